@@ -0,0 +1,35 @@
+# Find the Zstandard library.
+
+# ZSTD_INCLUDE_DIRS - where to find <zstd.h>.
+# ZSTD_LIBRARIES - List of libraries when using libzstd.
+# ZSTD_VERSION_STRING - Version of libzstd found, from <zstd.h>.
+# ZSTD_FOUND - True if libzstd found.
+if(ZSTD_INCLUDE_DIRS)
+	# Already in cache, be silent
+	set(ZSTD_FIND_QUIETLY YES)
+endif()
+
+find_path(ZSTD_INCLUDE_DIRS zstd.h)
+find_library(ZSTD_LIBRARY NAMES zstd libzstd)
+
+# Get the version number from zstd.h.
+if(ZSTD_INCLUDE_DIRS AND EXISTS "${ZSTD_INCLUDE_DIRS}/zstd.h")
+	file(STRINGS "${ZSTD_INCLUDE_DIRS}/zstd.h" ZSTD_VERSION_LINES
+		REGEX "^#define[ \t]+ZSTD_VERSION_(MAJOR|MINOR|RELEASE)[ \t]+[0-9]+")
+	string(REGEX REPLACE ".*ZSTD_VERSION_MAJOR[ \t]+([0-9]+).*" "\\1" ZSTD_VERSION_MAJOR "${ZSTD_VERSION_LINES}")
+	string(REGEX REPLACE ".*ZSTD_VERSION_MINOR[ \t]+([0-9]+).*" "\\1" ZSTD_VERSION_MINOR "${ZSTD_VERSION_LINES}")
+	string(REGEX REPLACE ".*ZSTD_VERSION_RELEASE[ \t]+([0-9]+).*" "\\1" ZSTD_VERSION_RELEASE "${ZSTD_VERSION_LINES}")
+	set(ZSTD_VERSION_STRING "${ZSTD_VERSION_MAJOR}.${ZSTD_VERSION_MINOR}.${ZSTD_VERSION_RELEASE}")
+	unset(ZSTD_VERSION_LINES)
+endif()
+
+# handle the QUIETLY and REQUIRED arguments and set ZSTD_FOUND to TRUE if
+# all listed variables are TRUE
+include(FindPackageHandleStandardArgs)
+find_package_handle_standard_args(Zstd
+	REQUIRED_VARS ZSTD_LIBRARY ZSTD_INCLUDE_DIRS
+	VERSION_VAR ZSTD_VERSION_STRING)
+
+if(ZSTD_FOUND)
+	set(ZSTD_LIBRARIES ${ZSTD_LIBRARY})
+endif()
@@ -67,6 +67,14 @@ ELSE(WIN32)
 	OPTION(USE_INTERNAL_XML "Use the internal copy of TinyXML2." OFF)
 ENDIF()
 
+# Transparent decompression of xz, bzip2, and zstd compressed files.
+# gzip is always supported, since zlib is required.
+IF(NOT WIN32)
+	OPTION(ENABLE_LZMA "Enable transparent xz decompression using liblzma." ON)
+	OPTION(ENABLE_BZIP2 "Enable transparent bzip2 decompression using libbz2." ON)
+	OPTION(ENABLE_ZSTD "Enable transparent zstd decompression using libzstd." ON)
+ENDIF(NOT WIN32)
+
 # TODO: If APNG export is added, verify that system libpng
 # supports APNG.
 
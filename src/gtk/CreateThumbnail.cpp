@@ -21,7 +21,7 @@
 // librpbase
 #include "librpbase/common.h"
 #include "librpbase/RomData.hpp"
-#include "librpbase/file/RpFile.hpp"
+#include "librpbase/file/IRpFile.hpp"
 #include "librpbase/img/rp_image.hpp"
 #include "librpbase/img/RpPngWriter.hpp"
 using namespace LibRpBase;
@@ -281,8 +281,9 @@ G_MODULE_EXPORT int rp_create_thumbnail(const char *source_file, const char *out
 
 	// Attempt to open the ROM file.
 	// TODO: RpGVfsFile wrapper.
-	// For now, using RpFile, which is an stdio wrapper.
-	unique_ptr<IRpFile> file(new RpFile(source_file, RpFile::FM_OPEN_READ_GZ));
+	// For now, using RomDataFactory::openFile(), which returns
+	// a memory-mapped file or RpFile with transparent decompression.
+	unique_ptr<IRpFile> file(RomDataFactory::openFile(source_file));
 	if (!file || !file->isOpen()) {
 		// Could not open the file.
 		return RPCT_SOURCE_FILE_ERROR;
@@ -297,31 +298,20 @@ G_MODULE_EXPORT int rp_create_thumbnail(const char *source_file, const char *out
 		return RPCT_SOURCE_FILE_NOT_SUPPORTED;
 	}
 
-	// Create the thumbnail.
+	// Select the thumbnail image.
+	// NOTE: The image is written directly to the PNG file,
+	// so it isn't converted to PIMGTYPE.
 	// TODO: If image is larger than maximum_size, resize down.
 	unique_ptr<CreateThumbnailPrivate> d(new CreateThumbnailPrivate());
-	PIMGTYPE ret_img = nullptr;
-	rp_image::sBIT_t sBIT;
-	int ret = d->getThumbnail(romData, maximum_size, ret_img, &sBIT);
-
-	if (ret != 0 || !d->isImgClassValid(ret_img)) {
+	CreateThumbnailPrivate::SourceImage src;
+	int ret = d->getThumbnailSource(romData, maximum_size, src);
+	if (ret != 0) {
 		// No image.
-		if (ret_img) {
-			d->freeImgClass(ret_img);
-		}
 		romData->unref();
 		return RPCT_SOURCE_FILE_NO_IMAGE;
 	}
 
-	// Save the image using RpPngWriter.
-	TCreateThumbnail<PIMGTYPE>::ImgSize imgSz;
-	d->getImgClassSize(ret_img, &imgSz);
-	unique_ptr<const uint8_t*[]> row_pointers;
-	guchar *pixels;
-	int rowstride;
-	int pwRet;
-
-	// tEXt chunks.
+	/** tEXt chunks. **/
 	RpPngWriter::kv_vector kv;
 	char mtime_str[32];
 	char szFile_str[32];
@@ -329,21 +319,6 @@ G_MODULE_EXPORT int rp_create_thumbnail(const char *source_file, const char *out
 	gchar *content_type;
 	gchar *uri = nullptr;
 
-	// gdk-pixbuf doesn't support CI8, so we'll assume all
-	// images are ARGB32. (Well, ABGR32, but close enough.)
-	// TODO: Verify channels, etc.?
-	unique_ptr<RpPngWriter> pngWriter(new RpPngWriter(output_file,
-		imgSz.width, imgSz.height, rp_image::FORMAT_ARGB32));
-	if (!pngWriter->isOpen()) {
-		// Could not open the PNG writer.
-		ret = RPCT_OUTPUT_FILE_FAILED;
-		goto cleanup;
-	}
-
-	/** tEXt chunks. **/
-	// NOTE: These are written before IHDR in order to put the
-	// tEXt chunks before the IDAT chunk.
-
 	// Get values for the XDG thumbnail cache text chunks.
 	// KDE uses this order: Software, MTime, Mimetype, Size, URI
 	kv.reserve(5);
@@ -435,54 +410,10 @@ G_MODULE_EXPORT int rp_create_thumbnail(const char *source_file, const char *out
 		g_free(uri);
 	}
 
-	// Write the tEXt chunks.
-	pngWriter->write_tEXt(kv);
-
-	/** IHDR **/
-
-	// If sBIT wasn't found, all fields will be 0.
-	// RpPngWriter will ignore sBIT in this case.
-	pwRet = pngWriter->write_IHDR(&sBIT);
-	if (pwRet != 0) {
-		// Error writing IHDR.
-		// TODO: Unlink the PNG image.
-		ret = RPCT_OUTPUT_FILE_FAILED;
-		goto cleanup;
-	}
-
-	/** IDAT chunk. **/
-
-	// Initialize the row pointers.
-	row_pointers.reset(new const uint8_t*[imgSz.height]);
-#ifdef RP_GTK_USE_CAIRO
-	pixels = cairo_image_surface_get_data(ret_img);
-	rowstride = cairo_image_surface_get_stride(ret_img);
-#else /* !RP_GTK_USE_CAIRO */
-	pixels = gdk_pixbuf_get_pixels(ret_img);
-	rowstride = gdk_pixbuf_get_rowstride(ret_img);
-#endif
-	for (int y = 0; y < imgSz.height; y++, pixels += rowstride) {
-		row_pointers[y] = pixels;
-	}
-
-	// Write the IDAT section.
-#ifdef RP_GTK_USE_CAIRO
-	// Cairo uses ARGB32.
-	static const bool is_abgr = false;
-#else /* !RP_GTK_USE_CAIRO */
-	// GdkPixbuf uses ABGR32.
-	static const bool is_abgr = true;
-#endif
-	pwRet = pngWriter->write_IDAT(row_pointers.get(), is_abgr);
-	if (pwRet != 0) {
-		// Error writing IDAT.
-		// TODO: Unlink the PNG image.
-		ret = RPCT_OUTPUT_FILE_FAILED;
-		goto cleanup;
-	}
-
-cleanup:
-	d->freeImgClass(ret_img);
+	// Save the image using RpPngWriter.
+	// NOTE: romData owns internal images, so it must
+	// remain valid until the image is written.
+	ret = d->writeThumbnailPng(src, maximum_size, output_file, kv);
 	romData->unref();
 	return ret;
 }
@@ -40,9 +40,6 @@ using LibRomData::TCreateThumbnail;
 // C includes.
 #include <unistd.h>
 
-// C includes. (C++ namespace)
-#include <cassert>
-
 // C++ includes.
 #include <memory>
 #include <string>
@@ -308,8 +305,9 @@ Q_DECL_EXPORT int rp_create_thumbnail(const char *source_file, const char *outpu
 
 	// Attempt to open the ROM file.
 	// TODO: RpQFile wrapper.
-	// For now, using RpFile, which is an stdio wrapper.
-	unique_ptr<IRpFile> file(new RpFile(source_file, RpFile::FM_OPEN_READ_GZ));
+	// For now, using RomDataFactory::openFile(), which returns
+	// a memory-mapped file or RpFile with transparent decompression.
+	unique_ptr<IRpFile> file(RomDataFactory::openFile(source_file));
 	if (!file || !file->isOpen()) {
 		// Could not open the file.
 		return RPCT_SOURCE_FILE_ERROR;
@@ -324,26 +322,20 @@ Q_DECL_EXPORT int rp_create_thumbnail(const char *source_file, const char *outpu
 		return RPCT_SOURCE_FILE_NOT_SUPPORTED;
 	}
 
-	// Create the thumbnail.
+	// Select the thumbnail image.
+	// NOTE: The image is written directly to the PNG file,
+	// so it isn't converted to QImage.
 	// TODO: If image is larger than maximum_size, resize down.
-	RomThumbCreatorPrivate *d = new RomThumbCreatorPrivate();
-	QImage ret_img;
-	rp_image::sBIT_t sBIT;
-	int ret = d->getThumbnail(romData, maximum_size, ret_img, &sBIT);
-	delete d;
-
-	if (ret != 0 || ret_img.isNull()) {
+	unique_ptr<RomThumbCreatorPrivate> d(new RomThumbCreatorPrivate());
+	RomThumbCreatorPrivate::SourceImage src;
+	int ret = d->getThumbnailSource(romData, maximum_size, src);
+	if (ret != 0) {
 		// No image.
 		romData->unref();
 		return RPCT_SOURCE_FILE_NO_IMAGE;
 	}
 
-	// Save the image using RpPngWriter.
-	const int height = ret_img.height();
-
 	/** tEXt chunks. **/
-	// NOTE: These are written before IHDR in order to put the
-	// tEXt chunks before the IDAT chunk.
 
 	// NOTE: QString::toStdString() uses toAscii() in Qt4.
 	// Hence, we'll use toUtf8() manually.
@@ -352,31 +344,6 @@ Q_DECL_EXPORT int rp_create_thumbnail(const char *source_file, const char *outpu
 	// KDE uses this order: Software, MTime, Mimetype, Size, URI
 	RpPngWriter::kv_vector kv;
 
-	// Determine the image format.
-	rp_image::Format format;
-	switch (ret_img.format()) {
-		case QImage::Format_Indexed8:
-			format = rp_image::FORMAT_CI8;
-			break;
-		case QImage::Format_ARGB32:
-			format = rp_image::FORMAT_ARGB32;
-			break;
-		default:
-			// Unsupported...
-			assert(!"Unsupported QImage image format.");
-			romData->unref();
-			return RPCT_OUTPUT_FILE_FAILED;
-	}
-
-	RpPngWriter *pngWriter = new RpPngWriter(output_file,
-		ret_img.width(), height, format);
-	if (!pngWriter->isOpen()) {
-		// Could not open the PNG writer.
-		delete pngWriter;
-		romData->unref();
-		return RPCT_OUTPUT_FILE_FAILED;
-	}
-
 	// Software.
 	static const char sw[] = "ROM Properties Page shell extension (KDE" QT_MAJOR_STR ")";
 	kv.push_back(std::make_pair("Software", sw));
@@ -422,47 +389,10 @@ Q_DECL_EXPORT int rp_create_thumbnail(const char *source_file, const char *outpu
 			string(url.toString().toUtf8().constData())));
 	}
 
-	// Write the tEXt chunks.
-	pngWriter->write_tEXt(kv);
-
-	/** IHDR **/
-
-	// CI8 palette.
-	// This will be an empty vector if the image isn't CI8.
-	// RpPngWriter will ignore the palette arguments in that case.
-	QVector<QRgb> colorTable = ret_img.colorTable();
-
-	// If sBIT wasn't found, all fields will be 0.
-	// RpPngWriter will ignore sBIT in this case.
-	int pwRet = pngWriter->write_IHDR(&sBIT,
-		colorTable.constData(), colorTable.size());
-	if (pwRet != 0) {
-		// Error writing IHDR.
-		// TODO: Unlink the PNG image.
-		delete pngWriter;
-		romData->unref();
-		return RPCT_OUTPUT_FILE_FAILED;
-	}
-
-	/** IDAT chunk. **/
-
-	// Initialize the row pointers.
-	unique_ptr<const uint8_t*[]> row_pointers(new const uint8_t*[height]);
-	const uint8_t *bits = ret_img.bits();
-	const int bytesPerLine = ret_img.bytesPerLine();
-	for (int y = 0; y < height; y++, bits += bytesPerLine) {
-		row_pointers[y] = bits;
-	}
-
-	// Write the IDAT section.
-	pwRet = pngWriter->write_IDAT(row_pointers.get());
-	if (pwRet != 0) {
-		// Error writing IDAT.
-		// TODO: Unlink the PNG image.
-		ret = RPCT_OUTPUT_FILE_FAILED;
-	}
-
-	delete pngWriter;
+	// Save the image using RpPngWriter.
+	// NOTE: romData owns internal images, so it must
+	// remain valid until the image is written.
+	ret = d->writeThumbnailPng(src, maximum_size, output_file, kv);
 	romData->unref();
 	return ret;
 }
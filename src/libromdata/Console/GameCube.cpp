@@ -46,6 +46,7 @@ using namespace LibRpBase;
 #include "disc/NASOSReader.hpp"
 #include "disc/nasos_gcn.h"	// for magic numbers
 #include "disc/WiiPartition.hpp"
+#include "disc/WiiPartitionCache.hpp"
 
 // For sections delegated to other RomData subclasses.
 #include "GameCubeBNR.hpp"
@@ -156,6 +157,14 @@ class GameCubePrivate : public RomDataPrivate
 		vector<WiiPartEntry> wiiPtbl;
 		bool wiiPtblLoaded;
 
+		// WiiPartitionCache key.
+		// Only valid if wiiPtblCacheable is true.
+		WiiPartitionCache::Key wiiPtblCacheKey;
+		bool wiiPtblCacheable;
+		// Number of title keys in the cached partition tables.
+		// (-1 if the partition tables haven't been cached.)
+		int wiiPtblCachedKeys;
+
 		// Pointers to specific partitions within wiiPtbl.
 		WiiPartition *updatePartition;
 		WiiPartition *gamePartition;
@@ -167,6 +176,13 @@ class GameCubePrivate : public RomDataPrivate
 		 */
 		int loadWiiPartitionTables(void);
 
+		/**
+		 * Save the Wii partition tables to WiiPartitionCache.
+		 * The cache is only updated if title keys were
+		 * decrypted since the tables were last saved.
+		 */
+		void saveWiiPartitionTables(void);
+
 	public:
 		/**
 		 * Get the disc publisher.
@@ -234,6 +250,8 @@ GameCubePrivate::GameCubePrivate(GameCube *q, IRpFile *file)
 	, discReader(nullptr)
 	, gcnRegion(~0)
 	, wiiPtblLoaded(false)
+	, wiiPtblCacheable(false)
+	, wiiPtblCachedKeys(-1)
 	, updatePartition(nullptr)
 	, gamePartition(nullptr)
 {
@@ -245,6 +263,9 @@ GameCubePrivate::GameCubePrivate(GameCube *q, IRpFile *file)
 
 GameCubePrivate::~GameCubePrivate()
 {
+	// Save any title keys that were decrypted.
+	saveWiiPartitionTables();
+
 	// Wii partition pointers.
 	updatePartition = nullptr;
 	gamePartition = nullptr;
@@ -299,11 +320,61 @@ int GameCubePrivate::loadWiiPartitionTables(void)
 		delete iter->partition;
 	}
 	wiiPtbl.clear();
+	updatePartition = nullptr;
+	gamePartition = nullptr;
+
+	// Check the crypto and hash method.
+	// TODO: Lookup table instead of branches?
+	unsigned int cryptoMethod = 0;
+	if (discHeader.disc_noCrypto != 0 || (discType & DISC_FORMAT_MASK) == DISC_FORMAT_NASOS) {
+		// No encryption.
+		cryptoMethod |= WiiPartition::CM_UNENCRYPTED;
+	}
+	if (discHeader.hash_verify != 0) {
+		// No hashes.
+		cryptoMethod |= WiiPartition::CM_32K;
+	}
+
+	// Check if the partition tables are cached.
+	// The thumbnailer, property page, and metadata extractor
+	// may each open the same disc image.
+	wiiPtblCacheable = WiiPartitionCache::getKey(this->file, &wiiPtblCacheKey);
+	vector<WiiPartitionCache::Partition> cached;
+	if (wiiPtblCacheable && WiiPartitionCache::lookup(wiiPtblCacheKey, cached)) {
+		// Create the WiiPartition objects from the cached data.
+		wiiPtbl.resize(cached.size());
+		wiiPtblCachedKeys = 0;
+		auto src_iter = cached.cbegin();
+		for (auto iter = wiiPtbl.begin(); iter != wiiPtbl.end(); ++iter, ++src_iter) {
+			iter->vg = src_iter->vg;
+			iter->pt = src_iter->pt;
+			iter->start = src_iter->start;
+			iter->size = src_iter->size;
+			iter->type = src_iter->type;
+			iter->partition = new WiiPartition(discReader, *src_iter,
+				(WiiPartition::CryptoMethod)cryptoMethod);
+			if (src_iter->has_title_key) {
+				wiiPtblCachedKeys++;
+			}
+
+			if (iter->type == PARTITION_UPDATE && !updatePartition) {
+				// System Update partition.
+				updatePartition = iter->partition;
+			} else if (iter->type == PARTITION_GAME && !gamePartition) {
+				// Game partition.
+				gamePartition = iter->partition;
+			}
+		}
+
+		wiiPtblLoaded = true;
+		return 0;
+	}
 
 	// Assuming a maximum of 128 partitions per table.
 	// (This is a rather high estimate.)
+	// Each volume group is limited to 1024 entries.
+	static const unsigned int PT_MAX_ENTRIES = 1024;
 	RVL_VolumeGroupTable vgtbl;
-	RVL_PartitionTableEntry pt[1024];
 
 	// Read the volume group table.
 	// References:
@@ -323,46 +394,55 @@ int GameCubePrivate::loadWiiPartitionTables(void)
 		return -errno;
 	}
 
-	// Check the crypto and hash method.
-	// TODO: Lookup table instead of branches?
-	unsigned int cryptoMethod = 0;
-	if (discHeader.disc_noCrypto != 0 || (discType & DISC_FORMAT_MASK) == DISC_FORMAT_NASOS) {
-		// No encryption.
-		cryptoMethod |= WiiPartition::CM_UNENCRYPTED;
-	}
-	if (discHeader.hash_verify != 0) {
-		// No hashes.
-		cryptoMethod |= WiiPartition::CM_32K;
+	// Determine which partition table entries to read.
+	unsigned int vg_count[4];
+	unsigned int pt_total = 0;
+	for (unsigned int i = 0; i < 4; i++) {
+		unsigned int count = be32_to_cpu(vgtbl.vg[i].count);
+		if (count > PT_MAX_ENTRIES) {
+			count = PT_MAX_ENTRIES;
+		}
+		vg_count[i] = count;
+		pt_total += count;
 	}
 
-	// Process each volume group.
+	// All of the partition tables are read in a single batch.
+	vector<RVL_PartitionTableEntry> pt(pt_total);
+	ReadSegment segs[4];
+	unsigned int seg_count = 0;
+	unsigned int pt_offset = 0;
 	for (unsigned int i = 0; i < 4; i++) {
-		unsigned int count = be32_to_cpu(vgtbl.vg[i].count);
-		if (count == 0) {
+		if (vg_count[i] == 0) {
 			continue;
-		} else if (count > ARRAY_SIZE(pt)) {
-			count = ARRAY_SIZE(pt);
 		}
 
-		// Read the partition table entries.
-		int64_t pt_addr = static_cast<int64_t>(be32_to_cpu(vgtbl.vg[i].addr)) << 2;
-		const size_t ptSize = sizeof(RVL_PartitionTableEntry) * count;
-		size = discReader->seekAndRead(pt_addr, pt, ptSize);
-		if (size != ptSize) {
-			// Error reading the partition table entries.
-			return -EIO;
-		}
+		ReadSegment &seg = segs[seg_count++];
+		seg.pos = static_cast<int64_t>(be32_to_cpu(vgtbl.vg[i].addr)) << 2;
+		seg.ptr = &pt[pt_offset];
+		seg.size = sizeof(RVL_PartitionTableEntry) * vg_count[i];
+		pt_offset += vg_count[i];
+	}
 
+	// Read the partition table entries.
+	if (discReader->readBatch(segs, seg_count) != seg_count) {
+		// Error reading the partition table entries.
+		return -EIO;
+	}
+
+	// Process each volume group.
+	wiiPtbl.resize(pt_total);
+	const RVL_PartitionTableEntry *pte = pt.data();
+	size_t idx = 0;
+	for (unsigned int i = 0; i < 4; i++) {
 		// Process each partition table entry.
-		size_t idx = wiiPtbl.size();
-		wiiPtbl.resize(wiiPtbl.size() + count);
-		for (unsigned int j = 0; j < count; j++, idx++) {
+		const unsigned int count = vg_count[i];
+		for (unsigned int j = 0; j < count; j++, idx++, pte++) {
 			WiiPartEntry &entry = wiiPtbl.at(idx);
 
 			entry.vg = static_cast<uint8_t>(i);
 			entry.pt = static_cast<uint8_t>(j);
-			entry.start = static_cast<int64_t>(be32_to_cpu(pt[j].addr)) << 2;
-			entry.type = be32_to_cpu(pt[j].type);
+			entry.start = static_cast<int64_t>(be32_to_cpu(pte->addr)) << 2;
+			entry.type = be32_to_cpu(pte->type);
 		}
 	}
 
@@ -408,9 +488,53 @@ int GameCubePrivate::loadWiiPartitionTables(void)
 	}
 
 	// Done reading the partition tables.
+	// Save the partition tables to the cache.
+	// Title keys haven't been decrypted yet, so they'll
+	// be saved by the destructor if they're decrypted later.
+	wiiPtblLoaded = true;
+	wiiPtblCachedKeys = -1;
+	saveWiiPartitionTables();
 	return 0;
 }
 
+/**
+ * Save the Wii partition tables to WiiPartitionCache.
+ * The cache is only updated if title keys were
+ * decrypted since the tables were last saved.
+ */
+void GameCubePrivate::saveWiiPartitionTables(void)
+{
+	if (!wiiPtblLoaded || !wiiPtblCacheable || wiiPtbl.empty()) {
+		// Nothing to save.
+		return;
+	}
+
+	vector<WiiPartitionCache::Partition> cached(wiiPtbl.size());
+	int keys = 0;
+	auto dest_iter = cached.begin();
+	for (auto iter = wiiPtbl.cbegin(); iter != wiiPtbl.cend(); ++iter, ++dest_iter) {
+		if (!iter->partition->saveToCache(&(*dest_iter))) {
+			// Partition header wasn't loaded.
+			// Don't cache this disc image.
+			wiiPtblCacheable = false;
+			return;
+		}
+		dest_iter->vg = iter->vg;
+		dest_iter->pt = iter->pt;
+		dest_iter->type = iter->type;
+		dest_iter->start = iter->start;
+		dest_iter->size = iter->size;
+		if (dest_iter->has_title_key) {
+			keys++;
+		}
+	}
+
+	if (keys > wiiPtblCachedKeys) {
+		WiiPartitionCache::store(wiiPtblCacheKey, cached);
+		wiiPtblCachedKeys = keys;
+	}
+}
+
 /**
  * Get the disc publisher.
  * @return Disc publisher.
@@ -501,30 +501,28 @@ const rp_image *GameCubeSavePrivate::loadBanner(void)
 	}
 
 	// Read the banner data.
+	// CI8 banners have a palette immediately after the image data.
 	static const int MAX_BANNER_SIZE = (CARD_BANNER_W * CARD_BANNER_H * 2);
 	uint8_t bannerbuf[MAX_BANNER_SIZE];
-	size_t size = file->seekAndRead(dataOffset + direntry.iconaddr,
-					bannerbuf, bannersize);
-	if (size != bannersize) {
+	uint16_t palbuf[256];
+	const bool isRGB = ((direntry.bannerfmt & CARD_BANNER_MASK) == CARD_BANNER_RGB);
+	const int64_t banner_addr = dataOffset + direntry.iconaddr;
+	const ReadSegment segs[2] = {
+		{banner_addr, bannerbuf, bannersize},
+		{banner_addr + bannersize, palbuf, sizeof(palbuf)},
+	};
+	const unsigned int seg_count = (isRGB ? 1 : 2);
+	if (file->readBatch(segs, seg_count) != seg_count) {
 		// Seek and/or read error.
 		return nullptr;
 	}
 
-	if ((direntry.bannerfmt & CARD_BANNER_MASK) == CARD_BANNER_RGB) {
+	if (isRGB) {
 		// Convert the banner from GCN RGB5A3 format to ARGB32.
 		img_banner = ImageDecoder::fromGcn16(ImageDecoder::PXF_RGB5A3,
 			CARD_BANNER_W, CARD_BANNER_H,
 			reinterpret_cast<const uint16_t*>(bannerbuf), bannersize);
 	} else {
-		// Read the palette data.
-		uint16_t palbuf[256];
-		size = file->seekAndRead(dataOffset + direntry.iconaddr + bannersize,
-					 palbuf, sizeof(palbuf));
-		if (size != sizeof(palbuf)) {
-			// Seek and/or read error.
-			return nullptr;
-		}
-
 		// Convert the banner from GCN CI8 format to CI8.
 		img_banner = ImageDecoder::fromGcnCI8(CARD_BANNER_W, CARD_BANNER_H,
 			bannerbuf, bannersize, palbuf, sizeof(palbuf));
@@ -315,24 +315,26 @@ SNES::SNES(IRpFile *file)
 
 	if (d->romType == SNESPrivate::ROM_UNKNOWN) {
 		// Check for BS-X "Memory Pack" headers.
-		static const uint16_t bsx_addrs[2] = {0x7F00, 0xFF00};
+		// Both possible locations are read in a single batch.
 		static const uint8_t bsx_mempack_magic[6] = {'M', 0, 'P', 0, 0, 0};
-		uint8_t buf[7];
+		uint8_t buf[2][7];
+		const ReadSegment segs[2] = {
+			{0x7F00, buf[0], sizeof(buf[0])},
+			{0xFF00, buf[1], sizeof(buf[1])},
+		};
+		if (d->file->readBatch(segs, 2) != 2) {
+			// Read error.
+			delete d->file;
+			d->file = nullptr;
+			return;
+		}
 
 		for (unsigned int i = 0; i < 2; i++) {
-			size_t size = d->file->seekAndRead(bsx_addrs[i], buf, sizeof(buf));
-			if (size != sizeof(buf)) {
-				// Read error.
-				delete d->file;
-				d->file = nullptr;
-				return;
-			}
-
-			if (!memcmp(buf, bsx_mempack_magic, sizeof(bsx_mempack_magic))) {
+			if (!memcmp(buf[i], bsx_mempack_magic, sizeof(bsx_mempack_magic))) {
 				// Found BS-X memory pack magic.
 				// Check the memory pack type.
 				// (7 is ROM; 1 to 4 is FLASH.)
-				if ((buf[6] & 0xF0) == 0x70) {
+				if ((buf[i][6] & 0xF0) == 0x70) {
 					// ROM cartridge
 					// TODO: Use the size value.
 					// Size is (1024 << (buf[6] & 0x0F))
@@ -191,24 +191,16 @@ WiiU::WiiU(IRpFile *file)
 		return;
 	}
 
-	// Re-read the disc header for WUX.
-	if (d->discType > WiiUPrivate::DISC_FORMAT_WUD) {
-		size = d->discReader->seekAndRead(0, header, sizeof(header));
-		if (size != sizeof(header)) {
-			// Seek and/or read error.
-			delete d->discReader;
-			delete d->file;
-			d->discReader = nullptr;
-			d->file = nullptr;
-			d->discType = WiiUPrivate::DISC_UNKNOWN;
-			return;
-		}
-	}
-
-	// Verify the secondary magic number at 0x10000.
+	// Read the secondary magic number at 0x10000.
+	// WUX images also need the disc header to be re-read
+	// through the DiscReader; both are read in a single batch.
 	uint32_t disc_magic;
-	size = d->discReader->seekAndRead(0x10000, &disc_magic, sizeof(disc_magic));
-	if (size != sizeof(disc_magic)) {
+	const ReadSegment segs[2] = {
+		{0x10000, &disc_magic, sizeof(disc_magic)},
+		{0, header, sizeof(header)},
+	};
+	const unsigned int seg_count = (d->discType > WiiUPrivate::DISC_FORMAT_WUD ? 2 : 1);
+	if (d->discReader->readBatch(segs, seg_count) != seg_count) {
 		// Seek and/or read error.
 		delete d->discReader;
 		delete d->file;
@@ -218,6 +210,7 @@ WiiU::WiiU(IRpFile *file)
 		return;
 	}
 
+	// Verify the secondary magic number.
 	if (disc_magic == cpu_to_be32(WIIU_SECONDARY_MAGIC)) {
 		// Secondary magic matches.
 		d->isValid = true;
@@ -42,7 +42,6 @@ using namespace LibRpBase;
 #include "librpbase/crypto/KeyManager.hpp"
 #include "disc/WiiPartition.hpp"	// for key information
 #ifdef ENABLE_DECRYPTION
-# include "librpbase/crypto/AesCipherFactory.hpp"
 # include "librpbase/crypto/IAesCipher.hpp"
 # include "librpbase/disc/CBCReader.hpp"
 // For sections delegated to other RomData subclasses.
@@ -325,17 +324,14 @@ WiiWAD::WiiWAD(IRpFile *file)
 	}
 
 	// Read the ticket and TMD.
+	// Both addresses are known from the WAD header,
+	// so they're read in a single batch.
 	// TODO: Verify ticket/TMD sizes.
-	size = d->file->seekAndRead(ticket_addr, &d->ticket, sizeof(d->ticket));
-	if (size != sizeof(d->ticket)) {
-		// Seek and/or read error.
-		d->isValid = false;
-		delete d->file;
-		d->file = nullptr;
-		return;
-	}
-	size = d->file->seekAndRead(tmd_addr, &d->tmdHeader, sizeof(d->tmdHeader));
-	if (size != sizeof(d->tmdHeader)) {
+	const ReadSegment segs[2] = {
+		{ticket_addr, &d->ticket, sizeof(d->ticket)},
+		{tmd_addr, &d->tmdHeader, sizeof(d->tmdHeader)},
+	};
+	if (d->file->readBatch(segs, 2) != 2) {
 		// Seek and/or read error.
 		d->isValid = false;
 		delete d->file;
@@ -381,27 +377,29 @@ WiiWAD::WiiWAD(IRpFile *file)
 		return;
 	}
 
-	// Create a cipher to decrypt the title key.
-	IAesCipher *cipher = AesCipherFactory::create();
+	// Get a cipher to decrypt the title key.
+	IAesCipher *const cipher = keyManager->getCipher(keyData.key, keyData.length);
+	if (!cipher) {
+		// Unable to create the cipher.
+		d->key_status = KeyManager::VERFIY_IAESCIPHER_INIT_ERR;
+		return;
+	}
 
 	// Initialize parameters for title key decryption.
-	// TODO: Error checking.
 	// Parameters:
 	// - Chaining mode: CBC
 	// - IV: Title ID (little-endian)
-	cipher->setChainingMode(IAesCipher::CM_CBC);
-	cipher->setKey(keyData.key, keyData.length);
 	// Title key IV: High 8 bytes are the title ID (in big-endian), low 8 bytes are 0.
 	uint8_t iv[16];
 	memcpy(iv, &d->ticket.title_id.id, sizeof(d->ticket.title_id.id));
 	memset(&iv[8], 0, 8);
-	cipher->setIV(iv, sizeof(iv));
-	
+
 	// Decrypt the title key.
 	uint8_t title_key[16];
 	memcpy(title_key, d->ticket.enc_title_key, sizeof(d->ticket.enc_title_key));
-	cipher->decrypt(title_key, sizeof(title_key));
-	delete cipher;
+	cipher->setChainingMode(IAesCipher::CM_CBC);
+	cipher->decrypt(title_key, sizeof(title_key), iv, sizeof(iv));
+	keyManager->releaseCipher(cipher);
 
 	// Data area IV:
 	// - First two bytes are the big-endian content index.
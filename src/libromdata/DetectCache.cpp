@@ -0,0 +1,435 @@
+/***************************************************************************
+ * ROM Properties Page shell extension. (libromdata)                       *
+ * DetectCache.cpp: Persistent RomData detection cache.                    *
+ *                                                                         *
+ * Copyright (c) 2016-2018 by David Korth.                                 *
+ *                                                                         *
+ * This program is free software; you can redistribute it and/or modify it *
+ * under the terms of the GNU General Public License as published by the   *
+ * Free Software Foundation; either version 2 of the License, or (at your  *
+ * option) any later version.                                              *
+ *                                                                         *
+ * This program is distributed in the hope that it will be useful, but     *
+ * WITHOUT ANY WARRANTY; without even the implied warranty of              *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the           *
+ * GNU General Public License for more details.                            *
+ *                                                                         *
+ * You should have received a copy of the GNU General Public License       *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.   *
+ ***************************************************************************/
+
+#include "DetectCache.hpp"
+#include "libromdata/config.libromdata.h"
+
+// librpbase
+#include "librpbase/file/FileSystem.hpp"
+#include "librpbase/file/IRpFile.hpp"
+using LibRpBase::IRpFile;
+using LibRpBase::FileSystem::file_ext;
+
+// C includes.
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// C includes. (C++ namespace)
+#include <cassert>
+#include <cctype>
+#include <cstddef>
+#include <cstring>
+
+// C++ includes.
+#include <atomic>
+#include <string>
+using std::string;
+
+#ifndef O_CLOEXEC
+# define O_CLOEXEC 0
+#endif
+
+namespace LibRomData {
+
+/**
+ * Cache file layout:
+ * - CacheHeader
+ * - CacheEntry[entry_count]
+ *
+ * All fields are host-endian, since the cache is local
+ * to the current user on the current system.
+ */
+
+#define DETECTCACHE_MAGIC	0x43445052	/* 'RPDC' */
+#define DETECTCACHE_VERSION	3
+
+// Number of hash table entries. (must be a power of two)
+#define DETECTCACHE_ENTRY_COUNT	16384
+// Maximum number of entries to probe for each lookup.
+#define DETECTCACHE_MAX_PROBE	8
+
+struct CacheHeader {
+	uint32_t magic;		// DETECTCACHE_MAGIC
+	uint32_t version;	// DETECTCACHE_VERSION
+	uint32_t signature;	// Detection table signature.
+	uint32_t entry_count;	// Number of hash table entries.
+	uint8_t reserved[48];
+};
+ASSERT_STRUCT(CacheHeader, 64);
+
+struct CacheEntry {
+	uint64_t dev;
+	uint64_t ino;
+	int64_t mtime;
+	int64_t size;
+	uint32_t mtime_nsec;
+	uint32_t ext_hash;
+	uint32_t attrs;
+	uint32_t decomp;
+	uint32_t result;	// RESULT_NONE if the entry is empty.
+	uint32_t check;		// Checksum of all other fields.
+	uint32_t reserved[2];
+};
+ASSERT_STRUCT(CacheEntry, 64);
+
+class DetectCachePrivate
+{
+	public:
+		DetectCachePrivate(const string &filename, uint32_t signature);
+		~DetectCachePrivate();
+
+	private:
+		RP_DISABLE_COPY(DetectCachePrivate)
+
+	public:
+		// Mapped cache file.
+		uint8_t *addr;
+		size_t size;
+
+		// Detection table signature.
+		uint32_t signature;
+
+		/**
+		 * Get the hash table entries.
+		 * @return Hash table entries.
+		 */
+		inline CacheEntry *entries(void) const
+		{
+			return reinterpret_cast<CacheEntry*>(addr + sizeof(CacheHeader));
+		}
+
+		/**
+		 * Mix a 64-bit value into a hash.
+		 * Based on the SplitMix64 finalizer.
+		 * @param h Hash.
+		 * @param v Value.
+		 * @return New hash.
+		 */
+		static inline uint64_t mix(uint64_t h, uint64_t v)
+		{
+			h ^= v + 0x9E3779B97F4A7C15ULL + (h << 6) + (h >> 2);
+			h = (h ^ (h >> 30)) * 0xBF58476D1CE4E5B9ULL;
+			h = (h ^ (h >> 27)) * 0x94D049BB133111EBULL;
+			return h ^ (h >> 31);
+		}
+
+		/**
+		 * Get the home bucket for a file.
+		 * @param key File identity.
+		 * @return Home bucket index.
+		 */
+		static inline unsigned int bucket(const DetectCache::Key &key)
+		{
+			uint64_t h = mix(0, key.dev);
+			h = mix(h, key.ino);
+			h = mix(h, (static_cast<uint64_t>(key.decomp) << 32) | key.attrs);
+			return static_cast<unsigned int>(h) & (DETECTCACHE_ENTRY_COUNT - 1);
+		}
+
+		/**
+		 * Calculate the checksum for a cache entry.
+		 *
+		 * The signature is included so entries written by a
+		 * different version are rejected, even if the header
+		 * was rewritten while another process had it mapped.
+		 *
+		 * @param entry Cache entry.
+		 * @return Checksum. (never 0)
+		 */
+		uint32_t checksum(const CacheEntry &entry) const
+		{
+			uint64_t h = mix(signature, entry.dev);
+			h = mix(h, entry.ino);
+			h = mix(h, static_cast<uint64_t>(entry.mtime));
+			h = mix(h, static_cast<uint64_t>(entry.size));
+			h = mix(h, (static_cast<uint64_t>(entry.mtime_nsec) << 32) | entry.ext_hash);
+			h = mix(h, (static_cast<uint64_t>(entry.attrs) << 32) | entry.result);
+			h = mix(h, entry.decomp);
+			const uint32_t check = static_cast<uint32_t>(h ^ (h >> 32));
+			return (check != 0 ? check : 1);
+		}
+};
+
+DetectCachePrivate::DetectCachePrivate(const string &filename, uint32_t signature)
+	: addr(nullptr)
+	, size(sizeof(CacheHeader) + (DETECTCACHE_ENTRY_COUNT * sizeof(CacheEntry)))
+	, signature(signature)
+{
+	assert(signature != 0);
+	int fd = ::open(filename.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+	if (fd < 0) {
+		// Unable to open the cache file.
+		return;
+	}
+
+	// Check the header.
+	// The file is locked while initializing it in case
+	// another process is initializing it at the same time.
+	// NOTE: Lookups don't lock the file.
+	if (flock(fd, LOCK_EX) != 0) {
+		::close(fd);
+		return;
+	}
+
+	CacheHeader header;
+	struct stat sb;
+	bool isValid = (fstat(fd, &sb) == 0);
+	if (isValid && sb.st_size != static_cast<off_t>(size)) {
+		// Wrong size. Truncating the file clears all entries.
+		// NOTE: Nothing else can have the file mapped with
+		// the current layout, so this won't cause SIGBUS.
+		isValid = (ftruncate(fd, 0) == 0 &&
+			ftruncate(fd, static_cast<off_t>(size)) == 0);
+		memset(&header, 0, sizeof(header));
+	} else if (isValid) {
+		isValid = (pread(fd, &header, sizeof(header), 0) == static_cast<ssize_t>(sizeof(header)));
+	}
+
+	if (isValid &&
+	    (header.magic != DETECTCACHE_MAGIC ||
+	     header.version != DETECTCACHE_VERSION ||
+	     header.signature != signature ||
+	     header.entry_count != DETECTCACHE_ENTRY_COUNT))
+	{
+		// (Re-)initialize the cache header.
+		// Existing entries have the wrong signature,
+		// so they will be treated as cache misses.
+		memset(&header, 0, sizeof(header));
+		header.magic = DETECTCACHE_MAGIC;
+		header.version = DETECTCACHE_VERSION;
+		header.signature = signature;
+		header.entry_count = DETECTCACHE_ENTRY_COUNT;
+		isValid = (pwrite(fd, &header, sizeof(header), 0) == static_cast<ssize_t>(sizeof(header)));
+	}
+
+	if (isValid) {
+		void *const map = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+		if (map != MAP_FAILED) {
+			addr = static_cast<uint8_t*>(map);
+		}
+	}
+
+	// The mapping stays valid after the file descriptor is closed.
+	flock(fd, LOCK_UN);
+	::close(fd);
+}
+
+DetectCachePrivate::~DetectCachePrivate()
+{
+	if (addr) {
+		munmap(addr, size);
+	}
+}
+
+/** DetectCache **/
+
+/**
+ * Open a detection cache file.
+ *
+ * The cache file is a fixed-size hash table that is
+ * memory-mapped by all processes that use it. Lookups
+ * don't take any locks; each entry has a checksum, so
+ * entries that are being written by another process
+ * are treated as cache misses.
+ *
+ * If the file doesn't exist, or if it was created with
+ * a different signature, it will be (re-)initialized.
+ *
+ * @param filename Cache filename.
+ * @param signature Signature of the detection tables. (must be non-zero)
+ */
+DetectCache::DetectCache(const string &filename, uint32_t signature)
+	: d_ptr(new DetectCachePrivate(filename, signature))
+{ }
+
+DetectCache::~DetectCache()
+{
+	delete d_ptr;
+}
+
+/**
+ * Get the cache key for a file.
+ * Only regular files are supported.
+ * @param file		[in] Opened file.
+ * @param ext_lc	[in] Lowercase file extension used for prediction. (may differ for compressed files)
+ * @param attrs		[in] RomDataAttr bitfield.
+ * @param pKey		[out] Cache key.
+ * @return True on success; false on error.
+ */
+bool DetectCache::getKey(IRpFile *file, const string &ext_lc,
+	unsigned int attrs, Key *pKey)
+{
+	if (!file) {
+		return false;
+	}
+	const string filename = file->filename();
+
+	struct stat sb;
+	if (filename.empty() || stat(filename.c_str(), &sb) != 0 || !S_ISREG(sb.st_mode)) {
+		return false;
+	}
+
+	pKey->dev = static_cast<uint64_t>(sb.st_dev);
+	pKey->ino = static_cast<uint64_t>(sb.st_ino);
+	pKey->mtime = static_cast<int64_t>(sb.st_mtime);
+	pKey->size = static_cast<int64_t>(sb.st_size);
+#if defined(HAVE_STRUCT_STAT_ST_MTIM_TV_NSEC)
+	pKey->mtime_nsec = static_cast<uint32_t>(sb.st_mtim.tv_nsec);
+#elif defined(HAVE_STRUCT_STAT_ST_MTIMESPEC_TV_NSEC)
+	pKey->mtime_nsec = static_cast<uint32_t>(sb.st_mtimespec.tv_nsec);
+#else
+	pKey->mtime_nsec = 0;
+#endif
+
+	// FNV-1a hash of the extensions.
+	// Both the lookup extension and the actual extension are
+	// used, since they differ for compressed files.
+	uint32_t ext_hash = 0x811C9DC5U;
+	for (auto iter = ext_lc.cbegin(); iter != ext_lc.cend(); ++iter) {
+		ext_hash ^= static_cast<uint8_t>(*iter);
+		ext_hash *= 0x01000193U;
+	}
+	const char *ext = file_ext(filename);
+	if (ext) {
+		for (; *ext != '\0'; ext++) {
+			ext_hash ^= static_cast<uint8_t>(tolower(*ext));
+			ext_hash *= 0x01000193U;
+		}
+	}
+	pKey->ext_hash = ext_hash;
+
+	pKey->attrs = attrs;
+	pKey->decomp = static_cast<uint32_t>(file->decompFormat() + 1);
+	return true;
+}
+
+/**
+ * Is the cache open?
+ * @return True if the cache is open; false if it isn't.
+ */
+bool DetectCache::isOpen(void) const
+{
+	RP_D(const DetectCache);
+	return (d->addr != nullptr);
+}
+
+/**
+ * Look up a file in the cache.
+ * @param key File identity.
+ * @return Cached result, or RESULT_NONE if not found.
+ */
+uint32_t DetectCache::lookup(const Key &key) const
+{
+	RP_D(const DetectCache);
+	if (!d->addr) {
+		return RESULT_NONE;
+	}
+
+	const CacheEntry *const entries = d->entries();
+	unsigned int idx = DetectCachePrivate::bucket(key);
+	for (unsigned int i = DETECTCACHE_MAX_PROBE; i > 0; i--, idx = (idx + 1) & (DETECTCACHE_ENTRY_COUNT - 1)) {
+		// Copy the entry first, since another process
+		// may be writing to it.
+		CacheEntry entry;
+		memcpy(&entry, &entries[idx], sizeof(entry));
+		if (entry.result == RESULT_NONE) {
+			// Empty entry. The file isn't in the cache.
+			break;
+		}
+		if (entry.dev != key.dev || entry.ino != key.ino ||
+		    entry.attrs != key.attrs || entry.decomp != key.decomp)
+		{
+			// Different file.
+			continue;
+		}
+
+		if (entry.check != d->checksum(entry) ||
+		    entry.mtime != key.mtime || entry.mtime_nsec != key.mtime_nsec ||
+		    entry.size != key.size || entry.ext_hash != key.ext_hash)
+		{
+			// Entry is either being written or out of date.
+			break;
+		}
+		return entry.result;
+	}
+
+	// Not found.
+	return RESULT_NONE;
+}
+
+/**
+ * Store a result in the cache.
+ * An existing entry for the same file is replaced.
+ * @param key File identity.
+ * @param result Result. (must not be RESULT_NONE)
+ */
+void DetectCache::store(const Key &key, uint32_t result)
+{
+	RP_D(DetectCache);
+	assert(result != RESULT_NONE);
+	if (!d->addr || result == RESULT_NONE) {
+		return;
+	}
+
+	// Find an entry for this file, or an empty entry.
+	// If neither is found, replace the home bucket.
+	CacheEntry *const entries = d->entries();
+	const unsigned int home = DetectCachePrivate::bucket(key);
+	unsigned int slot = home;
+	unsigned int idx = home;
+	for (unsigned int i = DETECTCACHE_MAX_PROBE; i > 0; i--, idx = (idx + 1) & (DETECTCACHE_ENTRY_COUNT - 1)) {
+		const CacheEntry &entry = entries[idx];
+		if (entry.result == RESULT_NONE ||
+		    (entry.dev == key.dev && entry.ino == key.ino &&
+		     entry.attrs == key.attrs && entry.decomp == key.decomp))
+		{
+			slot = idx;
+			break;
+		}
+	}
+
+	CacheEntry entry;
+	entry.dev = key.dev;
+	entry.ino = key.ino;
+	entry.mtime = key.mtime;
+	entry.size = key.size;
+	entry.mtime_nsec = key.mtime_nsec;
+	entry.ext_hash = key.ext_hash;
+	entry.attrs = key.attrs;
+	entry.decomp = key.decomp;
+	entry.result = result;
+	memset(entry.reserved, 0, sizeof(entry.reserved));
+	entry.check = d->checksum(entry);
+
+	// Clear the checksum before updating the entry so
+	// concurrent lookups won't accept a partial entry.
+	CacheEntry *const pEntry = &entries[slot];
+	pEntry->check = 0;
+	std::atomic_thread_fence(std::memory_order_release);
+	memcpy(pEntry, &entry, offsetof(CacheEntry, check));
+	memset(pEntry->reserved, 0, sizeof(pEntry->reserved));
+	std::atomic_thread_fence(std::memory_order_release);
+	pEntry->check = entry.check;
+}
+
+}
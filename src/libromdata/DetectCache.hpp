@@ -0,0 +1,137 @@
+/***************************************************************************
+ * ROM Properties Page shell extension. (libromdata)                       *
+ * DetectCache.hpp: Persistent RomData detection cache.                    *
+ *                                                                         *
+ * Copyright (c) 2016-2018 by David Korth.                                 *
+ *                                                                         *
+ * This program is free software; you can redistribute it and/or modify it *
+ * under the terms of the GNU General Public License as published by the   *
+ * Free Software Foundation; either version 2 of the License, or (at your  *
+ * option) any later version.                                              *
+ *                                                                         *
+ * This program is distributed in the hope that it will be useful, but     *
+ * WITHOUT ANY WARRANTY; without even the implied warranty of              *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the           *
+ * GNU General Public License for more details.                            *
+ *                                                                         *
+ * You should have received a copy of the GNU General Public License       *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.   *
+ ***************************************************************************/
+
+#ifndef __ROMPROPERTIES_LIBROMDATA_DETECTCACHE_HPP__
+#define __ROMPROPERTIES_LIBROMDATA_DETECTCACHE_HPP__
+
+#include "librpbase/common.h"
+
+// C includes.
+#include <stdint.h>
+
+// C++ includes.
+#include <string>
+
+namespace LibRpBase {
+	class IRpFile;
+}
+
+namespace LibRomData {
+
+class DetectCachePrivate;
+class DetectCache
+{
+	public:
+		/**
+		 * Open a detection cache file.
+		 *
+		 * The cache file is a fixed-size hash table that is
+		 * memory-mapped by all processes that use it. Lookups
+		 * don't take any locks; each entry has a checksum, so
+		 * entries that are being written by another process
+		 * are treated as cache misses.
+		 *
+		 * If the file doesn't exist, or if it was created with
+		 * a different signature, it will be (re-)initialized.
+		 *
+		 * @param filename Cache filename.
+		 * @param signature Signature of the detection tables. (must be non-zero)
+		 */
+		DetectCache(const std::string &filename, uint32_t signature);
+		~DetectCache();
+
+	private:
+		RP_DISABLE_COPY(DetectCache)
+	private:
+		friend class DetectCachePrivate;
+		DetectCachePrivate *const d_ptr;
+
+	public:
+		/**
+		 * File identity.
+		 * If any field changes, the cache entry is invalid.
+		 */
+		struct Key {
+			uint64_t dev;		// Device ID.
+			uint64_t ino;		// Inode number.
+			int64_t mtime;		// Modification time. (seconds)
+			int64_t size;		// File size.
+			uint32_t mtime_nsec;	// Modification time. (nanoseconds)
+			uint32_t ext_hash;	// Hash of the lowercase file extension.
+			uint32_t attrs;		// RomDataAttr bitfield passed to create().
+			uint32_t decomp;	// Decompression format + 1, or 0 if the file is read as-is.
+		};
+
+		/**
+		 * Get the cache key for a file.
+		 * Only regular files are supported.
+		 *
+		 * Detection depends on the file extension, and renaming
+		 * a file or creating a hard link doesn't change the inode
+		 * or mtime, so the extension is part of the key.
+		 *
+		 * A compressed file can be opened either as-is or with
+		 * transparent decompression, and the two views have
+		 * different contents, so the decompression format is
+		 * also part of the key.
+		 *
+		 * @param file		[in] Opened file.
+		 * @param ext_lc	[in] Lowercase file extension used for prediction. (may differ for compressed files)
+		 * @param attrs		[in] RomDataAttr bitfield.
+		 * @param pKey		[out] Cache key.
+		 * @return True on success; false on error.
+		 */
+		static bool getKey(LibRpBase::IRpFile *file, const std::string &ext_lc,
+			unsigned int attrs, Key *pKey);
+
+		/**
+		 * Special result values.
+		 * Other values are defined by the caller.
+		 */
+		enum Result : uint32_t {
+			RESULT_NONE		= 0,		// No entry. (not stored)
+			RESULT_UNSUPPORTED	= 0xFFFFFFFFU,	// File isn't supported.
+		};
+
+		/**
+		 * Is the cache open?
+		 * @return True if the cache is open; false if it isn't.
+		 */
+		bool isOpen(void) const;
+
+		/**
+		 * Look up a file in the cache.
+		 * @param key File identity.
+		 * @return Cached result, or RESULT_NONE if not found.
+		 */
+		uint32_t lookup(const Key &key) const;
+
+		/**
+		 * Store a result in the cache.
+		 * An existing entry for the same file is replaced.
+		 * @param key File identity.
+		 * @param result Result. (must not be RESULT_NONE)
+		 */
+		void store(const Key &key, uint32_t result);
+};
+
+}
+
+#endif /* __ROMPROPERTIES_LIBROMDATA_DETECTCACHE_HPP__ */
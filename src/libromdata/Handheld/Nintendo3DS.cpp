@@ -669,25 +669,35 @@ int Nintendo3DSPrivate::loadTicketAndTMD(void)
 		return -1;
 	}
 
-	/** Read the ticket. **/
+	/** Read the ticket and TMD. **/
 
-	// Determine the ticket starting address
-	// and read the signature type.
+	// Determine the ticket and TMD starting addresses
+	// and read the signature types.
+	// Both addresses are known from the CIA header,
+	// so they're read in a single batch.
 	const uint32_t ticket_start = toNext64(le32_to_cpu(mxh.cia_header.header_size)) +
 			toNext64(le32_to_cpu(mxh.cia_header.cert_chain_size));
-	uint32_t addr = ticket_start;
-	uint32_t signature_type;
-	size_t size = file->seekAndRead(addr, &signature_type, sizeof(signature_type));
-	if (size != sizeof(signature_type)) {
+	const uint32_t tmd_start = ticket_start +
+			toNext64(le32_to_cpu(mxh.cia_header.ticket_size));
+	uint32_t ticket_sig_type, tmd_sig_type;
+	const ReadSegment sig_segs[2] = {
+		{ticket_start, &ticket_sig_type, sizeof(ticket_sig_type)},
+		{tmd_start, &tmd_sig_type, sizeof(tmd_sig_type)},
+	};
+	if (file->readBatch(sig_segs, 2) != 2) {
 		// Seek and/or read error.
 		return -2;
 	}
-	signature_type = be32_to_cpu(signature_type);
+	ticket_sig_type = be32_to_cpu(ticket_sig_type);
+	tmd_sig_type = be32_to_cpu(tmd_sig_type);
 
-	// Verify the signature type.
-	if ((signature_type & 0xFFFFFFF8) != 0x00010000) {
+	// Verify the signature types.
+	if ((ticket_sig_type & 0xFFFFFFF8) != 0x00010000) {
 		// Invalid signature type.
 		return -3;
+	} else if ((tmd_sig_type & 0xFFFFFFF8) != 0x00010000) {
+		// Invalid signature type.
+		return -7;
 	}
 
 	// Skip over the signature and padding.
@@ -704,66 +714,38 @@ int Nintendo3DSPrivate::loadTicketAndTMD(void)
 		0,		// invalid
 	};
 
-	uint32_t sig_len = sig_len_tbl[signature_type & 0x07];
-	if (sig_len == 0) {
+	const uint32_t ticket_sig_len = sig_len_tbl[ticket_sig_type & 0x07];
+	const uint32_t tmd_sig_len = sig_len_tbl[tmd_sig_type & 0x07];
+	if (ticket_sig_len == 0) {
 		// Invalid signature type.
 		return -3;
+	} else if (tmd_sig_len == 0) {
+		// Invalid signature type.
+		return -7;
 	}
 
-	// Make sure the ticket is large enough.
+	// Make sure the ticket and TMD are large enough.
 	const uint32_t ticket_size = le32_to_cpu(mxh.cia_header.ticket_size);
-	if (ticket_size < (sizeof(N3DS_Ticket_t) + sig_len)) {
+	if (ticket_size < (sizeof(N3DS_Ticket_t) + ticket_sig_len)) {
 		// Ticket is too small.
 		return -4;
 	}
-
-	// Read the ticket.
-	addr += sizeof(signature_type) + sig_len;
-	size = file->seekAndRead(addr, &mxh.ticket, sizeof(mxh.ticket));
-	if (size != sizeof(mxh.ticket)) {
-		// Seek and/or read error.
-		return -5;
-	}
-
-	/** Read the TMD. **/
-
-	// Determine the TMD starting address.
-	const uint32_t tmd_start = ticket_start +
-			toNext64(le32_to_cpu(mxh.cia_header.ticket_size));
-	addr = tmd_start;
-	size = file->seekAndRead(addr, &signature_type, sizeof(signature_type));
-	if (size != sizeof(signature_type)) {
-		// Seek and/or read error.
-		return -6;
-	}
-	signature_type = be32_to_cpu(signature_type);
-
-	// Verify the signature type.
-	if ((signature_type & 0xFFFFFFF8) != 0x00010000) {
-		// Invalid signature type.
-		return -7;
-	}
-
-	// Skip over the signature and padding.
-	sig_len = sig_len_tbl[signature_type & 0x07];
-	if (sig_len == 0) {
-		// Invalid signature type.
-		return -7;
-	}
-
-	// Make sure the TMD is large enough.
 	const uint32_t tmd_size = le32_to_cpu(mxh.cia_header.tmd_size);
-	if (tmd_size < (sizeof(N3DS_TMD_t) + sig_len)) {
+	if (tmd_size < (sizeof(N3DS_TMD_t) + tmd_sig_len)) {
 		// TMD is too small.
 		return -8;
 	}
 
-	// Read the TMD.
-	addr += sizeof(signature_type) + sig_len;
-	size = file->seekAndRead(addr, &mxh.tmd_header, sizeof(mxh.tmd_header));
-	if (size != sizeof(mxh.tmd_header)) {
+	// Read the ticket and the TMD header.
+	const uint32_t ticket_addr = ticket_start + sizeof(ticket_sig_type) + ticket_sig_len;
+	uint32_t addr = tmd_start + sizeof(tmd_sig_type) + tmd_sig_len;
+	const ReadSegment segs[2] = {
+		{ticket_addr, &mxh.ticket, sizeof(mxh.ticket)},
+		{addr, &mxh.tmd_header, sizeof(mxh.tmd_header)},
+	};
+	if (file->readBatch(segs, 2) != 2) {
 		// Seek and/or read error.
-		return -9;
+		return -5;
 	}
 
 	// Load the content chunk records.
@@ -777,7 +759,7 @@ int Nintendo3DSPrivate::loadTicketAndTMD(void)
 	const size_t content_chunks_size = content_count * sizeof(N3DS_Content_Chunk_Record_t);
 
 	addr += sizeof(N3DS_TMD_t);
-	size = file->seekAndRead(addr, content_chunks.get(), content_chunks_size);
+	size_t size = file->seekAndRead(addr, content_chunks.get(), content_chunks_size);
 	if (size != content_chunks_size) {
 		// Seek and/or read error.
 		content_count = 0;
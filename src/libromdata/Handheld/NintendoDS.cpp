@@ -149,15 +149,17 @@ class NintendoDSPrivate : public RomDataPrivate
 		 * flash carts and mask ROM hardware, so DSiWare and Wii U VC
 		 * SRLs will have non-zero data here.
 		 *
+		 * @param blank_area	[in] Contents of $1000-$3FFF.
 		 * @return True if the security data area has non-zero data; false if not.
 		 */
-		bool checkNDSSecurityDataArea(void);
+		static bool checkNDSSecurityDataArea(const uintptr_t *blank_area);
 
 		/**
 		 * Check the NDS Secure Area type.
+		 * @param secure_area	[in] First 16 bytes of the Secure Area. ($4000)
 		 * @return Secure area type.
 		 */
-		const char *checkNDSSecureArea(void);
+		const char *checkNDSSecureArea(const uint32_t *secure_area) const;
 
 		/**
 		 * Convert a Nintendo DS(i) region value to a GameTDB region code.
@@ -414,22 +416,16 @@ int NintendoDSPrivate::getTitleIndex(void) const
  * flash carts and mask ROM hardware, so DSiWare and Wii U VC
  * SRLs will have non-zero data here.
  *
+ * @param blank_area	[in] Contents of $1000-$3FFF.
  * @return True if the security data area has non-zero data; false if not.
  */
-bool NintendoDSPrivate::checkNDSSecurityDataArea(void)
+bool NintendoDSPrivate::checkNDSSecurityDataArea(const uintptr_t *blank_area)
 {
 	// Make sure 0x1000-0x3FFF is blank.
 	// NOTE: ndstool checks 0x0200-0x0FFF, but this may
 	// contain extra data for DSi-enhanced ROMs, or even
 	// for regular DS games released after the DSi.
-	uintptr_t blank_area[0x3000/sizeof(uintptr_t)];
-	size_t size = file->seekAndRead(0x1000, blank_area, sizeof(blank_area));
-	if (size != sizeof(blank_area)) {
-		// Seek and/or read error.
-		return false;
-	}
-
-	const uintptr_t *const end = &blank_area[ARRAY_SIZE(blank_area)-1];
+	const uintptr_t *const end = &blank_area[(0x3000/sizeof(uintptr_t))-1];
 	for (const uintptr_t *p = blank_area; p < end; p += 2) {
 		if (p[0] != 0 || p[1] != 0) {
 			// Not zero. This isn't a dumped ROM.
@@ -443,21 +439,11 @@ bool NintendoDSPrivate::checkNDSSecurityDataArea(void)
 
 /**
  * Check the NDS Secure Area type.
+ * @param secure_area	[in] First 16 bytes of the Secure Area. ($4000)
  * @return Secure area type, or nullptr if unknown.
  */
-const char *NintendoDSPrivate::checkNDSSecureArea(void)
+const char *NintendoDSPrivate::checkNDSSecureArea(const uint32_t *secure_area) const
 {
-	// Read the start of the Secure Area.
-	// NOTE: We only need to check the first two DWORDs, but
-	// we're reading the first four because CIAReader only
-	// supports multiples of 16 bytes right now.
-	uint32_t secure_area[4];
-	size_t size = file->seekAndRead(0x4000, secure_area, sizeof(secure_area));
-	if (size != sizeof(secure_area)) {
-		// Seek and/or read error.
-		return nullptr;
-	}
-
 	// Reference: https://github.com/devkitPro/ndstool/blob/master/source/header.cpp#L39
 
 	const char *secType = nullptr;
@@ -1096,15 +1082,28 @@ int NintendoDS::loadFieldData(void)
 	d->fields->addField_string_numeric(C_("RomData", "Revision"),
 		romHeader->rom_version, RomFields::FB_DEC, 2);
 
+	// Read the security data area and the start of the Secure Area.
+	// These are adjacent, so they're read in a single batch.
+	// NOTE: We only need to check the first two DWORDs of the
+	// Secure Area, but we're reading the first four because
+	// CIAReader only supports multiples of 16 bytes right now.
+	uintptr_t blank_area[0x3000/sizeof(uintptr_t)];
+	uint32_t secure_area[4];
+	const ReadSegment segs[2] = {
+		{0x1000, blank_area, sizeof(blank_area)},
+		{0x4000, secure_area, sizeof(secure_area)},
+	};
+	const bool secReadOK = (d->file->readBatch(segs, 2) == 2);
+
 	// Is the security data present?
 	d->fields->addField_string(C_("NintendoDS", "Security Data"),
-		d->checkNDSSecurityDataArea() ? "Present" : "Missing");
+		secReadOK && d->checkNDSSecurityDataArea(blank_area) ? "Present" : "Missing");
 
 	// Secure Area.
 	// TODO: Verify the CRC.
-	const char *secure_area = d->checkNDSSecureArea();
+	const char *const secType = (secReadOK ? d->checkNDSSecureArea(secure_area) : nullptr);
 	d->fields->addField_string(C_("NintendoDS", "Secure Area"),
-		secure_area ? secure_area : C_("NintendoDS", "Unknown"));
+		secType ? secType : C_("NintendoDS", "Unknown"));
 
 	// Hardware type.
 	// NOTE: DS_HW_DS is inverted bit0; DS_HW_DSi is normal bit1.
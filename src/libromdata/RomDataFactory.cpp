@@ -19,6 +19,7 @@
  ***************************************************************************/
 
 #include "librpbase/config.librpbase.h"
+#include "libromdata/config.libromdata.h"
 
 #include "RomDataFactory.hpp"
 
@@ -27,21 +28,33 @@
 #include "librpbase/byteswap.h"
 #include "librpbase/RomData.hpp"
 #include "librpbase/file/IRpFile.hpp"
+#include "librpbase/file/RpFile.hpp"
+#include "librpbase/file/IDecompReader.hpp"
+#ifdef HAVE_MMAP
+# include "librpbase/file/RpMmapFile.hpp"
+#endif /* HAVE_MMAP */
 #include "librpbase/file/FileSystem.hpp"
 #include "librpbase/file/RelatedFile.hpp"
 #include "librpbase/threads/pthread_once.h"
 using namespace LibRpBase;
 
+#ifdef HAVE_DETECTCACHE
+# include "DetectCache.hpp"
+#endif /* HAVE_DETECTCACHE */
+
 // C includes. (C++ namespace)
 #include <cassert>
 #include <cstring>
 
 // C++ includes.
+#include <algorithm>
+#include <memory>
 #include <string>
 #include <unordered_map>
 #include <unordered_set>
 #include <vector>
 using std::string;
+using std::unique_ptr;
 using std::unordered_map;
 using std::unordered_set;
 using std::vector;
@@ -123,6 +136,15 @@ class RomDataFactoryPrivate
 		typedef const char *const * (*pfnSupportedMimeTypes_t)(void);
 		typedef RomData* (*pfnNewRomData_t)(IRpFile *file);
 
+		// Maximum amount of data to decompress in order to
+		// determine the file size for detection. Files that
+		// don't store the uncompressed size (bzip2, zstd
+		// without frame sizes) are only decompressed up to
+		// this size; larger files get a lower bound instead.
+		// NOTE: Must be larger than any exact size checked by
+		// isRomSupported_static(). (GameCubeSave: ~16 MB)
+		static const int64_t DETECT_MAX_DECOMP_SIZE = 32*1024*1024;
+
 		struct RomDataFns {
 			pfnIsRomSupported_t isRomSupported;
 			pfnNewRomData_t newRomData;
@@ -164,8 +186,39 @@ class RomDataFactoryPrivate
 		// definitely have a 32-bit magic number in the header.
 		// - address: Address of magic number within the header.
 		// - size: 32-bit magic number.
+		// NOTE: A class may be listed multiple times if it
+		// has more than one magic number.
 		static const RomDataFns romDataFns_magic[];
 
+		/**
+		 * Magic number dispatch table entry.
+		 * Sorted by address, then by magic number.
+		 */
+		struct MagicDispatch {
+			uint32_t address;	// Address of the magic number.
+			uint32_t magic;		// 32-bit magic number.
+			unsigned int idx;	// Index in romDataFns_magic[].
+
+			inline bool operator<(const MagicDispatch &other) const
+			{
+				return (address < other.address ||
+					(address == other.address && magic < other.magic));
+			}
+		};
+
+		// Magic number dispatch table, and the
+		// distinct magic number addresses in order.
+		static vector<MagicDispatch> vec_magicDispatch;
+		static vector<uint32_t> vec_magicAddrs;
+		static pthread_once_t once_magicDispatch;
+
+		/**
+		 * Initialize the magic number dispatch table.
+		 *
+		 * Internal function; must be called using pthread_once().
+		 */
+		static void init_magicDispatch(void);
+
 		// RomData subclasses that use a header.
 		// Headers with addresses other than 0 should be
 		// placed at the end of this array.
@@ -214,6 +267,93 @@ class RomDataFactoryPrivate
 		 * Internal function; must be called using pthread_once().
 		 */
 		static void init_supportedMimeTypes(void);
+
+		// Case-insensitive lookup tables. Keys are lowercase.
+		// - map_extFns: RomData subclasses that support each
+		//   file extension, in table order. (init with vec_exts)
+		// - set_mimeTypes: All MIME types. (init with vec_mimeTypes)
+		typedef vector<const RomDataFns*> RomDataFnsList;
+		static unordered_map<string, RomDataFnsList> map_extFns;
+		static unordered_set<string> set_mimeTypes;
+
+		/**
+		 * Convert an ASCII string to lowercase.
+		 * @param str String.
+		 * @return Lowercase string.
+		 */
+		static string toLower(const char *str);
+
+		/**
+		 * Get the file extension used to predict the RomData subclass.
+		 * For compressed files, this is the extension before the
+		 * compression suffix, e.g. ".nds" for "game.nds.gz".
+		 * @param filename Filename.
+		 * @return Lowercase file extension, or empty string if none.
+		 */
+		static string lookupExt(const string &filename);
+
+		/**
+		 * Get the RomData subclasses that support a file extension.
+		 * @param ext_lc Lowercase file extension.
+		 * @return RomData subclasses, or nullptr if none.
+		 */
+		static const RomDataFnsList *extFns(const string &ext_lc);
+
+		/**
+		 * Check if a RomData subclass is in a list.
+		 * @param fnsList List, or nullptr.
+		 * @param fns RomData subclass.
+		 * @return True if fns is in fnsList; false if not.
+		 */
+		static inline bool hasFns(const RomDataFnsList *fnsList, const RomDataFns *fns)
+		{
+			return (fnsList != nullptr &&
+				std::find(fnsList->cbegin(), fnsList->cend(), fns) != fnsList->cend());
+		}
+
+		/**
+		 * Detect the RomData subclass for a file by checking its header and footer.
+		 * Common function for create().
+		 * @param file		[in] ROM file.
+		 * @param attrs		[in] RomDataAttr bitfield.
+		 * @param info		[in/out] DetectInfo. (szFile and ext must be set)
+		 * @param ext_lc	[in] Lowercase file extension used for prediction.
+		 * @param extFnsList	[in] RomData subclasses that support ext_lc, or nullptr.
+		 * @param ppFns		[out] RomData subclass that was detected.
+		 * @param pRejected	[out] If the ROM isn't supported: True if the header checks rejected it;
+		 *			false if a read error occurred or a subclass failed to load it.
+		 * @return RomData subclass, or nullptr if the ROM isn't supported.
+		 */
+		static RomData *detect(IRpFile *file, unsigned int attrs, RomData::DetectInfo &info,
+			const string &ext_lc, const RomDataFnsList *extFnsList,
+			const RomDataFns **ppFns, bool *pRejected);
+
+#ifdef HAVE_DETECTCACHE
+		// Persistent detection cache.
+		static unique_ptr<DetectCache> detectCache;
+		static pthread_once_t once_detectCache;
+
+		/**
+		 * Open the detection cache.
+		 *
+		 * Internal function; must be called using pthread_once().
+		 */
+		static void init_detectCache(void);
+
+		/**
+		 * Get the detection cache ID for a RomData subclass.
+		 * @param fns RomData subclass.
+		 * @return Detection cache ID.
+		 */
+		static uint32_t cacheIdFromFns(const RomDataFns *fns);
+
+		/**
+		 * Get the RomData subclass for a detection cache ID.
+		 * @param id Detection cache ID.
+		 * @return RomData subclass, or nullptr if the ID is invalid.
+		 */
+		static const RomDataFns *fnsFromCacheId(uint32_t id);
+#endif /* HAVE_DETECTCACHE */
 };
 
 /** RomDataFactoryPrivate **/
@@ -222,6 +362,17 @@ vector<RomDataFactory::ExtInfo> RomDataFactoryPrivate::vec_exts;
 vector<const char*> RomDataFactoryPrivate::vec_mimeTypes;
 pthread_once_t RomDataFactoryPrivate::once_exts = PTHREAD_ONCE_INIT;
 pthread_once_t RomDataFactoryPrivate::once_mimeTypes = PTHREAD_ONCE_INIT;
+unordered_map<string, RomDataFactoryPrivate::RomDataFnsList> RomDataFactoryPrivate::map_extFns;
+unordered_set<string> RomDataFactoryPrivate::set_mimeTypes;
+
+vector<RomDataFactoryPrivate::MagicDispatch> RomDataFactoryPrivate::vec_magicDispatch;
+vector<uint32_t> RomDataFactoryPrivate::vec_magicAddrs;
+pthread_once_t RomDataFactoryPrivate::once_magicDispatch = PTHREAD_ONCE_INIT;
+
+#ifdef HAVE_DETECTCACHE
+unique_ptr<DetectCache> RomDataFactoryPrivate::detectCache;
+pthread_once_t RomDataFactoryPrivate::once_detectCache = PTHREAD_ONCE_INIT;
+#endif /* HAVE_DETECTCACHE */
 
 #define ATTR_NONE RomDataFactory::RDA_NONE
 #define ATTR_HAS_THUMBNAIL RomDataFactory::RDA_HAS_THUMBNAIL
@@ -231,9 +382,14 @@ pthread_once_t RomDataFactoryPrivate::once_mimeTypes = PTHREAD_ONCE_INIT;
 // definitely have a 32-bit magic number in the header.
 // - address: Address of magic number within the header.
 // - size: 32-bit magic number.
-// TODO: Add support for multiple magic numbers per class.
+// NOTE: A class may be listed multiple times if it
+// has more than one magic number.
 const RomDataFactoryPrivate::RomDataFns RomDataFactoryPrivate::romDataFns_magic[] = {
 	// Consoles
+	GetRomDataFns_addr(N64, ATTR_NONE, 0, 0x80371240),	// Z64
+	GetRomDataFns_addr(N64, ATTR_NONE, 0, 0x37804012),	// V64
+	GetRomDataFns_addr(N64, ATTR_NONE, 0, 0x12408037),	// SWAP2
+	GetRomDataFns_addr(N64, ATTR_NONE, 0, 0x40123780),	// LE32
 	GetRomDataFns_addr(WiiWIBN, RomDataFactory::RDA_HAS_THUMBNAIL, 0, 'WIBN'),
 
 	// Handhelds
@@ -255,11 +411,28 @@ const RomDataFactoryPrivate::RomDataFns RomDataFactoryPrivate::romDataFns_magic[
 	// Audio
 	GetRomDataFns_addr(GBS, ATTR_NONE, 0, 'GBS\x01'),
 	GetRomDataFns_addr(NSF, ATTR_NONE, 0, 'NESM'),
+	GetRomDataFns_addr(SAP, ATTR_NONE, 0, 'SAP\r'),	// "SAP\r\n"
+	GetRomDataFns_addr(SAP, ATTR_NONE, 0, 'SAP\n'),
+	GetRomDataFns_addr(SID, ATTR_NONE, 0, 'PSID'),
+	GetRomDataFns_addr(SID, ATTR_NONE, 0, 'RSID'),
+	GetRomDataFns_addr(SNDH, ATTR_NONE, 12, 'SNDH'),
+#ifdef ENABLE_UNICE68
+	// Packed SNDH files.
+	GetRomDataFns_addr(SNDH, ATTR_NONE, 0, 'ICE!'),
+	GetRomDataFns_addr(SNDH, ATTR_NONE, 0, 'Ice!'),
+#endif /* ENABLE_UNICE68 */
 	GetRomDataFns_addr(SPC, ATTR_NONE, 0, 'SNES'),
 	GetRomDataFns_addr(VGM, ATTR_NONE, 0, 'Vgm '),
 
 	// Other
 	GetRomDataFns_addr(ELF, ATTR_NONE, 0, '\177ELF'),
+	GetRomDataFns_addr(MachO, ATTR_NONE, 0, 0xFEEDFACE),	// MH_MAGIC
+	GetRomDataFns_addr(MachO, ATTR_NONE, 0, 0xCEFAEDFE),	// MH_CIGAM
+	GetRomDataFns_addr(MachO, ATTR_NONE, 0, 0xFEEDFACF),	// MH_MAGIC_64
+	GetRomDataFns_addr(MachO, ATTR_NONE, 0, 0xCFFAEDFE),	// MH_CIGAM_64
+	GetRomDataFns_addr(MachO, ATTR_NONE, 0, 0xCAFEBABE),	// FAT_MAGIC
+	GetRomDataFns_addr(NintendoBadge, ATTR_HAS_THUMBNAIL, 0, 'PRBS'),
+	GetRomDataFns_addr(NintendoBadge, ATTR_HAS_THUMBNAIL, 0, 'CABS'),
 
 	{nullptr, nullptr, nullptr, nullptr, ATTR_NONE, 0, 0}
 };
@@ -275,7 +448,6 @@ const RomDataFactoryPrivate::RomDataFns RomDataFactoryPrivate::romDataFns_header
 	GetRomDataFns(GameCubeBNR, ATTR_HAS_THUMBNAIL),
 	GetRomDataFns(GameCubeSave, ATTR_HAS_THUMBNAIL),
 	GetRomDataFns(MegaDrive, ATTR_NONE),
-	GetRomDataFns(N64, ATTR_NONE),
 	GetRomDataFns(NES, ATTR_NONE),
 	GetRomDataFns(SNES, ATTR_NONE),
 	GetRomDataFns(SegaSaturn, ATTR_NONE),
@@ -293,14 +465,9 @@ const RomDataFactoryPrivate::RomDataFns RomDataFactoryPrivate::romDataFns_header
 	// Audio
 	GetRomDataFns(ADX, ATTR_NONE),
 	GetRomDataFns(PSF, ATTR_NONE),
-	GetRomDataFns(SAP, ATTR_NONE),	// "SAP\r\n", "SAP\n"; maybe move to _magic[]?
-	GetRomDataFns(SNDH, ATTR_NONE),	// "SNDH", or "ICE!" or "Ice!" if packed.
-	GetRomDataFns(SID, ATTR_NONE),	// PSID/RSID; maybe move to _magic[]?
 
 	// Other
 	GetRomDataFns(Amiibo, ATTR_HAS_THUMBNAIL),
-	GetRomDataFns(MachO, ATTR_NONE),
-	GetRomDataFns(NintendoBadge, ATTR_HAS_THUMBNAIL),
 
 	// The following formats have 16-bit magic numbers,
 	// so they should go at the end of the address=0 section.
@@ -402,6 +569,191 @@ RomData *RomDataFactoryPrivate::openDreamcastVMSandVMI(IRpFile *file)
 	return dcSave;
 }
 
+/**
+ * Convert an ASCII string to lowercase.
+ * @param str String.
+ * @return Lowercase string.
+ */
+string RomDataFactoryPrivate::toLower(const char *str)
+{
+	string ret(str);
+	for (auto iter = ret.begin(); iter != ret.end(); ++iter) {
+		if (*iter >= 'A' && *iter <= 'Z') {
+			*iter |= 0x20;
+		}
+	}
+	return ret;
+}
+
+/**
+ * Get the file extension used to predict the RomData subclass.
+ * For compressed files, this is the extension before the
+ * compression suffix, e.g. ".nds" for "game.nds.gz".
+ * @param filename Filename.
+ * @return Lowercase file extension, or empty string if none.
+ */
+string RomDataFactoryPrivate::lookupExt(const string &filename)
+{
+	const char *ext = FileSystem::file_ext(filename);
+	if (!ext) {
+		return string();
+	}
+
+	// Compression suffixes handled by RpFile.
+	static const char *const comp_exts[] = {
+		".gz", ".xz", ".bz2", ".zst",
+		nullptr
+	};
+	for (const char *const *comp_ext = comp_exts; *comp_ext != nullptr; comp_ext++) {
+		if (!strcasecmp(ext, *comp_ext)) {
+			// Use the extension before the compression suffix, if any.
+			const string basename = filename.substr(0, ext - filename.c_str());
+			const char *const inner_ext = FileSystem::file_ext(basename);
+			return (inner_ext ? toLower(inner_ext) : string());
+		}
+	}
+
+	return toLower(ext);
+}
+
+/**
+ * Get the RomData subclasses that support a file extension.
+ * @param ext_lc Lowercase file extension.
+ * @return RomData subclasses, or nullptr if none.
+ */
+const RomDataFactoryPrivate::RomDataFnsList *RomDataFactoryPrivate::extFns(const string &ext_lc)
+{
+	pthread_once(&once_exts, init_supportedFileExtensions);
+	auto iter = map_extFns.find(ext_lc);
+	return (iter != map_extFns.end() ? &iter->second : nullptr);
+}
+
+/**
+ * Initialize the magic number dispatch table.
+ *
+ * Internal function; must be called using pthread_once().
+ */
+void RomDataFactoryPrivate::init_magicDispatch(void)
+{
+	vec_magicDispatch.reserve(ARRAY_SIZE(romDataFns_magic) - 1);
+	const RomDataFns *fns = &romDataFns_magic[0];
+	for (unsigned int i = 0; fns->supportedFileExtensions != nullptr; fns++, i++) {
+		// Magic numbers must be 32-bit aligned.
+		assert(fns->address % 4 == 0);
+		assert(fns->address + sizeof(uint32_t) <= 4096+256);
+		MagicDispatch entry = {fns->address, fns->size, i};
+		vec_magicDispatch.push_back(entry);
+	}
+
+	// Sort by address and magic number.
+	// NOTE: stable_sort() is used in order to keep the
+	// table order for classes with the same magic number.
+	std::stable_sort(vec_magicDispatch.begin(), vec_magicDispatch.end());
+
+	// Get the distinct addresses.
+	for (auto iter = vec_magicDispatch.cbegin(); iter != vec_magicDispatch.cend(); ++iter) {
+		if (vec_magicAddrs.empty() || vec_magicAddrs.back() != iter->address) {
+			vec_magicAddrs.push_back(iter->address);
+		}
+	}
+}
+
+#ifdef HAVE_DETECTCACHE
+/**
+ * Open the detection cache.
+ *
+ * Internal function; must be called using pthread_once().
+ */
+void RomDataFactoryPrivate::init_detectCache(void)
+{
+	string cache_filename = FileSystem::getCacheDirectory();
+	if (cache_filename.empty())
+		return;
+	if (cache_filename.at(cache_filename.size()-1) != DIR_SEP_CHR)
+		cache_filename += DIR_SEP_CHR;
+	cache_filename += "detect.cache";
+	if (FileSystem::rmkdir(cache_filename) != 0)
+		return;
+
+	// The signature identifies the layout of the detection tables.
+	// Cache IDs are indexes into these tables, so if any class is
+	// added, removed, or reordered, the cache must be discarded.
+	// Each class is identified by its first file extension.
+	// (FNV-1a hash)
+	uint32_t signature = 2166136261U;
+	const RomDataFns *const tables[] = {
+		romDataFns_magic, romDataFns_header, romDataFns_footer
+	};
+	for (unsigned int i = 0; i < ARRAY_SIZE(tables); i++) {
+		const RomDataFns *fns = tables[i];
+		for (; fns->supportedFileExtensions != nullptr; fns++) {
+			const uint32_t vals[] = {fns->attrs, fns->address, fns->size};
+			const uint8_t *p = reinterpret_cast<const uint8_t*>(vals);
+			for (unsigned int j = 0; j < sizeof(vals); j++) {
+				signature = (signature ^ p[j]) * 16777619U;
+			}
+			const char *const *const exts = fns->supportedFileExtensions();
+			for (const char *ext = (exts ? exts[0] : nullptr); ext && *ext != '\0'; ext++) {
+				signature = (signature ^ static_cast<uint8_t>(*ext)) * 16777619U;
+			}
+		}
+		// Table separator.
+		signature = (signature ^ 0xFF) * 16777619U;
+	}
+	if (signature == 0) {
+		signature = 1;
+	}
+
+	unique_ptr<DetectCache> cache(new DetectCache(cache_filename, signature));
+	if (cache->isOpen()) {
+		detectCache = std::move(cache);
+	}
+}
+
+/**
+ * Get the detection cache ID for a RomData subclass.
+ * @param fns RomData subclass.
+ * @return Detection cache ID.
+ */
+uint32_t RomDataFactoryPrivate::cacheIdFromFns(const RomDataFns *fns)
+{
+	// IDs are 1-based indexes into the magic, header,
+	// and footer tables, in that order.
+	static const unsigned int magic_count = ARRAY_SIZE(romDataFns_magic) - 1;
+	static const unsigned int header_count = ARRAY_SIZE(romDataFns_header) - 1;
+	if (fns >= &romDataFns_magic[0] && fns < &romDataFns_magic[magic_count]) {
+		return static_cast<uint32_t>(fns - &romDataFns_magic[0]) + 1;
+	} else if (fns >= &romDataFns_header[0] && fns < &romDataFns_header[header_count]) {
+		return static_cast<uint32_t>(fns - &romDataFns_header[0]) + magic_count + 1;
+	}
+	return static_cast<uint32_t>(fns - &romDataFns_footer[0]) + magic_count + header_count + 1;
+}
+
+/**
+ * Get the RomData subclass for a detection cache ID.
+ * @param id Detection cache ID.
+ * @return RomData subclass, or nullptr if the ID is invalid.
+ */
+const RomDataFactoryPrivate::RomDataFns *RomDataFactoryPrivate::fnsFromCacheId(uint32_t id)
+{
+	static const unsigned int magic_count = ARRAY_SIZE(romDataFns_magic) - 1;
+	static const unsigned int header_count = ARRAY_SIZE(romDataFns_header) - 1;
+	static const unsigned int footer_count = ARRAY_SIZE(romDataFns_footer) - 1;
+	if (id == 0)
+		return nullptr;
+	id--;
+	if (id < magic_count)
+		return &romDataFns_magic[id];
+	id -= magic_count;
+	if (id < header_count)
+		return &romDataFns_header[id];
+	id -= header_count;
+	if (id < footer_count)
+		return &romDataFns_footer[id];
+	return nullptr;
+}
+#endif /* HAVE_DETECTCACHE */
+
 /** RomDataFactory **/
 
 /**
@@ -415,6 +767,13 @@ RomData *RomDataFactoryPrivate::openDreamcastVMSandVMI(IRpFile *file)
  * types must be supported by the RomData subclass in order to
  * be returned.
  *
+ * If attrs is non-zero and the file has an extension that isn't
+ * registered by any RomData subclass with the specified attributes,
+ * the file is rejected without reading the header.
+ *
+ * RomData subclasses that register the file's extension are
+ * checked before all other RomData subclasses.
+ *
  * @param file ROM file.
  * @param attrs RomDataAttr bitfield. If set, RomData subclass must have the specified attributes.
  * @return RomData subclass, or nullptr if the ROM isn't supported.
@@ -424,37 +783,56 @@ RomData *RomDataFactory::create(IRpFile *file, unsigned int attrs)
 	RomData::DetectInfo info;
 
 	// Get the file size.
-	info.szFile = file->size();
-
-	// Read 4,096+256 bytes from the ROM header.
-	// This should be enough to detect most systems.
-	union {
-		uint8_t u8[4096+256];
-		uint32_t u32[(4096+256)/4];
-	} header;
-	file->rewind();
-	info.header.addr = 0;
-	info.header.pData = header.u8;
-	info.header.size = static_cast<uint32_t>(file->read(header.u8, sizeof(header.u8)));
-	if (info.header.size == 0) {
-		// Read error.
+	// NOTE: For some compressed files, this may be a lower bound.
+	// detect() will get the actual size if it's needed.
+	info.szFile = file->sizeUpTo(RomDataFactoryPrivate::DETECT_MAX_DECOMP_SIZE);
+	if (info.szFile == 0) {
+		// Empty file.
 		return nullptr;
 	}
 
 	// Get the file extension.
+	// For compressed files, the extension before the
+	// compression suffix is used to predict the class.
 	info.ext = nullptr;
 	const string filename = file->filename();
+	string ext_lc;
 	if (!filename.empty()) {
 		info.ext = FileSystem::file_ext(filename);
+		ext_lc = RomDataFactoryPrivate::lookupExt(filename);
+	}
+	const RomDataFactoryPrivate::RomDataFnsList *const extFnsList =
+		(!ext_lc.empty() ? RomDataFactoryPrivate::extFns(ext_lc) : nullptr);
+	if (attrs != 0 && !ext_lc.empty()) {
+		// Make sure at least one class that supports this
+		// extension has the required attributes.
+		bool attrsOK = false;
+		if (extFnsList) {
+			for (auto iter = extFnsList->cbegin(); iter != extFnsList->cend(); ++iter) {
+				if (((*iter)->attrs & attrs) == attrs) {
+					attrsOK = true;
+					break;
+				}
+			}
+		}
+		if (!attrsOK) {
+			// No class supports this extension with the required
+			// attributes. Don't bother reading the header.
+			return nullptr;
+		}
 	}
 
 	// Special handling for Dreamcast .VMI+.VMS pairs.
+	// NOTE: The result depends on the other file in the pair,
+	// so these files aren't stored in the detection cache.
+	bool useCache = true;
 	if (info.ext != nullptr &&
 	    (!strcasecmp(info.ext, ".vms") ||
 	     !strcasecmp(info.ext, ".vmi")))
 	{
 		// Dreamcast .VMI+.VMS pair.
 		// Attempt to open the other file in the pair.
+		useCache = false;
 		RomData *romData = RomDataFactoryPrivate::openDreamcastVMSandVMI(file);
 		if (romData) {
 			if (romData->isValid()) {
@@ -468,47 +846,240 @@ RomData *RomDataFactory::create(IRpFile *file, unsigned int attrs)
 		// Not a .VMI+.VMS pair.
 	}
 
-	// Check RomData subclasses that take a header at 0x0000
-	// and definitely have a 32-bit magic number in the header.
-	const RomDataFactoryPrivate::RomDataFns *fns =
-		&RomDataFactoryPrivate::romDataFns_magic[0];
-	for (; fns->supportedFileExtensions != nullptr; fns++) {
-		if ((fns->attrs & attrs) != attrs) {
-			// This RomData subclass doesn't have the
-			// required attributes.
-			continue;
+#ifdef HAVE_DETECTCACHE
+	// Check the detection cache.
+	// If the file was checked before and hasn't changed,
+	// the header doesn't need to be checked again.
+	DetectCache *cache = nullptr;
+	DetectCache::Key cacheKey;
+	if (useCache) {
+		pthread_once(&RomDataFactoryPrivate::once_detectCache,
+			RomDataFactoryPrivate::init_detectCache);
+		cache = RomDataFactoryPrivate::detectCache.get();
+		if (cache && !DetectCache::getKey(file, ext_lc, attrs, &cacheKey)) {
+			// Not a regular file.
+			cache = nullptr;
+		}
+	}
+	if (cache) {
+		const uint32_t result = cache->lookup(cacheKey);
+		if (result == DetectCache::RESULT_UNSUPPORTED) {
+			// File isn't supported.
+			return nullptr;
 		}
 
-		// Check the magic number.
-		// TODO: Verify alignment restrictions.
-		assert(fns->address % 4 == 0);
-		assert(fns->address + sizeof(uint32_t) <= sizeof(header.u32));
-		// FIXME: Fix strict aliasing warnings on Ubuntu 14.04.
-		uint32_t magic = header.u32[fns->address/4];
-		if (be32_to_cpu(magic) == fns->size) {
-			// Found a matching magic number.
+		const RomDataFactoryPrivate::RomDataFns *const fns =
+			RomDataFactoryPrivate::fnsFromCacheId(result);
+		if (fns) {
+			RomData *const romData = fns->newRomData(file);
+			if (romData->isValid()) {
+				// RomData subclass obtained.
+				return romData;
+			}
+
+			// Not actually supported.
+			// Check the file again.
+			romData->unref();
+		}
+	}
+#else /* !HAVE_DETECTCACHE */
+	RP_UNUSED(useCache);
+#endif /* HAVE_DETECTCACHE */
+
+	const RomDataFactoryPrivate::RomDataFns *fns = nullptr;
+	bool rejected = false;
+	RomData *const romData = RomDataFactoryPrivate::detect(
+		file, attrs, info, ext_lc, extFnsList, &fns, &rejected);
+
+#ifdef HAVE_DETECTCACHE
+	if (cache) {
+		if (romData) {
+			cache->store(cacheKey, RomDataFactoryPrivate::cacheIdFromFns(fns));
+		} else if (rejected) {
+			// Only store the result if the header checks
+			// rejected the file. Read errors and subclass
+			// failures may be transient.
+			cache->store(cacheKey, DetectCache::RESULT_UNSUPPORTED);
+		}
+	}
+#endif /* HAVE_DETECTCACHE */
+	return romData;
+}
+
+/**
+ * Detect the RomData subclass for a file by checking its header and footer.
+ * Common function for create().
+ * @param file		[in] ROM file.
+ * @param attrs		[in] RomDataAttr bitfield.
+ * @param info		[in/out] DetectInfo. (szFile and ext must be set)
+ * @param ext_lc	[in] Lowercase file extension used for prediction.
+ * @param extFnsList	[in] RomData subclasses that support ext_lc, or nullptr.
+ * @param ppFns		[out] RomData subclass that was detected.
+ * @param pRejected	[out] If the ROM isn't supported: True if the header checks rejected it;
+ *			false if a read error occurred or a subclass failed to load it.
+ * @return RomData subclass, or nullptr if the ROM isn't supported.
+ */
+RomData *RomDataFactoryPrivate::detect(IRpFile *file, unsigned int attrs, RomData::DetectInfo &info,
+	const string &ext_lc, const RomDataFnsList *extFnsList,
+	const RomDataFns **ppFns, bool *pRejected)
+{
+	*ppFns = nullptr;
+	*pRejected = true;
+
+	// Read 4,096+256 bytes from the ROM header.
+	// This should be enough to detect most systems.
+	union {
+		uint8_t u8[4096+256];
+		uint32_t u32[(4096+256)/4];
+	} header;
+	file->rewind();
+	info.header.addr = 0;
+
+	// If the file is memory-backed, borrow the header
+	// directly instead of copying it.
+	// NOTE: Mappings are page-aligned, so 32-bit access is fine.
+	size_t szHeader = sizeof(header.u8);
+	if (info.szFile >= 0 && info.szFile < static_cast<int64_t>(szHeader)) {
+		szHeader = static_cast<size_t>(info.szFile);
+	}
+	const uint8_t *const pBorrowed = static_cast<const uint8_t*>(file->borrow(0, szHeader));
+	if (pBorrowed) {
+		info.header.pData = pBorrowed;
+		info.header.size = static_cast<uint32_t>(szHeader);
+	} else {
+		info.header.pData = header.u8;
+		info.header.size = static_cast<uint32_t>(file->read(header.u8, sizeof(header.u8)));
+	}
+	if (info.header.size == 0) {
+		// Read error.
+		*pRejected = false;
+		return nullptr;
+	}
+	const uint32_t *const pHeader32 = reinterpret_cast<const uint32_t*>(info.header.pData);
+
+	// Check RomData subclasses that support the file extension first.
+	// Only classes that use the header at 0x0000 are checked here;
+	// these are skipped when checking the rest of the classes.
+	const RomDataFns *const magic_begin = &romDataFns_magic[0];
+	const RomDataFns *const magic_end = &romDataFns_magic[ARRAY_SIZE(romDataFns_magic)];
+	RomDataFnsList vec_predicted;
+	if (extFnsList) {
+		vec_predicted.reserve(extFnsList->size());
+		for (auto iter = extFnsList->cbegin(); iter != extFnsList->cend(); ++iter) {
+			const RomDataFns *const fns = *iter;
+			if ((fns->attrs & attrs) != attrs) {
+				// This RomData subclass doesn't have the
+				// required attributes.
+				continue;
+			}
+
+			if (fns >= magic_begin && fns < magic_end) {
+				// Magic number class. Check the magic number.
+				if (fns->address + sizeof(uint32_t) > info.header.size ||
+				    be32_to_cpu(pHeader32[fns->address/4]) != fns->size)
+				{
+					// Magic number doesn't match.
+					vec_predicted.push_back(fns);
+					continue;
+				}
+			} else if (fns->address != 0 || fns->size > info.header.size) {
+				// Header isn't at 0x0000, or is too big.
+				// This class will be checked later.
+				continue;
+			}
+
+			vec_predicted.push_back(fns);
 			if (fns->isRomSupported(&info) >= 0) {
 				RomData *const romData = fns->newRomData(file);
 				if (romData->isValid()) {
 					// RomData subclass obtained.
+					*ppFns = fns;
 					return romData;
 				}
 
 				// Not actually supported.
+				// This may be due to a transient error, e.g.
+				// a read error past the header.
+				*pRejected = false;
 				romData->unref();
 			}
 		}
 	}
 
+	// Check RomData subclasses that take a header at 0x0000
+	// and definitely have a 32-bit magic number in the header.
+	// The dispatch table is sorted by (address, magic), so only
+	// one binary search is needed per magic number address.
+	pthread_once(&once_magicDispatch, init_magicDispatch);
+
+	// Indexes of matching classes in romDataFns_magic[].
+	unsigned int magic_matches[ARRAY_SIZE(romDataFns_magic)];
+	unsigned int magic_match_count = 0;
+	for (auto addr_iter = vec_magicAddrs.cbegin();
+	     addr_iter != vec_magicAddrs.cend(); ++addr_iter)
+	{
+		const uint32_t address = *addr_iter;
+		if (address + sizeof(uint32_t) > info.header.size) {
+			// Header is too small for this magic number.
+			// Addresses are sorted, so the rest are too large, too.
+			break;
+		}
+
+		// FIXME: Fix strict aliasing warnings on Ubuntu 14.04.
+		const MagicDispatch key = {
+			address, be32_to_cpu(pHeader32[address/4]), 0
+		};
+		auto range = std::equal_range(vec_magicDispatch.cbegin(), vec_magicDispatch.cend(), key);
+		for (auto iter = range.first; iter != range.second; ++iter) {
+			magic_matches[magic_match_count++] = iter->idx;
+		}
+	}
+
+	// Check the matching classes in table order.
+	if (magic_match_count > 1) {
+		std::sort(&magic_matches[0], &magic_matches[magic_match_count]);
+	}
+	for (unsigned int i = 0; i < magic_match_count; i++) {
+		const RomDataFns *const fns = &romDataFns_magic[magic_matches[i]];
+		if ((fns->attrs & attrs) != attrs) {
+			// This RomData subclass doesn't have the
+			// required attributes.
+			continue;
+		}
+		if (hasFns(&vec_predicted, fns)) {
+			// Already checked.
+			continue;
+		}
+
+		if (fns->isRomSupported(&info) >= 0) {
+			RomData *const romData = fns->newRomData(file);
+			if (romData->isValid()) {
+				// RomData subclass obtained.
+				*ppFns = fns;
+				return romData;
+			}
+
+			// Not actually supported.
+			// This may be due to a transient error, e.g.
+			// a read error past the header.
+			*pRejected = false;
+			romData->unref();
+		}
+	}
+
 	// Check other RomData subclasses that take a header,
 	// but don't have a simple 32-bit magic number check.
-	fns = &RomDataFactoryPrivate::romDataFns_header[0];
+	const RomDataFns *fns = &romDataFns_header[0];
 	for (; fns->supportedFileExtensions != nullptr; fns++) {
 		if ((fns->attrs & attrs) != attrs) {
 			// This RomData subclass doesn't have the
 			// required attributes.
 			continue;
 		}
+		if (hasFns(&vec_predicted, fns)) {
+			// Already checked.
+			continue;
+		}
 
 		if (fns->address != info.header.addr ||
 		    fns->size > info.header.size)
@@ -517,18 +1088,16 @@ RomData *RomDataFactory::create(IRpFile *file, unsigned int attrs)
 
 			// Check the file extension to reduce overhead
 			// for file types that don't use this.
-			// TODO: Don't hard-code this.
-			// Use a pointer to supportedFileExtensions_static() instead?
-			if (info.ext == nullptr) {
+			// The class must support the file extension,
+			// or the file must have the generic ".bin" extension.
+			if (ext_lc.empty()) {
 				// No file extension...
 				break;
-			} else if (strcasecmp(info.ext, ".bin") != 0 &&	/* generic .bin */
-				   strcasecmp(info.ext, ".sms") != 0 &&	/* Sega Master System */
-				   strcasecmp(info.ext, ".gg") != 0 &&	/* Game Gear */
-				   strcasecmp(info.ext, ".tgc") != 0)	/* game.com */
+			} else if (ext_lc != ".bin" &&
+				   !hasFns(extFnsList, fns))
 			{
-				// Not SMS, Game Gear, or game.com.
-				break;
+				// Class doesn't support this extension.
+				continue;
 			}
 
 			// Read the new header data.
@@ -548,22 +1117,38 @@ RomData *RomDataFactory::create(IRpFile *file, unsigned int attrs)
 
 			// Read the header data.
 			info.header.addr = fns->address;
-			int ret = file->seek(info.header.addr);
-			if (ret != 0)
-				continue;
-			info.header.size = static_cast<uint32_t>(file->read(header.u8, fns->size));
-			if (info.header.size != fns->size)
-				continue;
+			const uint8_t *const pBorrowedAddr =
+				static_cast<const uint8_t*>(file->borrow(fns->address, fns->size));
+			if (pBorrowedAddr) {
+				info.header.pData = pBorrowedAddr;
+				info.header.size = fns->size;
+			} else {
+				info.header.pData = header.u8;
+				int ret = file->seek(info.header.addr);
+				if (ret != 0) {
+					*pRejected = false;
+					continue;
+				}
+				info.header.size = static_cast<uint32_t>(file->read(header.u8, fns->size));
+				if (info.header.size != fns->size) {
+					*pRejected = false;
+					continue;
+				}
+			}
 		}
 
 		if (fns->isRomSupported(&info) >= 0) {
 			RomData *const romData = fns->newRomData(file);
 			if (romData->isValid()) {
 				// RomData subclass obtained.
+				*ppFns = fns;
 				return romData;
 			}
 
 			// Not actually supported.
+			// This may be due to a transient error, e.g.
+			// a read error past the header.
+			*pRejected = false;
 			romData->unref();
 		}
 	}
@@ -576,7 +1161,7 @@ RomData *RomDataFactory::create(IRpFile *file, unsigned int attrs)
 	}
 
 	bool readFooter = false;
-	fns = &RomDataFactoryPrivate::romDataFns_footer[0];
+	fns = &romDataFns_footer[0];
 	for (; fns->supportedFileExtensions != nullptr; fns++) {
 		if ((fns->attrs & attrs) != attrs) {
 			// This RomData subclass doesn't have the
@@ -585,21 +1170,38 @@ RomData *RomDataFactory::create(IRpFile *file, unsigned int attrs)
 		}
 
 		// Do we have a matching extension?
-		// FIXME: Instead of hard-coded, check supportedFileExtensions.
-		// Currently only supports VirtualBoy.
-		if (!info.ext || strcasecmp(info.ext, ".vb") != 0) {
+		if (!hasFns(extFnsList, fns)) {
 			// Extension doesn't match.
 			continue;
 		}
 
 		// Make sure we've read the footer.
 		if (!readFooter) {
+			if (info.szFile > RomDataFactoryPrivate::DETECT_MAX_DECOMP_SIZE) {
+				// szFile may be a lower bound for compressed files.
+				// The actual size is needed to find the footer.
+				info.szFile = file->size();
+				if (info.szFile > (1LL << 30)) {
+					// File is too big.
+					return nullptr;
+				}
+			}
+
 			static const int footer_size = 1024;
 			if (info.szFile > footer_size) {
 				info.header.addr = static_cast<uint32_t>(info.szFile - footer_size);
-				info.header.size = static_cast<uint32_t>(file->seekAndRead(info.header.addr, header.u8, footer_size));
+				const uint8_t *const pBorrowedFooter =
+					static_cast<const uint8_t*>(file->borrow(info.header.addr, footer_size));
+				if (pBorrowedFooter) {
+					info.header.pData = pBorrowedFooter;
+					info.header.size = footer_size;
+				} else {
+					info.header.pData = header.u8;
+					info.header.size = static_cast<uint32_t>(file->seekAndRead(info.header.addr, header.u8, footer_size));
+				}
 				if (info.header.size == 0) {
 					// Seek and/or read error.
+					*pRejected = false;
 					return nullptr;
 				}
 			}
@@ -610,10 +1212,14 @@ RomData *RomDataFactory::create(IRpFile *file, unsigned int attrs)
 			RomData *const romData = fns->newRomData(file);
 			if (romData->isValid()) {
 				// RomData subclass obtained.
+				*ppFns = fns;
 				return romData;
 			}
 
 			// Not actually supported.
+			// This may be due to a transient error, e.g.
+			// a read error past the header.
+			*pRejected = false;
 			romData->unref();
 		}
 	}
@@ -622,6 +1228,42 @@ RomData *RomDataFactory::create(IRpFile *file, unsigned int attrs)
 	return nullptr;
 }
 
+/**
+ * Open a file for use with create().
+ *
+ * Regular files are memory-mapped if possible, which
+ * allows header parsers to borrow the file data without
+ * copying it. Compressed files and files that can't be
+ * mapped are opened using RpFile with transparent
+ * decompression.
+ *
+ * NOTE: The returned IRpFile is never nullptr.
+ * Check isOpen() and lastError() for errors.
+ *
+ * @param filename Filename.
+ * @return IRpFile. (Caller must delete it.)
+ */
+IRpFile *RomDataFactory::openFile(const string &filename)
+{
+#ifdef HAVE_MMAP
+	RpMmapFile *const mmapFile = new RpMmapFile(filename);
+	if (mmapFile->isOpen()) {
+		// Check for compression. If the file is compressed,
+		// RpFile is needed for transparent decompression.
+		const int64_t filesize = mmapFile->size();
+		const size_t magic_size = (filesize < 6 ? static_cast<size_t>(filesize) : 6);
+		const uint8_t *const magic = static_cast<const uint8_t*>(mmapFile->borrow(0, magic_size));
+		if (!magic || IDecompReader::detectFormat(magic, magic_size) < 0) {
+			// Not compressed.
+			return mmapFile;
+		}
+	}
+	delete mmapFile;
+#endif /* HAVE_MMAP */
+
+	return new RpFile(filename, RpFile::FM_OPEN_READ_GZ);
+}
+
 /**
  * Initialize the vector of supported file extensions.
  * Used for Win32 COM registration.
@@ -661,6 +1303,12 @@ void RomDataFactoryPrivate::init_supportedFileExtensions(void)
 				continue;
 
 			for (; *sys_exts != nullptr; sys_exts++) {
+				// Add this class to the extension lookup table.
+				RomDataFnsList &extFnsList = map_extFns[toLower(*sys_exts)];
+				if (std::find(extFnsList.cbegin(), extFnsList.cend(), fns) == extFnsList.cend()) {
+					extFnsList.push_back(fns);
+				}
+
 				auto iter = map_exts.find(*sys_exts);
 				if (iter != map_exts.end()) {
 					// We already had this extension.
@@ -712,7 +1360,8 @@ void RomDataFactoryPrivate::init_supportedMimeTypes(void)
 	// that support the same MIME types, we're using
 	// an unordered_set<string>. The actual data
 	// is stored in the vector<const char*>.
-	unordered_set<string> set_mimeTypes;
+	// NOTE: set_mimeTypes is also used by isMimeTypeSupported(),
+	// so MIME types are stored in lowercase.
 
 	static const size_t reserve_size =
 		(ARRAY_SIZE(RomDataFactoryPrivate::romDataFns_header) +
@@ -732,9 +1381,8 @@ void RomDataFactoryPrivate::init_supportedMimeTypes(void)
 				continue;
 
 			for (; *sys_mimeTypes != nullptr; sys_mimeTypes++) {
-				auto iter = set_mimeTypes.find(*sys_mimeTypes);
-				if (iter == set_mimeTypes.end()) {
-					set_mimeTypes.insert(*sys_mimeTypes);
+				if (set_mimeTypes.insert(toLower(*sys_mimeTypes)).second) {
+					// First time encountering this MIME type.
 					vec_mimeTypes.push_back(*sys_mimeTypes);
 				}
 			}
@@ -754,4 +1402,46 @@ const vector<const char*> &RomDataFactory::supportedMimeTypes(void)
 	return RomDataFactoryPrivate::vec_mimeTypes;
 }
 
+
+/**
+ * Check if a file extension is supported by any RomData subclass.
+ * The check is case-insensitive.
+ * @param ext File extension, including the leading dot.
+ * @param attrs RomDataAttr bitfield. If set, RomData subclass must have the specified attributes.
+ * @return True if the file extension is supported; false if not.
+ */
+bool RomDataFactory::isFileExtensionSupported(const char *ext, unsigned int attrs)
+{
+	if (!ext || ext[0] == '\0')
+		return false;
+
+	const RomDataFactoryPrivate::RomDataFnsList *const fnsList =
+		RomDataFactoryPrivate::extFns(RomDataFactoryPrivate::toLower(ext));
+	if (!fnsList)
+		return false;
+
+	for (auto iter = fnsList->cbegin(); iter != fnsList->cend(); ++iter) {
+		if (((*iter)->attrs & attrs) == attrs) {
+			return true;
+		}
+	}
+	return false;
+}
+
+/**
+ * Check if a MIME type is supported by any RomData subclass.
+ * The check is case-insensitive.
+ * @param mimeType MIME type.
+ * @return True if the MIME type is supported; false if not.
+ */
+bool RomDataFactory::isMimeTypeSupported(const char *mimeType)
+{
+	if (!mimeType || mimeType[0] == '\0')
+		return false;
+
+	pthread_once(&RomDataFactoryPrivate::once_mimeTypes, RomDataFactoryPrivate::init_supportedMimeTypes);
+	const auto &set_mimeTypes = RomDataFactoryPrivate::set_mimeTypes;
+	return (set_mimeTypes.find(RomDataFactoryPrivate::toLower(mimeType)) != set_mimeTypes.end());
+}
+
 }
@@ -24,6 +24,7 @@
 #include "librpbase/common.h"
 
 // C++ includes.
+#include <string>
 #include <vector>
 
 namespace LibRpBase {
@@ -73,6 +74,23 @@ class RomDataFactory
 		 */
 		static LibRpBase::RomData *create(LibRpBase::IRpFile *file, unsigned int attrs = 0);
 
+		/**
+		 * Open a file for use with create().
+		 *
+		 * Regular files are memory-mapped if possible, which
+		 * allows header parsers to borrow the file data without
+		 * copying it. Compressed files and files that can't be
+		 * mapped are opened using RpFile with transparent
+		 * decompression.
+		 *
+		 * NOTE: The returned IRpFile is never nullptr.
+		 * Check isOpen() and lastError() for errors.
+		 *
+		 * @param filename Filename.
+		 * @return IRpFile. (Caller must delete it.)
+		 */
+		static LibRpBase::IRpFile *openFile(const std::string &filename);
+
 		struct ExtInfo {
 			const char *ext;
 			unsigned int attrs;
@@ -102,6 +120,23 @@ class RomDataFactory
 		 * @return All supported MIME types.
 		 */
 		static const std::vector<const char*> &supportedMimeTypes(void);
+
+		/**
+		 * Check if a file extension is supported by any RomData subclass.
+		 * The check is case-insensitive.
+		 * @param ext File extension, including the leading dot.
+		 * @param attrs RomDataAttr bitfield. If set, RomData subclass must have the specified attributes.
+		 * @return True if the file extension is supported; false if not.
+		 */
+		static bool isFileExtensionSupported(const char *ext, unsigned int attrs = 0);
+
+		/**
+		 * Check if a MIME type is supported by any RomData subclass.
+		 * The check is case-insensitive.
+		 * @param mimeType MIME type.
+		 * @return True if the MIME type is supported; false if not.
+		 */
+		static bool isMimeTypeSupported(const char *mimeType);
 };
 
 }
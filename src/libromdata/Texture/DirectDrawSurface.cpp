@@ -42,6 +42,7 @@ using namespace LibRpBase;
 #include <cstring>
 
 // C++ includes.
+#include <algorithm>
 #include <string>
 #include <vector>
 using std::string;
@@ -74,12 +75,42 @@ class DirectDrawSurfacePrivate : public RomDataPrivate
 		// Decoded image.
 		rp_image *img;
 
+		// Reduced-size images, indexed by reduction level.
+		// (Level 0 is the full-size image, which is stored in img.)
+		vector<rp_image*> mipmaps;
+
+		/**
+		 * Get the number of mipmaps, including the full-size image.
+		 * @return Number of mipmaps.
+		 */
+		inline unsigned int mipmapCount(void) const
+		{
+			if (!(ddsHeader.dwCaps & DDSCAPS_MIPMAP) || ddsHeader.dwMipMapCount == 0)
+				return 1;
+			return ddsHeader.dwMipMapCount;
+		}
+
+		/**
+		 * Decode the image.
+		 * @param mipmapLevel	[in] Mipmap level to read. (0 for the full-size image)
+		 * @param reduceLevel	[in] Additional reduction level. (block-compressed formats only)
+		 * @return Image, or nullptr on error. (Caller must delete the image.)
+		 */
+		rp_image *decodeImage(unsigned int mipmapLevel, int reduceLevel);
+
 		/**
 		 * Load the image.
 		 * @return Image, or nullptr on error.
 		 */
 		const rp_image *loadImage(void);
 
+		/**
+		 * Load the image at a reduced size.
+		 * @param size Requested image size.
+		 * @return Image, or nullptr on error.
+		 */
+		const rp_image *loadImage(int size);
+
 	public:
 		// Supported uncompressed RGB formats.
 		struct RGB_Format_Table_t {
@@ -515,18 +546,20 @@ DirectDrawSurfacePrivate::DirectDrawSurfacePrivate(DirectDrawSurface *q, IRpFile
 DirectDrawSurfacePrivate::~DirectDrawSurfacePrivate()
 {
 	delete img;
+	for (auto iter = mipmaps.begin(); iter != mipmaps.end(); ++iter) {
+		delete *iter;
+	}
 }
 
 /**
- * Load the image.
- * @return Image, or nullptr on error.
+ * Decode the image.
+ * @param mipmapLevel	[in] Mipmap level to read. (0 for the full-size image)
+ * @param reduceLevel	[in] Additional reduction level. (block-compressed formats only)
+ * @return Image, or nullptr on error. (Caller must delete the image.)
  */
-const rp_image *DirectDrawSurfacePrivate::loadImage(void)
+rp_image *DirectDrawSurfacePrivate::decodeImage(unsigned int mipmapLevel, int reduceLevel)
 {
-	if (img) {
-		// Image has already been loaded.
-		return img;
-	} else if (!this->file || !this->isValid) {
+	if (!this->file || !this->isValid) {
 		// Can't load the image.
 		return nullptr;
 	}
@@ -558,26 +591,25 @@ const rp_image *DirectDrawSurfacePrivate::loadImage(void)
 	}
 	const uint32_t file_sz = static_cast<uint32_t>(file->size());
 
-	// Seek to the start of the texture data.
-	int ret = file->seek(texDataStartAddr);
-	if (ret != 0) {
-		// Seek error.
-		return nullptr;
-	}
+	// Mipmap dimensions.
+	assert(mipmapLevel < mipmapCount());
+	const unsigned int width = std::max(ddsHeader.dwWidth >> mipmapLevel, 1U);
+	const unsigned int height = std::max(ddsHeader.dwHeight >> mipmapLevel, 1U);
 
 	// TODO: Handle DX10 alpha processing.
 	// Currently, we're assuming straight alpha for formats
 	// that have an alpha channel, except for DXT2 and DXT4,
 	// which use premultiplied alpha.
 
-	// NOTE: Mipmaps are stored *after* the main image.
-	// Hence, no mipmap processing is necessary.
+	// NOTE: Mipmaps are stored *after* the main image,
+	// from largest to smallest.
+	rp_image *img = nullptr;
 	if (dxgi_format != 0) {
 		// Compressed RGB data.
 
 		// NOTE: dwPitchOrLinearSize is not necessarily correct.
-		// Calculate the expected size.
-		uint32_t expected_size;
+		// Determine the block size.
+		unsigned int blockSize;
 		switch (dxgi_format) {
 			case DXGI_FORMAT_BC1_TYPELESS:
 			case DXGI_FORMAT_BC1_UNORM:
@@ -586,7 +618,7 @@ const rp_image *DirectDrawSurfacePrivate::loadImage(void)
 			case DXGI_FORMAT_BC4_UNORM:
 			case DXGI_FORMAT_BC4_SNORM:
 				// 16 pixels compressed into 64 bits. (4bpp)
-				expected_size = (ddsHeader.dwWidth * ddsHeader.dwHeight) / 2;
+				blockSize = 8;
 				break;
 
 			case DXGI_FORMAT_BC2_TYPELESS:
@@ -602,7 +634,7 @@ const rp_image *DirectDrawSurfacePrivate::loadImage(void)
 			case DXGI_FORMAT_BC7_UNORM:
 			case DXGI_FORMAT_BC7_UNORM_SRGB:
 				// 16 pixels compressed into 128 bits. (8bpp)
-				expected_size = ddsHeader.dwWidth * ddsHeader.dwHeight;
+				blockSize = 16;
 				break;
 
 			default:
@@ -610,12 +642,29 @@ const rp_image *DirectDrawSurfacePrivate::loadImage(void)
 				return nullptr;
 		}
 
+		// Calculate the mipmap's address and the expected size.
+		// Partial blocks are rounded up to full blocks, so
+		// each mipmap takes up at least one block.
+		uint32_t mipmapAddr = texDataStartAddr;
+		for (unsigned int i = 0; i < mipmapLevel; i++) {
+			mipmapAddr += std::max(((ddsHeader.dwWidth >> i) + 3) / 4, 1U) *
+				      std::max(((ddsHeader.dwHeight >> i) + 3) / 4, 1U) * blockSize;
+		}
+		const uint32_t expected_size = ((width + 3) / 4) * ((height + 3) / 4) * blockSize;
+
 		// Verify file size.
-		if (expected_size >= file_sz + texDataStartAddr) {
+		if (mipmapAddr + expected_size > file_sz) {
 			// File is too small.
 			return nullptr;
 		}
 
+		// Seek to the start of the texture data.
+		int ret = file->seek(mipmapAddr);
+		if (ret != 0) {
+			// Seek error.
+			return nullptr;
+		}
+
 		// Read the texture data.
 		auto buf = aligned_uptr<uint8_t>(16, expected_size);
 		size_t size = file->read(buf.get(), expected_size);
@@ -625,20 +674,17 @@ const rp_image *DirectDrawSurfacePrivate::loadImage(void)
 		}
 
 		// TODO: Handle typeless, signed, sRGB, float.
+		ImageDecoder::BlockFormat blockFormat;
 		switch (dxgi_format) {
 			case DXGI_FORMAT_BC1_TYPELESS:
 			case DXGI_FORMAT_BC1_UNORM:
 			case DXGI_FORMAT_BC1_UNORM_SRGB:
 				if (likely(dxgi_alpha != DDS_ALPHA_MODE_OPAQUE)) {
 					// 1-bit alpha.
-					img = ImageDecoder::fromDXT1_A1(
-						ddsHeader.dwWidth, ddsHeader.dwHeight,
-						buf.get(), expected_size);
+					blockFormat = ImageDecoder::BLOCK_DXT1_A1;
 				} else {
 					// No alpha channel.
-					img = ImageDecoder::fromDXT1(
-						ddsHeader.dwWidth, ddsHeader.dwHeight,
-						buf.get(), expected_size);
+					blockFormat = ImageDecoder::BLOCK_DXT1;
 				}
 				break;
 
@@ -647,14 +693,10 @@ const rp_image *DirectDrawSurfacePrivate::loadImage(void)
 			case DXGI_FORMAT_BC2_UNORM_SRGB:
 				if (likely(dxgi_alpha != DDS_ALPHA_MODE_PREMULTIPLIED)) {
 					// Standard alpha: DXT3
-					img = ImageDecoder::fromDXT3(
-						ddsHeader.dwWidth, ddsHeader.dwHeight,
-						buf.get(), expected_size);
+					blockFormat = ImageDecoder::BLOCK_DXT3;
 				} else {
 					// Premultiplied alpha: DXT2
-					img = ImageDecoder::fromDXT2(
-						ddsHeader.dwWidth, ddsHeader.dwHeight,
-						buf.get(), expected_size);
+					blockFormat = ImageDecoder::BLOCK_DXT2;
 				}
 				break;
 
@@ -663,45 +705,38 @@ const rp_image *DirectDrawSurfacePrivate::loadImage(void)
 			case DXGI_FORMAT_BC3_UNORM_SRGB:
 				if (likely(dxgi_alpha != DDS_ALPHA_MODE_PREMULTIPLIED)) {
 					// Standard alpha: DXT5
-					img = ImageDecoder::fromDXT5(
-						ddsHeader.dwWidth, ddsHeader.dwHeight,
-						buf.get(), expected_size);
+					blockFormat = ImageDecoder::BLOCK_DXT5;
 				} else {
 					// Premultiplied alpha: DXT4
-					img = ImageDecoder::fromDXT4(
-						ddsHeader.dwWidth, ddsHeader.dwHeight,
-						buf.get(), expected_size);
+					blockFormat = ImageDecoder::BLOCK_DXT4;
 				}
 				break;
 
 			case DXGI_FORMAT_BC4_TYPELESS:
 			case DXGI_FORMAT_BC4_UNORM:
 			case DXGI_FORMAT_BC4_SNORM:
-				img = ImageDecoder::fromBC4(
-					ddsHeader.dwWidth, ddsHeader.dwHeight,
-					buf.get(), expected_size);
+				blockFormat = ImageDecoder::BLOCK_BC4;
 				break;
 
 			case DXGI_FORMAT_BC5_TYPELESS:
 			case DXGI_FORMAT_BC5_UNORM:
 			case DXGI_FORMAT_BC5_SNORM:
-				img = ImageDecoder::fromBC5(
-					ddsHeader.dwWidth, ddsHeader.dwHeight,
-					buf.get(), expected_size);
+				blockFormat = ImageDecoder::BLOCK_BC5;
 				break;
 
 			case DXGI_FORMAT_BC7_TYPELESS:
 			case DXGI_FORMAT_BC7_UNORM:
 			case DXGI_FORMAT_BC7_UNORM_SRGB:
-				img = ImageDecoder::fromBC7(
-					ddsHeader.dwWidth, ddsHeader.dwHeight,
-					buf.get(), expected_size);
+				blockFormat = ImageDecoder::BLOCK_BC7;
 				break;
 
 			default:
 				// Not supported.
-				break;
+				return nullptr;
 		}
+
+		img = ImageDecoder::fromBlocksReduced(blockFormat,
+			width, height, buf.get(), expected_size, reduceLevel);
 	} else {
 		// Uncompressed linear image data.
 		assert(pxf_uncomp != 0);
@@ -713,6 +748,7 @@ const rp_image *DirectDrawSurfacePrivate::loadImage(void)
 
 		// If DDSD_LINEARSIZE is set, the field is linear size,
 		// so it needs to be divided by the image height.
+		// NOTE: This is only valid for the full-size image.
 		unsigned int stride = 0;
 		if (ddsHeader.dwFlags & DDSD_LINEARSIZE) {
 			if (ddsHeader.dwHeight != 0) {
@@ -729,14 +765,32 @@ const rp_image *DirectDrawSurfacePrivate::loadImage(void)
 			// Stride is too large.
 			return nullptr;
 		}
-		const unsigned int expected_size = ddsHeader.dwHeight * stride;
+
+		// Calculate the mipmap's address.
+		uint32_t mipmapAddr = texDataStartAddr;
+		if (mipmapLevel > 0) {
+			mipmapAddr += ddsHeader.dwHeight * stride;
+			for (unsigned int i = 1; i < mipmapLevel; i++) {
+				mipmapAddr += std::max(ddsHeader.dwWidth >> i, 1U) *
+					      std::max(ddsHeader.dwHeight >> i, 1U) * bytespp;
+			}
+			stride = width * bytespp;
+		}
+		const unsigned int expected_size = height * stride;
 
 		// Verify file size.
-		if (expected_size >= file_sz + texDataStartAddr) {
+		if (mipmapAddr + expected_size > file_sz) {
 			// File is too small.
 			return nullptr;
 		}
 
+		// Seek to the start of the texture data.
+		int ret = file->seek(mipmapAddr);
+		if (ret != 0) {
+			// Seek error.
+			return nullptr;
+		}
+
 		// Read the texture data.
 		auto buf = aligned_uptr<uint8_t>(16, expected_size);
 		size_t size = file->read(buf.get(), expected_size);
@@ -750,7 +804,7 @@ const rp_image *DirectDrawSurfacePrivate::loadImage(void)
 				// 8-bit image. (Usually luminance or alpha.)
 				img = ImageDecoder::fromLinear8(
 					(ImageDecoder::PixelFormat)pxf_uncomp,
-					ddsHeader.dwWidth, ddsHeader.dwHeight,
+					width, height,
 					buf.get(), expected_size, stride);
 				break;
 
@@ -758,7 +812,7 @@ const rp_image *DirectDrawSurfacePrivate::loadImage(void)
 				// 16-bit RGB image.
 				img = ImageDecoder::fromLinear16(
 					(ImageDecoder::PixelFormat)pxf_uncomp,
-					ddsHeader.dwWidth, ddsHeader.dwHeight,
+					width, height,
 					reinterpret_cast<const uint16_t*>(buf.get()),
 					expected_size, stride);
 				break;
@@ -767,7 +821,7 @@ const rp_image *DirectDrawSurfacePrivate::loadImage(void)
 				// 24-bit RGB image.
 				img = ImageDecoder::fromLinear24(
 					(ImageDecoder::PixelFormat)pxf_uncomp,
-					ddsHeader.dwWidth, ddsHeader.dwHeight,
+					width, height,
 					buf.get(), expected_size, stride);
 				break;
 
@@ -775,7 +829,7 @@ const rp_image *DirectDrawSurfacePrivate::loadImage(void)
 				// 32-bit RGB image.
 				img = ImageDecoder::fromLinear32(
 					(ImageDecoder::PixelFormat)pxf_uncomp,
-					ddsHeader.dwWidth, ddsHeader.dwHeight,
+					width, height,
 					reinterpret_cast<const uint32_t*>(buf.get()),
 					expected_size, stride);
 				break;
@@ -791,6 +845,57 @@ const rp_image *DirectDrawSurfacePrivate::loadImage(void)
 	return img;
 }
 
+/**
+ * Load the image.
+ * @return Image, or nullptr on error.
+ */
+const rp_image *DirectDrawSurfacePrivate::loadImage(void)
+{
+	if (!img) {
+		img = decodeImage(0, 0);
+	}
+	return img;
+}
+
+/**
+ * Load the image at a reduced size.
+ * @param size Requested image size.
+ * @return Image, or nullptr on error.
+ */
+const rp_image *DirectDrawSurfacePrivate::loadImage(int size)
+{
+	// Use the smallest mipmap that's at least the requested size.
+	// Block-compressed images can be reduced further while decoding.
+	const unsigned int mipmaps_in_file = mipmapCount();
+	const bool isBlock = (dxgi_format != 0);
+	const int level = ImageDecoder::selectReduceLevel(
+		ddsHeader.dwWidth, ddsHeader.dwHeight, size,
+		(isBlock ? 15 : mipmaps_in_file - 1));
+	if (level <= 0) {
+		// Full-size image.
+		return loadImage();
+	} else if (static_cast<unsigned int>(level) < mipmaps.size() && mipmaps[level]) {
+		// Image has already been loaded.
+		return mipmaps[level];
+	}
+
+	// Block-compressed mipmaps must have 4-aligned dimensions.
+	const int mipmapLevel = ImageDecoder::selectMipmapLevel(
+		ddsHeader.dwWidth, ddsHeader.dwHeight, level,
+		mipmaps_in_file - 1, (isBlock ? 4 : 1));
+	rp_image *const mipimg = decodeImage(mipmapLevel, level - mipmapLevel);
+	if (!mipimg) {
+		// Mipmap data may be missing. Use the full-size image.
+		return loadImage();
+	}
+
+	if (mipmaps.size() <= static_cast<unsigned int>(level)) {
+		mipmaps.resize(level + 1);
+	}
+	mipmaps[level] = mipimg;
+	return mipimg;
+}
+
 /** DirectDrawSurface **/
 
 /**
@@ -1356,4 +1461,36 @@ int DirectDrawSurface::loadInternalImage(ImageType imageType, const rp_image **p
 	return (*pImage != nullptr ? 0 : -EIO);
 }
 
+/**
+ * Load an internal image at a reduced size.
+ * Called by RomData::image() if a size is requested.
+ * @param imageType	[in] Image type to load.
+ * @param size		[in] Requested image size, in pixels.
+ * @param pImage	[out] Pointer to const rp_image* to store the image in.
+ * @return 0 on success; negative POSIX error code on error.
+ */
+int DirectDrawSurface::loadInternalImageForSize(ImageType imageType, int size, const rp_image **pImage)
+{
+	ASSERT_loadInternalImage(imageType, pImage);
+
+	RP_D(DirectDrawSurface);
+	if (imageType != IMG_INT_IMAGE) {
+		// Only IMG_INT_IMAGE is supported by DDS.
+		*pImage = nullptr;
+		return -ENOENT;
+	} else if (!d->file) {
+		// File isn't open.
+		*pImage = nullptr;
+		return -EBADF;
+	} else if (!d->isValid) {
+		// DDS texture isn't valid.
+		*pImage = nullptr;
+		return -EIO;
+	}
+
+	// Load the image.
+	*pImage = d->loadImage(size);
+	return (*pImage != nullptr ? 0 : -EIO);
+}
+
 }
@@ -93,18 +93,37 @@ class KhronosKTXPrivate : public RomDataPrivate
 		// Decoded image.
 		rp_image *img;
 
+		// Reduced-size images, indexed by reduction level.
+		// (Level 0 is the full-size image, which is stored in img.)
+		vector<rp_image*> mipmaps;
+
 		// Key/Value data.
 		// NOTE: Stored as vector<vector<string> > instead of
 		// vector<pair<string, string> > for compatibility with
 		// RFT_LISTDATA.
 		vector<vector<string> > kv_data;
 
+		/**
+		 * Decode the image.
+		 * @param mipmapLevel	[in] Mipmap level to read. (0 for the full-size image)
+		 * @param reduceLevel	[in] Additional reduction level. (block-compressed formats only)
+		 * @return Image, or nullptr on error. (Caller must delete the image.)
+		 */
+		rp_image *decodeImage(unsigned int mipmapLevel, int reduceLevel);
+
 		/**
 		 * Load the image.
 		 * @return Image, or nullptr on error.
 		 */
 		const rp_image *loadImage(void);
 
+		/**
+		 * Load the image at a reduced size.
+		 * @param size Requested image size.
+		 * @return Image, or nullptr on error.
+		 */
+		const rp_image *loadImage(int size);
+
 		/**
 		 * Load key/value data.
 		 */
@@ -128,18 +147,20 @@ KhronosKTXPrivate::KhronosKTXPrivate(KhronosKTX *q, IRpFile *file)
 KhronosKTXPrivate::~KhronosKTXPrivate()
 {
 	delete img;
+	for (auto iter = mipmaps.begin(); iter != mipmaps.end(); ++iter) {
+		delete *iter;
+	}
 }
 
 /**
- * Load the image.
- * @return Image, or nullptr on error.
+ * Decode the image.
+ * @param mipmapLevel	[in] Mipmap level to read. (0 for the full-size image)
+ * @param reduceLevel	[in] Additional reduction level. (block-compressed formats only)
+ * @return Image, or nullptr on error. (Caller must delete the image.)
  */
-const rp_image *KhronosKTXPrivate::loadImage(void)
+rp_image *KhronosKTXPrivate::decodeImage(unsigned int mipmapLevel, int reduceLevel)
 {
-	if (img) {
-		// Image has already been loaded.
-		return img;
-	} else if (!this->file || !this->isValid) {
+	if (!this->file || !this->isValid) {
 		// Can't load the image.
 		return nullptr;
 	}
@@ -169,40 +190,79 @@ const rp_image *KhronosKTXPrivate::loadImage(void)
 	}
 	const uint32_t file_sz = static_cast<uint32_t>(file->size());
 
+	// NOTE: Mipmaps are stored *after* the main image,
+	// from largest to smallest. Each mipmap level has
+	// its own image size field, so skip the levels
+	// before the requested level.
+	// Non-array cubemaps have six faces per level, and
+	// the image size field only counts one face.
+	const unsigned int faces = (ktxHeader.numberOfFaces == 6 &&
+		ktxHeader.numberOfArrayElements == 0) ? 6 : 1;
+	uint32_t mipmapAddr = texDataStartAddr;
+	if (mipmapAddr >= file_sz) {
+		// File is too small.
+		return nullptr;
+	}
+	for (unsigned int i = 0; i < mipmapLevel; i++) {
+		uint32_t imageSize;
+		size_t size = file->seekAndRead(mipmapAddr, &imageSize, sizeof(imageSize));
+		if (size != sizeof(imageSize)) {
+			// Unable to read the image size field.
+			return nullptr;
+		}
+		if (isByteswapNeeded) {
+			imageSize = __swab32(imageSize);
+		}
+		if (imageSize >= file_sz) {
+			// Image size is invalid.
+			return nullptr;
+		}
+		// NOTE: Calculated using 64-bit arithmetic so a bogus
+		// image size can't wrap mipmapAddr around.
+		const uint64_t levelSize = sizeof(imageSize) +
+			(static_cast<uint64_t>(ALIGN(4, imageSize)) * faces);
+		if (levelSize >= file_sz - mipmapAddr) {
+			// File is too small.
+			return nullptr;
+		}
+		mipmapAddr += static_cast<uint32_t>(levelSize);
+	}
+
 	// Seek to the start of the texture data.
-	int ret = file->seek(texDataStartAddr);
+	int ret = file->seek(mipmapAddr);
 	if (ret != 0) {
 		// Seek error.
 		return nullptr;
 	}
 
-	// NOTE: Mipmaps are stored *after* the main image.
-	// Hence, no mipmap processing is necessary.
-
 	// Handle a 1D texture as a "width x 1" 2D texture.
 	// NOTE: Handling a 3D texture as a single 2D texture.
-	const int height = (ktxHeader.pixelHeight > 0 ? ktxHeader.pixelHeight : 1);
+	const int width = std::max(ktxHeader.pixelWidth >> mipmapLevel, 1U);
+	const int height = std::max((ktxHeader.pixelHeight > 0 ? ktxHeader.pixelHeight : 1) >> mipmapLevel, 1U);
 
 	// Calculate the expected size.
 	// NOTE: Scanlines are 4-byte aligned.
 	uint32_t expected_size;
 	int stride = 0;
+	unsigned int blockSize = 0;
 	switch (ktxHeader.glFormat) {
 		case GL_RGB:
 			// 24-bit RGB.
-			stride = ALIGN(4, ktxHeader.pixelWidth * 3);
+			stride = ALIGN(4, width * 3);
 			expected_size = static_cast<unsigned int>(stride * height);
 			break;
 
 		case GL_RGBA:
 			// 32-bit RGBA.
-			stride = ktxHeader.pixelWidth * 4;
+			stride = width * 4;
 			expected_size = static_cast<unsigned int>(stride * height);
 			break;
 
 		case GL_LUMINANCE:
 			// 8-bit luminance.
-			stride = ALIGN(4, ktxHeader.pixelWidth);
+			// NOTE: ALIGN() casts to __typeof__(x), so drop the
+			// const qualifier to avoid -Wignored-qualifiers.
+			stride = ALIGN(4, static_cast<int>(width));
 			expected_size = static_cast<unsigned int>(stride * height);
 			break;
 
@@ -227,7 +287,7 @@ const rp_image *KhronosKTXPrivate::loadImage(void)
 				case GL_COMPRESSED_LUMINANCE_LATC1_EXT:
 				case GL_COMPRESSED_SIGNED_LUMINANCE_LATC1_EXT:
 					// 16 pixels compressed into 64 bits. (4bpp)
-					expected_size = (ktxHeader.pixelWidth * height) / 2;
+					blockSize = 8;
 					break;
 
 				//case GL_RGBA_S3TC:	// TODO
@@ -245,18 +305,21 @@ const rp_image *KhronosKTXPrivate::loadImage(void)
 				case GL_COMPRESSED_LUMINANCE_ALPHA_LATC2_EXT:
 				case GL_COMPRESSED_SIGNED_LUMINANCE_ALPHA_LATC2_EXT:
 					// 16 pixels compressed into 128 bits. (8bpp)
-					expected_size = ktxHeader.pixelWidth * height;
+					blockSize = 16;
 					break;
 
 				default:
 					// Not supported.
 					return nullptr;
 			}
+
+			// Each mipmap takes up at least one block.
+			expected_size = std::max(width / 4, 1) * std::max(height / 4, 1) * blockSize;
 			break;
 	}
 
 	// Verify file size.
-	if (texDataStartAddr + expected_size > file_sz) {
+	if (mipmapAddr + expected_size > file_sz) {
 		// File is too small.
 		return nullptr;
 	}
@@ -286,145 +349,130 @@ const rp_image *KhronosKTXPrivate::loadImage(void)
 
 	// TODO: Byteswapping.
 	// TODO: Handle variants. Check for channel sizes in glInternalFormat?
+	rp_image *img = nullptr;
 	switch (ktxHeader.glFormat) {
 		case GL_RGB:
 			// 24-bit RGB.
 			img = ImageDecoder::fromLinear24(ImageDecoder::PXF_BGR888,
-				ktxHeader.pixelWidth, height,
+				width, height,
 				buf.get(), expected_size, stride);
 			break;
 
 		case GL_RGBA:
 			// 32-bit RGBA.
 			img = ImageDecoder::fromLinear32(ImageDecoder::PXF_ABGR8888,
-				ktxHeader.pixelWidth, height,
+				width, height,
 				reinterpret_cast<const uint32_t*>(buf.get()), expected_size, stride);
 			break;
 
 		case GL_LUMINANCE:
 			// 8-bit Luminance.
 			img = ImageDecoder::fromLinear8(ImageDecoder::PXF_L8,
-				ktxHeader.pixelWidth, height,
+				width, height,
 				buf.get(), expected_size, stride);
 			break;
 
 		case 0:
-		default:
+		default: {
 			// May be a compressed format.
 			// TODO: sRGB post-processing for sRGB formats?
+			ImageDecoder::BlockFormat blockFormat;
 			switch (ktxHeader.glInternalFormat) {
 				case GL_RGB_S3TC:
 				case GL_RGB4_S3TC:
 				case GL_COMPRESSED_RGB_S3TC_DXT1_EXT:
 					// DXT1-compressed texture.
-					img = ImageDecoder::fromDXT1(
-						ktxHeader.pixelWidth, height,
-						buf.get(), expected_size);
+					blockFormat = ImageDecoder::BLOCK_DXT1;
 					break;
 
 				case GL_COMPRESSED_RGBA_S3TC_DXT1_EXT:
 					// DXT1-compressed texture with 1-bit alpha.
-					img = ImageDecoder::fromDXT1_A1(
-						ktxHeader.pixelWidth, height,
-						buf.get(), expected_size);
+					blockFormat = ImageDecoder::BLOCK_DXT1_A1;
 					break;
 
 				case GL_COMPRESSED_RGBA_S3TC_DXT3_EXT:
 					// DXT3-compressed texture.
-					img = ImageDecoder::fromDXT3(
-						ktxHeader.pixelWidth, height,
-						buf.get(), expected_size);
+					blockFormat = ImageDecoder::BLOCK_DXT3;
 					break;
 
 				case GL_RGBA_DXT5_S3TC:
 				case GL_RGBA4_DXT5_S3TC:
 				case GL_COMPRESSED_RGBA_S3TC_DXT5_EXT:
 					// DXT5-compressed texture.
-					img = ImageDecoder::fromDXT5(
-						ktxHeader.pixelWidth, height,
-						buf.get(), expected_size);
+					blockFormat = ImageDecoder::BLOCK_DXT5;
 					break;
 
 				case GL_ETC1_RGB8_OES:
 					// ETC1-compressed texture.
-					img = ImageDecoder::fromETC1(
-						ktxHeader.pixelWidth, height,
-						buf.get(), expected_size);
+					blockFormat = ImageDecoder::BLOCK_ETC1;
 					break;
 
 				case GL_COMPRESSED_RGB8_ETC2:
 					// ETC2-compressed RGB texture.
-					img = ImageDecoder::fromETC2_RGB(
-						ktxHeader.pixelWidth, height,
-						buf.get(), expected_size);
+					blockFormat = ImageDecoder::BLOCK_ETC2_RGB;
 					break;
 
 				case GL_COMPRESSED_RGB8_PUNCHTHROUGH_ALPHA1_ETC2:
 					// ETC2-compressed RGB texture
 					// with punchthrough alpha.
-					img = ImageDecoder::fromETC2_RGB_A1(
-						ktxHeader.pixelWidth, height,
-						buf.get(), expected_size);
+					blockFormat = ImageDecoder::BLOCK_ETC2_RGB_A1;
 					break;
 
 				case GL_COMPRESSED_RGBA8_ETC2_EAC:
 					// ETC2-compressed RGB texture
 					// with EAC-compressed alpha channel.
-					img = ImageDecoder::fromETC2_RGBA(
-						ktxHeader.pixelWidth, height,
-						buf.get(), expected_size);
+					blockFormat = ImageDecoder::BLOCK_ETC2_RGBA;
 					break;
 
 				case GL_COMPRESSED_RED_RGTC1:
 				case GL_COMPRESSED_SIGNED_RED_RGTC1:
+				case GL_COMPRESSED_LUMINANCE_LATC1_EXT:
+				case GL_COMPRESSED_SIGNED_LUMINANCE_LATC1_EXT:
 					// RGTC, one component. (BC4)
+					// LATC is converted to luminance below.
 					// TODO: Handle signed properly.
-					img = ImageDecoder::fromBC4(
-						ktxHeader.pixelWidth, height,
-						buf.get(), expected_size);
+					blockFormat = ImageDecoder::BLOCK_BC4;
 					break;
 
 				case GL_COMPRESSED_RG_RGTC2:
 				case GL_COMPRESSED_SIGNED_RG_RGTC2:
+				case GL_COMPRESSED_LUMINANCE_ALPHA_LATC2_EXT:
+				case GL_COMPRESSED_SIGNED_LUMINANCE_ALPHA_LATC2_EXT:
 					// RGTC, two components. (BC5)
+					// LATC is converted to luminance+alpha below.
 					// TODO: Handle signed properly.
-					img = ImageDecoder::fromBC5(
-						ktxHeader.pixelWidth, height,
-						buf.get(), expected_size);
+					blockFormat = ImageDecoder::BLOCK_BC5;
 					break;
 
+				default:
+					// Not supported.
+					return nullptr;
+			}
+
+			img = ImageDecoder::fromBlocksReduced(blockFormat,
+				width, height, buf.get(), expected_size, reduceLevel);
+
+			switch (ktxHeader.glInternalFormat) {
 				case GL_COMPRESSED_LUMINANCE_LATC1_EXT:
 				case GL_COMPRESSED_SIGNED_LUMINANCE_LATC1_EXT:
-					// LATC, one component. (BC4)
-					// TODO: Handle signed properly.
-					img = ImageDecoder::fromBC4(
-						ktxHeader.pixelWidth, height,
-						buf.get(), expected_size);
 					// TODO: If this fails, return it anyway or return nullptr?
 					ImageDecoder::fromRed8ToL8(img);
 					break;
-
 				case GL_COMPRESSED_LUMINANCE_ALPHA_LATC2_EXT:
 				case GL_COMPRESSED_SIGNED_LUMINANCE_ALPHA_LATC2_EXT:
-					// LATC, two components. (BC5)
-					// TODO: Handle signed properly.
-					img = ImageDecoder::fromBC5(
-						ktxHeader.pixelWidth, height,
-						buf.get(), expected_size);
 					// TODO: If this fails, return it anyway or return nullptr?
 					ImageDecoder::fromRG8ToLA8(img);
 					break;
-
 				default:
-					// Not supported.
 					break;
 			}
 			break;
+		}
 	}
 
 	// Post-processing: Check if VFlip is needed.
 	// TODO: Handle HFlip too?
-	if (img && isVFlipNeeded && height > 1) {
+	if (img && isVFlipNeeded && img->height() > 1) {
 		// TODO: Assert that img dimensions match ktxHeader?
 		rp_image *flipimg = img->vflip();
 		if (flipimg) {
@@ -438,6 +486,57 @@ const rp_image *KhronosKTXPrivate::loadImage(void)
 	return img;
 }
 
+/**
+ * Load the image.
+ * @return Image, or nullptr on error.
+ */
+const rp_image *KhronosKTXPrivate::loadImage(void)
+{
+	if (!img) {
+		img = decodeImage(0, 0);
+	}
+	return img;
+}
+
+/**
+ * Load the image at a reduced size.
+ * @param size Requested image size.
+ * @return Image, or nullptr on error.
+ */
+const rp_image *KhronosKTXPrivate::loadImage(int size)
+{
+	// Use the smallest mipmap that's at least the requested size.
+	// Block-compressed images can be reduced further while decoding.
+	const unsigned int mipmaps_in_file = std::max(ktxHeader.numberOfMipmapLevels, 1U);
+	const bool isBlock = (ktxHeader.glFormat == 0);
+	const int level = ImageDecoder::selectReduceLevel(
+		ktxHeader.pixelWidth, ktxHeader.pixelHeight, size,
+		(isBlock ? 15 : mipmaps_in_file - 1));
+	if (level <= 0) {
+		// Full-size image.
+		return loadImage();
+	} else if (static_cast<unsigned int>(level) < mipmaps.size() && mipmaps[level]) {
+		// Image has already been loaded.
+		return mipmaps[level];
+	}
+
+	// Block-compressed mipmaps must have 4-aligned dimensions.
+	const int mipmapLevel = ImageDecoder::selectMipmapLevel(
+		ktxHeader.pixelWidth, ktxHeader.pixelHeight, level,
+		mipmaps_in_file - 1, (isBlock ? 4 : 1));
+	rp_image *const mipimg = decodeImage(mipmapLevel, level - mipmapLevel);
+	if (!mipimg) {
+		// Mipmap data may be missing. Use the full-size image.
+		return loadImage();
+	}
+
+	if (mipmaps.size() <= static_cast<unsigned int>(level)) {
+		mipmaps.resize(level + 1);
+	}
+	mipmaps[level] = mipimg;
+	return mipimg;
+}
+
 /**
  * Load key/value data.
  */
@@ -976,4 +1075,36 @@ int KhronosKTX::loadInternalImage(ImageType imageType, const rp_image **pImage)
 	return (*pImage != nullptr ? 0 : -EIO);
 }
 
+/**
+ * Load an internal image at a reduced size.
+ * Called by RomData::image() if a size is requested.
+ * @param imageType	[in] Image type to load.
+ * @param size		[in] Requested image size, in pixels.
+ * @param pImage	[out] Pointer to const rp_image* to store the image in.
+ * @return 0 on success; negative POSIX error code on error.
+ */
+int KhronosKTX::loadInternalImageForSize(ImageType imageType, int size, const rp_image **pImage)
+{
+	ASSERT_loadInternalImage(imageType, pImage);
+
+	RP_D(KhronosKTX);
+	if (imageType != IMG_INT_IMAGE) {
+		// Only IMG_INT_IMAGE is supported by KTX.
+		*pImage = nullptr;
+		return -ENOENT;
+	} else if (!d->file) {
+		// File isn't open.
+		*pImage = nullptr;
+		return -EBADF;
+	} else if (!d->isValid) {
+		// KTX texture isn't valid.
+		*pImage = nullptr;
+		return -EIO;
+	}
+
+	// Load the image.
+	*pImage = d->loadImage(size);
+	return (*pImage != nullptr ? 0 : -EIO);
+}
+
 }
@@ -99,12 +99,27 @@ class SegaPVRPrivate : public RomDataPrivate
 		// Decoded image.
 		rp_image *img;
 
+		// Reduced-size images, indexed by mipmap level.
+		// (Level 0 is the full-size image, which is stored in img.)
+		vector<rp_image*> mipmaps;
+
 		/**
 		 * Load the PVR image.
 		 * @return Image, or nullptr on error.
 		 */
 		const rp_image *loadPvrImage(void);
 
+		/**
+		 * Load the PVR image at a reduced size.
+		 *
+		 * Only square twiddled textures with mipmaps are supported.
+		 * Other formats will use the full-size image.
+		 *
+		 * @param size Requested image size.
+		 * @return Image, or nullptr on error.
+		 */
+		const rp_image *loadPvrImage(int size);
+
 		/**
 		 * Load the GVR image.
 		 * @return Image, or nullptr on error.
@@ -128,6 +143,9 @@ SegaPVRPrivate::SegaPVRPrivate(SegaPVR *q, IRpFile *file)
 SegaPVRPrivate::~SegaPVRPrivate()
 {
 	delete img;
+	for (auto iter = mipmaps.begin(); iter != mipmaps.end(); ++iter) {
+		delete *iter;
+	}
 }
 
 #if SYS_BYTEORDER == SYS_BIG_ENDIAN
@@ -433,6 +451,106 @@ const rp_image *SegaPVRPrivate::loadPvrImage(void)
 	return img;
 }
 
+/**
+ * Load the PVR image at a reduced size.
+ *
+ * Only square twiddled textures with mipmaps are supported.
+ * Other formats will use the full-size image.
+ *
+ * @param size Requested image size.
+ * @return Image, or nullptr on error.
+ */
+const rp_image *SegaPVRPrivate::loadPvrImage(int size)
+{
+	if (!this->file || this->pvrType != PVR_TYPE_PVR) {
+		// Can't load the image.
+		return nullptr;
+	}
+
+	// Mipmaps are stored before the main image, from smallest to largest.
+	// TODO: VQ mipmaps.
+	uint32_t mipmap_size;
+	switch (pvrHeader.pvr.img_data_type) {
+		case PVR_IMG_SQUARE_TWIDDLED_MIPMAP:
+			// A 1x1 mipmap takes up as much space as a 2x1 mipmap.
+			mipmap_size = 2;
+			break;
+		case PVR_IMG_SQUARE_TWIDDLED_MIPMAP_ALT:
+			// A 1x1 mipmap takes up as much space as a 2x2 mipmap.
+			mipmap_size = 6;
+			break;
+		default:
+			// Mipmaps aren't supported for this format.
+			return loadPvrImage();
+	}
+
+	ImageDecoder::PixelFormat px_format;
+	switch (pvrHeader.pvr.px_format) {
+		case PVR_PX_ARGB1555:
+			px_format = ImageDecoder::PXF_ARGB1555;
+			break;
+		case PVR_PX_RGB565:
+			px_format = ImageDecoder::PXF_RGB565;
+			break;
+		case PVR_PX_ARGB4444:
+			px_format = ImageDecoder::PXF_ARGB4444;
+			break;
+		default:
+			// Unsupported pixel format.
+			return loadPvrImage();
+	}
+
+	if (pvrHeader.width != pvrHeader.height || popcount(pvrHeader.width) != 1) {
+		// Twiddled mipmaps must be square, with power-of-two dimensions.
+		return loadPvrImage();
+	}
+
+	const int level = ImageDecoder::selectReduceLevel(
+		pvrHeader.width, pvrHeader.height, size, uilog2(pvrHeader.width));
+	if (level <= 0) {
+		// Full-size image.
+		return loadPvrImage();
+	} else if (static_cast<unsigned int>(level) < mipmaps.size() && mipmaps[level]) {
+		// Image has already been loaded.
+		return mipmaps[level];
+	}
+
+	// Skip the smaller mipmaps.
+	// Each mipmap uses 16bpp.
+	const unsigned int mip_width = pvrHeader.width >> level;
+	for (unsigned int i = 1; i < mip_width; i <<= 1) {
+		mipmap_size += i * i * 2;
+	}
+	const unsigned int pvrDataStart = gbix_len + sizeof(PVR_Header);
+	const uint32_t expected_size = mip_width * mip_width * 2;
+	if (pvrDataStart + mipmap_size + expected_size > file->size()) {
+		// File is too small.
+		return loadPvrImage();
+	}
+
+	// Read the texture data.
+	auto buf = aligned_uptr<uint8_t>(16, expected_size);
+	size_t sz = file->seekAndRead(pvrDataStart + mipmap_size, buf.get(), expected_size);
+	if (sz != expected_size) {
+		// Read error.
+		return loadPvrImage();
+	}
+
+	rp_image *const mipimg = ImageDecoder::fromDreamcastSquareTwiddled16(px_format,
+		mip_width, mip_width,
+		reinterpret_cast<uint16_t*>(buf.get()), expected_size);
+	if (!mipimg) {
+		// Decode error. Use the full-size image.
+		return loadPvrImage();
+	}
+
+	if (mipmaps.size() <= static_cast<unsigned int>(level)) {
+		mipmaps.resize(level + 1);
+	}
+	mipmaps[level] = mipimg;
+	return mipimg;
+}
+
 /**
  * Load the GVR image.
  * @return Image, or nullptr on error.
@@ -1119,4 +1237,48 @@ int SegaPVR::loadInternalImage(ImageType imageType, const rp_image **pImage)
 	return (*pImage != nullptr ? 0 : -EIO);
 }
 
+/**
+ * Load an internal image at a reduced size.
+ * Called by RomData::image() if a size is requested.
+ * @param imageType	[in] Image type to load.
+ * @param size		[in] Requested image size, in pixels.
+ * @param pImage	[out] Pointer to const rp_image* to store the image in.
+ * @return 0 on success; negative POSIX error code on error.
+ */
+int SegaPVR::loadInternalImageForSize(ImageType imageType, int size, const rp_image **pImage)
+{
+	ASSERT_loadInternalImage(imageType, pImage);
+
+	RP_D(SegaPVR);
+	if (imageType != IMG_INT_IMAGE) {
+		// Only IMG_INT_IMAGE is supported by PVR.
+		*pImage = nullptr;
+		return -ENOENT;
+	} else if (!d->file) {
+		// File isn't open.
+		*pImage = nullptr;
+		return -EBADF;
+	} else if (!d->isValid || d->pvrType < 0) {
+		// PVR image isn't valid.
+		*pImage = nullptr;
+		return -EIO;
+	}
+
+	// Load the image.
+	// TODO: GVR mipmaps.
+	switch (d->pvrType) {
+		case SegaPVRPrivate::PVR_TYPE_PVR:
+			*pImage = d->loadPvrImage(size);
+			break;
+		case SegaPVRPrivate::PVR_TYPE_GVR:
+			*pImage = d->loadGvrImage();
+			break;
+		default:
+			// Not supported yet.
+			*pImage = nullptr;
+			break;
+	}
+	return (*pImage != nullptr ? 0 : -EIO);
+}
+
 }
@@ -48,6 +48,7 @@ using namespace LibRpBase;
 #include <cstring>
 
 // C++ includes.
+#include <algorithm>
 #include <memory>
 #include <string>
 #include <vector>
@@ -80,6 +81,10 @@ class ValveVTFPrivate : public RomDataPrivate
 		// Decoded image.
 		rp_image *img;
 
+		// Reduced-size images, indexed by reduction level.
+		// (Level 0 is the full-size image, which is stored in img.)
+		vector<rp_image*> mipmaps;
+
 		/**
 		 * Calculate an image size.
 		 * @param format VTF image format.
@@ -96,12 +101,27 @@ class ValveVTFPrivate : public RomDataPrivate
 		 */
 		static unsigned int getMinBlockSize(VTF_IMAGE_FORMAT format);
 
+		/**
+		 * Decode the image.
+		 * @param mipmapLevel	[in] Mipmap level to read. (0 for the full-size image)
+		 * @param reduceLevel	[in] Additional reduction level. (block-compressed formats only)
+		 * @return Image, or nullptr on error. (Caller must delete the image.)
+		 */
+		rp_image *decodeImage(unsigned int mipmapLevel, int reduceLevel);
+
 		/**
 		 * Load the image.
 		 * @return Image, or nullptr on error.
 		 */
 		const rp_image *loadImage(void);
 
+		/**
+		 * Load the image at a reduced size.
+		 * @param size Requested image size.
+		 * @return Image, or nullptr on error.
+		 */
+		const rp_image *loadImage(int size);
+
 #if SYS_BYTEORDER == SYS_BIG_ENDIAN
 		/**
 		 * Byteswap a float. (TODO: Move to byteswap.h?)
@@ -135,6 +155,9 @@ ValveVTFPrivate::ValveVTFPrivate(ValveVTF *q, IRpFile *file)
 ValveVTFPrivate::~ValveVTFPrivate()
 {
 	delete img;
+	for (auto iter = mipmaps.begin(); iter != mipmaps.end(); ++iter) {
+		delete *iter;
+	}
 }
 
 /**
@@ -288,17 +311,16 @@ unsigned int ValveVTFPrivate::getMinBlockSize(VTF_IMAGE_FORMAT format)
 }
 
 /**
- * Load the image.
- * @return Image, or nullptr on error.
+ * Decode the image.
+ * @param mipmapLevel	[in] Mipmap level to read. (0 for the full-size image)
+ * @param reduceLevel	[in] Additional reduction level. (block-compressed formats only)
+ * @return Image, or nullptr on error. (Caller must delete the image.)
  */
-const rp_image *ValveVTFPrivate::loadImage(void)
+rp_image *ValveVTFPrivate::decodeImage(unsigned int mipmapLevel, int reduceLevel)
 {
 	// TODO: Option to load the low-res image instead?
 
-	if (img) {
-		// Image has already been loaded.
-		return img;
-	} else if (!this->file || !this->isValid) {
+	if (!this->file || !this->isValid) {
 		// Can't load the image.
 		return nullptr;
 	}
@@ -323,38 +345,53 @@ const rp_image *ValveVTFPrivate::loadImage(void)
 
 	// Handle a 1D texture as a "width x 1" 2D texture.
 	// NOTE: Handling a 3D texture as a single 2D texture.
-	const int height = (vtfHeader.height > 0 ? vtfHeader.height : 1);
+	const int full_height = (vtfHeader.height > 0 ? vtfHeader.height : 1);
 
 	// NOTE: VTF specifications say the image size must be a power of two.
 	// Some malformed images may have a smaller width in the header,
 	// so calculate the row width here.
-	int row_width = vtfHeader.width;
-	if (popcount(row_width) != 1) {
+	int full_row_width = vtfHeader.width;
+	if (popcount(full_row_width) != 1) {
 		// Adjust to the next power of two.
 		// We need to calculate the actual stride in order to
 		// prevent crashes in the SSE2 code.
-		row_width = 1 << (uilog2(row_width) + 1);
+		full_row_width = 1 << (uilog2(full_row_width) + 1);
 	}
 
-	// Calculate the expected size.
-	unsigned int expected_size = calcImageSize(
+	// Calculate the full-size image's expected size.
+	const unsigned int full_expected_size = calcImageSize(
 		static_cast<VTF_IMAGE_FORMAT>(vtfHeader.highResImageFormat),
-		row_width, height);
-	if (expected_size == 0) {
+		full_row_width, full_height);
+	if (full_expected_size == 0) {
 		// Invalid image size.
 		return nullptr;
 	}
 
+	// Mipmap dimensions.
+	assert(mipmapLevel < std::max<unsigned int>(vtfHeader.mipmapCount, 1));
+	const int width = std::max(vtfHeader.width >> mipmapLevel, 1);
+	const int height = std::max(full_height >> mipmapLevel, 1);
+	const int row_width = std::max(full_row_width >> mipmapLevel, 1);
+	const unsigned int expected_size = (mipmapLevel == 0 ? full_expected_size :
+		calcImageSize(static_cast<VTF_IMAGE_FORMAT>(vtfHeader.highResImageFormat),
+			row_width, height));
+
 	// TODO: Handle environment maps (6-faced cube map) and volumetric textures.
 
-	// Adjust for the number of mipmaps.
+	// Skip the mipmaps that are smaller than the requested level.
+	// NOTE: Mipmaps are stored from smallest to largest,
+	// and the full-size image is stored last.
 	// NOTE: Dimensions must be powers of two.
 	unsigned int texDataStartAddr_adj = texDataStartAddr;
-	unsigned int mipmap_size = expected_size;
+	unsigned int mipmap_size = full_expected_size;
 	const unsigned int minBlockSize = getMinBlockSize(
 		static_cast<VTF_IMAGE_FORMAT>(vtfHeader.highResImageFormat));
-	for (unsigned int mipmapLevel = vtfHeader.mipmapCount; mipmapLevel > 1; mipmapLevel--) {
+	for (unsigned int i = 1; i < vtfHeader.mipmapCount; i++) {
 		mipmap_size /= 4;
+		if (i <= mipmapLevel) {
+			// This mipmap is stored after the requested level.
+			continue;
+		}
 		if (mipmap_size >= minBlockSize) {
 			texDataStartAddr_adj += mipmap_size;
 		} else {
@@ -403,19 +440,21 @@ const rp_image *ValveVTFPrivate::loadImage(void)
 	// (The channels appear to be backwards.)
 	// TODO: Lookup table to convert to PXF constants?
 	// TODO: Verify on big-endian?
+	rp_image *img = nullptr;
+	ImageDecoder::BlockFormat blockFormat = ImageDecoder::BLOCK_MAX;
 	switch (vtfHeader.highResImageFormat) {
 		/* 32-bit */
 		case VTF_IMAGE_FORMAT_RGBA8888:
 		case VTF_IMAGE_FORMAT_UVWQ8888:	// handling as RGBA8888
 		case VTF_IMAGE_FORMAT_UVLX8888:	// handling as RGBA8888
 			img = ImageDecoder::fromLinear32(ImageDecoder::PXF_ABGR8888,
-				vtfHeader.width, height,
+				width, height,
 				reinterpret_cast<const uint32_t*>(buf.get()), expected_size,
 				row_width * sizeof(uint32_t));
 			break;
 		case VTF_IMAGE_FORMAT_ABGR8888:
 			img = ImageDecoder::fromLinear32(ImageDecoder::PXF_RGBA8888,
-				vtfHeader.width, height,
+				width, height,
 				reinterpret_cast<const uint32_t*>(buf.get()), expected_size,
 				row_width * sizeof(uint32_t));
 			break;
@@ -423,19 +462,19 @@ const rp_image *ValveVTFPrivate::loadImage(void)
 			// This is stored as RAGB for some reason...
 			// FIXME: May be a bug in VTFEdit. (Tested versions: 1.2.5, 1.3.3)
 			img = ImageDecoder::fromLinear32(ImageDecoder::PXF_RABG8888,
-				vtfHeader.width, height,
+				width, height,
 				reinterpret_cast<const uint32_t*>(buf.get()), expected_size,
 				row_width * sizeof(uint32_t));
 			break;
 		case VTF_IMAGE_FORMAT_BGRA8888:
 			img = ImageDecoder::fromLinear32(ImageDecoder::PXF_ARGB8888,
-				vtfHeader.width, height,
+				width, height,
 				reinterpret_cast<const uint32_t*>(buf.get()), expected_size,
 				row_width * sizeof(uint32_t));
 			break;
 		case VTF_IMAGE_FORMAT_BGRx8888:
 			img = ImageDecoder::fromLinear32(ImageDecoder::PXF_xRGB8888,
-				vtfHeader.width, height,
+				width, height,
 				reinterpret_cast<const uint32_t*>(buf.get()), expected_size,
 				row_width * sizeof(uint32_t));
 			break;
@@ -443,26 +482,26 @@ const rp_image *ValveVTFPrivate::loadImage(void)
 		/* 24-bit */
 		case VTF_IMAGE_FORMAT_RGB888:
 			img = ImageDecoder::fromLinear24(ImageDecoder::PXF_BGR888,
-				vtfHeader.width, height,
+				width, height,
 				buf.get(), expected_size,
 				row_width * 3);
 			break;
 		case VTF_IMAGE_FORMAT_BGR888:
 			img = ImageDecoder::fromLinear24(ImageDecoder::PXF_RGB888,
-				vtfHeader.width, height,
+				width, height,
 				buf.get(), expected_size,
 				row_width * 3);
 			break;
 		case VTF_IMAGE_FORMAT_RGB888_BLUESCREEN:
 			img = ImageDecoder::fromLinear24(ImageDecoder::PXF_BGR888,
-				vtfHeader.width, height,
+				width, height,
 				buf.get(), expected_size,
 				row_width * 3);
 			img->apply_chroma_key(0xFF0000FF);
 			break;
 		case VTF_IMAGE_FORMAT_BGR888_BLUESCREEN:
 			img = ImageDecoder::fromLinear24(ImageDecoder::PXF_RGB888,
-				vtfHeader.width, height,
+				width, height,
 				buf.get(), expected_size,
 				row_width * 3);
 			img->apply_chroma_key(0xFF0000FF);
@@ -471,31 +510,31 @@ const rp_image *ValveVTFPrivate::loadImage(void)
 		/* 16-bit */
 		case VTF_IMAGE_FORMAT_RGB565:
 			img = ImageDecoder::fromLinear16(ImageDecoder::PXF_BGR565,
-				vtfHeader.width, height,
+				width, height,
 				reinterpret_cast<const uint16_t*>(buf.get()), expected_size,
 				row_width * sizeof(uint16_t));
 			break;
 		case VTF_IMAGE_FORMAT_BGR565:
 			img = ImageDecoder::fromLinear16(ImageDecoder::PXF_RGB565,
-				vtfHeader.width, height,
+				width, height,
 				reinterpret_cast<const uint16_t*>(buf.get()), expected_size,
 				row_width * sizeof(uint16_t));
 			break;
 		case VTF_IMAGE_FORMAT_BGRx5551:
 			img = ImageDecoder::fromLinear16(ImageDecoder::PXF_RGB555,
-				vtfHeader.width, height,
+				width, height,
 				reinterpret_cast<const uint16_t*>(buf.get()), expected_size,
 				row_width * sizeof(uint16_t));
 			break;
 		case VTF_IMAGE_FORMAT_BGRA4444:
 			img = ImageDecoder::fromLinear16(ImageDecoder::PXF_ARGB4444,
-				vtfHeader.width, height,
+				width, height,
 				reinterpret_cast<const uint16_t*>(buf.get()), expected_size,
 				row_width * sizeof(uint16_t));
 			break;
 		case VTF_IMAGE_FORMAT_BGRA5551:
 			img = ImageDecoder::fromLinear16(ImageDecoder::PXF_ARGB1555,
-				vtfHeader.width, height,
+				width, height,
 				reinterpret_cast<const uint16_t*>(buf.get()), expected_size,
 				row_width * sizeof(uint16_t));
 			break;
@@ -507,14 +546,14 @@ const rp_image *ValveVTFPrivate::loadImage(void)
 			// (Channels are backwards.)
 			// TODO: Add ImageDecoder::fromLinear16() support for IA8 later.
 			img = ImageDecoder::fromLinear16(ImageDecoder::PXF_A8L8,
-				vtfHeader.width, height,
+				width, height,
 				reinterpret_cast<const uint16_t*>(buf.get()), expected_size,
 				row_width * sizeof(uint16_t));
 			break;
 		case VTF_IMAGE_FORMAT_UV88:
 			// We're handling this as a GR88 texture.
 			img = ImageDecoder::fromLinear16(ImageDecoder::PXF_GR88,
-				vtfHeader.width, height,
+				width, height,
 				reinterpret_cast<const uint16_t*>(buf.get()), expected_size,
 				row_width * sizeof(uint16_t));
 			break;
@@ -525,37 +564,29 @@ const rp_image *ValveVTFPrivate::loadImage(void)
 			// whereas L8 has A=1.0.
 			// https://www.opengl.org/discussion_boards/showthread.php/151701-GL_LUMINANCE-vs-GL_INTENSITY
 			img = ImageDecoder::fromLinear8(ImageDecoder::PXF_L8,
-				vtfHeader.width, height,
+				width, height,
 				buf.get(), expected_size,
 				row_width);
 			break;
 		case VTF_IMAGE_FORMAT_A8:
 			img = ImageDecoder::fromLinear8(ImageDecoder::PXF_A8,
-				vtfHeader.width, height,
+				width, height,
 				buf.get(), expected_size,
 				row_width);
 			break;
 
 		/* Compressed */
 		case VTF_IMAGE_FORMAT_DXT1:
-			img = ImageDecoder::fromDXT1(
-				vtfHeader.width, height,
-				buf.get(), expected_size);
+			blockFormat = ImageDecoder::BLOCK_DXT1;
 			break;
 		case VTF_IMAGE_FORMAT_DXT1_ONEBITALPHA:
-			img = ImageDecoder::fromDXT1_A1(
-				vtfHeader.width, height,
-				buf.get(), expected_size);
+			blockFormat = ImageDecoder::BLOCK_DXT1_A1;
 			break;
 		case VTF_IMAGE_FORMAT_DXT3:
-			img = ImageDecoder::fromDXT3(
-				vtfHeader.width, height,
-				buf.get(), expected_size);
+			blockFormat = ImageDecoder::BLOCK_DXT3;
 			break;
 		case VTF_IMAGE_FORMAT_DXT5:
-			img = ImageDecoder::fromDXT5(
-				vtfHeader.width, height,
-				buf.get(), expected_size);
+			blockFormat = ImageDecoder::BLOCK_DXT5;
 			break;
 
 		case VTF_IMAGE_FORMAT_P8:
@@ -566,9 +597,77 @@ const rp_image *ValveVTFPrivate::loadImage(void)
 			break;
 	}
 
+	if (blockFormat != ImageDecoder::BLOCK_MAX) {
+		// Block-compressed image.
+		img = ImageDecoder::fromBlocksReduced(blockFormat,
+			width, height, buf.get(), expected_size, reduceLevel);
+	}
+
+	return img;
+}
+
+/**
+ * Load the image.
+ * @return Image, or nullptr on error.
+ */
+const rp_image *ValveVTFPrivate::loadImage(void)
+{
+	if (!img) {
+		img = decodeImage(0, 0);
+	}
 	return img;
 }
 
+/**
+ * Load the image at a reduced size.
+ * @param size Requested image size.
+ * @return Image, or nullptr on error.
+ */
+const rp_image *ValveVTFPrivate::loadImage(int size)
+{
+	// Use the smallest mipmap that's at least the requested size.
+	// Block-compressed images can be reduced further while decoding.
+	const unsigned int mipmaps_in_file = std::max<unsigned int>(vtfHeader.mipmapCount, 1);
+	bool isBlock;
+	switch (vtfHeader.highResImageFormat) {
+		case VTF_IMAGE_FORMAT_DXT1:
+		case VTF_IMAGE_FORMAT_DXT1_ONEBITALPHA:
+		case VTF_IMAGE_FORMAT_DXT3:
+		case VTF_IMAGE_FORMAT_DXT5:
+			isBlock = true;
+			break;
+		default:
+			isBlock = false;
+			break;
+	}
+	const int level = ImageDecoder::selectReduceLevel(
+		vtfHeader.width, vtfHeader.height, size,
+		(isBlock ? 15 : mipmaps_in_file - 1));
+	if (level <= 0) {
+		// Full-size image.
+		return loadImage();
+	} else if (static_cast<unsigned int>(level) < mipmaps.size() && mipmaps[level]) {
+		// Image has already been loaded.
+		return mipmaps[level];
+	}
+
+	// Block-compressed mipmaps must have 4-aligned dimensions.
+	const int mipmapLevel = ImageDecoder::selectMipmapLevel(
+		vtfHeader.width, vtfHeader.height, level,
+		mipmaps_in_file - 1, (isBlock ? 4 : 1));
+	rp_image *const mipimg = decodeImage(mipmapLevel, level - mipmapLevel);
+	if (!mipimg) {
+		// Mipmap data may be missing. Use the full-size image.
+		return loadImage();
+	}
+
+	if (mipmaps.size() <= static_cast<unsigned int>(level)) {
+		mipmaps.resize(level + 1);
+	}
+	mipmaps[level] = mipimg;
+	return mipimg;
+}
+
 /** ValveVTF **/
 
 /**
@@ -1077,4 +1176,36 @@ int ValveVTF::loadInternalImage(ImageType imageType, const rp_image **pImage)
 	return (*pImage != nullptr ? 0 : -EIO);
 }
 
+/**
+ * Load an internal image at a reduced size.
+ * Called by RomData::image() if a size is requested.
+ * @param imageType	[in] Image type to load.
+ * @param size		[in] Requested image size, in pixels.
+ * @param pImage	[out] Pointer to const rp_image* to store the image in.
+ * @return 0 on success; negative POSIX error code on error.
+ */
+int ValveVTF::loadInternalImageForSize(ImageType imageType, int size, const rp_image **pImage)
+{
+	ASSERT_loadInternalImage(imageType, pImage);
+
+	RP_D(ValveVTF);
+	if (imageType != IMG_INT_IMAGE) {
+		// Only IMG_INT_IMAGE is supported by DDS.
+		*pImage = nullptr;
+		return -ENOENT;
+	} else if (!d->file) {
+		// File isn't open.
+		*pImage = nullptr;
+		return -EBADF;
+	} else if (!d->isValid) {
+		// DDS texture isn't valid.
+		*pImage = nullptr;
+		return -EIO;
+	}
+
+	// Load the image.
+	*pImage = d->loadImage(size);
+	return (*pImage != nullptr ? 0 : -EIO);
+}
+
 }
@@ -22,10 +22,6 @@
 #include "N3DSVerifyKeys.hpp"
 
 // librpbase
-#include "librpbase/crypto/IAesCipher.hpp"
-#include "librpbase/crypto/AesCipherFactory.hpp"
-using LibRpBase::IAesCipher;
-using LibRpBase::AesCipherFactory;
 using LibRpBase::KeyManager;
 
 // libromdata
@@ -35,10 +31,6 @@ using LibRpBase::KeyManager;
 #include <cassert>
 #include <cstring>
 
-// C++ includes.
-#include <memory>
-using std::unique_ptr;
-
 namespace LibRomData {
 
 /**
@@ -151,38 +143,9 @@ KeyManager::VerifyResult N3DSVerifyKeys::loadKeyNormal(u128_t *pKeyOut,
 
 	if (keyNormal_verify) {
 		// Verify the generated Normal key.
-		// TODO: Make this a function in KeyManager, and share it
-		// with KeyManager::getAndVerify().
-		unique_ptr<IAesCipher> cipher(AesCipherFactory::create());
-		if (!cipher) {
-			// Unable to create the IAesCipher.
-			return KeyManager::VERFIY_IAESCIPHER_INIT_ERR;
-		}
-		// Set cipher parameters.
-		ret = cipher->setChainingMode(IAesCipher::CM_ECB);
-		if (ret != 0) {
-			return KeyManager::VERFIY_IAESCIPHER_INIT_ERR;
-		}
-		ret = cipher->setKey(pKeyOut->u8, sizeof(*pKeyOut));
-		if (ret != 0) {
-			return KeyManager::VERFIY_IAESCIPHER_INIT_ERR;
-		}
-
-		// Decrypt the test data.
-		// NOTE: IAesCipher decrypts in place, so we need to
-		// make a temporary copy.
-		unique_ptr<uint8_t[]> tmpData(new uint8_t[16]);
-		memcpy(tmpData.get(), keyNormal_verify, 16);
-		size_t size = cipher->decrypt(tmpData.get(), 16);
-		if (size != 16) {
-			// Decryption failed.
-			return KeyManager::VERIFY_IAESCIPHER_DECRYPT_ERR;
-		}
-
-		// Verify the test data.
-		if (memcmp(tmpData.get(), KeyManager::verifyTestString, 16) != 0) {
-			// Verification failed.
-			return KeyManager::VERIFY_WRONG_KEY;
+		res = keyManager->verifyKey(pKeyOut->u8, sizeof(*pKeyOut), keyNormal_verify, 16);
+		if (res != KeyManager::VERIFY_OK) {
+			return res;
 		}
 	}
 
@@ -25,7 +25,6 @@
 #include "librpbase/file/IRpFile.hpp"
 #include "librpbase/disc/CBCReader.hpp"
 #ifdef ENABLE_DECRYPTION
-# include "librpbase/crypto/AesCipherFactory.hpp"
 # include "librpbase/crypto/IAesCipher.hpp"
 # include "librpbase/crypto/KeyManager.hpp"
 # include "../crypto/N3DSVerifyKeys.hpp"
@@ -144,30 +143,36 @@ CIAReaderPrivate::CIAReaderPrivate(CIAReader *q, IRpFile *file,
 		keyNormal_name, keyX_name, keyY_name,
 		keyNormal_verify, keyX_verify, keyY_verify);
 	if (res == KeyManager::VERIFY_OK) {
-		// Create a cipher to decrypt the title key.
-		IAesCipher *cipher = AesCipherFactory::create();
+		// Get a cipher to decrypt the title key.
+		// NOTE: KeyManager caches the cipher, since the
+		// same common key is used for most CIAs.
+		KeyManager *const keyManager = KeyManager::instance();
+		IAesCipher *const cipher = keyManager->getCipher(keyNormal.u8, sizeof(keyNormal.u8));
+		if (!cipher) {
+			// Unable to create the cipher.
+			// TODO: Set an error.
+			this->file = nullptr;
+			return;
+		}
 
 		// Initialize parameters for title key decryption.
-		// TODO: Error checking.
 		// Parameters:
 		// - Keyslot: 0x3D
 		// - Chaining mode: CBC
 		// - IV: Title ID (little-endian)
-		cipher->setChainingMode(IAesCipher::CM_CBC);
-		cipher->setKey(keyNormal.u8, sizeof(keyNormal.u8));
 		// CIA IV is the title ID in big-endian.
 		// The ticket title ID is already in big-endian,
 		// so copy it over directly.
 		u128_t cia_iv;
 		memcpy(cia_iv.u8, &ticket->title_id.id, sizeof(ticket->title_id.id));
 		memset(&cia_iv.u8[8], 0, 8);
-		cipher->setIV(cia_iv.u8, sizeof(cia_iv.u8));
 
 		// Decrypt the title key.
 		uint8_t title_key[16];
 		memcpy(title_key, ticket->title_key, sizeof(title_key));
-		cipher->decrypt(title_key, sizeof(title_key));
-		delete cipher;
+		cipher->setChainingMode(IAesCipher::CM_CBC);
+		cipher->decrypt(title_key, sizeof(title_key), cia_iv.u8, sizeof(cia_iv.u8));
+		keyManager->releaseCipher(cipher);
 
 		// Data area: IV is the TMD content index.
 		cia_iv.u8[0] = tmd_content_index >> 8;
@@ -148,6 +148,20 @@ int64_t GcnPartition::tell(void)
 	return ret;
 }
 
+/**
+ * Hint that data will be read soon.
+ * @param pos	[in] Starting address.
+ * @param size	[in] Amount of data, in bytes.
+ */
+void GcnPartition::prefetch(int64_t pos, size_t size)
+{
+	RP_D(GcnPartition);
+	if (!d->discReader || pos < 0) {
+		return;
+	}
+	d->discReader->prefetch(d->data_offset + pos, size);
+}
+
 /**
  * Get the data size.
  * This size does not include the partition header,
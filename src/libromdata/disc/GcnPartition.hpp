@@ -97,6 +97,13 @@ class GcnPartition : public LibRpBase::IPartition
 		 */
 		int64_t size(void) final;
 
+		/**
+		 * Hint that data will be read soon.
+		 * @param pos	[in] Starting address.
+		 * @param size	[in] Amount of data, in bytes.
+		 */
+		void prefetch(int64_t pos, size_t size) override;
+
 		/** IPartition **/
 
 		/**
@@ -126,6 +126,13 @@ int GcnPartitionPrivate::loadBootBlockAndInfo(void)
 
 	// bootBlock and bootInfo have been loaded.
 	bootLoaded = true;
+
+	// The FST is usually loaded soon afterwards.
+	// NOTE: Same sanity check as loadFst().
+	if (bootBlock.fst_size > 0 && bootBlock.fst_size <= (1048576U >> offsetShift)) {
+		q->prefetch(static_cast<int64_t>(bootBlock.fst_offset) << offsetShift,
+			static_cast<size_t>(bootBlock.fst_size) << offsetShift);
+	}
 	return 0;
 }
 
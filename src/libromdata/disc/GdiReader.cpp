@@ -28,6 +28,7 @@
 #include "librpbase/TextFuncs.hpp"
 #include "librpbase/file/IRpFile.hpp"
 #include "librpbase/file/RelatedFile.hpp"
+#include "librpbase/threads/Mutex.hpp"
 using namespace LibRpBase;
 
 // C includes.
@@ -41,6 +42,7 @@ using namespace LibRpBase;
 #include <cstring>
 
 // C++ includes.
+#include <algorithm>
 #include <memory>
 #include <string>
 #include <vector>
@@ -69,6 +71,7 @@ class GdiReaderPrivate : public SparseDiscReaderPrivate {
 
 		// Block range mapping.
 		// NOTE: This currently *only* contains data tracks.
+		// Sorted by starting LBA once the GDI file is parsed.
 		struct BlockRange {
 			unsigned int blockStart;	// First LBA.
 			unsigned int blockEnd;		// Last LBA. (inclusive) (0 if the file hasn't been opened yet)
@@ -87,6 +90,13 @@ class GdiReaderPrivate : public SparseDiscReaderPrivate {
 		// Value = pointer to BlockRange in blockRanges.
 		vector<BlockRange*> trackMappings;
 
+		// Mutex for lazily opening tracks in readBlock().
+		Mutex trackMutex;
+
+		// Last block range found by findBlockRange().
+		// Sequential reads usually hit the same track.
+		const BlockRange *lastHit;
+
 		/**
 		 * Close all opened files.
 		 */
@@ -106,6 +116,15 @@ class GdiReaderPrivate : public SparseDiscReaderPrivate {
 		 * @return 0 on success; negative POSIX error code on error.
 		 */
 		int openTrack(int trackNumber);
+
+		/**
+		 * Find the block range containing the specified block.
+		 * The track is opened if it isn't open already.
+		 * NOTE: trackMutex must be locked by the caller.
+		 * @param blockIdx Block index.
+		 * @return Block range, or nullptr if not found.
+		 */
+		const BlockRange *findBlockRange(uint32_t blockIdx);
 };
 
 /** GdiReaderPrivate **/
@@ -113,6 +132,7 @@ class GdiReaderPrivate : public SparseDiscReaderPrivate {
 GdiReaderPrivate::GdiReaderPrivate(GdiReader *q, IRpFile *file)
 	: super(q, file)
 	, blockCount(0)
+	, lastHit(nullptr)
 {
 	if (!this->file) {
 		// File could not be dup()'d.
@@ -223,6 +243,7 @@ void GdiReaderPrivate::close(void)
 	}
 	blockRanges.clear();
 	trackMappings.clear();
+	lastHit = nullptr;
 
 	// GDI file.
 	delete this->file;
@@ -336,8 +357,18 @@ int GdiReaderPrivate::parseGdiFile(char *gdibuf)
 		trackMappings[trackNumber-1] = &blockRange;
 	}
 
+	// Sort the block ranges by LBA so findBlockRange()
+	// can use a binary search, then update the track
+	// mappings, since sorting moved the block ranges.
+	std::sort(blockRanges.begin(), blockRanges.end(),
+		[](const BlockRange &a, const BlockRange &b) {
+			return (a.blockStart < b.blockStart);
+		});
+	for (auto iter = blockRanges.begin(); iter != blockRanges.end(); ++iter) {
+		trackMappings[iter->trackNumber-1] = &(*iter);
+	}
+
 	// Done parsing the GDI.
-	// TODO: Sort by LBA?
 	return 0;
 }
 
@@ -414,6 +445,55 @@ int GdiReaderPrivate::openTrack(int trackNumber)
 	return 0;
 }
 
+/**
+ * Find the block range containing the specified block.
+ * The track is opened if it isn't open already.
+ * NOTE: trackMutex must be locked by the caller.
+ * @param blockIdx Block index.
+ * @return Block range, or nullptr if not found.
+ */
+const GdiReaderPrivate::BlockRange *GdiReaderPrivate::findBlockRange(uint32_t blockIdx)
+{
+	// Check the last block range first.
+	if (lastHit &&
+	    blockIdx >= lastHit->blockStart &&
+	    blockIdx <= lastHit->blockEnd)
+	{
+		return lastHit;
+	}
+
+	// Find the last block range that starts at or before blockIdx.
+	auto iter = std::upper_bound(blockRanges.begin(), blockRanges.end(), blockIdx,
+		[](uint32_t blockIdx, const BlockRange &br) {
+			return (blockIdx < br.blockStart);
+		});
+	if (iter == blockRanges.begin()) {
+		// blockIdx is before the first track.
+		return nullptr;
+	}
+	--iter;
+
+	// Is the track loaded?
+	if (iter->blockEnd == 0) {
+		// Track isn't loaded. Load it.
+		int ret = openTrack(iter->trackNumber);
+		if (ret != 0) {
+			// Unable to load the track.
+			return nullptr;
+		}
+	}
+
+	// Check the end block.
+	// If blockIdx is past the end of this track,
+	// it's in a gap between tracks. (e.g. audio tracks)
+	if (blockIdx > iter->blockEnd) {
+		return nullptr;
+	}
+
+	lastHit = &(*iter);
+	return lastHit;
+}
+
 /** GdiReader **/
 
 GdiReader::GdiReader(IRpFile *file)
@@ -526,33 +606,12 @@ int GdiReader::readBlock(uint32_t blockIdx, void *ptr, int pos, size_t size)
 	}
 
 	// Find the block.
-	// TODO: Cache this lookup somewhere or something.
-	const GdiReaderPrivate::BlockRange *blockRange = nullptr;
-	for (auto iter = d->blockRanges.cbegin(); iter != d->blockRanges.cend(); ++iter) {
-		// NOTE: Using volatile because it can change in d->openTrack().
-		const volatile GdiReaderPrivate::BlockRange *const vbr = &(*iter);
-		if (blockIdx < vbr->blockStart) {
-			// Not in this track.
-			continue;
-		}
-
-		// Is the track loaded?
-		if (vbr->blockEnd == 0) {
-			// Track isn't loaded. Load it.
-			int ret = d->openTrack(vbr->trackNumber);
-			if (ret != 0) {
-				// Unable to load the track.
-				// Skip for now.
-				continue;
-			}
-		}
-
-		// Check the end block.
-		if (vbr->blockEnd != 0 && blockIdx <= vbr->blockEnd) {
-			// Found the track.
-			blockRange = (const GdiReaderPrivate::BlockRange*)vbr;
-			break;
-		}
+	// NOTE: Tracks are opened on demand, so the lookup is
+	// serialized in case pread() is called from multiple threads.
+	const GdiReaderPrivate::BlockRange *blockRange;
+	{
+		MutexLocker locker(d->trackMutex);
+		blockRange = d->findBlockRange(blockIdx);
 	}
 
 	if (!blockRange) {
@@ -570,11 +629,90 @@ int GdiReader::readBlock(uint32_t blockIdx, void *ptr, int pos, size_t size)
 	// FIXME: Read the whole block so we can determine if this is Mode1 or Mode2.
 	// Mode1 data starts at byte 16; Mode2 data starts at byte 24.
 	const int64_t phys_pos = (static_cast<int64_t>(blockIdx - blockRange->blockStart) * blockRange->sectorSize) + 16 + pos;
-	size_t sz_read = blockRange->file->seekAndRead(phys_pos, ptr, size);
-	m_lastError = blockRange->file->lastError();
+	size_t sz_read = blockRange->file->pread(phys_pos, ptr, size);
+	if (sz_read != size) {
+		m_lastError = blockRange->file->lastError();
+	}
 	return (sz_read > 0 ? (int)sz_read : -1);
 }
 
+/**
+ * Read multiple full blocks.
+ *
+ * Blocks are read one at a time using readBlock(),
+ * since getPhysBlockAddr() isn't implemented.
+ *
+ * @param blockIdx	[in] First block index.
+ * @param ptr		[out] Output data buffer.
+ * @param blockCount	[in] Number of blocks to read.
+ * @return Number of bytes read.
+ */
+size_t GdiReader::readBlocks(uint32_t blockIdx, void *ptr, unsigned int blockCount)
+{
+	RP_D(const GdiReader);
+	const unsigned int block_size = d->block_size;
+	uint8_t *ptr8 = static_cast<uint8_t*>(ptr);
+	size_t ret = 0;
+
+	for (; blockCount > 0; blockCount--, blockIdx++, ptr8 += block_size) {
+		int rd = readBlock(blockIdx, ptr8, 0, block_size);
+		if (rd != static_cast<int>(block_size)) {
+			// Error reading the data.
+			return ret + (rd > 0 ? rd : 0);
+		}
+		ret += block_size;
+	}
+
+	return ret;
+}
+
+/**
+ * Hint that data will be read soon.
+ * Only tracks that have already been opened are prefetched.
+ * @param pos	[in] Starting address.
+ * @param size	[in] Amount of data, in bytes.
+ */
+void GdiReader::prefetch(int64_t pos, size_t size)
+{
+	RP_D(GdiReader);
+	if (pos < 0 || size == 0 || d->block_size == 0) {
+		return;
+	}
+
+	const int64_t blockFirst64 = pos / d->block_size;
+	const int64_t blockLast64 = (pos + static_cast<int64_t>(size) - 1) / d->block_size;
+	if (blockFirst64 >= d->blockCount) {
+		return;
+	}
+	const unsigned int blockFirst = static_cast<unsigned int>(blockFirst64);
+	const unsigned int blockLast = (blockLast64 < d->blockCount
+		? static_cast<unsigned int>(blockLast64)
+		: d->blockCount - 1);
+
+	// NOTE: Block ranges are sorted by LBA.
+	MutexLocker locker(d->trackMutex);
+	for (auto iter = d->blockRanges.cbegin(); iter != d->blockRanges.cend(); ++iter) {
+		const GdiReaderPrivate::BlockRange &br = *iter;
+		if (br.blockStart > blockLast) {
+			// No more tracks in range.
+			break;
+		}
+		if (br.blockEnd == 0 || !br.file ||
+		    blockLast < br.blockStart || blockFirst > br.blockEnd)
+		{
+			// Track isn't open, or isn't in range.
+			continue;
+		}
+
+		// Sectors are stored contiguously in the track file.
+		const unsigned int first = (blockFirst > br.blockStart ? blockFirst : br.blockStart);
+		const unsigned int last = (blockLast < br.blockEnd ? blockLast : br.blockEnd);
+		const int64_t phys_pos = static_cast<int64_t>(first - br.blockStart) * br.sectorSize;
+		const size_t phys_size = static_cast<size_t>(last - first + 1) * br.sectorSize;
+		br.file->prefetch(phys_pos, phys_size);
+	}
+}
+
 /** GDI-specific functions. **/
 // TODO: "CdromReader" class?
 
@@ -95,6 +95,28 @@ class GdiReader : public LibRpBase::SparseDiscReader
 		 */
 		int readBlock(uint32_t blockIdx, void *ptr, int pos, size_t size) final;
 
+		/**
+		 * Read multiple full blocks.
+		 *
+		 * Blocks are read one at a time using readBlock(),
+		 * since getPhysBlockAddr() isn't implemented.
+		 *
+		 * @param blockIdx	[in] First block index.
+		 * @param ptr		[out] Output data buffer.
+		 * @param blockCount	[in] Number of blocks to read.
+		 * @return Number of bytes read.
+		 */
+		size_t readBlocks(uint32_t blockIdx, void *ptr, unsigned int blockCount) final;
+
+	public:
+		/**
+		 * Hint that data will be read soon.
+		 * Only tracks that have already been opened are prefetched.
+		 * @param pos	[in] Starting address.
+		 * @param size	[in] Amount of data, in bytes.
+		 */
+		void prefetch(int64_t pos, size_t size) final;
+
 	public:
 		/** GDI-specific functions. **/
 
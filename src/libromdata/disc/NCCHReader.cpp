@@ -26,7 +26,7 @@
 #include "librpbase/file/IRpFile.hpp"
 #include "librpbase/disc/PartitionFile.hpp"
 #ifdef ENABLE_DECRYPTION
-#include "librpbase/crypto/AesCipherFactory.hpp"
+#include "librpbase/crypto/AesParallel.hpp"
 #include "librpbase/crypto/IAesCipher.hpp"
 #endif /* ENABLE_DECRYPTION */
 using namespace LibRpBase;
@@ -59,7 +59,6 @@ NCCHReaderPrivate::NCCHReaderPrivate(NCCHReader *q, IRpFile *file,
 	, nonNcchContentType(NONCCH_UNKNOWN)
 #ifdef ENABLE_DECRYPTION
 	, tid_be(0)
-	, cipher(nullptr)
 	, titleKeyEncIdx(0)
 	, tmd_content_index(0)
 #endif /* ENABLE_DECRYPTION */
@@ -68,6 +67,9 @@ NCCHReaderPrivate::NCCHReaderPrivate(NCCHReader *q, IRpFile *file,
 	memset(&ncch_header, 0, sizeof(ncch_header));
 	memset(&ncch_exheader, 0, sizeof(ncch_exheader));
 	memset(&exefs_header, 0, sizeof(exefs_header));
+#ifdef ENABLE_DECRYPTION
+	memset(cipher, 0, sizeof(cipher));
+#endif /* ENABLE_DECRYPTION */
 
 	// Run the common init function.
 	init();
@@ -87,7 +89,6 @@ NCCHReaderPrivate::NCCHReaderPrivate(NCCHReader *q, IDiscReader *discReader,
 	, verifyResult(KeyManager::VERIFY_UNKNOWN)
 #ifdef ENABLE_DECRYPTION
 	, tid_be(0)
-	, cipher(nullptr)
 	, titleKeyEncIdx(0)
 	, tmd_content_index(0)
 #endif /* ENABLE_DECRYPTION */
@@ -96,6 +97,9 @@ NCCHReaderPrivate::NCCHReaderPrivate(NCCHReader *q, IDiscReader *discReader,
 	memset(&ncch_header, 0, sizeof(ncch_header));
 	memset(&ncch_exheader, 0, sizeof(ncch_exheader));
 	memset(&exefs_header, 0, sizeof(exefs_header));
+#ifdef ENABLE_DECRYPTION
+	memset(cipher, 0, sizeof(cipher));
+#endif /* ENABLE_DECRYPTION */
 
 	// Run the common init function.
 	init();
@@ -200,19 +204,29 @@ void NCCHReaderPrivate::init(void)
 
 #ifdef ENABLE_DECRYPTION
 	if (!(ncch_header.hdr.flags[N3DS_NCCH_FLAG_BIT_MASKS] & N3DS_NCCH_BIT_MASK_NoCrypto)) {
-		// Initialize the AES cipher.
-		// TODO: Check for errors.
-		cipher = AesCipherFactory::create();
-		cipher->setChainingMode(IAesCipher::CM_CTR);
-		u128_t ctr;
+		// Get an AES cipher for each NCCH key.
+		// NOTE: KeyManager caches ciphers, and the keys don't
+		// need to be changed when switching between sections.
+		KeyManager *const keyManager = KeyManager::instance();
+		for (int i = 0; i < ARRAY_SIZE(cipher); i++) {
+			cipher[i] = keyManager->getCipher(ncch_keys[i].u8, sizeof(ncch_keys[i].u8));
+			if (!cipher[i]) {
+				// Unable to create the cipher.
+				verifyResult = KeyManager::VERFIY_IAESCIPHER_INIT_ERR;
+				q->m_lastError = EIO;
+				this->file = nullptr;
+				return;
+			}
+			cipher[i]->setChainingMode(IAesCipher::CM_CTR);
+		}
 
 		if (headers_loaded & HEADER_EXEFS) {
 			// Decrypt the ExeFS header.
 			// ExeFS header uses ncchKey0.
-			cipher->setKey(ncch_keys[0].u8, sizeof(ncch_keys[0].u8));
+			u128_t ctr;
 			ctr.init_ctr(tid_be, N3DS_NCCH_SECTION_EXEFS, 0);
-			cipher->setIV(ctr.u8, sizeof(ctr.u8));
-			cipher->decrypt(reinterpret_cast<uint8_t*>(&exefs_header), sizeof(exefs_header));
+			cipher[0]->setIV(ctr.u8, sizeof(ctr.u8));
+			cipher[0]->decrypt(reinterpret_cast<uint8_t*>(&exefs_header), sizeof(exefs_header));
 		}
 
 		// Initialize encrypted section handling.
@@ -300,7 +314,10 @@ void NCCHReaderPrivate::init(void)
 NCCHReaderPrivate::~NCCHReaderPrivate()
 {
 #ifdef ENABLE_DECRYPTION
-	delete cipher;
+	KeyManager *const keyManager = KeyManager::instance();
+	for (int i = 0; i < ARRAY_SIZE(cipher); i++) {
+		keyManager->releaseCipher(cipher[i]);
+	}
 #endif /* ENABLE_DECRYPTION */
 
 	if (useDiscReader) {
@@ -609,18 +626,25 @@ size_t NCCHReader::read(void *ptr, size_t size)
 		size_t ret_sz = d->readFromROM(d->pos, ptr8, sz_to_read);
 
 		if (section && section->section > N3DS_NCCH_SECTION_PLAIN) {
-			// Set the required key.
-			// TODO: Don't set the key if it hasn't changed.
-			d->cipher->setKey(d->ncch_keys[section->keyIdx].u8, sizeof(d->ncch_keys[section->keyIdx].u8));
-
 			// Initialize the counter based on section and offset.
 			u128_t ctr;
 			ctr.init_ctr(d->tid_be, section->section, d->pos - section->ctr_base);
-			d->cipher->setIV(ctr.u8, sizeof(ctr.u8));
+			const u128_t &key = d->ncch_keys[section->keyIdx];
 
 			// Decrypt the data.
 			// FIXME: Round up to 16 if a short read occurred?
-			ret_sz = d->cipher->decrypt(static_cast<uint8_t*>(ptr), static_cast<unsigned int>(ret_sz));
+			if (AesParallel::isWorthwhile(ret_sz)) {
+				// Large read, e.g. RomFS or ExeFS extraction.
+				// Split it across multiple threads.
+				ret_sz = AesParallel::decrypt(IAesCipher::CM_CTR,
+					key.u8, sizeof(key.u8), ctr.u8, ptr8, ret_sz);
+			} else {
+				// Each key has its own cipher, so the key
+				// doesn't need to be set here.
+				IAesCipher *const cipher = d->cipher[section->keyIdx];
+				cipher->setIV(ctr.u8, sizeof(ctr.u8));
+				ret_sz = cipher->decrypt(ptr8, ret_sz);
+			}
 		}
 
 		d->pos += static_cast<uint32_t>(ret_sz);
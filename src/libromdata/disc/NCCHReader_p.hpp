@@ -142,8 +142,9 @@ class NCCHReaderPrivate
 		// Encryption keys.
 		u128_t ncch_keys[2];
 
-		// NCCH cipher.
-		LibRpBase::IAesCipher *cipher;
+		// NCCH ciphers, one per key.
+		// Obtained from KeyManager::getCipher().
+		LibRpBase::IAesCipher *cipher[2];
 
 		// Encrypted section addresses.
 		struct EncSection {
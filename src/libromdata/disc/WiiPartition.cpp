@@ -28,7 +28,6 @@
 #include "librpbase/crypto/KeyManager.hpp"
 #ifdef ENABLE_DECRYPTION
 # include "librpbase/crypto/IAesCipher.hpp"
-# include "librpbase/crypto/AesCipherFactory.hpp"
 #endif /* ENABLE_DECRYPTION */
 using namespace LibRpBase;
 
@@ -53,7 +52,8 @@ class WiiPartitionPrivate : public GcnPartitionPrivate
 {
 	public:
 		WiiPartitionPrivate(WiiPartition *q, IDiscReader *discReader,
-			int64_t partition_offset, int64_t partition_size, WiiPartition::CryptoMethod cryptoMethod);
+			int64_t partition_offset, int64_t partition_size, WiiPartition::CryptoMethod cryptoMethod,
+			const WiiPartitionCache::Partition *cached = nullptr);
 		virtual ~WiiPartitionPrivate();
 
 	private:
@@ -90,24 +90,59 @@ class WiiPartitionPrivate : public GcnPartitionPrivate
 		// Decrypted sector cache.
 		// NOTE: Actual data starts at 0x400.
 		// Hashes and the sector IV are stored first.
-		uint32_t sector_num;				// Sector number.
-		uint8_t sector_buf[SECTOR_SIZE_ENCRYPTED];	// Decrypted sector data.
+		// The least-recently used sector is replaced on a miss.
+		static const unsigned int SECTOR_CACHE_COUNT = 8;
+		struct SectorCacheEntry {
+			uint32_t sector_num;	// Sector number. (~0 if empty)
+			uint32_t lru;		// sectorCacheLRU value from the last access.
+		};
+		SectorCacheEntry sectorCache[SECTOR_CACHE_COUNT];
+		uint32_t sectorCacheLRU;
+		uint8_t sector_buf[SECTOR_CACHE_COUNT][SECTOR_SIZE_ENCRYPTED];	// Decrypted sector data.
 
 		/**
 		 * Read and decrypt a sector.
-		 * The decrypted sector is stored in sector_buf.
+		 * The decrypted sector is stored in the sector cache.
 		 *
 		 * @param sector_num Sector number. (address / 0x7C00)
-		 * @return 0 on success; negative POSIX error code on error.
+		 * @return Decrypted sector, or nullptr on error.
 		 */
-		int readSector(uint32_t sector_num);
+		const uint8_t *readSector(uint32_t sector_num);
+
+		// Maximum number of sectors read at once by readSectors().
+		static const unsigned int SECTOR_BATCH_COUNT = 16;
+		// Encrypted sector buffer for readSectors().
+		// Allocated on first use.
+		unique_ptr<uint8_t[]> batch_buf;
+
+		/**
+		 * Read and decrypt multiple contiguous sectors.
+		 * Only the sector data is returned; hashes are discarded.
+		 * The sector cache is bypassed, since this is used
+		 * for large reads that would evict everything else.
+		 *
+		 * @param sector_num	[in] First sector number. (address / 0x7C00)
+		 * @param ptr		[out] Output buffer. (Must be at least count * 0x7C00 bytes.)
+		 * @param count		[in] Number of sectors.
+		 * @return Number of sectors read.
+		 */
+		unsigned int readSectors(uint32_t sector_num, uint8_t *ptr, unsigned int count);
 
 #ifdef ENABLE_DECRYPTION
 	public:
 		// AES cipher for this partition's title key.
 		IAesCipher *aes_title;
 		// Decrypted title key.
+		// Only valid if has_title_key is true.
 		uint8_t title_key[16];
+		bool has_title_key;
+
+		/**
+		 * Decrypt the title key using the common key.
+		 * The decrypted title key is stored in title_key.
+		 * @return VerifyResult.
+		 */
+		KeyManager::VerifyResult decryptTitleKey(void);
 
 		/**
 		 * Initialize decryption.
@@ -174,7 +209,8 @@ const uint8_t WiiPartitionPrivate::EncryptionKeyVerifyData[WiiPartition::Key_Max
 
 WiiPartitionPrivate::WiiPartitionPrivate(WiiPartition *q,
 		IDiscReader *discReader, int64_t partition_offset,
-		int64_t partition_size, WiiPartition::CryptoMethod cryptoMethod)
+		int64_t partition_size, WiiPartition::CryptoMethod cryptoMethod,
+		const WiiPartitionCache::Partition *cached)
 	: super(q, discReader, partition_offset, 2)
 #ifdef ENABLE_DECRYPTION
 	, verifyResult(KeyManager::VERIFY_UNKNOWN)
@@ -182,17 +218,23 @@ WiiPartitionPrivate::WiiPartitionPrivate(WiiPartition *q,
 	, encKeyReal(WiiPartition::ENCKEY_UNKNOWN)
 	, cryptoMethod(cryptoMethod)
 	, pos_7C00(-1)
-	, sector_num(~0)
+	, sectorCacheLRU(0)
 	, aes_title(nullptr)
+	, has_title_key(false)
 #else /* !ENABLE_DECRYPTION */
 	, verifyResult(KeyManager::VERIFY_NO_SUPPORT)
 	, encKey(WiiPartition::ENCKEY_UNKNOWN)
 	, encKeyReal(WiiPartition::ENCKEY_UNKNOWN)
 	, cryptoMethod(cryptoMethod)
 	, pos_7C00(-1)
-	, sector_num(~0)
+	, sectorCacheLRU(0)
 #endif /* ENABLE_DECRYPTION */
 {
+	for (unsigned int i = 0; i < SECTOR_CACHE_COUNT; i++) {
+		sectorCache[i].sector_num = ~0;
+		sectorCache[i].lru = 0;
+	}
+
 	if ((cryptoMethod & WiiPartition::CM_MASK_ENCRYPTED) == WiiPartition::CM_UNENCRYPTED) {
 		// No encryption. (RVT-H)
 		verifyResult = KeyManager::VERIFY_OK;
@@ -212,15 +254,27 @@ WiiPartitionPrivate::WiiPartitionPrivate(WiiPartition *q,
 		return;
 	}
 
-	// Read the partition header.
-	if (discReader->seek(partition_offset) != 0) {
-		q->m_lastError = discReader->lastError();
-		return;
-	}
-	size_t size = discReader->read(&partitionHeader, sizeof(partitionHeader));
-	if (size != sizeof(partitionHeader)) {
-		q->m_lastError = EIO;
-		return;
+	if (cached) {
+		// Use the cached partition header.
+		// NOTE: Only the start of the partition header is cached.
+		memcpy(&partitionHeader, cached->header, sizeof(cached->header));
+#ifdef ENABLE_DECRYPTION
+		if (cached->has_title_key) {
+			memcpy(title_key, cached->title_key, sizeof(title_key));
+			has_title_key = true;
+		}
+#endif /* ENABLE_DECRYPTION */
+	} else {
+		// Read the partition header.
+		if (discReader->seek(partition_offset) != 0) {
+			q->m_lastError = discReader->lastError();
+			return;
+		}
+		size_t size = discReader->read(&partitionHeader, sizeof(partitionHeader));
+		if (size != sizeof(partitionHeader)) {
+			q->m_lastError = EIO;
+			return;
+		}
 	}
 
 	// Make sure the signature type is correct.
@@ -296,34 +350,16 @@ void WiiPartitionPrivate::getEncKey(void)
 
 #ifdef ENABLE_DECRYPTION
 /**
- * Initialize decryption.
+ * Decrypt the title key using the common key.
+ * The decrypted title key is stored in title_key.
  * @return VerifyResult.
  */
-KeyManager::VerifyResult WiiPartitionPrivate::initDecryption(void)
+KeyManager::VerifyResult WiiPartitionPrivate::decryptTitleKey(void)
 {
-	if (verifyResult != KeyManager::VERIFY_UNKNOWN) {
-		// Decryption has already been initialized.
-		return verifyResult;
-	}
-
-	// If decryption is enabled, we can load the key and enable reading.
-	// Otherwise, we can only get the partition size information.
-
 	// Get the Key Manager instance.
 	KeyManager *const keyManager = KeyManager::instance();
 	assert(keyManager != nullptr);
 
-	// Determine the required encryption key.
-	getEncKey();
-	if (encKey <= WiiPartition::ENCKEY_UNKNOWN) {
-		// Invalid encryption key index.
-		// Use VERIFY_KEY_NOT_FOUND here.
-		// This condition is indicated by VERIFY_KEY_NOT_FOUND
-		// and a key index ENCKEY_UNKNOWN.
-		verifyResult = KeyManager::VERIFY_KEY_NOT_FOUND;
-		return verifyResult;
-	}
-
 	// Determine the encryption key to use.
 	WiiPartition::EncryptionKeys keyIdx;
 	switch (encKey) {
@@ -345,35 +381,27 @@ KeyManager::VerifyResult WiiPartitionPrivate::initDecryption(void)
 			break;
 		default:
 			// Unknown key...
-			verifyResult = KeyManager::VERIFY_KEY_NOT_FOUND;
-			return verifyResult;
-	}
-
-	// Initialize the AES cipher.
-	unique_ptr<IAesCipher> cipher(AesCipherFactory::create());
-	if (!cipher || !cipher->isInit()) {
-		// Error initializing the cipher.
-		verifyResult = KeyManager::VERFIY_IAESCIPHER_INIT_ERR;
-		return verifyResult;
+			return KeyManager::VERIFY_KEY_NOT_FOUND;
 	}
 
 	// Get the common key.
 	KeyManager::KeyData_t keyData;
-	verifyResult = keyManager->getAndVerify(
+	KeyManager::VerifyResult res = keyManager->getAndVerify(
 		WiiPartitionPrivate::EncryptionKeyNames[keyIdx], &keyData,
 		WiiPartitionPrivate::EncryptionKeyVerifyData[keyIdx], 16);
-	if (verifyResult != KeyManager::VERIFY_OK) {
+	if (res != KeyManager::VERIFY_OK) {
 		// An error occurred loading while the common key.
-		return verifyResult;
+		return res;
 	}
 
-	// Load the common key. (CBC mode)
-	int ret = cipher->setKey(keyData.key, keyData.length);
-	ret |= cipher->setChainingMode(IAesCipher::CM_CBC);
-	if (ret != 0) {
+	// Get a cipher for the common key. (CBC mode)
+	// NOTE: KeyManager caches ciphers, so the common key
+	// isn't expanded again for every partition.
+	IAesCipher *const cipher = keyManager->getCipher(keyData.key, keyData.length);
+	if (!cipher || cipher->setChainingMode(IAesCipher::CM_CBC) != 0) {
 		// Error initializing the cipher.
-		verifyResult = KeyManager::VERFIY_IAESCIPHER_INIT_ERR;
-		return verifyResult;
+		keyManager->releaseCipher(cipher);
+		return KeyManager::VERFIY_IAESCIPHER_INIT_ERR;
 	}
 
 	// Get the IV.
@@ -385,30 +413,75 @@ KeyManager::VerifyResult WiiPartitionPrivate::initDecryption(void)
 
 	// Decrypt the title key.
 	memcpy(title_key, partitionHeader.ticket.enc_title_key, sizeof(title_key));
-	if (cipher->decrypt(title_key, sizeof(title_key), iv, sizeof(iv)) != sizeof(title_key)) {
+	const size_t size = cipher->decrypt(title_key, sizeof(title_key), iv, sizeof(iv));
+	keyManager->releaseCipher(cipher);
+	if (size != sizeof(title_key)) {
 		// Error decrypting the title key.
-		verifyResult = KeyManager::VERIFY_IAESCIPHER_DECRYPT_ERR;
+		return KeyManager::VERIFY_IAESCIPHER_DECRYPT_ERR;
+	}
+
+	// Title key decrypted.
+	has_title_key = true;
+	return KeyManager::VERIFY_OK;
+}
+
+/**
+ * Initialize decryption.
+ * @return VerifyResult.
+ */
+KeyManager::VerifyResult WiiPartitionPrivate::initDecryption(void)
+{
+	if (verifyResult != KeyManager::VERIFY_UNKNOWN) {
+		// Decryption has already been initialized.
+		return verifyResult;
+	}
+
+	// If decryption is enabled, we can load the key and enable reading.
+	// Otherwise, we can only get the partition size information.
+
+	// Get the Key Manager instance.
+	KeyManager *const keyManager = KeyManager::instance();
+	assert(keyManager != nullptr);
+
+	// Determine the required encryption key.
+	getEncKey();
+	if (encKey <= WiiPartition::ENCKEY_UNKNOWN) {
+		// Invalid encryption key index.
+		// Use VERIFY_KEY_NOT_FOUND here.
+		// This condition is indicated by VERIFY_KEY_NOT_FOUND
+		// and a key index ENCKEY_UNKNOWN.
+		verifyResult = KeyManager::VERIFY_KEY_NOT_FOUND;
 		return verifyResult;
 	}
 
-	// Set the title key in the AES cipher.
-	if (cipher->setKey(title_key, sizeof(title_key)) != 0) {
+	if (!has_title_key) {
+		// Title key isn't cached. Decrypt it.
+		const KeyManager::VerifyResult res = decryptTitleKey();
+		if (res != KeyManager::VERIFY_OK) {
+			verifyResult = res;
+			return verifyResult;
+		}
+	}
+
+	// Get a cipher for the title key.
+	IAesCipher *const cipher = keyManager->getCipher(title_key, sizeof(title_key));
+	if (!cipher || cipher->setChainingMode(IAesCipher::CM_CBC) != 0) {
 		// Error initializing the cipher.
+		keyManager->releaseCipher(cipher);
 		verifyResult = KeyManager::VERFIY_IAESCIPHER_INIT_ERR;
 		return verifyResult;
 	}
 
 	// readSector() needs aes_title.
-	if (aes_title) {
-		delete aes_title;
-	}
-	aes_title = cipher.release();
+	keyManager->releaseCipher(aes_title);
+	aes_title = cipher;
 
 	// Read sector 0, which contains a disc header.
 	// NOTE: readSector() doesn't check verifyResult.
-	if (readSector(0) != 0) {
+	const uint8_t *const sector0 = readSector(0);
+	if (!sector0) {
 		// Error reading sector 0.
-		delete aes_title;
+		keyManager->releaseCipher(aes_title);
 		aes_title = nullptr;
 		verifyResult = KeyManager::VERIFY_IAESCIPHER_DECRYPT_ERR;
 		return verifyResult;
@@ -417,7 +490,7 @@ KeyManager::VerifyResult WiiPartitionPrivate::initDecryption(void)
 	// Verify that this is a Wii partition.
 	// If it isn't, the key is probably wrong.
 	const GCN_DiscHeader *discHeader =
-		reinterpret_cast<const GCN_DiscHeader*>(&sector_buf[SECTOR_SIZE_DECRYPTED_OFFSET]);
+		reinterpret_cast<const GCN_DiscHeader*>(&sector0[SECTOR_SIZE_DECRYPTED_OFFSET]);
 	if (discHeader->magic_wii != cpu_to_be32(WII_MAGIC)) {
 		// Invalid disc header.
 		verifyResult = KeyManager::VERIFY_WRONG_KEY;
@@ -433,22 +506,33 @@ KeyManager::VerifyResult WiiPartitionPrivate::initDecryption(void)
 WiiPartitionPrivate::~WiiPartitionPrivate()
 {
 #ifdef ENABLE_DECRYPTION
-	delete aes_title;
+	if (aes_title) {
+		KeyManager::instance()->releaseCipher(aes_title);
+	}
 #endif /* ENABLE_DECRYPTION */
 }
 
 /**
  * Read and decrypt a sector.
- * The decrypted sector is stored in sector_buf.
+ * The decrypted sector is stored in the sector cache.
  *
  * @param sector_num Sector number. (address / 0x7C00)
- * @return 0 on success; negative POSIX error code on error.
+ * @return Decrypted sector, or nullptr on error.
  */
-int WiiPartitionPrivate::readSector(uint32_t sector_num)
+const uint8_t *WiiPartitionPrivate::readSector(uint32_t sector_num)
 {
-	if (this->sector_num == sector_num) {
-		// Sector is already in memory.
-		return 0;
+	// Check if the sector is already in memory.
+	// If it isn't, replace the least-recently used sector.
+	unsigned int idx = 0;
+	for (unsigned int i = 0; i < SECTOR_CACHE_COUNT; i++) {
+		if (sectorCache[i].sector_num == sector_num) {
+			// Sector is already in memory.
+			sectorCache[i].lru = ++sectorCacheLRU;
+			return sector_buf[i];
+		}
+		if (sectorCache[i].lru < sectorCache[idx].lru) {
+			idx = i;
+		}
 	}
 
 	RP_Q(WiiPartition);
@@ -457,7 +541,7 @@ int WiiPartitionPrivate::readSector(uint32_t sector_num)
 	if (isCrypted) {
 		// Decryption is disabled.
 		q->m_lastError = EIO;
-		return -1;
+		return nullptr;
 	}
 #endif /* !ENABLE_DECRYPTION */
 
@@ -467,37 +551,101 @@ int WiiPartitionPrivate::readSector(uint32_t sector_num)
 	int64_t sector_addr = partition_offset + data_offset;
 	sector_addr += (static_cast<int64_t>(sector_num) * SECTOR_SIZE_ENCRYPTED);
 
-	int ret = discReader->seek(sector_addr);
-	if (ret != 0) {
-		q->m_lastError = discReader->lastError();
-		return ret;
-	}
+	// The cache entry is invalid until the sector is read.
+	SectorCacheEntry &entry = sectorCache[idx];
+	uint8_t *const buf = sector_buf[idx];
+	entry.sector_num = ~0;
+	entry.lru = 0;
 
-	size_t sz = discReader->read(sector_buf, sizeof(sector_buf));
+	size_t sz = discReader->pread(sector_addr, buf, SECTOR_SIZE_ENCRYPTED);
 	if (sz != SECTOR_SIZE_ENCRYPTED) {
-		// sector_buf may be invalid.
-		this->sector_num = ~0;
 		q->m_lastError = EIO;
-		return -1;
+		return nullptr;
 	}
 
 #ifdef ENABLE_DECRYPTION
 	if (isCrypted) {
 		// Decrypt the sector.
-		if (aes_title->decrypt(&sector_buf[SECTOR_SIZE_DECRYPTED_OFFSET], SECTOR_SIZE_DECRYPTED,
-		    &sector_buf[0x3D0], 16) != SECTOR_SIZE_DECRYPTED)
+		if (aes_title->decrypt(&buf[SECTOR_SIZE_DECRYPTED_OFFSET], SECTOR_SIZE_DECRYPTED,
+		    &buf[0x3D0], 16) != SECTOR_SIZE_DECRYPTED)
 		{
-			// sector_buf may be invalid.
-			this->sector_num = ~0;
 			q->m_lastError = EIO;
-			return -1;
+			return nullptr;
 		}
 	}
 #endif /* ENABLE_DECRYPTION */
 
 	// Sector read and decrypted.
-	this->sector_num = sector_num;
-	return 0;
+	entry.sector_num = sector_num;
+	entry.lru = ++sectorCacheLRU;
+	return buf;
+}
+
+/**
+ * Read and decrypt multiple contiguous sectors.
+ * Only the sector data is returned; hashes are discarded.
+ * The sector cache is bypassed, since this is used
+ * for large reads that would evict everything else.
+ *
+ * @param sector_num	[in] First sector number. (address / 0x7C00)
+ * @param ptr		[out] Output buffer. (Must be at least count * 0x7C00 bytes.)
+ * @param count		[in] Number of sectors.
+ * @return Number of sectors read.
+ */
+unsigned int WiiPartitionPrivate::readSectors(uint32_t sector_num, uint8_t *ptr, unsigned int count)
+{
+	RP_Q(WiiPartition);
+	const bool isCrypted = ((cryptoMethod & WiiPartition::CM_MASK_ENCRYPTED) == WiiPartition::CM_ENCRYPTED);
+#ifndef ENABLE_DECRYPTION
+	if (isCrypted) {
+		// Decryption is disabled.
+		q->m_lastError = EIO;
+		return 0;
+	}
+#endif /* !ENABLE_DECRYPTION */
+
+	if (!batch_buf) {
+		batch_buf.reset(new uint8_t[SECTOR_BATCH_COUNT * SECTOR_SIZE_ENCRYPTED]);
+	}
+
+	unsigned int ret = 0;
+	while (count > 0) {
+		// Read as many encrypted sectors as possible at once.
+		const unsigned int batch = (count < SECTOR_BATCH_COUNT ? count : SECTOR_BATCH_COUNT);
+		const int64_t sector_addr = partition_offset + data_offset +
+			(static_cast<int64_t>(sector_num) * SECTOR_SIZE_ENCRYPTED);
+		const size_t batch_sz = static_cast<size_t>(batch) * SECTOR_SIZE_ENCRYPTED;
+		size_t sz = discReader->pread(sector_addr, batch_buf.get(), batch_sz);
+		const unsigned int batch_rd = static_cast<unsigned int>(sz / SECTOR_SIZE_ENCRYPTED);
+
+		// Decrypt the sector data directly into the output buffer.
+		const uint8_t *src = batch_buf.get();
+		for (unsigned int i = 0; i < batch_rd; i++, src += SECTOR_SIZE_ENCRYPTED) {
+			memcpy(ptr, &src[SECTOR_SIZE_DECRYPTED_OFFSET], SECTOR_SIZE_DECRYPTED);
+#ifdef ENABLE_DECRYPTION
+			if (isCrypted) {
+				if (aes_title->decrypt(ptr, SECTOR_SIZE_DECRYPTED,
+				    &src[0x3D0], 16) != SECTOR_SIZE_DECRYPTED)
+				{
+					q->m_lastError = EIO;
+					return ret;
+				}
+			}
+#endif /* ENABLE_DECRYPTION */
+			ptr += SECTOR_SIZE_DECRYPTED;
+			ret++;
+		}
+
+		if (batch_rd != batch) {
+			// Short read.
+			q->m_lastError = EIO;
+			break;
+		}
+		sector_num += batch;
+		count -= batch;
+	}
+
+	return ret;
 }
 
 /** WiiPartition **/
@@ -518,6 +666,24 @@ WiiPartition::WiiPartition(IDiscReader *discReader, int64_t partition_offset,
 	: super(new WiiPartitionPrivate(this, discReader, partition_offset, partition_size, cryptoMethod))
 { }
 
+/**
+ * Construct a WiiPartition using cached partition information.
+ *
+ * The partition header is not read from the disc, and if
+ * a title key is cached, it won't be decrypted again.
+ *
+ * NOTE: The IDiscReader *must* remain valid while this
+ * WiiPartition is open.
+ *
+ * @param discReader		[in] IDiscReader.
+ * @param cached		[in] Cached partition information.
+ * @param cryptoMethod		[in] Crypto method.
+ */
+WiiPartition::WiiPartition(IDiscReader *discReader, const WiiPartitionCache::Partition &cached,
+		CryptoMethod cryptoMethod)
+	: super(new WiiPartitionPrivate(this, discReader, cached.start, cached.size, cryptoMethod, &cached))
+{ }
+
 WiiPartition::~WiiPartition()
 { }
 
@@ -566,12 +732,15 @@ size_t WiiPartition::read(void *ptr, size_t size)
 				read_sz = static_cast<uint32_t>(size);
 			}
 
-			// Read and decrypt the sector.
+			// Read the sector.
 			const uint32_t blockStart = static_cast<uint32_t>(d->pos_7C00 / SECTOR_SIZE_ENCRYPTED);
-			d->readSector(blockStart);
+			const uint8_t *const sector = d->readSector(blockStart);
+			if (!sector) {
+				return ret;
+			}
 
 			// Copy data from the sector.
-			memcpy(ptr8, &d->sector_buf[blockStartOffset], read_sz);
+			memcpy(ptr8, &sector[blockStartOffset], read_sz);
 
 			// Starting block read.
 			size -= read_sz;
@@ -581,18 +750,22 @@ size_t WiiPartition::read(void *ptr, size_t size)
 		}
 
 		// Read entire blocks.
-		for (; size >= SECTOR_SIZE_ENCRYPTED;
-		     size -= SECTOR_SIZE_ENCRYPTED, ptr8 += SECTOR_SIZE_ENCRYPTED,
-		     ret += SECTOR_SIZE_ENCRYPTED, d->pos_7C00 += SECTOR_SIZE_ENCRYPTED)
-		{
+		// These don't need to be decrypted, so they're
+		// read directly into the output buffer.
+		if (size >= SECTOR_SIZE_ENCRYPTED) {
 			assert(d->pos_7C00 % SECTOR_SIZE_ENCRYPTED == 0);
-
-			// Read the sector.
-			const uint32_t blockStart = static_cast<uint32_t>(d->pos_7C00 / SECTOR_SIZE_ENCRYPTED);
-			d->readSector(blockStart);
-
-			// Copy data from the sector.
-			memcpy(ptr8, d->sector_buf, SECTOR_SIZE_ENCRYPTED);
+			const size_t blocks_sz = size - (size % SECTOR_SIZE_ENCRYPTED);
+			const size_t sz = d->discReader->pread(
+				d->partition_offset + d->data_offset + d->pos_7C00, ptr8, blocks_sz);
+			size -= sz;
+			ptr8 += sz;
+			ret += sz;
+			d->pos_7C00 += sz;
+			if (sz != blocks_sz) {
+				// Short read.
+				m_lastError = EIO;
+				return ret;
+			}
 		}
 
 		// Check if we still have data left. (not a full block)
@@ -602,10 +775,13 @@ size_t WiiPartition::read(void *ptr, size_t size)
 			// Read the sector.
 			assert(d->pos_7C00 % SECTOR_SIZE_ENCRYPTED == 0);
 			const uint32_t blockEnd = static_cast<uint32_t>(d->pos_7C00 / SECTOR_SIZE_ENCRYPTED);
-			d->readSector(blockEnd);
+			const uint8_t *const sector = d->readSector(blockEnd);
+			if (!sector) {
+				return ret;
+			}
 
 			// Copy data from the sector.
-			memcpy(ptr8, &d->sector_buf[blockStartOffset], size);
+			memcpy(ptr8, sector, size);
 
 			ret += size;
 			d->pos_7C00 += size;
@@ -638,7 +814,7 @@ size_t WiiPartition::read(void *ptr, size_t size)
 #else /* !ENABLE_DECRYPTION */
 			// Decryption is not enabled.
 			m_lastError = EIO;
-			ret = 0;
+			return 0;
 #endif /* ENABLE_DECRYPTION */
 		}
 
@@ -654,10 +830,13 @@ size_t WiiPartition::read(void *ptr, size_t size)
 
 			// Read and decrypt the sector.
 			const uint32_t blockStart = static_cast<uint32_t>(d->pos_7C00 / SECTOR_SIZE_DECRYPTED);
-			d->readSector(blockStart);
+			const uint8_t *const sector = d->readSector(blockStart);
+			if (!sector) {
+				return ret;
+			}
 
 			// Copy data from the sector.
-			memcpy(ptr8, &d->sector_buf[SECTOR_SIZE_DECRYPTED_OFFSET + blockStartOffset], read_sz);
+			memcpy(ptr8, &sector[SECTOR_SIZE_DECRYPTED_OFFSET + blockStartOffset], read_sz);
 
 			// Starting block read.
 			size -= read_sz;
@@ -667,18 +846,22 @@ size_t WiiPartition::read(void *ptr, size_t size)
 		}
 
 		// Read entire blocks.
-		for (; size >= SECTOR_SIZE_DECRYPTED;
-		size -= SECTOR_SIZE_DECRYPTED, ptr8 += SECTOR_SIZE_DECRYPTED,
-		ret += SECTOR_SIZE_DECRYPTED, d->pos_7C00 += SECTOR_SIZE_DECRYPTED)
-		{
+		if (size >= SECTOR_SIZE_DECRYPTED) {
 			assert(d->pos_7C00 % SECTOR_SIZE_DECRYPTED == 0);
 
-			// Read and decrypt the sector.
+			// Read and decrypt the sectors.
 			const uint32_t blockStart = static_cast<uint32_t>(d->pos_7C00 / SECTOR_SIZE_DECRYPTED);
-			d->readSector(blockStart);
-
-			// Copy data from the sector.
-			memcpy(ptr8, &d->sector_buf[SECTOR_SIZE_DECRYPTED_OFFSET], SECTOR_SIZE_DECRYPTED);
+			const unsigned int blockCount = static_cast<unsigned int>(size / SECTOR_SIZE_DECRYPTED);
+			const unsigned int blocksRead = d->readSectors(blockStart, ptr8, blockCount);
+			const size_t sz = static_cast<size_t>(blocksRead) * SECTOR_SIZE_DECRYPTED;
+			size -= sz;
+			ptr8 += sz;
+			ret += sz;
+			d->pos_7C00 += sz;
+			if (blocksRead != blockCount) {
+				// Short read.
+				return ret;
+			}
 		}
 
 		// Check if we still have data left. (not a full block)
@@ -688,10 +871,13 @@ size_t WiiPartition::read(void *ptr, size_t size)
 			// Read and decrypt the sector.
 			assert(d->pos_7C00 % SECTOR_SIZE_DECRYPTED == 0);
 			const uint32_t blockEnd = static_cast<uint32_t>(d->pos_7C00 / SECTOR_SIZE_DECRYPTED);
-			d->readSector(blockEnd);
+			const uint8_t *const sector = d->readSector(blockEnd);
+			if (!sector) {
+				return ret;
+			}
 
 			// Copy data from the sector.
-			memcpy(ptr8, &d->sector_buf[SECTOR_SIZE_DECRYPTED_OFFSET], size);
+			memcpy(ptr8, &sector[SECTOR_SIZE_DECRYPTED_OFFSET], size);
 
 			ret += size;
 			d->pos_7C00 += size;
@@ -747,6 +933,36 @@ int64_t WiiPartition::tell(void)
 	return d->pos_7C00;
 }
 
+/**
+ * Hint that data will be read soon.
+ * The encrypted sectors containing the data are prefetched.
+ * @param pos	[in] Starting address.
+ * @param size	[in] Amount of data, in bytes.
+ */
+void WiiPartition::prefetch(int64_t pos, size_t size)
+{
+	RP_D(WiiPartition);
+	if (!d->discReader || d->data_offset < 0 || pos < 0 || size == 0) {
+		return;
+	}
+
+	int64_t sector_pos;
+	size_t sector_size;
+	if ((d->cryptoMethod & CM_MASK_SECTOR) == CM_32K) {
+		// Full 32K sectors. Addresses are unchanged.
+		sector_pos = pos;
+		sector_size = size;
+	} else {
+		// Each 0x7C00-byte block of data is stored
+		// in a 0x8000-byte sector.
+		const int64_t sectorFirst = pos / SECTOR_SIZE_DECRYPTED;
+		const int64_t sectorLast = (pos + static_cast<int64_t>(size) - 1) / SECTOR_SIZE_DECRYPTED;
+		sector_pos = sectorFirst * SECTOR_SIZE_ENCRYPTED;
+		sector_size = static_cast<size_t>(sectorLast - sectorFirst + 1) * SECTOR_SIZE_ENCRYPTED;
+	}
+	d->discReader->prefetch(d->partition_offset + d->data_offset + sector_pos, sector_size);
+}
+
 /** WiiPartition **/
 
 /**
@@ -811,6 +1027,36 @@ const RVL_TMD_Header *WiiPartition::tmdHeader(void) const
 		: nullptr);
 }
 
+/**
+ * Save the partition header and title key for WiiPartitionCache.
+ * The partition table fields are not modified.
+ * @param pCached	[out] Cached partition information.
+ * @return True on success; false if the partition header wasn't loaded.
+ */
+bool WiiPartition::saveToCache(WiiPartitionCache::Partition *pCached) const
+{
+	RP_D(const WiiPartition);
+	if (d->partition_size < 0) {
+		// Partition header wasn't loaded.
+		return false;
+	}
+
+	memcpy(pCached->header, &d->partitionHeader, sizeof(pCached->header));
+#ifdef ENABLE_DECRYPTION
+	// Only save the title key if it was verified.
+	pCached->has_title_key = (d->has_title_key && d->verifyResult == KeyManager::VERIFY_OK);
+	if (pCached->has_title_key) {
+		memcpy(pCached->title_key, d->title_key, sizeof(pCached->title_key));
+	} else {
+		memset(pCached->title_key, 0, sizeof(pCached->title_key));
+	}
+#else /* !ENABLE_DECRYPTION */
+	pCached->has_title_key = false;
+	memset(pCached->title_key, 0, sizeof(pCached->title_key));
+#endif /* ENABLE_DECRYPTION */
+	return true;
+}
+
 #ifdef ENABLE_DECRYPTION
 /** Encryption keys. **/
 
@@ -23,6 +23,7 @@
 
 #include "librpbase/config.librpbase.h"
 #include "GcnPartition.hpp"
+#include "WiiPartitionCache.hpp"
 #include "../Console/wii_structs.h"
 
 // librpbase
@@ -62,6 +63,23 @@ class WiiPartition : public GcnPartition
 		 */
 		WiiPartition(IDiscReader *discReader, int64_t partition_offset,
 			int64_t partition_size, CryptoMethod crypto = CM_STANDARD);
+
+		/**
+		 * Construct a WiiPartition using cached partition information.
+		 *
+		 * The partition header is not read from the disc, and if
+		 * a title key is cached, it won't be decrypted again.
+		 *
+		 * NOTE: The IDiscReader *must* remain valid while this
+		 * WiiPartition is open.
+		 *
+		 * @param discReader		[in] IDiscReader.
+		 * @param cached		[in] Cached partition information.
+		 * @param cryptoMethod		[in] Crypto method.
+		 */
+		WiiPartition(IDiscReader *discReader, const WiiPartitionCache::Partition &cached,
+			CryptoMethod crypto = CM_STANDARD);
+
 		~WiiPartition();
 
 	private:
@@ -97,6 +115,14 @@ class WiiPartition : public GcnPartition
 		 */
 		int64_t tell(void) final;
 
+		/**
+		 * Hint that data will be read soon.
+		 * The encrypted sectors containing the data are prefetched.
+		 * @param pos	[in] Starting address.
+		 * @param size	[in] Amount of data, in bytes.
+		 */
+		void prefetch(int64_t pos, size_t size) final;
+
 		/** WiiPartition **/
 
 		/**
@@ -141,6 +167,14 @@ class WiiPartition : public GcnPartition
 		 */
 		const RVL_TMD_Header *tmdHeader(void) const;
 
+		/**
+		 * Save the partition header and title key for WiiPartitionCache.
+		 * The partition table fields are not modified.
+		 * @param pCached	[out] Cached partition information.
+		 * @return True on success; false if the partition header wasn't loaded.
+		 */
+		bool saveToCache(WiiPartitionCache::Partition *pCached) const;
+
 	public:
 		// Encryption key indexes.
 		enum EncryptionKeys {
@@ -0,0 +1,232 @@
+/***************************************************************************
+ * ROM Properties Page shell extension. (libromdata)                       *
+ * WiiPartitionCache.cpp: Process-wide cache of Wii partition tables.      *
+ *                                                                         *
+ * Copyright (c) 2016-2018 by David Korth.                                 *
+ *                                                                         *
+ * This program is free software; you can redistribute it and/or modify it *
+ * under the terms of the GNU General Public License as published by the   *
+ * Free Software Foundation; either version 2 of the License, or (at your  *
+ * option) any later version.                                              *
+ *                                                                         *
+ * This program is distributed in the hope that it will be useful, but     *
+ * WITHOUT ANY WARRANTY; without even the implied warranty of              *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the           *
+ * GNU General Public License for more details.                            *
+ *                                                                         *
+ * You should have received a copy of the GNU General Public License       *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.   *
+ ***************************************************************************/
+
+#include "WiiPartitionCache.hpp"
+#include "libromdata/config.libromdata.h"
+
+// librpbase
+#include "librpbase/file/IRpFile.hpp"
+#include "librpbase/threads/Mutex.hpp"
+#ifdef _WIN32
+# include "librpbase/TextFuncs_wchar.hpp"
+#endif /* _WIN32 */
+using namespace LibRpBase;
+
+#ifdef _WIN32
+# include "libwin32common/RpWin32_sdk.h"
+#else /* !_WIN32 */
+// C includes.
+# include <sys/stat.h>
+#endif /* _WIN32 */
+
+// C++ includes.
+#include <string>
+#include <vector>
+using std::string;
+using std::vector;
+
+namespace LibRomData {
+
+class WiiPartitionCachePrivate
+{
+	private:
+		WiiPartitionCachePrivate();
+		~WiiPartitionCachePrivate();
+	private:
+		RP_DISABLE_COPY(WiiPartitionCachePrivate)
+
+	public:
+		// Cache mutex.
+		static Mutex mtxCache;
+
+		// Cached disc image.
+		struct Entry {
+			WiiPartitionCache::Key key;
+			vector<WiiPartitionCache::Partition> partitions;
+		};
+
+		// Cached disc images.
+		// Ordered from least recently used to most recently used.
+		static vector<Entry> entries;
+
+		/**
+		 * Find a disc image in the cache.
+		 * mtxCache must be locked by the caller.
+		 * @param key File identity.
+		 * @return Iterator, or entries.end() if not found.
+		 */
+		static vector<Entry>::iterator find(const WiiPartitionCache::Key &key);
+};
+
+/** WiiPartitionCachePrivate **/
+
+Mutex WiiPartitionCachePrivate::mtxCache;
+vector<WiiPartitionCachePrivate::Entry> WiiPartitionCachePrivate::entries;
+
+/**
+ * Find a disc image in the cache.
+ * mtxCache must be locked by the caller.
+ * @param key File identity.
+ * @return Iterator, or entries.end() if not found.
+ */
+vector<WiiPartitionCachePrivate::Entry>::iterator WiiPartitionCachePrivate::find(const WiiPartitionCache::Key &key)
+{
+	for (auto iter = entries.begin(); iter != entries.end(); ++iter) {
+		const WiiPartitionCache::Key &ekey = iter->key;
+		if (ekey.dev == key.dev && ekey.ino == key.ino &&
+		    ekey.size == key.size && ekey.mtime == key.mtime &&
+		    ekey.mtime_nsec == key.mtime_nsec &&
+		    ekey.filename == key.filename)
+		{
+			return iter;
+		}
+	}
+	return entries.end();
+}
+
+/** WiiPartitionCache **/
+
+/**
+ * Get the cache key for a file.
+ * @param file	[in] Opened file.
+ * @param pKey	[out] Cache key.
+ * @return True on success; false if the file can't be cached.
+ */
+bool WiiPartitionCache::getKey(IRpFile *file, Key *pKey)
+{
+	if (!file || !file->isOpen()) {
+		return false;
+	}
+
+	pKey->filename = file->filename();
+	if (pKey->filename.empty()) {
+		// No filename. (memory buffer, etc.)
+		return false;
+	}
+
+#ifdef _WIN32
+	// Use GetFileInformationByHandle() to get the file index
+	// and the full-precision modification time.
+	HANDLE hFile = CreateFileW(U82W_s(pKey->filename),
+		GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr,
+		OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (!hFile || hFile == INVALID_HANDLE_VALUE) {
+		return false;
+	}
+	BY_HANDLE_FILE_INFORMATION bhfi;
+	BOOL bRet = GetFileInformationByHandle(hFile, &bhfi);
+	CloseHandle(hFile);
+	if (!bRet) {
+		return false;
+	}
+
+	pKey->dev = bhfi.dwVolumeSerialNumber;
+	pKey->ino = (static_cast<uint64_t>(bhfi.nFileIndexHigh) << 32) | bhfi.nFileIndexLow;
+	pKey->size = (static_cast<int64_t>(bhfi.nFileSizeHigh) << 32) | bhfi.nFileSizeLow;
+	// FILETIME is in 100ns units since 1601/01/01.
+	const int64_t ft = (static_cast<int64_t>(bhfi.ftLastWriteTime.dwHighDateTime) << 32) |
+			    bhfi.ftLastWriteTime.dwLowDateTime;
+	pKey->mtime = ft / 10000000;
+	pKey->mtime_nsec = static_cast<uint32_t>(ft % 10000000) * 100;
+#else /* !_WIN32 */
+	struct stat sb;
+	if (stat(pKey->filename.c_str(), &sb) != 0 || !S_ISREG(sb.st_mode)) {
+		return false;
+	}
+
+	pKey->dev = static_cast<uint64_t>(sb.st_dev);
+	pKey->ino = static_cast<uint64_t>(sb.st_ino);
+	pKey->size = static_cast<int64_t>(sb.st_size);
+	pKey->mtime = static_cast<int64_t>(sb.st_mtime);
+# if defined(HAVE_STRUCT_STAT_ST_MTIM_TV_NSEC)
+	pKey->mtime_nsec = static_cast<uint32_t>(sb.st_mtim.tv_nsec);
+# elif defined(HAVE_STRUCT_STAT_ST_MTIMESPEC_TV_NSEC)
+	pKey->mtime_nsec = static_cast<uint32_t>(sb.st_mtimespec.tv_nsec);
+# else
+	pKey->mtime_nsec = 0;
+# endif
+#endif /* _WIN32 */
+
+	return true;
+}
+
+/**
+ * Look up a disc image in the cache.
+ * @param key		[in] File identity.
+ * @param partitions	[out] Cached partitions.
+ * @return True if found; false if not.
+ */
+bool WiiPartitionCache::lookup(const Key &key, vector<Partition> &partitions)
+{
+	MutexLocker mtxLocker(WiiPartitionCachePrivate::mtxCache);
+	auto iter = WiiPartitionCachePrivate::find(key);
+	if (iter == WiiPartitionCachePrivate::entries.end()) {
+		return false;
+	}
+
+	partitions = iter->partitions;
+
+	// Mark this entry as the most recently used.
+	if (iter + 1 != WiiPartitionCachePrivate::entries.end()) {
+		WiiPartitionCachePrivate::Entry entry = std::move(*iter);
+		WiiPartitionCachePrivate::entries.erase(iter);
+		WiiPartitionCachePrivate::entries.push_back(std::move(entry));
+	}
+	return true;
+}
+
+/**
+ * Store a disc image in the cache.
+ * An existing entry for the same file is replaced.
+ * @param key		[in] File identity.
+ * @param partitions	[in] Partitions.
+ */
+void WiiPartitionCache::store(const Key &key, const vector<Partition> &partitions)
+{
+	if (partitions.empty() || partitions.size() > MAX_PARTITIONS) {
+		// Not caching this disc image.
+		return;
+	}
+
+	MutexLocker mtxLocker(WiiPartitionCachePrivate::mtxCache);
+	auto iter = WiiPartitionCachePrivate::find(key);
+	if (iter != WiiPartitionCachePrivate::entries.end()) {
+		WiiPartitionCachePrivate::entries.erase(iter);
+	} else if (WiiPartitionCachePrivate::entries.size() >= MAX_DISCS) {
+		// Evict the least recently used disc image.
+		WiiPartitionCachePrivate::entries.erase(WiiPartitionCachePrivate::entries.begin());
+	}
+
+	WiiPartitionCachePrivate::Entry entry;
+	entry.key = key;
+	entry.partitions = partitions;
+	WiiPartitionCachePrivate::entries.push_back(std::move(entry));
+}
+
+/**
+ * Remove all disc images from the cache.
+ */
+void WiiPartitionCache::clear(void)
+{
+	MutexLocker mtxLocker(WiiPartitionCachePrivate::mtxCache);
+	WiiPartitionCachePrivate::entries.clear();
+}
+
+}
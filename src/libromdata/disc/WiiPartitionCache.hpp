@@ -0,0 +1,144 @@
+/***************************************************************************
+ * ROM Properties Page shell extension. (libromdata)                       *
+ * WiiPartitionCache.hpp: Process-wide cache of Wii partition tables.      *
+ *                                                                         *
+ * Copyright (c) 2016-2018 by David Korth.                                 *
+ *                                                                         *
+ * This program is free software; you can redistribute it and/or modify it *
+ * under the terms of the GNU General Public License as published by the   *
+ * Free Software Foundation; either version 2 of the License, or (at your  *
+ * option) any later version.                                              *
+ *                                                                         *
+ * This program is distributed in the hope that it will be useful, but     *
+ * WITHOUT ANY WARRANTY; without even the implied warranty of              *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the           *
+ * GNU General Public License for more details.                            *
+ *                                                                         *
+ * You should have received a copy of the GNU General Public License       *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.   *
+ ***************************************************************************/
+
+#ifndef __ROMPROPERTIES_LIBROMDATA_DISC_WIIPARTITIONCACHE_HPP__
+#define __ROMPROPERTIES_LIBROMDATA_DISC_WIIPARTITIONCACHE_HPP__
+
+#include "librpbase/common.h"
+#include "../Console/wii_structs.h"
+
+// C includes.
+#include <stddef.h>
+#include <stdint.h>
+
+// C++ includes.
+#include <string>
+#include <vector>
+
+namespace LibRpBase {
+	class IRpFile;
+}
+
+namespace LibRomData {
+
+/**
+ * Process-wide cache of Wii partition tables.
+ *
+ * The thumbnailer, property page, and metadata extractor
+ * each create their own GameCube object for the same disc
+ * image. Caching the partition tables, partition headers,
+ * and decrypted title keys allows subsequent objects to
+ * skip reading and decrypting them again.
+ *
+ * The cache holds a limited number of disc images,
+ * and the least recently used image is evicted first.
+ */
+class WiiPartitionCache
+{
+	private:
+		WiiPartitionCache();
+		~WiiPartitionCache();
+	private:
+		RP_DISABLE_COPY(WiiPartitionCache)
+
+	public:
+		/**
+		 * File identity.
+		 * If any field changes, the cache entry is invalid.
+		 *
+		 * dev/ino identify the file itself, so a file that was
+		 * replaced by rename() doesn't match. On Windows, these
+		 * are the volume serial number and the file index.
+		 * The filename is still compared in case the filesystem
+		 * doesn't provide stable inode numbers.
+		 */
+		struct Key {
+			uint64_t dev;		// Device ID.
+			uint64_t ino;		// Inode number.
+			int64_t size;		// File size.
+			int64_t mtime;		// Modification time. (seconds)
+			uint32_t mtime_nsec;	// Modification time. (nanoseconds)
+			std::string filename;	// Filename.
+		};
+
+		/**
+		 * Get the cache key for a file.
+		 * @param file	[in] Opened file.
+		 * @param pKey	[out] Cache key.
+		 * @return True on success; false if the file can't be cached.
+		 */
+		static bool getKey(LibRpBase::IRpFile *file, Key *pKey);
+
+		// Amount of the partition header that's cached.
+		// This includes the ticket, the partition header
+		// fields, and the TMD header.
+		static const unsigned int HEADER_SIZE =
+			offsetof(RVL_PartitionHeader, tmd) + sizeof(RVL_TMD_Header);
+
+		/**
+		 * Cached partition.
+		 */
+		struct Partition {
+			uint8_t vg;		// Volume group number.
+			uint8_t pt;		// Partition number.
+			uint32_t type;		// Partition type.
+			int64_t start;		// Starting address, in bytes.
+			int64_t size;		// Estimated partition size, in bytes.
+
+			// Start of the partition header.
+			uint8_t header[HEADER_SIZE];
+
+			// Decrypted title key.
+			// Only valid if has_title_key is true.
+			bool has_title_key;
+			uint8_t title_key[16];
+		};
+
+		// Maximum number of disc images in the cache.
+		static const unsigned int MAX_DISCS = 16;
+		// Maximum number of partitions per disc image.
+		// Disc images with more partitions are not cached.
+		static const unsigned int MAX_PARTITIONS = 16;
+
+		/**
+		 * Look up a disc image in the cache.
+		 * @param key		[in] File identity.
+		 * @param partitions	[out] Cached partitions.
+		 * @return True if found; false if not.
+		 */
+		static bool lookup(const Key &key, std::vector<Partition> &partitions);
+
+		/**
+		 * Store a disc image in the cache.
+		 * An existing entry for the same file is replaced.
+		 * @param key		[in] File identity.
+		 * @param partitions	[in] Partitions.
+		 */
+		static void store(const Key &key, const std::vector<Partition> &partitions);
+
+		/**
+		 * Remove all disc images from the cache.
+		 */
+		static void clear(void);
+};
+
+}
+
+#endif /* __ROMPROPERTIES_LIBROMDATA_DISC_WIIPARTITIONCACHE_HPP__ */
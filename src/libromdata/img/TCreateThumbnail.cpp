@@ -33,6 +33,8 @@ using LibCacheMgr::CacheManager;
 #include "librpbase/file/RpFile.hpp"
 #include "librpbase/img/rp_image.hpp"
 #include "librpbase/img/RpImageLoader.hpp"
+#include "librpbase/img/ImagePipeline.hpp"
+#include "librpbase/img/RpPngWriter.hpp"
 #include "librpbase/config/Config.hpp"
 using namespace LibRpBase;
 
@@ -61,6 +63,7 @@ TCreateThumbnail<ImgClass>::~TCreateThumbnail()
  * Get an internal image.
  * @param romData	[in] RomData object.
  * @param imageType	[in] Image type.
+ * @param req_size	[in] Requested image size. (<= 0 for the full-size image)
  * @param pOutSize	[out,opt] Pointer to ImgSize to store the image's size.
  * @param sBIT		[out,opt] sBIT metadata.
  * @return Internal image, or null ImgClass on error.
@@ -69,7 +72,7 @@ template<typename ImgClass>
 ImgClass TCreateThumbnail<ImgClass>::getInternalImage(
 	const RomData *romData,
 	RomData::ImageType imageType,
-	ImgSize *pOutSize,
+	int req_size, ImgSize *pOutSize,
 	rp_image::sBIT_t *sBIT)
 {
 	assert(imageType >= RomData::IMG_INT_MIN && imageType <= RomData::IMG_INT_MAX);
@@ -81,7 +84,9 @@ ImgClass TCreateThumbnail<ImgClass>::getInternalImage(
 		return getNullImgClass();
 	}
 
-	const rp_image *image = romData->image(imageType);
+	// Textures may have smaller mipmaps that are still
+	// large enough for the requested thumbnail size.
+	const rp_image *image = romData->image(imageType, req_size);
 	if (!image) {
 		// No image.
 		if (sBIT) {
@@ -91,7 +96,7 @@ ImgClass TCreateThumbnail<ImgClass>::getInternalImage(
 	}
 
 	// Convert the rp_image to ImgClass.
-	ImgClass ret_img = rpImageToImgClass(image);
+	ImgClass ret_img = rpImageToImgClassScaled(image, romData->imgpf(imageType), req_size);
 	if (isImgClassValid(ret_img)) {
 		// Image converted successfully.
 		if (pOutSize) {
@@ -115,27 +120,20 @@ ImgClass TCreateThumbnail<ImgClass>::getInternalImage(
 }
 
 /**
- * Get an external image.
+ * Load an external image.
  * @param romData	[in] RomData object.
  * @param imageType	[in] Image type.
  * @param req_size	[in] Requested image size.
- * @param pOutSize	[out,opt] Pointer to ImgSize to store the image's size.
- * @param sBIT		[out,opt] sBIT metadata.
- * @return External image, or null ImgClass on error.
+ * @return External image, or nullptr on error. (Caller must delete it.)
  */
 template<typename ImgClass>
-ImgClass TCreateThumbnail<ImgClass>::getExternalImage(
-	const RomData *romData, RomData::ImageType imageType,
-	int req_size, ImgSize *pOutSize,
-	rp_image::sBIT_t *sBIT)
+rp_image *TCreateThumbnail<ImgClass>::loadExternalImage(
+	const RomData *romData, RomData::ImageType imageType, int req_size)
 {
 	assert(imageType >= RomData::IMG_EXT_MIN && imageType <= RomData::IMG_EXT_MAX);
 	if (imageType < RomData::IMG_EXT_MIN || imageType > RomData::IMG_EXT_MAX) {
 		// Out of range.
-		if (sBIT) {
-			memset(sBIT, 0, sizeof(*sBIT));
-		}
-		return getNullImgClass();
+		return nullptr;
 	}
 
 	// Synchronously download from the source URLs.
@@ -144,10 +142,7 @@ ImgClass TCreateThumbnail<ImgClass>::getExternalImage(
 	int ret = romData->extURLs(imageType, &extURLs, req_size);
 	if (ret != 0 || extURLs.empty()) {
 		// No URLs.
-		if (sBIT) {
-			memset(sBIT, 0, sizeof(*sBIT));
-		}
-		return getNullImgClass();
+		return nullptr;
 	}
 
 	// NOTE: This will force a configuration timestamp check.
@@ -191,34 +186,61 @@ ImgClass TCreateThumbnail<ImgClass>::getExternalImage(
 			unique_ptr<rp_image> dl_img(RpImageLoader::load(file.get()));
 			if (dl_img && dl_img->isValid()) {
 				// Image loaded successfully.
-				ImgClass ret_img = rpImageToImgClass(dl_img.get());
-				if (isImgClassValid(ret_img)) {
-					// Image converted successfully.
-					if (pOutSize) {
-						// Get the image size.
-						pOutSize->width = dl_img->width();
-						pOutSize->height = dl_img->height();
-					}
-					// Get the sBIT metadata.
-					if (sBIT) {
-						if (dl_img->get_sBIT(sBIT) != 0) {
-							// No sBIT metadata.
-							// Clear the struct.
-							memset(sBIT, 0, sizeof(*sBIT));
-						}
-					}
-					// TODO: Transparency processing?
-					return ret_img;
-				}
+				return dl_img.release();
 			}
 		}
 	}
 
 	// No image.
-	if (sBIT) {
+	return nullptr;
+}
+
+/**
+ * Get an external image.
+ * @param romData	[in] RomData object.
+ * @param imageType	[in] Image type.
+ * @param req_size	[in] Requested image size.
+ * @param pOutSize	[out,opt] Pointer to ImgSize to store the image's size.
+ * @param sBIT		[out,opt] sBIT metadata.
+ * @return External image, or null ImgClass on error.
+ */
+template<typename ImgClass>
+ImgClass TCreateThumbnail<ImgClass>::getExternalImage(
+	const RomData *romData, RomData::ImageType imageType,
+	int req_size, ImgSize *pOutSize,
+	rp_image::sBIT_t *sBIT)
+{
+	unique_ptr<rp_image> dl_img(loadExternalImage(romData, imageType, req_size));
+	if (!dl_img) {
+		// No image.
+		if (sBIT) {
+			memset(sBIT, 0, sizeof(*sBIT));
+		}
+		return getNullImgClass();
+	}
+
+	ImgClass ret_img = rpImageToImgClassScaled(dl_img.get(),
+		romData->imgpf(imageType), req_size);
+	if (isImgClassValid(ret_img)) {
+		// Image converted successfully.
+		if (pOutSize) {
+			// Get the image size.
+			// TODO: Check for errors?
+			getImgClassSize(ret_img, pOutSize);
+		}
+		// Get the sBIT metadata.
+		if (sBIT) {
+			if (dl_img->get_sBIT(sBIT) != 0) {
+				// No sBIT metadata.
+				// Clear the struct.
+				memset(sBIT, 0, sizeof(*sBIT));
+			}
+		}
+		// TODO: Transparency processing?
+	} else if (sBIT) {
 		memset(sBIT, 0, sizeof(*sBIT));
 	}
-	return getNullImgClass();
+	return ret_img;
 }
 
 /**
@@ -250,19 +272,167 @@ inline void TCreateThumbnail<ImgClass>::rescale_aspect(ImgSize &rs_size, const I
 }
 
 /**
- * Create a thumbnail for the specified ROM file.
+ * Calculate the nearest-neighbor upscaling size for an image.
+ * @param img_sz	[in] Image size.
+ * @param req_size	[in] Requested image size.
+ * @param rescale_sz	[out] Rescaled image size.
+ * @return True if the image should be upscaled; false if not.
+ */
+template<typename ImgClass>
+bool TCreateThumbnail<ImgClass>::calcNearestUpscaleSize(const ImgSize &img_sz, int req_size, ImgSize &rescale_sz)
+{
+	// TODO: User configuration.
+	ResizeNearestUpPolicy resize_up = RESIZE_UP_HALF;
+	bool needs_resize_up = false;
+
+	// FIXME: Only if both dimensions are less, or if the second dimension
+	// isn't much bigger? (e.g. skip 64x1024)
+	switch (resize_up) {
+		case RESIZE_UP_NONE:
+			// No resize.
+			break;
+
+		case RESIZE_UP_HALF:
+		default:
+			// Only resize images that are less than or equal to
+			// half requested thumbnail size.
+			needs_resize_up = (img_sz.width  <= (req_size/2)) ||
+					  (img_sz.height <= (req_size/2));
+			break;
+
+		case RESIZE_UP_ALL:
+			// Resize all images that are smaller than the
+			// requested thumbnail size.
+			needs_resize_up = (img_sz.width  < req_size) ||
+					  (img_sz.height < req_size);
+			break;
+	}
+
+	if (!needs_resize_up) {
+		// No resize is needed.
+		return false;
+	}
+
+	// Need to upscale the image.
+	ImgSize int_sz = {req_size, req_size};
+	// Resize to the next highest integer multiple.
+	int_sz.width -= (int_sz.width % img_sz.width);
+	int_sz.height -= (int_sz.height % img_sz.height);
+
+	// Calculate the closest size while maintaining the aspect ratio.
+	// Based on Qt 4.8's QSize::scale().
+	rescale_sz = img_sz;
+	rescale_aspect(rescale_sz, int_sz);
+
+	// FIXME: If the original image is 64x1024, the rescale
+	// may result in 0x0, which is no good. If this happens,
+	// skip the rescaling entirely.
+	return (rescale_sz.width > 0 && rescale_sz.height > 0);
+}
+
+/**
+ * Calculate the thumbnail upscaling size for an image.
+ * This checks the image processing flags.
+ * @param img		[in] rp_image.
+ * @param imgpf		[in] Image processing flags.
+ * @param req_size	[in] Requested image size.
+ * @param rescale_sz	[out] Rescaled image size.
+ * @return True if the image should be upscaled; false if not.
+ */
+template<typename ImgClass>
+bool TCreateThumbnail<ImgClass>::calcThumbnailUpscaleSize(const rp_image *img,
+	uint32_t imgpf, int req_size, ImgSize &rescale_sz)
+{
+	if (!(imgpf & RomData::IMGPF_RESCALE_NEAREST) || req_size <= 0) {
+		// No rescaling.
+		return false;
+	}
+	const ImgSize img_sz = {img->width(), img->height()};
+	if (img_sz.width <= 0 || img_sz.height <= 0) {
+		// Invalid image size.
+		return false;
+	}
+	return calcNearestUpscaleSize(img_sz, req_size, rescale_sz);
+}
+
+/**
+ * Convert an rp_image to ImgClass, upscaling it if necessary.
+ *
+ * Format conversion and nearest-neighbor upscaling are done
+ * in a single pass using ImagePipeline, so the unscaled image
+ * doesn't have to be converted to ImgClass first.
+ *
+ * @param img		[in] rp_image.
+ * @param imgpf		[in] Image processing flags.
+ * @param req_size	[in] Requested image size.
+ * @return ImgClass, or null ImgClass on error.
+ */
+template<typename ImgClass>
+ImgClass TCreateThumbnail<ImgClass>::rpImageToImgClassScaled(const rp_image *img, uint32_t imgpf, int req_size)
+{
+	ImgSize rescale_sz;
+	if (!calcThumbnailUpscaleSize(img, imgpf, req_size, rescale_sz)) {
+		// No rescaling.
+		return rpImageToImgClass(img);
+	}
+
+	// Convert and upscale the image in a single pass.
+	ImagePipeline pipeline(img);
+	if (pipeline.isValid()) {
+		pipeline.setScale(rescale_sz.width, rescale_sz.height, ImagePipeline::SCALE_NEAREST);
+		ImgClass ret_img = pipelineToImgClass(&pipeline);
+		if (isImgClassValid(ret_img)) {
+			return ret_img;
+		}
+	}
+
+	// ImagePipeline failed. Rescale the ImgClass instead.
+	ImgClass ret_img = rpImageToImgClass(img);
+	if (isImgClassValid(ret_img)) {
+		ImgClass scaled_imgClass = rescaleImgClass(ret_img, rescale_sz);
+		freeImgClass(ret_img);
+		ret_img = scaled_imgClass;
+	}
+	return ret_img;
+}
+
+/**
+ * Convert the output of an ImagePipeline to ImgClass.
+ *
+ * The default implementation generates an rp_image and
+ * converts it using rpImageToImgClass(). Frontends should
+ * override this to write the output directly into the
+ * ImgClass's pixel buffer.
+ *
+ * @param pipeline ImagePipeline.
+ * @return ImgClass, or null ImgClass on error.
+ */
+template<typename ImgClass>
+ImgClass TCreateThumbnail<ImgClass>::pipelineToImgClass(ImagePipeline *pipeline) const
+{
+	unique_ptr<rp_image> img(pipeline->toImage());
+	if (!img) {
+		// Error processing the image.
+		return getNullImgClass();
+	}
+	return rpImageToImgClass(img.get());
+}
+
+/**
+ * Select the source image for a thumbnail.
+ * The image is not converted to ImgClass.
  * @param romData	[in] RomData object.
  * @param req_size	[in] Requested image size.
- * @param ret_img	[out] Return image.
- * @param sBIT		[out,opt] sBIT metadata.
+ * @param src		[out] Source image.
  * @return 0 on success; non-zero on error.
  */
 template<typename ImgClass>
-int TCreateThumbnail<ImgClass>::getThumbnail(const RomData *romData, int req_size, ImgClass &ret_img, rp_image::sBIT_t *sBIT)
+int TCreateThumbnail<ImgClass>::getThumbnailSource(const RomData *romData, int req_size, SourceImage &src)
 {
 	uint32_t imgbf = romData->supportedImageTypes();
-	uint32_t imgpf = 0;
-	ImgSize img_sz = {0, 0};
+	src.img = nullptr;
+	src.imgpf = 0;
+	src.ext_img.reset();
 
 	// Get the image priority.
 	const Config *const config = Config::instance();
@@ -289,14 +459,13 @@ int TCreateThumbnail<ImgClass>::getThumbnail(const RomData *romData, int req_siz
 		// Check for an icon first.
 		// TODO: Define "small sizes" somewhere. (DPI independence?)
 		if (imgbf & RomData::IMGBF_INT_ICON) {
-			ret_img = getInternalImage(romData, RomData::IMG_INT_ICON, &img_sz, sBIT);
-			imgpf = romData->imgpf(RomData::IMG_INT_ICON);
+			const rp_image *const img = romData->image(RomData::IMG_INT_ICON, req_size);
 			imgbf &= ~RomData::IMGBF_INT_ICON;
-
-			if (isImgClassValid(ret_img)) {
+			if (img && img->isValid()) {
 				// Image retrieved.
-				// TODO: Better method than goto?
-				goto skip_image_check;
+				src.img = img;
+				src.imgpf = romData->imgpf(RomData::IMG_INT_ICON);
+				return RPCT_SUCCESS;
 			}
 		}
 	}
@@ -321,17 +490,25 @@ int TCreateThumbnail<ImgClass>::getThumbnail(const RomData *romData, int req_siz
 		// This image may be present.
 		if (imgType <= RomData::IMG_INT_MAX) {
 			// Internal image.
-			ret_img = getInternalImage(romData, imgType, &img_sz, sBIT);
-			imgpf = romData->imgpf(imgType);
+			// Textures may have smaller mipmaps that are still
+			// large enough for the requested thumbnail size.
+			const rp_image *const img = romData->image(imgType, req_size);
+			if (img && img->isValid()) {
+				// Image retrieved.
+				src.img = img;
+				src.imgpf = romData->imgpf(imgType);
+				return RPCT_SUCCESS;
+			}
 		} else {
 			// External image.
-			ret_img = getExternalImage(romData, imgType, req_size, &img_sz, sBIT);
-			imgpf = romData->imgpf(imgType);
-		}
-
-		if (isImgClassValid(ret_img)) {
-			// Image retrieved.
-			break;
+			rp_image *const img = loadExternalImage(romData, imgType, req_size);
+			if (img) {
+				// Image retrieved.
+				src.ext_img.reset(img);
+				src.img = img;
+				src.imgpf = romData->imgpf(imgType);
+				return RPCT_SUCCESS;
+			}
 		}
 
 		// Make sure we don't check this image type again
@@ -340,70 +517,142 @@ int TCreateThumbnail<ImgClass>::getThumbnail(const RomData *romData, int req_siz
 		imgbf &= ~bf;
 	}
 
-	if (!isImgClassValid(ret_img)) {
+	// No image.
+	return RPCT_SOURCE_FILE_NO_IMAGE;
+}
+
+/**
+ * Write a thumbnail to a PNG file.
+ *
+ * If the image needs to be upscaled, it's processed one row
+ * at a time using ImagePipeline, so the upscaled image is
+ * never stored in memory. Otherwise, the source image is
+ * written as-is.
+ *
+ * @param src		[in] Source image from getThumbnailSource().
+ * @param req_size	[in] Requested image size.
+ * @param filename	[in] Output filename.
+ * @param kv		[in] tEXt chunks.
+ * @return 0 on success; non-zero on error.
+ */
+template<typename ImgClass>
+int TCreateThumbnail<ImgClass>::writeThumbnailPng(const SourceImage &src, int req_size,
+	const char *filename, const RpPngWriter::kv_vector &kv)
+{
+	assert(src.img != nullptr);
+	if (!src.img || !src.img->isValid()) {
+		return RPCT_SOURCE_FILE_NO_IMAGE;
+	}
+
+	ImgSize rescale_sz;
+	if (!calcThumbnailUpscaleSize(src.img, src.imgpf, req_size, rescale_sz)) {
+		// No upscaling. Write the source image directly.
+		// NOTE: tEXt chunks are written before IHDR in order
+		// to put them before the IDAT chunk.
+		unique_ptr<RpPngWriter> pngWriter(new RpPngWriter(filename, src.img));
+		if (!pngWriter->isOpen()) {
+			// Could not open the PNG writer.
+			return RPCT_OUTPUT_FILE_FAILED;
+		}
+		pngWriter->write_tEXt(kv);
+		if (pngWriter->write_IHDR() != 0 ||
+		    pngWriter->write_IDAT() != 0)
+		{
+			// Error writing the PNG image.
+			// TODO: Unlink the PNG image.
+			return RPCT_OUTPUT_FILE_FAILED;
+		}
+		return RPCT_SUCCESS;
+	}
+
+	// Upscale the image while writing it.
+	ImagePipeline pipeline(src.img);
+	if (!pipeline.isValid()) {
+		// Unsupported image format.
+		return RPCT_OUTPUT_FILE_FAILED;
+	}
+	pipeline.setScale(rescale_sz.width, rescale_sz.height, ImagePipeline::SCALE_NEAREST);
+
+	// If sBIT wasn't found, all fields will be 0.
+	// RpPngWriter will ignore sBIT in this case.
+	rp_image::sBIT_t sBIT;
+	if (src.img->get_sBIT(&sBIT) != 0) {
+		memset(&sBIT, 0, sizeof(sBIT));
+	}
+
+	unique_ptr<RpPngWriter> pngWriter(new RpPngWriter(filename,
+		pipeline.width(), pipeline.height(), rp_image::FORMAT_ARGB32));
+	if (!pngWriter->isOpen()) {
+		// Could not open the PNG writer.
+		return RPCT_OUTPUT_FILE_FAILED;
+	}
+	pngWriter->write_tEXt(kv);
+	if (pngWriter->write_IHDR(&sBIT) != 0 ||
+	    pngWriter->write_IDAT(&pipeline) != 0)
+	{
+		// Error writing the PNG image.
+		// TODO: Unlink the PNG image.
+		return RPCT_OUTPUT_FILE_FAILED;
+	}
+	return RPCT_SUCCESS;
+}
+
+/**
+ * Create a thumbnail for the specified ROM file.
+ * @param romData	[in] RomData object.
+ * @param req_size	[in] Requested image size.
+ * @param ret_img	[out] Return image.
+ * @param sBIT		[out,opt] sBIT metadata.
+ * @return 0 on success; non-zero on error.
+ */
+template<typename ImgClass>
+int TCreateThumbnail<ImgClass>::getThumbnail(const RomData *romData, int req_size, ImgClass &ret_img, rp_image::sBIT_t *sBIT)
+{
+	// Select the source image.
+	SourceImage src;
+	int ret = getThumbnailSource(romData, req_size, src);
+	if (ret != RPCT_SUCCESS) {
 		// No image.
+		if (sBIT) {
+			memset(sBIT, 0, sizeof(*sBIT));
+		}
+		return ret;
+	}
+
+	// Convert the image to ImgClass.
+	// Nearest-neighbor upscaling is handled by
+	// rpImageToImgClassScaled() before ImgClass conversion.
+	ret_img = rpImageToImgClassScaled(src.img, src.imgpf, req_size);
+	if (!isImgClassValid(ret_img)) {
+		// Unable to convert the image.
+		if (sBIT) {
+			memset(sBIT, 0, sizeof(*sBIT));
+		}
 		return RPCT_SOURCE_FILE_NO_IMAGE;
 	}
 
-skip_image_check:
+	ImgSize img_sz = {0, 0};
+	getImgClassSize(ret_img, &img_sz);
 	if (img_sz.width <= 0 || img_sz.height <= 0) {
 		// Image size is invalid.
 		freeImgClass(ret_img);
+		if (sBIT) {
+			memset(sBIT, 0, sizeof(*sBIT));
+		}
 		return RPCT_SOURCE_FILE_ERROR;
 	}
 
-	// TODO: If image is larger than req_size, resize down.
-	if (imgpf & RomData::IMGPF_RESCALE_NEAREST) {
-		// TODO: User configuration.
-		ResizeNearestUpPolicy resize_up = RESIZE_UP_HALF;
-		bool needs_resize_up = false;
-
-		// FIXME: Only if both dimensions are less, or if the second dimension
-		// isn't much bigger? (e.g. skip 64x1024)
-		switch (resize_up) {
-			case RESIZE_UP_NONE:
-				// No resize.
-				break;
-
-			case RESIZE_UP_HALF:
-			default:
-				// Only resize images that are less than or equal to
-				// half requested thumbnail size.
-				needs_resize_up = (img_sz.width  <= (req_size/2)) ||
-						  (img_sz.height <= (req_size/2));
-				break;
-
-			case RESIZE_UP_ALL:
-				// Resize all images that are smaller than the
-				// requested thumbnail size.
-				needs_resize_up = (img_sz.width  < req_size) ||
-						  (img_sz.height < req_size);
-				break;
-		}
-
-		if (needs_resize_up) {
-			// Need to upscale the image.
-			ImgSize int_sz = {req_size, req_size};
-			// Resize to the next highest integer multiple.
-			int_sz.width -= (int_sz.width % img_sz.width);
-			int_sz.height -= (int_sz.height % img_sz.height);
-
-			// Calculate the closest size while maintaining the aspect ratio.
-			// Based on Qt 4.8's QSize::scale().
-			ImgSize rescale_sz = img_sz;
-			rescale_aspect(rescale_sz, int_sz);
-
-			// FIXME: If the original image is 64x1024, the rescale
-			// may result in 0x0, which is no good. If this happens,
-			// skip the rescaling entirely.
-			if (rescale_sz.width > 0 && rescale_sz.height > 0) {
-				ImgClass scaled_img = rescaleImgClass(ret_img, rescale_sz);
-				freeImgClass(ret_img);
-				ret_img = scaled_img;
-			}
+	if (sBIT) {
+		// Get the sBIT metadata.
+		if (src.img->get_sBIT(sBIT) != 0) {
+			// No sBIT metadata.
+			// Clear the struct.
+			memset(sBIT, 0, sizeof(*sBIT));
 		}
 	}
 
+	// TODO: If image is larger than req_size, resize down.
+
 	// Image retrieved successfully.
 	return RPCT_SUCCESS;
 }
@@ -449,8 +698,9 @@ int TCreateThumbnail<ImgClass>::getThumbnail(const char *filename, int req_size,
 {
 	// Attempt to open the ROM file.
 	// TODO: OS-specific wrappers, e.g. RpQFile or RpGVfsFile.
-	// For now, using RpFile, which is an stdio wrapper.
-	unique_ptr<IRpFile> file(new RpFile(filename, RpFile::FM_OPEN_READ));
+	// For now, using RomDataFactory::openFile(), which returns
+	// a memory-mapped file or RpFile with transparent decompression.
+	unique_ptr<IRpFile> file(RomDataFactory::openFile(filename));
 	if (!file || !file->isOpen()) {
 		// Could not open the file.
 		if (sBIT) {
@@ -81,13 +81,16 @@ typedef int (*PFN_RP_CREATE_THUMBNAIL)(const char *source_file, const char *outp
 #ifdef __cplusplus
 #include "librpbase/RomData.hpp"
 #include "librpbase/img/rp_image.hpp"
+#include "librpbase/img/RpPngWriter.hpp"
 
 // C++ includes.
+#include <memory>
 #include <string>
 
 namespace LibRpBase {
 	class IRpFile;
 	class RomData;
+	class ImagePipeline;
 };
 
 namespace LibRomData {
@@ -110,17 +113,34 @@ class TCreateThumbnail
 			int height;
 		};
 
+		/**
+		 * Thumbnail source image.
+		 * This is the selected image before ImgClass conversion.
+		 */
+		struct SourceImage {
+			const LibRpBase::rp_image *img;	// Source image.
+			uint32_t imgpf;			// Image processing flags.
+
+			// Owns img if it's an external image.
+			// Internal images are owned by the RomData object,
+			// which must remain valid while img is in use.
+			std::unique_ptr<LibRpBase::rp_image> ext_img;
+
+			SourceImage() : img(nullptr), imgpf(0) { }
+		};
+
 		/**
 		 * Get an internal image.
 		 * @param romData	[in] RomData object.
 		 * @param imageType	[in] Image type.
+		 * @param req_size	[in] Requested image size. (<= 0 for the full-size image)
 		 * @param pOutSize	[out,opt] Pointer to ImgSize to store the image's size.
 		 * @param sBIT		[out,opt] sBIT metadata.
 		 * @return Internal image, or null ImgClass on error.
 		 */
 		ImgClass getInternalImage(const LibRpBase::RomData *romData,
 			LibRpBase::RomData::ImageType imageType,
-			ImgSize *pOutSize = nullptr,
+			int req_size, ImgSize *pOutSize = nullptr,
 			LibRpBase::rp_image::sBIT_t *sBIT = nullptr);
 
 		/**
@@ -137,6 +157,33 @@ class TCreateThumbnail
 			int req_size, ImgSize *pOutSize = nullptr,
 			LibRpBase::rp_image::sBIT_t *sBIT = nullptr);
 
+		/**
+		 * Select the source image for a thumbnail.
+		 * The image is not converted to ImgClass.
+		 * @param romData	[in] RomData object.
+		 * @param req_size	[in] Requested image size.
+		 * @param src		[out] Source image.
+		 * @return 0 on success; non-zero on error.
+		 */
+		int getThumbnailSource(const LibRpBase::RomData *romData, int req_size, SourceImage &src);
+
+		/**
+		 * Write a thumbnail to a PNG file.
+		 *
+		 * If the image needs to be upscaled, it's processed one row
+		 * at a time using ImagePipeline, so the upscaled image is
+		 * never stored in memory. Otherwise, the source image is
+		 * written as-is.
+		 *
+		 * @param src		[in] Source image from getThumbnailSource().
+		 * @param req_size	[in] Requested image size.
+		 * @param filename	[in] Output filename.
+		 * @param kv		[in] tEXt chunks.
+		 * @return 0 on success; non-zero on error.
+		 */
+		int writeThumbnailPng(const SourceImage &src, int req_size, const char *filename,
+			const LibRpBase::RpPngWriter::kv_vector &kv);
+
 		/**
 		 * Create a thumbnail for the specified ROM file.
 		 * @param romData	[in] RomData object.
@@ -179,6 +226,67 @@ class TCreateThumbnail
 		 */
 		static inline void rescale_aspect(ImgSize &rs_size, const ImgSize &tgt_size);
 
+		/**
+		 * Calculate the nearest-neighbor upscaling size for an image.
+		 * @param img_sz	[in] Image size.
+		 * @param req_size	[in] Requested image size.
+		 * @param rescale_sz	[out] Rescaled image size.
+		 * @return True if the image should be upscaled; false if not.
+		 */
+		static bool calcNearestUpscaleSize(const ImgSize &img_sz, int req_size, ImgSize &rescale_sz);
+
+		/**
+		 * Calculate the thumbnail upscaling size for an image.
+		 * This checks the image processing flags.
+		 * @param img		[in] rp_image.
+		 * @param imgpf		[in] Image processing flags.
+		 * @param req_size	[in] Requested image size.
+		 * @param rescale_sz	[out] Rescaled image size.
+		 * @return True if the image should be upscaled; false if not.
+		 */
+		static bool calcThumbnailUpscaleSize(const LibRpBase::rp_image *img,
+			uint32_t imgpf, int req_size, ImgSize &rescale_sz);
+
+		/**
+		 * Load an external image.
+		 * @param romData	[in] RomData object.
+		 * @param imageType	[in] Image type.
+		 * @param req_size	[in] Requested image size.
+		 * @return External image, or nullptr on error. (Caller must delete it.)
+		 */
+		LibRpBase::rp_image *loadExternalImage(const LibRpBase::RomData *romData,
+			LibRpBase::RomData::ImageType imageType, int req_size);
+
+		/**
+		 * Convert an rp_image to ImgClass, upscaling it if necessary.
+		 *
+		 * Format conversion and nearest-neighbor upscaling are done
+		 * in a single pass using ImagePipeline, so the unscaled image
+		 * doesn't have to be converted to ImgClass first.
+		 *
+		 * @param img		[in] rp_image.
+		 * @param imgpf		[in] Image processing flags.
+		 * @param req_size	[in] Requested image size.
+		 * @return ImgClass, or null ImgClass on error.
+		 */
+		ImgClass rpImageToImgClassScaled(const LibRpBase::rp_image *img, uint32_t imgpf, int req_size);
+
+	protected:
+		/** Virtual functions. **/
+
+		/**
+		 * Convert the output of an ImagePipeline to ImgClass.
+		 *
+		 * The default implementation generates an rp_image and
+		 * converts it using rpImageToImgClass(). Frontends should
+		 * override this to write the output directly into the
+		 * ImgClass's pixel buffer.
+		 *
+		 * @param pipeline ImagePipeline.
+		 * @return ImgClass, or null ImgClass on error.
+		 */
+		virtual ImgClass pipelineToImgClass(LibRpBase::ImagePipeline *pipeline) const;
+
 	protected:
 		/** Pure virtual functions. **/
 
@@ -0,0 +1,276 @@
+/***************************************************************************
+ * ROM Properties Page shell extension. (libromdata/tests)                 *
+ * DetectCacheTest.cpp: DetectCache test.                                  *
+ *                                                                         *
+ * Copyright (c) 2016-2018 by David Korth.                                 *
+ *                                                                         *
+ * This program is free software; you can redistribute it and/or modify it *
+ * under the terms of the GNU General Public License as published by the   *
+ * Free Software Foundation; either version 2 of the License, or (at your  *
+ * option) any later version.                                              *
+ *                                                                         *
+ * This program is distributed in the hope that it will be useful, but     *
+ * WITHOUT ANY WARRANTY; without even the implied warranty of              *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the           *
+ * GNU General Public License for more details.                            *
+ *                                                                         *
+ * You should have received a copy of the GNU General Public License       *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.   *
+ ***************************************************************************/
+
+// Google Test
+#include "gtest/gtest.h"
+
+// DetectCache
+#include "libromdata/DetectCache.hpp"
+#include "librpbase/file/IDecompReader.hpp"
+#include "librpbase/file/RpFile.hpp"
+using LibRpBase::IDecompReader;
+using LibRpBase::RpFile;
+
+// zlib
+#include <zlib.h>
+
+// C includes.
+#include <unistd.h>
+
+// C includes. (C++ namespace)
+#include <cstdio>
+
+// C++ includes.
+#include <string>
+using std::string;
+
+namespace LibRomData { namespace Tests {
+
+class DetectCacheTest : public ::testing::Test
+{
+	protected:
+		DetectCacheTest()
+			: m_filename("DetectCacheTest.cache")
+		{ }
+
+		void SetUp(void) final
+		{
+			unlink(m_filename.c_str());
+		}
+
+		void TearDown(void) final
+		{
+			unlink(m_filename.c_str());
+		}
+
+	public:
+		// Cache filename.
+		const string m_filename;
+
+		/**
+		 * Create a cache key.
+		 * @param ino Inode number.
+		 * @param attrs RomDataAttr bitfield.
+		 * @return Cache key.
+		 */
+		static DetectCache::Key makeKey(uint64_t ino, uint32_t attrs = 0)
+		{
+			DetectCache::Key key;
+			key.dev = 0x801;
+			key.ino = ino;
+			key.mtime = 1500000000;
+			key.size = 1048576;
+			key.mtime_nsec = 123456789;
+			key.ext_hash = 0x5A5A5A5A;
+			key.attrs = attrs;
+			key.decomp = 0;
+			return key;
+		}
+};
+
+/**
+ * Stored results can be looked up.
+ */
+TEST_F(DetectCacheTest, storeAndLookup_test)
+{
+	DetectCache cache(m_filename, 0x12345678);
+	ASSERT_TRUE(cache.isOpen());
+
+	const DetectCache::Key key = makeKey(100);
+	EXPECT_EQ(DetectCache::RESULT_NONE, cache.lookup(key));
+	cache.store(key, 42);
+	EXPECT_EQ(42U, cache.lookup(key));
+
+	// Replacing an entry.
+	cache.store(key, DetectCache::RESULT_UNSUPPORTED);
+	EXPECT_EQ(DetectCache::RESULT_UNSUPPORTED, cache.lookup(key));
+
+	// Attributes are part of the key.
+	EXPECT_EQ(DetectCache::RESULT_NONE, cache.lookup(makeKey(100, 1)));
+}
+
+/**
+ * Entries are invalidated if the mtime, size, or extension changes.
+ */
+TEST_F(DetectCacheTest, invalidate_test)
+{
+	DetectCache cache(m_filename, 0x12345678);
+	ASSERT_TRUE(cache.isOpen());
+
+	DetectCache::Key key = makeKey(100);
+	cache.store(key, 42);
+
+	key.mtime++;
+	EXPECT_EQ(DetectCache::RESULT_NONE, cache.lookup(key));
+	key.mtime--;
+	key.mtime_nsec++;
+	EXPECT_EQ(DetectCache::RESULT_NONE, cache.lookup(key));
+	key.mtime_nsec--;
+	key.size++;
+	EXPECT_EQ(DetectCache::RESULT_NONE, cache.lookup(key));
+	key.size--;
+	key.ext_hash++;
+	EXPECT_EQ(DetectCache::RESULT_NONE, cache.lookup(key));
+	key.ext_hash--;
+	EXPECT_EQ(42U, cache.lookup(key));
+}
+
+/**
+ * Renaming a file changes its cache key.
+ */
+TEST_F(DetectCacheTest, rename_test)
+{
+	const string filename1 = "DetectCacheTest.xyz";
+	const string filename2 = "DetectCacheTest.gba";
+	FILE *f = fopen(filename1.c_str(), "wb");
+	ASSERT_TRUE(f != nullptr);
+	fputs("DetectCacheTest", f);
+	fclose(f);
+
+	DetectCache::Key key1, key2;
+	{
+		RpFile file1(filename1, RpFile::FM_OPEN_READ);
+		ASSERT_TRUE(file1.isOpen());
+		ASSERT_TRUE(DetectCache::getKey(&file1, ".xyz", 0, &key1));
+	}
+	ASSERT_EQ(0, rename(filename1.c_str(), filename2.c_str()));
+	{
+		RpFile file2(filename2, RpFile::FM_OPEN_READ);
+		ASSERT_TRUE(file2.isOpen());
+		ASSERT_TRUE(DetectCache::getKey(&file2, ".gba", 0, &key2));
+	}
+	unlink(filename2.c_str());
+
+	// Same inode and mtime, but a different extension.
+	EXPECT_EQ(key1.ino, key2.ino);
+	EXPECT_EQ(key1.mtime, key2.mtime);
+	EXPECT_NE(key1.ext_hash, key2.ext_hash);
+
+	DetectCache cache(m_filename, 0x12345678);
+	ASSERT_TRUE(cache.isOpen());
+	cache.store(key1, DetectCache::RESULT_UNSUPPORTED);
+	EXPECT_EQ(DetectCache::RESULT_NONE, cache.lookup(key2));
+}
+
+/**
+ * A compressed file opened with and without transparent
+ * decompression has separate cache entries.
+ */
+TEST_F(DetectCacheTest, decompress_test)
+{
+	const string filename = "DetectCacheTest.nds.gz";
+	gzFile gzf = gzopen(filename.c_str(), "wb");
+	ASSERT_TRUE(gzf != nullptr);
+	for (unsigned int i = 0; i < 256; i++) {
+		gzputs(gzf, "DetectCacheTest");
+	}
+	gzclose(gzf);
+
+	DetectCache::Key rawKey, gzKey;
+	{
+		RpFile rawFile(filename, RpFile::FM_OPEN_READ);
+		RpFile gzFile(filename, RpFile::FM_OPEN_READ_GZ);
+		ASSERT_TRUE(rawFile.isOpen());
+		ASSERT_TRUE(gzFile.isOpen());
+		EXPECT_EQ(-1, rawFile.decompFormat());
+		EXPECT_EQ(static_cast<int>(IDecompReader::FMT_GZIP), gzFile.decompFormat());
+
+		ASSERT_TRUE(DetectCache::getKey(&rawFile, ".nds", 0, &rawKey));
+		ASSERT_TRUE(DetectCache::getKey(&gzFile, ".nds", 0, &gzKey));
+	}
+	unlink(filename.c_str());
+
+	// Same file, but a different view of its contents.
+	EXPECT_EQ(rawKey.ino, gzKey.ino);
+	EXPECT_EQ(rawKey.ext_hash, gzKey.ext_hash);
+	EXPECT_NE(rawKey.decomp, gzKey.decomp);
+
+	// Rejecting the raw file must not affect the decompressed file.
+	DetectCache cache(m_filename, 0x12345678);
+	ASSERT_TRUE(cache.isOpen());
+	cache.store(rawKey, DetectCache::RESULT_UNSUPPORTED);
+	EXPECT_EQ(DetectCache::RESULT_NONE, cache.lookup(gzKey));
+	cache.store(gzKey, 42);
+	EXPECT_EQ(42U, cache.lookup(gzKey));
+	EXPECT_EQ(DetectCache::RESULT_UNSUPPORTED, cache.lookup(rawKey));
+}
+
+/**
+ * Entries persist if the cache is reopened with the same signature,
+ * and are discarded if the signature changes.
+ */
+TEST_F(DetectCacheTest, reopen_test)
+{
+	const DetectCache::Key key = makeKey(100);
+	{
+		DetectCache cache(m_filename, 0x12345678);
+		ASSERT_TRUE(cache.isOpen());
+		cache.store(key, 42);
+	}
+	{
+		DetectCache cache(m_filename, 0x12345678);
+		ASSERT_TRUE(cache.isOpen());
+		EXPECT_EQ(42U, cache.lookup(key));
+	}
+	{
+		DetectCache cache(m_filename, 0x87654321);
+		ASSERT_TRUE(cache.isOpen());
+		EXPECT_EQ(DetectCache::RESULT_NONE, cache.lookup(key));
+	}
+}
+
+/**
+ * Colliding entries are stored in separate slots.
+ */
+TEST_F(DetectCacheTest, manyEntries_test)
+{
+	DetectCache cache(m_filename, 0x12345678);
+	ASSERT_TRUE(cache.isOpen());
+
+	for (unsigned int i = 0; i < 1000; i++) {
+		cache.store(makeKey(i), i + 1);
+	}
+
+	// A few entries may have been evicted, but most should be present.
+	unsigned int found = 0;
+	for (unsigned int i = 0; i < 1000; i++) {
+		const uint32_t result = cache.lookup(makeKey(i));
+		if (result != DetectCache::RESULT_NONE) {
+			EXPECT_EQ(i + 1, result);
+			found++;
+		}
+	}
+	EXPECT_GE(found, 990U);
+}
+
+} }
+
+/**
+ * Test suite main function.
+ */
+extern "C" int gtest_main(int argc, char *argv[])
+{
+	fprintf(stderr, "LibRomData test suite: DetectCache tests.\n\n");
+	fflush(nullptr);
+
+	// coverity[fun_call_w_exception]: uncaught exceptions cause nonzero exit anyway, so don't warn.
+	::testing::InitGoogleTest(&argc, argv);
+	return RUN_ALL_TESTS();
+}
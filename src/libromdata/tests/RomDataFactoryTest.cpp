@@ -0,0 +1,209 @@
+/***************************************************************************
+ * ROM Properties Page shell extension. (libromdata/tests)                 *
+ * RomDataFactoryTest.cpp: RomDataFactory detection test.                  *
+ *                                                                         *
+ * Copyright (c) 2016-2018 by David Korth.                                 *
+ *                                                                         *
+ * This program is free software; you can redistribute it and/or modify it *
+ * under the terms of the GNU General Public License as published by the   *
+ * Free Software Foundation; either version 2 of the License, or (at your  *
+ * option) any later version.                                              *
+ *                                                                         *
+ * This program is distributed in the hope that it will be useful, but     *
+ * WITHOUT ANY WARRANTY; without even the implied warranty of              *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the           *
+ * GNU General Public License for more details.                            *
+ *                                                                         *
+ * You should have received a copy of the GNU General Public License       *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.   *
+ ***************************************************************************/
+
+// Google Test
+#include "gtest/gtest.h"
+
+// RomDataFactory
+#include "libromdata/RomDataFactory.hpp"
+#include "librpbase/RomData.hpp"
+#include "librpbase/file/RpMemFile.hpp"
+using LibRpBase::RomData;
+using LibRpBase::RpMemFile;
+
+// C includes. (C++ namespace)
+#include <cstdio>
+#include <cstring>
+
+namespace LibRomData { namespace Tests {
+
+class RomDataFactoryTest : public ::testing::Test
+{
+	protected:
+		RomDataFactoryTest()
+		{
+			memset(m_buf, 0, sizeof(m_buf));
+		}
+
+	public:
+		// Number of iterations for benchmarks.
+		static const unsigned int BENCHMARK_ITERATIONS = 100000;
+
+	public:
+		// Test file. (same size as the header read by create())
+		uint8_t m_buf[4096+256];
+
+	public:
+		/**
+		 * Initialize m_buf as a PSID/RSID header.
+		 * @param magic Magic number.
+		 */
+		void initSID(const char *magic)
+		{
+			memcpy(&m_buf[0], magic, 4);
+			m_buf[0x05] = 2;	// version
+			m_buf[0x07] = 0x7C;	// dataOffset
+			m_buf[0x0F] = 1;	// songs
+			m_buf[0x11] = 1;	// startSong
+		}
+
+		/**
+		 * Initialize m_buf as a Neo Geo Pocket Color ROM.
+		 * The magic number " SNK" is at 0x0C.
+		 */
+		void initNGPC(void)
+		{
+			memcpy(&m_buf[0], "COPYRIGHT BY SNK CORPORATION", 28);
+			m_buf[0x23] = 0x10;	// machine_type: Color
+			memcpy(&m_buf[0x24], "TEST ROM    ", 12);
+		}
+
+		/**
+		 * Run RomDataFactory::create() on m_buf.
+		 * @param attrs RomDataAttr bitfield.
+		 * @return Class name of the RomData subclass, or nullptr if not supported.
+		 */
+		const char *detect(unsigned int attrs = 0)
+		{
+			RpMemFile file(m_buf, sizeof(m_buf));
+			RomData *const romData = RomDataFactory::create(&file, attrs);
+			if (!romData) {
+				return nullptr;
+			}
+			const char *const className = romData->className();
+			romData->unref();
+			return className;
+		}
+};
+
+/**
+ * A zero-filled file isn't supported.
+ */
+TEST_F(RomDataFactoryTest, miss_test)
+{
+	EXPECT_EQ(nullptr, detect());
+}
+
+/**
+ * Classes with multiple magic numbers are detected
+ * using each magic number.
+ */
+TEST_F(RomDataFactoryTest, multipleMagic_test)
+{
+	initSID("PSID");
+	EXPECT_STREQ("SID", detect());
+	initSID("RSID");
+	EXPECT_STREQ("SID", detect());
+	initSID("XSID");
+	EXPECT_EQ(nullptr, detect());
+}
+
+/**
+ * Magic numbers at non-zero addresses are detected.
+ */
+TEST_F(RomDataFactoryTest, magicAddress_test)
+{
+	initNGPC();
+	EXPECT_STREQ("NGPC", detect());
+}
+
+/**
+ * Required attributes are checked for magic number matches.
+ */
+TEST_F(RomDataFactoryTest, magicAttrs_test)
+{
+	initSID("PSID");
+	EXPECT_EQ(nullptr, detect(RomDataFactory::RDA_HAS_THUMBNAIL));
+}
+
+/**
+ * File extension lookups are case-insensitive
+ * and check the required attributes.
+ */
+TEST_F(RomDataFactoryTest, isFileExtensionSupported_test)
+{
+	EXPECT_TRUE(RomDataFactory::isFileExtensionSupported(".sid"));
+	EXPECT_TRUE(RomDataFactory::isFileExtensionSupported(".SID"));
+	EXPECT_TRUE(RomDataFactory::isFileExtensionSupported(".NgPc"));
+	EXPECT_FALSE(RomDataFactory::isFileExtensionSupported(".sid", RomDataFactory::RDA_HAS_THUMBNAIL));
+	EXPECT_FALSE(RomDataFactory::isFileExtensionSupported(".txt"));
+	EXPECT_FALSE(RomDataFactory::isFileExtensionSupported(""));
+	EXPECT_FALSE(RomDataFactory::isFileExtensionSupported(nullptr));
+}
+
+/**
+ * MIME type lookups are case-insensitive.
+ */
+TEST_F(RomDataFactoryTest, isMimeTypeSupported_test)
+{
+	EXPECT_TRUE(RomDataFactory::isMimeTypeSupported("audio/prs.sid"));
+	EXPECT_TRUE(RomDataFactory::isMimeTypeSupported("Application/X-Neo-Geo-Pocket-ROM"));
+	EXPECT_FALSE(RomDataFactory::isMimeTypeSupported("text/plain"));
+	EXPECT_FALSE(RomDataFactory::isMimeTypeSupported(""));
+	EXPECT_FALSE(RomDataFactory::isMimeTypeSupported(nullptr));
+}
+
+/**
+ * Benchmark detection of a supported file.
+ */
+TEST_F(RomDataFactoryTest, hit_benchmark)
+{
+	initNGPC();
+	for (unsigned int i = BENCHMARK_ITERATIONS; i > 0; i--) {
+		RpMemFile file(m_buf, sizeof(m_buf));
+		RomData *const romData = RomDataFactory::create(&file);
+		ASSERT_TRUE(romData != nullptr);
+		romData->unref();
+	}
+}
+
+/**
+ * Benchmark detection of an unsupported file.
+ */
+TEST_F(RomDataFactoryTest, miss_benchmark)
+{
+	// Fill the header with non-zero data so
+	// header checks don't stop early.
+	for (unsigned int i = 0; i < sizeof(m_buf); i++) {
+		m_buf[i] = static_cast<uint8_t>(i * 37 + 11);
+	}
+
+	for (unsigned int i = BENCHMARK_ITERATIONS; i > 0; i--) {
+		RpMemFile file(m_buf, sizeof(m_buf));
+		RomData *const romData = RomDataFactory::create(&file);
+		ASSERT_TRUE(romData == nullptr);
+	}
+}
+
+} }
+
+/**
+ * Test suite main function.
+ */
+extern "C" int gtest_main(int argc, char *argv[])
+{
+	fprintf(stderr, "LibRomData test suite: RomDataFactory tests.\n\n");
+	fprintf(stderr, "Benchmark iterations: %u\n", LibRomData::Tests::RomDataFactoryTest::BENCHMARK_ITERATIONS);
+	fflush(nullptr);
+
+	// coverity[fun_call_w_exception]: uncaught exceptions cause nonzero exit anyway, so don't warn.
+	::testing::InitGoogleTest(&argc, argv);
+	return RUN_ALL_TESTS();
+}
@@ -0,0 +1,281 @@
+/***************************************************************************
+ * ROM Properties Page shell extension. (libromdata/tests)                 *
+ * WiiPartitionTest.cpp: WiiPartition sector cache tests.                  *
+ *                                                                         *
+ * Copyright (c) 2016-2018 by David Korth.                                 *
+ *                                                                         *
+ * This program is free software; you can redistribute it and/or modify it *
+ * under the terms of the GNU General Public License as published by the   *
+ * Free Software Foundation; either version 2 of the License, or (at your  *
+ * option) any later version.                                              *
+ *                                                                         *
+ * This program is distributed in the hope that it will be useful, but     *
+ * WITHOUT ANY WARRANTY; without even the implied warranty of              *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the           *
+ * GNU General Public License for more details.                            *
+ *                                                                         *
+ * You should have received a copy of the GNU General Public License       *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.   *
+ ***************************************************************************/
+
+// Google Test
+#include "gtest/gtest.h"
+
+// librpbase
+#include "librpbase/byteswap.h"
+#include "librpbase/disc/DiscReader.hpp"
+#include "librpbase/file/RpMemFile.hpp"
+using namespace LibRpBase;
+
+// libromdata
+#include "libromdata/Console/wii_structs.h"
+#include "libromdata/disc/WiiPartition.hpp"
+#include "libromdata/disc/WiiPartitionCache.hpp"
+
+// C includes. (C++ namespace)
+#include <cstdio>
+#include <cstring>
+
+// C++ includes.
+#include <vector>
+using std::vector;
+
+namespace LibRomData { namespace Tests {
+
+class WiiPartitionTest : public ::testing::TestWithParam<WiiPartition::CryptoMethod>
+{
+	protected:
+		static const unsigned int DATA_OFFSET = 0x20000;
+		static const unsigned int SECTOR_COUNT = 40;
+
+		void SetUp(void) final;
+		void TearDown(void) final;
+
+	public:
+		vector<uint8_t> discData;	// Disc image.
+		vector<uint8_t> logicalData;	// Expected partition data.
+
+		RpMemFile *memFile;
+		DiscReader *discReader;
+		WiiPartition *partition;
+};
+
+/**
+ * SetUp() function.
+ * Run before each test.
+ */
+void WiiPartitionTest::SetUp(void)
+{
+	const WiiPartition::CryptoMethod cryptoMethod = GetParam();
+	const bool is32K = ((cryptoMethod & WiiPartition::CM_MASK_SECTOR) == WiiPartition::CM_32K);
+	const unsigned int dataOffset = (is32K ? 0 : 0x400);
+	const unsigned int dataSize = 0x8000 - dataOffset;
+
+	// Partition header, followed by unencrypted sectors.
+	// The hash area is filled with 0xFF so that incorrect
+	// reads of the hashes will be detected.
+	discData.assign(DATA_OFFSET + (SECTOR_COUNT * 0x8000), 0xFF);
+	logicalData.resize(SECTOR_COUNT * dataSize);
+
+	RVL_PartitionHeader *const partitionHeader =
+		reinterpret_cast<RVL_PartitionHeader*>(discData.data());
+	memset(partitionHeader, 0, sizeof(*partitionHeader));
+	partitionHeader->ticket.signature_type = cpu_to_be32(RVL_SIGNATURE_TYPE_RSA2048);
+	partitionHeader->data_offset = cpu_to_be32(DATA_OFFSET >> 2);
+	partitionHeader->data_size = cpu_to_be32((SECTOR_COUNT * 0x8000) >> 2);
+
+	for (unsigned int i = 0; i < SECTOR_COUNT; i++) {
+		uint8_t *const sector = &discData[DATA_OFFSET + (i * 0x8000) + dataOffset];
+		for (unsigned int j = 0; j < dataSize; j++) {
+			const uint8_t val = static_cast<uint8_t>((i * 13) + (j * 7) + (j >> 8));
+			sector[j] = val;
+			logicalData[(i * dataSize) + j] = val;
+		}
+	}
+
+	memFile = new RpMemFile(discData.data(), discData.size());
+	discReader = new DiscReader(memFile);
+	partition = new WiiPartition(discReader, 0, discData.size(), cryptoMethod);
+}
+
+/**
+ * TearDown() function.
+ * Run after each test.
+ */
+void WiiPartitionTest::TearDown(void)
+{
+	delete partition;
+	delete discReader;
+	delete memFile;
+}
+
+/**
+ * Read a range of data and compare it to the expected data.
+ * @param pos Starting position.
+ * @param size Amount of data to read.
+ */
+#define CHECK_RANGE(pos, size) do { \
+	vector<uint8_t> buf((size) + 1, 0xCC); \
+	ASSERT_EQ(0, partition->seek(pos)) << "pos == " << (pos); \
+	ASSERT_EQ(static_cast<size_t>(size), partition->read(buf.data(), (size))) \
+		<< "pos == " << (pos) << ", size == " << (size); \
+	ASSERT_EQ(0, memcmp(&logicalData[pos], buf.data(), (size))) \
+		<< "pos == " << (pos) << ", size == " << (size); \
+	ASSERT_EQ(0xCC, buf[size]) << "pos == " << (pos) << ", size == " << (size); \
+} while (0)
+
+/**
+ * Read the entire partition at once.
+ */
+TEST_P(WiiPartitionTest, read_full_test)
+{
+	ASSERT_TRUE(partition->isOpen());
+	CHECK_RANGE(0, logicalData.size());
+}
+
+/**
+ * Read ranges that alternate between sectors.
+ * This uses the sector cache.
+ */
+TEST_P(WiiPartitionTest, read_alternating_test)
+{
+	ASSERT_TRUE(partition->isOpen());
+	const size_t dataSize = logicalData.size() / SECTOR_COUNT;
+	for (unsigned int i = 0; i < 4; i++) {
+		CHECK_RANGE(dataSize * 3 + 100, 200);
+		CHECK_RANGE(dataSize * 17 + 5, 1000);
+		CHECK_RANGE(dataSize * 3 + 500, 200);
+		CHECK_RANGE(dataSize * 9 - 16, 32);
+	}
+}
+
+/**
+ * Read pseudo-random ranges, including ranges that span
+ * multiple full sectors and partial sectors.
+ */
+TEST_P(WiiPartitionTest, read_random_test)
+{
+	ASSERT_TRUE(partition->isOpen());
+	const size_t total = logicalData.size();
+	uint32_t seed = 1;
+	for (unsigned int i = 0; i < 500; i++) {
+		seed = (seed * 1103515245U) + 12345U;
+		const size_t pos = (seed >> 4) % total;
+		seed = (seed * 1103515245U) + 12345U;
+		size_t size = ((seed >> 4) % (0x8000 * 6)) + 1;
+		if (pos + size > total) {
+			size = total - pos;
+		}
+		CHECK_RANGE(pos, size);
+	}
+}
+
+/**
+ * Create a WiiPartition using cached partition information.
+ * The partition header must not be read from the disc.
+ */
+TEST_P(WiiPartitionTest, cached_partition_test)
+{
+	ASSERT_TRUE(partition->isOpen());
+	WiiPartitionCache::Partition cached;
+	cached.vg = 0;
+	cached.pt = 0;
+	cached.type = 0;
+	cached.start = 0;
+	cached.size = discData.size();
+	ASSERT_TRUE(partition->saveToCache(&cached));
+	EXPECT_FALSE(cached.has_title_key);
+
+	// Clear the on-disc partition header.
+	delete partition;
+	memset(discData.data(), 0, sizeof(RVL_PartitionHeader));
+	partition = new WiiPartition(discReader, cached, GetParam());
+	ASSERT_TRUE(partition->isOpen());
+	EXPECT_EQ(static_cast<int64_t>(discData.size()), partition->partition_size());
+	CHECK_RANGE(0, logicalData.size());
+}
+
+INSTANTIATE_TEST_CASE_P(WiiPartition, WiiPartitionTest,
+	testing::Values(WiiPartition::CM_NASOS, WiiPartition::CM_RVTH));
+
+/**
+ * WiiPartitionCache lookups, replacement, and eviction.
+ */
+TEST(WiiPartitionCacheTest, lookupTest)
+{
+	WiiPartitionCache::clear();
+
+	WiiPartitionCache::Key key;
+	key.dev = 0x801;
+	key.ino = 123456;
+	key.size = 4699979776LL;
+	key.mtime = 1500000000;
+	key.mtime_nsec = 250000000;
+	key.filename = "/nonexistent/disc.iso";
+
+	vector<WiiPartitionCache::Partition> partitions(2);
+	memset(partitions.data(), 0, partitions.size() * sizeof(partitions[0]));
+	partitions[0].start = 0x50000;
+	partitions[1].start = 0xF800000;
+	partitions[1].type = 1;
+
+	vector<WiiPartitionCache::Partition> result;
+	EXPECT_FALSE(WiiPartitionCache::lookup(key, result));
+	WiiPartitionCache::store(key, partitions);
+	ASSERT_TRUE(WiiPartitionCache::lookup(key, result));
+	ASSERT_EQ(2U, result.size());
+	EXPECT_EQ(0x50000, result[0].start);
+	EXPECT_EQ(0xF800000, result[1].start);
+	EXPECT_EQ(1U, result[1].type);
+
+	// Modified file. (different mtime)
+	WiiPartitionCache::Key key2 = key;
+	key2.mtime++;
+	EXPECT_FALSE(WiiPartitionCache::lookup(key2, result));
+
+	// Modified within the same second. (different mtime_nsec)
+	key2 = key;
+	key2.mtime_nsec++;
+	EXPECT_FALSE(WiiPartitionCache::lookup(key2, result));
+
+	// Replaced by rename(). (different inode)
+	key2 = key;
+	key2.ino++;
+	EXPECT_FALSE(WiiPartitionCache::lookup(key2, result));
+
+	// Replace the entry with one that has a title key.
+	partitions[0].has_title_key = true;
+	partitions[0].title_key[0] = 0x42;
+	WiiPartitionCache::store(key, partitions);
+	ASSERT_TRUE(WiiPartitionCache::lookup(key, result));
+	ASSERT_EQ(2U, result.size());
+	EXPECT_TRUE(result[0].has_title_key);
+	EXPECT_EQ(0x42, result[0].title_key[0]);
+
+	// Fill the cache with other disc images.
+	// The original entry should be evicted.
+	for (unsigned int i = 0; i < WiiPartitionCache::MAX_DISCS; i++) {
+		key2.mtime = 1600000000 + i;
+		WiiPartitionCache::store(key2, partitions);
+	}
+	EXPECT_FALSE(WiiPartitionCache::lookup(key, result));
+	EXPECT_TRUE(WiiPartitionCache::lookup(key2, result));
+
+	WiiPartitionCache::clear();
+	EXPECT_FALSE(WiiPartitionCache::lookup(key2, result));
+}
+
+} }
+
+/**
+ * Test suite main function.
+ */
+extern "C" int gtest_main(int argc, char *argv[])
+{
+	fprintf(stderr, "LibRomData test suite: WiiPartition tests.\n\n");
+	fflush(nullptr);
+
+	// coverity[fun_call_w_exception]: uncaught exceptions cause nonzero exit anyway, so don't warn.
+	::testing::InitGoogleTest(&argc, argv);
+	return RUN_ALL_TESTS();
+}
@@ -151,7 +151,6 @@ class ImageDecoderTest : public ::testing::TestWithParam<ImageDecoderTest_mode>
 
 		// Number of iterations for benchmarks.
 		static const unsigned int BENCHMARK_ITERATIONS = 1000;
-		static const unsigned int BENCHMARK_ITERATIONS_BC7 = 100;
 
 	public:
 		// Image buffers.
@@ -463,6 +462,17 @@ void ImageDecoderTest::decodeTest_internal(void)
 
 	// Compare the image data.
 	ASSERT_NO_FATAL_FAILURE(Compare_RpImage(img_png.get(), img_dds));
+
+	// Get a reduced-size image.
+	// This must not be larger than the full-size image,
+	// but it must be at least the requested size.
+	static const int REDUCED_SIZE = 64;
+	const rp_image *const img_reduced = m_romData->image(RomData::IMG_INT_IMAGE, REDUCED_SIZE);
+	ASSERT_TRUE(img_reduced != nullptr) << "Could not load the " << filetype << " image at a reduced size.";
+	EXPECT_LE(img_reduced->width(), img_dds->width());
+	EXPECT_LE(img_reduced->height(), img_dds->height());
+	EXPECT_GE(std::max(img_reduced->width(), img_reduced->height()),
+		  std::min(REDUCED_SIZE, std::max(img_dds->width(), img_dds->height())));
 }
 
 /**
@@ -489,15 +499,7 @@ void ImageDecoderTest::decodeBenchmark_internal(void)
 	// We have to reopen the RomData subclass every time.
 
 	// Benchmark iterations.
-	// BC7 has fewer iterations because it's more complicated.
-	unsigned int max_iterations;
-	if (mode.dds_gz_filename.find("BC7/") == 0) {
-		// This is BC7.
-		max_iterations = BENCHMARK_ITERATIONS_BC7;
-	} else {
-		// Not BC7.
-		max_iterations = BENCHMARK_ITERATIONS;
-	}
+	const unsigned int max_iterations = BENCHMARK_ITERATIONS;
 
 	// Determine the image type by checking the last 7 characters of the filename.
 	ASSERT_GT(mode.dds_gz_filename.size(), 7U);
@@ -1133,6 +1135,462 @@ INSTANTIATE_TEST_CASE_P(BC7, ImageDecoderTest,
 			"BC7/w5_wood503_prm.png"))
 	, ImageDecoderTest::test_case_suffix_generator);
 
+/** S3TC, BC7, and ETC SIMD tests. **/
+
+#if defined(RP_CPU_I386) || defined(RP_CPU_AMD64)
+/**
+ * S3TC, BC7, or ETC decoder function.
+ * Matches the ImageDecoder::fromDXT1() signature.
+ */
+typedef rp_image *(*pfnS3TC_t)(int width, int height,
+	const uint8_t *RESTRICT img_buf, int img_siz);
+
+struct ImageDecoderS3TCTest_mode
+{
+	const char *name;	// Format name.
+	unsigned int blockSize;	// Bytes per 4x4 block.
+	ImageDecoder::BlockFormat blockFormat;
+
+	// Decoder functions.
+	// NULL if the variant isn't available in this build.
+	pfnS3TC_t pfn_cpp;
+	pfnS3TC_t pfn_sse2;
+	pfnS3TC_t pfn_ssse3;
+	pfnS3TC_t pfn_sse41;
+	pfnS3TC_t pfn_avx2;
+
+	bool bc7;		// BC7: Each block needs a valid mode.
+};
+
+/**
+ * Formatting function for ImageDecoderS3TCTest.
+ */
+inline ::std::ostream& operator<<(::std::ostream& os, const ImageDecoderS3TCTest_mode& mode)
+{
+	return os << mode.name;
+};
+
+class ImageDecoderS3TCTest : public ::testing::TestWithParam<ImageDecoderS3TCTest_mode>
+{
+	protected:
+		ImageDecoderS3TCTest()
+			: ::testing::TestWithParam<ImageDecoderS3TCTest_mode>()
+			, m_prevEnableS3TC(ImageDecoder::EnableS3TC)
+		{ }
+
+		void SetUp(void) final
+		{
+			// The S3TC SIMD decoders only handle S3TC.
+			// (BC7 and ETC don't use this setting.)
+			ImageDecoder::EnableS3TC = true;
+		}
+
+		void TearDown(void) final
+		{
+			ImageDecoder::EnableS3TC = m_prevEnableS3TC;
+		}
+
+	public:
+		// Test image size.
+		// The width isn't a multiple of 16 pixels in order
+		// to test handling of partial block groups.
+		static const int TEST_WIDTH = 132;
+		static const int TEST_HEIGHT = 68;
+
+		// Benchmark image size.
+		static const int BENCHMARK_WIDTH = 512;
+		static const int BENCHMARK_HEIGHT = 512;
+
+		bool m_prevEnableS3TC;
+		ao::uvector<uint8_t> m_buf;
+
+		/**
+		 * Fill m_buf with pseudo-random compressed blocks.
+		 * A fixed seed is used so failures are reproducible.
+		 * @param width Image width.
+		 * @param height Image height.
+		 */
+		void initBlocks(int width, int height)
+		{
+			const ImageDecoderS3TCTest_mode &mode = GetParam();
+			m_buf.resize((width / 4) * (height / 4) * mode.blockSize);
+
+			uint32_t seed = 0x12345678;
+			for (auto iter = m_buf.begin(); iter != m_buf.end(); ++iter) {
+				// xorshift32
+				seed ^= (seed << 13);
+				seed ^= (seed >> 17);
+				seed ^= (seed << 5);
+				*iter = static_cast<uint8_t>(seed >> 24);
+			}
+
+			if (mode.bc7) {
+				// BC7 blocks with mode byte 0 are invalid.
+				// The mode is the lowest set bit, so cycle through
+				// all eight modes, keeping the random high bits.
+				unsigned int blk_mode = 0;
+				for (size_t i = 0; i < m_buf.size(); i += 16, blk_mode = (blk_mode + 1) & 7) {
+					const uint8_t mode_mask = static_cast<uint8_t>((2U << blk_mode) - 1);
+					m_buf[i] = (m_buf[i] & ~mode_mask) | (1U << blk_mode);
+				}
+			}
+		}
+
+		/**
+		 * Compare a SIMD decoder against the standard version.
+		 * @param pfn Decoder function.
+		 */
+		void compareTest_internal(pfnS3TC_t pfn)
+		{
+			const ImageDecoderS3TCTest_mode &mode = GetParam();
+			ASSERT_NO_FATAL_FAILURE(initBlocks(TEST_WIDTH, TEST_HEIGHT));
+
+			unique_ptr<rp_image> pImgExpected(mode.pfn_cpp(TEST_WIDTH, TEST_HEIGHT,
+				m_buf.data(), static_cast<int>(m_buf.size())));
+			ASSERT_TRUE(pImgExpected != nullptr);
+			unique_ptr<rp_image> pImgActual(pfn(TEST_WIDTH, TEST_HEIGHT,
+				m_buf.data(), static_cast<int>(m_buf.size())));
+			ASSERT_TRUE(pImgActual != nullptr);
+
+			ASSERT_EQ(pImgExpected->format(), pImgActual->format());
+			ASSERT_NO_FATAL_FAILURE(ImageDecoderTest::Compare_RpImage(
+				pImgExpected.get(), pImgActual.get()));
+
+			// sBIT must match as well.
+			rp_image::sBIT_t sBIT_expected, sBIT_actual;
+			ASSERT_EQ(0, pImgExpected->get_sBIT(&sBIT_expected));
+			ASSERT_EQ(0, pImgActual->get_sBIT(&sBIT_actual));
+			EXPECT_EQ(0, memcmp(&sBIT_expected, &sBIT_actual, sizeof(sBIT_expected)));
+
+			// The block data must be large enough.
+			pImgActual.reset(pfn(TEST_WIDTH, TEST_HEIGHT,
+				m_buf.data(), static_cast<int>(m_buf.size()) - 1));
+			EXPECT_TRUE(pImgActual == nullptr);
+		}
+
+		/**
+		 * Box-filter a region of an ARGB32 image.
+		 * Color channels are weighted by alpha.
+		 * @param img Image.
+		 * @param x0 Left edge of the box.
+		 * @param y0 Top edge of the box.
+		 * @param w Box width.
+		 * @param h Box height.
+		 * @return Filtered pixel.
+		 */
+		static uint32_t boxFilter(const rp_image *img, int x0, int y0, int w, int h)
+		{
+			uint64_t a_sum = 0, r_sum = 0, g_sum = 0, b_sum = 0;
+			for (int y = y0; y < y0 + h; y++) {
+				const uint32_t *src = static_cast<const uint32_t*>(img->scanLine(y));
+				for (int x = x0; x < x0 + w; x++) {
+					const uint32_t a = src[x] >> 24;
+					a_sum += a;
+					r_sum += ((src[x] >> 16) & 0xFF) * a;
+					g_sum += ((src[x] >>  8) & 0xFF) * a;
+					b_sum += ( src[x]        & 0xFF) * a;
+				}
+			}
+			if (a_sum == 0)
+				return 0;
+			const uint64_t area = static_cast<uint64_t>(w) * h;
+			return (static_cast<uint32_t>((a_sum + area/2) / area) << 24) |
+			       (static_cast<uint32_t>((r_sum + a_sum/2) / a_sum) << 16) |
+			       (static_cast<uint32_t>((g_sum + a_sum/2) / a_sum) <<  8) |
+			        static_cast<uint32_t>((b_sum + a_sum/2) / a_sum);
+		}
+
+		/**
+		 * Benchmark a decoder.
+		 * @param pfn Decoder function.
+		 */
+		void benchmark_internal(pfnS3TC_t pfn)
+		{
+			ASSERT_NO_FATAL_FAILURE(initBlocks(BENCHMARK_WIDTH, BENCHMARK_HEIGHT));
+			for (unsigned int i = ImageDecoderTest::BENCHMARK_ITERATIONS; i > 0; i--) {
+				unique_ptr<rp_image> pImg(pfn(BENCHMARK_WIDTH, BENCHMARK_HEIGHT,
+					m_buf.data(), static_cast<int>(m_buf.size())));
+				ASSERT_TRUE(pImg != nullptr);
+			}
+		}
+
+		/**
+		 * Test case suffix generator.
+		 * @param info Test parameter information.
+		 * @return Test case suffix.
+		 */
+		static string test_case_suffix_generator(const ::testing::TestParamInfo<ImageDecoderS3TCTest_mode> &info)
+		{
+			return info.param.name;
+		}
+};
+
+/**
+ * Test region-of-interest and reduced-resolution decoding
+ * against the full-size image.
+ */
+TEST_P(ImageDecoderS3TCTest, roi_test)
+{
+	const ImageDecoderS3TCTest_mode &mode = GetParam();
+	ASSERT_NO_FATAL_FAILURE(initBlocks(TEST_WIDTH, TEST_HEIGHT));
+	const int buf_siz = static_cast<int>(m_buf.size());
+
+	unique_ptr<rp_image> pImgFull(ImageDecoder::fromBlocks(mode.blockFormat,
+		TEST_WIDTH, TEST_HEIGHT, m_buf.data(), buf_siz));
+	ASSERT_TRUE(pImgFull != nullptr);
+
+	// Region is expanded to block boundaries: (8,4)-(48,28)
+	unique_ptr<rp_image> pImgRect(ImageDecoder::fromBlocksRect(mode.blockFormat,
+		TEST_WIDTH, TEST_HEIGHT, m_buf.data(), buf_siz, 10, 6, 37, 21));
+	ASSERT_TRUE(pImgRect != nullptr);
+	ASSERT_EQ(40, pImgRect->width());
+	ASSERT_EQ(24, pImgRect->height());
+	for (int y = 0; y < pImgRect->height(); y++) {
+		const uint32_t *const pFull = static_cast<const uint32_t*>(pImgFull->scanLine(y + 4)) + 8;
+		ASSERT_EQ(0, memcmp(pFull, pImgRect->scanLine(y), 40 * sizeof(uint32_t))) << "row " << y;
+	}
+
+	// Full-width regions are decoded in place.
+	pImgRect.reset(ImageDecoder::fromBlocksRect(mode.blockFormat,
+		TEST_WIDTH, TEST_HEIGHT, m_buf.data(), buf_siz, 0, 16, TEST_WIDTH, 8));
+	ASSERT_TRUE(pImgRect != nullptr);
+	ASSERT_EQ(static_cast<int>(TEST_WIDTH), pImgRect->width());
+	ASSERT_EQ(8, pImgRect->height());
+	ASSERT_EQ(0, memcmp(pImgFull->scanLine(16), pImgRect->bits(), TEST_WIDTH * 8 * sizeof(uint32_t)));
+
+	// Reduced-resolution images are box-filtered from the full-size image.
+	// Level 3 (8x8 boxes) doesn't divide the width evenly, so some
+	// boxes are 9 pixels wide. 50x20 doesn't divide either dimension.
+	static const struct {
+		int level;
+		int out_w, out_h;
+	} reduce_modes[] = {
+		{1, TEST_WIDTH >> 1, TEST_HEIGHT >> 1},
+		{2, TEST_WIDTH >> 2, TEST_HEIGHT >> 2},
+		{3, TEST_WIDTH >> 3, TEST_HEIGHT >> 3},
+		{-1, 50, 20},
+	};
+	for (size_t i = 0; i < ARRAY_SIZE(reduce_modes); i++) {
+		const int out_w = reduce_modes[i].out_w;
+		const int out_h = reduce_modes[i].out_h;
+		unique_ptr<rp_image> pImgReduced(reduce_modes[i].level > 0
+			? ImageDecoder::fromBlocksReduced(mode.blockFormat,
+				TEST_WIDTH, TEST_HEIGHT, m_buf.data(), buf_siz, reduce_modes[i].level)
+			: ImageDecoder::fromBlocksReduced(mode.blockFormat,
+				TEST_WIDTH, TEST_HEIGHT, m_buf.data(), buf_siz, out_w, out_h));
+		ASSERT_TRUE(pImgReduced != nullptr);
+		ASSERT_EQ(out_w, pImgReduced->width());
+		ASSERT_EQ(out_h, pImgReduced->height());
+		for (int y = 0; y < out_h; y++) {
+			const int y0 = y * TEST_HEIGHT / out_h;
+			const int y1 = (y + 1) * TEST_HEIGHT / out_h;
+			const uint32_t *const pReduced = static_cast<const uint32_t*>(pImgReduced->scanLine(y));
+			for (int x = 0; x < out_w; x++) {
+				const int x0 = x * TEST_WIDTH / out_w;
+				const int x1 = (x + 1) * TEST_WIDTH / out_w;
+				ASSERT_EQ(boxFilter(pImgFull.get(), x0, y0, x1 - x0, y1 - y0), pReduced[x])
+					<< out_w << "x" << out_h << ", pixel (" << x << "," << y << ")";
+			}
+		}
+	}
+}
+
+/**
+ * Reduction level and mipmap level selection.
+ */
+TEST(ImageDecoderReduceTest, selectLevels)
+{
+	// 1000x1000 at 96px: 1000 >> 3 = 125.
+	const int level = ImageDecoder::selectReduceLevel(1000, 1000, 96, 15);
+	EXPECT_EQ(3, level);
+
+	// 4x4 blocks: Mipmap 1 (500x500) is the smallest 4-aligned mipmap.
+	EXPECT_EQ(1, ImageDecoder::selectMipmapLevel(1000, 1000, level, 9, 4));
+	// Only the full-size image is in the file.
+	EXPECT_EQ(0, ImageDecoder::selectMipmapLevel(1000, 1000, level, 0, 4));
+	// Linear images can use any mipmap.
+	EXPECT_EQ(3, ImageDecoder::selectMipmapLevel(1000, 1000, level, 9));
+
+	// Neither dimension may be reduced to zero.
+	EXPECT_EQ(2, ImageDecoder::selectReduceLevel(1024, 4, 96, 15));
+	// Full-size image.
+	EXPECT_EQ(0, ImageDecoder::selectReduceLevel(1000, 1000, 0, 15));
+}
+
+/**
+ * Benchmark the standard S3TC decoder.
+ */
+TEST_P(ImageDecoderS3TCTest, cpp_benchmark)
+{
+	ASSERT_NO_FATAL_FAILURE(benchmark_internal(GetParam().pfn_cpp));
+}
+
+/**
+ * Compare the SSE2 S3TC decoder against the standard version.
+ */
+TEST_P(ImageDecoderS3TCTest, sse2_test)
+{
+	const ImageDecoderS3TCTest_mode &mode = GetParam();
+	if (!mode.pfn_sse2 || !RP_CPU_HasSSE2()) {
+		fprintf(stderr, "*** SSE2 is not supported on this CPU. Skipping test.\n");
+		return;
+	}
+	ASSERT_NO_FATAL_FAILURE(compareTest_internal(mode.pfn_sse2));
+}
+
+/**
+ * Benchmark the SSE2 S3TC decoder.
+ */
+TEST_P(ImageDecoderS3TCTest, sse2_benchmark)
+{
+	const ImageDecoderS3TCTest_mode &mode = GetParam();
+	if (!mode.pfn_sse2 || !RP_CPU_HasSSE2()) {
+		fprintf(stderr, "*** SSE2 is not supported on this CPU. Skipping test.\n");
+		return;
+	}
+	ASSERT_NO_FATAL_FAILURE(benchmark_internal(mode.pfn_sse2));
+}
+
+/**
+ * Compare the SSSE3 S3TC decoder against the standard version.
+ */
+TEST_P(ImageDecoderS3TCTest, ssse3_test)
+{
+	const ImageDecoderS3TCTest_mode &mode = GetParam();
+	if (!mode.pfn_ssse3 || !RP_CPU_HasSSSE3()) {
+		fprintf(stderr, "*** SSSE3 is not supported on this CPU. Skipping test.\n");
+		return;
+	}
+	ASSERT_NO_FATAL_FAILURE(compareTest_internal(mode.pfn_ssse3));
+}
+
+/**
+ * Benchmark the SSSE3 S3TC decoder.
+ */
+TEST_P(ImageDecoderS3TCTest, ssse3_benchmark)
+{
+	const ImageDecoderS3TCTest_mode &mode = GetParam();
+	if (!mode.pfn_ssse3 || !RP_CPU_HasSSSE3()) {
+		fprintf(stderr, "*** SSSE3 is not supported on this CPU. Skipping test.\n");
+		return;
+	}
+	ASSERT_NO_FATAL_FAILURE(benchmark_internal(mode.pfn_ssse3));
+}
+
+/**
+ * Compare the SSE4.1 decoder against the standard version.
+ */
+TEST_P(ImageDecoderS3TCTest, sse41_test)
+{
+	const ImageDecoderS3TCTest_mode &mode = GetParam();
+	if (!mode.pfn_sse41 || !RP_CPU_HasSSE41()) {
+		fprintf(stderr, "*** SSE4.1 is not supported on this CPU. Skipping test.\n");
+		return;
+	}
+	ASSERT_NO_FATAL_FAILURE(compareTest_internal(mode.pfn_sse41));
+}
+
+/**
+ * Benchmark the SSE4.1 decoder.
+ */
+TEST_P(ImageDecoderS3TCTest, sse41_benchmark)
+{
+	const ImageDecoderS3TCTest_mode &mode = GetParam();
+	if (!mode.pfn_sse41 || !RP_CPU_HasSSE41()) {
+		fprintf(stderr, "*** SSE4.1 is not supported on this CPU. Skipping test.\n");
+		return;
+	}
+	ASSERT_NO_FATAL_FAILURE(benchmark_internal(mode.pfn_sse41));
+}
+
+/**
+ * Compare the AVX2 S3TC decoder against the standard version.
+ */
+TEST_P(ImageDecoderS3TCTest, avx2_test)
+{
+	const ImageDecoderS3TCTest_mode &mode = GetParam();
+	if (!mode.pfn_avx2 || !RP_CPU_HasAVX2()) {
+		fprintf(stderr, "*** AVX2 is not supported on this CPU. Skipping test.\n");
+		return;
+	}
+	ASSERT_NO_FATAL_FAILURE(compareTest_internal(mode.pfn_avx2));
+}
+
+/**
+ * Benchmark the AVX2 S3TC decoder.
+ */
+TEST_P(ImageDecoderS3TCTest, avx2_benchmark)
+{
+	const ImageDecoderS3TCTest_mode &mode = GetParam();
+	if (!mode.pfn_avx2 || !RP_CPU_HasAVX2()) {
+		fprintf(stderr, "*** AVX2 is not supported on this CPU. Skipping test.\n");
+		return;
+	}
+	ASSERT_NO_FATAL_FAILURE(benchmark_internal(mode.pfn_avx2));
+}
+
+#ifdef IMAGEDECODER_HAS_SSE2
+# define S3TC_SSE2(fn) &ImageDecoder::fn##_sse2
+#else /* !IMAGEDECODER_HAS_SSE2 */
+# define S3TC_SSE2(fn) nullptr
+#endif /* IMAGEDECODER_HAS_SSE2 */
+#ifdef IMAGEDECODER_HAS_SSSE3
+# define S3TC_SSSE3(fn) &ImageDecoder::fn##_ssse3
+#else /* !IMAGEDECODER_HAS_SSSE3 */
+# define S3TC_SSSE3(fn) nullptr
+#endif /* IMAGEDECODER_HAS_SSSE3 */
+#ifdef IMAGEDECODER_HAS_SSE41
+# define S3TC_SSE41(fn) &ImageDecoder::fn##_sse41
+#else /* !IMAGEDECODER_HAS_SSE41 */
+# define S3TC_SSE41(fn) nullptr
+#endif /* IMAGEDECODER_HAS_SSE41 */
+#ifdef IMAGEDECODER_HAS_AVX2
+# define S3TC_AVX2(fn) &ImageDecoder::fn##_avx2
+#else /* !IMAGEDECODER_HAS_AVX2 */
+# define S3TC_AVX2(fn) nullptr
+#endif /* IMAGEDECODER_HAS_AVX2 */
+#define S3TC_MODE(name, blockSize, fn) \
+	{#name, blockSize, ImageDecoder::BLOCK_##name, &ImageDecoder::fn##_cpp, S3TC_SSE2(fn), S3TC_SSSE3(fn), nullptr, S3TC_AVX2(fn), false}
+
+static const ImageDecoderS3TCTest_mode s3tc_modes[] = {
+	S3TC_MODE(DXT1,      8, fromDXT1),
+	S3TC_MODE(DXT1_A1,   8, fromDXT1_A1),
+	S3TC_MODE(DXT3,     16, fromDXT3),
+	S3TC_MODE(DXT5,     16, fromDXT5),
+	S3TC_MODE(BC4,       8, fromBC4),
+	S3TC_MODE(BC5,      16, fromBC5),
+};
+
+INSTANTIATE_TEST_CASE_P(S3TC, ImageDecoderS3TCTest,
+	::testing::ValuesIn(s3tc_modes)
+	, ImageDecoderS3TCTest::test_case_suffix_generator);
+
+// BC7 doesn't have an AVX2 version.
+static const ImageDecoderS3TCTest_mode bc7_modes[] = {
+	{"BC7", 16, ImageDecoder::BLOCK_BC7, &ImageDecoder::fromBC7_cpp, S3TC_SSE2(fromBC7), S3TC_SSSE3(fromBC7), nullptr, nullptr, true},
+};
+
+INSTANTIATE_TEST_CASE_P(BC7, ImageDecoderS3TCTest,
+	::testing::ValuesIn(bc7_modes)
+	, ImageDecoderS3TCTest::test_case_suffix_generator);
+
+// ETC only has SSE4.1 and AVX2 versions.
+// Random blocks use all of the ETC1 and ETC2 block modes.
+#define ETC_MODE(name, blockSize, fn) \
+	{#name, blockSize, ImageDecoder::BLOCK_##name, &ImageDecoder::fn##_cpp, nullptr, nullptr, S3TC_SSE41(fn), S3TC_AVX2(fn), false}
+
+static const ImageDecoderS3TCTest_mode etc_modes[] = {
+	ETC_MODE(ETC1,           8, fromETC1),
+	ETC_MODE(ETC2_RGB,       8, fromETC2_RGB),
+	ETC_MODE(ETC2_RGBA,     16, fromETC2_RGBA),
+	ETC_MODE(ETC2_RGB_A1,    8, fromETC2_RGB_A1),
+};
+
+INSTANTIATE_TEST_CASE_P(ETC, ImageDecoderS3TCTest,
+	::testing::ValuesIn(etc_modes)
+	, ImageDecoderS3TCTest::test_case_suffix_generator);
+#endif /* RP_CPU_I386 || RP_CPU_AMD64 */
+
 } }
 
 /**
@@ -1142,9 +1600,8 @@ INSTANTIATE_TEST_CASE_P(BC7, ImageDecoderTest,
 extern "C" int gtest_main(int argc, char *argv[])
 {
 	fprintf(stderr, "LibRomData test suite: ImageDecoder tests.\n\n");
-	fprintf(stderr, "Benchmark iterations: %u (%u for BC7)\n",
-		LibRomData::Tests::ImageDecoderTest::BENCHMARK_ITERATIONS,
-		LibRomData::Tests::ImageDecoderTest::BENCHMARK_ITERATIONS_BC7);
+	fprintf(stderr, "Benchmark iterations: %u\n",
+		LibRomData::Tests::ImageDecoderTest::BENCHMARK_ITERATIONS);
 	fflush(nullptr);
 
 	// coverity[fun_call_w_exception]: uncaught exceptions cause nonzero exit anyway, so don't warn.
@@ -586,6 +586,25 @@ int RomData::loadInternalImage(ImageType imageType, const rp_image **pImage)
 	return -ENOENT;
 }
 
+/**
+ * Load an internal image at a reduced size.
+ * Called by RomData::image() if a size is requested.
+ *
+ * Subclasses that can load smaller versions of an image,
+ * e.g. textures with mipmaps, should override this.
+ * The default implementation loads the full-size image.
+ *
+ * @param imageType	[in] Image type to load.
+ * @param size		[in] Requested image size, in pixels.
+ * @param pImage	[out] Pointer to const rp_image* to store the image in.
+ * @return 0 on success; negative POSIX error code on error.
+ */
+int RomData::loadInternalImageForSize(ImageType imageType, int size, const rp_image **pImage)
+{
+	RP_UNUSED(size);
+	return loadInternalImage(imageType, pImage);
+}
+
 /**
  * Load metadata properties.
  * Called by RomData::metaData() if the field data hasn't been loaded yet.
@@ -671,6 +690,54 @@ const rp_image *RomData::image(ImageType imageType) const
 	return (ret == 0 ? img : nullptr);
 }
 
+/**
+ * Get an internal image from the ROM at a reduced size.
+ *
+ * If the image is available in multiple sizes, e.g. a texture
+ * with mipmaps, the smallest one that is at least the requested
+ * size will be returned. The returned image may be larger than
+ * the requested size, so the caller must rescale it if needed.
+ *
+ * NOTE: The rp_image is owned by this object.
+ * Do NOT delete this object until you're done using this rp_image.
+ *
+ * @param imageType Image type to load.
+ * @param size Requested image size, in pixels. (<= 0 for the full-size image)
+ * @return Internal image, or nullptr if the ROM doesn't have one.
+ */
+const rp_image *RomData::image(ImageType imageType, int size) const
+{
+	if (size <= 0) {
+		// Full-size image.
+		return image(imageType);
+	}
+
+	assert(imageType >= IMG_INT_MIN && imageType <= IMG_INT_MAX);
+	if (imageType < IMG_INT_MIN || imageType > IMG_INT_MAX) {
+		// ImageType is out of range.
+		return nullptr;
+	}
+
+	// Load the internal image.
+	// The subclass maintains ownership of the image.
+#ifdef _DEBUG
+	const rp_image *img = INVALID_IMG_PTR;
+#else /* !_DEBUG */
+	const rp_image *img;
+#endif
+	int ret = const_cast<RomData*>(this)->loadInternalImageForSize(imageType, size, &img);
+
+	// SANITY CHECK: If loadInternalImageForSize() returns 0,
+	// img *must* be valid. Otherwise, it must be nullptr.
+	assert((ret == 0 && img != nullptr) ||
+	       (ret != 0 && img == nullptr));
+
+	// SANITY CHECK: `img` must not be -1LL.
+	assert(img != INVALID_IMG_PTR);
+
+	return (ret == 0 ? img : nullptr);
+}
+
 /**
  * Get a list of URLs for an external image type.
  *
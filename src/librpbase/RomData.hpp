@@ -139,6 +139,7 @@ class RomData
 			HeaderInfo header;	// ROM header.
 			const char *ext;	// File extension, including leading '.'
 			int64_t szFile;		// File size. (Required for certain types.)
+						// NOTE: May be a lower bound for large compressed files.
 		};
 
 		/**
@@ -415,6 +416,21 @@ class RomData
 		 */
 		virtual int loadInternalImage(ImageType imageType, const rp_image **pImage);
 
+		/**
+		 * Load an internal image at a reduced size.
+		 * Called by RomData::image() if a size is requested.
+		 *
+		 * Subclasses that can load smaller versions of an image,
+		 * e.g. textures with mipmaps, should override this.
+		 * The default implementation loads the full-size image.
+		 *
+		 * @param imageType	[in] Image type to load.
+		 * @param size		[in] Requested image size, in pixels.
+		 * @param pImage	[out] Pointer to const rp_image* to store the image in.
+		 * @return 0 on success; negative POSIX error code on error.
+		 */
+		virtual int loadInternalImageForSize(ImageType imageType, int size, const rp_image **pImage);
+
 	public:
 		/**
 		 * Get the ROM Fields object.
@@ -448,6 +464,23 @@ class RomData
 		 */
 		const rp_image *image(ImageType imageType) const;
 
+		/**
+		 * Get an internal image from the ROM at a reduced size.
+		 *
+		 * If the image is available in multiple sizes, e.g. a texture
+		 * with mipmaps, the smallest one that is at least the requested
+		 * size will be returned. The returned image may be larger than
+		 * the requested size, so the caller must rescale it if needed.
+		 *
+		 * NOTE: The rp_image is owned by this object.
+		 * Do NOT delete this object until you're done using this rp_image.
+		 *
+		 * @param imageType Image type to load.
+		 * @param size Requested image size, in pixels. (<= 0 for the full-size image)
+		 * @return Internal image, or nullptr if the ROM doesn't have one.
+		 */
+		const rp_image *image(ImageType imageType, int size) const;
+
 		/**
 		 * External URLs for a media type.
 		 * Includes URL and "cache key" for local caching,
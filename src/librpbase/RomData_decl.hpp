@@ -209,6 +209,22 @@ class klass : public LibRpBase::RomData { \
 		 */ \
 		int loadInternalImage(ImageType imageType, const LibRpBase::rp_image **pImage) final;
 
+/**
+ * RomData subclass function declaration for loading internal images
+ * at a reduced size, e.g. using mipmaps.
+ */
+#define ROMDATA_DECL_IMGINT_SIZED() \
+	public: \
+		/** \
+		 * Load an internal image at a reduced size. \
+		 * Called by RomData::image() if a size is requested. \
+		 * @param imageType	[in] Image type to load. \
+		 * @param size		[in] Requested image size, in pixels. \
+		 * @param pImage	[out] Pointer to const rp_image* to store the image in. \
+		 * @return 0 on success; negative POSIX error code on error. \
+		 */ \
+		int loadInternalImageForSize(ImageType imageType, int size, const LibRpBase::rp_image **pImage) final;
+
 /**
  * RomData subclass function declaration for obtaining URLs for external images.
  */
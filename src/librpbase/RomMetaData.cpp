@@ -88,6 +88,10 @@ class RomMetaDataPrivate
 
 		// Property type mapping.
 		static const uint8_t PropertyTypeMap[];
+
+		// Property names.
+		// These match KFileMetaData::PropertyInfo::name().
+		static const char *const PropertyNames[];
 };
 
 /** RomMetaDataPrivate **/
@@ -184,11 +188,105 @@ const uint8_t RomMetaDataPrivate::PropertyTypeMap[] = {
 	PropertyType::String,	// License
 };
 
+// Property names.
+const char *const RomMetaDataPrivate::PropertyNames[] = {
+	nullptr,	// first property is invalid
+
+	// Audio
+	"bitRate",
+	"channels",
+	"duration",
+	"genre",
+	"sampleRate",
+	"trackNumber",
+	"releaseYear",
+	"comment",
+	"artist",
+	"album",
+	"albumArtist",
+	"composer",
+	"lyricist",
+
+	// Document
+	"author",
+	"title",
+	"subject",
+	"generator",
+	"pageCount",
+	"wordCount",
+	"lineCount",
+	"language",
+	"copyright",
+	"publisher",
+	"creationDate",
+	"keywords",
+
+	// Media
+	"width",
+	"height",
+	"aspectRatio",
+	"frameRate",
+
+	// Images
+	"imageMake",
+	"imageModel",
+	"imageDateTime",
+	"imageOrientation",
+	"photoFlash",
+	"photoPixelXDimension",
+	"photoPixelYDimension",
+	"photoDateTimeOriginal",
+	"photoFocalLength",
+	"photoFocalLengthIn35mmFilm",
+	"photoExposureTime",
+	"photoFNumber",
+	"photoApertureValue",
+	"photoExposureBiasValue",
+	"photoWhiteBalance",
+	"photoMeteringMode",
+	"photoISOSpeedRatings",
+	"photoSaturation",
+	"photoSharpness",
+	"photoGpsLatitude",
+	"photoGpsLongitude",
+	"photoGpsAltitude",
+
+	// Translations
+	"translationUnitsTotal",
+	"translationUnitsWithTranslation",
+	"translationUnitsWithDraftTranslation",
+	"translationLastAuthor",
+	"translationLastUpDate",
+	"translationTemplateDate",
+
+	// Origin
+	"originUrl",
+	"originEmailSubject",
+	"originEmailSender",
+	"originEmailMessageId",
+
+	// Audio
+	"discNumber",
+	"location",
+	"performer",
+	"ensemble",
+	"arranger",
+	"conductor",
+	"opus",
+
+	// Other
+	"label",
+	"compilation",
+	"license",
+};
+
 RomMetaDataPrivate::RomMetaDataPrivate()
 	: ref_cnt(1)
 {
 	static_assert(ARRAY_SIZE(RomMetaDataPrivate::PropertyTypeMap) == Property::PropertyCount,
 		      "PropertyTypeMap needs to be updated!");
+	static_assert(ARRAY_SIZE(RomMetaDataPrivate::PropertyNames) == Property::PropertyCount,
+		      "PropertyNames needs to be updated!");
 }
 
 RomMetaDataPrivate::~RomMetaDataPrivate()
@@ -392,6 +490,24 @@ bool RomMetaData::empty(void) const
 	return d->metaData.empty();
 }
 
+/**
+ * Get the name of a metadata property.
+ * Names match KFileMetaData::PropertyInfo::name().
+ * @param name Metadata property.
+ * @return Property name, or nullptr if invalid.
+ */
+const char *RomMetaData::getPropertyName(Property::Property name)
+{
+	assert(name > Property::FirstProperty);
+	assert(name < Property::PropertyCount);
+	if (name <= Property::FirstProperty ||
+	    name >= Property::PropertyCount)
+	{
+		return nullptr;
+	}
+	return RomMetaDataPrivate::PropertyNames[name];
+}
+
 /** Convenience functions for RomData subclasses. **/
 
 /**
@@ -214,6 +214,14 @@ class RomMetaData
 		 */
 		bool empty(void) const;
 
+		/**
+		 * Get the name of a metadata property.
+		 * Names match KFileMetaData::PropertyInfo::name().
+		 * @param name Metadata property.
+		 * @return Property name, or nullptr if invalid.
+		 */
+		static const char *getPropertyName(Property::Property name);
+
 	private:
 		/**
 		 * Detach this instance from all other instances.
@@ -55,6 +55,7 @@
 #define CPUFLAG_IA32_ECX_SSSE3		((uint32_t)(1U << 9))
 #define CPUFLAG_IA32_ECX_SSE41		((uint32_t)(1U << 19))
 #define CPUFLAG_IA32_ECX_SSE42		((uint32_t)(1U << 20))
+#define CPUFLAG_IA32_ECX_AES		((uint32_t)(1U << 25))
 #define CPUFLAG_IA32_ECX_XSAVE		((uint32_t)(1U << 26))
 #define CPUFLAG_IA32_ECX_OSXSAVE	((uint32_t)(1U << 27))
 #define CPUFLAG_IA32_ECX_AVX		((uint32_t)(1U << 28))
@@ -64,6 +65,22 @@
 
 // Flags stored in the %ebx register.
 #define CPUFLAG_IA32_FN7_EBX_AVX2	((uint32_t)(1U << 5))
+#define CPUFLAG_IA32_FN7_EBX_AVX512F	((uint32_t)(1U << 16))
+
+// Flags stored in the %ecx register.
+#define CPUFLAG_IA32_FN7_ECX_VAES	((uint32_t)(1U << 9))
+
+// XCR0: Extended control register 0.
+// SSE and AVX must be set for the OS to support AVX.
+// All of these bits must be set for the OS to support AVX-512.
+#define IA32_XCR0_SSE			((uint32_t)(1U << 1))
+#define IA32_XCR0_AVX			((uint32_t)(1U << 2))
+#define IA32_XCR0_OPMASK		((uint32_t)(1U << 5))
+#define IA32_XCR0_ZMM_HI256		((uint32_t)(1U << 6))
+#define IA32_XCR0_HI16_ZMM		((uint32_t)(1U << 7))
+#define IA32_XCR0_AVX_MASK		(IA32_XCR0_SSE | IA32_XCR0_AVX)
+#define IA32_XCR0_AVX512_MASK		(IA32_XCR0_SSE | IA32_XCR0_AVX | \
+					 IA32_XCR0_OPMASK | IA32_XCR0_ZMM_HI256 | IA32_XCR0_HI16_ZMM)
 
 // CPUID function 0x80000001: Extended Processor Info and Feature Bits
 
@@ -147,6 +164,8 @@ static FORCEINLINE int is_cpuid_supported(void)
 
 /**
  * Run the `cpuid` instruction.
+ * NOTE: %ecx is set to 0, which selects subleaf 0
+ * for functions that have subleaves, e.g. function 7.
  * @param level
  * @param regs Registers. (%eax, %ebx, %ecx, %edx)
  */
@@ -161,19 +180,24 @@ static FORCEINLINE void cpuid(unsigned int level, unsigned int regs[4])
 		"cpuid\n"
 		"xchgl	%%ebx, %1\n"
 		: "=a" (regs[0]), "=r" (regs[1]), "=c" (regs[2]), "=d" (regs[3])
-		: "0" (level)
+		: "0" (level), "2" (0)
 		);
 # else /* !ASM_RESERVE_EBX */
 	__asm__ (
 		"cpuid\n"
 		: "=a" (regs[0]), "=b" (regs[1]), "=c" (regs[2]), "=d" (regs[3])
-		: "0" (level)
+		: "0" (level), "2" (0)
 		);
 # endif
 #elif defined(_MSC_VER)
-# if _MSC_VER >= 1400
-	// CPUID for MSVC 2005+
+# if _MSC_VER >= 1500
+	// CPUID for MSVC 2008+
+	// Uses the __cpuidex() intrinsic.
+	__cpuidex((int*)regs, level, 0);
+# elif _MSC_VER >= 1400
+	// CPUID for MSVC 2005
 	// Uses the __cpuid() intrinsic.
+	// NOTE: Subleaves aren't supported.
 	__cpuid((int*)regs, level);
 # else /* _MSC_VER < 1400 */
 	// CPUID for old MSVC that doesn't support intrinsics.
@@ -194,6 +218,33 @@ static FORCEINLINE void cpuid(unsigned int level, unsigned int regs[4])
 #endif
 }
 
+/**
+ * Read XCR0 using the `xgetbv` instruction.
+ * CPUID.1:ECX.OSXSAVE must be set before calling this function.
+ * @return Low 32 bits of XCR0, or 0 if not supported by the compiler.
+ */
+static FORCEINLINE uint32_t xgetbv0(void)
+{
+#if defined(__GNUC__)
+	// NOTE: Using the opcode directly, since older
+	// assemblers don't recognize `xgetbv`.
+	unsigned int eax, edx;
+	__asm__ (
+		".byte 0x0f, 0x01, 0xd0\n"
+		: "=a" (eax), "=d" (edx)
+		: "c" (0)
+		);
+	return eax;
+#elif defined(_MSC_FULL_VER) && _MSC_FULL_VER >= 160040219
+	// MSVC 2010 SP1+
+	return (uint32_t)_xgetbv(0);
+#else
+	// xgetbv isn't supported by this compiler.
+	// AVX-512 will not be used.
+	return 0;
+#endif
+}
+
 // Register indexes.
 #define REG_EAX 0
 #define REG_EBX 1
@@ -212,6 +263,8 @@ static void RP_CPU_InitCPUFlags_int(void)
 	unsigned int regs[4];	// %eax, %ebx, %ecx, %edx
 	unsigned int maxFunc;
 	uint8_t can_FXSAVE = 0;
+	uint8_t can_AVX = 0;
+	uint8_t can_AVX512 = 0;
 
 	// Make sure the CPU flags variable is empty.
 	RP_CPU_Flags = 0;
@@ -302,6 +355,8 @@ static void RP_CPU_InitCPUFlags_int(void)
 				RP_CPU_Flags |= RP_CPUFLAG_X86_SSE41;
 			if (regs[REG_ECX] & CPUFLAG_IA32_ECX_SSE42)
 				RP_CPU_Flags |= RP_CPUFLAG_X86_SSE42;
+			if (regs[REG_ECX] & CPUFLAG_IA32_ECX_AES)
+				RP_CPU_Flags |= RP_CPUFLAG_X86_AES;
 		}
 #else /* !(defined(__i386__) || defined(_M_IX86)) */
 		// AMD64: SSE2 and lower are always supported.
@@ -315,7 +370,35 @@ static void RP_CPU_InitCPUFlags_int(void)
 			RP_CPU_Flags |= RP_CPUFLAG_X86_SSE41;
 		if (regs[REG_ECX] & CPUFLAG_IA32_ECX_SSE42)
 			RP_CPU_Flags |= RP_CPUFLAG_X86_SSE42;
+		if (regs[REG_ECX] & CPUFLAG_IA32_ECX_AES)
+			RP_CPU_Flags |= RP_CPUFLAG_X86_AES;
 #endif /* defined(__i386__) || defined(_M_IX86) */
+
+		// Check if the OS supports the AVX and AVX-512 registers.
+		if (can_FXSAVE && (regs[REG_ECX] & CPUFLAG_IA32_ECX_OSXSAVE)) {
+			const uint32_t xcr0 = xgetbv0();
+			if ((regs[REG_ECX] & CPUFLAG_IA32_ECX_AVX) &&
+			    (xcr0 & IA32_XCR0_AVX_MASK) == IA32_XCR0_AVX_MASK)
+			{
+				can_AVX = 1;
+			}
+			if ((xcr0 & IA32_XCR0_AVX512_MASK) == IA32_XCR0_AVX512_MASK) {
+				can_AVX512 = 1;
+			}
+		}
+	}
+
+	if (maxFunc >= CPUID_EXT_FEATURES && (can_AVX || can_AVX512)) {
+		// Get the extended features.
+		cpuid(CPUID_EXT_FEATURES, regs);
+		if (can_AVX && (regs[REG_EBX] & CPUFLAG_IA32_FN7_EBX_AVX2)) {
+			RP_CPU_Flags |= RP_CPUFLAG_X86_AVX2;
+		}
+		if (can_AVX512 && (regs[REG_EBX] & CPUFLAG_IA32_FN7_EBX_AVX512F)) {
+			RP_CPU_Flags |= RP_CPUFLAG_X86_AVX512F;
+			if (regs[REG_ECX] & CPUFLAG_IA32_FN7_ECX_VAES)
+				RP_CPU_Flags |= RP_CPUFLAG_X86_VAES;
+		}
 	}
 
 	// CPU flags initialized.
@@ -42,6 +42,10 @@ extern "C" {
 #define RP_CPUFLAG_X86_SSSE3		((uint32_t)(1U << 4))
 #define RP_CPUFLAG_X86_SSE41		((uint32_t)(1U << 5))
 #define RP_CPUFLAG_X86_SSE42		((uint32_t)(1U << 6))
+#define RP_CPUFLAG_X86_AES		((uint32_t)(1U << 7))
+#define RP_CPUFLAG_X86_AVX512F		((uint32_t)(1U << 8))	// includes OS support for ZMM registers
+#define RP_CPUFLAG_X86_VAES		((uint32_t)(1U << 9))
+#define RP_CPUFLAG_X86_AVX2		((uint32_t)(1U << 10))	// includes OS support for YMM registers
 
 #endif /* defined(__i386__) || defined(__amd64__) || defined(__x86_64__) */
 
@@ -112,6 +116,46 @@ static FORCEINLINE int RP_CPU_HasSSE41(void)
 	return (RP_CPU_Flags & RP_CPUFLAG_X86_SSE41);
 }
 
+/**
+ * Check if the CPU supports AES-NI.
+ * @return Non-zero if AES-NI is supported; 0 if not.
+ */
+static FORCEINLINE int RP_CPU_HasAES(void)
+{
+	if (unlikely(!RP_CPU_Flags_Init)) {
+		RP_CPU_InitCPUFlags();
+	}
+	return (RP_CPU_Flags & RP_CPUFLAG_X86_AES);
+}
+
+/**
+ * Check if the CPU supports AVX2.
+ * The OS must support saving the AVX registers.
+ * @return Non-zero if AVX2 is supported; 0 if not.
+ */
+static FORCEINLINE int RP_CPU_HasAVX2(void)
+{
+	if (unlikely(!RP_CPU_Flags_Init)) {
+		RP_CPU_InitCPUFlags();
+	}
+	return (RP_CPU_Flags & RP_CPUFLAG_X86_AVX2);
+}
+
+/**
+ * Check if the CPU supports VAES with 512-bit vectors.
+ * This requires both VAES and AVX-512F, and the OS
+ * must support saving the AVX-512 registers.
+ * @return Non-zero if VAES-512 is supported; 0 if not.
+ */
+static FORCEINLINE int RP_CPU_HasVAES512(void)
+{
+	if (unlikely(!RP_CPU_Flags_Init)) {
+		RP_CPU_InitCPUFlags();
+	}
+	return ((RP_CPU_Flags & (RP_CPUFLAG_X86_AVX512F | RP_CPUFLAG_X86_VAES)) ==
+		(RP_CPUFLAG_X86_AVX512F | RP_CPUFLAG_X86_VAES));
+}
+
 #ifdef __cplusplus
 }
 #endif
@@ -24,6 +24,10 @@
 #include "AesCipherFactory.hpp"
 
 // IAesCipher implementations.
+#include "librpbase/cpu_dispatch.h"
+#if defined(RP_CPU_I386) || defined(RP_CPU_AMD64)
+# include "AesNI.hpp"
+#endif /* RP_CPU_I386 || RP_CPU_AMD64 */
 #if defined(_WIN32)
 # include "AesCAPI.hpp"
 # include "AesCAPI_NG.hpp"
@@ -44,6 +48,14 @@ namespace LibRpBase {
  */
 IAesCipher *AesCipherFactory::create(void)
 {
+#if defined(RP_CPU_I386) || defined(RP_CPU_AMD64)
+	// x86: Use AES-NI if it's supported by the CPU.
+	// This is significantly faster than the OS libraries.
+	if (AesNI::isUsable()) {
+		return new AesNI();
+	}
+#endif /* RP_CPU_I386 || RP_CPU_AMD64 */
+
 #if defined(_WIN32)
 	// Windows: Use CryptoAPI NG if available.
 	// If not, fall back to CryptoAPI.
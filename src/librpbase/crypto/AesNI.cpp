@@ -0,0 +1,506 @@
+/***************************************************************************
+ * ROM Properties Page shell extension. (librpbase)                        *
+ * AesNI.cpp: AES decryption class using AES-NI instructions.              *
+ *                                                                         *
+ * Copyright (c) 2016-2018 by David Korth.                                 *
+ *                                                                         *
+ * This program is free software; you can redistribute it and/or modify it *
+ * under the terms of the GNU General Public License as published by the   *
+ * Free Software Foundation; either version 2 of the License, or (at your  *
+ * option) any later version.                                              *
+ *                                                                         *
+ * This program is distributed in the hope that it will be useful, but     *
+ * WITHOUT ANY WARRANTY; without even the implied warranty of              *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the           *
+ * GNU General Public License for more details.                            *
+ *                                                                         *
+ * You should have received a copy of the GNU General Public License       *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.   *
+ ***************************************************************************/
+
+#include "AesNI.hpp"
+#include "../byteswap.h"
+
+// C includes. (C++ namespace)
+#include <cerrno>
+#include <cstring>
+
+// AES-NI intrinsics.
+#include <emmintrin.h>
+#include <wmmintrin.h>
+
+// References:
+// - Intel Advanced Encryption Standard (AES) New Instructions Set
+//   https://www.intel.com/content/dam/doc/white-paper/advanced-encryption-standard-new-instructions-set-paper.pdf
+// - FIPS-197: Advanced Encryption Standard (AES)
+
+#define AES_BLOCK_SIZE 16
+#define AES_MAX_ROUNDS 14
+
+namespace LibRpBase {
+
+class AesNIPrivate
+{
+	public:
+		AesNIPrivate();
+		~AesNIPrivate();
+
+	private:
+		RP_DISABLE_COPY(AesNIPrivate)
+
+	public:
+		// Round keys.
+		// Encryption keys are used for CTR.
+		// Decryption keys are used for ECB and CBC.
+		uint8_t enc_keys[(AES_MAX_ROUNDS+1) * AES_BLOCK_SIZE];
+		uint8_t dec_keys[(AES_MAX_ROUNDS+1) * AES_BLOCK_SIZE];
+		unsigned int rounds;	// 0 if no key is set.
+
+		// CBC: Initialization vector.
+		// CTR: Counter.
+		uint8_t iv[AES_BLOCK_SIZE];
+
+		IAesCipher::ChainingMode chainingMode;
+
+		/**
+		 * Expand an AES key.
+		 * @param pKey	[in] Key data.
+		 * @param size	[in] Size of pKey, in bytes. (16, 24, or 32)
+		 */
+		void expandKey(const uint8_t *RESTRICT pKey, size_t size);
+};
+
+/** AesNIPrivate **/
+
+AesNIPrivate::AesNIPrivate()
+	: rounds(0)
+	, chainingMode(IAesCipher::CM_ECB)
+{
+	// Clear the keys.
+	memset(enc_keys, 0, sizeof(enc_keys));
+	memset(dec_keys, 0, sizeof(dec_keys));
+	memset(iv, 0, sizeof(iv));
+}
+
+AesNIPrivate::~AesNIPrivate()
+{
+	// Don't leave the round keys in memory.
+	memset(enc_keys, 0, sizeof(enc_keys));
+	memset(dec_keys, 0, sizeof(dec_keys));
+}
+
+/**
+ * Expand an AES key.
+ * @param pKey	[in] Key data.
+ * @param size	[in] Size of pKey, in bytes. (16, 24, or 32)
+ */
+void AesNIPrivate::expandKey(const uint8_t *RESTRICT pKey, size_t size)
+{
+	// FIPS-197 key expansion, using AESKEYGENASSIST for SubWord().
+	// This handles all three key sizes with the same code.
+	// NOTE: Words are stored in little-endian order, so
+	// RotWord() is a right rotation, and Rcon is XORed
+	// into the low byte.
+	static const uint8_t rcon[10] = {
+		0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x80, 0x1B, 0x36
+	};
+
+	const unsigned int nk = static_cast<unsigned int>(size / 4);
+	rounds = nk + 6;
+	const unsigned int nw = (rounds + 1) * 4;
+
+	uint32_t w[(AES_MAX_ROUNDS+1) * 4];
+	memcpy(w, pKey, size);
+	for (unsigned int i = nk; i < nw; i++) {
+		uint32_t temp = w[i-1];
+		if (i % nk == 0 || (nk > 6 && i % nk == 4)) {
+			// SubWord(): AESKEYGENASSIST applies the S-box
+			// to dword 1 and stores the result in dword 0.
+			temp = static_cast<uint32_t>(_mm_cvtsi128_si32(
+				_mm_aeskeygenassist_si128(_mm_set_epi32(0, 0, static_cast<int>(temp), 0), 0)));
+			if (i % nk == 0) {
+				// RotWord(), then Rcon.
+				temp = ((temp >> 8) | (temp << 24)) ^ rcon[(i / nk) - 1];
+			}
+		}
+		w[i] = w[i-nk] ^ temp;
+	}
+	memcpy(enc_keys, w, nw * sizeof(uint32_t));
+
+	// Decryption keys: Reverse order, with InvMixColumns
+	// applied to all keys except the first and last.
+	memcpy(&dec_keys[0], &enc_keys[rounds * AES_BLOCK_SIZE], AES_BLOCK_SIZE);
+	for (unsigned int i = 1; i < rounds; i++) {
+		const __m128i key = _mm_loadu_si128(
+			reinterpret_cast<const __m128i*>(&enc_keys[(rounds - i) * AES_BLOCK_SIZE]));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(&dec_keys[i * AES_BLOCK_SIZE]),
+			_mm_aesimc_si128(key));
+	}
+	memcpy(&dec_keys[rounds * AES_BLOCK_SIZE], &enc_keys[0], AES_BLOCK_SIZE);
+
+	// Don't leave the key schedule on the stack.
+	memset(w, 0, sizeof(w));
+}
+
+/** Cipher functions. **/
+
+// Apply an AES round function to 8 blocks.
+#define AESNI_ROUND8(op, k) do { \
+	b0 = op(b0, k); b1 = op(b1, k); b2 = op(b2, k); b3 = op(b3, k); \
+	b4 = op(b4, k); b5 = op(b5, k); b6 = op(b6, k); b7 = op(b7, k); \
+} while (0)
+
+/**
+ * Load round keys.
+ * @param k		[out] Round keys.
+ * @param pKeys		[in] Round keys. (unaligned)
+ * @param rounds	[in] Number of rounds.
+ */
+static FORCEINLINE void load_keys(__m128i k[AES_MAX_ROUNDS+1], const uint8_t *pKeys, unsigned int rounds)
+{
+	for (unsigned int r = 0; r <= rounds; r++) {
+		k[r] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&pKeys[r * AES_BLOCK_SIZE]));
+	}
+}
+
+/**
+ * Decrypt a single block.
+ * @param b		[in] Cipher text.
+ * @param k		[in] Decryption round keys.
+ * @param rounds	[in] Number of rounds.
+ * @return Plain text.
+ */
+static FORCEINLINE __m128i decrypt1(__m128i b, const __m128i k[AES_MAX_ROUNDS+1], unsigned int rounds)
+{
+	b = _mm_xor_si128(b, k[0]);
+	for (unsigned int r = 1; r < rounds; r++) {
+		b = _mm_aesdec_si128(b, k[r]);
+	}
+	return _mm_aesdeclast_si128(b, k[rounds]);
+}
+
+/**
+ * Encrypt a single block.
+ * @param b		[in] Plain text.
+ * @param k		[in] Encryption round keys.
+ * @param rounds	[in] Number of rounds.
+ * @return Cipher text.
+ */
+static FORCEINLINE __m128i encrypt1(__m128i b, const __m128i k[AES_MAX_ROUNDS+1], unsigned int rounds)
+{
+	b = _mm_xor_si128(b, k[0]);
+	for (unsigned int r = 1; r < rounds; r++) {
+		b = _mm_aesenc_si128(b, k[r]);
+	}
+	return _mm_aesenclast_si128(b, k[rounds]);
+}
+
+/**
+ * Decrypt data using AES-ECB.
+ * @param pKeys		[in] Decryption round keys.
+ * @param rounds	[in] Number of rounds.
+ * @param pData		[in/out] Data.
+ * @param blocks	[in] Number of 16-byte blocks.
+ */
+static void ecb_decrypt(const uint8_t *RESTRICT pKeys, unsigned int rounds,
+	uint8_t *RESTRICT pData, size_t blocks)
+{
+	__m128i k[AES_MAX_ROUNDS+1];
+	load_keys(k, pKeys, rounds);
+
+	__m128i *p = reinterpret_cast<__m128i*>(pData);
+	for (; blocks >= 8; blocks -= 8, p += 8) {
+		__m128i b0 = _mm_xor_si128(_mm_loadu_si128(p+0), k[0]);
+		__m128i b1 = _mm_xor_si128(_mm_loadu_si128(p+1), k[0]);
+		__m128i b2 = _mm_xor_si128(_mm_loadu_si128(p+2), k[0]);
+		__m128i b3 = _mm_xor_si128(_mm_loadu_si128(p+3), k[0]);
+		__m128i b4 = _mm_xor_si128(_mm_loadu_si128(p+4), k[0]);
+		__m128i b5 = _mm_xor_si128(_mm_loadu_si128(p+5), k[0]);
+		__m128i b6 = _mm_xor_si128(_mm_loadu_si128(p+6), k[0]);
+		__m128i b7 = _mm_xor_si128(_mm_loadu_si128(p+7), k[0]);
+		for (unsigned int r = 1; r < rounds; r++) {
+			AESNI_ROUND8(_mm_aesdec_si128, k[r]);
+		}
+		AESNI_ROUND8(_mm_aesdeclast_si128, k[rounds]);
+		_mm_storeu_si128(p+0, b0); _mm_storeu_si128(p+1, b1);
+		_mm_storeu_si128(p+2, b2); _mm_storeu_si128(p+3, b3);
+		_mm_storeu_si128(p+4, b4); _mm_storeu_si128(p+5, b5);
+		_mm_storeu_si128(p+6, b6); _mm_storeu_si128(p+7, b7);
+	}
+	for (; blocks > 0; blocks--, p++) {
+		_mm_storeu_si128(p, decrypt1(_mm_loadu_si128(p), k, rounds));
+	}
+}
+
+/**
+ * Decrypt data using AES-CBC.
+ * AES-NI version. (8 blocks at a time)
+ * @param pKeys		[in] Decryption round keys.
+ * @param rounds	[in] Number of rounds.
+ * @param pIV		[in/out] IV. Updated for the next block.
+ * @param pData		[in/out] Data.
+ * @param blocks	[in] Number of 16-byte blocks.
+ */
+void AesNI::cbc_decrypt_aesni(const uint8_t *RESTRICT pKeys, unsigned int rounds,
+	uint8_t *RESTRICT pIV, uint8_t *RESTRICT pData, size_t blocks)
+{
+	__m128i k[AES_MAX_ROUNDS+1];
+	load_keys(k, pKeys, rounds);
+
+	// CBC decryption doesn't have a dependency chain, since
+	// each block only depends on the previous cipher text.
+	__m128i iv = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pIV));
+	__m128i *p = reinterpret_cast<__m128i*>(pData);
+	for (; blocks >= 8; blocks -= 8, p += 8) {
+		const __m128i c0 = _mm_loadu_si128(p+0);
+		const __m128i c1 = _mm_loadu_si128(p+1);
+		const __m128i c2 = _mm_loadu_si128(p+2);
+		const __m128i c3 = _mm_loadu_si128(p+3);
+		const __m128i c4 = _mm_loadu_si128(p+4);
+		const __m128i c5 = _mm_loadu_si128(p+5);
+		const __m128i c6 = _mm_loadu_si128(p+6);
+		const __m128i c7 = _mm_loadu_si128(p+7);
+
+		__m128i b0 = _mm_xor_si128(c0, k[0]);
+		__m128i b1 = _mm_xor_si128(c1, k[0]);
+		__m128i b2 = _mm_xor_si128(c2, k[0]);
+		__m128i b3 = _mm_xor_si128(c3, k[0]);
+		__m128i b4 = _mm_xor_si128(c4, k[0]);
+		__m128i b5 = _mm_xor_si128(c5, k[0]);
+		__m128i b6 = _mm_xor_si128(c6, k[0]);
+		__m128i b7 = _mm_xor_si128(c7, k[0]);
+		for (unsigned int r = 1; r < rounds; r++) {
+			AESNI_ROUND8(_mm_aesdec_si128, k[r]);
+		}
+		AESNI_ROUND8(_mm_aesdeclast_si128, k[rounds]);
+
+		_mm_storeu_si128(p+0, _mm_xor_si128(b0, iv));
+		_mm_storeu_si128(p+1, _mm_xor_si128(b1, c0));
+		_mm_storeu_si128(p+2, _mm_xor_si128(b2, c1));
+		_mm_storeu_si128(p+3, _mm_xor_si128(b3, c2));
+		_mm_storeu_si128(p+4, _mm_xor_si128(b4, c3));
+		_mm_storeu_si128(p+5, _mm_xor_si128(b5, c4));
+		_mm_storeu_si128(p+6, _mm_xor_si128(b6, c5));
+		_mm_storeu_si128(p+7, _mm_xor_si128(b7, c6));
+		iv = c7;
+	}
+	for (; blocks > 0; blocks--, p++) {
+		const __m128i c = _mm_loadu_si128(p);
+		_mm_storeu_si128(p, _mm_xor_si128(decrypt1(c, k, rounds), iv));
+		iv = c;
+	}
+
+	_mm_storeu_si128(reinterpret_cast<__m128i*>(pIV), iv);
+}
+
+/**
+ * Encrypt or decrypt data using AES-CTR.
+ * AES-NI version. (8 blocks at a time)
+ * @param pKeys		[in] Encryption round keys.
+ * @param rounds	[in] Number of rounds.
+ * @param pCtr		[in/out] Counter. (big-endian) Updated for the next block.
+ * @param pData		[in/out] Data.
+ * @param blocks	[in] Number of 16-byte blocks.
+ */
+void AesNI::ctr_crypt_aesni(const uint8_t *RESTRICT pKeys, unsigned int rounds,
+	uint8_t *RESTRICT pCtr, uint8_t *RESTRICT pData, size_t blocks)
+{
+	__m128i k[AES_MAX_ROUNDS+1];
+	load_keys(k, pKeys, rounds);
+
+	// The counter is a 128-bit big-endian value.
+	uint64_t ctr_hi, ctr_lo;
+	memcpy(&ctr_hi, &pCtr[0], sizeof(ctr_hi));
+	memcpy(&ctr_lo, &pCtr[8], sizeof(ctr_lo));
+	ctr_hi = be64_to_cpu(ctr_hi);
+	ctr_lo = be64_to_cpu(ctr_lo);
+
+	// Get the next counter block, and increment the counter.
+	#define NEXT_CTR() _mm_set_epi64x( \
+		static_cast<int64_t>(cpu_to_be64(ctr_lo)), \
+		static_cast<int64_t>(cpu_to_be64(ctr_hi))); \
+		if (++ctr_lo == 0) { ctr_hi++; }
+
+	__m128i *p = reinterpret_cast<__m128i*>(pData);
+	for (; blocks >= 8; blocks -= 8, p += 8) {
+		__m128i b0 = NEXT_CTR();
+		__m128i b1 = NEXT_CTR();
+		__m128i b2 = NEXT_CTR();
+		__m128i b3 = NEXT_CTR();
+		__m128i b4 = NEXT_CTR();
+		__m128i b5 = NEXT_CTR();
+		__m128i b6 = NEXT_CTR();
+		__m128i b7 = NEXT_CTR();
+
+		AESNI_ROUND8(_mm_xor_si128, k[0]);
+		for (unsigned int r = 1; r < rounds; r++) {
+			AESNI_ROUND8(_mm_aesenc_si128, k[r]);
+		}
+		AESNI_ROUND8(_mm_aesenclast_si128, k[rounds]);
+
+		_mm_storeu_si128(p+0, _mm_xor_si128(b0, _mm_loadu_si128(p+0)));
+		_mm_storeu_si128(p+1, _mm_xor_si128(b1, _mm_loadu_si128(p+1)));
+		_mm_storeu_si128(p+2, _mm_xor_si128(b2, _mm_loadu_si128(p+2)));
+		_mm_storeu_si128(p+3, _mm_xor_si128(b3, _mm_loadu_si128(p+3)));
+		_mm_storeu_si128(p+4, _mm_xor_si128(b4, _mm_loadu_si128(p+4)));
+		_mm_storeu_si128(p+5, _mm_xor_si128(b5, _mm_loadu_si128(p+5)));
+		_mm_storeu_si128(p+6, _mm_xor_si128(b6, _mm_loadu_si128(p+6)));
+		_mm_storeu_si128(p+7, _mm_xor_si128(b7, _mm_loadu_si128(p+7)));
+	}
+	for (; blocks > 0; blocks--, p++) {
+		__m128i b = NEXT_CTR();
+		b = encrypt1(b, k, rounds);
+		_mm_storeu_si128(p, _mm_xor_si128(b, _mm_loadu_si128(p)));
+	}
+	#undef NEXT_CTR
+
+	ctr_hi = cpu_to_be64(ctr_hi);
+	ctr_lo = cpu_to_be64(ctr_lo);
+	memcpy(&pCtr[0], &ctr_hi, sizeof(ctr_hi));
+	memcpy(&pCtr[8], &ctr_lo, sizeof(ctr_lo));
+}
+
+/** AesNI **/
+
+AesNI::AesNI()
+	: d_ptr(new AesNIPrivate())
+{ }
+
+AesNI::~AesNI()
+{
+	delete d_ptr;
+}
+
+/**
+ * Get the name of the AesCipher implementation.
+ * @return Name.
+ */
+const char *AesNI::name(void) const
+{
+#ifdef AESNI_HAS_VAES
+	if (RP_CPU_HasVAES512()) {
+		return "AES-NI (VAES)";
+	}
+#endif /* AESNI_HAS_VAES */
+	return "AES-NI";
+}
+
+/**
+ * Has the cipher been initialized properly?
+ * @return True if initialized; false if not.
+ */
+bool AesNI::isInit(void) const
+{
+	// AES-NI always works if it's supported by the CPU.
+	return isUsable();
+}
+
+/**
+ * Set the encryption key.
+ * @param pKey	[in] Key data.
+ * @param size	[in] Size of pKey, in bytes.
+ * @return 0 on success; negative POSIX error code on error.
+ */
+int AesNI::setKey(const uint8_t *RESTRICT pKey, size_t size)
+{
+	// Acceptable key lengths:
+	// - 16 (AES-128)
+	// - 24 (AES-192)
+	// - 32 (AES-256)
+	if (!pKey || !(size == 16 || size == 24 || size == 32)) {
+		return -EINVAL;
+	}
+
+	RP_D(AesNI);
+	d->expandKey(pKey, size);
+	return 0;
+}
+
+/**
+ * Set the cipher chaining mode.
+ *
+ * Note that the IV/counter must be set *after* setting
+ * the chaining mode; otherwise, setIV() will fail.
+ *
+ * @param mode Cipher chaining mode.
+ * @return 0 on success; negative POSIX error code on error.
+ */
+int AesNI::setChainingMode(ChainingMode mode)
+{
+	if (mode < CM_ECB || mode > CM_CTR) {
+		return -EINVAL;
+	}
+
+	// NOTE: Both encryption and decryption round keys
+	// are expanded by setKey(), so changing the chaining
+	// mode doesn't require a key update.
+	RP_D(AesNI);
+	d->chainingMode = mode;
+	return 0;
+}
+
+/**
+ * Set the IV (CBC mode) or counter (CTR mode).
+ * @param pIV	[in] IV/counter data.
+ * @param size	[in] Size of pIV, in bytes.
+ * @return 0 on success; negative POSIX error code on error.
+ */
+int AesNI::setIV(const uint8_t *RESTRICT pIV, size_t size)
+{
+	RP_D(AesNI);
+	if (!pIV || size != AES_BLOCK_SIZE ||
+	    d->chainingMode < CM_CBC || d->chainingMode > CM_CTR)
+	{
+		// Invalid parameters and/or chaining mode.
+		return -EINVAL;
+	}
+
+	// Set the IV/counter.
+	memcpy(d->iv, pIV, AES_BLOCK_SIZE);
+	return 0;
+}
+
+/**
+ * Decrypt a block of data.
+ * @param pData	[in/out] Data block.
+ * @param size	[in] Length of data block. (Must be a multiple of 16.)
+ * @return Number of bytes decrypted on success; 0 on error.
+ */
+size_t AesNI::decrypt(uint8_t *RESTRICT pData, size_t size)
+{
+	if (!pData || size == 0 || (size % AES_BLOCK_SIZE != 0)) {
+		// Invalid parameters.
+		return 0;
+	}
+
+	RP_D(AesNI);
+	if (d->rounds == 0) {
+		// No key set...
+		return 0;
+	}
+
+	const size_t blocks = size / AES_BLOCK_SIZE;
+	switch (d->chainingMode) {
+		case CM_ECB:
+			ecb_decrypt(d->dec_keys, d->rounds, pData, blocks);
+			break;
+
+		case CM_CBC:
+			// IV is automatically updated for the next block.
+			cbc_decrypt(d->dec_keys, d->rounds, d->iv, pData, blocks);
+			break;
+
+		case CM_CTR:
+			// ctr is automatically updated for the next block.
+			// NOTE: ctr uses the *encrypt* function, even for decryption.
+			ctr_crypt(d->enc_keys, d->rounds, d->iv, pData, blocks);
+			break;
+
+		default:
+			return 0;
+	}
+
+	return size;
+}
+
+}
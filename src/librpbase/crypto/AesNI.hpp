@@ -0,0 +1,246 @@
+/***************************************************************************
+ * ROM Properties Page shell extension. (librpbase)                        *
+ * AesNI.hpp: AES decryption class using AES-NI instructions.              *
+ *                                                                         *
+ * Copyright (c) 2016-2018 by David Korth.                                 *
+ *                                                                         *
+ * This program is free software; you can redistribute it and/or modify it *
+ * under the terms of the GNU General Public License as published by the   *
+ * Free Software Foundation; either version 2 of the License, or (at your  *
+ * option) any later version.                                              *
+ *                                                                         *
+ * This program is distributed in the hope that it will be useful, but     *
+ * WITHOUT ANY WARRANTY; without even the implied warranty of              *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the           *
+ * GNU General Public License for more details.                            *
+ *                                                                         *
+ * You should have received a copy of the GNU General Public License       *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.   *
+ ***************************************************************************/
+
+#ifndef __ROMPROPERTIES_LIBRPBASE_CRYPTO_AESNI_HPP__
+#define __ROMPROPERTIES_LIBRPBASE_CRYPTO_AESNI_HPP__
+
+#include "librpbase/config.librpbase.h"
+#include "librpbase/cpu_dispatch.h"
+#include "librpbase/cpuflags_x86.h"
+#include "IAesCipher.hpp"
+
+#if !defined(RP_CPU_I386) && !defined(RP_CPU_AMD64)
+# error AesNI is only supported on x86 CPUs.
+#endif
+
+// VAES is only used on amd64.
+#if defined(HAVE_AESNI_VAES) && defined(RP_CPU_AMD64)
+# define AESNI_HAS_VAES 1
+#endif
+
+namespace LibRpBase {
+
+class AesNIPrivate;
+class AesNI : public IAesCipher
+{
+	public:
+		AesNI();
+		virtual ~AesNI();
+
+	private:
+		typedef IAesCipher super;
+		RP_DISABLE_COPY(AesNI)
+	private:
+		friend class AesNIPrivate;
+		AesNIPrivate *const d_ptr;
+
+	public:
+		/**
+		 * Is AES-NI usable on this system?
+		 * @return True if AES-NI is usable; false if not.
+		 */
+		static inline bool isUsable(void)
+		{
+			return !!RP_CPU_HasAES();
+		}
+
+	public:
+		/**
+		 * Get the name of the AesCipher implementation.
+		 * @return Name.
+		 */
+		const char *name(void) const final;
+
+		/**
+		 * Has the cipher been initialized properly?
+		 * @return True if initialized; false if not.
+		 */
+		bool isInit(void) const final;
+
+		/**
+		 * Set the encryption key.
+		 * @param pKey	[in] Key data.
+		 * @param size	[in] Size of pKey, in bytes.
+		 * @return 0 on success; negative POSIX error code on error.
+		 */
+		int setKey(const uint8_t *RESTRICT pKey, size_t size) final;
+
+		/**
+		 * Set the cipher chaining mode.
+		 *
+		 * Note that the IV/counter must be set *after* setting
+		 * the chaining mode; otherwise, setIV() will fail.
+		 *
+		 * @param mode Cipher chaining mode.
+		 * @return 0 on success; negative POSIX error code on error.
+		 */
+		int setChainingMode(ChainingMode mode) final;
+
+		/**
+		 * Set the IV (CBC mode) or counter (CTR mode).
+		 * @param pIV	[in] IV/counter data.
+		 * @param size	[in] Size of pIV, in bytes.
+		 * @return 0 on success; negative POSIX error code on error.
+		 */
+		int setIV(const uint8_t *RESTRICT pIV, size_t size) final;
+
+		/**
+		 * Decrypt a block of data.
+		 * Key and IV/counter must be set before calling this function.
+		 *
+		 * @param pData	[in/out] Data block.
+		 * @param size	[in] Length of data block. (Must be a multiple of 16.)
+		 * @return Number of bytes decrypted on success; 0 on error.
+		 */
+		size_t decrypt(uint8_t *RESTRICT pData, size_t size) final;
+
+	public:
+		/** Bulk cipher functions. **/
+		// Round keys are stored as (rounds+1) 16-byte blocks.
+		// Decryption round keys are in reverse order, and
+		// have InvMixColumns applied. (for AESDEC)
+
+		/**
+		 * Decrypt data using AES-CBC.
+		 * AES-NI version. (8 blocks at a time)
+		 * @param pKeys		[in] Decryption round keys.
+		 * @param rounds	[in] Number of rounds.
+		 * @param pIV		[in/out] IV. Updated for the next block.
+		 * @param pData		[in/out] Data.
+		 * @param blocks	[in] Number of 16-byte blocks.
+		 */
+		static void cbc_decrypt_aesni(const uint8_t *RESTRICT pKeys, unsigned int rounds,
+			uint8_t *RESTRICT pIV, uint8_t *RESTRICT pData, size_t blocks);
+
+		/**
+		 * Encrypt or decrypt data using AES-CTR.
+		 * AES-NI version. (8 blocks at a time)
+		 * @param pKeys		[in] Encryption round keys.
+		 * @param rounds	[in] Number of rounds.
+		 * @param pCtr		[in/out] Counter. (big-endian) Updated for the next block.
+		 * @param pData		[in/out] Data.
+		 * @param blocks	[in] Number of 16-byte blocks.
+		 */
+		static void ctr_crypt_aesni(const uint8_t *RESTRICT pKeys, unsigned int rounds,
+			uint8_t *RESTRICT pCtr, uint8_t *RESTRICT pData, size_t blocks);
+
+#ifdef AESNI_HAS_VAES
+		/**
+		 * Decrypt data using AES-CBC.
+		 * VAES version. (16 blocks at a time, using 512-bit vectors)
+		 * @param pKeys		[in] Decryption round keys.
+		 * @param rounds	[in] Number of rounds.
+		 * @param pIV		[in/out] IV. Updated for the next block.
+		 * @param pData		[in/out] Data.
+		 * @param blocks	[in] Number of 16-byte blocks.
+		 */
+		static void cbc_decrypt_vaes(const uint8_t *RESTRICT pKeys, unsigned int rounds,
+			uint8_t *RESTRICT pIV, uint8_t *RESTRICT pData, size_t blocks);
+
+		/**
+		 * Encrypt or decrypt data using AES-CTR.
+		 * VAES version. (16 blocks at a time, using 512-bit vectors)
+		 * @param pKeys		[in] Encryption round keys.
+		 * @param rounds	[in] Number of rounds.
+		 * @param pCtr		[in/out] Counter. (big-endian) Updated for the next block.
+		 * @param pData		[in/out] Data.
+		 * @param blocks	[in] Number of 16-byte blocks.
+		 */
+		static void ctr_crypt_vaes(const uint8_t *RESTRICT pKeys, unsigned int rounds,
+			uint8_t *RESTRICT pCtr, uint8_t *RESTRICT pData, size_t blocks);
+#endif /* AESNI_HAS_VAES */
+
+		/**
+		 * Decrypt data using AES-CBC.
+		 * @param pKeys		[in] Decryption round keys.
+		 * @param rounds	[in] Number of rounds.
+		 * @param pIV		[in/out] IV. Updated for the next block.
+		 * @param pData		[in/out] Data.
+		 * @param blocks	[in] Number of 16-byte blocks.
+		 */
+		static IFUNC_INLINE void cbc_decrypt(const uint8_t *RESTRICT pKeys, unsigned int rounds,
+			uint8_t *RESTRICT pIV, uint8_t *RESTRICT pData, size_t blocks);
+
+		/**
+		 * Encrypt or decrypt data using AES-CTR.
+		 * @param pKeys		[in] Encryption round keys.
+		 * @param rounds	[in] Number of rounds.
+		 * @param pCtr		[in/out] Counter. (big-endian) Updated for the next block.
+		 * @param pData		[in/out] Data.
+		 * @param blocks	[in] Number of 16-byte blocks.
+		 */
+		static IFUNC_INLINE void ctr_crypt(const uint8_t *RESTRICT pKeys, unsigned int rounds,
+			uint8_t *RESTRICT pCtr, uint8_t *RESTRICT pData, size_t blocks);
+};
+
+/** Dispatch functions. **/
+
+#ifndef RP_HAS_IFUNC
+
+// System does not support IFUNC.
+// Use standard inline dispatch.
+
+/**
+ * Decrypt data using AES-CBC.
+ * @param pKeys		[in] Decryption round keys.
+ * @param rounds	[in] Number of rounds.
+ * @param pIV		[in/out] IV. Updated for the next block.
+ * @param pData		[in/out] Data.
+ * @param blocks	[in] Number of 16-byte blocks.
+ */
+inline void AesNI::cbc_decrypt(const uint8_t *RESTRICT pKeys, unsigned int rounds,
+	uint8_t *RESTRICT pIV, uint8_t *RESTRICT pData, size_t blocks)
+{
+#ifdef AESNI_HAS_VAES
+	if (RP_CPU_HasVAES512()) {
+		cbc_decrypt_vaes(pKeys, rounds, pIV, pData, blocks);
+	} else
+#endif /* AESNI_HAS_VAES */
+	{
+		cbc_decrypt_aesni(pKeys, rounds, pIV, pData, blocks);
+	}
+}
+
+/**
+ * Encrypt or decrypt data using AES-CTR.
+ * @param pKeys		[in] Encryption round keys.
+ * @param rounds	[in] Number of rounds.
+ * @param pCtr		[in/out] Counter. (big-endian) Updated for the next block.
+ * @param pData		[in/out] Data.
+ * @param blocks	[in] Number of 16-byte blocks.
+ */
+inline void AesNI::ctr_crypt(const uint8_t *RESTRICT pKeys, unsigned int rounds,
+	uint8_t *RESTRICT pCtr, uint8_t *RESTRICT pData, size_t blocks)
+{
+#ifdef AESNI_HAS_VAES
+	if (RP_CPU_HasVAES512()) {
+		ctr_crypt_vaes(pKeys, rounds, pCtr, pData, blocks);
+	} else
+#endif /* AESNI_HAS_VAES */
+	{
+		ctr_crypt_aesni(pKeys, rounds, pCtr, pData, blocks);
+	}
+}
+
+#endif /* !RP_HAS_IFUNC */
+
+}
+
+#endif /* __ROMPROPERTIES_LIBRPBASE_CRYPTO_AESNI_HPP__ */
@@ -0,0 +1,73 @@
+/***************************************************************************
+ * ROM Properties Page shell extension. (librpbase)                        *
+ * AesNI_ifunc.cpp: AesNI IFUNC resolution functions.                      *
+ *                                                                         *
+ * Copyright (c) 2016-2018 by David Korth.                                 *
+ *                                                                         *
+ * This program is free software; you can redistribute it and/or modify it *
+ * under the terms of the GNU General Public License as published by the   *
+ * Free Software Foundation; either version 2 of the License, or (at your  *
+ * option) any later version.                                              *
+ *                                                                         *
+ * This program is distributed in the hope that it will be useful, but     *
+ * WITHOUT ANY WARRANTY; without even the implied warranty of              *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the           *
+ * GNU General Public License for more details.                            *
+ *                                                                         *
+ * You should have received a copy of the GNU General Public License       *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.   *
+ ***************************************************************************/
+
+#include "librpbase/cpu_dispatch.h"
+
+#ifdef RP_HAS_IFUNC
+
+#include "AesNI.hpp"
+using LibRpBase::AesNI;
+
+// IFUNC attribute doesn't support C++ name mangling.
+extern "C" {
+
+/**
+ * IFUNC resolver function for cbc_decrypt().
+ * @return Function pointer.
+ */
+static __typeof__(&AesNI::cbc_decrypt_aesni) cbc_decrypt_resolve(void)
+{
+#ifdef AESNI_HAS_VAES
+	if (RP_CPU_HasVAES512()) {
+		return &AesNI::cbc_decrypt_vaes;
+	} else
+#endif /* AESNI_HAS_VAES */
+	{
+		return &AesNI::cbc_decrypt_aesni;
+	}
+}
+
+/**
+ * IFUNC resolver function for ctr_crypt().
+ * @return Function pointer.
+ */
+static __typeof__(&AesNI::ctr_crypt_aesni) ctr_crypt_resolve(void)
+{
+#ifdef AESNI_HAS_VAES
+	if (RP_CPU_HasVAES512()) {
+		return &AesNI::ctr_crypt_vaes;
+	} else
+#endif /* AESNI_HAS_VAES */
+	{
+		return &AesNI::ctr_crypt_aesni;
+	}
+}
+
+}
+
+void AesNI::cbc_decrypt(const uint8_t *RESTRICT pKeys, unsigned int rounds,
+	uint8_t *RESTRICT pIV, uint8_t *RESTRICT pData, size_t blocks)
+	IFUNC_ATTR(cbc_decrypt_resolve);
+
+void AesNI::ctr_crypt(const uint8_t *RESTRICT pKeys, unsigned int rounds,
+	uint8_t *RESTRICT pCtr, uint8_t *RESTRICT pData, size_t blocks)
+	IFUNC_ATTR(ctr_crypt_resolve);
+
+#endif /* RP_HAS_IFUNC */
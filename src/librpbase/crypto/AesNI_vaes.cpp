@@ -0,0 +1,175 @@
+/***************************************************************************
+ * ROM Properties Page shell extension. (librpbase)                        *
+ * AesNI_vaes.cpp: AES-NI decryption functions. (VAES-optimized)           *
+ *                                                                         *
+ * Copyright (c) 2016-2018 by David Korth.                                 *
+ *                                                                         *
+ * This program is free software; you can redistribute it and/or modify it *
+ * under the terms of the GNU General Public License as published by the   *
+ * Free Software Foundation; either version 2 of the License, or (at your  *
+ * option) any later version.                                              *
+ *                                                                         *
+ * This program is distributed in the hope that it will be useful, but     *
+ * WITHOUT ANY WARRANTY; without even the implied warranty of              *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the           *
+ * GNU General Public License for more details.                            *
+ *                                                                         *
+ * You should have received a copy of the GNU General Public License       *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.   *
+ ***************************************************************************/
+
+#include "AesNI.hpp"
+#include "../byteswap.h"
+
+// C includes. (C++ namespace)
+#include <cstring>
+
+// VAES and AVX-512 intrinsics.
+#include <immintrin.h>
+
+#define AES_BLOCK_SIZE 16
+#define AES_MAX_ROUNDS 14
+
+namespace LibRpBase {
+
+// NOTE: The unmasked forms of _mm512_broadcast_i32x4(),
+// _mm512_alignr_epi64(), and _mm512_extracti32x4_epi32() use
+// an undefined source vector, which causes false-positive
+// -Wmaybe-uninitialized warnings on gcc-12. The zero-masked
+// forms with all mask bits set are used instead.
+
+// Apply an AES round function to 16 blocks. (4 vectors)
+#define VAES_ROUND16(op, k) do { \
+	b0 = op(b0, k); b1 = op(b1, k); b2 = op(b2, k); b3 = op(b3, k); \
+} while (0)
+
+/**
+ * Load round keys, broadcast to all four 128-bit lanes.
+ * @param k		[out] Round keys.
+ * @param pKeys		[in] Round keys. (unaligned)
+ * @param rounds	[in] Number of rounds.
+ */
+static FORCEINLINE void load_keys_512(__m512i k[AES_MAX_ROUNDS+1], const uint8_t *pKeys, unsigned int rounds)
+{
+	for (unsigned int r = 0; r <= rounds; r++) {
+		k[r] = _mm512_maskz_broadcast_i32x4(0xFFFF,
+			_mm_loadu_si128(reinterpret_cast<const __m128i*>(&pKeys[r * AES_BLOCK_SIZE])));
+	}
+}
+
+/**
+ * Decrypt data using AES-CBC.
+ * VAES version. (16 blocks at a time, using 512-bit vectors)
+ * @param pKeys		[in] Decryption round keys.
+ * @param rounds	[in] Number of rounds.
+ * @param pIV		[in/out] IV. Updated for the next block.
+ * @param pData		[in/out] Data.
+ * @param blocks	[in] Number of 16-byte blocks.
+ */
+void AesNI::cbc_decrypt_vaes(const uint8_t *RESTRICT pKeys, unsigned int rounds,
+	uint8_t *RESTRICT pIV, uint8_t *RESTRICT pData, size_t blocks)
+{
+	if (blocks >= 16) {
+		__m512i k[AES_MAX_ROUNDS+1];
+		load_keys_512(k, pKeys, rounds);
+
+		// The IV is stored in the high lane, since that's
+		// where the previous cipher text block is taken from.
+		__m512i prev = _mm512_maskz_broadcast_i32x4(0xFFFF,
+			_mm_loadu_si128(reinterpret_cast<const __m128i*>(pIV)));
+		for (; blocks >= 16; blocks -= 16, pData += 16*AES_BLOCK_SIZE) {
+			const __m512i c0 = _mm512_loadu_si512(pData + 0*64);
+			const __m512i c1 = _mm512_loadu_si512(pData + 1*64);
+			const __m512i c2 = _mm512_loadu_si512(pData + 2*64);
+			const __m512i c3 = _mm512_loadu_si512(pData + 3*64);
+
+			__m512i b0 = _mm512_xor_si512(c0, k[0]);
+			__m512i b1 = _mm512_xor_si512(c1, k[0]);
+			__m512i b2 = _mm512_xor_si512(c2, k[0]);
+			__m512i b3 = _mm512_xor_si512(c3, k[0]);
+			for (unsigned int r = 1; r < rounds; r++) {
+				VAES_ROUND16(_mm512_aesdec_epi128, k[r]);
+			}
+			VAES_ROUND16(_mm512_aesdeclast_epi128, k[rounds]);
+
+			// Previous cipher text blocks: Shift each vector
+			// up by one lane, using the last lane of the
+			// previous vector as the first lane.
+			_mm512_storeu_si512(pData + 0*64, _mm512_xor_si512(b0, _mm512_maskz_alignr_epi64(0xFF, c0, prev, 6)));
+			_mm512_storeu_si512(pData + 1*64, _mm512_xor_si512(b1, _mm512_maskz_alignr_epi64(0xFF, c1, c0, 6)));
+			_mm512_storeu_si512(pData + 2*64, _mm512_xor_si512(b2, _mm512_maskz_alignr_epi64(0xFF, c2, c1, 6)));
+			_mm512_storeu_si512(pData + 3*64, _mm512_xor_si512(b3, _mm512_maskz_alignr_epi64(0xFF, c3, c2, 6)));
+			prev = c3;
+		}
+
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(pIV), _mm512_maskz_extracti32x4_epi32(0xF, prev, 3));
+	}
+
+	if (blocks > 0) {
+		// Decrypt the remaining blocks using AES-NI.
+		cbc_decrypt_aesni(pKeys, rounds, pIV, pData, blocks);
+	}
+}
+
+/**
+ * Encrypt or decrypt data using AES-CTR.
+ * VAES version. (16 blocks at a time, using 512-bit vectors)
+ * @param pKeys		[in] Encryption round keys.
+ * @param rounds	[in] Number of rounds.
+ * @param pCtr		[in/out] Counter. (big-endian) Updated for the next block.
+ * @param pData		[in/out] Data.
+ * @param blocks	[in] Number of 16-byte blocks.
+ */
+void AesNI::ctr_crypt_vaes(const uint8_t *RESTRICT pKeys, unsigned int rounds,
+	uint8_t *RESTRICT pCtr, uint8_t *RESTRICT pData, size_t blocks)
+{
+	if (blocks >= 16) {
+		__m512i k[AES_MAX_ROUNDS+1];
+		load_keys_512(k, pKeys, rounds);
+
+		// The counter is a 128-bit big-endian value.
+		uint64_t ctr_hi, ctr_lo;
+		memcpy(&ctr_hi, &pCtr[0], sizeof(ctr_hi));
+		memcpy(&ctr_lo, &pCtr[8], sizeof(ctr_lo));
+		ctr_hi = be64_to_cpu(ctr_hi);
+		ctr_lo = be64_to_cpu(ctr_lo);
+
+		// Counter blocks for 16 blocks.
+		ALIGNED_VAR(64, uint64_t ctrbuf[32]);
+		for (; blocks >= 16; blocks -= 16, pData += 16*AES_BLOCK_SIZE) {
+			for (unsigned int i = 0; i < 32; i += 2) {
+				ctrbuf[i+0] = cpu_to_be64(ctr_hi);
+				ctrbuf[i+1] = cpu_to_be64(ctr_lo);
+				if (++ctr_lo == 0) {
+					ctr_hi++;
+				}
+			}
+
+			__m512i b0 = _mm512_xor_si512(_mm512_load_si512(&ctrbuf[ 0]), k[0]);
+			__m512i b1 = _mm512_xor_si512(_mm512_load_si512(&ctrbuf[ 8]), k[0]);
+			__m512i b2 = _mm512_xor_si512(_mm512_load_si512(&ctrbuf[16]), k[0]);
+			__m512i b3 = _mm512_xor_si512(_mm512_load_si512(&ctrbuf[24]), k[0]);
+			for (unsigned int r = 1; r < rounds; r++) {
+				VAES_ROUND16(_mm512_aesenc_epi128, k[r]);
+			}
+			VAES_ROUND16(_mm512_aesenclast_epi128, k[rounds]);
+
+			_mm512_storeu_si512(pData + 0*64, _mm512_xor_si512(b0, _mm512_loadu_si512(pData + 0*64)));
+			_mm512_storeu_si512(pData + 1*64, _mm512_xor_si512(b1, _mm512_loadu_si512(pData + 1*64)));
+			_mm512_storeu_si512(pData + 2*64, _mm512_xor_si512(b2, _mm512_loadu_si512(pData + 2*64)));
+			_mm512_storeu_si512(pData + 3*64, _mm512_xor_si512(b3, _mm512_loadu_si512(pData + 3*64)));
+		}
+
+		ctr_hi = cpu_to_be64(ctr_hi);
+		ctr_lo = cpu_to_be64(ctr_lo);
+		memcpy(&pCtr[0], &ctr_hi, sizeof(ctr_hi));
+		memcpy(&pCtr[8], &ctr_lo, sizeof(ctr_lo));
+	}
+
+	if (blocks > 0) {
+		// Process the remaining blocks using AES-NI.
+		ctr_crypt_aesni(pKeys, rounds, pCtr, pData, blocks);
+	}
+}
+
+}
@@ -0,0 +1,532 @@
+/***************************************************************************
+ * ROM Properties Page shell extension. (librpbase)                        *
+ * AesParallel.cpp: Multi-threaded AES decryption.                         *
+ *                                                                         *
+ * Copyright (c) 2016-2018 by David Korth.                                 *
+ *                                                                         *
+ * This program is free software; you can redistribute it and/or modify it *
+ * under the terms of the GNU General Public License as published by the   *
+ * Free Software Foundation; either version 2 of the License, or (at your  *
+ * option) any later version.                                              *
+ *                                                                         *
+ * This program is distributed in the hope that it will be useful, but     *
+ * WITHOUT ANY WARRANTY; without even the implied warranty of              *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the           *
+ * GNU General Public License for more details.                            *
+ *                                                                         *
+ * You should have received a copy of the GNU General Public License       *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.   *
+ ***************************************************************************/
+
+#include "AesParallel.hpp"
+#include "AesCipherFactory.hpp"
+
+// librpbase
+#include "threads/Atomics.h"
+#include "threads/Mutex.hpp"
+#include "threads/Semaphore.hpp"
+#include "threads/Thread.hpp"
+#include "threads/pthread_once.h"
+
+// C includes. (C++ namespace)
+#include <cassert>
+#include <cerrno>
+#include <cstring>
+
+// C++ includes.
+#include <deque>
+#include <memory>
+#include <vector>
+using std::deque;
+using std::unique_ptr;
+using std::vector;
+
+namespace LibRpBase {
+
+// Chunk size for parallel decryption.
+// Chunks are assigned to threads dynamically,
+// so this is small enough to balance the load.
+#define AES_PARALLEL_CHUNK_SIZE (64*1024)
+
+// Minimum size for parallel decryption.
+#define AES_PARALLEL_MIN_SIZE (256*1024)
+
+// Maximum number of worker threads.
+#define AES_PARALLEL_MAX_THREADS 16
+
+/**
+ * Parallel decryption job.
+ * Owned by the calling thread.
+ */
+struct AesParallelJob
+{
+	IAesCipher::ChainingMode mode;
+	uint8_t key[32];
+	size_t key_len;
+
+	uint8_t *data;
+	size_t size;
+
+	// Per-chunk IVs or counters. (16 bytes per chunk)
+	// ECB doesn't use these.
+	vector<uint8_t> ivs;
+
+	volatile int next_chunk;	// Next chunk to decrypt. (atomic)
+	int chunk_count;		// Total number of chunks.
+	volatile int errors;		// Number of chunks that failed. (atomic)
+
+	// The following fields are protected by the pool mutex.
+	int workers;			// Number of workers processing this job.
+	bool waiting;			// True if the caller is waiting for workers.
+
+	Semaphore done;			// Released when the last worker finishes.
+
+	AesParallelJob()
+		: mode(IAesCipher::CM_ECB)
+		, key_len(0)
+		, data(nullptr)
+		, size(0)
+		, next_chunk(0)
+		, chunk_count(0)
+		, errors(0)
+		, workers(0)
+		, waiting(false)
+		, done(0)
+	{ }
+
+	~AesParallelJob()
+	{
+		// Don't leave the key in memory.
+		memset(key, 0, sizeof(key));
+	}
+
+	private:
+		RP_DISABLE_COPY(AesParallelJob)
+
+	public:
+		/**
+		 * Decrypt chunks until none are left.
+		 * @param cipher Cipher owned by the current thread.
+		 */
+		void run(IAesCipher *cipher);
+};
+
+/**
+ * Decrypt chunks until none are left.
+ * @param cipher Cipher owned by the current thread.
+ */
+void AesParallelJob::run(IAesCipher *cipher)
+{
+	// NOTE: The key is set for each job, since a worker's
+	// cipher may have been used for a different job.
+	bool keySet = false;
+
+	int chunk;
+	while ((chunk = ATOMIC_INC_FETCH(&next_chunk) - 1) < chunk_count) {
+		if (!keySet) {
+			if (!cipher ||
+			    cipher->setChainingMode(mode) != 0 ||
+			    cipher->setKey(key, key_len) != 0)
+			{
+				ATOMIC_INC_FETCH(&errors);
+				continue;
+			}
+			keySet = true;
+		}
+
+		const size_t offset = static_cast<size_t>(chunk) * AES_PARALLEL_CHUNK_SIZE;
+		size_t len = size - offset;
+		if (len > AES_PARALLEL_CHUNK_SIZE) {
+			len = AES_PARALLEL_CHUNK_SIZE;
+		}
+
+		if (mode != IAesCipher::CM_ECB) {
+			if (cipher->setIV(&ivs[chunk * 16], 16) != 0) {
+				ATOMIC_INC_FETCH(&errors);
+				continue;
+			}
+		}
+		if (cipher->decrypt(&data[offset], len) != len) {
+			ATOMIC_INC_FETCH(&errors);
+		}
+	}
+}
+
+/**
+ * Worker thread pool.
+ * A single pool is shared by all AesParallel users.
+ *
+ * The pool is created on first use and destroyed by
+ * AesParallel::shutdown(). On Windows, this is called by
+ * DllCanUnloadNow(), since joining threads while the
+ * loader lock is held can deadlock. On other systems,
+ * it's called by AesParallelUnloader when the library
+ * is unloaded (dlclose) or when the process exits.
+ */
+class AesParallelPool
+{
+	public:
+		/**
+		 * Create the thread pool and start the worker threads.
+		 * @param count Number of worker threads.
+		 */
+		explicit AesParallelPool(unsigned int count);
+
+		/**
+		 * Stop the worker threads and delete the thread pool.
+		 * The pool must not have any pending jobs.
+		 */
+		~AesParallelPool();
+
+	private:
+		RP_DISABLE_COPY(AesParallelPool)
+
+	public:
+		/**
+		 * Worker thread.
+		 * @param param Thread pool.
+		 */
+		static void worker(void *param);
+
+		/**
+		 * Run a job using the worker threads.
+		 * The calling thread also decrypts chunks.
+		 * @param job Job.
+		 */
+		void run(AesParallelJob *job);
+
+	public:
+		Thread threads[AES_PARALLEL_MAX_THREADS];
+		unsigned int threadCount;	// Number of running threads.
+
+		// Pending jobs. There is one entry for each worker
+		// that may be assigned to the job.
+		Mutex mutex;
+		deque<AesParallelJob*> queue;
+		Semaphore queueSem;	// Number of entries in the queue.
+		bool quit;
+};
+
+// Number of worker threads to use.
+// Determined once, since the pool may be created
+// and destroyed multiple times.
+static unsigned int pool_thread_count = 0;
+static pthread_once_t pool_once_control = PTHREAD_ONCE_INIT;
+
+// Shared thread pool.
+// Protected by pool_mutex.
+static Mutex pool_mutex;
+static AesParallelPool *pool = nullptr;
+static int pool_users = 0;	// Number of decrypt() calls using the pool.
+
+#ifndef _WIN32
+/**
+ * Stop the worker threads when the library is unloaded.
+ *
+ * The frontends are plugins, and librpbase is statically
+ * linked into each of them, so dlclose() would unmap the
+ * code that the worker threads are waiting in. Static
+ * destructors run before the library is unmapped.
+ *
+ * NOTE: This must be defined after pool_mutex, since
+ * static objects are destroyed in reverse order.
+ */
+class AesParallelUnloader
+{
+	public:
+		AesParallelUnloader() { }
+		~AesParallelUnloader()
+		{
+			// NOTE: If decryption is still in progress,
+			// the threads can't be stopped here.
+			AesParallel::shutdown();
+		}
+
+	private:
+		RP_DISABLE_COPY(AesParallelUnloader)
+};
+static AesParallelUnloader aesParallelUnloader;
+#endif /* !_WIN32 */
+
+/**
+ * Determine the number of worker threads to use.
+ * Called by pthread_once().
+ */
+static void initPoolThreadCount(void)
+{
+	// The calling thread also decrypts chunks,
+	// so one less worker thread is needed.
+	unsigned int count = Thread::cpuCount() - 1;
+	if (count > AES_PARALLEL_MAX_THREADS) {
+		count = AES_PARALLEL_MAX_THREADS;
+	}
+	pool_thread_count = count;
+}
+
+/**
+ * Create the thread pool and start the worker threads.
+ * @param count Number of worker threads.
+ */
+AesParallelPool::AesParallelPool(unsigned int count)
+	: threadCount(0)
+	, queueSem(0)
+	, quit(false)
+{
+	assert(count <= AES_PARALLEL_MAX_THREADS);
+	for (; threadCount < count; threadCount++) {
+		if (threads[threadCount].start(worker, this) != 0) {
+			// Unable to start the thread.
+			// Use the threads that were started.
+			break;
+		}
+	}
+}
+
+/**
+ * Stop the worker threads and delete the thread pool.
+ * The pool must not have any pending jobs.
+ */
+AesParallelPool::~AesParallelPool()
+{
+	{
+		MutexLocker locker(mutex);
+		assert(queue.empty());
+		quit = true;
+	}
+	for (unsigned int i = 0; i < threadCount; i++) {
+		queueSem.release();
+	}
+	for (unsigned int i = 0; i < threadCount; i++) {
+		threads[i].join();
+	}
+}
+
+/**
+ * Worker thread.
+ * @param param Thread pool.
+ */
+void AesParallelPool::worker(void *param)
+{
+	AesParallelPool *const pool = static_cast<AesParallelPool*>(param);
+
+	// Each worker has its own cipher.
+	unique_ptr<IAesCipher> cipher(AesCipherFactory::create());
+
+	while (true) {
+		pool->queueSem.obtain();
+
+		AesParallelJob *job;
+		{
+			MutexLocker locker(pool->mutex);
+			if (pool->quit) {
+				break;
+			}
+			if (pool->queue.empty()) {
+				// Entries for a job that was completed
+				// by the calling thread were removed.
+				continue;
+			}
+			job = pool->queue.front();
+			pool->queue.pop_front();
+			job->workers++;
+		}
+
+		job->run(cipher.get());
+
+		MutexLocker locker(pool->mutex);
+		if (--job->workers == 0 && job->waiting) {
+			// Last worker for this job.
+			job->done.release();
+		}
+	}
+}
+
+/**
+ * Run a job using the worker threads.
+ * The calling thread also decrypts chunks.
+ * @param job Job.
+ */
+void AesParallelPool::run(AesParallelJob *job)
+{
+	int entries = job->chunk_count - 1;
+	if (entries > static_cast<int>(threadCount)) {
+		entries = static_cast<int>(threadCount);
+	}
+	{
+		MutexLocker locker(mutex);
+		for (int i = 0; i < entries; i++) {
+			queue.push_back(job);
+		}
+	}
+	for (int i = 0; i < entries; i++) {
+		queueSem.release();
+	}
+
+	// Decrypt chunks on this thread.
+	unique_ptr<IAesCipher> cipher(AesCipherFactory::create());
+	job->run(cipher.get());
+
+	// All chunks have been assigned. Remove any entries
+	// that haven't been picked up by the workers, then
+	// wait for the workers that are still decrypting.
+	bool wait;
+	{
+		MutexLocker locker(mutex);
+		for (auto iter = queue.begin(); iter != queue.end(); ) {
+			if (*iter == job) {
+				iter = queue.erase(iter);
+			} else {
+				++iter;
+			}
+		}
+		wait = (job->workers > 0);
+		job->waiting = wait;
+	}
+	if (wait) {
+		job->done.obtain();
+	}
+}
+
+/** AesParallel **/
+
+/**
+ * Is parallel decryption worthwhile for the specified size?
+ * Small reads, e.g. headers, should be decrypted on
+ * the caller's thread.
+ * @param size Size of the data to decrypt, in bytes.
+ * @return True if parallel decryption should be used.
+ */
+bool AesParallel::isWorthwhile(size_t size)
+{
+	if (size < AES_PARALLEL_MIN_SIZE)
+		return false;
+
+	pthread_once(&pool_once_control, initPoolThreadCount);
+	return (pool_thread_count > 0);
+}
+
+/**
+ * Decrypt a block of data using multiple threads.
+ * The data is decrypted in place.
+ *
+ * @param mode		[in] Chaining mode.
+ * @param pKey		[in] Key data.
+ * @param key_len	[in] Size of pKey, in bytes.
+ * @param pIV		[in] IV (CBC) or counter (CTR). (Ignored for ECB.)
+ * @param pData		[in/out] Data block.
+ * @param size		[in] Length of data block. (Must be a multiple of 16.)
+ * @return Number of bytes decrypted on success; 0 on error.
+ */
+size_t AesParallel::decrypt(IAesCipher::ChainingMode mode,
+	const uint8_t *pKey, size_t key_len, const uint8_t *pIV,
+	uint8_t *pData, size_t size)
+{
+	assert(pKey != nullptr);
+	assert(pData != nullptr);
+	assert(size % 16 == 0);
+	if (!pKey || !pData || size == 0 || size % 16 != 0 ||
+	    key_len > 32 || (mode != IAesCipher::CM_ECB && !pIV))
+	{
+		// Invalid parameters.
+		return 0;
+	}
+
+	AesParallelJob job;
+	job.mode = mode;
+	memcpy(job.key, pKey, key_len);
+	job.key_len = key_len;
+	job.data = pData;
+	job.size = size;
+	job.chunk_count = static_cast<int>(
+		(size + AES_PARALLEL_CHUNK_SIZE - 1) / AES_PARALLEL_CHUNK_SIZE);
+
+	switch (mode) {
+		case IAesCipher::CM_ECB:
+			break;
+
+		case IAesCipher::CM_CBC:
+			// Each chunk's IV is the last cipher text block
+			// of the previous chunk. These must be saved
+			// before decrypting, since decryption is in place.
+			job.ivs.resize(job.chunk_count * 16);
+			memcpy(&job.ivs[0], pIV, 16);
+			for (int i = 1; i < job.chunk_count; i++) {
+				memcpy(&job.ivs[i * 16],
+					&pData[(static_cast<size_t>(i) * AES_PARALLEL_CHUNK_SIZE) - 16], 16);
+			}
+			break;
+
+		case IAesCipher::CM_CTR: {
+			// Each chunk's counter is the base counter plus
+			// the number of blocks preceding the chunk.
+			// The counter is a 128-bit big-endian value.
+			job.ivs.resize(job.chunk_count * 16);
+			uint8_t ctr[16];
+			memcpy(ctr, pIV, sizeof(ctr));
+			for (int i = 0; i < job.chunk_count; i++) {
+				memcpy(&job.ivs[i * 16], ctr, sizeof(ctr));
+
+				unsigned int carry = AES_PARALLEL_CHUNK_SIZE / 16;
+				for (int j = 15; j >= 0 && carry != 0; j--) {
+					carry += ctr[j];
+					ctr[j] = static_cast<uint8_t>(carry);
+					carry >>= 8;
+				}
+			}
+			break;
+		}
+
+		default:
+			assert(!"Invalid chaining mode.");
+			return 0;
+	}
+
+	// Get the thread pool, creating it if necessary.
+	pthread_once(&pool_once_control, initPoolThreadCount);
+	AesParallelPool *p;
+	{
+		MutexLocker locker(pool_mutex);
+		if (!pool) {
+			pool = new AesParallelPool(pool_thread_count);
+		}
+		p = pool;
+		pool_users++;
+	}
+
+	p->run(&job);
+
+	{
+		MutexLocker locker(pool_mutex);
+		pool_users--;
+	}
+	return (job.errors == 0 ? size : 0);
+}
+
+/**
+ * Stop the worker threads.
+ *
+ * On Windows, this must be called before the library is
+ * unloaded, e.g. from DllCanUnloadNow(). It must NOT be
+ * called while the loader lock is held, e.g. from DllMain().
+ * On other systems, it's called automatically when the
+ * library is unloaded or when the process exits.
+ *
+ * The worker threads will be restarted by the next call
+ * to decrypt(), so this can be called at any time.
+ *
+ * @return 0 on success; -EBUSY if the worker threads are in use.
+ */
+int AesParallel::shutdown(void)
+{
+	MutexLocker locker(pool_mutex);
+	if (pool_users > 0) {
+		// Decryption is in progress.
+		return -EBUSY;
+	}
+
+	delete pool;
+	pool = nullptr;
+	return 0;
+}
+
+}
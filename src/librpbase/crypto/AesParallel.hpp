@@ -0,0 +1,97 @@
+/***************************************************************************
+ * ROM Properties Page shell extension. (librpbase)                        *
+ * AesParallel.hpp: Multi-threaded AES decryption.                         *
+ *                                                                         *
+ * Copyright (c) 2016-2018 by David Korth.                                 *
+ *                                                                         *
+ * This program is free software; you can redistribute it and/or modify it *
+ * under the terms of the GNU General Public License as published by the   *
+ * Free Software Foundation; either version 2 of the License, or (at your  *
+ * option) any later version.                                              *
+ *                                                                         *
+ * This program is distributed in the hope that it will be useful, but     *
+ * WITHOUT ANY WARRANTY; without even the implied warranty of              *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the           *
+ * GNU General Public License for more details.                            *
+ *                                                                         *
+ * You should have received a copy of the GNU General Public License       *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.   *
+ ***************************************************************************/
+
+#ifndef __ROMPROPERTIES_LIBRPBASE_CRYPTO_AESPARALLEL_HPP__
+#define __ROMPROPERTIES_LIBRPBASE_CRYPTO_AESPARALLEL_HPP__
+
+#include "IAesCipher.hpp"
+
+namespace LibRpBase {
+
+/**
+ * Multi-threaded AES decryption.
+ *
+ * Large buffers are split into chunks, which are decrypted
+ * by a process-wide pool of worker threads. The calling
+ * thread also decrypts chunks while it waits.
+ *
+ * The worker threads are started on first use. They must be
+ * stopped by calling shutdown() before the library is unloaded.
+ * On Windows, this must be done by the caller. On other systems,
+ * this is done automatically by a static destructor.
+ *
+ * CTR chunks use counters derived from the chunk offset.
+ * CBC chunks use the preceding cipher text block as the IV.
+ * (Both are captured before any decryption takes place.)
+ */
+class AesParallel
+{
+	private:
+		AesParallel();
+		~AesParallel();
+	private:
+		RP_DISABLE_COPY(AesParallel)
+
+	public:
+		/**
+		 * Is parallel decryption worthwhile for the specified size?
+		 * Small reads, e.g. headers, should be decrypted on
+		 * the caller's thread.
+		 * @param size Size of the data to decrypt, in bytes.
+		 * @return True if parallel decryption should be used.
+		 */
+		static bool isWorthwhile(size_t size);
+
+		/**
+		 * Decrypt a block of data using multiple threads.
+		 * The data is decrypted in place.
+		 *
+		 * @param mode		[in] Chaining mode.
+		 * @param pKey		[in] Key data.
+		 * @param key_len	[in] Size of pKey, in bytes.
+		 * @param pIV		[in] IV (CBC) or counter (CTR). (Ignored for ECB.)
+		 * @param pData		[in/out] Data block.
+		 * @param size		[in] Length of data block. (Must be a multiple of 16.)
+		 * @return Number of bytes decrypted on success; 0 on error.
+		 */
+		static size_t decrypt(IAesCipher::ChainingMode mode,
+			const uint8_t *pKey, size_t key_len, const uint8_t *pIV,
+			uint8_t *pData, size_t size);
+
+		/**
+		 * Stop the worker threads.
+		 *
+		 * On Windows, this must be called before the library is
+		 * unloaded, e.g. from DllCanUnloadNow(). It must NOT be
+		 * called while the loader lock is held, e.g. from DllMain().
+		 * On other systems, it's called automatically when the
+		 * library is unloaded or when the process exits.
+		 *
+		 * The worker threads will be restarted by the next call
+		 * to decrypt(), so this can be called at any time.
+		 *
+		 * @return 0 on success; -EBUSY if the worker threads are in use.
+		 */
+		static int shutdown(void);
+};
+
+}
+
+#endif /* __ROMPROPERTIES_LIBRPBASE_CRYPTO_AESPARALLEL_HPP__ */
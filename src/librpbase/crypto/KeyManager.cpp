@@ -30,13 +30,13 @@
 #include <cstring>
 
 // C++ includes.
-#include <memory>
 #include <string>
 #include <unordered_map>
 #include <utility>
+#include <vector>
 using std::string;
-using std::unique_ptr;
 using std::unordered_map;
+using std::vector;
 
 #include "IAesCipher.hpp"
 #include "AesCipherFactory.hpp"
@@ -51,6 +51,9 @@ class KeyManagerPrivate : public ConfReaderPrivate
 {
 	public:
 		KeyManagerPrivate();
+#ifdef ENABLE_DECRYPTION
+		~KeyManagerPrivate();
+#endif /* ENABLE_DECRYPTION */
 
 	private:
 		typedef ConfReaderPrivate super;
@@ -106,6 +109,51 @@ class KeyManagerPrivate : public ConfReaderPrivate
 		 * - Value: Verification result.
 		 */
 		unordered_map<string, uint8_t> mapInvalidKeyNames;
+
+	public:
+		/** Cipher cache **/
+
+		// Cache mutex.
+		// Protects vCiphers and mapVerifyResults.
+		Mutex mtxCache;
+
+		// Cached cipher.
+		struct CachedCipher {
+			IAesCipher *cipher;	// Cipher, with the key already set.
+			uint8_t key[32];	// Key data.
+			uint8_t keyLen;		// Key length.
+			bool inUse;		// True if the cipher was obtained with getCipher().
+		};
+
+		/**
+		 * Cached ciphers.
+		 * Ordered from least recently used to most recently used.
+		 * Ciphers that are in use are never evicted, so this may
+		 * temporarily contain more than CIPHER_CACHE_MAX entries.
+		 */
+		vector<CachedCipher> vCiphers;
+		static const unsigned int CIPHER_CACHE_MAX = 16;
+
+		/**
+		 * Map of verified keys to verification results.
+		 * - Key: Key data, followed by the verification data.
+		 * - Value: Verification result.
+		 */
+		unordered_map<string, uint8_t> mapVerifyResults;
+		static const unsigned int VERIFY_CACHE_MAX = 256;
+
+		/**
+		 * Mark a cached cipher as the most recently used.
+		 * mtxCache must be locked by the caller.
+		 * @param idx vCiphers index.
+		 */
+		void touchCipher(size_t idx);
+
+		/**
+		 * Evict unused ciphers until the cache is within its size limit.
+		 * mtxCache must be locked by the caller.
+		 */
+		void trimCipherCache(void);
 #endif /* ENABLE_DECRYPTION */
 };
 
@@ -129,6 +177,48 @@ KeyManagerPrivate::KeyManagerPrivate()
 	: super("keys.conf")
 { }
 
+#ifdef ENABLE_DECRYPTION
+KeyManagerPrivate::~KeyManagerPrivate()
+{
+	for (auto iter = vCiphers.cbegin(); iter != vCiphers.cend(); ++iter) {
+		delete iter->cipher;
+	}
+}
+
+/**
+ * Mark a cached cipher as the most recently used.
+ * mtxCache must be locked by the caller.
+ * @param idx vCiphers index.
+ */
+void KeyManagerPrivate::touchCipher(size_t idx)
+{
+	assert(idx < vCiphers.size());
+	if (idx + 1 < vCiphers.size()) {
+		const CachedCipher entry = vCiphers[idx];
+		vCiphers.erase(vCiphers.begin() + idx);
+		vCiphers.push_back(entry);
+	}
+}
+
+/**
+ * Evict unused ciphers until the cache is within its size limit.
+ * mtxCache must be locked by the caller.
+ */
+void KeyManagerPrivate::trimCipherCache(void)
+{
+	// Evict the least recently used ciphers first.
+	auto iter = vCiphers.begin();
+	while (vCiphers.size() > CIPHER_CACHE_MAX && iter != vCiphers.end()) {
+		if (iter->inUse) {
+			++iter;
+			continue;
+		}
+		delete iter->cipher;
+		iter = vCiphers.erase(iter);
+	}
+}
+#endif /* ENABLE_DECRYPTION */
+
 /**
  * Reset the configuration to the default values.
  */
@@ -402,43 +492,186 @@ KeyManager::VerifyResult KeyManager::getAndVerify(const char *keyName, KeyData_t
 		return VERIFY_KEY_INVALID;
 	}
 
-	// Decrypt the test data.
-	// TODO: Keep this IAesCipher instance around?
-	unique_ptr<IAesCipher> cipher(AesCipherFactory::create());
-	if (!cipher) {
-		// Unable to create the IAesCipher.
-		return VERFIY_IAESCIPHER_INIT_ERR;
+	// Verify the key.
+	return verifyKey(pKeyData->key, pKeyData->length, pVerifyData, verifyLen);
+}
+
+/**
+ * Verify an encryption key.
+ *
+ * This will decrypt the specified block of data
+ * using the key with AES-128-ECB, which will result
+ * in the 16-byte string "AES-128-ECB-TEST".
+ *
+ * Results are cached, so verifying the same key
+ * with the same data again doesn't decrypt anything.
+ *
+ * @param pKey		[in] Key data.
+ * @param keyLen	[in] Length of pKey. (Must be 16, 24, or 32.)
+ * @param pVerifyData	[in] Verification data block.
+ * @param verifyLen	[in] Length of pVerifyData. (Must be 16.)
+ * @return VerifyResult.
+ */
+KeyManager::VerifyResult KeyManager::verifyKey(const uint8_t *pKey, unsigned int keyLen,
+	const uint8_t *pVerifyData, unsigned int verifyLen) const
+{
+	assert(pKey);
+	assert(pVerifyData);
+	assert(verifyLen == 16);
+	if (!pKey || !pVerifyData || verifyLen != 16) {
+		// Invalid parameters.
+		return VERIFY_INVALID_PARAMS;
+	} else if (keyLen != 16 && keyLen != 24 && keyLen != 32) {
+		// Key length is invalid.
+		return VERIFY_KEY_INVALID;
 	}
 
-	// Set cipher parameters.
-	int ret = cipher->setChainingMode(IAesCipher::CM_ECB);
-	if (ret != 0) {
+	// Check if this key was already verified.
+	RP_D(KeyManager);
+	string cacheKey(reinterpret_cast<const char*>(pKey), keyLen);
+	cacheKey.append(reinterpret_cast<const char*>(pVerifyData), verifyLen);
+	{
+		MutexLocker mtxLocker(d->mtxCache);
+		auto iter = d->mapVerifyResults.find(cacheKey);
+		if (iter != d->mapVerifyResults.end()) {
+			return (VerifyResult)iter->second;
+		}
+	}
+
+	// Get a cipher for this key.
+	IAesCipher *const cipher = getCipher(pKey, keyLen);
+	if (!cipher) {
+		// Unable to create the IAesCipher.
 		return VERFIY_IAESCIPHER_INIT_ERR;
 	}
-	ret = cipher->setKey(pKeyData->key, pKeyData->length);
-	if (ret != 0) {
+	if (cipher->setChainingMode(IAesCipher::CM_ECB) != 0) {
+		releaseCipher(cipher);
 		return VERFIY_IAESCIPHER_INIT_ERR;
 	}
 
 	// Decrypt the test data.
 	// NOTE: IAesCipher decrypts in place, so we need to
 	// make a temporary copy.
-	unique_ptr<uint8_t[]> tmpData(new uint8_t[verifyLen]);
-	memcpy(tmpData.get(), pVerifyData, verifyLen);
-	size_t size = cipher->decrypt(tmpData.get(), verifyLen);
-	if (size != verifyLen) {
+	uint8_t tmpData[16];
+	memcpy(tmpData, pVerifyData, sizeof(tmpData));
+	size_t size = cipher->decrypt(tmpData, sizeof(tmpData));
+	releaseCipher(cipher);
+	if (size != sizeof(tmpData)) {
 		// Decryption failed.
 		return VERIFY_IAESCIPHER_DECRYPT_ERR;
 	}
 
 	// Verify the test data.
-	if (memcmp(tmpData.get(), verifyTestString, verifyLen) != 0) {
-		// Verification failed.
-		return VERIFY_WRONG_KEY;
+	const VerifyResult res = (memcmp(tmpData, verifyTestString, sizeof(tmpData)) == 0
+		? VERIFY_OK
+		: VERIFY_WRONG_KEY);
+
+	// Save the result.
+	// NOTE: The cache is simply cleared if it's full.
+	// Only a handful of keys are verified in practice.
+	MutexLocker mtxLocker(d->mtxCache);
+	if (d->mapVerifyResults.size() >= KeyManagerPrivate::VERIFY_CACHE_MAX) {
+		d->mapVerifyResults.clear();
 	}
+	d->mapVerifyResults.insert(std::make_pair(std::move(cacheKey), static_cast<uint8_t>(res)));
+	return res;
+}
 
-	// Test data verified.
-	return VERIFY_OK;
+/**
+ * Get an AES cipher with the specified key.
+ *
+ * Recently-released ciphers are cached along with their
+ * expanded key schedules, so requesting a key that was
+ * used recently doesn't create a new cipher or expand
+ * the key again.
+ *
+ * The key must not be changed by the caller.
+ * The chaining mode and IV are NOT reset, so they
+ * must be set by the caller before decrypting.
+ *
+ * When the cipher is no longer needed, it must be
+ * returned using releaseCipher().
+ *
+ * @param pKey	[in] Key data.
+ * @param keyLen	[in] Length of pKey. (Must be 16, 24, or 32.)
+ * @return IAesCipher, or nullptr on error.
+ */
+IAesCipher *KeyManager::getCipher(const uint8_t *pKey, unsigned int keyLen) const
+{
+	assert(pKey);
+	assert(keyLen == 16 || keyLen == 24 || keyLen == 32);
+	if (!pKey || (keyLen != 16 && keyLen != 24 && keyLen != 32)) {
+		// Invalid parameters.
+		return nullptr;
+	}
+
+	// Check for an unused cipher with the same key.
+	// NOTE: d_ptr is not const, so the cache can be
+	// modified in this const function.
+	RP_D(KeyManager);
+	{
+		MutexLocker mtxLocker(d->mtxCache);
+		for (size_t i = d->vCiphers.size(); i > 0; i--) {
+			KeyManagerPrivate::CachedCipher &entry = d->vCiphers[i-1];
+			if (!entry.inUse && entry.keyLen == keyLen &&
+			    !memcmp(entry.key, pKey, keyLen))
+			{
+				// Found a cached cipher.
+				entry.inUse = true;
+				IAesCipher *const cipher = entry.cipher;
+				d->touchCipher(i-1);
+				return cipher;
+			}
+		}
+	}
+
+	// Not cached. Create a new cipher.
+	// NOTE: The key is expanded without holding the mutex.
+	IAesCipher *const cipher = AesCipherFactory::create();
+	if (!cipher) {
+		return nullptr;
+	} else if (!cipher->isInit() || cipher->setKey(pKey, keyLen) != 0) {
+		delete cipher;
+		return nullptr;
+	}
+
+	KeyManagerPrivate::CachedCipher entry;
+	entry.cipher = cipher;
+	memcpy(entry.key, pKey, keyLen);
+	entry.keyLen = static_cast<uint8_t>(keyLen);
+	entry.inUse = true;
+
+	MutexLocker mtxLocker(d->mtxCache);
+	d->vCiphers.push_back(entry);
+	d->trimCipherCache();
+	return cipher;
+}
+
+/**
+ * Return a cipher obtained from getCipher() to the cache.
+ * @param cipher IAesCipher. (If nullptr, nothing is done.)
+ */
+void KeyManager::releaseCipher(IAesCipher *cipher) const
+{
+	if (!cipher)
+		return;
+
+	RP_D(KeyManager);
+	MutexLocker mtxLocker(d->mtxCache);
+	for (size_t i = d->vCiphers.size(); i > 0; i--) {
+		KeyManagerPrivate::CachedCipher &entry = d->vCiphers[i-1];
+		if (entry.cipher == cipher) {
+			assert(entry.inUse);
+			entry.inUse = false;
+			d->touchCipher(i-1);
+			d->trimCipherCache();
+			return;
+		}
+	}
+
+	// Not a cached cipher.
+	assert(!"IAesCipher was not obtained from getCipher().");
+	delete cipher;
 }
 
 /**
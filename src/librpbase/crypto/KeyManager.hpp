@@ -29,6 +29,8 @@
 
 namespace LibRpBase {
 
+class IAesCipher;
+
 class KeyManager : public ConfReader
 {
 	protected:
@@ -116,10 +118,59 @@ class KeyManager : public ConfReader
 		VerifyResult getAndVerify(const char *keyName, KeyData_t *pKeyData,
 			const uint8_t *pVerifyData, unsigned int verifyLen) const;
 
+		/**
+		 * Verify an encryption key.
+		 *
+		 * This will decrypt the specified block of data
+		 * using the key with AES-128-ECB, which will result
+		 * in the 16-byte string "AES-128-ECB-TEST".
+		 *
+		 * Results are cached, so verifying the same key
+		 * with the same data again doesn't decrypt anything.
+		 *
+		 * @param pKey		[in] Key data.
+		 * @param keyLen	[in] Length of pKey. (Must be 16, 24, or 32.)
+		 * @param pVerifyData	[in] Verification data block.
+		 * @param verifyLen	[in] Length of pVerifyData. (Must be 16.)
+		 * @return VerifyResult.
+		 */
+		VerifyResult verifyKey(const uint8_t *pKey, unsigned int keyLen,
+			const uint8_t *pVerifyData, unsigned int verifyLen) const;
+
 		// Verification test string.
 		// NOTE: This string is NOT NULL-terminated!
 		static const char verifyTestString[16];
 
+	public:
+		/** Cipher cache **/
+
+		/**
+		 * Get an AES cipher with the specified key.
+		 *
+		 * Recently-released ciphers are cached along with their
+		 * expanded key schedules, so requesting a key that was
+		 * used recently doesn't create a new cipher or expand
+		 * the key again.
+		 *
+		 * The key must not be changed by the caller.
+		 * The chaining mode and IV are NOT reset, so they
+		 * must be set by the caller before decrypting.
+		 *
+		 * When the cipher is no longer needed, it must be
+		 * returned using releaseCipher().
+		 *
+		 * @param pKey	[in] Key data.
+		 * @param keyLen	[in] Length of pKey. (Must be 16, 24, or 32.)
+		 * @return IAesCipher, or nullptr on error.
+		 */
+		IAesCipher *getCipher(const uint8_t *pKey, unsigned int keyLen) const;
+
+		/**
+		 * Return a cipher obtained from getCipher() to the cache.
+		 * @param cipher IAesCipher. (If nullptr, nothing is done.)
+		 */
+		void releaseCipher(IAesCipher *cipher) const;
+
 		/**
 		 * Convert string data from hexadecimal to bytes.
 		 * @param str	[in] String data. (Must be len*2 characters.)
@@ -25,8 +25,10 @@
 #include "file/IRpFile.hpp"
 #ifdef ENABLE_DECRYPTION
 # include "crypto/AesCipherFactory.hpp"
+# include "crypto/AesParallel.hpp"
 # include "crypto/IAesCipher.hpp"
 # include "crypto/KeyManager.hpp"
+# include "threads/Mutex.hpp"
 #endif
 
 // C includes. (C++ namespace)
@@ -62,7 +64,48 @@ class CBCReaderPrivate
 		// Encryption cipher.
 		uint8_t key[16];
 		uint8_t iv[16];
+		LibRpBase::IAesCipher::ChainingMode chainingMode;
 		LibRpBase::IAesCipher *cipher;
+
+		// The cipher and the caches below are shared
+		// by all reads, so decryption is serialized.
+		// (Except for parallel decryption, which doesn't
+		// use the shared cipher or the window.)
+		LibRpBase::Mutex cipherMutex;
+
+		// Decrypted window.
+		// Unaligned reads and partial blocks are
+		// decrypted into the window first.
+		static const unsigned int WINDOW_SIZE = 32768;
+		uint8_t window[WINDOW_SIZE];
+		int64_t window_pos;		// Window start position. (-1 if empty)
+		unsigned int window_len;	// Window length, in bytes.
+
+		// Last cipher text block that was read.
+		// This is the IV for the block at ct_next_pos,
+		// so sequential reads don't need to re-read it.
+		uint8_t ct_last[16];
+		int64_t ct_next_pos;		// Position following ct_last. (-1 if none)
+
+		/**
+		 * Read and decrypt full blocks.
+		 * The cipher mutex must be locked by the caller.
+		 * @param pos	[in] Starting position. (Must be a multiple of 16.)
+		 * @param ptr	[out] Output buffer.
+		 * @param size	[in] Amount of data to read. (Must be a multiple of 16.)
+		 * @return 0 on success; positive POSIX error code on error.
+		 */
+		int readBlocks(int64_t pos, uint8_t *ptr, size_t size);
+
+		/**
+		 * Read and decrypt full blocks using multiple threads.
+		 * The cipher mutex must NOT be locked by the caller.
+		 * @param pos	[in] Starting position. (Must be a multiple of 16.)
+		 * @param ptr	[out] Output buffer.
+		 * @param size	[in] Amount of data to read. (Must be a multiple of 16.)
+		 * @return 0 on success; positive POSIX error code on error.
+		 */
+		int readBlocksParallel(int64_t pos, uint8_t *ptr, size_t size);
 #endif /* ENABLE_DECRYPTION */
 };
 
@@ -77,7 +120,11 @@ CBCReaderPrivate::CBCReaderPrivate(CBCReader *q, IRpFile *file,
 	, length(length)
 	, pos(0)
 #ifdef ENABLE_DECRYPTION
+	, chainingMode(iv != nullptr ? IAesCipher::CM_CBC : IAesCipher::CM_ECB)
 	, cipher(nullptr)
+	, window_pos(-1)
+	, window_len(0)
+	, ct_next_pos(-1)
 #endif
 {
 #ifdef ENABLE_DECRYPTION
@@ -108,7 +155,7 @@ CBCReaderPrivate::CBCReaderPrivate(CBCReader *q, IRpFile *file,
 	}
 
 	// Initialize parameters for CBC decryption.
-	cipher->setChainingMode(iv != nullptr ? IAesCipher::CM_CBC : IAesCipher::CM_ECB);
+	cipher->setChainingMode(chainingMode);
 	cipher->setKey(this->key, sizeof(this->key));
 	if (iv) {
 		cipher->setIV(this->iv, sizeof(this->iv));
@@ -127,6 +174,147 @@ CBCReaderPrivate::~CBCReaderPrivate()
 #endif /* ENABLE_DECRYPTION */
 }
 
+#ifdef ENABLE_DECRYPTION
+/**
+ * Read and decrypt full blocks.
+ * The cipher mutex must be locked by the caller.
+ * @param pos	[in] Starting position. (Must be a multiple of 16.)
+ * @param ptr	[out] Output buffer.
+ * @param size	[in] Amount of data to read. (Must be a multiple of 16.)
+ * @return 0 on success; positive POSIX error code on error.
+ */
+int CBCReaderPrivate::readBlocks(int64_t pos, uint8_t *ptr, size_t size)
+{
+	assert(pos % 16 == 0);
+	assert(size % 16 == 0);
+	assert(size > 0);
+
+	// Determine the current IV.
+	uint8_t cur_iv[16];
+	if (chainingMode == IAesCipher::CM_ECB) {
+		// ECB doesn't use an IV.
+	} else if (pos == 0) {
+		// Start of encrypted data.
+		// Use the specified IV.
+		memcpy(cur_iv, iv, sizeof(cur_iv));
+	} else if (pos == ct_next_pos) {
+		// Sequential read. Use the cached cipher text block.
+		memcpy(cur_iv, ct_last, sizeof(cur_iv));
+	} else {
+		// IV is the previous 16 bytes.
+		size_t sz_read = file->pread(offset + pos - 16, cur_iv, sizeof(cur_iv));
+		if (sz_read != sizeof(cur_iv)) {
+			// Read error.
+			const int err = file->lastError();
+			return (err != 0 ? err : EIO);
+		}
+	}
+
+	// Read the data.
+	size_t sz_read = file->pread(offset + pos, ptr, size);
+	if (sz_read != size) {
+		// Short read.
+		// Cannot decrypt with a short read.
+		const int err = file->lastError();
+		return (err != 0 ? err : EIO);
+	}
+
+	// Save the last cipher text block for the next read.
+	// This must be done before decrypting, since
+	// decryption is done in place.
+	memcpy(ct_last, &ptr[size - 16], sizeof(ct_last));
+	ct_next_pos = pos + size;
+
+	// Decrypt the data.
+	if (chainingMode != IAesCipher::CM_ECB &&
+	    cipher->setIV(cur_iv, sizeof(cur_iv)) != 0)
+	{
+		// setIV() failed.
+		ct_next_pos = -1;
+		return EIO;
+	}
+	if (cipher->decrypt(ptr, size) != size) {
+		// decrypt() failed.
+		ct_next_pos = -1;
+		return EIO;
+	}
+	return 0;
+}
+
+/**
+ * Read and decrypt full blocks using multiple threads.
+ * The cipher mutex must NOT be locked by the caller.
+ * @param pos	[in] Starting position. (Must be a multiple of 16.)
+ * @param ptr	[out] Output buffer.
+ * @param size	[in] Amount of data to read. (Must be a multiple of 16.)
+ * @return 0 on success; positive POSIX error code on error.
+ */
+int CBCReaderPrivate::readBlocksParallel(int64_t pos, uint8_t *ptr, size_t size)
+{
+	assert(pos % 16 == 0);
+	assert(size % 16 == 0);
+	assert(size > 0);
+
+	// Determine the current IV.
+	// NOTE: key, iv, and chainingMode are never modified
+	// after construction, so they don't need the mutex.
+	uint8_t cur_iv[16];
+	if (chainingMode == IAesCipher::CM_ECB) {
+		// ECB doesn't use an IV.
+	} else if (pos == 0) {
+		// Start of encrypted data.
+		// Use the specified IV.
+		memcpy(cur_iv, iv, sizeof(cur_iv));
+	} else {
+		bool haveIV = false;
+		{
+			MutexLocker locker(cipherMutex);
+			if (pos == ct_next_pos) {
+				// Sequential read. Use the cached cipher text block.
+				memcpy(cur_iv, ct_last, sizeof(cur_iv));
+				haveIV = true;
+			}
+		}
+		if (!haveIV) {
+			// IV is the previous 16 bytes.
+			size_t sz_read = file->pread(offset + pos - 16, cur_iv, sizeof(cur_iv));
+			if (sz_read != sizeof(cur_iv)) {
+				// Read error.
+				const int err = file->lastError();
+				return (err != 0 ? err : EIO);
+			}
+		}
+	}
+
+	// Read the data.
+	size_t sz_read = file->pread(offset + pos, ptr, size);
+	if (sz_read != size) {
+		// Short read.
+		// Cannot decrypt with a short read.
+		const int err = file->lastError();
+		return (err != 0 ? err : EIO);
+	}
+
+	// Save the last cipher text block for the next read.
+	// This must be done before decrypting, since
+	// decryption is done in place.
+	{
+		MutexLocker locker(cipherMutex);
+		memcpy(ct_last, &ptr[size - 16], sizeof(ct_last));
+		ct_next_pos = pos + size;
+	}
+
+	// Decrypt the data.
+	// Each thread uses its own cipher, so the
+	// shared cipher isn't used here.
+	if (AesParallel::decrypt(chainingMode, key, sizeof(key), cur_iv, ptr, size) != size) {
+		// decrypt() failed.
+		return EIO;
+	}
+	return 0;
+}
+#endif /* ENABLE_DECRYPTION */
+
 /** CBCReader **/
 
 /**
@@ -171,6 +359,26 @@ bool CBCReader::isOpen(void) const
  * @return Number of bytes read.
  */
 size_t CBCReader::read(void *ptr, size_t size)
+{
+	RP_D(CBCReader);
+	size_t ret = this->pread(d->pos, ptr, size);
+	d->pos += ret;
+	return ret;
+}
+
+/**
+ * Read data from the partition at the specified address.
+ * The partition position is not changed.
+ *
+ * This function is thread-safe if the underlying
+ * file's pread() is thread-safe.
+ *
+ * @param pos	[in] Starting address.
+ * @param ptr	[out] Output data buffer.
+ * @param size	[in] Amount of data to read, in bytes.
+ * @return Number of bytes read.
+ */
+size_t CBCReader::pread(int64_t pos, void *ptr, size_t size)
 {
 	RP_D(CBCReader);
 	assert(ptr != nullptr);
@@ -188,13 +396,13 @@ size_t CBCReader::read(void *ptr, size_t size)
 	}
 
 	// Are we already at the end of the file?
-	if (d->pos >= d->length)
+	if (pos < 0 || pos >= d->length)
 		return 0;
 
-	// Make sure d->pos + size <= d->length.
+	// Make sure pos + size <= d->length.
 	// If it isn't, we'll do a short read.
-	if (d->pos + (int64_t)size >= d->length) {
-		size = (size_t)(d->length - d->pos);
+	if (pos + (int64_t)size >= d->length) {
+		size = (size_t)(d->length - pos);
 	}
 
 #ifdef ENABLE_DECRYPTION
@@ -204,9 +412,9 @@ size_t CBCReader::read(void *ptr, size_t size)
 #endif /* ENABLE_DECRYPTION */
 	{
 		// No encryption. Read directly from the file.
-		size_t sz_read = d->file->seekAndRead(d->offset + d->pos, ptr, size);
+		size_t sz_read = d->file->pread(d->offset + pos, ptr, size);
 		if (sz_read != size) {
-			// Seek and/or read error.
+			// Read error.
 			m_lastError = d->file->lastError();
 			if (m_lastError == 0) {
 				m_lastError = EIO;
@@ -217,80 +425,94 @@ size_t CBCReader::read(void *ptr, size_t size)
 	}
 
 #ifdef ENABLE_DECRYPTION
-	// TODO: Handle reads that aren't a multiple of 16 bytes.
-	assert(d->pos % 16 == 0);
-	assert(size % 16 == 0);
-	if (d->pos % 16 != 0 || size % 16 != 0) {
-		// Cannot read now.
+	// Encrypted data can only be decrypted in full blocks.
+	// If the length isn't a multiple of 16, the trailing
+	// partial block can't be read.
+	const int64_t dec_length = d->length & ~15LL;
+	if (pos >= dec_length) {
+		m_lastError = EIO;
 		return 0;
 	}
-
-	// Physical address.
-	int64_t phys_addr = d->offset + d->pos;
-
-	// Determine the current IV.
-	uint8_t cur_iv[16];
-	if (d->pos >= 16) {
-		// Subtract 16 in order to read the IV.
-		phys_addr -= 16;
+	if (pos + static_cast<int64_t>(size) > dec_length) {
+		size = static_cast<size_t>(dec_length - pos);
 	}
-	int ret = d->file->seek(phys_addr);
-	if (ret != 0) {
-		// Seek error.
-		m_lastError = d->file->lastError();
-		if (m_lastError == 0) {
-			m_lastError = EIO;
+
+	uint8_t *ptr8 = static_cast<uint8_t*>(ptr);
+	size_t sz_total_read = 0;
+	while (size > 0) {
+		if (pos % 16 == 0 && AesParallel::isWorthwhile(size & ~static_cast<size_t>(15))) {
+			// Very large block-aligned read. Decrypt all full blocks
+			// directly into the output buffer using multiple threads.
+			// The cipher mutex isn't held while decrypting.
+			const size_t sz_blocks = size & ~static_cast<size_t>(15);
+			int ret = d->readBlocksParallel(pos, ptr8, sz_blocks);
+			if (ret != 0) {
+				m_lastError = ret;
+				return 0;
+			}
+			pos += sz_blocks;
+			ptr8 += sz_blocks;
+			sz_total_read += sz_blocks;
+			size -= sz_blocks;
+			continue;
 		}
-		return 0;
-	}
 
-	if (d->pos < 16) {
-		// Start of encrypted data.
-		// Use the specified IV.
-		memcpy(cur_iv, d->iv, sizeof(cur_iv));
-	} else {
-		// IV is the previous 16 bytes.
-		// TODO: Cache this?
-		size_t sz_read = d->file->read(cur_iv, sizeof(cur_iv));
-		if (sz_read != sizeof(cur_iv)) {
-			// Read error.
-			m_lastError = d->file->lastError();
-			if (m_lastError == 0) {
-				m_lastError = EIO;
+		MutexLocker locker(d->cipherMutex);
+
+		// Check the decrypted window first.
+		if (d->window_pos >= 0 && pos >= d->window_pos &&
+		    pos < d->window_pos + d->window_len)
+		{
+			const unsigned int window_offset = static_cast<unsigned int>(pos - d->window_pos);
+			size_t sz_copy = d->window_len - window_offset;
+			if (sz_copy > size) {
+				sz_copy = size;
 			}
-			return 0;
+			memcpy(ptr8, &d->window[window_offset], sz_copy);
+			pos += sz_copy;
+			ptr8 += sz_copy;
+			sz_total_read += sz_copy;
+			size -= sz_copy;
+			continue;
 		}
-	}
 
-	// Read the data.
-	size_t sz_read = d->file->read(ptr, size);
-	if (sz_read != size) {
-		// Short read.
-		// Cannot decrypt with a short read.
-		m_lastError = d->file->lastError();
-		if (m_lastError == 0) {
-			m_lastError = EIO;
+		if (pos % 16 == 0 && size >= CBCReaderPrivate::WINDOW_SIZE) {
+			// Large block-aligned read. Decrypt all full blocks
+			// directly into the output buffer in one call.
+			// Smaller reads use the window, since they're
+			// usually followed by sequential reads.
+			const size_t sz_blocks = size & ~static_cast<size_t>(15);
+			int ret = d->readBlocks(pos, ptr8, sz_blocks);
+			if (ret != 0) {
+				m_lastError = ret;
+				return 0;
+			}
+			pos += sz_blocks;
+			ptr8 += sz_blocks;
+			sz_total_read += sz_blocks;
+			size -= sz_blocks;
+			continue;
 		}
-		return 0;
-	}
 
-	// Decrypt the data.
-	ret = d->cipher->setIV(cur_iv, sizeof(cur_iv));
-	if (ret != 0) {
-		// setIV() failed.
-		m_lastError = EIO;
-		return 0;
-	}
-	size_t sz_dec = d->cipher->decrypt(
-		static_cast<uint8_t*>(ptr), size);
-	if (sz_dec != size) {
-		// decrypt() failed.
-		m_lastError = EIO;
-		return 0;
+		// Small or unaligned read, or a partial block.
+		// Decrypt the surrounding blocks into the window.
+		const int64_t window_pos = pos & ~15LL;
+		int64_t window_len = dec_length - window_pos;
+		if (window_len > CBCReaderPrivate::WINDOW_SIZE) {
+			window_len = CBCReaderPrivate::WINDOW_SIZE;
+		}
+		d->window_pos = -1;
+		int ret = d->readBlocks(window_pos, d->window, static_cast<size_t>(window_len));
+		if (ret != 0) {
+			m_lastError = ret;
+			return 0;
+		}
+		d->window_pos = window_pos;
+		d->window_len = static_cast<unsigned int>(window_len);
 	}
 
 	// Data read and decrypted successfully.
-	return sz_read;
+	return sz_total_read;
 #else
 	// Cannot decrypt data if decryption is disabled.
 	return 0;
@@ -320,7 +542,7 @@ int CBCReader::seek(int64_t pos)
 	} else if (pos >= d->length) {
 		d->pos = d->length;
 	} else {
-		d->pos = static_cast<uint32_t>(pos);
+		d->pos = pos;
 	}
 	return 0;
 }
@@ -74,6 +74,20 @@ class CBCReader : public LibRpBase::IPartition
 		 */
 		size_t read(void *ptr, size_t size) final;
 
+		/**
+		 * Read data from the partition at the specified address.
+		 * The partition position is not changed.
+		 *
+		 * This function is thread-safe if the underlying
+		 * file's pread() is thread-safe.
+		 *
+		 * @param pos	[in] Starting address.
+		 * @param ptr	[out] Output data buffer.
+		 * @param size	[in] Amount of data to read, in bytes.
+		 * @return Number of bytes read.
+		 */
+		size_t pread(int64_t pos, void *ptr, size_t size) final;
+
 		/**
 		 * Set the partition position.
 		 * @param pos Partition position.
@@ -28,6 +28,10 @@
 #include <cassert>
 #include <cerrno>
 
+// C++ includes.
+#include <vector>
+using std::vector;
+
 namespace LibRpBase {
 
 /**
@@ -148,6 +152,7 @@ size_t DiscReader::read(void *ptr, size_t size)
 	if (pos + static_cast<int64_t>(size) > m_offset + m_length) {
 		size = static_cast<size_t>(m_offset + m_length - pos);
 	}
+	readAhead(pos - m_offset, size);
 
 	size_t ret = m_file->read(ptr, size);
 	m_lastError = m_file->lastError();
@@ -208,4 +213,109 @@ int64_t DiscReader::size(void)
 	return m_length;
 }
 
+/**
+ * Read data from the disc image at the specified address.
+ * The disc image position is not changed.
+ * This function is thread-safe if the underlying
+ * file's pread() is thread-safe.
+ * @param pos	[in] Starting address.
+ * @param ptr	[out] Output data buffer.
+ * @param size	[in] Amount of data to read, in bytes.
+ * @return Number of bytes read.
+ */
+size_t DiscReader::pread(int64_t pos, void *ptr, size_t size)
+{
+	assert(m_file != nullptr);
+	if (!m_file) {
+		m_lastError = EBADF;
+		return 0;
+	} else if (pos < 0 || pos >= m_length) {
+		// Out of range.
+		return 0;
+	}
+
+	// Constrain size based on offset and length.
+	if (pos + static_cast<int64_t>(size) > m_length) {
+		size = static_cast<size_t>(m_length - pos);
+	}
+
+	readAhead(pos, size);
+	size_t ret = m_file->pread(m_offset + pos, ptr, size);
+	if (ret != size) {
+		m_lastError = m_file->lastError();
+	}
+	return ret;
+}
+
+/**
+ * Read multiple segments from the disc image.
+ * The batch is passed to the underlying file.
+ *
+ * NOTE: The disc image position is unspecified afterwards.
+ *
+ * @param segs	[in] Read segments.
+ * @param count	[in] Number of segments.
+ * @return Number of segments that were read completely.
+ */
+unsigned int DiscReader::readBatch(const ReadSegment *segs, unsigned int count)
+{
+	assert(m_file != nullptr);
+	if (!m_file) {
+		m_lastError = EBADF;
+		return 0;
+	}
+
+	// Adjust the segments for the starting offset.
+	// Segments that extend past the end of the disc
+	// can't be read completely, so they're skipped.
+	vector<ReadSegment> adj;
+	adj.reserve(count);
+	for (unsigned int i = 0; i < count; i++) {
+		const ReadSegment &seg = segs[i];
+		if (seg.pos < 0 || seg.pos + static_cast<int64_t>(seg.size) > m_length)
+			continue;
+		ReadSegment adjSeg = {seg.pos + m_offset, seg.ptr, seg.size};
+		adj.push_back(adjSeg);
+	}
+	if (adj.empty()) {
+		return 0;
+	}
+
+	unsigned int ret = m_file->readBatch(adj.data(), static_cast<unsigned int>(adj.size()));
+	m_lastError = m_file->lastError();
+	return ret;
+}
+
+/**
+ * Hint that data will be read soon.
+ * The hint is passed to the underlying file.
+ * @param pos	[in] Starting address.
+ * @param size	[in] Amount of data, in bytes.
+ */
+void DiscReader::prefetch(int64_t pos, size_t size)
+{
+	if (!m_file || pos < 0 || pos >= m_length) {
+		return;
+	}
+	if (pos + static_cast<int64_t>(size) > m_length) {
+		size = static_cast<size_t>(m_length - pos);
+	}
+	m_file->prefetch(m_offset + pos, size);
+}
+
+/**
+ * Update the read-ahead state for a read,
+ * and prefetch the following data if needed.
+ * @param pos	[in] Starting address.
+ * @param size	[in] Amount of data to read, in bytes.
+ */
+void DiscReader::readAhead(int64_t pos, size_t size)
+{
+	int64_t prefetchPos;
+	size_t prefetchSize;
+	if (m_readAhead.update(pos, size, &prefetchPos, &prefetchSize)) {
+		prefetch(prefetchPos, prefetchSize);
+	}
+}
+
 }
@@ -24,6 +24,7 @@
 #define __ROMPROPERTIES_LIBRPBASE_DISCREADER_HPP__
 
 #include "IDiscReader.hpp"
+#include "ReadAhead.hpp"
 
 namespace LibRpBase {
 
@@ -108,12 +109,56 @@ class DiscReader : public IDiscReader
 		 */
 		int64_t size(void) override;
 
+		/**
+		 * Read data from the disc image at the specified address.
+		 * The disc image position is not changed.
+		 * This function is thread-safe if the underlying
+		 * file's pread() is thread-safe.
+		 * @param pos	[in] Starting address.
+		 * @param ptr	[out] Output data buffer.
+		 * @param size	[in] Amount of data to read, in bytes.
+		 * @return Number of bytes read.
+		 */
+		size_t pread(int64_t pos, void *ptr, size_t size) override;
+
+		/**
+		 * Read multiple segments from the disc image.
+		 * The batch is passed to the underlying file.
+		 *
+		 * NOTE: The disc image position is unspecified afterwards.
+		 *
+		 * @param segs	[in] Read segments.
+		 * @param count	[in] Number of segments.
+		 * @return Number of segments that were read completely.
+		 */
+		unsigned int readBatch(const ReadSegment *segs, unsigned int count) override;
+
+		/**
+		 * Hint that data will be read soon.
+		 * The hint is passed to the underlying file.
+		 * @param pos	[in] Starting address.
+		 * @param size	[in] Amount of data, in bytes.
+		 */
+		void prefetch(int64_t pos, size_t size) override;
+
+	protected:
+		/**
+		 * Update the read-ahead state for a read,
+		 * and prefetch the following data if needed.
+		 * @param pos	[in] Starting address.
+		 * @param size	[in] Amount of data to read, in bytes.
+		 */
+		void readAhead(int64_t pos, size_t size);
+
 	protected:
 		IRpFile *m_file;
 
 		// Offset/length. Useful for e.g. GameCube TGC.
 		int64_t m_offset;
 		int64_t m_length;
+
+		// Sequential read detection.
+		ReadAhead m_readAhead;
 };
 
 }
@@ -31,6 +31,9 @@
 // C includes. (C++ namespace)
 #include <cstddef>
 
+#include "../file/ReadSegment.hpp"
+#include "../threads/Mutex.hpp"
+
 namespace LibRpBase {
 
 class IDiscReader
@@ -121,8 +124,62 @@ class IDiscReader
 		 */
 		size_t seekAndRead(int64_t pos, void *ptr, size_t size);
 
+		/**
+		 * Read data from the disc image at the specified address.
+		 *
+		 * The disc image position is not changed, and multiple
+		 * threads may call pread() on the same object concurrently.
+		 * (Mixing pread() with seek() and read() on other threads
+		 * is NOT thread-safe.)
+		 *
+		 * The default implementation serializes calls with a mutex.
+		 * Subclasses should override this if they can read without
+		 * using the disc image position.
+		 *
+		 * @param pos	[in] Starting address.
+		 * @param ptr	[out] Output data buffer.
+		 * @param size	[in] Amount of data to read, in bytes.
+		 * @return Number of bytes read.
+		 */
+		virtual size_t pread(int64_t pos, void *ptr, size_t size);
+
+		/**
+		 * Read multiple segments from the disc image.
+		 *
+		 * Segments are read in ascending address order, and
+		 * contiguous segments are read without seeking.
+		 * Subclasses may override this to pass the entire
+		 * batch to the underlying file.
+		 *
+		 * NOTE: The disc image position is unspecified afterwards.
+		 *
+		 * @param segs	[in] Read segments.
+		 * @param count	[in] Number of segments.
+		 * @return Number of segments that were read completely.
+		 */
+		virtual unsigned int readBatch(const ReadSegment *segs, unsigned int count);
+
+		/**
+		 * Hint that data will be read soon.
+		 *
+		 * Parsers can call this as soon as they know the location
+		 * of data that will be read later, e.g. the FST offset from
+		 * the disc header. This is only a hint; no data is returned.
+		 *
+		 * The default implementation does nothing.
+		 *
+		 * @param pos	[in] Starting address.
+		 * @param size	[in] Amount of data, in bytes.
+		 */
+		virtual void prefetch(int64_t pos, size_t size)
+		{
+			RP_UNUSED(pos);
+			RP_UNUSED(size);
+		}
+
 	protected:
 		int m_lastError;
+		Mutex m_preadMutex;	// Serializes the default pread().
 };
 
 /**
@@ -27,7 +27,9 @@
 
 // C++ includes.
 #include <string>
+#include <vector>
 using std::string;
+using std::vector;
 
 namespace LibRpBase {
 
@@ -227,6 +229,78 @@ int PartitionFile::truncate(int64_t size)
 	return -m_lastError;
 }
 
+/**
+ * Read data from the file at the specified address.
+ * The file position is not changed.
+ * This function is thread-safe if the underlying
+ * partition's pread() is thread-safe.
+ * @param pos	[in] Starting address.
+ * @param ptr	[out] Output data buffer.
+ * @param size	[in] Amount of data to read, in bytes.
+ * @return Number of bytes read.
+ */
+size_t PartitionFile::pread(int64_t pos, void *ptr, size_t size)
+{
+	if (!m_partition) {
+		m_lastError = EBADF;
+		return 0;
+	} else if (pos < 0 || pos >= m_size) {
+		// Out of range.
+		return 0;
+	}
+
+	// Make sure pos + size <= m_size.
+	// If it isn't, we'll do a short read.
+	if (pos > m_size - static_cast<int64_t>(size)) {
+		size = static_cast<size_t>(m_size - pos);
+	}
+
+	size_t ret = m_partition->pread(m_offset + pos, ptr, size);
+	if (ret != size) {
+		m_lastError = m_partition->lastError();
+	}
+	return ret;
+}
+
+/**
+ * Read multiple segments from the file.
+ * The batch is passed to the underlying partition.
+ *
+ * NOTE: The file position is not changed.
+ *
+ * @param segs	[in] Read segments.
+ * @param count	[in] Number of segments.
+ * @return Number of segments that were read completely.
+ */
+unsigned int PartitionFile::readBatch(const ReadSegment *segs, unsigned int count)
+{
+	if (!m_partition) {
+		m_lastError = EBADF;
+		return 0;
+	}
+
+	// Adjust the segments for the file's starting offset.
+	// Segments that extend past the end of the file
+	// can't be read completely, so they're skipped.
+	vector<ReadSegment> adj;
+	adj.reserve(count);
+	for (unsigned int i = 0; i < count; i++) {
+		const ReadSegment &seg = segs[i];
+		if (seg.pos < 0 || seg.pos + static_cast<int64_t>(seg.size) > m_size)
+			continue;
+		ReadSegment adjSeg = {seg.pos + m_offset, seg.ptr, seg.size};
+		adj.push_back(adjSeg);
+	}
+	if (adj.empty()) {
+		return 0;
+	}
+
+	m_partition->clearError();
+	unsigned int ret = m_partition->readBatch(adj.data(), static_cast<unsigned int>(adj.size()));
+	m_lastError = m_partition->lastError();
+	return ret;
+}
+
 /** File properties. **/
 
 /**
@@ -111,6 +111,30 @@ class PartitionFile : public IRpFile
 		 */
 		int truncate(int64_t size = 0) final;
 
+		/**
+		 * Read data from the file at the specified address.
+		 * The file position is not changed.
+		 * This function is thread-safe if the underlying
+		 * partition's pread() is thread-safe.
+		 * @param pos	[in] Starting address.
+		 * @param ptr	[out] Output data buffer.
+		 * @param size	[in] Amount of data to read, in bytes.
+		 * @return Number of bytes read.
+		 */
+		size_t pread(int64_t pos, void *ptr, size_t size) final;
+
+		/**
+		 * Read multiple segments from the file.
+		 * The batch is passed to the underlying partition.
+		 *
+		 * NOTE: The file position is not changed.
+		 *
+		 * @param segs	[in] Read segments.
+		 * @param count	[in] Number of segments.
+		 * @return Number of segments that were read completely.
+		 */
+		unsigned int readBatch(const ReadSegment *segs, unsigned int count) final;
+
 	public:
 		/** File properties. **/
 
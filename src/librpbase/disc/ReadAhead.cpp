@@ -0,0 +1,74 @@
+/***************************************************************************
+ * ROM Properties Page shell extension. (librpbase)                        *
+ * ReadAhead.cpp: Sequential read detection for disc readers.              *
+ *                                                                         *
+ * Copyright (c) 2016-2018 by David Korth.                                 *
+ *                                                                         *
+ * This program is free software; you can redistribute it and/or modify it *
+ * under the terms of the GNU General Public License as published by the   *
+ * Free Software Foundation; either version 2 of the License, or (at your  *
+ * option) any later version.                                              *
+ *                                                                         *
+ * This program is distributed in the hope that it will be useful, but     *
+ * WITHOUT ANY WARRANTY; without even the implied warranty of              *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the           *
+ * GNU General Public License for more details.                            *
+ *                                                                         *
+ * You should have received a copy of the GNU General Public License along *
+ * with this program; if not, write to the Free Software Foundation, Inc., *
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.           *
+ ***************************************************************************/
+
+#include "ReadAhead.hpp"
+
+namespace LibRpBase {
+
+ReadAhead::ReadAhead()
+	: m_nextPos(-1)
+	, m_prefetchEnd(-1)
+	, m_window(0)
+{ }
+
+/**
+ * Update the read-ahead state for a read.
+ * @param pos		[in] Starting address of the read.
+ * @param size		[in] Size of the read.
+ * @param pPrefetchPos	[out] Starting address of the range to prefetch.
+ * @param pPrefetchSize	[out] Size of the range to prefetch.
+ * @return True if the range should be prefetched; false if not.
+ */
+bool ReadAhead::update(int64_t pos, size_t size, int64_t *pPrefetchPos, size_t *pPrefetchSize)
+{
+	const int64_t end = pos + static_cast<int64_t>(size);
+
+	MutexLocker locker(m_mutex);
+	if (pos != m_nextPos) {
+		// Not a sequential read.
+		m_nextPos = end;
+		m_prefetchEnd = end;
+		m_window = 0;
+		return false;
+	}
+	m_nextPos = end;
+
+	if (m_window == 0) {
+		// Second sequential read. Start prefetching.
+		m_window = WINDOW_MIN;
+	} else if (end + static_cast<int64_t>(m_window / 2) < m_prefetchEnd) {
+		// Less than half of the prefetched range has been read.
+		return false;
+	}
+
+	// Prefetch the window following this read.
+	// Data that was already prefetched is skipped.
+	const int64_t start = (m_prefetchEnd > end ? m_prefetchEnd : end);
+	m_prefetchEnd = end + m_window;
+	*pPrefetchPos = start;
+	*pPrefetchSize = static_cast<size_t>(m_prefetchEnd - start);
+	if (m_window < WINDOW_MAX) {
+		m_window *= 2;
+	}
+	return true;
+}
+
+}
@@ -0,0 +1,79 @@
+/***************************************************************************
+ * ROM Properties Page shell extension. (librpbase)                        *
+ * ReadAhead.hpp: Sequential read detection for disc readers.              *
+ *                                                                         *
+ * Copyright (c) 2016-2018 by David Korth.                                 *
+ *                                                                         *
+ * This program is free software; you can redistribute it and/or modify it *
+ * under the terms of the GNU General Public License as published by the   *
+ * Free Software Foundation; either version 2 of the License, or (at your  *
+ * option) any later version.                                              *
+ *                                                                         *
+ * This program is distributed in the hope that it will be useful, but     *
+ * WITHOUT ANY WARRANTY; without even the implied warranty of              *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the           *
+ * GNU General Public License for more details.                            *
+ *                                                                         *
+ * You should have received a copy of the GNU General Public License along *
+ * with this program; if not, write to the Free Software Foundation, Inc., *
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.           *
+ ***************************************************************************/
+
+#ifndef __ROMPROPERTIES_LIBRPBASE_DISC_READAHEAD_HPP__
+#define __ROMPROPERTIES_LIBRPBASE_DISC_READAHEAD_HPP__
+
+#include "librpbase/common.h"
+#include "../threads/Mutex.hpp"
+
+// C includes.
+#include <stdint.h>
+
+// C includes. (C++ namespace)
+#include <cstddef>
+
+namespace LibRpBase {
+
+/**
+ * Sequential read detection.
+ *
+ * Disc readers call update() for each read. Once two reads in a
+ * row are sequential, update() returns a window following the
+ * current read, which the reader should pass to prefetch().
+ * The window doubles in size for each prefetch, up to WINDOW_MAX,
+ * and is reset when a non-sequential read is detected.
+ *
+ * This class is thread-safe.
+ */
+class ReadAhead
+{
+	public:
+		ReadAhead();
+
+	private:
+		RP_DISABLE_COPY(ReadAhead)
+
+	public:
+		// Initial and maximum read-ahead window sizes.
+		static const unsigned int WINDOW_MIN = 128*1024;
+		static const unsigned int WINDOW_MAX = 2*1024*1024;
+
+		/**
+		 * Update the read-ahead state for a read.
+		 * @param pos		[in] Starting address of the read.
+		 * @param size		[in] Size of the read.
+		 * @param pPrefetchPos	[out] Starting address of the range to prefetch.
+		 * @param pPrefetchSize	[out] Size of the range to prefetch.
+		 * @return True if the range should be prefetched; false if not.
+		 */
+		bool update(int64_t pos, size_t size, int64_t *pPrefetchPos, size_t *pPrefetchSize);
+
+	private:
+		Mutex m_mutex;
+		int64_t m_nextPos;	// Starting address of the next sequential read.
+		int64_t m_prefetchEnd;	// End of the prefetched range.
+		unsigned int m_window;	// Current window size. (0 if not sequential)
+};
+
+}
+
+#endif /* __ROMPROPERTIES_LIBRPBASE_DISC_READAHEAD_HPP__ */
@@ -30,6 +30,14 @@
 #include <cerrno>
 #include <cstring>
 
+// C++ includes.
+#include <list>
+#include <unordered_map>
+#include <vector>
+using std::list;
+using std::unordered_map;
+using std::vector;
+
 namespace LibRpBase {
 
 /** SparseDiscReaderPrivate **/
@@ -40,6 +48,10 @@ SparseDiscReaderPrivate::SparseDiscReaderPrivate(SparseDiscReader *q, IRpFile *f
 	, disc_size(0)
 	, pos(-1)
 	, block_size(0)
+	, cacheSize(0)
+	, cacheSizeMax(CACHE_SIZE_DEFAULT)
+	, cacheHits(0)
+	, cacheMisses(0)
 {
 	if (!file) {
 		q->m_lastError = EBADF;
@@ -53,9 +65,193 @@ SparseDiscReaderPrivate::SparseDiscReaderPrivate(SparseDiscReader *q, IRpFile *f
 
 SparseDiscReaderPrivate::~SparseDiscReaderPrivate()
 {
+	{
+		MutexLocker locker(cacheMutex);
+		cacheShrink(0);
+	}
 	delete file;
 }
 
+// Process-wide cache usage.
+Mutex SparseDiscReaderPrivate::globalCacheMutex;
+size_t SparseDiscReaderPrivate::globalCacheSize = 0;
+size_t SparseDiscReaderPrivate::globalCacheSizeMax = 0;
+
+/**
+ * Get the cache line size.
+ * @return Cache line size.
+ */
+unsigned int SparseDiscReaderPrivate::cacheLineSize(void) const
+{
+	// NOTE: Lines must not cross block boundaries.
+	if (block_size > CACHE_LINE_SIZE && (block_size % CACHE_LINE_SIZE) == 0) {
+		return CACHE_LINE_SIZE;
+	}
+	return block_size;
+}
+
+/**
+ * Read data using the block cache.
+ * @param pos	[in] Starting address.
+ * @param ptr	[out] Output data buffer.
+ * @param size	[in] Amount of data to read, in bytes.
+ * @return Number of bytes read.
+ */
+size_t SparseDiscReaderPrivate::readCached(int64_t pos, uint8_t *ptr, size_t size)
+{
+	const unsigned int lineSize = cacheLineSize();
+	size_t ret = 0;
+
+	while (size > 0) {
+		const int64_t lineIdx = pos / lineSize;
+		const unsigned int lineOffset = static_cast<unsigned int>(pos % lineSize);
+		size_t copy_sz = lineSize - lineOffset;
+		if (copy_sz > size) {
+			copy_sz = size;
+		}
+
+		{
+			MutexLocker locker(cacheMutex);
+			auto iter = cacheMap.find(lineIdx);
+			if (iter != cacheMap.end()) {
+				// Cache hit. Move the line to the front.
+				cacheHits++;
+				cacheLines.splice(cacheLines.begin(), cacheLines, iter->second);
+				const vector<uint8_t> &data = iter->second->data;
+				assert(lineOffset + copy_sz <= data.size());
+				memcpy(ptr, &data[lineOffset], copy_sz);
+
+				size -= copy_sz;
+				ptr += copy_sz;
+				ret += copy_sz;
+				pos += copy_sz;
+				continue;
+			}
+			cacheMisses++;
+		}
+
+		// Cache miss. Read the entire line.
+		// NOTE: The mutex isn't held here so other threads
+		// can use the cache while this line is being read.
+		const int64_t lineStart = lineIdx * lineSize;
+		unsigned int lineLen = lineSize;
+		if (lineStart + lineLen > disc_size) {
+			lineLen = static_cast<unsigned int>(disc_size - lineStart);
+		}
+		vector<uint8_t> data(lineLen);
+		const uint32_t blockIdx = static_cast<uint32_t>(lineStart / block_size);
+		const int blockOffset = static_cast<int>(lineStart % block_size);
+		int rd = q_ptr->readBlock(blockIdx, data.data(), blockOffset, lineLen);
+		if (rd != static_cast<int>(lineLen)) {
+			// Error reading the data.
+			// Copy whatever was read, but don't cache it.
+			if (rd > static_cast<int>(lineOffset)) {
+				size_t sz = static_cast<size_t>(rd) - lineOffset;
+				if (sz > copy_sz) {
+					sz = copy_sz;
+				}
+				memcpy(ptr, &data[lineOffset], sz);
+				ret += sz;
+			}
+			break;
+		}
+		memcpy(ptr, &data[lineOffset], copy_sz);
+
+		{
+			MutexLocker locker(cacheMutex);
+			cacheInsert(lineIdx, data);
+		}
+
+		size -= copy_sz;
+		ptr += copy_sz;
+		ret += copy_sz;
+		pos += copy_sz;
+	}
+
+	return ret;
+}
+
+/**
+ * Add a line to the cache.
+ * cacheMutex must be locked by the caller.
+ * @param lineIdx	[in] Line index.
+ * @param data		[in/out] Line data. (swapped into the cache)
+ */
+void SparseDiscReaderPrivate::cacheInsert(int64_t lineIdx, vector<uint8_t> &data)
+{
+	const size_t len = data.size();
+	if (len > cacheSizeMax || cacheMap.find(lineIdx) != cacheMap.end()) {
+		// Line is too big, or another thread already added it.
+		return;
+	}
+
+	// Make room in this reader's cache.
+	size_t evicted = 0;
+	while (cacheSize + len > cacheSizeMax) {
+		evicted += cacheEvictLRU();
+	}
+
+	MutexLocker globalLocker(globalCacheMutex);
+	globalCacheSize -= evicted;
+	if (globalCacheSizeMax != 0) {
+		// Make room in the process-wide cache budget.
+		// Only this reader's lines can be evicted here.
+		while (globalCacheSize + len > globalCacheSizeMax && !cacheLines.empty()) {
+			globalCacheSize -= cacheEvictLRU();
+		}
+		if (globalCacheSize + len > globalCacheSizeMax) {
+			// The budget is used by other readers.
+			return;
+		}
+	}
+	globalCacheSize += len;
+
+	cacheLines.push_front(CacheLine());
+	CacheLine &line = cacheLines.front();
+	line.lineIdx = lineIdx;
+	line.data.swap(data);
+	cacheMap.insert(std::make_pair(lineIdx, cacheLines.begin()));
+	cacheSize += len;
+}
+
+/**
+ * Evict the least recently used line from the cache.
+ * cacheMutex must be locked by the caller.
+ * NOTE: globalCacheSize is not updated.
+ * @return Size of the evicted line, in bytes.
+ */
+size_t SparseDiscReaderPrivate::cacheEvictLRU(void)
+{
+	assert(!cacheLines.empty());
+	if (cacheLines.empty()) {
+		return 0;
+	}
+
+	const CacheLine &line = cacheLines.back();
+	const size_t len = line.data.size();
+	cacheMap.erase(line.lineIdx);
+	cacheLines.pop_back();
+	cacheSize -= len;
+	return len;
+}
+
+/**
+ * Evict lines until the cache is at most the specified size.
+ * cacheMutex must be locked by the caller.
+ * @param size Maximum cache size, in bytes.
+ */
+void SparseDiscReaderPrivate::cacheShrink(size_t size)
+{
+	size_t evicted = 0;
+	while (cacheSize > size) {
+		evicted += cacheEvictLRU();
+	}
+	if (evicted != 0) {
+		MutexLocker globalLocker(globalCacheMutex);
+		globalCacheSize -= evicted;
+	}
+}
+
 /** SparseDiscReader **/
 
 SparseDiscReader::SparseDiscReader(SparseDiscReaderPrivate *d)
@@ -87,36 +283,75 @@ bool SparseDiscReader::isOpen(void) const
  * @return Number of bytes read.
  */
 size_t SparseDiscReader::read(void *ptr, size_t size)
+{
+	RP_D(SparseDiscReader);
+	assert(d->pos >= 0);
+	if (d->pos < 0) {
+		// Disc image wasn't initialized properly.
+		m_lastError = EBADF;
+		return 0;
+	}
+
+	size_t ret = this->pread(d->pos, ptr, size);
+	d->pos += ret;
+	return ret;
+}
+
+/**
+ * Read data from the disc image at the specified address.
+ * The disc image position is not changed.
+ *
+ * This function is thread-safe if the subclass's
+ * readBlock() is thread-safe.
+ *
+ * @param pos	[in] Starting address.
+ * @param ptr	[out] Output data buffer.
+ * @param size	[in] Amount of data to read, in bytes.
+ * @return Number of bytes read.
+ */
+size_t SparseDiscReader::pread(int64_t pos, void *ptr, size_t size)
 {
 	RP_D(SparseDiscReader);
 	assert(d->file != nullptr);
 	assert(d->disc_size > 0);
-	assert(d->pos >= 0);
 	assert(d->block_size != 0);
-	if (!d->file || d->disc_size <= 0 || d->pos < 0 || d->block_size == 0) {
+	if (!d->file || d->disc_size <= 0 || d->block_size == 0) {
 		// Disc image wasn't initialized properly.
 		m_lastError = EBADF;
-		return -1;
+		return 0;
 	}
 
 	uint8_t *ptr8 = static_cast<uint8_t*>(ptr);
 	size_t ret = 0;
 
 	// Are we already at the end of the disc?
-	if (d->pos >= d->disc_size) {
+	if (pos < 0 || pos >= d->disc_size) {
 		// End of the disc.
 		return 0;
 	}
 
-	// Make sure d->pos + size <= d->disc_size.
+	// Make sure pos + size <= d->disc_size.
 	// If it isn't, we'll do a short read.
-	if (d->pos + static_cast<int64_t>(size) >= d->disc_size) {
-		size = static_cast<size_t>(d->disc_size - d->pos);
+	if (pos + static_cast<int64_t>(size) >= d->disc_size) {
+		size = static_cast<size_t>(d->disc_size - pos);
+	}
+
+	// Prefetch the following data if this is a sequential read.
+	int64_t prefetchPos;
+	size_t prefetchSize;
+	if (d->readAhead.update(pos, size, &prefetchPos, &prefetchSize)) {
+		this->prefetch(prefetchPos, prefetchSize);
+	}
+
+	// Small reads, e.g. headers and partition tables, use the block cache.
+	// Large reads bypass it so they don't evict everything else.
+	if (d->cacheSizeMax != 0 && size <= SparseDiscReaderPrivate::CACHE_MAX_READ) {
+		return d->readCached(pos, ptr8, size);
 	}
 
 	// Check if we're not starting on a block boundary.
 	const uint32_t block_size = d->block_size;
-	const uint32_t blockStartOffset = d->pos % block_size;
+	const uint32_t blockStartOffset = pos % block_size;
 	if (blockStartOffset != 0) {
 		// Not a block boundary.
 		// Read the end of the block.
@@ -125,7 +360,7 @@ size_t SparseDiscReader::read(void *ptr, size_t size)
 			read_sz = static_cast<uint32_t>(size);
 		}
 
-		const unsigned int blockIdx = static_cast<unsigned int>(d->pos / block_size);
+		const unsigned int blockIdx = static_cast<unsigned int>(pos / block_size);
 		int rd = this->readBlock(blockIdx, ptr8, blockStartOffset, read_sz);
 		if (rd < 0 || rd != static_cast<int>(read_sz)) {
 			// Error reading the data.
@@ -136,30 +371,34 @@ size_t SparseDiscReader::read(void *ptr, size_t size)
 		size -= read_sz;
 		ptr8 += read_sz;
 		ret += read_sz;
-		d->pos += read_sz;
+		pos += read_sz;
 	}
 
 	// Read entire blocks.
-	for (; size >= block_size;
-	    size -= block_size, ptr8 += block_size,
-	    ret += block_size, d->pos += block_size)
-	{
-		assert(d->pos % block_size == 0);
-		const unsigned int blockIdx = static_cast<unsigned int>(d->pos / block_size);
-		int rd = this->readBlock(blockIdx, ptr8, 0, block_size);
-		if (rd < 0 || rd != static_cast<int>(block_size)) {
+	if (size >= block_size) {
+		assert(pos % block_size == 0);
+		const unsigned int blockIdx = static_cast<unsigned int>(pos / block_size);
+		const unsigned int blockCount = static_cast<unsigned int>(size / block_size);
+		const size_t blocks_sz = static_cast<size_t>(blockCount) * block_size;
+		size_t rd = this->readBlocks(blockIdx, ptr8, blockCount);
+		if (rd != blocks_sz) {
 			// Error reading the data.
-			return ret + (rd > 0 ? rd : 0);
+			return ret + rd;
 		}
+
+		size -= blocks_sz;
+		ptr8 += blocks_sz;
+		ret += blocks_sz;
+		pos += blocks_sz;
 	}
 
 	// Check if we still have data left. (not a full block)
 	if (size > 0) {
 		// Not a full block.
-		assert(d->pos % block_size == 0);
+		assert(pos % block_size == 0);
 
 		// Read the start of the block.
-		const unsigned int blockIdx = static_cast<unsigned int>(d->pos / block_size);
+		const unsigned int blockIdx = static_cast<unsigned int>(pos / block_size);
 		int rd = this->readBlock(blockIdx, ptr8, 0, size);
 		if (rd < 0 || rd != static_cast<int>(size)) {
 			// Error reading the data.
@@ -167,7 +406,6 @@ size_t SparseDiscReader::read(void *ptr, size_t size)
 		}
 
 		ret += size;
-		d->pos += size;
 	}
 
 	// Finished reading the data.
@@ -245,6 +483,111 @@ int64_t SparseDiscReader::size(void)
 	return d->disc_size;
 }
 
+/**
+ * Hint that data will be read soon.
+ *
+ * The default implementation prefetches the physical
+ * blocks using getPhysBlockAddr(). Contiguous blocks are
+ * prefetched together, and empty blocks are skipped.
+ *
+ * @param pos	[in] Starting address.
+ * @param size	[in] Amount of data, in bytes.
+ */
+void SparseDiscReader::prefetch(int64_t pos, size_t size)
+{
+	RP_D(SparseDiscReader);
+	if (!d->file || d->block_size == 0 || size == 0 ||
+	    pos < 0 || pos >= d->disc_size)
+	{
+		return;
+	}
+	if (pos + static_cast<int64_t>(size) > d->disc_size) {
+		size = static_cast<size_t>(d->disc_size - pos);
+	}
+
+	// Prefetch whole blocks.
+	const uint32_t block_size = d->block_size;
+	uint32_t blockIdx = static_cast<uint32_t>(pos / block_size);
+	const uint32_t blockEnd = static_cast<uint32_t>((pos + size - 1) / block_size);
+
+	int64_t runStart = 0;	// Physical address of the current run.
+	int64_t runSize = 0;	// Size of the current run.
+	for (; blockIdx <= blockEnd; blockIdx++) {
+		const int64_t physBlockAddr = getPhysBlockAddr(blockIdx);
+		if (runSize != 0 && physBlockAddr == runStart + runSize) {
+			// Contiguous with the current run.
+			runSize += block_size;
+			continue;
+		}
+
+		// Prefetch the current run and start a new one.
+		if (runSize != 0) {
+			d->file->prefetch(runStart, static_cast<size_t>(runSize));
+		}
+		if (physBlockAddr > 0) {
+			runStart = physBlockAddr;
+			runSize = block_size;
+		} else {
+			// Empty or invalid block.
+			runSize = 0;
+		}
+	}
+	if (runSize != 0) {
+		d->file->prefetch(runStart, static_cast<size_t>(runSize));
+	}
+}
+
+/** Block cache functions. **/
+
+/**
+ * Set the maximum size of this reader's block cache.
+ * @param size Maximum cache size, in bytes. (0 to disable the cache)
+ */
+void SparseDiscReader::setCacheSize(size_t size)
+{
+	RP_D(SparseDiscReader);
+	MutexLocker locker(d->cacheMutex);
+	d->cacheSizeMax = size;
+	d->cacheShrink(size);
+}
+
+/**
+ * Get the block cache statistics.
+ * @param pStats	[out] Cache statistics.
+ */
+void SparseDiscReader::getCacheStats(CacheStats *pStats) const
+{
+	RP_D(const SparseDiscReader);
+	assert(pStats != nullptr);
+	MutexLocker locker(d->cacheMutex);
+	pStats->hits = d->cacheHits;
+	pStats->misses = d->cacheMisses;
+	pStats->size = d->cacheSize;
+	pStats->sizeMax = d->cacheSizeMax;
+}
+
+/**
+ * Set the maximum size of all block caches in this process.
+ * Existing caches are not shrunk immediately; the limit is
+ * enforced as new lines are added.
+ * @param size Maximum size of all caches, in bytes. (0 for unlimited)
+ */
+void SparseDiscReader::setGlobalCacheSize(size_t size)
+{
+	MutexLocker locker(SparseDiscReaderPrivate::globalCacheMutex);
+	SparseDiscReaderPrivate::globalCacheSizeMax = size;
+}
+
+/**
+ * Get the total size of all block caches in this process.
+ * @return Total cache size, in bytes.
+ */
+size_t SparseDiscReader::globalCacheSize(void)
+{
+	MutexLocker locker(SparseDiscReaderPrivate::globalCacheMutex);
+	return SparseDiscReaderPrivate::globalCacheSize;
+}
+
 /**
  * Read the specified block.
  *
@@ -292,9 +635,90 @@ int SparseDiscReader::readBlock(uint32_t blockIdx, void *ptr, int pos, size_t si
 	}
 
 	// Read from the block.
-	size_t sz_read = d->file->seekAndRead(physBlockAddr + pos, ptr, size);
-	m_lastError = d->file->lastError();
+	// NOTE: Using pread() so multiple threads can read blocks.
+	size_t sz_read = d->file->pread(physBlockAddr + pos, ptr, size);
+	if (sz_read != size) {
+		m_lastError = d->file->lastError();
+	}
 	return (sz_read > 0 ? (int)sz_read : -1);
 }
 
+/**
+ * Read multiple full blocks.
+ *
+ * The default implementation finds runs of blocks that are
+ * physically contiguous in the disc image file and reads
+ * each run with a single pread(). Runs of empty blocks are
+ * zero-filled without reading the file.
+ *
+ * @param blockIdx	[in] First block index.
+ * @param ptr		[out] Output data buffer.
+ * @param blockCount	[in] Number of blocks to read.
+ * @return Number of bytes read.
+ */
+size_t SparseDiscReader::readBlocks(uint32_t blockIdx, void *ptr, unsigned int blockCount)
+{
+	// NOTE: This can only be called by SparseDiscReader,
+	// so the main assertions are already checked there.
+	RP_D(SparseDiscReader);
+	const uint32_t block_size = d->block_size;
+	uint8_t *ptr8 = static_cast<uint8_t*>(ptr);
+	size_t ret = 0;
+
+	if (unlikely(blockCount == 0)) {
+		// Nothing to read.
+		return 0;
+	}
+
+	// Physical address of the first block in the current run.
+	int64_t physBlockAddr = getPhysBlockAddr(blockIdx);
+	while (blockCount > 0) {
+		assert(physBlockAddr >= 0);
+		if (physBlockAddr < 0) {
+			// Out of range.
+			break;
+		}
+
+		// Find the end of the run.
+		// - Empty blocks: Every block in the run is empty.
+		// - Data blocks: Every block immediately follows the previous one.
+		const int64_t addrInc = (physBlockAddr != 0 ? block_size : 0);
+		int64_t nextAddr = physBlockAddr;
+		int64_t nextPhysBlockAddr = -1;
+		unsigned int runCount = 1;
+		for (; runCount < blockCount; runCount++) {
+			nextAddr += addrInc;
+			nextPhysBlockAddr = getPhysBlockAddr(blockIdx + runCount);
+			if (nextPhysBlockAddr != nextAddr) {
+				// End of the run.
+				break;
+			}
+		}
+
+		const size_t run_sz = static_cast<size_t>(runCount) * block_size;
+		if (physBlockAddr == 0) {
+			// Empty blocks.
+			memset(ptr8, 0, run_sz);
+		} else {
+			// Read the entire run at once.
+			// NOTE: Using pread() so multiple threads can read blocks.
+			size_t sz_read = d->file->pread(physBlockAddr, ptr8, run_sz);
+			if (sz_read != run_sz) {
+				m_lastError = d->file->lastError();
+				return ret + sz_read;
+			}
+		}
+
+		blockIdx += runCount;
+		blockCount -= runCount;
+		ptr8 += run_sz;
+		ret += run_sz;
+
+		// The address that ended the run starts the next run.
+		physBlockAddr = nextPhysBlockAddr;
+	}
+
+	return ret;
+}
+
 }
@@ -59,6 +59,20 @@ class SparseDiscReader : public IDiscReader
 		 */
 		size_t read(void *ptr, size_t size) final;
 
+		/**
+		 * Read data from the disc image at the specified address.
+		 * The disc image position is not changed.
+		 *
+		 * This function is thread-safe if the subclass's
+		 * readBlock() is thread-safe.
+		 *
+		 * @param pos	[in] Starting address.
+		 * @param ptr	[out] Output data buffer.
+		 * @param size	[in] Amount of data to read, in bytes.
+		 * @return Number of bytes read.
+		 */
+		size_t pread(int64_t pos, void *ptr, size_t size) final;
+
 		/**
 		 * Set the disc image position.
 		 * @param pos disc image position.
@@ -78,6 +92,64 @@ class SparseDiscReader : public IDiscReader
 		 */
 		int64_t size(void) final;
 
+		/**
+		 * Hint that data will be read soon.
+		 *
+		 * The default implementation prefetches the physical
+		 * blocks using getPhysBlockAddr(). Contiguous blocks are
+		 * prefetched together, and empty blocks are skipped.
+		 *
+		 * Subclasses that override readBlock() should override
+		 * this function if they can prefetch data.
+		 *
+		 * @param pos	[in] Starting address.
+		 * @param size	[in] Amount of data, in bytes.
+		 */
+		void prefetch(int64_t pos, size_t size) override;
+
+	public:
+		/** Block cache functions. **/
+
+		/**
+		 * Block cache statistics.
+		 *
+		 * Small reads are cached in memory, which speeds up parsers
+		 * that re-read the disc header, FST, or partition tables.
+		 * Large reads bypass the cache.
+		 */
+		struct CacheStats {
+			uint64_t hits;		// Number of cache lines read from the cache.
+			uint64_t misses;	// Number of cache lines read from the disc image.
+			size_t size;		// Current cache size, in bytes.
+			size_t sizeMax;		// Maximum cache size, in bytes.
+		};
+
+		/**
+		 * Set the maximum size of this reader's block cache.
+		 * @param size Maximum cache size, in bytes. (0 to disable the cache)
+		 */
+		void setCacheSize(size_t size);
+
+		/**
+		 * Get the block cache statistics.
+		 * @param pStats	[out] Cache statistics.
+		 */
+		void getCacheStats(CacheStats *pStats) const;
+
+		/**
+		 * Set the maximum size of all block caches in this process.
+		 * Existing caches are not shrunk immediately; the limit is
+		 * enforced as new lines are added.
+		 * @param size Maximum size of all caches, in bytes. (0 for unlimited)
+		 */
+		static void setGlobalCacheSize(size_t size);
+
+		/**
+		 * Get the total size of all block caches in this process.
+		 * @return Total cache size, in bytes.
+		 */
+		static size_t globalCacheSize(void);
+
 	protected:
 		/** Virtual functions for SparseDiscReader subclasses. **/
 
@@ -104,6 +176,9 @@ class SparseDiscReader : public IDiscReader
 		 * though usually it isn't needed. Override getPhysBlockAddr()
 		 * instead.
 		 *
+		 * NOTE: This function may be called from multiple threads
+		 * by pread(), so overrides should be thread-safe.
+		 *
 		 * @param blockIdx	[in] Block index.
 		 * @param ptr		[out] Output data buffer.
 		 * @param pos		[in] Starting position. (Must be >= 0 and <= the block size!)
@@ -111,6 +186,28 @@ class SparseDiscReader : public IDiscReader
 		 * @return Number of bytes read, or -1 if the block index is invalid.
 		 */
 		virtual int readBlock(uint32_t blockIdx, void *ptr, int pos, size_t size);
+
+		/**
+		 * Read multiple full blocks.
+		 *
+		 * The default implementation finds runs of blocks that are
+		 * physically contiguous in the disc image file and reads
+		 * each run with a single pread(). Runs of empty blocks are
+		 * zero-filled without reading the file.
+		 *
+		 * Subclasses that override readBlock() must also override
+		 * this function, since the default implementation doesn't
+		 * call readBlock().
+		 *
+		 * NOTE: This function may be called from multiple threads
+		 * by pread(), so overrides should be thread-safe.
+		 *
+		 * @param blockIdx	[in] First block index.
+		 * @param ptr		[out] Output data buffer.
+		 * @param blockCount	[in] Number of blocks to read.
+		 * @return Number of bytes read.
+		 */
+		virtual size_t readBlocks(uint32_t blockIdx, void *ptr, unsigned int blockCount);
 };
 
 }
@@ -26,6 +26,13 @@
 
 #include <stdint.h>
 #include "../common.h"
+#include "../threads/Mutex.hpp"
+#include "ReadAhead.hpp"
+
+// C++ includes.
+#include <list>
+#include <unordered_map>
+#include <vector>
 
 namespace LibRpBase {
 
@@ -50,6 +57,77 @@ class SparseDiscReaderPrivate
 		int64_t disc_size;	// Virtual disc image size.
 		int64_t pos;		// Read position.
 		unsigned int block_size;	// Block size.
+
+		// Sequential read detection.
+		ReadAhead readAhead;
+
+	public:
+		/** Block cache. **/
+
+		// Cached data is stored in lines of up to CACHE_LINE_SIZE bytes.
+		// If the block size is smaller, one line is one block.
+		static const unsigned int CACHE_LINE_SIZE = 32*1024;
+		// Reads larger than this bypass the cache.
+		static const size_t CACHE_MAX_READ = 64*1024;
+		// Default cache size per reader.
+		static const size_t CACHE_SIZE_DEFAULT = 512*1024;
+
+		struct CacheLine {
+			int64_t lineIdx;		// Line index.
+			std::vector<uint8_t> data;	// Line data.
+		};
+
+		mutable Mutex cacheMutex;	// Protects all cache fields.
+		std::list<CacheLine> cacheLines;	// Cache lines, most recently used first.
+		std::unordered_map<int64_t, std::list<CacheLine>::iterator> cacheMap;
+		size_t cacheSize;		// Current cache size, in bytes.
+		size_t cacheSizeMax;		// Maximum cache size, in bytes. (0 == disabled)
+		uint64_t cacheHits;		// Number of lines read from the cache.
+		uint64_t cacheMisses;		// Number of lines read from the disc image.
+
+		// Process-wide cache usage.
+		// Protected by globalCacheMutex.
+		static Mutex globalCacheMutex;
+		static size_t globalCacheSize;	// Current size of all caches, in bytes.
+		static size_t globalCacheSizeMax;	// Maximum size of all caches, in bytes. (0 == unlimited)
+
+		/**
+		 * Get the cache line size.
+		 * @return Cache line size.
+		 */
+		unsigned int cacheLineSize(void) const;
+
+		/**
+		 * Read data using the block cache.
+		 * @param pos	[in] Starting address.
+		 * @param ptr	[out] Output data buffer.
+		 * @param size	[in] Amount of data to read, in bytes.
+		 * @return Number of bytes read.
+		 */
+		size_t readCached(int64_t pos, uint8_t *ptr, size_t size);
+
+		/**
+		 * Add a line to the cache.
+		 * cacheMutex must be locked by the caller.
+		 * @param lineIdx	[in] Line index.
+		 * @param data		[in/out] Line data. (swapped into the cache)
+		 */
+		void cacheInsert(int64_t lineIdx, std::vector<uint8_t> &data);
+
+		/**
+		 * Evict the least recently used line from the cache.
+		 * cacheMutex must be locked by the caller.
+		 * NOTE: globalCacheSize is not updated.
+		 * @return Size of the evicted line, in bytes.
+		 */
+		size_t cacheEvictLRU(void);
+
+		/**
+		 * Evict lines until the cache is at most the specified size.
+		 * cacheMutex must be locked by the caller.
+		 * @param size Maximum cache size, in bytes.
+		 */
+		void cacheShrink(size_t size);
 };
 
 }
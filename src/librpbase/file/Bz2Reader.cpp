@@ -0,0 +1,251 @@
+/***************************************************************************
+ * ROM Properties Page shell extension. (librpbase)                        *
+ * Bz2Reader.cpp: bzip2 decompression reader.                              *
+ *                                                                         *
+ * Copyright (c) 2016-2018 by David Korth.                                 *
+ *                                                                         *
+ * This program is free software; you can redistribute it and/or modify it *
+ * under the terms of the GNU General Public License as published by the   *
+ * Free Software Foundation; either version 2 of the License, or (at your  *
+ * option) any later version.                                              *
+ *                                                                         *
+ * This program is distributed in the hope that it will be useful, but     *
+ * WITHOUT ANY WARRANTY; without even the implied warranty of              *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the           *
+ * GNU General Public License for more details.                            *
+ *                                                                         *
+ * You should have received a copy of the GNU General Public License       *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.   *
+ ***************************************************************************/
+
+#include "Bz2Reader.hpp"
+
+// bzip2
+#include <bzlib.h>
+
+// C includes. (C++ namespace)
+#include <cerrno>
+#include <climits>
+#include <cstring>
+
+namespace LibRpBase {
+
+/** Bz2ReaderPrivate **/
+
+class Bz2ReaderPrivate
+{
+	public:
+		Bz2ReaderPrivate(Bz2Reader *q);
+		~Bz2ReaderPrivate();
+
+	private:
+		RP_DISABLE_COPY(Bz2ReaderPrivate)
+		Bz2Reader *const q_ptr;
+
+	public:
+		// Decompression state.
+		bz_stream strm;
+		bool strm_init;		// True if strm is initialized.
+		bool eof;		// True if the end of the compressed data was reached.
+		int64_t in_pos;		// Compressed address of the end of inbuf.
+
+		uint8_t inbuf[16384];
+
+	public:
+		/**
+		 * Refill the input buffer.
+		 * Unused input data is moved to the start of the buffer.
+		 * @return Number of bytes read.
+		 */
+		size_t fillInput(void);
+
+		/**
+		 * Close the decompressor.
+		 */
+		void closeStream(void);
+};
+
+Bz2ReaderPrivate::Bz2ReaderPrivate(Bz2Reader *q)
+	: q_ptr(q)
+	, strm_init(false)
+	, eof(false)
+	, in_pos(0)
+{
+	memset(&strm, 0, sizeof(strm));
+}
+
+Bz2ReaderPrivate::~Bz2ReaderPrivate()
+{
+	closeStream();
+}
+
+/**
+ * Refill the input buffer.
+ * Unused input data is moved to the start of the buffer.
+ * @return Number of bytes read.
+ */
+size_t Bz2ReaderPrivate::fillInput(void)
+{
+	RP_Q(Bz2Reader);
+	unsigned int leftover = strm.avail_in;
+	if (leftover > 0 && strm.next_in != reinterpret_cast<char*>(inbuf)) {
+		memmove(inbuf, strm.next_in, leftover);
+	}
+
+	size_t to_read = sizeof(inbuf) - leftover;
+	if (q->m_comp_size - in_pos < static_cast<int64_t>(to_read)) {
+		to_read = static_cast<size_t>(q->m_comp_size - in_pos);
+	}
+	const size_t sz_read = (to_read > 0
+		? q->readCompressed(in_pos, &inbuf[leftover], to_read)
+		: 0);
+	in_pos += sz_read;
+
+	strm.next_in = reinterpret_cast<char*>(inbuf);
+	strm.avail_in = leftover + static_cast<unsigned int>(sz_read);
+	return sz_read;
+}
+
+/**
+ * Close the decompressor.
+ */
+void Bz2ReaderPrivate::closeStream(void)
+{
+	if (strm_init) {
+		BZ2_bzDecompressEnd(&strm);
+		strm_init = false;
+	}
+}
+
+/** Bz2Reader **/
+
+/**
+ * Create a bzip2 decompression reader.
+ * @param readFunc	[in] Read function for compressed data.
+ * @param opaque	[in] Opaque pointer for readFunc.
+ * @param comp_size	[in] Compressed file size.
+ */
+Bz2Reader::Bz2Reader(ReadFunc readFunc, void *opaque, int64_t comp_size)
+	: super(readFunc, opaque, comp_size)
+	, d_ptr(new Bz2ReaderPrivate(this))
+{ }
+
+/**
+ * Create a bzip2 decompression reader for the
+ * same compressed file as another reader.
+ * @param other		[in] Other Bz2Reader.
+ * @param readFunc	[in] Read function for compressed data.
+ * @param opaque	[in] Opaque pointer for readFunc.
+ */
+Bz2Reader::Bz2Reader(const Bz2Reader &other, ReadFunc readFunc, void *opaque)
+	: super(other, readFunc, opaque)
+	, d_ptr(new Bz2ReaderPrivate(this))
+{ }
+
+Bz2Reader::~Bz2Reader()
+{
+	delete d_ptr;
+}
+
+/**
+ * Create a new reader for the same compressed file.
+ * @param readFunc	[in] Read function for compressed data.
+ * @param opaque	[in] Opaque pointer for readFunc.
+ * @return New reader.
+ */
+IDecompReader *Bz2Reader::dup(ReadFunc readFunc, void *opaque) const
+{
+	return new Bz2Reader(*this, readFunc, opaque);
+}
+
+/**
+ * Restart decompression at a restart point.
+ * @param rp Restart point.
+ * @return 0 on success; negative POSIX error code on error.
+ */
+int Bz2Reader::resetStream(const RestartPoint &rp)
+{
+	RP_D(Bz2Reader);
+	d->closeStream();
+	memset(&d->strm, 0, sizeof(d->strm));
+	d->eof = false;
+	d->in_pos = rp.in;
+
+	int ret = BZ2_bzDecompressInit(&d->strm, 0, 0);
+	if (ret != BZ_OK) {
+		return (ret == BZ_MEM_ERROR ? -ENOMEM : -EIO);
+	}
+	d->strm_init = true;
+	return 0;
+}
+
+/**
+ * Decompress data from the current block.
+ * @param out	[out] Output buffer.
+ * @param size	[in] Size of the output buffer.
+ * @return Number of bytes decompressed; 0 at the end of the block; negative POSIX error code on error.
+ */
+int64_t Bz2Reader::decodeStream(uint8_t *out, size_t size)
+{
+	RP_D(Bz2Reader);
+	if (d->eof || !d->strm_init) {
+		return 0;
+	}
+
+	if (size > UINT_MAX) {
+		size = UINT_MAX;
+	}
+	d->strm.next_out = reinterpret_cast<char*>(out);
+	d->strm.avail_out = static_cast<unsigned int>(size);
+
+	while (d->strm.avail_out > 0) {
+		if (d->strm.avail_in == 0 && d->fillInput() == 0) {
+			// End of file. (Truncated bzip2 stream.)
+			d->eof = true;
+			break;
+		}
+
+		int ret = BZ2_bzDecompress(&d->strm);
+		if (ret == BZ_STREAM_END) {
+			// End of this bzip2 stream.
+			// Check if another stream follows it.
+			if (d->strm.avail_in < 4) {
+				d->fillInput();
+			}
+			if (d->strm.avail_in < 4 || memcmp(d->strm.next_in, "BZh", 3) != 0) {
+				// No more streams.
+				d->eof = true;
+				break;
+			}
+
+			// Restart the decompressor for the next stream.
+			char *const next_in = d->strm.next_in;
+			const unsigned int avail_in = d->strm.avail_in;
+			char *const next_out = d->strm.next_out;
+			const unsigned int avail_out = d->strm.avail_out;
+			BZ2_bzDecompressEnd(&d->strm);
+			memset(&d->strm, 0, sizeof(d->strm));
+			ret = BZ2_bzDecompressInit(&d->strm, 0, 0);
+			if (ret != BZ_OK) {
+				d->strm_init = false;
+				return (ret == BZ_MEM_ERROR ? -ENOMEM : -EIO);
+			}
+			d->strm.next_in = next_in;
+			d->strm.avail_in = avail_in;
+			d->strm.next_out = next_out;
+			d->strm.avail_out = avail_out;
+		} else if (ret != BZ_OK) {
+			// Decompression error.
+			return (ret == BZ_MEM_ERROR ? -ENOMEM : -EIO);
+		}
+
+		if (d->strm.avail_out < size) {
+			// Got some data.
+			break;
+		}
+	}
+
+	return static_cast<int64_t>(size - d->strm.avail_out);
+}
+
+}
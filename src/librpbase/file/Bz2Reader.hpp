@@ -0,0 +1,105 @@
+/***************************************************************************
+ * ROM Properties Page shell extension. (librpbase)                        *
+ * Bz2Reader.hpp: bzip2 decompression reader.                              *
+ *                                                                         *
+ * Copyright (c) 2016-2018 by David Korth.                                 *
+ *                                                                         *
+ * This program is free software; you can redistribute it and/or modify it *
+ * under the terms of the GNU General Public License as published by the   *
+ * Free Software Foundation; either version 2 of the License, or (at your  *
+ * option) any later version.                                              *
+ *                                                                         *
+ * This program is distributed in the hope that it will be useful, but     *
+ * WITHOUT ANY WARRANTY; without even the implied warranty of              *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the           *
+ * GNU General Public License for more details.                            *
+ *                                                                         *
+ * You should have received a copy of the GNU General Public License       *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.   *
+ ***************************************************************************/
+
+#ifndef __ROMPROPERTIES_LIBRPBASE_FILE_BZ2READER_HPP__
+#define __ROMPROPERTIES_LIBRPBASE_FILE_BZ2READER_HPP__
+
+#include "DecompStreamReader.hpp"
+
+namespace LibRpBase {
+
+/**
+ * bzip2 decompression reader.
+ *
+ * bzip2 blocks aren't byte-aligned and there's no index,
+ * so the file is always decompressed from the beginning.
+ * Concatenated streams (e.g. from pbzip2) are supported.
+ *
+ * The uncompressed size isn't stored in the file, so
+ * size() has to decompress the entire file.
+ */
+class Bz2ReaderPrivate;
+class Bz2Reader : public DecompStreamReader
+{
+	public:
+		/**
+		 * Create a bzip2 decompression reader.
+		 * @param readFunc	[in] Read function for compressed data.
+		 * @param opaque	[in] Opaque pointer for readFunc.
+		 * @param comp_size	[in] Compressed file size.
+		 */
+		Bz2Reader(ReadFunc readFunc, void *opaque, int64_t comp_size);
+
+		/**
+		 * Create a bzip2 decompression reader for the
+		 * same compressed file as another reader.
+		 * @param other		[in] Other Bz2Reader.
+		 * @param readFunc	[in] Read function for compressed data.
+		 * @param opaque	[in] Opaque pointer for readFunc.
+		 */
+		Bz2Reader(const Bz2Reader &other, ReadFunc readFunc, void *opaque);
+
+		~Bz2Reader();
+
+	private:
+		typedef DecompStreamReader super;
+		RP_DISABLE_COPY(Bz2Reader)
+	protected:
+		friend class Bz2ReaderPrivate;
+		Bz2ReaderPrivate *const d_ptr;
+
+	public:
+		/**
+		 * Get the compression format.
+		 * @return Compression format.
+		 */
+		Format format(void) const final
+		{
+			return FMT_BZIP2;
+		}
+
+		/**
+		 * Create a new reader for the same compressed file.
+		 * @param readFunc	[in] Read function for compressed data.
+		 * @param opaque	[in] Opaque pointer for readFunc.
+		 * @return New reader.
+		 */
+		IDecompReader *dup(ReadFunc readFunc, void *opaque) const final;
+
+	protected:
+		/**
+		 * Restart decompression at a restart point.
+		 * @param rp Restart point.
+		 * @return 0 on success; negative POSIX error code on error.
+		 */
+		int resetStream(const RestartPoint &rp) final;
+
+		/**
+		 * Decompress data from the current block.
+		 * @param out	[out] Output buffer.
+		 * @param size	[in] Size of the output buffer.
+		 * @return Number of bytes decompressed; 0 at the end of the block; negative POSIX error code on error.
+		 */
+		int64_t decodeStream(uint8_t *out, size_t size) final;
+};
+
+}
+
+#endif /* __ROMPROPERTIES_LIBRPBASE_FILE_BZ2READER_HPP__ */
@@ -0,0 +1,282 @@
+/***************************************************************************
+ * ROM Properties Page shell extension. (librpbase)                        *
+ * DecompStreamReader.cpp: Seekable reader for stream decompressors.       *
+ *                                                                         *
+ * Copyright (c) 2016-2018 by David Korth.                                 *
+ *                                                                         *
+ * This program is free software; you can redistribute it and/or modify it *
+ * under the terms of the GNU General Public License as published by the   *
+ * Free Software Foundation; either version 2 of the License, or (at your  *
+ * option) any later version.                                              *
+ *                                                                         *
+ * This program is distributed in the hope that it will be useful, but     *
+ * WITHOUT ANY WARRANTY; without even the implied warranty of              *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the           *
+ * GNU General Public License for more details.                            *
+ *                                                                         *
+ * You should have received a copy of the GNU General Public License       *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.   *
+ ***************************************************************************/
+
+#include "DecompStreamReader.hpp"
+
+// C includes. (C++ namespace)
+#include <cerrno>
+#include <cstring>
+
+namespace LibRpBase {
+
+// Size of the buffer for skipped data.
+#define SKIPBUF_SIZE (64*1024)
+
+/**
+ * Create a stream decompression reader.
+ * @param readFunc	[in] Read function for compressed data.
+ * @param opaque	[in] Opaque pointer for readFunc.
+ * @param comp_size	[in] Compressed file size.
+ */
+DecompStreamReader::DecompStreamReader(ReadFunc readFunc, void *opaque, int64_t comp_size)
+	: super()
+	, m_readFunc(readFunc)
+	, m_opaque(opaque)
+	, m_comp_size(comp_size)
+	, m_uncomp_size(-1)
+	, m_active(false)
+	, m_block_in(0)
+	, m_out_pos(0)
+{ }
+
+/**
+ * Create a stream decompression reader for the
+ * same compressed file as another reader.
+ * @param other		[in] Other DecompStreamReader.
+ * @param readFunc	[in] Read function for compressed data.
+ * @param opaque	[in] Opaque pointer for readFunc.
+ */
+DecompStreamReader::DecompStreamReader(const DecompStreamReader &other, ReadFunc readFunc, void *opaque)
+	: super()
+	, m_readFunc(readFunc)
+	, m_opaque(opaque)
+	, m_comp_size(other.m_comp_size)
+	, m_uncomp_size(other.m_uncomp_size)
+	, m_active(false)
+	, m_block_in(0)
+	, m_out_pos(0)
+{ }
+
+/**
+ * Find the last restart point at or before the specified address.
+ * The default implementation returns the start of the file.
+ * @param pos	[in] Uncompressed address.
+ * @param rp	[out] Restart point.
+ */
+void DecompStreamReader::findRestartPoint(int64_t pos, RestartPoint *rp) const
+{
+	RP_UNUSED(pos);
+	rp->in = 0;
+	rp->out = 0;
+}
+
+/**
+ * Restart decompression at a restart point.
+ * @param rp Restart point.
+ * @return 0 on success; negative POSIX error code on error.
+ */
+int DecompStreamReader::restart(const RestartPoint &rp)
+{
+	int ret = resetStream(rp);
+	if (ret != 0) {
+		m_active = false;
+		m_lastError = -ret;
+		return ret;
+	}
+
+	m_active = true;
+	m_block_in = rp.in;
+	m_out_pos = rp.out;
+	return 0;
+}
+
+/**
+ * Decompress data, continuing into the next block
+ * if the current block ends.
+ * @param out	[out] Output buffer.
+ * @param size	[in] Size of the output buffer.
+ * @return Number of bytes decompressed; 0 at the end of the file; negative POSIX error code on error.
+ */
+int64_t DecompStreamReader::decodeNext(uint8_t *out, size_t size)
+{
+	while (true) {
+		int64_t ret = decodeStream(out, size);
+		if (ret > 0) {
+			m_out_pos += ret;
+			return ret;
+		} else if (ret < 0) {
+			// Decompression error.
+			m_active = false;
+			m_lastError = static_cast<int>(-ret);
+			return ret;
+		}
+
+		// End of the current block.
+		// If the next block is a restart point, continue there.
+		RestartPoint rp;
+		findRestartPoint(m_out_pos, &rp);
+		if (rp.out != m_out_pos || rp.in <= m_block_in) {
+			// No more blocks.
+			if (m_uncomp_size < 0) {
+				// Now we know the uncompressed size.
+				m_uncomp_size = m_out_pos;
+			}
+			return 0;
+		}
+
+		int rret = restart(rp);
+		if (rret != 0) {
+			return rret;
+		}
+	}
+}
+
+/**
+ * Read uncompressed data.
+ * @param pos	[in] Uncompressed starting address.
+ * @param ptr	[out] Output data buffer.
+ * @param size	[in] Amount of data to read, in bytes.
+ * @return Number of bytes read.
+ */
+size_t DecompStreamReader::read(int64_t pos, void *ptr, size_t size)
+{
+	if (pos < 0) {
+		m_lastError = EINVAL;
+		return 0;
+	} else if (size == 0) {
+		return 0;
+	}
+
+	if (m_uncomp_size >= 0) {
+		// Don't read past the end of the file.
+		if (pos >= m_uncomp_size) {
+			return 0;
+		} else if (static_cast<int64_t>(size) > m_uncomp_size - pos) {
+			size = static_cast<size_t>(m_uncomp_size - pos);
+		}
+	}
+
+	// Restart decompression if the requested address is behind
+	// the current position, or if there's a restart point that's
+	// closer than the current position.
+	RestartPoint rp;
+	findRestartPoint(pos, &rp);
+	if (!m_active || pos < m_out_pos || rp.out > m_out_pos) {
+		if (restart(rp) != 0) {
+			return 0;
+		}
+	}
+
+	// Skip data until we reach the requested address.
+	while (m_out_pos < pos) {
+		if (!m_skipbuf) {
+			m_skipbuf.reset(new uint8_t[SKIPBUF_SIZE]);
+		}
+		size_t to_skip = SKIPBUF_SIZE;
+		if (pos - m_out_pos < static_cast<int64_t>(to_skip)) {
+			to_skip = static_cast<size_t>(pos - m_out_pos);
+		}
+		if (decodeNext(m_skipbuf.get(), to_skip) <= 0) {
+			// End of file or error.
+			return 0;
+		}
+	}
+
+	// Decompress the requested data.
+	uint8_t *ptr8 = static_cast<uint8_t*>(ptr);
+	size_t ret = 0;
+	while (ret < size) {
+		int64_t n = decodeNext(ptr8 + ret, size - ret);
+		if (n <= 0) {
+			// End of file or error.
+			break;
+		}
+		ret += static_cast<size_t>(n);
+	}
+	return ret;
+}
+
+/**
+ * Get the uncompressed size.
+ *
+ * If the format doesn't store the uncompressed size,
+ * the rest of the file will be decompressed in order
+ * to determine the size.
+ *
+ * @return Uncompressed size, or negative on error.
+ */
+int64_t DecompStreamReader::size(void)
+{
+	if (m_uncomp_size >= 0) {
+		return m_uncomp_size;
+	}
+
+	// Decompress the rest of the file.
+	if (!m_active) {
+		RestartPoint rp;
+		findRestartPoint(0, &rp);
+		if (restart(rp) != 0) {
+			return -m_lastError;
+		}
+	}
+	if (!m_skipbuf) {
+		m_skipbuf.reset(new uint8_t[SKIPBUF_SIZE]);
+	}
+
+	int64_t ret;
+	do {
+		ret = decodeNext(m_skipbuf.get(), SKIPBUF_SIZE);
+	} while (ret > 0);
+	if (ret < 0) {
+		return ret;
+	}
+	return m_uncomp_size;
+}
+
+/**
+ * Get the uncompressed size, decompressing
+ * at most max_size bytes to determine it.
+ * @param max_size	[in] Maximum amount of data to decompress.
+ * @return Uncompressed size if it's known or if it's <= max_size; otherwise, a lower bound larger than max_size. Negative on error.
+ */
+int64_t DecompStreamReader::sizeUpTo(int64_t max_size)
+{
+	if (m_uncomp_size >= 0) {
+		return m_uncomp_size;
+	}
+
+	if (!m_active) {
+		RestartPoint rp;
+		findRestartPoint(0, &rp);
+		if (restart(rp) != 0) {
+			return -m_lastError;
+		}
+	}
+	if (!m_skipbuf) {
+		m_skipbuf.reset(new uint8_t[SKIPBUF_SIZE]);
+	}
+
+	// Decompress until the end of the file is found,
+	// or until we're past max_size.
+	while (m_out_pos <= max_size) {
+		const int64_t ret = decodeNext(m_skipbuf.get(), SKIPBUF_SIZE);
+		if (ret == 0) {
+			// End of file.
+			return m_uncomp_size;
+		} else if (ret < 0) {
+			return ret;
+		}
+	}
+
+	// The file is larger than max_size.
+	return m_out_pos;
+}
+
+}
@@ -0,0 +1,180 @@
+/***************************************************************************
+ * ROM Properties Page shell extension. (librpbase)                        *
+ * DecompStreamReader.hpp: Seekable reader for stream decompressors.       *
+ *                                                                         *
+ * Copyright (c) 2016-2018 by David Korth.                                 *
+ *                                                                         *
+ * This program is free software; you can redistribute it and/or modify it *
+ * under the terms of the GNU General Public License as published by the   *
+ * Free Software Foundation; either version 2 of the License, or (at your  *
+ * option) any later version.                                              *
+ *                                                                         *
+ * This program is distributed in the hope that it will be useful, but     *
+ * WITHOUT ANY WARRANTY; without even the implied warranty of              *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the           *
+ * GNU General Public License for more details.                            *
+ *                                                                         *
+ * You should have received a copy of the GNU General Public License       *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.   *
+ ***************************************************************************/
+
+#ifndef __ROMPROPERTIES_LIBRPBASE_FILE_DECOMPSTREAMREADER_HPP__
+#define __ROMPROPERTIES_LIBRPBASE_FILE_DECOMPSTREAMREADER_HPP__
+
+#include "IDecompReader.hpp"
+
+// C++ includes.
+#include <memory>
+
+namespace LibRpBase {
+
+/**
+ * Seekable reader for stream decompressors.
+ *
+ * Subclasses only need to implement forward decompression
+ * starting at a "restart point", i.e. a location where the
+ * decompressor can be started without any previous state.
+ * Formats with a seek index (xz blocks, seekable zstd frames)
+ * provide a restart point for each independent block; other
+ * formats only have a restart point at the start of the file.
+ *
+ * Reads that are ahead of the current position within the
+ * same block continue decompressing; anything else restarts
+ * decompression from the nearest preceding restart point.
+ */
+class DecompStreamReader : public IDecompReader
+{
+	protected:
+		/**
+		 * Create a stream decompression reader.
+		 * @param readFunc	[in] Read function for compressed data.
+		 * @param opaque	[in] Opaque pointer for readFunc.
+		 * @param comp_size	[in] Compressed file size.
+		 */
+		DecompStreamReader(ReadFunc readFunc, void *opaque, int64_t comp_size);
+
+		/**
+		 * Create a stream decompression reader for the
+		 * same compressed file as another reader.
+		 * @param other		[in] Other DecompStreamReader.
+		 * @param readFunc	[in] Read function for compressed data.
+		 * @param opaque	[in] Opaque pointer for readFunc.
+		 */
+		DecompStreamReader(const DecompStreamReader &other, ReadFunc readFunc, void *opaque);
+
+	public:
+		virtual ~DecompStreamReader() { }
+
+	private:
+		typedef IDecompReader super;
+		RP_DISABLE_COPY(DecompStreamReader)
+
+	public:
+		/**
+		 * Read uncompressed data.
+		 * @param pos	[in] Uncompressed starting address.
+		 * @param ptr	[out] Output data buffer.
+		 * @param size	[in] Amount of data to read, in bytes.
+		 * @return Number of bytes read.
+		 */
+		size_t read(int64_t pos, void *ptr, size_t size) final;
+
+		/**
+		 * Get the uncompressed size.
+		 *
+		 * If the format doesn't store the uncompressed size,
+		 * the rest of the file will be decompressed in order
+		 * to determine the size.
+		 *
+		 * @return Uncompressed size, or negative on error.
+		 */
+		int64_t size(void) final;
+
+		/**
+		 * Get the uncompressed size, decompressing
+		 * at most max_size bytes to determine it.
+		 * @param max_size	[in] Maximum amount of data to decompress.
+		 * @return Uncompressed size if it's known or if it's <= max_size; otherwise, a lower bound larger than max_size. Negative on error.
+		 */
+		int64_t sizeUpTo(int64_t max_size) final;
+
+	protected:
+		/**
+		 * Restart point.
+		 * Decompression can be started at any restart point.
+		 */
+		struct RestartPoint {
+			int64_t in;	// Compressed address.
+			int64_t out;	// Uncompressed address.
+		};
+
+		/**
+		 * Find the last restart point at or before the specified address.
+		 * The default implementation returns the start of the file.
+		 * @param pos	[in] Uncompressed address.
+		 * @param rp	[out] Restart point.
+		 */
+		virtual void findRestartPoint(int64_t pos, RestartPoint *rp) const;
+
+		/**
+		 * Restart decompression at a restart point.
+		 * @param rp Restart point.
+		 * @return 0 on success; negative POSIX error code on error.
+		 */
+		virtual int resetStream(const RestartPoint &rp) = 0;
+
+		/**
+		 * Decompress data from the current block.
+		 * @param out	[out] Output buffer.
+		 * @param size	[in] Size of the output buffer.
+		 * @return Number of bytes decompressed; 0 at the end of the block; negative POSIX error code on error.
+		 */
+		virtual int64_t decodeStream(uint8_t *out, size_t size) = 0;
+
+		/**
+		 * Read compressed data.
+		 * @param pos	[in] Compressed address.
+		 * @param ptr	[out] Output data buffer.
+		 * @param size	[in] Amount of data to read, in bytes.
+		 * @return Number of bytes read.
+		 */
+		inline size_t readCompressed(int64_t pos, void *ptr, size_t size)
+		{
+			return m_readFunc(m_opaque, pos, ptr, size);
+		}
+
+	private:
+		/**
+		 * Decompress data, continuing into the next block
+		 * if the current block ends.
+		 * @param out	[out] Output buffer.
+		 * @param size	[in] Size of the output buffer.
+		 * @return Number of bytes decompressed; 0 at the end of the file; negative POSIX error code on error.
+		 */
+		int64_t decodeNext(uint8_t *out, size_t size);
+
+		/**
+		 * Restart decompression at a restart point.
+		 * @param rp Restart point.
+		 * @return 0 on success; negative POSIX error code on error.
+		 */
+		int restart(const RestartPoint &rp);
+
+	protected:
+		ReadFunc m_readFunc;
+		void *m_opaque;
+		int64_t m_comp_size;	// Compressed file size.
+		int64_t m_uncomp_size;	// Uncompressed file size, or -1 if not known yet.
+
+	private:
+		bool m_active;		// True if the decompressor is active.
+		int64_t m_block_in;	// Compressed address of the current block.
+		int64_t m_out_pos;	// Uncompressed address of the next output byte.
+
+		// Buffer for skipped data. (allocated on demand)
+		std::unique_ptr<uint8_t[]> m_skipbuf;
+};
+
+}
+
+#endif /* __ROMPROPERTIES_LIBRPBASE_FILE_DECOMPSTREAMREADER_HPP__ */
@@ -0,0 +1,732 @@
+/***************************************************************************
+ * ROM Properties Page shell extension. (librpbase)                        *
+ * GzReader.cpp: Seekable gzip reader using an access point index.         *
+ *                                                                         *
+ * Copyright (c) 2016-2018 by David Korth.                                 *
+ *                                                                         *
+ * This program is free software; you can redistribute it and/or modify it *
+ * under the terms of the GNU General Public License as published by the   *
+ * Free Software Foundation; either version 2 of the License, or (at your  *
+ * option) any later version.                                              *
+ *                                                                         *
+ * This program is distributed in the hope that it will be useful, but     *
+ * WITHOUT ANY WARRANTY; without even the implied warranty of              *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the           *
+ * GNU General Public License for more details.                            *
+ *                                                                         *
+ * You should have received a copy of the GNU General Public License       *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.   *
+ ***************************************************************************/
+
+#include "GzReader.hpp"
+
+// librpbase
+#include "byteswap.h"
+#include "RpFile.hpp"
+#include "FileSystem.hpp"
+#include "threads/Mutex.hpp"
+
+// zlib
+#include <zlib.h>
+
+// C includes. (C++ namespace)
+#include <cassert>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+
+// C++ includes.
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <vector>
+using std::shared_ptr;
+using std::string;
+using std::unique_ptr;
+using std::vector;
+
+namespace LibRpBase {
+
+// Size of the deflate window.
+#define GZ_WINSIZE 32768U
+// Minimum span between access points.
+#define GZ_MIN_SPAN (1024*1024)
+// Maximum number of access points, based on the uncompressed size.
+// The span is increased for large files to limit memory usage.
+#define GZ_MAX_POINTS 256
+// Maximum deflate compression ratio.
+// Used to validate index files.
+#define GZ_MAX_RATIO 1032
+
+/**
+ * Access point.
+ * Decompression can be restarted from any access point.
+ */
+struct GzAccessPoint {
+	int64_t out;		// Uncompressed address.
+	int64_t in;		// Compressed address of the first complete byte.
+	uint8_t bits;		// Number of bits (1-7) from the previous byte, or 0.
+	uint8_t prev_byte;	// Previous byte. (only valid if bits != 0)
+	unsigned int win_size;	// Window size. (GZ_WINSIZE, or less at the start of the file)
+	uint8_t window[GZ_WINSIZE];	// Uncompressed data preceding this point.
+};
+
+/**
+ * Access point index.
+ * This is shared between all GzReaders for the same file.
+ */
+struct GzIndex {
+	int64_t comp_size;	// Compressed file size.
+	int64_t uncomp_size;	// Uncompressed file size. (from the gzip trailer)
+	int64_t span;		// Uncompressed bytes between access points.
+	int64_t indexed_out;	// Access points have been recorded up to here.
+	bool dirty;		// True if new access points were recorded.
+
+	// Access points, sorted by uncompressed address.
+	vector<shared_ptr<GzAccessPoint> > points;
+
+	// Mutex for points and indexed_out.
+	Mutex mutex;
+
+	GzIndex(int64_t comp_size, int64_t uncomp_size, int64_t span)
+		: comp_size(comp_size), uncomp_size(uncomp_size), span(span)
+		, indexed_out(0), dirty(false) { }
+
+	private:
+		RP_DISABLE_COPY(GzIndex)
+};
+
+/** GzReaderPrivate **/
+
+class GzReaderPrivate
+{
+	public:
+		GzReaderPrivate(GzReader::ReadFunc readFunc, void *opaque,
+			const shared_ptr<GzIndex> &index);
+		~GzReaderPrivate();
+
+	private:
+		RP_DISABLE_COPY(GzReaderPrivate)
+
+	public:
+		GzReader::ReadFunc readFunc;
+		void *opaque;
+		shared_ptr<GzIndex> index;
+
+		// Decompression state.
+		z_stream strm;
+		bool strm_init;		// True if strm is initialized.
+		bool raw;		// True if inflating raw deflate data. (after an access point)
+		bool eof;		// True if the end of the compressed data was reached.
+		int64_t in_pos;		// Compressed address of the end of inbuf.
+		int64_t out_pos;	// Uncompressed address of the next output byte.
+		uint8_t last_byte;	// Last byte of the previous input buffer.
+		unsigned int in_fill;	// Number of bytes in inbuf.
+
+		uint8_t inbuf[16384];
+		uint8_t window[GZ_WINSIZE];	// Circular buffer of recent output.
+
+	public:
+		/**
+		 * Restart decompression from an access point.
+		 * @param point Access point, or nullptr for the start of the file.
+		 * @return 0 on success; negative POSIX error code on error.
+		 */
+		int restart(const GzAccessPoint *point);
+
+		/**
+		 * Record an access point at the current position.
+		 */
+		void addAccessPoint(void);
+
+		/**
+		 * Skip the gzip trailer after a raw deflate stream,
+		 * and prepare for another gzip member if present.
+		 * @return True if another gzip member is present; false if EOF.
+		 */
+		bool nextMember(void);
+};
+
+GzReaderPrivate::GzReaderPrivate(GzReader::ReadFunc readFunc, void *opaque,
+	const shared_ptr<GzIndex> &index)
+	: readFunc(readFunc)
+	, opaque(opaque)
+	, index(index)
+	, strm_init(false)
+	, raw(false)
+	, eof(false)
+	, in_pos(0)
+	, out_pos(0)
+	, last_byte(0)
+	, in_fill(0)
+{
+	memset(&strm, 0, sizeof(strm));
+
+	// Make sure the CRC32 table is initialized.
+	get_crc_table();
+}
+
+GzReaderPrivate::~GzReaderPrivate()
+{
+	if (strm_init) {
+		inflateEnd(&strm);
+	}
+}
+
+/**
+ * Restart decompression from an access point.
+ * @param point Access point, or nullptr for the start of the file.
+ * @return 0 on success; negative POSIX error code on error.
+ */
+int GzReaderPrivate::restart(const GzAccessPoint *point)
+{
+	// Access points are within raw deflate data.
+	// The start of the file has a gzip header.
+	const int windowBits = (point ? -15 : 15+16);
+	int ret;
+	if (!strm_init) {
+		ret = inflateInit2(&strm, windowBits);
+		if (ret != Z_OK) {
+			return -ENOMEM;
+		}
+		strm_init = true;
+	} else {
+		ret = inflateReset2(&strm, windowBits);
+		if (ret != Z_OK) {
+			return -EIO;
+		}
+	}
+
+	strm.next_in = inbuf;
+	strm.avail_in = 0;
+	in_fill = 0;
+	eof = false;
+
+	if (!point) {
+		// Start of the file.
+		raw = false;
+		in_pos = 0;
+		out_pos = 0;
+		return 0;
+	}
+
+	raw = true;
+	in_pos = point->in;
+	out_pos = point->out;
+	last_byte = point->prev_byte;
+	if (point->bits != 0) {
+		inflatePrime(&strm, point->bits, point->prev_byte >> (8 - point->bits));
+	}
+	inflateSetDictionary(&strm, point->window, point->win_size);
+
+	// Restore the circular window so new access points
+	// can be recorded after this one.
+	if (point->win_size == GZ_WINSIZE) {
+		const unsigned int wpos = static_cast<unsigned int>(out_pos % GZ_WINSIZE);
+		memcpy(&window[wpos], point->window, GZ_WINSIZE - wpos);
+		memcpy(window, &point->window[GZ_WINSIZE - wpos], wpos);
+	} else {
+		memcpy(window, point->window, point->win_size);
+	}
+	return 0;
+}
+
+/**
+ * Record an access point at the current position.
+ */
+void GzReaderPrivate::addAccessPoint(void)
+{
+	shared_ptr<GzAccessPoint> point = std::make_shared<GzAccessPoint>();
+	point->out = out_pos;
+	point->in = in_pos - strm.avail_in;
+	point->bits = strm.data_type & 7;
+	point->prev_byte = (strm.next_in > inbuf ? strm.next_in[-1] : last_byte);
+
+	// Save the window, oldest byte first.
+	if (out_pos >= GZ_WINSIZE) {
+		const unsigned int wpos = static_cast<unsigned int>(out_pos % GZ_WINSIZE);
+		point->win_size = GZ_WINSIZE;
+		memcpy(point->window, &window[wpos], GZ_WINSIZE - wpos);
+		memcpy(&point->window[GZ_WINSIZE - wpos], window, wpos);
+	} else {
+		point->win_size = static_cast<unsigned int>(out_pos);
+		memcpy(point->window, window, point->win_size);
+	}
+
+	// NOTE: The caller must hold the index mutex.
+	index->points.push_back(point);
+	index->dirty = true;
+}
+
+/**
+ * Skip the gzip trailer after a raw deflate stream,
+ * and prepare for another gzip member if present.
+ * @return True if another gzip member is present; false if EOF.
+ */
+bool GzReaderPrivate::nextMember(void)
+{
+	if (raw) {
+		// Skip the CRC32 and ISIZE fields.
+		unsigned int skip = 8;
+		const unsigned int avail = std::min(skip, strm.avail_in);
+		strm.next_in += avail;
+		strm.avail_in -= avail;
+		skip -= avail;
+		if (skip > 0) {
+			// Trailer extends past the input buffer.
+			in_pos += skip;
+			last_byte = 0;
+			strm.next_in = inbuf;
+			in_fill = 0;
+		}
+	}
+
+	if (in_pos - static_cast<int64_t>(strm.avail_in) >= index->comp_size) {
+		// No more gzip members.
+		return false;
+	}
+
+	// Another gzip member is present.
+	if (inflateReset2(&strm, 15+16) != Z_OK) {
+		return false;
+	}
+	raw = false;
+	return true;
+}
+
+/** GzReader **/
+
+/**
+ * Create a seekable gzip reader.
+ * @param readFunc	[in] Read function for compressed data.
+ * @param opaque	[in] Opaque pointer for readFunc.
+ * @param comp_size	[in] Compressed file size.
+ * @param uncomp_size	[in] Uncompressed file size. (from the gzip trailer)
+ */
+GzReader::GzReader(ReadFunc readFunc, void *opaque, int64_t comp_size, int64_t uncomp_size)
+	: super()
+	, d_ptr(new GzReaderPrivate(readFunc, opaque,
+		std::make_shared<GzIndex>(comp_size, uncomp_size,
+			std::max(static_cast<int64_t>(GZ_MIN_SPAN), uncomp_size / GZ_MAX_POINTS))))
+{ }
+
+/**
+ * Create a seekable gzip reader that shares
+ * another reader's access point index.
+ * @param other		[in] Other GzReader.
+ * @param readFunc	[in] Read function for compressed data.
+ * @param opaque	[in] Opaque pointer for readFunc.
+ */
+GzReader::GzReader(const GzReader &other, ReadFunc readFunc, void *opaque)
+	: super()
+	, d_ptr(new GzReaderPrivate(readFunc, opaque, other.d_ptr->index))
+{ }
+
+GzReader::~GzReader()
+{
+	delete d_ptr;
+}
+
+/**
+ * Create a new reader for the same compressed file.
+ * The access point index is shared with this reader.
+ * @param readFunc	[in] Read function for compressed data.
+ * @param opaque	[in] Opaque pointer for readFunc.
+ * @return New reader.
+ */
+IDecompReader *GzReader::dup(ReadFunc readFunc, void *opaque) const
+{
+	return new GzReader(*this, readFunc, opaque);
+}
+
+/**
+ * Read uncompressed data.
+ * @param pos	[in] Uncompressed starting address.
+ * @param ptr	[out] Output data buffer.
+ * @param size	[in] Amount of data to read, in bytes.
+ * @return Number of bytes read.
+ */
+size_t GzReader::read(int64_t pos, void *ptr, size_t size)
+{
+	RP_D(GzReader);
+	if (pos < 0) {
+		m_lastError = EINVAL;
+		return 0;
+	} else if (size == 0) {
+		return 0;
+	}
+
+	GzIndex *const index = d->index.get();
+
+	// Find the closest access point before the requested address.
+	shared_ptr<GzAccessPoint> point;
+	{
+		MutexLocker locker(index->mutex);
+		auto iter = std::upper_bound(index->points.cbegin(), index->points.cend(), pos,
+			[](int64_t pos, const shared_ptr<GzAccessPoint> &pt) {
+				return (pos < pt->out);
+			});
+		if (iter != index->points.cbegin()) {
+			point = *(--iter);
+		}
+	}
+
+	// Restart decompression if the requested address is behind
+	// the current position, or if there's an access point that's
+	// closer than the current position.
+	if (!d->strm_init || pos < d->out_pos ||
+	    (point && point->out > d->out_pos))
+	{
+		int ret = d->restart(point.get());
+		if (ret != 0) {
+			m_lastError = -ret;
+			return 0;
+		}
+	}
+
+	uint8_t *const ptr8 = static_cast<uint8_t*>(ptr);
+	size_t ret = 0;
+	while (ret < size && !d->eof) {
+		// Refill the input buffer if necessary.
+		if (d->strm.avail_in == 0) {
+			if (d->in_fill > 0) {
+				d->last_byte = d->inbuf[d->in_fill - 1];
+			}
+			size_t to_read = sizeof(d->inbuf);
+			if (index->comp_size - d->in_pos < static_cast<int64_t>(to_read)) {
+				to_read = static_cast<size_t>(index->comp_size - d->in_pos);
+			}
+			const size_t sz_read = (to_read > 0
+				? d->readFunc(d->opaque, d->in_pos, d->inbuf, to_read)
+				: 0);
+			if (sz_read == 0) {
+				// End of file. (Truncated gzip stream.)
+				d->eof = true;
+				break;
+			}
+			d->in_pos += sz_read;
+			d->in_fill = static_cast<unsigned int>(sz_read);
+			d->strm.next_in = d->inbuf;
+			d->strm.avail_in = static_cast<uInt>(sz_read);
+		}
+
+		// Decompress into the circular window.
+		const unsigned int wpos = static_cast<unsigned int>(d->out_pos % GZ_WINSIZE);
+		const unsigned int wavail = GZ_WINSIZE - wpos;
+		d->strm.next_out = &d->window[wpos];
+		d->strm.avail_out = wavail;
+		int zret = inflate(&d->strm, Z_BLOCK);
+		if (zret == Z_NEED_DICT || zret == Z_DATA_ERROR || zret == Z_MEM_ERROR) {
+			// Decompression error.
+			// NOTE: Trailing garbage after a gzip member is
+			// handled here, too.
+			m_lastError = (zret == Z_MEM_ERROR ? ENOMEM : EIO);
+			d->eof = true;
+			break;
+		}
+		const unsigned int produced = wavail - d->strm.avail_out;
+
+		if (produced > 0) {
+			// Copy the requested part of the new data.
+			const int64_t want = pos + static_cast<int64_t>(ret);
+			const int64_t out_end = d->out_pos + produced;
+			if (out_end > want) {
+				assert(want >= d->out_pos);
+				const unsigned int skip = static_cast<unsigned int>(want - d->out_pos);
+				size_t n = produced - skip;
+				if (n > size - ret) {
+					n = size - ret;
+				}
+				memcpy(&ptr8[ret], &d->window[wpos + skip], n);
+				ret += n;
+			}
+			d->out_pos = out_end;
+		}
+
+		if (zret == Z_STREAM_END) {
+			// End of this gzip member.
+			if (!d->nextMember()) {
+				d->eof = true;
+			}
+			continue;
+		}
+
+		// Check for a deflate block boundary that isn't the last block.
+		if ((d->strm.data_type & 128) && !(d->strm.data_type & 64)) {
+			MutexLocker locker(index->mutex);
+			if (d->out_pos > index->indexed_out) {
+				// This is past the end of the index.
+				const int64_t last_out = (!index->points.empty()
+					? index->points.back()->out : 0);
+				if (d->out_pos - last_out >= index->span) {
+					d->addAccessPoint();
+				}
+				index->indexed_out = d->out_pos;
+			}
+		}
+	}
+
+	return ret;
+}
+
+/**
+ * Get the uncompressed size.
+ * NOTE: This is the size from the gzip trailer,
+ * which is only accurate for files under 4 GB.
+ * @return Uncompressed size.
+ */
+int64_t GzReader::size(void)
+{
+	RP_D(const GzReader);
+	return d->index->uncomp_size;
+}
+
+/**
+ * Get the number of access points in the index.
+ * @return Number of access points.
+ */
+unsigned int GzReader::accessPointCount(void) const
+{
+	RP_D(const GzReader);
+	MutexLocker locker(d->index->mutex);
+	return static_cast<unsigned int>(d->index->points.size());
+}
+
+/**
+ * Has the index changed since it was created or loaded?
+ * @return True if the index has new access points.
+ */
+bool GzReader::isIndexDirty(void) const
+{
+	RP_D(const GzReader);
+	MutexLocker locker(d->index->mutex);
+	return d->index->dirty;
+}
+
+/** Index files. **/
+
+// Index file header.
+#define GZIDX_MAGIC "RPGZIDX"
+#define GZIDX_VERSION 1
+#pragma pack(1)
+struct PACKED GzIdxHeader {
+	char magic[8];		// "RPGZIDX\0"
+	uint32_t version;	// GZIDX_VERSION
+	uint32_t count;		// Number of access points.
+	int64_t comp_size;	// Compressed file size.
+	int64_t mtime;		// Modification time of the gzipped file.
+	int64_t span;		// Span between access points.
+	int64_t indexed_out;	// Access points have been recorded up to here.
+	uint32_t filename_len;	// Length of the filename that follows.
+};
+struct PACKED GzIdxPoint {
+	int64_t out;
+	int64_t in;
+	uint8_t bits;
+	uint8_t prev_byte;
+	uint16_t reserved;
+	uint32_t win_size;
+	// Followed by win_size bytes of window data.
+};
+#pragma pack()
+
+/**
+ * Get the index filename for a gzipped file.
+ * Index files are stored in the cache directory.
+ * @param filename	[in] gzipped file.
+ * @return Index filename, or empty string on error.
+ */
+string GzReader::indexFilename(const string &filename)
+{
+	string idx_filename = FileSystem::getCacheDirectory();
+	if (idx_filename.empty() || filename.empty())
+		return string();
+	if (idx_filename.at(idx_filename.size()-1) != DIR_SEP_CHR)
+		idx_filename += DIR_SEP_CHR;
+
+	// Hash the filename using CRC32 and Adler-32.
+	// The full filename is stored in the index file
+	// in order to detect collisions.
+	const Bytef *const buf = reinterpret_cast<const Bytef*>(filename.data());
+	const uInt len = static_cast<uInt>(filename.size());
+	const uint32_t crc = static_cast<uint32_t>(crc32(0, buf, len));
+	const uint32_t adler = static_cast<uint32_t>(adler32(1, buf, len));
+
+	char hash[32];
+	snprintf(hash, sizeof(hash), "%08X%08X.gzidx", crc, adler);
+	idx_filename += "gzidx";
+	idx_filename += DIR_SEP_CHR;
+	idx_filename += hash;
+	return idx_filename;
+}
+
+/**
+ * Load the access point index from a file.
+ *
+ * The index is only loaded if it was saved for the same
+ * file with the same compressed size and mtime.
+ *
+ * @param idx_filename	[in] Index filename.
+ * @param filename	[in] gzipped file.
+ * @param mtime		[in] Modification time of the gzipped file.
+ * @return 0 on success; negative POSIX error code on error.
+ */
+int GzReader::loadIndex(const string &idx_filename, const string &filename, time_t mtime)
+{
+	RP_D(GzReader);
+	unique_ptr<RpFile> file(new RpFile(idx_filename, RpFile::FM_OPEN_READ));
+	if (!file->isOpen()) {
+		return -file->lastError();
+	}
+
+	GzIdxHeader header;
+	if (file->read(&header, sizeof(header)) != sizeof(header)) {
+		return -EIO;
+	}
+	GzIndex *const index = d->index.get();
+	if (memcmp(header.magic, GZIDX_MAGIC, sizeof(header.magic)) != 0 ||
+	    le32_to_cpu(header.version) != GZIDX_VERSION ||
+	    static_cast<int64_t>(le64_to_cpu(header.comp_size)) != index->comp_size ||
+	    static_cast<int64_t>(le64_to_cpu(header.mtime)) != static_cast<int64_t>(mtime) ||
+	    le32_to_cpu(header.filename_len) != filename.size())
+	{
+		// Index is for a different file.
+		return -EINVAL;
+	}
+
+	// Verify the filename.
+	const unsigned int filename_len = le32_to_cpu(header.filename_len);
+	unique_ptr<char[]> idx_fn(new char[filename_len]);
+	if (file->read(idx_fn.get(), filename_len) != filename_len ||
+	    memcmp(idx_fn.get(), filename.data(), filename_len) != 0)
+	{
+		return -EINVAL;
+	}
+
+	// Validate the index parameters.
+	// The index file may be corrupted or truncated, so
+	// nothing is allocated based on these values.
+	const unsigned int count = le32_to_cpu(header.count);
+	const int64_t span = le64_to_cpu(header.span);
+	const int64_t indexed_out = le64_to_cpu(header.indexed_out);
+
+	// Maximum uncompressed size. The gzip trailer only has the
+	// low 32 bits of the size, so it's only used if the file
+	// can't be 4 GB or larger when decompressed.
+	int64_t max_out = index->comp_size * GZ_MAX_RATIO;
+	if (max_out < (1LL << 32)) {
+		max_out = std::min(max_out, index->uncomp_size);
+	}
+
+	// Access points are at least span bytes apart, so the
+	// compressed data between them is at least span / GZ_MAX_RATIO.
+	const int64_t idx_remain = file->size() - static_cast<int64_t>(sizeof(header) + filename_len);
+	if (span < GZ_MIN_SPAN || indexed_out < 0 || indexed_out > max_out ||
+	    count > static_cast<uint64_t>(index->comp_size / (GZ_MIN_SPAN / GZ_MAX_RATIO)) + 1 ||
+	    static_cast<int64_t>(count) * static_cast<int64_t>(sizeof(GzIdxPoint)) > idx_remain)
+	{
+		// Invalid index.
+		return -EINVAL;
+	}
+
+	// Load the access points.
+	vector<shared_ptr<GzAccessPoint> > points;
+	int64_t prev_out = -1;
+	int64_t prev_in = 0;
+	for (unsigned int i = 0; i < count; i++) {
+		GzIdxPoint idxPoint;
+		if (file->read(&idxPoint, sizeof(idxPoint)) != sizeof(idxPoint)) {
+			return -EIO;
+		}
+
+		shared_ptr<GzAccessPoint> point = std::make_shared<GzAccessPoint>();
+		point->out = le64_to_cpu(idxPoint.out);
+		point->in = le64_to_cpu(idxPoint.in);
+		point->bits = idxPoint.bits;
+		point->prev_byte = idxPoint.prev_byte;
+		point->win_size = le32_to_cpu(idxPoint.win_size);
+		if (point->out <= prev_out || point->out > indexed_out ||
+		    point->bits > 7 || point->in < prev_in ||
+		    point->in > index->comp_size || point->win_size > GZ_WINSIZE)
+		{
+			// Invalid access point.
+			return -EINVAL;
+		}
+		if (file->read(point->window, point->win_size) != point->win_size) {
+			return -EIO;
+		}
+		prev_out = point->out;
+		prev_in = point->in;
+		points.push_back(point);
+	}
+
+	// Index loaded.
+	MutexLocker locker(index->mutex);
+	index->span = span;
+	index->indexed_out = indexed_out;
+	index->points.swap(points);
+	index->dirty = false;
+	return 0;
+}
+
+/**
+ * Save the access point index to a file.
+ * @param idx_filename	[in] Index filename.
+ * @param filename	[in] gzipped file.
+ * @param mtime		[in] Modification time of the gzipped file.
+ * @return 0 on success; negative POSIX error code on error.
+ */
+int GzReader::saveIndex(const string &idx_filename, const string &filename, time_t mtime)
+{
+	RP_D(GzReader);
+	GzIndex *const index = d->index.get();
+	MutexLocker locker(index->mutex);
+
+	// Make sure the cache directory exists.
+	int ret = FileSystem::rmkdir(idx_filename);
+	if (ret != 0) {
+		return ret;
+	}
+
+	unique_ptr<RpFile> file(new RpFile(idx_filename, RpFile::FM_CREATE_WRITE));
+	if (!file->isOpen()) {
+		return -file->lastError();
+	}
+
+	GzIdxHeader header;
+	memcpy(header.magic, GZIDX_MAGIC, sizeof(header.magic));
+	header.version = cpu_to_le32(GZIDX_VERSION);
+	header.count = cpu_to_le32(static_cast<uint32_t>(index->points.size()));
+	header.comp_size = cpu_to_le64(index->comp_size);
+	header.mtime = cpu_to_le64(static_cast<int64_t>(mtime));
+	header.span = cpu_to_le64(index->span);
+	header.indexed_out = cpu_to_le64(index->indexed_out);
+	header.filename_len = cpu_to_le32(static_cast<uint32_t>(filename.size()));
+	bool ok = (file->write(&header, sizeof(header)) == sizeof(header));
+	ok = ok && (file->write(filename.data(), filename.size()) == filename.size());
+
+	for (auto iter = index->points.cbegin(); ok && iter != index->points.cend(); ++iter) {
+		const GzAccessPoint *const point = iter->get();
+		GzIdxPoint idxPoint;
+		idxPoint.out = cpu_to_le64(point->out);
+		idxPoint.in = cpu_to_le64(point->in);
+		idxPoint.bits = point->bits;
+		idxPoint.prev_byte = point->prev_byte;
+		idxPoint.reserved = 0;
+		idxPoint.win_size = cpu_to_le32(point->win_size);
+		ok = (file->write(&idxPoint, sizeof(idxPoint)) == sizeof(idxPoint)) &&
+		     (file->write(point->window, point->win_size) == point->win_size);
+	}
+
+	if (!ok) {
+		// Write error. Delete the incomplete index file.
+		file.reset();
+		FileSystem::delete_file(idx_filename);
+		return -EIO;
+	}
+
+	index->dirty = false;
+	return 0;
+}
+
+}
@@ -0,0 +1,159 @@
+/***************************************************************************
+ * ROM Properties Page shell extension. (librpbase)                        *
+ * GzReader.hpp: Seekable gzip reader using an access point index.         *
+ *                                                                         *
+ * Copyright (c) 2016-2018 by David Korth.                                 *
+ *                                                                         *
+ * This program is free software; you can redistribute it and/or modify it *
+ * under the terms of the GNU General Public License as published by the   *
+ * Free Software Foundation; either version 2 of the License, or (at your  *
+ * option) any later version.                                              *
+ *                                                                         *
+ * This program is distributed in the hope that it will be useful, but     *
+ * WITHOUT ANY WARRANTY; without even the implied warranty of              *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the           *
+ * GNU General Public License for more details.                            *
+ *                                                                         *
+ * You should have received a copy of the GNU General Public License       *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.   *
+ ***************************************************************************/
+
+#ifndef __ROMPROPERTIES_LIBRPBASE_FILE_GZREADER_HPP__
+#define __ROMPROPERTIES_LIBRPBASE_FILE_GZREADER_HPP__
+
+#include "IDecompReader.hpp"
+
+namespace LibRpBase {
+
+/**
+ * Seekable gzip reader.
+ *
+ * Decompressed data is read using an access point index,
+ * similar to zlib's zran.c example. An access point is
+ * recorded at a deflate block boundary every "span" bytes
+ * of uncompressed data while the file is being read, so a
+ * seek to any previously-read area only needs to inflate
+ * at most one span of data.
+ *
+ * The access point index is shared between copies of the
+ * same GzReader, and it can be saved to and loaded from
+ * an index file.
+ *
+ * NOTE: GzReader itself is NOT thread-safe.
+ */
+class GzReaderPrivate;
+class GzReader : public IDecompReader
+{
+	public:
+		/**
+		 * Create a seekable gzip reader.
+		 * @param readFunc	[in] Read function for compressed data.
+		 * @param opaque	[in] Opaque pointer for readFunc.
+		 * @param comp_size	[in] Compressed file size.
+		 * @param uncomp_size	[in] Uncompressed file size. (from the gzip trailer)
+		 */
+		GzReader(ReadFunc readFunc, void *opaque, int64_t comp_size, int64_t uncomp_size);
+
+		/**
+		 * Create a seekable gzip reader that shares
+		 * another reader's access point index.
+		 * @param other		[in] Other GzReader.
+		 * @param readFunc	[in] Read function for compressed data.
+		 * @param opaque	[in] Opaque pointer for readFunc.
+		 */
+		GzReader(const GzReader &other, ReadFunc readFunc, void *opaque);
+
+		~GzReader();
+
+	private:
+		typedef IDecompReader super;
+		RP_DISABLE_COPY(GzReader)
+	protected:
+		friend class GzReaderPrivate;
+		GzReaderPrivate *const d_ptr;
+
+	public:
+		/**
+		 * Get the compression format.
+		 * @return Compression format.
+		 */
+		Format format(void) const final
+		{
+			return FMT_GZIP;
+		}
+
+		/**
+		 * Create a new reader for the same compressed file.
+		 * The access point index is shared with this reader.
+		 * @param readFunc	[in] Read function for compressed data.
+		 * @param opaque	[in] Opaque pointer for readFunc.
+		 * @return New reader.
+		 */
+		IDecompReader *dup(ReadFunc readFunc, void *opaque) const final;
+
+		/**
+		 * Read uncompressed data.
+		 * @param pos	[in] Uncompressed starting address.
+		 * @param ptr	[out] Output data buffer.
+		 * @param size	[in] Amount of data to read, in bytes.
+		 * @return Number of bytes read.
+		 */
+		size_t read(int64_t pos, void *ptr, size_t size) final;
+
+		/**
+		 * Get the uncompressed size.
+		 * NOTE: This is the size from the gzip trailer,
+		 * which is only accurate for files under 4 GB.
+		 * @return Uncompressed size.
+		 */
+		int64_t size(void) final;
+
+		/**
+		 * Get the number of access points in the index.
+		 * @return Number of access points.
+		 */
+		unsigned int accessPointCount(void) const;
+
+		/**
+		 * Has the index changed since it was created or loaded?
+		 * @return True if the index has new access points.
+		 */
+		bool isIndexDirty(void) const final;
+
+	public:
+		/** Index files. **/
+
+		/**
+		 * Get the index filename for a gzipped file.
+		 * Index files are stored in the cache directory.
+		 * @param filename	[in] gzipped file.
+		 * @return Index filename, or empty string on error.
+		 */
+		static std::string indexFilename(const std::string &filename);
+
+		/**
+		 * Load the access point index from a file.
+		 *
+		 * The index is only loaded if it was saved for the same
+		 * file with the same compressed size and mtime.
+		 *
+		 * @param idx_filename	[in] Index filename.
+		 * @param filename	[in] gzipped file.
+		 * @param mtime		[in] Modification time of the gzipped file.
+		 * @return 0 on success; negative POSIX error code on error.
+		 */
+		int loadIndex(const std::string &idx_filename, const std::string &filename, time_t mtime) final;
+
+		/**
+		 * Save the access point index to a file.
+		 * @param idx_filename	[in] Index filename.
+		 * @param filename	[in] gzipped file.
+		 * @param mtime		[in] Modification time of the gzipped file.
+		 * @return 0 on success; negative POSIX error code on error.
+		 */
+		int saveIndex(const std::string &idx_filename, const std::string &filename, time_t mtime) final;
+};
+
+}
+
+#endif /* __ROMPROPERTIES_LIBRPBASE_FILE_GZREADER_HPP__ */
@@ -0,0 +1,194 @@
+/***************************************************************************
+ * ROM Properties Page shell extension. (librpbase)                        *
+ * IDecompReader.cpp: Seekable decompression reader interface.             *
+ *                                                                         *
+ * Copyright (c) 2016-2018 by David Korth.                                 *
+ *                                                                         *
+ * This program is free software; you can redistribute it and/or modify it *
+ * under the terms of the GNU General Public License as published by the   *
+ * Free Software Foundation; either version 2 of the License, or (at your  *
+ * option) any later version.                                              *
+ *                                                                         *
+ * This program is distributed in the hope that it will be useful, but     *
+ * WITHOUT ANY WARRANTY; without even the implied warranty of              *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the           *
+ * GNU General Public License for more details.                            *
+ *                                                                         *
+ * You should have received a copy of the GNU General Public License       *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.   *
+ ***************************************************************************/
+
+#include "librpbase/config.librpbase.h"
+#include "IDecompReader.hpp"
+
+// librpbase
+#include "byteswap.h"
+
+// Decompression readers.
+#include "GzReader.hpp"
+#ifdef HAVE_LZMA
+# include "XzReader.hpp"
+#endif
+#ifdef HAVE_BZIP2
+# include "Bz2Reader.hpp"
+#endif
+#ifdef HAVE_ZSTD
+# include "ZstdReader.hpp"
+#endif
+
+// C includes. (C++ namespace)
+#include <cerrno>
+#include <cstring>
+
+// C++ includes.
+#include <string>
+using std::string;
+
+namespace LibRpBase {
+
+/**
+ * Detect the compression format from a file's magic number.
+ *
+ * Formats whose decompression library wasn't
+ * available at compile time are not detected.
+ *
+ * @param pHeader	[in] First few bytes of the file.
+ * @param size		[in] Size of pHeader. (should be at least 6)
+ * @return Compression format, or -1 if the data isn't compressed or isn't supported.
+ */
+int IDecompReader::detectFormat(const uint8_t *pHeader, size_t size)
+{
+	if (size < 2) {
+		return -1;
+	}
+
+	if (pHeader[0] == 0x1F && pHeader[1] == 0x8B) {
+		// gzip
+		// Reference: https://www.forensicswiki.org/wiki/Gzip
+		return FMT_GZIP;
+	}
+#ifdef HAVE_LZMA
+	if (size >= 6 && !memcmp(pHeader, "\xFD" "7zXZ\x00", 6)) {
+		// xz
+		return FMT_XZ;
+	}
+#endif /* HAVE_LZMA */
+#ifdef HAVE_BZIP2
+	if (size >= 4 && pHeader[0] == 'B' && pHeader[1] == 'Z' && pHeader[2] == 'h' &&
+	    pHeader[3] >= '1' && pHeader[3] <= '9')
+	{
+		// bzip2
+		return FMT_BZIP2;
+	}
+#endif /* HAVE_BZIP2 */
+#ifdef HAVE_ZSTD
+	if (size >= 4 && pHeader[0] == 0x28 && pHeader[1] == 0xB5 &&
+	    pHeader[2] == 0x2F && pHeader[3] == 0xFD)
+	{
+		// zstd
+		return FMT_ZSTD;
+	}
+#endif /* HAVE_ZSTD */
+
+	// Not compressed, or not supported.
+	return -1;
+}
+
+/**
+ * Create a decompression reader for a compressed file.
+ *
+ * The compression format is detected using the file's
+ * magic number. Formats whose decompression library
+ * wasn't available at compile time are not detected.
+ *
+ * @param readFunc	[in] Read function for compressed data.
+ * @param opaque	[in] Opaque pointer for readFunc.
+ * @param comp_size	[in] Compressed file size.
+ * @return Decompression reader, or nullptr if the file isn't compressed or isn't supported.
+ */
+IDecompReader *IDecompReader::create(ReadFunc readFunc, void *opaque, int64_t comp_size)
+{
+	uint8_t magic[6];
+	if (comp_size < static_cast<int64_t>(sizeof(magic)) ||
+	    readFunc(opaque, 0, magic, sizeof(magic)) != sizeof(magic))
+	{
+		// Too small to be a compressed file.
+		return nullptr;
+	}
+
+	IDecompReader *reader = nullptr;
+	switch (detectFormat(magic, sizeof(magic))) {
+		case FMT_GZIP: {
+			// Get the uncompressed size at the end of the file.
+			uint32_t uncomp_sz;
+			if (comp_size > 10+8 &&
+			    readFunc(opaque, comp_size-4, &uncomp_sz, sizeof(uncomp_sz)) == sizeof(uncomp_sz))
+			{
+				uncomp_sz = le32_to_cpu(uncomp_sz);
+				if (uncomp_sz >= comp_size-(10+8)) {
+					// Uncompressed size looks valid.
+					reader = new GzReader(readFunc, opaque, comp_size, uncomp_sz);
+				}
+			}
+			break;
+		}
+#ifdef HAVE_LZMA
+		case FMT_XZ:
+			reader = new XzReader(readFunc, opaque, comp_size);
+			break;
+#endif /* HAVE_LZMA */
+#ifdef HAVE_BZIP2
+		case FMT_BZIP2:
+			reader = new Bz2Reader(readFunc, opaque, comp_size);
+			break;
+#endif /* HAVE_BZIP2 */
+#ifdef HAVE_ZSTD
+		case FMT_ZSTD:
+			reader = new ZstdReader(readFunc, opaque, comp_size);
+			break;
+#endif /* HAVE_ZSTD */
+		default:
+			break;
+	}
+
+	if (reader && !reader->isOpen()) {
+		// Invalid compressed file.
+		delete reader;
+		reader = nullptr;
+	}
+	return reader;
+}
+
+/**
+ * Load the seek index from a file.
+ * @param idx_filename	[in] Index filename.
+ * @param filename	[in] Compressed file.
+ * @param mtime		[in] Modification time of the compressed file.
+ * @return 0 on success; negative POSIX error code on error.
+ */
+int IDecompReader::loadIndex(const string &idx_filename, const string &filename, time_t mtime)
+{
+	// Not supported by default.
+	RP_UNUSED(idx_filename);
+	RP_UNUSED(filename);
+	RP_UNUSED(mtime);
+	return -ENOTSUP;
+}
+
+/**
+ * Save the seek index to a file.
+ * @param idx_filename	[in] Index filename.
+ * @param filename	[in] Compressed file.
+ * @param mtime		[in] Modification time of the compressed file.
+ * @return 0 on success; negative POSIX error code on error.
+ */
+int IDecompReader::saveIndex(const string &idx_filename, const string &filename, time_t mtime)
+{
+	// Not supported by default.
+	RP_UNUSED(idx_filename);
+	RP_UNUSED(filename);
+	RP_UNUSED(mtime);
+	return -ENOTSUP;
+}
+
+}
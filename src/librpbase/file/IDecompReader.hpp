@@ -0,0 +1,220 @@
+/***************************************************************************
+ * ROM Properties Page shell extension. (librpbase)                        *
+ * IDecompReader.hpp: Seekable decompression reader interface.             *
+ *                                                                         *
+ * Copyright (c) 2016-2018 by David Korth.                                 *
+ *                                                                         *
+ * This program is free software; you can redistribute it and/or modify it *
+ * under the terms of the GNU General Public License as published by the   *
+ * Free Software Foundation; either version 2 of the License, or (at your  *
+ * option) any later version.                                              *
+ *                                                                         *
+ * This program is distributed in the hope that it will be useful, but     *
+ * WITHOUT ANY WARRANTY; without even the implied warranty of              *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the           *
+ * GNU General Public License for more details.                            *
+ *                                                                         *
+ * You should have received a copy of the GNU General Public License       *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.   *
+ ***************************************************************************/
+
+#ifndef __ROMPROPERTIES_LIBRPBASE_FILE_IDECOMPREADER_HPP__
+#define __ROMPROPERTIES_LIBRPBASE_FILE_IDECOMPREADER_HPP__
+
+#include "librpbase/common.h"
+
+// C includes.
+#include <stdint.h>
+#include <time.h>
+
+// C includes. (C++ namespace)
+#include <cstddef>
+
+// C++ includes.
+#include <string>
+
+namespace LibRpBase {
+
+/**
+ * Seekable decompression reader interface.
+ *
+ * Decompression readers provide random access to the
+ * uncompressed data of a compressed file. Compressed
+ * data is read using a read function, so the reader
+ * doesn't need to know how the file is accessed.
+ *
+ * NOTE: Decompression readers are NOT thread-safe.
+ * Use dup() to get a reader for another thread.
+ */
+class IDecompReader
+{
+	public:
+		/**
+		 * Read function for compressed data.
+		 * @param opaque	[in] Opaque pointer.
+		 * @param pos		[in] Starting address.
+		 * @param ptr		[out] Output data buffer.
+		 * @param size		[in] Amount of data to read, in bytes.
+		 * @return Number of bytes read.
+		 */
+		typedef size_t (*ReadFunc)(void *opaque, int64_t pos, void *ptr, size_t size);
+
+		/**
+		 * Compression format.
+		 */
+		enum Format {
+			FMT_GZIP	= 0,	// gzip (zlib)
+			FMT_XZ		= 1,	// xz (liblzma)
+			FMT_BZIP2	= 2,	// bzip2 (libbz2)
+			FMT_ZSTD	= 3,	// Zstandard (libzstd)
+		};
+
+	protected:
+		IDecompReader() : m_lastError(0) { }
+	public:
+		virtual ~IDecompReader() { }
+
+	private:
+		RP_DISABLE_COPY(IDecompReader)
+
+	public:
+		/**
+		 * Detect the compression format from a file's magic number.
+		 *
+		 * Formats whose decompression library wasn't
+		 * available at compile time are not detected.
+		 *
+		 * @param pHeader	[in] First few bytes of the file.
+		 * @param size		[in] Size of pHeader. (should be at least 6)
+		 * @return Compression format, or -1 if the data isn't compressed or isn't supported.
+		 */
+		static int detectFormat(const uint8_t *pHeader, size_t size);
+
+		/**
+		 * Create a decompression reader for a compressed file.
+		 *
+		 * The compression format is detected using the file's
+		 * magic number. Formats whose decompression library
+		 * wasn't available at compile time are not detected.
+		 *
+		 * @param readFunc	[in] Read function for compressed data.
+		 * @param opaque	[in] Opaque pointer for readFunc.
+		 * @param comp_size	[in] Compressed file size.
+		 * @return Decompression reader, or nullptr if the file isn't compressed or isn't supported.
+		 */
+		static IDecompReader *create(ReadFunc readFunc, void *opaque, int64_t comp_size);
+
+	public:
+		/**
+		 * Is the reader open?
+		 * This usually only returns false if the
+		 * compressed file's headers are invalid.
+		 * @return True if the reader is open; false if it isn't.
+		 */
+		virtual bool isOpen(void) const
+		{
+			return true;
+		}
+
+		/**
+		 * Get the compression format.
+		 * @return Compression format.
+		 */
+		virtual Format format(void) const = 0;
+
+		/**
+		 * Create a new reader for the same compressed file.
+		 *
+		 * The new reader has its own decompression state,
+		 * but any seek index is shared with this reader.
+		 *
+		 * @param readFunc	[in] Read function for compressed data.
+		 * @param opaque	[in] Opaque pointer for readFunc.
+		 * @return New reader.
+		 */
+		virtual IDecompReader *dup(ReadFunc readFunc, void *opaque) const = 0;
+
+		/**
+		 * Read uncompressed data.
+		 * @param pos	[in] Uncompressed starting address.
+		 * @param ptr	[out] Output data buffer.
+		 * @param size	[in] Amount of data to read, in bytes.
+		 * @return Number of bytes read.
+		 */
+		virtual size_t read(int64_t pos, void *ptr, size_t size) = 0;
+
+		/**
+		 * Get the uncompressed size.
+		 *
+		 * For formats that don't store the uncompressed size,
+		 * this may require decompressing the entire file.
+		 *
+		 * @return Uncompressed size, or negative on error.
+		 */
+		virtual int64_t size(void) = 0;
+
+		/**
+		 * Get the uncompressed size, decompressing
+		 * at most max_size bytes to determine it.
+		 *
+		 * This is used for file type detection, where an exact
+		 * size isn't needed for files larger than max_size.
+		 *
+		 * @param max_size	[in] Maximum amount of data to decompress.
+		 * @return Uncompressed size if it's known or if it's <= max_size; otherwise, a lower bound larger than max_size. Negative on error.
+		 */
+		virtual int64_t sizeUpTo(int64_t max_size)
+		{
+			// Default implementation for formats
+			// that store the uncompressed size.
+			RP_UNUSED(max_size);
+			return size();
+		}
+
+		/**
+		 * Get the last error.
+		 * @return Last POSIX error, or 0 if no error.
+		 */
+		inline int lastError(void) const
+		{
+			return m_lastError;
+		}
+
+	public:
+		/** Index files. **/
+
+		/**
+		 * Has the seek index changed since it was created or loaded?
+		 * Only formats that build their own seek index support this.
+		 * @return True if the index should be saved.
+		 */
+		virtual bool isIndexDirty(void) const
+		{
+			return false;
+		}
+
+		/**
+		 * Load the seek index from a file.
+		 * @param idx_filename	[in] Index filename.
+		 * @param filename	[in] Compressed file.
+		 * @param mtime		[in] Modification time of the compressed file.
+		 * @return 0 on success; negative POSIX error code on error.
+		 */
+		virtual int loadIndex(const std::string &idx_filename, const std::string &filename, time_t mtime);
+
+		/**
+		 * Save the seek index to a file.
+		 * @param idx_filename	[in] Index filename.
+		 * @param filename	[in] Compressed file.
+		 * @param mtime		[in] Modification time of the compressed file.
+		 * @return 0 on success; negative POSIX error code on error.
+		 */
+		virtual int saveIndex(const std::string &idx_filename, const std::string &filename, time_t mtime);
+
+	protected:
+		int m_lastError;
+};
+
+}
+
+#endif /* __ROMPROPERTIES_LIBRPBASE_FILE_IDECOMPREADER_HPP__ */
@@ -23,6 +23,11 @@
 
 // C includes. (C++ namespace)
 #include <cstdio>
+#include <cstring>
+
+// C++ includes.
+#include <vector>
+using std::vector;
 
 namespace LibRpBase {
 
@@ -99,4 +104,95 @@ size_t IRpFile::seekAndRead(int64_t pos, void *ptr, size_t size)
 	return this->read(ptr, size);
 }
 
+/**
+ * Read data from the file at the specified address.
+ *
+ * The file position is not changed, and multiple threads
+ * may call pread() on the same object concurrently.
+ * (Mixing pread() with seek() and read() on other threads
+ * is NOT thread-safe.)
+ *
+ * The default implementation serializes calls with a mutex.
+ * Subclasses should override this if they can read without
+ * using the file position.
+ *
+ * @param pos	[in] Starting address.
+ * @param ptr	[out] Output data buffer.
+ * @param size	[in] Amount of data to read, in bytes.
+ * @return Number of bytes read.
+ */
+size_t IRpFile::pread(int64_t pos, void *ptr, size_t size)
+{
+	MutexLocker locker(m_preadMutex);
+
+	// Save the file position so it can be restored afterwards.
+	const int64_t prev_pos = this->tell();
+	if (prev_pos < 0) {
+		// Unable to get the file position.
+		return 0;
+	}
+
+	size_t ret = this->seekAndRead(pos, ptr, size);
+	this->seek(prev_pos);
+	return ret;
+}
+
+/**
+ * Read multiple segments from the file.
+ *
+ * Segments are read in ascending address order, and
+ * contiguous segments are merged where possible, so
+ * this is more efficient than calling seekAndRead()
+ * for each segment. Subclasses may override this to
+ * issue a single system call for all segments.
+ *
+ * NOTE: The file position is unspecified afterwards.
+ *
+ * @param segs	[in] Read segments.
+ * @param count	[in] Number of segments.
+ * @return Number of segments that were read completely.
+ */
+unsigned int IRpFile::readBatch(const ReadSegment *segs, unsigned int count)
+{
+	const vector<const ReadSegment*> order = sortReadSegments(segs, count);
+
+	unsigned int ret = 0;
+	int64_t cur_pos = -1;
+	for (auto iter = order.cbegin(); iter != order.cend(); ++iter) {
+		const ReadSegment *const seg = *iter;
+		if (seg->size == 0) {
+			// Nothing to read.
+			ret++;
+			continue;
+		}
+
+		// Memory-backed files don't need to copy through read().
+		const void *const src = this->borrow(seg->pos, seg->size);
+		if (src) {
+			memcpy(seg->ptr, src, seg->size);
+			ret++;
+			continue;
+		}
+
+		// If this segment directly follows the previous one,
+		// the file position is already correct.
+		size_t size;
+		if (seg->pos == cur_pos) {
+			size = this->read(seg->ptr, seg->size);
+		} else {
+			size = this->seekAndRead(seg->pos, seg->ptr, seg->size);
+		}
+
+		if (size == seg->size) {
+			ret++;
+			cur_pos = seg->pos + static_cast<int64_t>(size);
+		} else {
+			// Short read. Force a seek for the next segment.
+			cur_pos = -1;
+		}
+	}
+
+	return ret;
+}
+
 }
@@ -31,6 +31,12 @@
 
 // C++ includes.
 #include <string>
+#if !defined(_MSC_VER) || _MSC_VER >= 1700
+# include <atomic>
+#endif
+
+#include "ReadSegment.hpp"
+#include "../threads/Mutex.hpp"
 
 namespace LibRpBase {
 
@@ -134,12 +140,44 @@ class IRpFile
 		 */
 		virtual int64_t size(void) = 0;
 
+		/**
+		 * Get the file size, limiting the amount of work needed
+		 * to determine it.
+		 *
+		 * Some compressed formats don't store the uncompressed size,
+		 * so size() has to decompress the entire file. This function
+		 * stops decompressing once the file is larger than max_size.
+		 *
+		 * @param max_size Maximum amount of data to decompress.
+		 * @return File size if it's <= max_size or if it can be determined cheaply; otherwise, a lower bound larger than max_size. Negative on error.
+		 */
+		virtual int64_t sizeUpTo(int64_t max_size)
+		{
+			RP_UNUSED(max_size);
+			return size();
+		}
+
 		/**
 		 * Get the filename.
 		 * @return Filename. (May be empty if the filename is not available.)
 		 */
 		virtual std::string filename(void) const = 0;
 
+		/**
+		 * Get the transparent decompression format.
+		 *
+		 * If the file is being decompressed, the data returned by
+		 * read() is different from the data on disk, so anything
+		 * that caches results based on the on-disk file needs to
+		 * take this into account.
+		 *
+		 * @return IDecompReader::Format, or -1 if the file data is read as-is.
+		 */
+		virtual int decompFormat(void) const
+		{
+			return -1;
+		}
+
 	public:
 		/** Convenience functions implemented for all IRpFile classes. **/
 
@@ -170,8 +208,90 @@ class IRpFile
 		 */
 		size_t seekAndRead(int64_t pos, void *ptr, size_t size);
 
+		/**
+		 * Read data from the file at the specified address.
+		 *
+		 * The file position is not changed, and multiple threads
+		 * may call pread() on the same object concurrently.
+		 * (Mixing pread() with seek() and read() on other threads
+		 * is NOT thread-safe.)
+		 *
+		 * The default implementation serializes calls with a mutex.
+		 * Subclasses should override this if they can read without
+		 * using the file position.
+		 *
+		 * @param pos	[in] Starting address.
+		 * @param ptr	[out] Output data buffer.
+		 * @param size	[in] Amount of data to read, in bytes.
+		 * @return Number of bytes read.
+		 */
+		virtual size_t pread(int64_t pos, void *ptr, size_t size);
+
+		/**
+		 * Read multiple segments from the file.
+		 *
+		 * Segments are read in ascending address order, and
+		 * contiguous segments are merged where possible, so
+		 * this is more efficient than calling seekAndRead()
+		 * for each segment. Subclasses may override this to
+		 * issue a single system call for all segments.
+		 *
+		 * NOTE: The file position is unspecified afterwards.
+		 *
+		 * @param segs	[in] Read segments.
+		 * @param count	[in] Number of segments.
+		 * @return Number of segments that were read completely.
+		 */
+		virtual unsigned int readBatch(const ReadSegment *segs, unsigned int count);
+
+		/**
+		 * Hint that data will be read soon.
+		 *
+		 * The file may start reading the data in the background,
+		 * so a later read of this range doesn't have to wait for
+		 * the disk. This is only a hint; it doesn't read any data
+		 * into the caller's buffers and can't fail.
+		 *
+		 * The default implementation does nothing.
+		 *
+		 * @param pos	[in] Starting address.
+		 * @param size	[in] Amount of data, in bytes.
+		 */
+		virtual void prefetch(int64_t pos, size_t size)
+		{
+			RP_UNUSED(pos);
+			RP_UNUSED(size);
+		}
+
+		/**
+		 * Borrow a pointer to the file data without copying it.
+		 *
+		 * This is only supported by memory-backed files, e.g.
+		 * RpMemFile and RpMmapFile. The file position is not
+		 * changed. The returned pointer is valid until the
+		 * file is closed or deleted.
+		 *
+		 * @param pos	[in] Starting address.
+		 * @param size	[in] Amount of data, in bytes.
+		 * @return Pointer to the data, or nullptr if not supported or out of range.
+		 */
+		virtual const void *borrow(int64_t pos, size_t size)
+		{
+			RP_UNUSED(pos);
+			RP_UNUSED(size);
+			return nullptr;
+		}
+
 	protected:
-		int m_lastError;
+		// Last error. pread() may set this from multiple threads.
+#if defined(_MSC_VER) && _MSC_VER < 1700
+		// MSVC 2010 doesn't have <atomic>, but volatile
+		// has acquire/release semantics on MSVC.
+		volatile int m_lastError;
+#else
+		std::atomic<int> m_lastError;
+#endif
+		Mutex m_preadMutex;	// Serializes the default pread().
 };
 
 }
@@ -0,0 +1,70 @@
+/***************************************************************************
+ * ROM Properties Page shell extension. (librpbase)                        *
+ * ReadSegment.hpp: Segment descriptor for batched reads.                  *
+ *                                                                         *
+ * Copyright (c) 2016-2018 by David Korth.                                 *
+ *                                                                         *
+ * This program is free software; you can redistribute it and/or modify it *
+ * under the terms of the GNU General Public License as published by the   *
+ * Free Software Foundation; either version 2 of the License, or (at your  *
+ * option) any later version.                                              *
+ *                                                                         *
+ * This program is distributed in the hope that it will be useful, but     *
+ * WITHOUT ANY WARRANTY; without even the implied warranty of              *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the           *
+ * GNU General Public License for more details.                            *
+ *                                                                         *
+ * You should have received a copy of the GNU General Public License       *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.   *
+ ***************************************************************************/
+
+#ifndef __ROMPROPERTIES_LIBRPBASE_FILE_READSEGMENT_HPP__
+#define __ROMPROPERTIES_LIBRPBASE_FILE_READSEGMENT_HPP__
+
+// C includes.
+#include <stdint.h>
+
+// C includes. (C++ namespace)
+#include <cstddef>	/* for size_t */
+
+// C++ includes.
+#include <algorithm>
+#include <vector>
+
+namespace LibRpBase {
+
+/**
+ * Segment descriptor for IRpFile::readBatch()
+ * and IDiscReader::readBatch().
+ */
+struct ReadSegment {
+	int64_t pos;	// Starting address.
+	void *ptr;	// Output data buffer.
+	size_t size;	// Amount of data to read, in bytes.
+};
+
+/**
+ * Sort read segments by starting address.
+ * The original array is not modified.
+ * @param segs	[in] Read segments.
+ * @param count	[in] Number of segments.
+ * @return Pointers to the segments, in ascending address order.
+ */
+static inline std::vector<const ReadSegment*> sortReadSegments(const ReadSegment *segs, unsigned int count)
+{
+	std::vector<const ReadSegment*> order;
+	order.reserve(count);
+	for (unsigned int i = 0; i < count; i++) {
+		order.push_back(&segs[i]);
+	}
+	std::stable_sort(order.begin(), order.end(),
+		[](const ReadSegment *a, const ReadSegment *b) {
+			return (a->pos < b->pos);
+		}
+	);
+	return order;
+}
+
+}
+
+#endif /* __ROMPROPERTIES_LIBRPBASE_FILE_READSEGMENT_HPP__ */
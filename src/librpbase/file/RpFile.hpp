@@ -51,7 +51,7 @@ class RpFile : public IRpFile
 			FM_MODE_MASK = 3,	// Mode mask.
 
 			// Extras.
-			FM_GZIP_DECOMPRESS = 4,	// Transparent gzip decompression. (read-only!)
+			FM_GZIP_DECOMPRESS = 4,	// Transparent gzip/xz/bzip2/zstd decompression. (read-only!)
 			FM_OPEN_READ_GZ = FM_READ | FM_GZIP_DECOMPRESS,
 		};
 
@@ -139,6 +139,54 @@ class RpFile : public IRpFile
 		 */
 		int truncate(int64_t size = 0) final;
 
+#ifndef _WIN32
+		// NOTE: On Windows, the default IRpFile implementations
+		// of pread(), readBatch(), and prefetch() are used.
+		// ReadFile() with an OVERLAPPED offset updates the shared
+		// file pointer on synchronous handles, so positional reads
+		// have to be serialized with seek() and read().
+
+		/**
+		 * Read data from the file at the specified address.
+		 * The file position is not changed.
+		 *
+		 * This function is thread-safe. Regular files are read
+		 * using pread(), which doesn't use the shared file position.
+		 * Reads from compressed files are serialized.
+		 *
+		 * @param pos	[in] Starting address.
+		 * @param ptr	[out] Output data buffer.
+		 * @param size	[in] Amount of data to read, in bytes.
+		 * @return Number of bytes read.
+		 */
+		size_t pread(int64_t pos, void *ptr, size_t size) final;
+
+		/**
+		 * Read multiple segments from the file.
+		 *
+		 * If the file isn't compressed, contiguous segments are
+		 * merged and read using preadv() where available.
+		 *
+		 * NOTE: The file position is unspecified afterwards.
+		 *
+		 * @param segs	[in] Read segments.
+		 * @param count	[in] Number of segments.
+		 * @return Number of segments that were read completely.
+		 */
+		unsigned int readBatch(const ReadSegment *segs, unsigned int count) final;
+
+		/**
+		 * Hint that data will be read soon.
+		 *
+		 * Regular files use posix_fadvise() where available.
+		 * Compressed files are not prefetched.
+		 *
+		 * @param pos	[in] Starting address.
+		 * @param size	[in] Amount of data, in bytes.
+		 */
+		void prefetch(int64_t pos, size_t size) final;
+#endif /* !_WIN32 */
+
 	public:
 		/** File properties. **/
 
@@ -148,11 +196,25 @@ class RpFile : public IRpFile
 		 */
 		int64_t size(void) final;
 
+		/**
+		 * Get the file size, limiting the amount of work needed
+		 * to determine it.
+		 * @param max_size Maximum amount of data to decompress.
+		 * @return File size if it's <= max_size or if it can be determined cheaply; otherwise, a lower bound larger than max_size. Negative on error.
+		 */
+		int64_t sizeUpTo(int64_t max_size) final;
+
 		/**
 		 * Get the filename.
 		 * @return Filename. (May be empty if the filename is not available.)
 		 */
 		std::string filename(void) const final;
+
+		/**
+		 * Get the transparent decompression format.
+		 * @return IDecompReader::Format, or -1 if the file data is read as-is.
+		 */
+		int decompFormat(void) const final;
 };
 
 }
@@ -18,11 +18,15 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.   *
  ***************************************************************************/
 
+#include "librpbase/config.librpbase.h"
 #include "RpFile.hpp"
 
 // librpbase
 #include "byteswap.h"
 #include "TextFuncs.hpp"
+#include "FileSystem.hpp"
+#include "IDecompReader.hpp"
+#include "GzReader.hpp"
 
 // C includes. (C++ namespace)
 #include <cerrno>
@@ -30,21 +34,11 @@
 // C++ includes.
 #include <string>
 #include <memory>
+#include <vector>
 using std::shared_ptr;
 using std::string;
 using std::u16string;
-
-// zlib for transparent gzip decompression.
-#include <zlib.h>
-// gzclose_r() and gzclose_w() were introduced in zlib-1.2.4.
-#if (ZLIB_VER_MAJOR > 1) || \
-    (ZLIB_VER_MAJOR == 1 && ZLIB_VER_MINOR > 2) || \
-    (ZLIB_VER_MAJOR == 1 && ZLIB_VER_MINOR == 2 && ZLIB_VER_REVISION >= 4)
-// zlib-1.2.4 or later
-#else
-# define gzclose_r(file) gzclose(file)
-# define gzclose_w(file) gzclose(file)
-#endif
+using std::vector;
 
 #ifdef _WIN32
 // Windows: _wfopen() requires a Unicode mode string.
@@ -66,6 +60,20 @@ typedef char mode_str_t;
 #include <unistd.h>
 #endif
 
+#ifdef HAVE_PREADV
+// preadv()
+# include <sys/uio.h>
+# include <climits>
+# ifndef IOV_MAX
+#  define IOV_MAX 16
+# endif
+#endif /* HAVE_PREADV */
+
+#ifdef HAVE_POSIX_FADVISE
+// posix_fadvise()
+# include <fcntl.h>
+#endif /* HAVE_POSIX_FADVISE */
+
 namespace LibRpBase {
 
 // Deleter for std::unique_ptr<FILE> d->file.
@@ -83,9 +91,11 @@ class RpFilePrivate
 {
 	public:
 		RpFilePrivate(RpFile *q, const char *filename, RpFile::FileMode mode)
-			: q_ptr(q), filename(filename), mode(mode), gzfd(nullptr), gzsz(-1) { }
+			: q_ptr(q), filename(filename), mode(mode)
+			, decomp(nullptr), decomp_pos(0), idx_mtime(0) { }
 		RpFilePrivate(RpFile *q, const string &filename, RpFile::FileMode mode)
-			: q_ptr(q), filename(filename), mode(mode), gzfd(nullptr), gzsz(-1) { }
+			: q_ptr(q), filename(filename), mode(mode)
+			, decomp(nullptr), decomp_pos(0), idx_mtime(0) { }
 		~RpFilePrivate();
 
 	private:
@@ -97,8 +107,10 @@ class RpFilePrivate
 		string filename;	// Filename.
 		RpFile::FileMode mode;	// File mode.
 
-		gzFile gzfd;			// Used for transparent gzip decompression.
-		int64_t gzsz;			// Uncompressed file size.
+		// Transparent decompression.
+		IDecompReader *decomp;		// Seekable decompression reader.
+		int64_t decomp_pos;		// Uncompressed file position.
+		time_t idx_mtime;		// Modification time. (for the index file)
 
 	public:
 		/**
@@ -111,20 +123,46 @@ class RpFilePrivate
 		/**
 		 * (Re-)Open the main file.
 		 *
-		 * INTERNAL FUNCTION. This does NOT affect gzfd.
+		 * INTERNAL FUNCTION. This does NOT affect decomp.
 		 * NOTE: This function sets q->m_lastError.
 		 *
 		 * Uses parameters stored in this->filename and this->mode.
 		 * @return 0 on success; non-zero on error.
 		 */
 		int reOpenFile(void);
+
+		/**
+		 * Read compressed data for decomp.
+		 * @param opaque	[in] RpFilePrivate.
+		 * @param pos		[in] Starting address.
+		 * @param ptr		[out] Output data buffer.
+		 * @param size		[in] Amount of data to read, in bytes.
+		 * @return Number of bytes read.
+		 */
+		static size_t compReadFunc(void *opaque, int64_t pos, void *ptr, size_t size);
+
+		/**
+		 * Open the decompression reader.
+		 * @param comp_size Compressed file size.
+		 * @param other Other RpFilePrivate to share the seek index with, or nullptr.
+		 */
+		void openDecompReader(int64_t comp_size, const RpFilePrivate *other);
+
+		/**
+		 * Close the decompression reader.
+		 * If the gzip access point index has changed and the
+		 * file is large, the index is saved to the cache.
+		 */
+		void closeDecompReader(void);
+
+		// Minimum uncompressed size for saving the access point index.
+		// Smaller files are fast enough to index on every open.
+		static const int64_t GZ_INDEX_SAVE_MIN_SIZE = 32*1024*1024;
 };
 
 RpFilePrivate::~RpFilePrivate()
 {
-	if (gzfd) {
-		gzclose_r(gzfd);
-	}
+	closeDecompReader();
 }
 
 /**
@@ -151,7 +189,7 @@ inline const mode_str_t *RpFilePrivate::mode_to_str(RpFile::FileMode mode)
 /**
  * (Re-)Open the main file.
  *
- * INTERNAL FUNCTION. This does NOT affect gzfd.
+ * INTERNAL FUNCTION. This does NOT affect decomp.
  * NOTE: This function sets q->m_lastError.
  *
  * Uses parameters stored in this->filename and this->mode.
@@ -198,6 +236,97 @@ int RpFilePrivate::reOpenFile(void)
 	return 0;
 }
 
+/**
+ * Read compressed data for decomp.
+ * @param opaque	[in] RpFilePrivate.
+ * @param pos		[in] Starting address.
+ * @param ptr		[out] Output data buffer.
+ * @param size		[in] Amount of data to read, in bytes.
+ * @return Number of bytes read.
+ */
+size_t RpFilePrivate::compReadFunc(void *opaque, int64_t pos, void *ptr, size_t size)
+{
+	RpFilePrivate *const d = static_cast<RpFilePrivate*>(opaque);
+	FILE *const f = d->file.get();
+	if (!f) {
+		return 0;
+	}
+
+#ifdef HAVE_PREAD
+	// NOTE: The FILE is shared with dup()'d objects,
+	// so pread() is used to avoid changing its position.
+	const int fd = fileno(f);
+	uint8_t *ptr8 = static_cast<uint8_t*>(ptr);
+	size_t ret = 0;
+	while (ret < size) {
+		ssize_t rd = ::pread(fd, ptr8 + ret, size - ret, pos + ret);
+		if (rd < 0 && errno == EINTR)
+			continue;
+		if (rd <= 0)
+			break;
+		ret += static_cast<size_t>(rd);
+	}
+	return ret;
+#else /* !HAVE_PREAD */
+	if (fseeko(f, pos, SEEK_SET) != 0) {
+		return 0;
+	}
+	return fread(ptr, 1, size, f);
+#endif /* HAVE_PREAD */
+}
+
+/**
+ * Open the decompression reader.
+ * @param comp_size Compressed file size.
+ * @param other Other RpFilePrivate to share the seek index with, or nullptr.
+ */
+void RpFilePrivate::openDecompReader(int64_t comp_size, const RpFilePrivate *other)
+{
+	if (other) {
+		// Share the other file's seek index.
+		decomp = other->decomp->dup(compReadFunc, this);
+		idx_mtime = other->idx_mtime;
+		return;
+	}
+
+	decomp = IDecompReader::create(compReadFunc, this, comp_size);
+	decomp_pos = 0;
+	if (!decomp)
+		return;
+
+	// Load the gzip access point index if it was saved previously.
+	if (decomp->format() == IDecompReader::FMT_GZIP &&
+	    decomp->size() >= GZ_INDEX_SAVE_MIN_SIZE &&
+	    FileSystem::get_mtime(filename, &idx_mtime) == 0)
+	{
+		const string idx_filename = GzReader::indexFilename(filename);
+		if (!idx_filename.empty()) {
+			decomp->loadIndex(idx_filename, filename, idx_mtime);
+		}
+	}
+}
+
+/**
+ * Close the decompression reader.
+ * If the gzip access point index has changed and the
+ * file is large, the index is saved to the cache.
+ */
+void RpFilePrivate::closeDecompReader(void)
+{
+	if (!decomp)
+		return;
+
+	if (idx_mtime != 0 && decomp->isIndexDirty()) {
+		const string idx_filename = GzReader::indexFilename(filename);
+		if (!idx_filename.empty()) {
+			decomp->saveIndex(idx_filename, filename, idx_mtime);
+		}
+	}
+
+	delete decomp;
+	decomp = nullptr;
+}
+
 /** RpFile **/
 
 /**
@@ -244,52 +373,15 @@ void RpFile::init(void)
 		return;
 	}
 
-	// Check if this is a gzipped file.
+	// Check if this is a compressed file.
 	// If it is, use transparent decompression.
-	// Reference: https://www.forensicswiki.org/wiki/Gzip
 	if (d->mode == FM_OPEN_READ_GZ) {
-		uint16_t gzmagic;
-		size_t size = fread(&gzmagic, 1, sizeof(gzmagic), d->file.get());
-		if (size == sizeof(gzmagic) && gzmagic == be16_to_cpu(0x1F8B)) {
-			// This is a gzipped file.
-			// Get the uncompressed size at the end of the file.
-			fseeko(d->file.get(), 0, SEEK_END);
-			int64_t real_sz = ftello(d->file.get());
-			if (real_sz > 10+8) {
-				int ret = fseeko(d->file.get(), real_sz-4, SEEK_SET);
-				if (!ret) {
-					uint32_t uncomp_sz;
-					size = fread(&uncomp_sz, 1, sizeof(uncomp_sz), d->file.get());
-					uncomp_sz = le32_to_cpu(uncomp_sz);
-					if (size == sizeof(uncomp_sz) && uncomp_sz >= real_sz-(10+8)) {
-						// Uncompressed size looks valid.
-						d->gzsz = (int64_t)uncomp_sz;
-
-						// Make sure the CRC32 table is initialized.
-						get_crc_table();
-
-						// Open the file with gzdopen().
-						::rewind(d->file.get());
-						::fflush(d->file.get());
-						int gzfd_dup = ::dup(fileno(d->file.get()));
-						if (gzfd_dup >= 0) {
-							d->gzfd = gzdopen(gzfd_dup, "r");
-							if (!d->gzfd) {
-								// gzdopen() failed.
-								// Close the dup()'d handle to prevent a leak.
-								::close(gzfd_dup);
-							}
-						}
-					}
-				}
-			}
-		}
-
-		if (!d->gzfd) {
-			// Not a gzipped file.
-			// Rewind and flush the file.
-			::rewind(d->file.get());
-			::fflush(d->file.get());
+		fseeko(d->file.get(), 0, SEEK_END);
+		const int64_t real_sz = ftello(d->file.get());
+		::rewind(d->file.get());
+		::fflush(d->file.get());
+		if (real_sz > 0) {
+			d->openDecompReader(real_sz, nullptr);
 		}
 	}
 }
@@ -308,35 +400,16 @@ RpFile::RpFile(const RpFile &other)
 	, d_ptr(new RpFilePrivate(this, other.d_ptr->filename, other.d_ptr->mode))
 {
 	RP_D(RpFile);
-	m_lastError = other.m_lastError;
-
-	// NOTE: If the file is gzipped, we can't simply dup()
-	// the file handle because gzdopen() won't work correctly.
-	// TODO: Consolidate with init() and others.
-	if (other.d_ptr->gzfd) {
-		// Re-open the file.
-		if (!d->reOpenFile()) {
-			// Open as gzip without checking modes,
-			// since we know it was already gzipped.
-			::rewind(d->file.get());
-			::fflush(d->file.get());
-			int gzfd_dup = ::dup(fileno(d->file.get()));
-			if (gzfd_dup >= 0) {
-				d->gzfd = gzdopen(gzfd_dup, "r");
-				if (d->gzfd) {
-					// Copy the uncompressed size and seek position.
-					d->gzsz = other.d_ptr->gzsz;
-					gzseek(d->gzfd, gztell(other.d_ptr->gzfd), SEEK_SET);
-				} else {
-					// gzdopen() failed.
-					// Close the dup()'d handle to prevent a leak.
-					::close(gzfd_dup);
-				}
-			}
-		}
-	} else {
-		// Not gzipped.
-		d->file = other.d_ptr->file;
+	m_lastError = other.lastError();
+
+	// NOTE: The decompression reader doesn't use the FILE's position,
+	// so the FILE can be shared even if the file is compressed.
+	// The dup()'d file gets its own decompression state,
+	// but the seek index is shared.
+	d->file = other.d_ptr->file;
+	if (other.d_ptr->decomp) {
+		d->openDecompReader(0, other.d_ptr);
+		d->decomp_pos = other.d_ptr->decomp_pos;
 	}
 }
 
@@ -350,44 +423,17 @@ RpFile &RpFile::operator=(const RpFile &other)
 	RP_D(RpFile);
 	d->filename = other.d_ptr->filename;
 	d->mode = other.d_ptr->mode;
-	m_lastError = other.m_lastError;
-
-	// NOTE: If the file is gzipped, we can't simply dup()
-	// the file handle because gzdopen() won't work correctly.
-	// TODO: Consolidate with init() and others.
-	if (other.d_ptr->gzfd) {
-		// Re-open the file.
-		const mode_str_t *mode_str = d->mode_to_str(d->mode);
-#ifdef _WIN32
-		// Windows: Use U82W_s() to convert the filename to wchar_t.
-		wstring filenameW = U82W_s(d->filename);
-		d->file.reset(_wfopen(filenameW.c_str(), mode_str), myFile_deleter());
-#else /* !_WIN32 */
-		// Linux: Use UTF-8 filenames directly.
-		d->file.reset(fopen(d->filename.c_str(), mode_str), myFile_deleter());
-#endif /* _WIN32 */
-		if (d->file) {
-			// Open as gzip without checking modes,
-			// since we know it was already gzipped.
-			::rewind(d->file.get());
-			::fflush(d->file.get());
-			int gzfd_dup = ::dup(fileno(d->file.get()));
-			if (gzfd_dup >= 0) {
-				d->gzfd = gzdopen(gzfd_dup, "r");
-				if (d->gzfd) {
-					// Copy the uncompressed size and seek position.
-					d->gzsz = other.d_ptr->gzsz;
-					gzseek(d->gzfd, gztell(other.d_ptr->gzfd), SEEK_SET);
-				} else {
-					// gzdopen() failed.
-					// Close the dup()'d handle to prevent a leak.
-					::close(gzfd_dup);
-				}
-			}
-		}
-	} else {
-		// Not gzipped.
-		d->file = other.d_ptr->file;
+	m_lastError = other.lastError();
+
+	// NOTE: The decompression reader doesn't use the FILE's position,
+	// so the FILE can be shared even if the file is compressed.
+	// The copied file gets its own decompression state,
+	// but the seek index is shared.
+	d->closeDecompReader();
+	d->file = other.d_ptr->file;
+	if (other.d_ptr->decomp) {
+		d->openDecompReader(0, other.d_ptr);
+		d->decomp_pos = other.d_ptr->decomp_pos;
 	}
 
 	return *this;
@@ -426,10 +472,7 @@ IRpFile *RpFile::dup(void)
 void RpFile::close(void)
 {
 	RP_D(RpFile);
-	if (d->gzfd) {
-		gzclose_r(d->gzfd);
-		d->gzfd = nullptr;
-	}
+	d->closeDecompReader();
 	d->file.reset();
 }
 
@@ -448,14 +491,14 @@ size_t RpFile::read(void *ptr, size_t size)
 	}
 
 	size_t ret;
-	if (d->gzfd) {
-		int iret = gzread(d->gzfd, ptr, size);
-		if (iret >= 0) {
-			ret = (size_t)iret;
-		} else {
+	if (d->decomp) {
+		// The decompression reader is shared with pread().
+		MutexLocker locker(m_preadMutex);
+		ret = d->decomp->read(d->decomp_pos, ptr, size);
+		d->decomp_pos += ret;
+		if (ret != size && d->decomp->lastError() != 0) {
 			// An error occurred.
-			ret = 0;
-			m_lastError = errno;
+			m_lastError = d->decomp->lastError();
 		}
 	} else {
 		ret = fread(ptr, 1, size, d->file.get());
@@ -505,22 +548,23 @@ int RpFile::seek(int64_t pos)
 	}
 
 	int ret;
-	if (d->gzfd) {
-		z_off_t zret = gzseek(d->gzfd, pos, SEEK_SET);
-		if (zret >= 0) {
+	if (d->decomp) {
+		// Seeking is handled by the decompression reader when reading.
+		MutexLocker locker(m_preadMutex);
+		if (pos >= 0) {
+			d->decomp_pos = pos;
 			ret = 0;
 		} else {
-			// TODO: Does gzseek() set errno?
 			ret = -1;
-			m_lastError = -EIO;
+			m_lastError = EINVAL;
 		}
 	} else {
 		ret = fseeko(d->file.get(), pos, SEEK_SET);
 		if (ret != 0) {
 			m_lastError = errno;
 		}
+		::fflush(d->file.get());
 	}
-	::fflush(d->file.get());	// needed for some things like gzip
 	return ret;
 }
 
@@ -536,8 +580,9 @@ int64_t RpFile::tell(void)
 		return -1;
 	}
 
-	if (d->gzfd) {
-		return (int64_t)gztell(d->gzfd);
+	if (d->decomp) {
+		MutexLocker locker(m_preadMutex);
+		return d->decomp_pos;
 	}
 	return ftello(d->file.get());
 }
@@ -593,6 +638,186 @@ int RpFile::truncate(int64_t size)
 	return 0;
 }
 
+/**
+ * Read data from the file at the specified address.
+ * The file position is not changed.
+ *
+ * This function is thread-safe. Regular files are read
+ * using pread(), which doesn't use the shared file position.
+ * Reads from compressed files are serialized with read()
+ * and seek(), since the decompression reader is shared.
+ *
+ * @param pos	[in] Starting address.
+ * @param ptr	[out] Output data buffer.
+ * @param size	[in] Amount of data to read, in bytes.
+ * @return Number of bytes read.
+ */
+size_t RpFile::pread(int64_t pos, void *ptr, size_t size)
+{
+	RP_D(RpFile);
+	if (!d->file) {
+		m_lastError = EBADF;
+		return 0;
+	} else if (d->decomp) {
+		// The decompression reader isn't thread-safe.
+		// NOTE: The default pread() can't be used here, since
+		// it locks m_preadMutex before calling read().
+		MutexLocker locker(m_preadMutex);
+		size_t ret = d->decomp->read(pos, ptr, size);
+		if (ret != size && d->decomp->lastError() != 0) {
+			m_lastError = d->decomp->lastError();
+		}
+		return ret;
+	}
+
+#ifdef HAVE_PREAD
+	if (d->mode & FM_WRITE) {
+		// pread() bypasses the stdio buffer, so make sure
+		// any pending writes are flushed first.
+		::fflush(d->file.get());
+	}
+	const int fd = fileno(d->file.get());
+
+	// Read the data, continuing after partial reads.
+	uint8_t *ptr8 = static_cast<uint8_t*>(ptr);
+	size_t ret = 0;
+	while (ret < size) {
+		ssize_t rd = ::pread(fd, ptr8 + ret, size - ret, pos + ret);
+		if (rd < 0 && errno == EINTR)
+			continue;
+		if (rd <= 0) {
+			// Error or end of file.
+			if (rd < 0) {
+				m_lastError = errno;
+			}
+			break;
+		}
+		ret += static_cast<size_t>(rd);
+	}
+	return ret;
+#else /* !HAVE_PREAD */
+	return super::pread(pos, ptr, size);
+#endif /* HAVE_PREAD */
+}
+
+/**
+ * Hint that data will be read soon.
+ *
+ * Regular files use posix_fadvise() where available.
+ * Compressed files are not prefetched.
+ *
+ * @param pos	[in] Starting address.
+ * @param size	[in] Amount of data, in bytes.
+ */
+void RpFile::prefetch(int64_t pos, size_t size)
+{
+#ifdef HAVE_POSIX_FADVISE
+	RP_D(RpFile);
+	if (!d->file || d->decomp || pos < 0) {
+		// Not open, or compressed.
+		return;
+	}
+	posix_fadvise(fileno(d->file.get()), pos, size, POSIX_FADV_WILLNEED);
+#else /* !HAVE_POSIX_FADVISE */
+	RP_UNUSED(pos);
+	RP_UNUSED(size);
+#endif /* HAVE_POSIX_FADVISE */
+}
+
+/**
+ * Read multiple segments from the file.
+ *
+ * If the file isn't compressed, contiguous segments are
+ * merged and read using preadv() where available.
+ *
+ * NOTE: The file position is unspecified afterwards.
+ *
+ * @param segs	[in] Read segments.
+ * @param count	[in] Number of segments.
+ * @return Number of segments that were read completely.
+ */
+unsigned int RpFile::readBatch(const ReadSegment *segs, unsigned int count)
+{
+#ifdef HAVE_PREADV
+	RP_D(RpFile);
+	if (!d->file) {
+		m_lastError = EBADF;
+		return 0;
+	} else if (d->decomp) {
+		// Decompression requires sequential reads.
+		return super::readBatch(segs, count);
+	}
+
+	// preadv() bypasses the stdio buffer, so make sure
+	// any pending writes are flushed first.
+	::fflush(d->file.get());
+	const int fd = fileno(d->file.get());
+
+	const vector<const ReadSegment*> order = sortReadSegments(segs, count);
+	unsigned int ret = 0;
+
+	// Merge runs of contiguous segments into iovecs.
+	struct iovec iov[IOV_MAX];
+	for (size_t i = 0; i < order.size(); ) {
+		const int64_t run_pos = order[i]->pos;
+		int64_t run_end = run_pos;
+		size_t run_total = 0;
+		int iovcnt = 0;
+		size_t j = i;
+		for (; j < order.size() && iovcnt < IOV_MAX; j++) {
+			const ReadSegment *const seg = order[j];
+			if (seg->pos != run_end)
+				break;
+			iov[iovcnt].iov_base = seg->ptr;
+			iov[iovcnt].iov_len = seg->size;
+			iovcnt++;
+			run_end += seg->size;
+			run_total += seg->size;
+		}
+
+		// Read the run, continuing after partial reads.
+		size_t done = 0;
+		while (done < run_total) {
+			// Skip iovecs that have already been filled.
+			int iov_idx = 0;
+			size_t skip = done;
+			while (iov_idx < iovcnt && skip >= iov[iov_idx].iov_len) {
+				skip -= iov[iov_idx].iov_len;
+				iov_idx++;
+			}
+			struct iovec first = iov[iov_idx];
+			iov[iov_idx].iov_base = static_cast<uint8_t*>(iov[iov_idx].iov_base) + skip;
+			iov[iov_idx].iov_len -= skip;
+			ssize_t rd = preadv(fd, &iov[iov_idx], iovcnt - iov_idx, run_pos + done);
+			iov[iov_idx] = first;
+			if (rd < 0 && errno == EINTR)
+				continue;
+			if (rd <= 0) {
+				// Error or end of file.
+				if (rd < 0) {
+					m_lastError = errno;
+				}
+				break;
+			}
+			done += static_cast<size_t>(rd);
+		}
+
+		// Count the segments that were read completely.
+		for (; i < j; i++) {
+			const size_t seg_end = static_cast<size_t>(order[i]->pos - run_pos) + order[i]->size;
+			if (seg_end > done)
+				break;
+			ret++;
+		}
+		i = j;
+	}
+
+	return ret;
+#else /* !HAVE_PREADV */
+	return super::readBatch(segs, count);
+#endif /* HAVE_PREADV */
+}
+
 /** File properties. **/
 
 /**
@@ -609,10 +834,11 @@ int64_t RpFile::size(void)
 
 	// TODO: Error checking?
 
-	if (d->gzfd) {
-		// gzipped files have the uncompressed size stored
-		// at the end of the stream.
-		return d->gzsz;
+	if (d->decomp) {
+		// NOTE: Some formats don't store the uncompressed size,
+		// so this may decompress the entire file.
+		MutexLocker locker(m_preadMutex);
+		return d->decomp->size();
 	}
 
 	// Save the current position.
@@ -629,6 +855,22 @@ int64_t RpFile::size(void)
 	return end_pos;
 }
 
+/**
+ * Get the file size, limiting the amount of work needed
+ * to determine it.
+ * @param max_size Maximum amount of data to decompress.
+ * @return File size if it's <= max_size or if it can be determined cheaply; otherwise, a lower bound larger than max_size. Negative on error.
+ */
+int64_t RpFile::sizeUpTo(int64_t max_size)
+{
+	RP_D(RpFile);
+	if (d->decomp) {
+		MutexLocker locker(m_preadMutex);
+		return d->decomp->sizeUpTo(max_size);
+	}
+	return size();
+}
+
 /**
  * Get the filename.
  * @return Filename. (May be empty if the filename is not available.)
@@ -639,4 +881,14 @@ string RpFile::filename(void) const
 	return d->filename;
 }
 
+/**
+ * Get the transparent decompression format.
+ * @return IDecompReader::Format, or -1 if the file data is read as-is.
+ */
+int RpFile::decompFormat(void) const
+{
+	RP_D(const RpFile);
+	return (d->decomp ? static_cast<int>(d->decomp->format()) : -1);
+}
+
 }
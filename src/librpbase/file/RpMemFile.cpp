@@ -64,7 +64,7 @@ RpMemFile::RpMemFile(const RpMemFile &other)
 	, m_pos(0)
 {
 	// If there's no buffer specified, that's an error.
-	m_lastError = (m_buf ? other.m_lastError : EBADF);
+	m_lastError = (m_buf ? other.lastError() : EBADF);
 }
 
 /**
@@ -79,7 +79,7 @@ RpMemFile &RpMemFile::operator=(const RpMemFile &other)
 	m_pos = 0;
 
 	// If there's no buffer specified, that's an error.
-	m_lastError = (m_buf ? other.m_lastError : EBADF);
+	m_lastError = (m_buf ? other.lastError() : EBADF);
 	return *this;
 }
 
@@ -218,6 +218,36 @@ int RpMemFile::truncate(int64_t size)
 	return -1;
 }
 
+/**
+ * Read data from the file at the specified address.
+ * The file position is not changed.
+ * This function is thread-safe.
+ * @param pos	[in] Starting address.
+ * @param ptr	[out] Output data buffer.
+ * @param size	[in] Amount of data to read, in bytes.
+ * @return Number of bytes read.
+ */
+size_t RpMemFile::pread(int64_t pos, void *ptr, size_t size)
+{
+	if (!m_buf) {
+		m_lastError = EBADF;
+		return 0;
+	} else if (pos < 0 || pos >= static_cast<int64_t>(m_size)) {
+		// Out of range.
+		return 0;
+	}
+
+	// Check if size is in bounds.
+	if (size > m_size - static_cast<size_t>(pos)) {
+		// Not enough data.
+		// Copy whatever's left in the buffer.
+		size = m_size - static_cast<size_t>(pos);
+	}
+
+	memcpy(ptr, static_cast<const uint8_t*>(m_buf) + pos, size);
+	return size;
+}
+
 /** File properties. **/
 
 /**
@@ -244,4 +274,24 @@ string RpMemFile::filename(void) const
 	return string();
 }
 
+/**
+ * Borrow a pointer to the file data without copying it.
+ * The file position is not changed.
+ * @param pos	[in] Starting address.
+ * @param size	[in] Amount of data, in bytes.
+ * @return Pointer to the data, or nullptr if out of range.
+ */
+const void *RpMemFile::borrow(int64_t pos, size_t size)
+{
+	if (!m_buf || pos < 0 ||
+	    static_cast<uint64_t>(pos) > m_size ||
+	    size > m_size - static_cast<size_t>(pos))
+	{
+		// Out of range.
+		return nullptr;
+	}
+
+	return static_cast<const uint8_t*>(m_buf) + pos;
+}
+
 }
@@ -109,6 +109,17 @@ class RpMemFile : public IRpFile
 		 */
 		int truncate(int64_t size = 0) final;
 
+		/**
+		 * Read data from the file at the specified address.
+		 * The file position is not changed.
+		 * This function is thread-safe.
+		 * @param pos	[in] Starting address.
+		 * @param ptr	[out] Output data buffer.
+		 * @param size	[in] Amount of data to read, in bytes.
+		 * @return Number of bytes read.
+		 */
+		size_t pread(int64_t pos, void *ptr, size_t size) final;
+
 	public:
 		/** File properties. **/
 
@@ -124,6 +135,16 @@ class RpMemFile : public IRpFile
 		 */
 		std::string filename(void) const final;
 
+	public:
+		/**
+		 * Borrow a pointer to the file data without copying it.
+		 * The file position is not changed.
+		 * @param pos	[in] Starting address.
+		 * @param size	[in] Amount of data, in bytes.
+		 * @return Pointer to the data, or nullptr if out of range.
+		 */
+		const void *borrow(int64_t pos, size_t size) final;
+
 	protected:
 		const void *m_buf;	// Memory buffer.
 		size_t m_size;		// Size of memory buffer.
@@ -0,0 +1,425 @@
+/***************************************************************************
+ * ROM Properties Page shell extension. (librpbase)                        *
+ * RpMmapFile.cpp: Memory-mapped file object. (read-only)                  *
+ *                                                                         *
+ * Copyright (c) 2016-2018 by David Korth.                                 *
+ *                                                                         *
+ * This program is free software; you can redistribute it and/or modify it *
+ * under the terms of the GNU General Public License as published by the   *
+ * Free Software Foundation; either version 2 of the License, or (at your  *
+ * option) any later version.                                              *
+ *                                                                         *
+ * This program is distributed in the hope that it will be useful, but     *
+ * WITHOUT ANY WARRANTY; without even the implied warranty of              *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the           *
+ * GNU General Public License for more details.                            *
+ *                                                                         *
+ * You should have received a copy of the GNU General Public License       *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.   *
+ ***************************************************************************/
+
+#include "RpMmapFile.hpp"
+
+// C includes.
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// C includes. (C++ namespace)
+#include <cerrno>
+#include <cstring>
+
+// C++ includes.
+#include <string>
+using std::string;
+
+#ifndef O_CLOEXEC
+# define O_CLOEXEC 0
+#endif
+
+namespace LibRpBase {
+
+/**
+ * Memory mapping shared between dup()'d RpMmapFile objects.
+ * The mapping is removed when the last reference is released.
+ */
+struct RpMmapFileMapping
+{
+	const uint8_t *addr;	// Mapped address.
+	size_t size;		// Mapped size.
+
+	RpMmapFileMapping(const uint8_t *addr, size_t size)
+		: addr(addr), size(size) { }
+	~RpMmapFileMapping()
+	{
+		munmap(const_cast<uint8_t*>(addr), size);
+	}
+
+	private:
+		RP_DISABLE_COPY(RpMmapFileMapping)
+};
+
+/**
+ * Open a file using a read-only memory mapping.
+ *
+ * The entire file is mapped, so reads don't require
+ * any system calls. Use borrow() to access the file
+ * data without copying it.
+ *
+ * NOTE: Only regular files are supported. If the file
+ * can't be mapped, isOpen() will return false and
+ * lastError() will be set; the caller should fall back
+ * to RpFile in that case.
+ *
+ * @param filename Filename.
+ */
+RpMmapFile::RpMmapFile(const char *filename)
+	: super()
+	, m_filename(filename)
+	, m_pos(0)
+{
+	init();
+}
+
+/**
+ * Open a file using a read-only memory mapping.
+ *
+ * The entire file is mapped, so reads don't require
+ * any system calls. Use borrow() to access the file
+ * data without copying it.
+ *
+ * NOTE: Only regular files are supported. If the file
+ * can't be mapped, isOpen() will return false and
+ * lastError() will be set; the caller should fall back
+ * to RpFile in that case.
+ *
+ * @param filename Filename.
+ */
+RpMmapFile::RpMmapFile(const string &filename)
+	: super()
+	, m_filename(filename)
+	, m_pos(0)
+{
+	init();
+}
+
+/**
+ * Common initialization function for RpMmapFile's constructors.
+ * Filename must be set in m_filename.
+ */
+void RpMmapFile::init(void)
+{
+	int fd = ::open(m_filename.c_str(), O_RDONLY | O_CLOEXEC);
+	if (fd < 0) {
+		m_lastError = errno;
+		if (m_lastError == 0) {
+			m_lastError = EIO;
+		}
+		return;
+	}
+
+	// Only regular files can be mapped.
+	// Empty files can't be mapped, either.
+	struct stat sb;
+	if (fstat(fd, &sb) != 0) {
+		m_lastError = errno;
+		::close(fd);
+		return;
+	} else if (!S_ISREG(sb.st_mode) || sb.st_size <= 0) {
+		m_lastError = ENOTSUP;
+		::close(fd);
+		return;
+	} else if (static_cast<uint64_t>(sb.st_size) > static_cast<uint64_t>(SIZE_MAX)) {
+		// File is too big to map on this system.
+		m_lastError = EFBIG;
+		::close(fd);
+		return;
+	}
+
+	const size_t map_size = static_cast<size_t>(sb.st_size);
+	void *addr = mmap(nullptr, map_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	// The mapping stays valid after the file descriptor is closed.
+	::close(fd);
+	if (addr == MAP_FAILED) {
+		m_lastError = errno;
+		if (m_lastError == 0) {
+			m_lastError = ENOMEM;
+		}
+		return;
+	}
+
+	// NOTE: If the file is truncated by another process while
+	// it's mapped, accessing the truncated area will SIGBUS.
+	// This is the same tradeoff as any other mmap() reader.
+	m_map = std::make_shared<RpMmapFileMapping>(static_cast<const uint8_t*>(addr), map_size);
+}
+
+RpMmapFile::~RpMmapFile()
+{ }
+
+/**
+ * Copy constructor.
+ * @param other Other instance.
+ */
+RpMmapFile::RpMmapFile(const RpMmapFile &other)
+	: super()
+	, m_map(other.m_map)
+	, m_filename(other.m_filename)
+	, m_pos(0)
+{
+	// If there's no mapping, that's an error.
+	m_lastError = (m_map ? other.lastError() : EBADF);
+}
+
+/**
+ * Assignment operator.
+ * @param other Other instance.
+ * @return This instance.
+ */
+RpMmapFile &RpMmapFile::operator=(const RpMmapFile &other)
+{
+	m_map = other.m_map;
+	m_filename = other.m_filename;
+	m_pos = 0;
+
+	// If there's no mapping, that's an error.
+	m_lastError = (m_map ? other.lastError() : EBADF);
+	return *this;
+}
+
+/**
+ * Is the file open?
+ * This usually only returns false if an error occurred.
+ * @return True if the file is open; false if it isn't.
+ */
+bool RpMmapFile::isOpen(void) const
+{
+	return (m_map.get() != nullptr);
+}
+
+/**
+ * dup() the file handle.
+ *
+ * Needed because IRpFile* objects are typically
+ * pointers, not actual instances of the object.
+ *
+ * NOTE: For RpMmapFile, the memory mapping is shared,
+ * but the dup()'d file has a separate file pointer.
+ *
+ * @return dup()'d file, or nullptr on error.
+ */
+IRpFile *RpMmapFile::dup(void)
+{
+	return new RpMmapFile(*this);
+}
+
+/**
+ * Close the file.
+ */
+void RpMmapFile::close(void)
+{
+	m_map.reset();
+}
+
+/**
+ * Read data from the file.
+ * @param ptr Output data buffer.
+ * @param size Amount of data to read, in bytes.
+ * @return Number of bytes read.
+ */
+size_t RpMmapFile::read(void *ptr, size_t size)
+{
+	if (!m_map) {
+		m_lastError = EBADF;
+		return 0;
+	}
+
+	// Check if size is in bounds.
+	const size_t map_size = m_map->size;
+	if (size > map_size - m_pos) {
+		// Not enough data.
+		// Copy whatever's left in the mapping.
+		size = map_size - m_pos;
+	}
+
+	if (size > 0) {
+		// Copy the data.
+		memcpy(ptr, &m_map->addr[m_pos], size);
+		m_pos += size;
+	}
+
+	return size;
+}
+
+/**
+ * Write data to the file.
+ * (NOTE: Not valid for RpMmapFile; this will always return 0.)
+ * @param ptr Input data buffer.
+ * @param size Amount of data to read, in bytes.
+ * @return Number of bytes written.
+ */
+size_t RpMmapFile::write(const void *ptr, size_t size)
+{
+	// Not a valid operation for RpMmapFile.
+	RP_UNUSED(ptr);
+	RP_UNUSED(size);
+	m_lastError = EBADF;
+	return 0;
+}
+
+/**
+ * Set the file position.
+ * @param pos File position.
+ * @return 0 on success; -1 on error.
+ */
+int RpMmapFile::seek(int64_t pos)
+{
+	if (!m_map) {
+		m_lastError = EBADF;
+		return -1;
+	}
+
+	// NOTE: m_pos is size_t, since it's referring to
+	// a position within the memory mapping.
+	if (pos <= 0) {
+		m_pos = 0;
+	} else if (static_cast<uint64_t>(pos) >= m_map->size) {
+		m_pos = m_map->size;
+	} else {
+		m_pos = static_cast<size_t>(pos);
+	}
+
+	return 0;
+}
+
+/**
+ * Get the file position.
+ * @return File position, or -1 on error.
+ */
+int64_t RpMmapFile::tell(void)
+{
+	if (!m_map) {
+		m_lastError = EBADF;
+		return -1;
+	}
+
+	return static_cast<int64_t>(m_pos);
+}
+
+/**
+ * Truncate the file.
+ * (NOTE: Not valid for RpMmapFile; this will always return -1.)
+ * @param size New size. (default is 0)
+ * @return 0 on success; -1 on error.
+ */
+int RpMmapFile::truncate(int64_t size)
+{
+	// Not supported.
+	RP_UNUSED(size);
+	m_lastError = ENOTSUP;
+	return -1;
+}
+
+/**
+ * Read data from the file at the specified address.
+ * The file position is not changed.
+ * This function is thread-safe.
+ * @param pos	[in] Starting address.
+ * @param ptr	[out] Output data buffer.
+ * @param size	[in] Amount of data to read, in bytes.
+ * @return Number of bytes read.
+ */
+size_t RpMmapFile::pread(int64_t pos, void *ptr, size_t size)
+{
+	if (!m_map) {
+		m_lastError = EBADF;
+		return 0;
+	} else if (pos < 0 || static_cast<uint64_t>(pos) >= m_map->size) {
+		// Out of range.
+		return 0;
+	}
+
+	// Check if size is in bounds.
+	const size_t map_pos = static_cast<size_t>(pos);
+	if (size > m_map->size - map_pos) {
+		// Not enough data.
+		// Copy whatever's left in the mapping.
+		size = m_map->size - map_pos;
+	}
+
+	memcpy(ptr, &m_map->addr[map_pos], size);
+	return size;
+}
+
+/**
+ * Hint that data will be read soon.
+ * The pages are prefetched using posix_madvise().
+ * @param pos	[in] Starting address.
+ * @param size	[in] Amount of data, in bytes.
+ */
+void RpMmapFile::prefetch(int64_t pos, size_t size)
+{
+	if (!m_map || pos < 0 || static_cast<uint64_t>(pos) >= m_map->size) {
+		return;
+	}
+
+	size_t map_pos = static_cast<size_t>(pos);
+	if (size > m_map->size - map_pos) {
+		size = m_map->size - map_pos;
+	}
+
+	// posix_madvise() requires a page-aligned address.
+	static const size_t page_size = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+	const size_t page_offset = map_pos % page_size;
+	map_pos -= page_offset;
+	size += page_offset;
+	posix_madvise(const_cast<uint8_t*>(&m_map->addr[map_pos]), size, POSIX_MADV_WILLNEED);
+}
+
+/** File properties. **/
+
+/**
+ * Get the file size.
+ * @return File size, or negative on error.
+ */
+int64_t RpMmapFile::size(void)
+{
+	if (!m_map) {
+		m_lastError = EBADF;
+		return -1;
+	}
+
+	return static_cast<int64_t>(m_map->size);
+}
+
+/**
+ * Get the filename.
+ * @return Filename. (May be empty if the filename is not available.)
+ */
+string RpMmapFile::filename(void) const
+{
+	return m_filename;
+}
+
+/**
+ * Borrow a pointer to the file data without copying it.
+ * The file position is not changed.
+ * @param pos	[in] Starting address.
+ * @param size	[in] Amount of data, in bytes.
+ * @return Pointer to the data, or nullptr if out of range.
+ */
+const void *RpMmapFile::borrow(int64_t pos, size_t size)
+{
+	if (!m_map || pos < 0 ||
+	    static_cast<uint64_t>(pos) > m_map->size ||
+	    size > m_map->size - static_cast<size_t>(pos))
+	{
+		// Out of range.
+		return nullptr;
+	}
+
+	return m_map->addr + pos;
+}
+
+}
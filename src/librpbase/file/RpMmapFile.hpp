@@ -0,0 +1,178 @@
+/***************************************************************************
+ * ROM Properties Page shell extension. (librpbase)                        *
+ * RpMmapFile.hpp: Memory-mapped file object. (read-only)                  *
+ *                                                                         *
+ * Copyright (c) 2016-2018 by David Korth.                                 *
+ *                                                                         *
+ * This program is free software; you can redistribute it and/or modify it *
+ * under the terms of the GNU General Public License as published by the   *
+ * Free Software Foundation; either version 2 of the License, or (at your  *
+ * option) any later version.                                              *
+ *                                                                         *
+ * This program is distributed in the hope that it will be useful, but     *
+ * WITHOUT ANY WARRANTY; without even the implied warranty of              *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the           *
+ * GNU General Public License for more details.                            *
+ *                                                                         *
+ * You should have received a copy of the GNU General Public License       *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.   *
+ ***************************************************************************/
+
+#ifndef __ROMPROPERTIES_LIBRPBASE_RPMMAPFILE_HPP__
+#define __ROMPROPERTIES_LIBRPBASE_RPMMAPFILE_HPP__
+
+#include "IRpFile.hpp"
+
+// C++ includes.
+#include <memory>
+
+namespace LibRpBase {
+
+struct RpMmapFileMapping;
+class RpMmapFile : public IRpFile
+{
+	public:
+		/**
+		 * Open a file using a read-only memory mapping.
+		 *
+		 * The entire file is mapped, so reads don't require
+		 * any system calls. Use borrow() to access the file
+		 * data without copying it.
+		 *
+		 * NOTE: Only regular files are supported. If the file
+		 * can't be mapped, isOpen() will return false and
+		 * lastError() will be set; the caller should fall back
+		 * to RpFile in that case.
+		 *
+		 * @param filename Filename.
+		 */
+		explicit RpMmapFile(const char *filename);
+		explicit RpMmapFile(const std::string &filename);
+	private:
+		void init(void);
+	public:
+		virtual ~RpMmapFile();
+
+	private:
+		typedef IRpFile super;
+	public:
+		RpMmapFile(const RpMmapFile &other);
+		RpMmapFile &operator=(const RpMmapFile &other);
+
+	public:
+		/**
+		 * Is the file open?
+		 * This usually only returns false if an error occurred.
+		 * @return True if the file is open; false if it isn't.
+		 */
+		bool isOpen(void) const final;
+
+		/**
+		 * dup() the file handle.
+		 *
+		 * Needed because IRpFile* objects are typically
+		 * pointers, not actual instances of the object.
+		 *
+		 * NOTE: For RpMmapFile, the memory mapping is shared,
+		 * but the dup()'d file has a separate file pointer.
+		 *
+		 * @return dup()'d file, or nullptr on error.
+		 */
+		IRpFile *dup(void) final;
+
+		/**
+		 * Close the file.
+		 */
+		void close(void) final;
+
+		/**
+		 * Read data from the file.
+		 * @param ptr Output data buffer.
+		 * @param size Amount of data to read, in bytes.
+		 * @return Number of bytes read.
+		 */
+		size_t read(void *ptr, size_t size) final;
+
+		/**
+		 * Write data to the file.
+		 * (NOTE: Not valid for RpMmapFile; this will always return 0.)
+		 * @param ptr Input data buffer.
+		 * @param size Amount of data to read, in bytes.
+		 * @return Number of bytes written.
+		 */
+		size_t write(const void *ptr, size_t size) final;
+
+		/**
+		 * Set the file position.
+		 * @param pos File position.
+		 * @return 0 on success; -1 on error.
+		 */
+		int seek(int64_t pos) final;
+
+		/**
+		 * Get the file position.
+		 * @return File position, or -1 on error.
+		 */
+		int64_t tell(void) final;
+
+		/**
+		 * Truncate the file.
+		 * (NOTE: Not valid for RpMmapFile; this will always return -1.)
+		 * @param size New size. (default is 0)
+		 * @return 0 on success; -1 on error.
+		 */
+		int truncate(int64_t size = 0) final;
+
+		/**
+		 * Read data from the file at the specified address.
+		 * The file position is not changed.
+		 * This function is thread-safe.
+		 * @param pos	[in] Starting address.
+		 * @param ptr	[out] Output data buffer.
+		 * @param size	[in] Amount of data to read, in bytes.
+		 * @return Number of bytes read.
+		 */
+		size_t pread(int64_t pos, void *ptr, size_t size) final;
+
+		/**
+		 * Hint that data will be read soon.
+		 * The pages are prefetched using posix_madvise().
+		 * @param pos	[in] Starting address.
+		 * @param size	[in] Amount of data, in bytes.
+		 */
+		void prefetch(int64_t pos, size_t size) final;
+
+	public:
+		/** File properties. **/
+
+		/**
+		 * Get the file size.
+		 * @return File size, or negative on error.
+		 */
+		int64_t size(void) final;
+
+		/**
+		 * Get the filename.
+		 * @return Filename. (May be empty if the filename is not available.)
+		 */
+		std::string filename(void) const final;
+
+	public:
+		/**
+		 * Borrow a pointer to the file data without copying it.
+		 * The file position is not changed.
+		 * @param pos	[in] Starting address.
+		 * @param size	[in] Amount of data, in bytes.
+		 * @return Pointer to the data, or nullptr if out of range.
+		 */
+		const void *borrow(int64_t pos, size_t size) final;
+
+	protected:
+		std::shared_ptr<RpMmapFileMapping> m_map;	// Shared memory mapping.
+		std::string m_filename;	// Filename.
+		size_t m_pos;		// Current position.
+};
+
+}
+
+#endif /* __ROMPROPERTIES_LIBRPBASE_RPMMAPFILE_HPP__ */
@@ -0,0 +1,463 @@
+/***************************************************************************
+ * ROM Properties Page shell extension. (librpbase)                        *
+ * XzReader.cpp: xz decompression reader.                                  *
+ *                                                                         *
+ * Copyright (c) 2016-2018 by David Korth.                                 *
+ *                                                                         *
+ * This program is free software; you can redistribute it and/or modify it *
+ * under the terms of the GNU General Public License as published by the   *
+ * Free Software Foundation; either version 2 of the License, or (at your  *
+ * option) any later version.                                              *
+ *                                                                         *
+ * This program is distributed in the hope that it will be useful, but     *
+ * WITHOUT ANY WARRANTY; without even the implied warranty of              *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the           *
+ * GNU General Public License for more details.                            *
+ *                                                                         *
+ * You should have received a copy of the GNU General Public License       *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.   *
+ ***************************************************************************/
+
+#include "XzReader.hpp"
+
+// liblzma
+#include <lzma.h>
+
+// C includes. (C++ namespace)
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+
+// C++ includes.
+#include <memory>
+#include <vector>
+using std::shared_ptr;
+using std::vector;
+
+namespace LibRpBase {
+
+// Maximum size of an xz index.
+// Each block uses a few bytes, so this allows millions of blocks.
+#define XZ_MAX_INDEX_SIZE (16*1024*1024)
+
+/**
+ * Convert an lzma_ret error code to a negative POSIX error code.
+ * @param ret lzma_ret
+ * @return Negative POSIX error code.
+ */
+static inline int lzmaErrorToPosix(lzma_ret ret)
+{
+	switch (ret) {
+		case LZMA_MEM_ERROR:
+		case LZMA_MEMLIMIT_ERROR:
+			return -ENOMEM;
+		case LZMA_OPTIONS_ERROR:
+		case LZMA_UNSUPPORTED_CHECK:
+			return -ENOTSUP;
+		default:
+			return -EIO;
+	}
+}
+
+/** XzReaderPrivate **/
+
+class XzReaderPrivate
+{
+	public:
+		XzReaderPrivate(XzReader *q);
+		~XzReaderPrivate();
+
+	private:
+		RP_DISABLE_COPY(XzReaderPrivate)
+		XzReader *const q_ptr;
+
+	public:
+		// xz index for all streams in the file.
+		// Shared between copies of the same XzReader.
+		shared_ptr<lzma_index> index;
+
+		// Decompression state.
+		lzma_stream strm;
+		bool strm_init;		// True if strm is initialized.
+		bool block_end;		// True if the end of the current block was reached.
+		int64_t in_pos;		// Compressed address of the end of inbuf.
+		int64_t in_end;		// Compressed address of the end of the current block.
+
+		// Block header. The filter options are
+		// allocated by lzma_block_header_decode().
+		lzma_block block;
+		lzma_filter filters[LZMA_FILTERS_MAX + 1];
+
+		uint8_t inbuf[16384];
+
+	public:
+		/**
+		 * Read the xz index from the end of the file.
+		 * Concatenated streams and stream padding are supported.
+		 * @return 0 on success; negative POSIX error code on error.
+		 */
+		int loadIndex(void);
+
+		/**
+		 * Free the filter options from the block header.
+		 */
+		void freeFilters(void);
+};
+
+XzReaderPrivate::XzReaderPrivate(XzReader *q)
+	: q_ptr(q)
+	, strm_init(false)
+	, block_end(false)
+	, in_pos(0)
+	, in_end(0)
+{
+	static const lzma_stream strm_init_val = LZMA_STREAM_INIT;
+	strm = strm_init_val;
+	memset(&block, 0, sizeof(block));
+	filters[0].id = LZMA_VLI_UNKNOWN;
+	filters[0].options = nullptr;
+}
+
+XzReaderPrivate::~XzReaderPrivate()
+{
+	if (strm_init) {
+		lzma_end(&strm);
+	}
+	freeFilters();
+}
+
+/**
+ * Free the filter options from the block header.
+ */
+void XzReaderPrivate::freeFilters(void)
+{
+	for (unsigned int i = 0; i < LZMA_FILTERS_MAX && filters[i].id != LZMA_VLI_UNKNOWN; i++) {
+		free(filters[i].options);
+		filters[i].options = nullptr;
+	}
+	filters[0].id = LZMA_VLI_UNKNOWN;
+}
+
+/**
+ * Read the xz index from the end of the file.
+ * Concatenated streams and stream padding are supported.
+ * @return 0 on success; negative POSIX error code on error.
+ */
+int XzReaderPrivate::loadIndex(void)
+{
+	RP_Q(XzReader);
+
+	// Streams are processed from the end of the file.
+	// Reference: xz's src/xz/list.c
+	lzma_index *combined = nullptr;
+	lzma_vli padding = 0;
+	int64_t pos = q->m_comp_size;
+	uint8_t buf[LZMA_STREAM_HEADER_SIZE];
+	vector<uint8_t> ibuf;
+	int ret = 0;
+
+	while (pos > 0) {
+		if (pos < 2*LZMA_STREAM_HEADER_SIZE) {
+			// Too small for a stream header and footer.
+			ret = -EIO;
+			break;
+		}
+
+		// Read the stream footer.
+		if (q->readCompressed(pos - LZMA_STREAM_HEADER_SIZE, buf, sizeof(buf)) != sizeof(buf)) {
+			ret = -EIO;
+			break;
+		}
+		if (buf[8] == 0 && buf[9] == 0 && buf[10] == 0 && buf[11] == 0) {
+			// Stream padding.
+			padding += 4;
+			pos -= 4;
+			continue;
+		}
+
+		lzma_stream_flags footer_flags;
+		lzma_ret lret = lzma_stream_footer_decode(&footer_flags, buf);
+		if (lret != LZMA_OK) {
+			ret = lzmaErrorToPosix(lret);
+			break;
+		}
+
+		// Read and decode the index.
+		const lzma_vli index_size = footer_flags.backward_size;
+		if (index_size > XZ_MAX_INDEX_SIZE ||
+		    static_cast<lzma_vli>(pos) < 2*LZMA_STREAM_HEADER_SIZE + index_size)
+		{
+			ret = -EIO;
+			break;
+		}
+		const int64_t index_pos = pos - LZMA_STREAM_HEADER_SIZE - static_cast<int64_t>(index_size);
+		ibuf.resize(static_cast<size_t>(index_size));
+		if (q->readCompressed(index_pos, ibuf.data(), ibuf.size()) != ibuf.size()) {
+			ret = -EIO;
+			break;
+		}
+
+		lzma_index *idx = nullptr;
+		uint64_t memlimit = UINT64_MAX;
+		size_t in_pos = 0;
+		lret = lzma_index_buffer_decode(&idx, &memlimit, nullptr, ibuf.data(), &in_pos, ibuf.size());
+		if (lret != LZMA_OK) {
+			ret = lzmaErrorToPosix(lret);
+			break;
+		}
+
+		// Verify the stream header.
+		const lzma_vli stream_size = lzma_index_stream_size(idx);
+		if (stream_size > static_cast<lzma_vli>(pos)) {
+			lzma_index_end(idx, nullptr);
+			ret = -EIO;
+			break;
+		}
+		const int64_t stream_pos = pos - static_cast<int64_t>(stream_size);
+		lzma_stream_flags header_flags;
+		if (q->readCompressed(stream_pos, buf, sizeof(buf)) != sizeof(buf) ||
+		    lzma_stream_header_decode(&header_flags, buf) != LZMA_OK ||
+		    lzma_stream_flags_compare(&header_flags, &footer_flags) != LZMA_OK)
+		{
+			lzma_index_end(idx, nullptr);
+			ret = -EIO;
+			break;
+		}
+
+		lret = lzma_index_stream_flags(idx, &footer_flags);
+		if (lret == LZMA_OK) {
+			lret = lzma_index_stream_padding(idx, padding);
+		}
+		if (lret != LZMA_OK) {
+			lzma_index_end(idx, nullptr);
+			ret = lzmaErrorToPosix(lret);
+			break;
+		}
+		padding = 0;
+
+		// Prepend this stream's index to the combined index.
+		if (combined) {
+			lret = lzma_index_cat(idx, combined, nullptr);
+			if (lret != LZMA_OK) {
+				lzma_index_end(idx, nullptr);
+				ret = lzmaErrorToPosix(lret);
+				break;
+			}
+		}
+		combined = idx;
+		pos = stream_pos;
+	}
+
+	if (ret == 0 && !combined) {
+		// No streams.
+		ret = -EIO;
+	}
+	if (ret != 0) {
+		if (combined) {
+			lzma_index_end(combined, nullptr);
+		}
+		return ret;
+	}
+
+	index.reset(combined, [](lzma_index *i) { lzma_index_end(i, nullptr); });
+	q->m_uncomp_size = static_cast<int64_t>(lzma_index_uncompressed_size(combined));
+	return 0;
+}
+
+/** XzReader **/
+
+/**
+ * Create an xz decompression reader.
+ * @param readFunc	[in] Read function for compressed data.
+ * @param opaque	[in] Opaque pointer for readFunc.
+ * @param comp_size	[in] Compressed file size.
+ *
+ * NOTE: If the xz index can't be read, isOpen() will return false.
+ */
+XzReader::XzReader(ReadFunc readFunc, void *opaque, int64_t comp_size)
+	: super(readFunc, opaque, comp_size)
+	, d_ptr(new XzReaderPrivate(this))
+{
+	RP_D(XzReader);
+	int ret = d->loadIndex();
+	if (ret != 0) {
+		m_lastError = -ret;
+	}
+}
+
+/**
+ * Create an xz decompression reader for the
+ * same compressed file as another reader.
+ * @param other		[in] Other XzReader.
+ * @param readFunc	[in] Read function for compressed data.
+ * @param opaque	[in] Opaque pointer for readFunc.
+ */
+XzReader::XzReader(const XzReader &other, ReadFunc readFunc, void *opaque)
+	: super(other, readFunc, opaque)
+	, d_ptr(new XzReaderPrivate(this))
+{
+	d_ptr->index = other.d_ptr->index;
+}
+
+XzReader::~XzReader()
+{
+	delete d_ptr;
+}
+
+/**
+ * Is the reader open?
+ * @return True if the xz index was read successfully; false if not.
+ */
+bool XzReader::isOpen(void) const
+{
+	RP_D(const XzReader);
+	return (d->index.get() != nullptr);
+}
+
+/**
+ * Create a new reader for the same compressed file.
+ * The xz index is shared with this reader.
+ * @param readFunc	[in] Read function for compressed data.
+ * @param opaque	[in] Opaque pointer for readFunc.
+ * @return New reader.
+ */
+IDecompReader *XzReader::dup(ReadFunc readFunc, void *opaque) const
+{
+	return new XzReader(*this, readFunc, opaque);
+}
+
+/**
+ * Find the last restart point at or before the specified address.
+ * @param pos	[in] Uncompressed address.
+ * @param rp	[out] Restart point.
+ */
+void XzReader::findRestartPoint(int64_t pos, RestartPoint *rp) const
+{
+	RP_D(const XzReader);
+	lzma_index_iter iter;
+	if (d->index) {
+		lzma_index_iter_init(&iter, d->index.get());
+		if (!lzma_index_iter_locate(&iter, static_cast<lzma_vli>(pos))) {
+			// Found the block.
+			rp->in = static_cast<int64_t>(iter.block.compressed_file_offset);
+			rp->out = static_cast<int64_t>(iter.block.uncompressed_file_offset);
+			return;
+		}
+	}
+
+	// Not found. Use the start of the file.
+	rp->in = 0;
+	rp->out = 0;
+}
+
+/**
+ * Restart decompression at a restart point.
+ * @param rp Restart point.
+ * @return 0 on success; negative POSIX error code on error.
+ */
+int XzReader::resetStream(const RestartPoint &rp)
+{
+	RP_D(XzReader);
+	if (!d->index) {
+		return -EBADF;
+	}
+
+	// Find the block.
+	lzma_index_iter iter;
+	lzma_index_iter_init(&iter, d->index.get());
+	if (lzma_index_iter_locate(&iter, static_cast<lzma_vli>(rp.out)) ||
+	    iter.block.compressed_file_offset != static_cast<lzma_vli>(rp.in))
+	{
+		return -EIO;
+	}
+
+	// Read and decode the block header.
+	uint8_t hdr[LZMA_BLOCK_HEADER_SIZE_MAX];
+	if (readCompressed(rp.in, hdr, 1) != 1 || hdr[0] == 0) {
+		return -EIO;
+	}
+	d->freeFilters();
+	memset(&d->block, 0, sizeof(d->block));
+	d->block.version = 0;
+	d->block.check = iter.stream.flags->check;
+	d->block.filters = d->filters;
+	d->block.header_size = lzma_block_header_size_decode(hdr[0]);
+	if (readCompressed(rp.in + 1, &hdr[1], d->block.header_size - 1) != d->block.header_size - 1) {
+		return -EIO;
+	}
+	lzma_ret lret = lzma_block_header_decode(&d->block, nullptr, hdr);
+	if (lret != LZMA_OK) {
+		d->filters[0].id = LZMA_VLI_UNKNOWN;
+		return lzmaErrorToPosix(lret);
+	}
+	lret = lzma_block_compressed_size(&d->block, iter.block.unpadded_size);
+	if (lret != LZMA_OK) {
+		return lzmaErrorToPosix(lret);
+	}
+
+	// Initialize the block decoder.
+	lret = lzma_block_decoder(&d->strm, &d->block);
+	if (lret != LZMA_OK) {
+		return lzmaErrorToPosix(lret);
+	}
+	d->strm_init = true;
+	d->strm.next_in = nullptr;
+	d->strm.avail_in = 0;
+	d->block_end = false;
+	d->in_pos = rp.in + d->block.header_size;
+	d->in_end = rp.in + static_cast<int64_t>(iter.block.total_size);
+	return 0;
+}
+
+/**
+ * Decompress data from the current block.
+ * @param out	[out] Output buffer.
+ * @param size	[in] Size of the output buffer.
+ * @return Number of bytes decompressed; 0 at the end of the block; negative POSIX error code on error.
+ */
+int64_t XzReader::decodeStream(uint8_t *out, size_t size)
+{
+	RP_D(XzReader);
+	if (d->block_end || !d->strm_init) {
+		return 0;
+	}
+
+	d->strm.next_out = out;
+	d->strm.avail_out = size;
+	while (d->strm.avail_out > 0) {
+		if (d->strm.avail_in == 0 && d->in_pos < d->in_end) {
+			// Refill the input buffer.
+			size_t to_read = sizeof(d->inbuf);
+			if (d->in_end - d->in_pos < static_cast<int64_t>(to_read)) {
+				to_read = static_cast<size_t>(d->in_end - d->in_pos);
+			}
+			const size_t sz_read = readCompressed(d->in_pos, d->inbuf, to_read);
+			if (sz_read == 0) {
+				// Truncated xz block.
+				return -EIO;
+			}
+			d->in_pos += sz_read;
+			d->strm.next_in = d->inbuf;
+			d->strm.avail_in = sz_read;
+		}
+
+		lzma_ret lret = lzma_code(&d->strm, LZMA_RUN);
+		if (lret == LZMA_STREAM_END) {
+			// End of the block.
+			d->block_end = true;
+			break;
+		} else if (lret != LZMA_OK) {
+			// Decompression error.
+			return lzmaErrorToPosix(lret);
+		}
+
+		if (d->strm.avail_out < size) {
+			// Got some data.
+			break;
+		}
+	}
+
+	return static_cast<int64_t>(size - d->strm.avail_out);
+}
+
+}
@@ -0,0 +1,123 @@
+/***************************************************************************
+ * ROM Properties Page shell extension. (librpbase)                        *
+ * XzReader.hpp: xz decompression reader.                                  *
+ *                                                                         *
+ * Copyright (c) 2016-2018 by David Korth.                                 *
+ *                                                                         *
+ * This program is free software; you can redistribute it and/or modify it *
+ * under the terms of the GNU General Public License as published by the   *
+ * Free Software Foundation; either version 2 of the License, or (at your  *
+ * option) any later version.                                              *
+ *                                                                         *
+ * This program is distributed in the hope that it will be useful, but     *
+ * WITHOUT ANY WARRANTY; without even the implied warranty of              *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the           *
+ * GNU General Public License for more details.                            *
+ *                                                                         *
+ * You should have received a copy of the GNU General Public License       *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.   *
+ ***************************************************************************/
+
+#ifndef __ROMPROPERTIES_LIBRPBASE_FILE_XZREADER_HPP__
+#define __ROMPROPERTIES_LIBRPBASE_FILE_XZREADER_HPP__
+
+#include "DecompStreamReader.hpp"
+
+namespace LibRpBase {
+
+/**
+ * xz decompression reader.
+ *
+ * The xz index at the end of each stream lists the compressed
+ * and uncompressed sizes of every block. Blocks can be decoded
+ * independently, so a seek only needs to decompress the block
+ * that contains the requested address. Files created with
+ * multi-threaded xz (or --block-size) have many small blocks;
+ * files with a single block are decompressed sequentially.
+ *
+ * The decoded index is shared between copies of the same reader.
+ */
+class XzReaderPrivate;
+class XzReader : public DecompStreamReader
+{
+	public:
+		/**
+		 * Create an xz decompression reader.
+		 * @param readFunc	[in] Read function for compressed data.
+		 * @param opaque	[in] Opaque pointer for readFunc.
+		 * @param comp_size	[in] Compressed file size.
+		 *
+		 * NOTE: If the xz index can't be read, isOpen() will return false.
+		 */
+		XzReader(ReadFunc readFunc, void *opaque, int64_t comp_size);
+
+		/**
+		 * Create an xz decompression reader for the
+		 * same compressed file as another reader.
+		 * @param other		[in] Other XzReader.
+		 * @param readFunc	[in] Read function for compressed data.
+		 * @param opaque	[in] Opaque pointer for readFunc.
+		 */
+		XzReader(const XzReader &other, ReadFunc readFunc, void *opaque);
+
+		~XzReader();
+
+	private:
+		typedef DecompStreamReader super;
+		RP_DISABLE_COPY(XzReader)
+	protected:
+		friend class XzReaderPrivate;
+		XzReaderPrivate *const d_ptr;
+
+	public:
+		/**
+		 * Is the reader open?
+		 * @return True if the xz index was read successfully; false if not.
+		 */
+		bool isOpen(void) const final;
+
+		/**
+		 * Get the compression format.
+		 * @return Compression format.
+		 */
+		Format format(void) const final
+		{
+			return FMT_XZ;
+		}
+
+		/**
+		 * Create a new reader for the same compressed file.
+		 * The xz index is shared with this reader.
+		 * @param readFunc	[in] Read function for compressed data.
+		 * @param opaque	[in] Opaque pointer for readFunc.
+		 * @return New reader.
+		 */
+		IDecompReader *dup(ReadFunc readFunc, void *opaque) const final;
+
+	protected:
+		/**
+		 * Find the last restart point at or before the specified address.
+		 * @param pos	[in] Uncompressed address.
+		 * @param rp	[out] Restart point.
+		 */
+		void findRestartPoint(int64_t pos, RestartPoint *rp) const final;
+
+		/**
+		 * Restart decompression at a restart point.
+		 * @param rp Restart point.
+		 * @return 0 on success; negative POSIX error code on error.
+		 */
+		int resetStream(const RestartPoint &rp) final;
+
+		/**
+		 * Decompress data from the current block.
+		 * @param out	[out] Output buffer.
+		 * @param size	[in] Size of the output buffer.
+		 * @return Number of bytes decompressed; 0 at the end of the block; negative POSIX error code on error.
+		 */
+		int64_t decodeStream(uint8_t *out, size_t size) final;
+};
+
+}
+
+#endif /* __ROMPROPERTIES_LIBRPBASE_FILE_XZREADER_HPP__ */
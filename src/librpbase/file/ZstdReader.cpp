@@ -0,0 +1,328 @@
+/***************************************************************************
+ * ROM Properties Page shell extension. (librpbase)                        *
+ * ZstdReader.cpp: zstd decompression reader.                              *
+ *                                                                         *
+ * Copyright (c) 2016-2018 by David Korth.                                 *
+ *                                                                         *
+ * This program is free software; you can redistribute it and/or modify it *
+ * under the terms of the GNU General Public License as published by the   *
+ * Free Software Foundation; either version 2 of the License, or (at your  *
+ * option) any later version.                                              *
+ *                                                                         *
+ * This program is distributed in the hope that it will be useful, but     *
+ * WITHOUT ANY WARRANTY; without even the implied warranty of              *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the           *
+ * GNU General Public License for more details.                            *
+ *                                                                         *
+ * You should have received a copy of the GNU General Public License       *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.   *
+ ***************************************************************************/
+
+#include "ZstdReader.hpp"
+
+// librpbase
+#include "byteswap.h"
+
+// zstd
+#include <zstd.h>
+
+// C includes. (C++ namespace)
+#include <cerrno>
+#include <cstring>
+
+// C++ includes.
+#include <algorithm>
+#include <memory>
+#include <vector>
+using std::shared_ptr;
+using std::vector;
+
+namespace LibRpBase {
+
+// Seekable format magic numbers.
+#define ZSTD_SEEKABLE_SKIPPABLE_MAGIC	0x184D2A5E
+#define ZSTD_SEEKABLE_FOOTER_MAGIC	0x8F92EAB1
+// Seek table footer size.
+#define ZSTD_SEEKABLE_FOOTER_SIZE	9
+// Maximum number of frames in the seek table.
+#define ZSTD_SEEKABLE_MAX_FRAMES	(1U << 22)
+
+/**
+ * Seek table entry.
+ * Addresses are the start of each frame.
+ */
+struct ZstdFrame {
+	int64_t in;	// Compressed address.
+	int64_t out;	// Uncompressed address.
+};
+
+/** ZstdReaderPrivate **/
+
+class ZstdReaderPrivate
+{
+	public:
+		ZstdReaderPrivate(ZstdReader *q);
+		~ZstdReaderPrivate();
+
+	private:
+		RP_DISABLE_COPY(ZstdReaderPrivate)
+		ZstdReader *const q_ptr;
+
+	public:
+		// Seek table. Empty if the file isn't seekable.
+		// Shared between copies of the same ZstdReader.
+		shared_ptr<const vector<ZstdFrame> > frames;
+
+		// Decompression state.
+		ZSTD_DCtx *dctx;
+		ZSTD_inBuffer input;
+		bool eof;		// True if the end of the compressed data was reached.
+		int64_t in_pos;		// Compressed address of the end of inbuf.
+
+		uint8_t inbuf[65536];
+
+	public:
+		/**
+		 * Load the seek table from the end of the file.
+		 * If the file isn't seekable, frames will be empty.
+		 */
+		void loadSeekTable(void);
+};
+
+ZstdReaderPrivate::ZstdReaderPrivate(ZstdReader *q)
+	: q_ptr(q)
+	, dctx(nullptr)
+	, eof(false)
+	, in_pos(0)
+{
+	input.src = inbuf;
+	input.size = 0;
+	input.pos = 0;
+}
+
+ZstdReaderPrivate::~ZstdReaderPrivate()
+{
+	if (dctx) {
+		ZSTD_freeDCtx(dctx);
+	}
+}
+
+/**
+ * Load the seek table from the end of the file.
+ * If the file isn't seekable, frames will be empty.
+ */
+void ZstdReaderPrivate::loadSeekTable(void)
+{
+	RP_Q(ZstdReader);
+	shared_ptr<vector<ZstdFrame> > table = std::make_shared<vector<ZstdFrame> >();
+	frames = table;
+
+	// Seek table footer:
+	// - Number of frames (LE32)
+	// - Descriptor (bit 7: checksums present; bits 6-2: reserved)
+	// - Footer magic (LE32)
+	const int64_t comp_size = q->m_comp_size;
+	uint8_t footer[ZSTD_SEEKABLE_FOOTER_SIZE];
+	if (comp_size < 8 + ZSTD_SEEKABLE_FOOTER_SIZE ||
+	    q->readCompressed(comp_size - sizeof(footer), footer, sizeof(footer)) != sizeof(footer))
+	{
+		return;
+	}
+
+	uint32_t u32;
+	memcpy(&u32, &footer[5], sizeof(u32));
+	if (le32_to_cpu(u32) != ZSTD_SEEKABLE_FOOTER_MAGIC || (footer[4] & 0x7C) != 0) {
+		// Not a seek table.
+		return;
+	}
+	memcpy(&u32, &footer[0], sizeof(u32));
+	const unsigned int num_frames = le32_to_cpu(u32);
+	const unsigned int entry_size = ((footer[4] & 0x80) ? 12 : 8);
+	if (num_frames == 0 || num_frames > ZSTD_SEEKABLE_MAX_FRAMES) {
+		return;
+	}
+
+	// The seek table is stored in a skippable frame.
+	const int64_t table_size = static_cast<int64_t>(num_frames) * entry_size;
+	const int64_t frame_size = 8 + table_size + ZSTD_SEEKABLE_FOOTER_SIZE;
+	if (frame_size > comp_size) {
+		return;
+	}
+	vector<uint8_t> buf(static_cast<size_t>(8 + table_size));
+	if (q->readCompressed(comp_size - frame_size, buf.data(), buf.size()) != buf.size()) {
+		return;
+	}
+	memcpy(&u32, &buf[0], sizeof(u32));
+	if (le32_to_cpu(u32) != ZSTD_SEEKABLE_SKIPPABLE_MAGIC) {
+		return;
+	}
+	memcpy(&u32, &buf[4], sizeof(u32));
+	if (le32_to_cpu(u32) != static_cast<uint32_t>(table_size + ZSTD_SEEKABLE_FOOTER_SIZE)) {
+		return;
+	}
+
+	// Convert the frame sizes to addresses.
+	table->reserve(num_frames);
+	const uint8_t *p = &buf[8];
+	ZstdFrame frame = {0, 0};
+	for (unsigned int i = 0; i < num_frames; i++, p += entry_size) {
+		table->push_back(frame);
+		uint32_t c_size, d_size;
+		memcpy(&c_size, &p[0], sizeof(c_size));
+		memcpy(&d_size, &p[4], sizeof(d_size));
+		frame.in += le32_to_cpu(c_size);
+		frame.out += le32_to_cpu(d_size);
+	}
+
+	if (frame.in != comp_size - frame_size) {
+		// Seek table doesn't match the file.
+		table->clear();
+		return;
+	}
+
+	q->m_uncomp_size = frame.out;
+}
+
+/** ZstdReader **/
+
+/**
+ * Create a zstd decompression reader.
+ * @param readFunc	[in] Read function for compressed data.
+ * @param opaque	[in] Opaque pointer for readFunc.
+ * @param comp_size	[in] Compressed file size.
+ */
+ZstdReader::ZstdReader(ReadFunc readFunc, void *opaque, int64_t comp_size)
+	: super(readFunc, opaque, comp_size)
+	, d_ptr(new ZstdReaderPrivate(this))
+{
+	RP_D(ZstdReader);
+	d->loadSeekTable();
+}
+
+/**
+ * Create a zstd decompression reader for the
+ * same compressed file as another reader.
+ * @param other		[in] Other ZstdReader.
+ * @param readFunc	[in] Read function for compressed data.
+ * @param opaque	[in] Opaque pointer for readFunc.
+ */
+ZstdReader::ZstdReader(const ZstdReader &other, ReadFunc readFunc, void *opaque)
+	: super(other, readFunc, opaque)
+	, d_ptr(new ZstdReaderPrivate(this))
+{
+	d_ptr->frames = other.d_ptr->frames;
+}
+
+ZstdReader::~ZstdReader()
+{
+	delete d_ptr;
+}
+
+/**
+ * Create a new reader for the same compressed file.
+ * The seek table is shared with this reader.
+ * @param readFunc	[in] Read function for compressed data.
+ * @param opaque	[in] Opaque pointer for readFunc.
+ * @return New reader.
+ */
+IDecompReader *ZstdReader::dup(ReadFunc readFunc, void *opaque) const
+{
+	return new ZstdReader(*this, readFunc, opaque);
+}
+
+/**
+ * Find the last restart point at or before the specified address.
+ * @param pos	[in] Uncompressed address.
+ * @param rp	[out] Restart point.
+ */
+void ZstdReader::findRestartPoint(int64_t pos, RestartPoint *rp) const
+{
+	RP_D(const ZstdReader);
+	const vector<ZstdFrame> &frames = *d->frames;
+	auto iter = std::upper_bound(frames.cbegin(), frames.cend(), pos,
+		[](int64_t pos, const ZstdFrame &frame) {
+			return (pos < frame.out);
+		});
+	if (iter != frames.cbegin()) {
+		--iter;
+		rp->in = iter->in;
+		rp->out = iter->out;
+	} else {
+		// Not seekable. Use the start of the file.
+		rp->in = 0;
+		rp->out = 0;
+	}
+}
+
+/**
+ * Restart decompression at a restart point.
+ * @param rp Restart point.
+ * @return 0 on success; negative POSIX error code on error.
+ */
+int ZstdReader::resetStream(const RestartPoint &rp)
+{
+	RP_D(ZstdReader);
+	if (!d->dctx) {
+		d->dctx = ZSTD_createDCtx();
+		if (!d->dctx) {
+			return -ENOMEM;
+		}
+	} else {
+		ZSTD_DCtx_reset(d->dctx, ZSTD_reset_session_only);
+	}
+
+	d->input.size = 0;
+	d->input.pos = 0;
+	d->eof = false;
+	d->in_pos = rp.in;
+	return 0;
+}
+
+/**
+ * Decompress data from the current block.
+ * @param out	[out] Output buffer.
+ * @param size	[in] Size of the output buffer.
+ * @return Number of bytes decompressed; 0 at the end of the block; negative POSIX error code on error.
+ */
+int64_t ZstdReader::decodeStream(uint8_t *out, size_t size)
+{
+	RP_D(ZstdReader);
+	if (d->eof || !d->dctx) {
+		return 0;
+	}
+
+	// NOTE: ZSTD_decompressStream() continues into the next
+	// frame automatically, and skippable frames (including
+	// the seek table) are ignored.
+	ZSTD_outBuffer output = {out, size, 0};
+	while (output.pos == 0) {
+		if (d->input.pos == d->input.size) {
+			// Refill the input buffer.
+			size_t to_read = sizeof(d->inbuf);
+			if (m_comp_size - d->in_pos < static_cast<int64_t>(to_read)) {
+				to_read = static_cast<size_t>(m_comp_size - d->in_pos);
+			}
+			const size_t sz_read = (to_read > 0
+				? readCompressed(d->in_pos, d->inbuf, to_read)
+				: 0);
+			if (sz_read == 0) {
+				// End of file.
+				d->eof = true;
+				break;
+			}
+			d->in_pos += sz_read;
+			d->input.size = sz_read;
+			d->input.pos = 0;
+		}
+
+		const size_t zret = ZSTD_decompressStream(d->dctx, &output, &d->input);
+		if (ZSTD_isError(zret)) {
+			// Decompression error.
+			return -EIO;
+		}
+	}
+
+	return static_cast<int64_t>(output.pos);
+}
+
+}
@@ -0,0 +1,117 @@
+/***************************************************************************
+ * ROM Properties Page shell extension. (librpbase)                        *
+ * ZstdReader.hpp: zstd decompression reader.                              *
+ *                                                                         *
+ * Copyright (c) 2016-2018 by David Korth.                                 *
+ *                                                                         *
+ * This program is free software; you can redistribute it and/or modify it *
+ * under the terms of the GNU General Public License as published by the   *
+ * Free Software Foundation; either version 2 of the License, or (at your  *
+ * option) any later version.                                              *
+ *                                                                         *
+ * This program is distributed in the hope that it will be useful, but     *
+ * WITHOUT ANY WARRANTY; without even the implied warranty of              *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the           *
+ * GNU General Public License for more details.                            *
+ *                                                                         *
+ * You should have received a copy of the GNU General Public License       *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.   *
+ ***************************************************************************/
+
+#ifndef __ROMPROPERTIES_LIBRPBASE_FILE_ZSTDREADER_HPP__
+#define __ROMPROPERTIES_LIBRPBASE_FILE_ZSTDREADER_HPP__
+
+#include "DecompStreamReader.hpp"
+
+namespace LibRpBase {
+
+/**
+ * zstd decompression reader.
+ *
+ * Files using the zstd seekable format have a seek table in
+ * a skippable frame at the end of the file, which lists the
+ * compressed and uncompressed sizes of every frame. Frames
+ * can be decoded independently, so a seek only needs to
+ * decompress the frame that contains the requested address.
+ *
+ * Other zstd files are decompressed sequentially, and size()
+ * has to decompress the entire file.
+ *
+ * Reference: https://github.com/facebook/zstd/blob/dev/contrib/seekable_format/zstd_seekable_compression_format.md
+ */
+class ZstdReaderPrivate;
+class ZstdReader : public DecompStreamReader
+{
+	public:
+		/**
+		 * Create a zstd decompression reader.
+		 * @param readFunc	[in] Read function for compressed data.
+		 * @param opaque	[in] Opaque pointer for readFunc.
+		 * @param comp_size	[in] Compressed file size.
+		 */
+		ZstdReader(ReadFunc readFunc, void *opaque, int64_t comp_size);
+
+		/**
+		 * Create a zstd decompression reader for the
+		 * same compressed file as another reader.
+		 * @param other		[in] Other ZstdReader.
+		 * @param readFunc	[in] Read function for compressed data.
+		 * @param opaque	[in] Opaque pointer for readFunc.
+		 */
+		ZstdReader(const ZstdReader &other, ReadFunc readFunc, void *opaque);
+
+		~ZstdReader();
+
+	private:
+		typedef DecompStreamReader super;
+		RP_DISABLE_COPY(ZstdReader)
+	protected:
+		friend class ZstdReaderPrivate;
+		ZstdReaderPrivate *const d_ptr;
+
+	public:
+		/**
+		 * Get the compression format.
+		 * @return Compression format.
+		 */
+		Format format(void) const final
+		{
+			return FMT_ZSTD;
+		}
+
+		/**
+		 * Create a new reader for the same compressed file.
+		 * The seek table is shared with this reader.
+		 * @param readFunc	[in] Read function for compressed data.
+		 * @param opaque	[in] Opaque pointer for readFunc.
+		 * @return New reader.
+		 */
+		IDecompReader *dup(ReadFunc readFunc, void *opaque) const final;
+
+	protected:
+		/**
+		 * Find the last restart point at or before the specified address.
+		 * @param pos	[in] Uncompressed address.
+		 * @param rp	[out] Restart point.
+		 */
+		void findRestartPoint(int64_t pos, RestartPoint *rp) const final;
+
+		/**
+		 * Restart decompression at a restart point.
+		 * @param rp Restart point.
+		 * @return 0 on success; negative POSIX error code on error.
+		 */
+		int resetStream(const RestartPoint &rp) final;
+
+		/**
+		 * Decompress data from the current block.
+		 * @param out	[out] Output buffer.
+		 * @param size	[in] Size of the output buffer.
+		 * @return Number of bytes decompressed; 0 at the end of the block; negative POSIX error code on error.
+		 */
+		int64_t decodeStream(uint8_t *out, size_t size) final;
+};
+
+}
+
+#endif /* __ROMPROPERTIES_LIBRPBASE_FILE_ZSTDREADER_HPP__ */
@@ -19,6 +19,7 @@
  ***************************************************************************/
 
 #include "../RpFile.hpp"
+#include "../IDecompReader.hpp"
 
 // librpbase
 #include "byteswap.h"
@@ -631,7 +632,7 @@ RpFile::RpFile(const RpFile &other)
 	RP_D(RpFile);
 	d->device_size = other.d_ptr->device_size;
 	d->sector_size = other.d_ptr->sector_size;
-	m_lastError = other.m_lastError;
+	m_lastError = other.lastError();
 
 	// NOTE: If the file is gzipped, we can't simply dup()
 	// the file handle because gzdopen() won't work correctly.
@@ -688,7 +689,7 @@ RpFile &RpFile::operator=(const RpFile &other)
 	d->mode = other.d_ptr->mode;
 	d->device_size = other.d_ptr->device_size;
 	d->sector_size = other.d_ptr->sector_size;
-	m_lastError = other.m_lastError;
+	m_lastError = other.lastError();
 
 	// NOTE: If the file is gzipped, we can't simply dup()
 	// the file handle because gzdopen() won't work correctly.
@@ -1004,6 +1005,20 @@ int64_t RpFile::size(void)
 	return liFileSize.QuadPart;
 }
 
+/**
+ * Get the file size, limiting the amount of work needed
+ * to determine it.
+ * @param max_size Maximum amount of data to decompress.
+ * @return File size if it's <= max_size or if it can be determined cheaply; otherwise, a lower bound larger than max_size. Negative on error.
+ */
+int64_t RpFile::sizeUpTo(int64_t max_size)
+{
+	// Only gzip is supported here, and gzip stores
+	// the uncompressed size at the end of the stream.
+	RP_UNUSED(max_size);
+	return size();
+}
+
 /**
  * Get the filename.
  * @return Filename. (May be empty if the filename is not available.)
@@ -1014,4 +1029,14 @@ string RpFile::filename(void) const
 	return d->filename;
 }
 
+/**
+ * Get the transparent decompression format.
+ * @return IDecompReader::Format, or -1 if the file data is read as-is.
+ */
+int RpFile::decompFormat(void) const
+{
+	RP_D(const RpFile);
+	return (d->gzfd ? static_cast<int>(IDecompReader::FMT_GZIP) : -1);
+}
+
 }
@@ -28,14 +28,22 @@
 // C includes.
 #include <stdint.h>
 
+// C++ includes.
+#include <algorithm>
+
 #if defined(RP_CPU_I386) || defined(RP_CPU_AMD64)
 # include "librpbase/cpuflags_x86.h"
 # define IMAGEDECODER_HAS_SSE2 1
 # define IMAGEDECODER_HAS_SSSE3 1
+# define IMAGEDECODER_HAS_SSE41 1
 #endif
 #ifdef RP_CPU_AMD64
 # define IMAGEDECODER_ALWAYS_HAS_SSE2 1
 #endif
+// AVX2 is only used on amd64.
+#if defined(HAVE_IMAGEDECODER_AVX2) && defined(RP_CPU_AMD64)
+# define IMAGEDECODER_HAS_AVX2 1
+#endif
 
 namespace LibRpBase {
 
@@ -466,6 +474,7 @@ class ImageDecoder
 
 		/**
 		 * Convert a DXT1 image to rp_image.
+		 * Standard version using regular C++ code.
 		 * S3TC palette index 3 will be interpreted as black.
 		 *
 		 * @param width Image width.
@@ -474,12 +483,14 @@ class ImageDecoder
 		 * @param img_siz Size of image data. [must be >= (w*h)/2]
 		 * @return rp_image, or nullptr on error.
 		 */
-		static rp_image *fromDXT1(int width, int height,
+		static rp_image *fromDXT1_cpp(int width, int height,
 			const uint8_t *RESTRICT img_buf, int img_siz);
 
+#ifdef IMAGEDECODER_HAS_SSE2
 		/**
 		 * Convert a DXT1 image to rp_image.
-		 * S3TC palette index 3 will be interpreted as fully transparent.
+		 * SSE2-optimized version.
+		 * S3TC palette index 3 will be interpreted as black.
 		 *
 		 * @param width Image width.
 		 * @param height Image height.
@@ -487,226 +498,984 @@ class ImageDecoder
 		 * @param img_siz Size of image data. [must be >= (w*h)/2]
 		 * @return rp_image, or nullptr on error.
 		 */
-		static rp_image *fromDXT1_A1(int width, int height,
+		static rp_image *fromDXT1_sse2(int width, int height,
 			const uint8_t *RESTRICT img_buf, int img_siz);
+#endif /* IMAGEDECODER_HAS_SSE2 */
 
+#ifdef IMAGEDECODER_HAS_SSSE3
 		/**
-		 * Convert a DXT2 image to rp_image.
+		 * Convert a DXT1 image to rp_image.
+		 * SSSE3-optimized version.
+		 * S3TC palette index 3 will be interpreted as black.
+		 *
 		 * @param width Image width.
 		 * @param height Image height.
-		 * @param img_buf DXT2 image buffer.
-		 * @param img_siz Size of image data. [must be >= (w*h)]
+		 * @param img_buf DXT1 image buffer.
+		 * @param img_siz Size of image data. [must be >= (w*h)/2]
 		 * @return rp_image, or nullptr on error.
 		 */
-		static rp_image *fromDXT2(int width, int height,
+		static rp_image *fromDXT1_ssse3(int width, int height,
 			const uint8_t *RESTRICT img_buf, int img_siz);
+#endif /* IMAGEDECODER_HAS_SSSE3 */
 
+#ifdef IMAGEDECODER_HAS_AVX2
 		/**
-		 * Convert a DXT3 image to rp_image.
+		 * Convert a DXT1 image to rp_image.
+		 * AVX2-optimized version.
+		 * S3TC palette index 3 will be interpreted as black.
+		 *
 		 * @param width Image width.
 		 * @param height Image height.
-		 * @param img_buf DXT3 image buffer.
-		 * @param img_siz Size of image data. [must be >= (w*h)]
+		 * @param img_buf DXT1 image buffer.
+		 * @param img_siz Size of image data. [must be >= (w*h)/2]
 		 * @return rp_image, or nullptr on error.
 		 */
-		static rp_image *fromDXT3(int width, int height,
+		static rp_image *fromDXT1_avx2(int width, int height,
 			const uint8_t *RESTRICT img_buf, int img_siz);
+#endif /* IMAGEDECODER_HAS_AVX2 */
 
 		/**
-		 * Convert a DXT4 image to rp_image.
+		 * Convert a DXT1 image to rp_image.
+		 * S3TC palette index 3 will be interpreted as black.
+		 *
 		 * @param width Image width.
 		 * @param height Image height.
-		 * @param img_buf DXT4 image buffer.
-		 * @param img_siz Size of image data. [must be >= (w*h)]
+		 * @param img_buf DXT1 image buffer.
+		 * @param img_siz Size of image data. [must be >= (w*h)/2]
 		 * @return rp_image, or nullptr on error.
 		 */
-		static rp_image *fromDXT4(int width, int height,
+		static IFUNC_INLINE rp_image *fromDXT1(int width, int height,
 			const uint8_t *RESTRICT img_buf, int img_siz);
 
 		/**
-		 * Convert a DXT5 image to rp_image.
+		 * Convert a DXT1 image to rp_image.
+		 * Standard version using regular C++ code.
+		 * S3TC palette index 3 will be interpreted as fully transparent.
+		 *
 		 * @param width Image width.
 		 * @param height Image height.
-		 * @param img_buf DXT5 image buffer.
-		 * @param img_siz Size of image data. [must be >= (w*h)]
+		 * @param img_buf DXT1 image buffer.
+		 * @param img_siz Size of image data. [must be >= (w*h)/2]
 		 * @return rp_image, or nullptr on error.
 		 */
-		static rp_image *fromDXT5(int width, int height,
+		static rp_image *fromDXT1_A1_cpp(int width, int height,
 			const uint8_t *RESTRICT img_buf, int img_siz);
 
+#ifdef IMAGEDECODER_HAS_SSE2
 		/**
-		 * Convert a BC4 (ATI1) image to rp_image.
-		 * Color component is Red.
+		 * Convert a DXT1 image to rp_image.
+		 * SSE2-optimized version.
+		 * S3TC palette index 3 will be interpreted as fully transparent.
 		 *
 		 * @param width Image width.
 		 * @param height Image height.
-		 * @param img_buf BC4 image buffer.
-		 * @param img_siz Size of image data. [must be >= (w*h)]
+		 * @param img_buf DXT1 image buffer.
+		 * @param img_siz Size of image data. [must be >= (w*h)/2]
 		 * @return rp_image, or nullptr on error.
 		 */
-		static rp_image *fromBC4(int width, int height,
+		static rp_image *fromDXT1_A1_sse2(int width, int height,
 			const uint8_t *RESTRICT img_buf, int img_siz);
+#endif /* IMAGEDECODER_HAS_SSE2 */
 
+#ifdef IMAGEDECODER_HAS_SSSE3
 		/**
-		 * Convert a BC5 (ATI2) image to rp_image.
-		 * Color components are Red and Green.
+		 * Convert a DXT1 image to rp_image.
+		 * SSSE3-optimized version.
+		 * S3TC palette index 3 will be interpreted as fully transparent.
 		 *
 		 * @param width Image width.
 		 * @param height Image height.
-		 * @param img_buf BC4 image buffer.
-		 * @param img_siz Size of image data. [must be >= (w*h)]
+		 * @param img_buf DXT1 image buffer.
+		 * @param img_siz Size of image data. [must be >= (w*h)/2]
 		 * @return rp_image, or nullptr on error.
 		 */
-		static rp_image *fromBC5(int width, int height,
+		static rp_image *fromDXT1_A1_ssse3(int width, int height,
 			const uint8_t *RESTRICT img_buf, int img_siz);
+#endif /* IMAGEDECODER_HAS_SSSE3 */
 
+#ifdef IMAGEDECODER_HAS_AVX2
 		/**
-		 * Convert a Red image to Luminance.
-		 * Use with fromBC4() to decode an LATC1 texture.
-		 * @param img rp_image to convert in-place.
-		 * @return 0 on success; negative POSIX error code on error.
+		 * Convert a DXT1 image to rp_image.
+		 * AVX2-optimized version.
+		 * S3TC palette index 3 will be interpreted as fully transparent.
+		 *
+		 * @param width Image width.
+		 * @param height Image height.
+		 * @param img_buf DXT1 image buffer.
+		 * @param img_siz Size of image data. [must be >= (w*h)/2]
+		 * @return rp_image, or nullptr on error.
 		 */
-		static int fromRed8ToL8(rp_image *img);
+		static rp_image *fromDXT1_A1_avx2(int width, int height,
+			const uint8_t *RESTRICT img_buf, int img_siz);
+#endif /* IMAGEDECODER_HAS_AVX2 */
 
 		/**
-		 * Convert a Red+Green image to Luminance+Alpha.
-		 * Use with fromBC5() to decode an LATC2 texture.
-		 * @param img rp_image to convert in-place.
-		 * @return 0 on success; negative POSIX error code on error.
+		 * Convert a DXT1 image to rp_image.
+		 * S3TC palette index 3 will be interpreted as fully transparent.
+		 *
+		 * @param width Image width.
+		 * @param height Image height.
+		 * @param img_buf DXT1 image buffer.
+		 * @param img_siz Size of image data. [must be >= (w*h)/2]
+		 * @return rp_image, or nullptr on error.
 		 */
-		 static int fromRG8ToLA8(rp_image *img);
-
-		/* Dreamcast */
+		static IFUNC_INLINE rp_image *fromDXT1_A1(int width, int height,
+			const uint8_t *RESTRICT img_buf, int img_siz);
 
 		/**
-		 * Convert a Dreamcast square twiddled 16-bit image to rp_image.
-		 * @param px_format 16-bit pixel format.
-		 * @param width Image width. (Maximum is 4096.)
-		 * @param height Image height. (Must be equal to width.)
-		 * @param img_buf 16-bit image buffer.
-		 * @param img_siz Size of image data. [must be >= (w*h)*2]
+		 * Convert a DXT2 image to rp_image.
+		 * @param width Image width.
+		 * @param height Image height.
+		 * @param img_buf DXT2 image buffer.
+		 * @param img_siz Size of image data. [must be >= (w*h)]
 		 * @return rp_image, or nullptr on error.
 		 */
-		static rp_image *fromDreamcastSquareTwiddled16(PixelFormat px_format,
-			int width, int height,
-			const uint16_t *RESTRICT img_buf, int img_siz);
+		static rp_image *fromDXT2(int width, int height,
+			const uint8_t *RESTRICT img_buf, int img_siz);
 
 		/**
-		 * Convert a Dreamcast vector-quantized image to rp_image.
-		 * @tparam smallVQ If true, handle this image as SmallVQ.
-		 * @param px_format Palette pixel format.
-		 * @param width Image width. (Maximum is 4096.)
-		 * @param height Image height. (Must be equal to width.)
-		 * @param img_buf VQ image buffer.
-		 * @param img_siz Size of image data. [must be >= (w*h)*2]
-		 * @param pal_buf Palette buffer.
-		 * @param pal_siz Size of palette data. [must be >= 1024*2; for SmallVQ, 64*2, 256*2, or 512*2]
+		 * Convert a DXT3 image to rp_image.
+		 * Standard version using regular C++ code.
+		 * @param width Image width.
+		 * @param height Image height.
+		 * @param img_buf DXT3 image buffer.
+		 * @param img_siz Size of image data. [must be >= (w*h)]
 		 * @return rp_image, or nullptr on error.
 		 */
-		template<bool smallVQ>
-		static rp_image *fromDreamcastVQ16(PixelFormat px_format,
-			int width, int height,
-			const uint8_t *RESTRICT img_buf, int img_siz,
-			const uint16_t *RESTRICT pal_buf, int pal_siz);
+		static rp_image *fromDXT3_cpp(int width, int height,
+			const uint8_t *RESTRICT img_buf, int img_siz);
 
+#ifdef IMAGEDECODER_HAS_SSE2
 		/**
-		 * Get the number of palette entries for Dreamcast SmallVQ textures.
-		 * TODO: constexpr?
-		 * @param width Texture width.
-		 * @return Number of palette entries.
+		 * Convert a DXT3 image to rp_image.
+		 * SSE2-optimized version.
+		 * @param width Image width.
+		 * @param height Image height.
+		 * @param img_buf DXT3 image buffer.
+		 * @param img_siz Size of image data. [must be >= (w*h)]
+		 * @return rp_image, or nullptr on error.
 		 */
-		static inline int calcDreamcastSmallVQPaletteEntries(int width);
-
-		/* ETC1 */
+		static rp_image *fromDXT3_sse2(int width, int height,
+			const uint8_t *RESTRICT img_buf, int img_siz);
+#endif /* IMAGEDECODER_HAS_SSE2 */
 
+#ifdef IMAGEDECODER_HAS_SSSE3
 		/**
-		 * Convert an ETC1 image to rp_image.
+		 * Convert a DXT3 image to rp_image.
+		 * SSSE3-optimized version.
 		 * @param width Image width.
 		 * @param height Image height.
-		 * @param img_buf ETC1 image buffer.
-		 * @param img_siz Size of image data. [must be >= (w*h)/2]
+		 * @param img_buf DXT3 image buffer.
+		 * @param img_siz Size of image data. [must be >= (w*h)]
 		 * @return rp_image, or nullptr on error.
 		 */
-		static rp_image *fromETC1(int width, int height,
+		static rp_image *fromDXT3_ssse3(int width, int height,
 			const uint8_t *RESTRICT img_buf, int img_siz);
+#endif /* IMAGEDECODER_HAS_SSSE3 */
 
+#ifdef IMAGEDECODER_HAS_AVX2
 		/**
-		 * Convert an ETC2 RGB image to rp_image.
+		 * Convert a DXT3 image to rp_image.
+		 * AVX2-optimized version.
 		 * @param width Image width.
 		 * @param height Image height.
-		 * @param img_buf ETC2 RGB image buffer.
-		 * @param img_siz Size of image data. [must be >= (w*h)/2]
+		 * @param img_buf DXT3 image buffer.
+		 * @param img_siz Size of image data. [must be >= (w*h)]
 		 * @return rp_image, or nullptr on error.
 		 */
-		static rp_image *fromETC2_RGB(int width, int height,
+		static rp_image *fromDXT3_avx2(int width, int height,
 			const uint8_t *RESTRICT img_buf, int img_siz);
+#endif /* IMAGEDECODER_HAS_AVX2 */
 
 		/**
-		 * Convert an ETC2 RGBA image to rp_image.
+		 * Convert a DXT3 image to rp_image.
 		 * @param width Image width.
 		 * @param height Image height.
-		 * @param img_buf ETC2 RGBA image buffer.
+		 * @param img_buf DXT3 image buffer.
 		 * @param img_siz Size of image data. [must be >= (w*h)]
 		 * @return rp_image, or nullptr on error.
 		 */
-		static rp_image *fromETC2_RGBA(int width, int height,
+		static IFUNC_INLINE rp_image *fromDXT3(int width, int height,
 			const uint8_t *RESTRICT img_buf, int img_siz);
 
 		/**
-		 * Convert an ETC2 RGB+A1 (punchthrough alpha) image to rp_image.
+		 * Convert a DXT4 image to rp_image.
 		 * @param width Image width.
 		 * @param height Image height.
-		 * @param img_buf ETC2 RGB+A1 image buffer.
-		 * @param img_siz Size of image data. [must be >= (w*h)/2]
+		 * @param img_buf DXT4 image buffer.
+		 * @param img_siz Size of image data. [must be >= (w*h)]
 		 * @return rp_image, or nullptr on error.
 		 */
-		static rp_image *fromETC2_RGB_A1(int width, int height,
+		static rp_image *fromDXT4(int width, int height,
 			const uint8_t *RESTRICT img_buf, int img_siz);
 
-		/* BC7 */
-
 		/**
-		 * Convert a BC7 image to rp_image.
+		 * Convert a DXT5 image to rp_image.
+		 * Standard version using regular C++ code.
 		 * @param width Image width.
 		 * @param height Image height.
-		 * @param img_buf BC7 image buffer.
+		 * @param img_buf DXT5 image buffer.
 		 * @param img_siz Size of image data. [must be >= (w*h)]
 		 * @return rp_image, or nullptr on error.
 		 */
-		static rp_image *fromBC7(int width, int height,
-			const uint8_t *img_buf, int img_siz);
-};
+		static rp_image *fromDXT5_cpp(int width, int height,
+			const uint8_t *RESTRICT img_buf, int img_siz);
 
-/**
- * Get the number of palette entries for Dreamcast SmallVQ textures.
- * TODO: constexpr?
- * @param width Texture width.
- * @return Number of palette entries.
- */
-inline int ImageDecoder::calcDreamcastSmallVQPaletteEntries(int width)
-{
-	if (width <= 16) {
-		return 64;
-	} else if (width <= 32) {
-		return 256;
-	} else if (width <= 64) {
-		return 512;
-	} else {
-		return 1024;
-	}
-}
+#ifdef IMAGEDECODER_HAS_SSE2
+		/**
+		 * Convert a DXT5 image to rp_image.
+		 * SSE2-optimized version.
+		 * @param width Image width.
+		 * @param height Image height.
+		 * @param img_buf DXT5 image buffer.
+		 * @param img_siz Size of image data. [must be >= (w*h)]
+		 * @return rp_image, or nullptr on error.
+		 */
+		static rp_image *fromDXT5_sse2(int width, int height,
+			const uint8_t *RESTRICT img_buf, int img_siz);
+#endif /* IMAGEDECODER_HAS_SSE2 */
 
-/** Dispatch functions. **/
+#ifdef IMAGEDECODER_HAS_SSSE3
+		/**
+		 * Convert a DXT5 image to rp_image.
+		 * SSSE3-optimized version.
+		 * @param width Image width.
+		 * @param height Image height.
+		 * @param img_buf DXT5 image buffer.
+		 * @param img_siz Size of image data. [must be >= (w*h)]
+		 * @return rp_image, or nullptr on error.
+		 */
+		static rp_image *fromDXT5_ssse3(int width, int height,
+			const uint8_t *RESTRICT img_buf, int img_siz);
+#endif /* IMAGEDECODER_HAS_SSSE3 */
 
-#if defined(RP_HAS_IFUNC) && defined(IMAGEDECODER_ALWAYS_HAS_SSE2)
+#ifdef IMAGEDECODER_HAS_AVX2
+		/**
+		 * Convert a DXT5 image to rp_image.
+		 * AVX2-optimized version.
+		 * @param width Image width.
+		 * @param height Image height.
+		 * @param img_buf DXT5 image buffer.
+		 * @param img_siz Size of image data. [must be >= (w*h)]
+		 * @return rp_image, or nullptr on error.
+		 */
+		static rp_image *fromDXT5_avx2(int width, int height,
+			const uint8_t *RESTRICT img_buf, int img_siz);
+#endif /* IMAGEDECODER_HAS_AVX2 */
 
-// System does support IFUNC, but it's always guaranteed to have SSE2.
-// Eliminate the IFUNC dispatch on this system.
+		/**
+		 * Convert a DXT5 image to rp_image.
+		 * @param width Image width.
+		 * @param height Image height.
+		 * @param img_buf DXT5 image buffer.
+		 * @param img_siz Size of image data. [must be >= (w*h)]
+		 * @return rp_image, or nullptr on error.
+		 */
+		static IFUNC_INLINE rp_image *fromDXT5(int width, int height,
+			const uint8_t *RESTRICT img_buf, int img_siz);
 
-/**
- * Convert a linear 16-bit RGB image to rp_image.
- * @param px_format	[in] 16-bit pixel format.
- * @param width		[in] Image width.
+		/**
+		 * Convert a BC4 (ATI1) image to rp_image.
+		 * Standard version using regular C++ code.
+		 * Color component is Red.
+		 *
+		 * @param width Image width.
+		 * @param height Image height.
+		 * @param img_buf BC4 image buffer.
+		 * @param img_siz Size of image data. [must be >= (w*h)]
+		 * @return rp_image, or nullptr on error.
+		 */
+		static rp_image *fromBC4_cpp(int width, int height,
+			const uint8_t *RESTRICT img_buf, int img_siz);
+
+#ifdef IMAGEDECODER_HAS_SSE2
+		/**
+		 * Convert a BC4 (ATI1) image to rp_image.
+		 * SSE2-optimized version.
+		 * Color component is Red.
+		 *
+		 * @param width Image width.
+		 * @param height Image height.
+		 * @param img_buf BC4 image buffer.
+		 * @param img_siz Size of image data. [must be >= (w*h)]
+		 * @return rp_image, or nullptr on error.
+		 */
+		static rp_image *fromBC4_sse2(int width, int height,
+			const uint8_t *RESTRICT img_buf, int img_siz);
+#endif /* IMAGEDECODER_HAS_SSE2 */
+
+#ifdef IMAGEDECODER_HAS_SSSE3
+		/**
+		 * Convert a BC4 (ATI1) image to rp_image.
+		 * SSSE3-optimized version.
+		 * Color component is Red.
+		 *
+		 * @param width Image width.
+		 * @param height Image height.
+		 * @param img_buf BC4 image buffer.
+		 * @param img_siz Size of image data. [must be >= (w*h)]
+		 * @return rp_image, or nullptr on error.
+		 */
+		static rp_image *fromBC4_ssse3(int width, int height,
+			const uint8_t *RESTRICT img_buf, int img_siz);
+#endif /* IMAGEDECODER_HAS_SSSE3 */
+
+#ifdef IMAGEDECODER_HAS_AVX2
+		/**
+		 * Convert a BC4 (ATI1) image to rp_image.
+		 * AVX2-optimized version.
+		 * Color component is Red.
+		 *
+		 * @param width Image width.
+		 * @param height Image height.
+		 * @param img_buf BC4 image buffer.
+		 * @param img_siz Size of image data. [must be >= (w*h)]
+		 * @return rp_image, or nullptr on error.
+		 */
+		static rp_image *fromBC4_avx2(int width, int height,
+			const uint8_t *RESTRICT img_buf, int img_siz);
+#endif /* IMAGEDECODER_HAS_AVX2 */
+
+		/**
+		 * Convert a BC4 (ATI1) image to rp_image.
+		 * Color component is Red.
+		 *
+		 * @param width Image width.
+		 * @param height Image height.
+		 * @param img_buf BC4 image buffer.
+		 * @param img_siz Size of image data. [must be >= (w*h)]
+		 * @return rp_image, or nullptr on error.
+		 */
+		static IFUNC_INLINE rp_image *fromBC4(int width, int height,
+			const uint8_t *RESTRICT img_buf, int img_siz);
+
+		/**
+		 * Convert a BC5 (ATI2) image to rp_image.
+		 * Standard version using regular C++ code.
+		 * Color components are Red and Green.
+		 *
+		 * @param width Image width.
+		 * @param height Image height.
+		 * @param img_buf BC4 image buffer.
+		 * @param img_siz Size of image data. [must be >= (w*h)]
+		 * @return rp_image, or nullptr on error.
+		 */
+		static rp_image *fromBC5_cpp(int width, int height,
+			const uint8_t *RESTRICT img_buf, int img_siz);
+
+#ifdef IMAGEDECODER_HAS_SSE2
+		/**
+		 * Convert a BC5 (ATI2) image to rp_image.
+		 * SSE2-optimized version.
+		 * Color components are Red and Green.
+		 *
+		 * @param width Image width.
+		 * @param height Image height.
+		 * @param img_buf BC4 image buffer.
+		 * @param img_siz Size of image data. [must be >= (w*h)]
+		 * @return rp_image, or nullptr on error.
+		 */
+		static rp_image *fromBC5_sse2(int width, int height,
+			const uint8_t *RESTRICT img_buf, int img_siz);
+#endif /* IMAGEDECODER_HAS_SSE2 */
+
+#ifdef IMAGEDECODER_HAS_SSSE3
+		/**
+		 * Convert a BC5 (ATI2) image to rp_image.
+		 * SSSE3-optimized version.
+		 * Color components are Red and Green.
+		 *
+		 * @param width Image width.
+		 * @param height Image height.
+		 * @param img_buf BC4 image buffer.
+		 * @param img_siz Size of image data. [must be >= (w*h)]
+		 * @return rp_image, or nullptr on error.
+		 */
+		static rp_image *fromBC5_ssse3(int width, int height,
+			const uint8_t *RESTRICT img_buf, int img_siz);
+#endif /* IMAGEDECODER_HAS_SSSE3 */
+
+#ifdef IMAGEDECODER_HAS_AVX2
+		/**
+		 * Convert a BC5 (ATI2) image to rp_image.
+		 * AVX2-optimized version.
+		 * Color components are Red and Green.
+		 *
+		 * @param width Image width.
+		 * @param height Image height.
+		 * @param img_buf BC4 image buffer.
+		 * @param img_siz Size of image data. [must be >= (w*h)]
+		 * @return rp_image, or nullptr on error.
+		 */
+		static rp_image *fromBC5_avx2(int width, int height,
+			const uint8_t *RESTRICT img_buf, int img_siz);
+#endif /* IMAGEDECODER_HAS_AVX2 */
+
+		/**
+		 * Convert a BC5 (ATI2) image to rp_image.
+		 * Color components are Red and Green.
+		 *
+		 * @param width Image width.
+		 * @param height Image height.
+		 * @param img_buf BC4 image buffer.
+		 * @param img_siz Size of image data. [must be >= (w*h)]
+		 * @return rp_image, or nullptr on error.
+		 */
+		static IFUNC_INLINE rp_image *fromBC5(int width, int height,
+			const uint8_t *RESTRICT img_buf, int img_siz);
+
+		/**
+		 * Convert a Red image to Luminance.
+		 * Use with fromBC4() to decode an LATC1 texture.
+		 * @param img rp_image to convert in-place.
+		 * @return 0 on success; negative POSIX error code on error.
+		 */
+		static int fromRed8ToL8(rp_image *img);
+
+		/**
+		 * Convert a Red+Green image to Luminance+Alpha.
+		 * Use with fromBC5() to decode an LATC2 texture.
+		 * @param img rp_image to convert in-place.
+		 * @return 0 on success; negative POSIX error code on error.
+		 */
+		 static int fromRG8ToLA8(rp_image *img);
+
+		/* Dreamcast */
+
+		/**
+		 * Convert a Dreamcast square twiddled 16-bit image to rp_image.
+		 * @param px_format 16-bit pixel format.
+		 * @param width Image width. (Maximum is 4096.)
+		 * @param height Image height. (Must be equal to width.)
+		 * @param img_buf 16-bit image buffer.
+		 * @param img_siz Size of image data. [must be >= (w*h)*2]
+		 * @return rp_image, or nullptr on error.
+		 */
+		static rp_image *fromDreamcastSquareTwiddled16(PixelFormat px_format,
+			int width, int height,
+			const uint16_t *RESTRICT img_buf, int img_siz);
+
+		/**
+		 * Convert a Dreamcast vector-quantized image to rp_image.
+		 * @tparam smallVQ If true, handle this image as SmallVQ.
+		 * @param px_format Palette pixel format.
+		 * @param width Image width. (Maximum is 4096.)
+		 * @param height Image height. (Must be equal to width.)
+		 * @param img_buf VQ image buffer.
+		 * @param img_siz Size of image data. [must be >= (w*h)*2]
+		 * @param pal_buf Palette buffer.
+		 * @param pal_siz Size of palette data. [must be >= 1024*2; for SmallVQ, 64*2, 256*2, or 512*2]
+		 * @return rp_image, or nullptr on error.
+		 */
+		template<bool smallVQ>
+		static rp_image *fromDreamcastVQ16(PixelFormat px_format,
+			int width, int height,
+			const uint8_t *RESTRICT img_buf, int img_siz,
+			const uint16_t *RESTRICT pal_buf, int pal_siz);
+
+		/**
+		 * Get the number of palette entries for Dreamcast SmallVQ textures.
+		 * TODO: constexpr?
+		 * @param width Texture width.
+		 * @return Number of palette entries.
+		 */
+		static inline int calcDreamcastSmallVQPaletteEntries(int width);
+
+		/* ETC1 */
+
+		/**
+		 * Convert an ETC1 image to rp_image.
+		 * Standard version using regular C++ code.
+		 * @param width Image width.
+		 * @param height Image height.
+		 * @param img_buf ETC1 image buffer.
+		 * @param img_siz Size of image data. [must be >= (w*h)/2]
+		 * @return rp_image, or nullptr on error.
+		 */
+		static rp_image *fromETC1_cpp(int width, int height,
+			const uint8_t *RESTRICT img_buf, int img_siz);
+
+#ifdef IMAGEDECODER_HAS_SSE41
+		/**
+		 * Convert an ETC1 image to rp_image.
+		 * SSE4.1-optimized version.
+		 * @param width Image width.
+		 * @param height Image height.
+		 * @param img_buf ETC1 image buffer.
+		 * @param img_siz Size of image data. [must be >= (w*h)/2]
+		 * @return rp_image, or nullptr on error.
+		 */
+		static rp_image *fromETC1_sse41(int width, int height,
+			const uint8_t *RESTRICT img_buf, int img_siz);
+#endif /* IMAGEDECODER_HAS_SSE41 */
+
+#ifdef IMAGEDECODER_HAS_AVX2
+		/**
+		 * Convert an ETC1 image to rp_image.
+		 * AVX2-optimized version.
+		 * @param width Image width.
+		 * @param height Image height.
+		 * @param img_buf ETC1 image buffer.
+		 * @param img_siz Size of image data. [must be >= (w*h)/2]
+		 * @return rp_image, or nullptr on error.
+		 */
+		static rp_image *fromETC1_avx2(int width, int height,
+			const uint8_t *RESTRICT img_buf, int img_siz);
+#endif /* IMAGEDECODER_HAS_AVX2 */
+
+		/**
+		 * Convert an ETC1 image to rp_image.
+		 * @param width Image width.
+		 * @param height Image height.
+		 * @param img_buf ETC1 image buffer.
+		 * @param img_siz Size of image data. [must be >= (w*h)/2]
+		 * @return rp_image, or nullptr on error.
+		 */
+		static IFUNC_INLINE rp_image *fromETC1(int width, int height,
+			const uint8_t *RESTRICT img_buf, int img_siz);
+
+		/**
+		 * Convert an ETC2 RGB image to rp_image.
+		 * Standard version using regular C++ code.
+		 * @param width Image width.
+		 * @param height Image height.
+		 * @param img_buf ETC2 RGB image buffer.
+		 * @param img_siz Size of image data. [must be >= (w*h)/2]
+		 * @return rp_image, or nullptr on error.
+		 */
+		static rp_image *fromETC2_RGB_cpp(int width, int height,
+			const uint8_t *RESTRICT img_buf, int img_siz);
+
+#ifdef IMAGEDECODER_HAS_SSE41
+		/**
+		 * Convert an ETC2 RGB image to rp_image.
+		 * SSE4.1-optimized version.
+		 * @param width Image width.
+		 * @param height Image height.
+		 * @param img_buf ETC2 RGB image buffer.
+		 * @param img_siz Size of image data. [must be >= (w*h)/2]
+		 * @return rp_image, or nullptr on error.
+		 */
+		static rp_image *fromETC2_RGB_sse41(int width, int height,
+			const uint8_t *RESTRICT img_buf, int img_siz);
+#endif /* IMAGEDECODER_HAS_SSE41 */
+
+#ifdef IMAGEDECODER_HAS_AVX2
+		/**
+		 * Convert an ETC2 RGB image to rp_image.
+		 * AVX2-optimized version.
+		 * @param width Image width.
+		 * @param height Image height.
+		 * @param img_buf ETC2 RGB image buffer.
+		 * @param img_siz Size of image data. [must be >= (w*h)/2]
+		 * @return rp_image, or nullptr on error.
+		 */
+		static rp_image *fromETC2_RGB_avx2(int width, int height,
+			const uint8_t *RESTRICT img_buf, int img_siz);
+#endif /* IMAGEDECODER_HAS_AVX2 */
+
+		/**
+		 * Convert an ETC2 RGB image to rp_image.
+		 * @param width Image width.
+		 * @param height Image height.
+		 * @param img_buf ETC2 RGB image buffer.
+		 * @param img_siz Size of image data. [must be >= (w*h)/2]
+		 * @return rp_image, or nullptr on error.
+		 */
+		static IFUNC_INLINE rp_image *fromETC2_RGB(int width, int height,
+			const uint8_t *RESTRICT img_buf, int img_siz);
+
+		/**
+		 * Convert an ETC2 RGBA image to rp_image.
+		 * Standard version using regular C++ code.
+		 * @param width Image width.
+		 * @param height Image height.
+		 * @param img_buf ETC2 RGBA image buffer.
+		 * @param img_siz Size of image data. [must be >= (w*h)]
+		 * @return rp_image, or nullptr on error.
+		 */
+		static rp_image *fromETC2_RGBA_cpp(int width, int height,
+			const uint8_t *RESTRICT img_buf, int img_siz);
+
+#ifdef IMAGEDECODER_HAS_SSE41
+		/**
+		 * Convert an ETC2 RGBA image to rp_image.
+		 * SSE4.1-optimized version.
+		 * @param width Image width.
+		 * @param height Image height.
+		 * @param img_buf ETC2 RGBA image buffer.
+		 * @param img_siz Size of image data. [must be >= (w*h)]
+		 * @return rp_image, or nullptr on error.
+		 */
+		static rp_image *fromETC2_RGBA_sse41(int width, int height,
+			const uint8_t *RESTRICT img_buf, int img_siz);
+#endif /* IMAGEDECODER_HAS_SSE41 */
+
+#ifdef IMAGEDECODER_HAS_AVX2
+		/**
+		 * Convert an ETC2 RGBA image to rp_image.
+		 * AVX2-optimized version.
+		 * @param width Image width.
+		 * @param height Image height.
+		 * @param img_buf ETC2 RGBA image buffer.
+		 * @param img_siz Size of image data. [must be >= (w*h)]
+		 * @return rp_image, or nullptr on error.
+		 */
+		static rp_image *fromETC2_RGBA_avx2(int width, int height,
+			const uint8_t *RESTRICT img_buf, int img_siz);
+#endif /* IMAGEDECODER_HAS_AVX2 */
+
+		/**
+		 * Convert an ETC2 RGBA image to rp_image.
+		 * @param width Image width.
+		 * @param height Image height.
+		 * @param img_buf ETC2 RGBA image buffer.
+		 * @param img_siz Size of image data. [must be >= (w*h)]
+		 * @return rp_image, or nullptr on error.
+		 */
+		static IFUNC_INLINE rp_image *fromETC2_RGBA(int width, int height,
+			const uint8_t *RESTRICT img_buf, int img_siz);
+
+		/**
+		 * Convert an ETC2 RGB+A1 (punchthrough alpha) image to rp_image.
+		 * Standard version using regular C++ code.
+		 * @param width Image width.
+		 * @param height Image height.
+		 * @param img_buf ETC2 RGB+A1 image buffer.
+		 * @param img_siz Size of image data. [must be >= (w*h)/2]
+		 * @return rp_image, or nullptr on error.
+		 */
+		static rp_image *fromETC2_RGB_A1_cpp(int width, int height,
+			const uint8_t *RESTRICT img_buf, int img_siz);
+
+#ifdef IMAGEDECODER_HAS_SSE41
+		/**
+		 * Convert an ETC2 RGB+A1 (punchthrough alpha) image to rp_image.
+		 * SSE4.1-optimized version.
+		 * @param width Image width.
+		 * @param height Image height.
+		 * @param img_buf ETC2 RGB+A1 image buffer.
+		 * @param img_siz Size of image data. [must be >= (w*h)/2]
+		 * @return rp_image, or nullptr on error.
+		 */
+		static rp_image *fromETC2_RGB_A1_sse41(int width, int height,
+			const uint8_t *RESTRICT img_buf, int img_siz);
+#endif /* IMAGEDECODER_HAS_SSE41 */
+
+#ifdef IMAGEDECODER_HAS_AVX2
+		/**
+		 * Convert an ETC2 RGB+A1 (punchthrough alpha) image to rp_image.
+		 * AVX2-optimized version.
+		 * @param width Image width.
+		 * @param height Image height.
+		 * @param img_buf ETC2 RGB+A1 image buffer.
+		 * @param img_siz Size of image data. [must be >= (w*h)/2]
+		 * @return rp_image, or nullptr on error.
+		 */
+		static rp_image *fromETC2_RGB_A1_avx2(int width, int height,
+			const uint8_t *RESTRICT img_buf, int img_siz);
+#endif /* IMAGEDECODER_HAS_AVX2 */
+
+		/**
+		 * Convert an ETC2 RGB+A1 (punchthrough alpha) image to rp_image.
+		 * @param width Image width.
+		 * @param height Image height.
+		 * @param img_buf ETC2 RGB+A1 image buffer.
+		 * @param img_siz Size of image data. [must be >= (w*h)/2]
+		 * @return rp_image, or nullptr on error.
+		 */
+		static IFUNC_INLINE rp_image *fromETC2_RGB_A1(int width, int height,
+			const uint8_t *RESTRICT img_buf, int img_siz);
+
+		/* BC7 */
+
+		/**
+		 * Convert a BC7 image to rp_image.
+		 * Standard version using regular C++ code.
+		 * @param width Image width.
+		 * @param height Image height.
+		 * @param img_buf BC7 image buffer.
+		 * @param img_siz Size of image data. [must be >= (w*h)]
+		 * @return rp_image, or nullptr on error.
+		 */
+		static rp_image *fromBC7_cpp(int width, int height,
+			const uint8_t *RESTRICT img_buf, int img_siz);
+
+#ifdef IMAGEDECODER_HAS_SSE2
+		/**
+		 * Convert a BC7 image to rp_image.
+		 * SSE2-optimized version.
+		 * @param width Image width.
+		 * @param height Image height.
+		 * @param img_buf BC7 image buffer.
+		 * @param img_siz Size of image data. [must be >= (w*h)]
+		 * @return rp_image, or nullptr on error.
+		 */
+		static rp_image *fromBC7_sse2(int width, int height,
+			const uint8_t *RESTRICT img_buf, int img_siz);
+#endif /* IMAGEDECODER_HAS_SSE2 */
+
+#ifdef IMAGEDECODER_HAS_SSSE3
+		/**
+		 * Convert a BC7 image to rp_image.
+		 * SSSE3-optimized version.
+		 * @param width Image width.
+		 * @param height Image height.
+		 * @param img_buf BC7 image buffer.
+		 * @param img_siz Size of image data. [must be >= (w*h)]
+		 * @return rp_image, or nullptr on error.
+		 */
+		static rp_image *fromBC7_ssse3(int width, int height,
+			const uint8_t *RESTRICT img_buf, int img_siz);
+#endif /* IMAGEDECODER_HAS_SSSE3 */
+
+		/**
+		 * Convert a BC7 image to rp_image.
+		 * @param width Image width.
+		 * @param height Image height.
+		 * @param img_buf BC7 image buffer.
+		 * @param img_siz Size of image data. [must be >= (w*h)]
+		 * @return rp_image, or nullptr on error.
+		 */
+		static IFUNC_INLINE rp_image *fromBC7(int width, int height,
+			const uint8_t *RESTRICT img_buf, int img_siz);
+
+		/** Region-of-interest and reduced-resolution decoding **/
+
+		/**
+		 * Block-compressed image formats.
+		 * All of these formats use 4x4 blocks.
+		 */
+		enum BlockFormat {
+			BLOCK_DXT1,		// DXT1 (BC1), opaque
+			BLOCK_DXT1_A1,		// DXT1 (BC1) with 1-bit alpha
+			BLOCK_DXT2,		// DXT2 (premultiplied DXT3)
+			BLOCK_DXT3,		// DXT3 (BC2)
+			BLOCK_DXT4,		// DXT4 (premultiplied DXT5)
+			BLOCK_DXT5,		// DXT5 (BC3)
+			BLOCK_BC4,		// BC4 (ATI1)
+			BLOCK_BC5,		// BC5 (ATI2)
+			BLOCK_BC7,		// BC7
+			BLOCK_ETC1,		// ETC1
+			BLOCK_ETC2_RGB,		// ETC2 RGB
+			BLOCK_ETC2_RGBA,		// ETC2 RGBA
+			BLOCK_ETC2_RGB_A1,	// ETC2 RGB with 1-bit alpha
+
+			BLOCK_MAX
+		};
+
+		/**
+		 * Get the size of one 4x4 block for a block-compressed format.
+		 * @param fmt Block format.
+		 * @return Block size, in bytes. (8 or 16; 0 if invalid)
+		 */
+		static unsigned int blockFormatSize(BlockFormat fmt);
+
+		/**
+		 * Convert a block-compressed image to rp_image.
+		 * This calls the decoder function for the specified format.
+		 * @param fmt		[in] Block format.
+		 * @param width		[in] Image width.
+		 * @param height	[in] Image height.
+		 * @param img_buf	[in] Image buffer.
+		 * @param img_siz	[in] Size of image data.
+		 * @return rp_image, or nullptr on error.
+		 */
+		static rp_image *fromBlocks(BlockFormat fmt, int width, int height,
+			const uint8_t *RESTRICT img_buf, int img_siz);
+
+		/**
+		 * Select a reduction level for a requested image size.
+		 *
+		 * Returns the highest level, i.e. the largest power-of-two
+		 * reduction, where the larger dimension is still at least
+		 * req_size and neither dimension is reduced to zero.
+		 *
+		 * @param width		[in] Full-size image width.
+		 * @param height	[in] Full-size image height.
+		 * @param req_size	[in] Requested image size. (<= 0 for full size)
+		 * @param maxLevel	[in] Maximum level.
+		 * @return Level, or 0 for the full-size image.
+		 */
+		static inline int selectReduceLevel(int width, int height,
+			int req_size, int maxLevel);
+
+		/**
+		 * Select the mipmap level to decode for a reduction level.
+		 *
+		 * Returns the highest mipmap level, up to level, whose
+		 * dimensions are multiples of align. The rest of the
+		 * reduction is done while decoding the mipmap.
+		 *
+		 * @param width		[in] Full-size image width.
+		 * @param height	[in] Full-size image height.
+		 * @param level		[in] Reduction level from selectReduceLevel().
+		 * @param maxMipmap	[in] Highest mipmap level in the file.
+		 * @param align		[in] Required dimension alignment. (4 for 4x4 blocks)
+		 * @return Mipmap level, or 0 for the full-size image.
+		 */
+		static inline int selectMipmapLevel(int width, int height,
+			int level, int maxMipmap, int align = 1);
+
+		/**
+		 * Convert a rectangular region of a block-compressed image to rp_image.
+		 * Only the blocks that intersect the region are decoded.
+		 * The region is expanded to 4x4 block boundaries.
+		 * @param fmt		[in] Block format.
+		 * @param width		[in] Image width.
+		 * @param height	[in] Image height.
+		 * @param img_buf	[in] Image buffer.
+		 * @param img_siz	[in] Size of image data.
+		 * @param x		[in] Region X position.
+		 * @param y		[in] Region Y position.
+		 * @param w		[in] Region width.
+		 * @param h		[in] Region height.
+		 * @return rp_image, or nullptr on error.
+		 */
+		static rp_image *fromBlocksRect(BlockFormat fmt,
+			int width, int height,
+			const uint8_t *RESTRICT img_buf, int img_siz,
+			int x, int y, int w, int h);
+
+		/**
+		 * Convert a block-compressed image to rp_image at a reduced resolution.
+		 *
+		 * The image is decoded one row of blocks at a time, and each row
+		 * is box-filtered into the destination image. The full-size image
+		 * is never allocated, so this uses much less memory than decoding
+		 * the full image and rescaling it.
+		 *
+		 * Color channels are weighted by alpha in order to prevent
+		 * transparent pixels from bleeding into the reduced image.
+		 *
+		 * @param fmt		[in] Block format.
+		 * @param width		[in] Image width.
+		 * @param height	[in] Image height.
+		 * @param img_buf	[in] Image buffer.
+		 * @param img_siz	[in] Size of image data.
+		 * @param level		[in] Reduction level. (Image is reduced by 2^level.)
+		 * @return rp_image, or nullptr on error.
+		 */
+		static rp_image *fromBlocksReduced(BlockFormat fmt,
+			int width, int height,
+			const uint8_t *RESTRICT img_buf, int img_siz,
+			int level);
+
+		/**
+		 * Convert a block-compressed image to rp_image at a reduced resolution.
+		 *
+		 * Same as above, but the output size can be any size up to
+		 * the image size. If the image size isn't a multiple of the
+		 * output size, the boxes differ in size by at most one pixel.
+		 *
+		 * @param fmt		[in] Block format.
+		 * @param width		[in] Image width.
+		 * @param height	[in] Image height.
+		 * @param img_buf	[in] Image buffer.
+		 * @param img_siz	[in] Size of image data.
+		 * @param out_w		[in] Output width.
+		 * @param out_h		[in] Output height.
+		 * @return rp_image, or nullptr on error.
+		 */
+		static rp_image *fromBlocksReduced(BlockFormat fmt,
+			int width, int height,
+			const uint8_t *RESTRICT img_buf, int img_siz,
+			int out_w, int out_h);
+};
+
+/**
+ * Select a reduction level for a requested image size.
+ *
+ * Returns the highest level, i.e. the largest power-of-two
+ * reduction, where the larger dimension is still at least
+ * req_size and neither dimension is reduced to zero.
+ *
+ * @param width		[in] Full-size image width.
+ * @param height	[in] Full-size image height.
+ * @param req_size	[in] Requested image size. (<= 0 for full size)
+ * @param maxLevel	[in] Maximum level.
+ * @return Level, or 0 for the full-size image.
+ */
+inline int ImageDecoder::selectReduceLevel(int width, int height,
+	int req_size, int maxLevel)
+{
+	if (req_size <= 0 || width <= 0 || height <= 0) {
+		// Full-size image.
+		return 0;
+	}
+
+	int level = 0;
+	while (level < maxLevel) {
+		const int w = width >> (level + 1);
+		const int h = height >> (level + 1);
+		if (std::max(w, h) < req_size || w <= 0 || h <= 0) {
+			// Next level is too small.
+			break;
+		}
+		level++;
+	}
+	return level;
+}
+
+/**
+ * Select the mipmap level to decode for a reduction level.
+ *
+ * Returns the highest mipmap level, up to level, whose
+ * dimensions are multiples of align. The rest of the
+ * reduction is done while decoding the mipmap.
+ *
+ * @param width		[in] Full-size image width.
+ * @param height	[in] Full-size image height.
+ * @param level		[in] Reduction level from selectReduceLevel().
+ * @param maxMipmap	[in] Highest mipmap level in the file.
+ * @param align		[in] Required dimension alignment. (4 for 4x4 blocks)
+ * @return Mipmap level, or 0 for the full-size image.
+ */
+inline int ImageDecoder::selectMipmapLevel(int width, int height,
+	int level, int maxMipmap, int align)
+{
+	int mip = std::min(level, maxMipmap);
+	for (; mip > 0; mip--) {
+		const int w = width >> mip;
+		const int h = height >> mip;
+		if (w > 0 && h > 0 && (w % align) == 0 && (h % align) == 0) {
+			// Found a usable mipmap.
+			break;
+		}
+	}
+	return mip;
+}
+
+/**
+ * Get the number of palette entries for Dreamcast SmallVQ textures.
+ * TODO: constexpr?
+ * @param width Texture width.
+ * @return Number of palette entries.
+ */
+inline int ImageDecoder::calcDreamcastSmallVQPaletteEntries(int width)
+{
+	if (width <= 16) {
+		return 64;
+	} else if (width <= 32) {
+		return 256;
+	} else if (width <= 64) {
+		return 512;
+	} else {
+		return 1024;
+	}
+}
+
+/** Dispatch functions. **/
+
+#if defined(RP_HAS_IFUNC) && defined(IMAGEDECODER_ALWAYS_HAS_SSE2)
+
+// System does support IFUNC, but it's always guaranteed to have SSE2.
+// Eliminate the IFUNC dispatch on this system.
+
+/**
+ * Convert a linear 16-bit RGB image to rp_image.
+ * @param px_format	[in] 16-bit pixel format.
+ * @param width		[in] Image width.
  * @param height	[in] Image height.
  * @param img_buf	[in] Image buffer.
  * @param img_siz	[in] Size of image data. [must be >= (w*h)*3]
@@ -805,6 +1574,326 @@ inline rp_image *ImageDecoder::fromLinear32(PixelFormat px_format,
 	}
 }
 
+/**
+ * Convert a DXT1 image to rp_image.
+ * S3TC palette index 3 will be interpreted as black.
+ *
+ * @param width Image width.
+ * @param height Image height.
+ * @param img_buf DXT1 image buffer.
+ * @param img_siz Size of image data. [must be >= (w*h)/2]
+ * @return rp_image, or nullptr on error.
+ */
+inline rp_image *ImageDecoder::fromDXT1(int width, int height,
+	const uint8_t *RESTRICT img_buf, int img_siz)
+{
+#ifdef IMAGEDECODER_HAS_AVX2
+	if (RP_CPU_HasAVX2()) {
+		return fromDXT1_avx2(width, height, img_buf, img_siz);
+	} else
+#endif /* IMAGEDECODER_HAS_AVX2 */
+#ifdef IMAGEDECODER_HAS_SSSE3
+	if (RP_CPU_HasSSSE3()) {
+		return fromDXT1_ssse3(width, height, img_buf, img_siz);
+	} else
+#endif /* IMAGEDECODER_HAS_SSSE3 */
+#ifdef IMAGEDECODER_HAS_SSE2
+	if (RP_CPU_HasSSE2()) {
+		return fromDXT1_sse2(width, height, img_buf, img_siz);
+	} else
+#endif /* IMAGEDECODER_HAS_SSE2 */
+	{
+		return fromDXT1_cpp(width, height, img_buf, img_siz);
+	}
+}
+
+/**
+ * Convert a DXT1 image to rp_image.
+ * S3TC palette index 3 will be interpreted as fully transparent.
+ *
+ * @param width Image width.
+ * @param height Image height.
+ * @param img_buf DXT1 image buffer.
+ * @param img_siz Size of image data. [must be >= (w*h)/2]
+ * @return rp_image, or nullptr on error.
+ */
+inline rp_image *ImageDecoder::fromDXT1_A1(int width, int height,
+	const uint8_t *RESTRICT img_buf, int img_siz)
+{
+#ifdef IMAGEDECODER_HAS_AVX2
+	if (RP_CPU_HasAVX2()) {
+		return fromDXT1_A1_avx2(width, height, img_buf, img_siz);
+	} else
+#endif /* IMAGEDECODER_HAS_AVX2 */
+#ifdef IMAGEDECODER_HAS_SSSE3
+	if (RP_CPU_HasSSSE3()) {
+		return fromDXT1_A1_ssse3(width, height, img_buf, img_siz);
+	} else
+#endif /* IMAGEDECODER_HAS_SSSE3 */
+#ifdef IMAGEDECODER_HAS_SSE2
+	if (RP_CPU_HasSSE2()) {
+		return fromDXT1_A1_sse2(width, height, img_buf, img_siz);
+	} else
+#endif /* IMAGEDECODER_HAS_SSE2 */
+	{
+		return fromDXT1_A1_cpp(width, height, img_buf, img_siz);
+	}
+}
+
+/**
+ * Convert a DXT3 image to rp_image.
+ * @param width Image width.
+ * @param height Image height.
+ * @param img_buf DXT3 image buffer.
+ * @param img_siz Size of image data. [must be >= (w*h)]
+ * @return rp_image, or nullptr on error.
+ */
+inline rp_image *ImageDecoder::fromDXT3(int width, int height,
+	const uint8_t *RESTRICT img_buf, int img_siz)
+{
+#ifdef IMAGEDECODER_HAS_AVX2
+	if (RP_CPU_HasAVX2()) {
+		return fromDXT3_avx2(width, height, img_buf, img_siz);
+	} else
+#endif /* IMAGEDECODER_HAS_AVX2 */
+#ifdef IMAGEDECODER_HAS_SSSE3
+	if (RP_CPU_HasSSSE3()) {
+		return fromDXT3_ssse3(width, height, img_buf, img_siz);
+	} else
+#endif /* IMAGEDECODER_HAS_SSSE3 */
+#ifdef IMAGEDECODER_HAS_SSE2
+	if (RP_CPU_HasSSE2()) {
+		return fromDXT3_sse2(width, height, img_buf, img_siz);
+	} else
+#endif /* IMAGEDECODER_HAS_SSE2 */
+	{
+		return fromDXT3_cpp(width, height, img_buf, img_siz);
+	}
+}
+
+/**
+ * Convert a DXT5 image to rp_image.
+ * @param width Image width.
+ * @param height Image height.
+ * @param img_buf DXT5 image buffer.
+ * @param img_siz Size of image data. [must be >= (w*h)]
+ * @return rp_image, or nullptr on error.
+ */
+inline rp_image *ImageDecoder::fromDXT5(int width, int height,
+	const uint8_t *RESTRICT img_buf, int img_siz)
+{
+#ifdef IMAGEDECODER_HAS_AVX2
+	if (RP_CPU_HasAVX2()) {
+		return fromDXT5_avx2(width, height, img_buf, img_siz);
+	} else
+#endif /* IMAGEDECODER_HAS_AVX2 */
+#ifdef IMAGEDECODER_HAS_SSSE3
+	if (RP_CPU_HasSSSE3()) {
+		return fromDXT5_ssse3(width, height, img_buf, img_siz);
+	} else
+#endif /* IMAGEDECODER_HAS_SSSE3 */
+#ifdef IMAGEDECODER_HAS_SSE2
+	if (RP_CPU_HasSSE2()) {
+		return fromDXT5_sse2(width, height, img_buf, img_siz);
+	} else
+#endif /* IMAGEDECODER_HAS_SSE2 */
+	{
+		return fromDXT5_cpp(width, height, img_buf, img_siz);
+	}
+}
+
+/**
+ * Convert a BC4 (ATI1) image to rp_image.
+ * @param width Image width.
+ * @param height Image height.
+ * @param img_buf BC4 image buffer.
+ * @param img_siz Size of image data. [must be >= (w*h)/2]
+ * @return rp_image, or nullptr on error.
+ */
+inline rp_image *ImageDecoder::fromBC4(int width, int height,
+	const uint8_t *RESTRICT img_buf, int img_siz)
+{
+#ifdef IMAGEDECODER_HAS_AVX2
+	if (RP_CPU_HasAVX2()) {
+		return fromBC4_avx2(width, height, img_buf, img_siz);
+	} else
+#endif /* IMAGEDECODER_HAS_AVX2 */
+#ifdef IMAGEDECODER_HAS_SSSE3
+	if (RP_CPU_HasSSSE3()) {
+		return fromBC4_ssse3(width, height, img_buf, img_siz);
+	} else
+#endif /* IMAGEDECODER_HAS_SSSE3 */
+#ifdef IMAGEDECODER_HAS_SSE2
+	if (RP_CPU_HasSSE2()) {
+		return fromBC4_sse2(width, height, img_buf, img_siz);
+	} else
+#endif /* IMAGEDECODER_HAS_SSE2 */
+	{
+		return fromBC4_cpp(width, height, img_buf, img_siz);
+	}
+}
+
+/**
+ * Convert a BC5 (ATI2) image to rp_image.
+ * @param width Image width.
+ * @param height Image height.
+ * @param img_buf BC5 image buffer.
+ * @param img_siz Size of image data. [must be >= (w*h)]
+ * @return rp_image, or nullptr on error.
+ */
+inline rp_image *ImageDecoder::fromBC5(int width, int height,
+	const uint8_t *RESTRICT img_buf, int img_siz)
+{
+#ifdef IMAGEDECODER_HAS_AVX2
+	if (RP_CPU_HasAVX2()) {
+		return fromBC5_avx2(width, height, img_buf, img_siz);
+	} else
+#endif /* IMAGEDECODER_HAS_AVX2 */
+#ifdef IMAGEDECODER_HAS_SSSE3
+	if (RP_CPU_HasSSSE3()) {
+		return fromBC5_ssse3(width, height, img_buf, img_siz);
+	} else
+#endif /* IMAGEDECODER_HAS_SSSE3 */
+#ifdef IMAGEDECODER_HAS_SSE2
+	if (RP_CPU_HasSSE2()) {
+		return fromBC5_sse2(width, height, img_buf, img_siz);
+	} else
+#endif /* IMAGEDECODER_HAS_SSE2 */
+	{
+		return fromBC5_cpp(width, height, img_buf, img_siz);
+	}
+}
+
+/**
+ * Convert a BC7 image to rp_image.
+ * @param width Image width.
+ * @param height Image height.
+ * @param img_buf BC7 image buffer.
+ * @param img_siz Size of image data. [must be >= (w*h)]
+ * @return rp_image, or nullptr on error.
+ */
+inline rp_image *ImageDecoder::fromBC7(int width, int height,
+	const uint8_t *RESTRICT img_buf, int img_siz)
+{
+#ifdef IMAGEDECODER_HAS_SSSE3
+	if (RP_CPU_HasSSSE3()) {
+		return fromBC7_ssse3(width, height, img_buf, img_siz);
+	} else
+#endif /* IMAGEDECODER_HAS_SSSE3 */
+#ifdef IMAGEDECODER_HAS_SSE2
+	if (RP_CPU_HasSSE2()) {
+		return fromBC7_sse2(width, height, img_buf, img_siz);
+	} else
+#endif /* IMAGEDECODER_HAS_SSE2 */
+	{
+		return fromBC7_cpp(width, height, img_buf, img_siz);
+	}
+}
+
+/**
+ * Convert an ETC1 image to rp_image.
+ * @param width Image width.
+ * @param height Image height.
+ * @param img_buf ETC1 image buffer.
+ * @param img_siz Size of image data. [must be >= (w*h)/2]
+ * @return rp_image, or nullptr on error.
+ */
+inline rp_image *ImageDecoder::fromETC1(int width, int height,
+	const uint8_t *RESTRICT img_buf, int img_siz)
+{
+#ifdef IMAGEDECODER_HAS_AVX2
+	if (RP_CPU_HasAVX2()) {
+		return fromETC1_avx2(width, height, img_buf, img_siz);
+	} else
+#endif /* IMAGEDECODER_HAS_AVX2 */
+#ifdef IMAGEDECODER_HAS_SSE41
+	if (RP_CPU_HasSSE41()) {
+		return fromETC1_sse41(width, height, img_buf, img_siz);
+	} else
+#endif /* IMAGEDECODER_HAS_SSE41 */
+	{
+		return fromETC1_cpp(width, height, img_buf, img_siz);
+	}
+}
+
+/**
+ * Convert an ETC2 RGB image to rp_image.
+ * @param width Image width.
+ * @param height Image height.
+ * @param img_buf ETC2 RGB image buffer.
+ * @param img_siz Size of image data. [must be >= (w*h)/2]
+ * @return rp_image, or nullptr on error.
+ */
+inline rp_image *ImageDecoder::fromETC2_RGB(int width, int height,
+	const uint8_t *RESTRICT img_buf, int img_siz)
+{
+#ifdef IMAGEDECODER_HAS_AVX2
+	if (RP_CPU_HasAVX2()) {
+		return fromETC2_RGB_avx2(width, height, img_buf, img_siz);
+	} else
+#endif /* IMAGEDECODER_HAS_AVX2 */
+#ifdef IMAGEDECODER_HAS_SSE41
+	if (RP_CPU_HasSSE41()) {
+		return fromETC2_RGB_sse41(width, height, img_buf, img_siz);
+	} else
+#endif /* IMAGEDECODER_HAS_SSE41 */
+	{
+		return fromETC2_RGB_cpp(width, height, img_buf, img_siz);
+	}
+}
+
+/**
+ * Convert an ETC2 RGBA image to rp_image.
+ * @param width Image width.
+ * @param height Image height.
+ * @param img_buf ETC2 RGBA image buffer.
+ * @param img_siz Size of image data. [must be >= (w*h)]
+ * @return rp_image, or nullptr on error.
+ */
+inline rp_image *ImageDecoder::fromETC2_RGBA(int width, int height,
+	const uint8_t *RESTRICT img_buf, int img_siz)
+{
+#ifdef IMAGEDECODER_HAS_AVX2
+	if (RP_CPU_HasAVX2()) {
+		return fromETC2_RGBA_avx2(width, height, img_buf, img_siz);
+	} else
+#endif /* IMAGEDECODER_HAS_AVX2 */
+#ifdef IMAGEDECODER_HAS_SSE41
+	if (RP_CPU_HasSSE41()) {
+		return fromETC2_RGBA_sse41(width, height, img_buf, img_siz);
+	} else
+#endif /* IMAGEDECODER_HAS_SSE41 */
+	{
+		return fromETC2_RGBA_cpp(width, height, img_buf, img_siz);
+	}
+}
+
+/**
+ * Convert an ETC2 RGB+A1 (punchthrough alpha) image to rp_image.
+ * @param width Image width.
+ * @param height Image height.
+ * @param img_buf ETC2 RGB+A1 image buffer.
+ * @param img_siz Size of image data. [must be >= (w*h)/2]
+ * @return rp_image, or nullptr on error.
+ */
+inline rp_image *ImageDecoder::fromETC2_RGB_A1(int width, int height,
+	const uint8_t *RESTRICT img_buf, int img_siz)
+{
+#ifdef IMAGEDECODER_HAS_AVX2
+	if (RP_CPU_HasAVX2()) {
+		return fromETC2_RGB_A1_avx2(width, height, img_buf, img_siz);
+	} else
+#endif /* IMAGEDECODER_HAS_AVX2 */
+#ifdef IMAGEDECODER_HAS_SSE41
+	if (RP_CPU_HasSSE41()) {
+		return fromETC2_RGB_A1_sse41(width, height, img_buf, img_siz);
+	} else
+#endif /* IMAGEDECODER_HAS_SSE41 */
+	{
+		return fromETC2_RGB_A1_cpp(width, height, img_buf, img_siz);
+	}
+}
+
 #endif /* !defined(RP_HAS_IFUNC) || (!defined(RP_CPU_I386) && !defined(RP_CPU_AMD64)) */
 
 }
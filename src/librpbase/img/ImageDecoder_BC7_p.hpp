@@ -0,0 +1,556 @@
+/***************************************************************************
+ * ROM Properties Page shell extension. (librpbase)                        *
+ * ImageDecoder_BC7_p.hpp: Image decoding functions. (BC7)                 *
+ * Mode-specialized block decoder templates.                               *
+ *                                                                         *
+ * Copyright (c) 2016-2019 by David Korth.                                 *
+ *                                                                         *
+ * This program is free software; you can redistribute it and/or modify it *
+ * under the terms of the GNU General Public License as published by the   *
+ * Free Software Foundation; either version 2 of the License, or (at your  *
+ * option) any later version.                                              *
+ *                                                                         *
+ * This program is distributed in the hope that it will be useful, but     *
+ * WITHOUT ANY WARRANTY; without even the implied warranty of              *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the           *
+ * GNU General Public License for more details.                            *
+ *                                                                         *
+ * You should have received a copy of the GNU General Public License       *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.   *
+ ***************************************************************************/
+
+#ifndef __ROMPROPERTIES_LIBRPBASE_IMG_IMAGEDECODER_BC7_P_HPP__
+#define __ROMPROPERTIES_LIBRPBASE_IMG_IMAGEDECODER_BC7_P_HPP__
+
+#include "ImageDecoder_p.hpp"
+
+// C++ includes.
+#include <algorithm>
+
+// References:
+// - https://msdn.microsoft.com/en-us/library/windows/desktop/hh308953(v=vs.85).aspx
+// - https://msdn.microsoft.com/en-us/library/windows/desktop/hh308954(v=vs.85).aspx
+
+// NOTE: This file is included by multiple source files that are
+// compiled with different CPU flags. Everything that generates
+// code must depend on the Ops template parameter so the linker
+// doesn't merge functions built for different instruction sets.
+
+namespace LibRpBase {
+
+/**
+ * BC7 block mode properties.
+ * Field sizes are listed in bitstream order.
+ * @tparam Mode	Block mode.
+ * @tparam NS	Number of subsets. (1-3)
+ * @tparam PB	Partition bits.
+ * @tparam RB	Rotation bits.
+ * @tparam ISB	Index selection bits.
+ * @tparam CB	Color bits per endpoint component.
+ * @tparam AB	Alpha bits per endpoint.
+ * @tparam EPB	P-bits per endpoint.
+ * @tparam SPB	P-bits per subset. (shared by both endpoints)
+ * @tparam IB	Primary index bits.
+ * @tparam IB2	Secondary index bits. (0 if not present)
+ */
+template<unsigned int Mode, unsigned int NS, unsigned int PB,
+	unsigned int RB, unsigned int ISB, unsigned int CB, unsigned int AB,
+	unsigned int EPB, unsigned int SPB, unsigned int IB, unsigned int IB2>
+struct BC7_ModeParams {
+	enum {
+		mode = Mode,
+		subsets = NS,
+		endpoints = NS * 2,
+		partition_bits = PB,
+		rotation_bits = RB,
+		idxsel_bits = ISB,
+		color_bits = CB,
+		alpha_bits = AB,
+		ep_pbits = EPB,
+		subset_pbits = SPB,
+		index_bits = IB,
+		index2_bits = IB2,
+
+		// Component precision after adding P-bits.
+		color_prec = CB + EPB + SPB,
+		alpha_prec = (AB != 0 ? AB + EPB + SPB : 0),
+
+		// Bit positions.
+		rotation_pos = Mode + 1,
+		idxsel_pos = rotation_pos + RB,
+		partition_pos = idxsel_pos + ISB,
+		color_pos = partition_pos + PB,
+		alpha_pos = color_pos + (endpoints * 3 * CB),
+		pbit_pos = alpha_pos + (endpoints * AB),
+		index_pos = pbit_pos + (endpoints * EPB) + (NS * SPB),
+
+		// Index data lengths.
+		// The MSB of each subset's anchor index is implied to be 0.
+		index_len = (16 * IB) - NS,
+		index2_pos = index_pos + index_len,
+		index2_len = (IB2 != 0 ? (16 * IB2) - 1 : 0),
+	};
+	static_assert(index2_pos + index2_len == 128, "BC7 mode table is inconsistent.");
+};
+
+/**
+ * BC7 mode table.
+ * @tparam mode Block mode.
+ */
+template<unsigned int mode> struct BC7_Mode;
+//                                          Mode NS PB RB ISB CB AB EPB SPB IB IB2
+template<> struct BC7_Mode<0> : BC7_ModeParams<0, 3, 4, 0, 0, 4, 0, 1, 0, 3, 0> { };
+template<> struct BC7_Mode<1> : BC7_ModeParams<1, 2, 6, 0, 0, 6, 0, 0, 1, 3, 0> { };
+template<> struct BC7_Mode<2> : BC7_ModeParams<2, 3, 6, 0, 0, 5, 0, 0, 0, 2, 0> { };
+template<> struct BC7_Mode<3> : BC7_ModeParams<3, 2, 6, 0, 0, 7, 0, 1, 0, 2, 0> { };
+template<> struct BC7_Mode<4> : BC7_ModeParams<4, 1, 0, 2, 1, 5, 6, 0, 0, 2, 3> { };
+template<> struct BC7_Mode<5> : BC7_ModeParams<5, 1, 0, 2, 0, 7, 8, 0, 0, 2, 2> { };
+template<> struct BC7_Mode<6> : BC7_ModeParams<6, 1, 0, 0, 0, 7, 7, 1, 0, 4, 0> { };
+template<> struct BC7_Mode<7> : BC7_ModeParams<7, 2, 6, 0, 0, 5, 5, 1, 0, 2, 0> { };
+
+/**
+ * BC7 palette lookup functions using scalar code.
+ *
+ * Interp must provide:
+ * - template<unsigned int IB> static void interpolate(uint32_t *pal, uint32_t c0, uint32_t c1)
+ *   Calculate all (1 << IB) palette entries between two ARGB32 endpoints.
+ *
+ * @tparam Interp Palette interpolation functions.
+ */
+template<class Interp>
+struct T_BC7_Ops_lookup {
+	/**
+	 * Write the pixels for a BC7 block with a single set of indexes. (Modes 0-3, 6, 7)
+	 * @tparam M BC7_Mode
+	 * @param dest		[out] Destination pixel for the top-left corner of the block.
+	 * @param stride_px	[in] Destination stride, in pixels.
+	 * @param ep		[in] ARGB32 endpoints.
+	 * @param idx		[in] Index data, with anchor bits inserted.
+	 * @param subset	[in] Partition definition. (2 bits per pixel)
+	 */
+	template<class M>
+	static FORCEINLINE void decodeColor(uint32_t *RESTRICT dest, unsigned int stride_px,
+		const uint32_t ep[M::endpoints], uint64_t idx, uint32_t subset)
+	{
+		// Palette for each subset.
+		uint32_t pal[M::subsets << M::index_bits];
+		for (unsigned int s = 0; s < M::subsets; s++) {
+			Interp::template interpolate<M::index_bits>(&pal[s << M::index_bits], ep[s*2], ep[s*2+1]);
+		}
+
+		const unsigned int idx_mask = (1U << M::index_bits) - 1;
+		for (unsigned int y = 0; y < 4; y++, dest += stride_px) {
+			for (unsigned int x = 0; x < 4; x++, idx >>= M::index_bits, subset >>= 2) {
+				dest[x] = pal[((subset & 3) << M::index_bits) |
+					(static_cast<unsigned int>(idx) & idx_mask)];
+			}
+		}
+	}
+
+	/**
+	 * Write the pixels for a BC7 block with separate color and alpha indexes. (Modes 4, 5)
+	 * @tparam CIB Color index bits.
+	 * @tparam AIB Alpha index bits.
+	 * @param dest		[out] Destination pixel for the top-left corner of the block.
+	 * @param stride_px	[in] Destination stride, in pixels.
+	 * @param ep		[in] ARGB32 endpoints.
+	 * @param rotation	[in] Rotation mode.
+	 * @param cidx		[in] Color index data, with anchor bits inserted.
+	 * @param aidx		[in] Alpha index data, with anchor bits inserted.
+	 */
+	template<unsigned int CIB, unsigned int AIB>
+	static FORCEINLINE void decodeSepAlpha(uint32_t *RESTRICT dest, unsigned int stride_px,
+		const uint32_t ep[2], unsigned int rotation, uint64_t cidx, uint64_t aidx)
+	{
+		uint32_t cpal[1U << CIB];
+		uint32_t apal[1U << AIB];
+		Interp::template interpolate<CIB>(cpal, ep[0], ep[1]);
+		Interp::template interpolate<AIB>(apal, ep[0] & 0xFF000000, ep[1] & 0xFF000000);
+
+		// Component rotation.
+		// The palettes are rotated instead of the pixels, since
+		// each pixel is a combination of one entry from each palette.
+		// - 00: ARGB - no swapping
+		// - 01: RAGB - swap A and R
+		// - 10: GRAB - swap A and G
+		// - 11: BRGA - swap A and B
+		if (rotation == 0) {
+			for (unsigned int i = 0; i < ARRAY_SIZE(cpal); i++) {
+				cpal[i] &= 0x00FFFFFF;
+			}
+		} else {
+			const unsigned int shamt = (3 - rotation) * 8;
+			const uint32_t keep_mask = ~(0xFF000000 | (0xFFU << shamt));
+			for (unsigned int i = 0; i < ARRAY_SIZE(cpal); i++) {
+				cpal[i] = (cpal[i] & keep_mask) | (((cpal[i] >> shamt) & 0xFF) << 24);
+			}
+			for (unsigned int i = 0; i < ARRAY_SIZE(apal); i++) {
+				apal[i] = (apal[i] >> 24) << shamt;
+			}
+		}
+
+		const unsigned int cidx_mask = (1U << CIB) - 1;
+		const unsigned int aidx_mask = (1U << AIB) - 1;
+		for (unsigned int y = 0; y < 4; y++, dest += stride_px) {
+			for (unsigned int x = 0; x < 4; x++, cidx >>= CIB, aidx >>= AIB) {
+				dest[x] = cpal[static_cast<unsigned int>(cidx) & cidx_mask] |
+					  apal[static_cast<unsigned int>(aidx) & aidx_mask];
+			}
+		}
+	}
+};
+
+/**
+ * BC7 decoder.
+ *
+ * Ops must provide:
+ * - template<class M> static void decodeColor(uint32_t *dest, unsigned int stride_px,
+ *	const uint32_t ep[M::endpoints], uint64_t idx, uint32_t subset)
+ * - template<unsigned int CIB, unsigned int AIB> static void decodeSepAlpha(
+ *	uint32_t *dest, unsigned int stride_px, const uint32_t ep[2],
+ *	unsigned int rotation, uint64_t cidx, uint64_t aidx)
+ * See T_BC7_Ops_lookup for details.
+ *
+ * @tparam Ops Palette and pixel lookup functions.
+ */
+template<class Ops>
+class T_BC7Decoder
+{
+	private:
+		// T_BC7Decoder is a static class.
+		T_BC7Decoder();
+		~T_BC7Decoder();
+		RP_DISABLE_COPY(T_BC7Decoder)
+
+	private:
+		/**
+		 * Get a bitfield from a 128-bit block.
+		 * @tparam pos Bit position.
+		 * @tparam len Number of bits. (must be less than 64)
+		 * @param lsb LSB QWORD
+		 * @param msb MSB QWORD
+		 * @return Bitfield.
+		 */
+		template<unsigned int pos, unsigned int len>
+		static FORCEINLINE uint64_t getBits(uint64_t lsb, uint64_t msb)
+		{
+			static_assert(len > 0 && len < 64 && pos + len <= 128, "Invalid bitfield.");
+			const uint64_t mask = (1ULL << len) - 1;
+			if (pos >= 64) {
+				return (msb >> (pos & 63)) & mask;
+			} else if (pos + len <= 64) {
+				return (lsb >> pos) & mask;
+			} else {
+				return ((lsb >> (pos & 63)) | (msb << ((64 - pos) & 63))) & mask;
+			}
+		}
+
+		/**
+		 * Expand packed components to 8 bits.
+		 * Each byte contains one component with `prec` bits.
+		 * @tparam prec Component precision.
+		 * @param v Packed components.
+		 * @return Expanded components.
+		 */
+		template<unsigned int prec>
+		static FORCEINLINE uint32_t expand(uint32_t v)
+		{
+			static_assert(prec >= 4 && prec <= 8, "Invalid component precision.");
+			if (prec == 8)
+				return v;
+			// The high bits are copied into the low bits.
+			// Bits shifted in from the next byte are masked out.
+			const uint32_t low_mask = ((1U << (8 - prec)) - 1) * 0x01010101U;
+			return (v << (8 - prec)) | ((v >> ((2 * prec - 8) & 31)) & low_mask);
+		}
+
+		/**
+		 * Insert the implied 0 bit for an anchor index.
+		 * @tparam IB Index bits.
+		 * @param idx Index data.
+		 * @param pixel Anchor pixel.
+		 * @return Index data with the anchor bit inserted.
+		 */
+		template<unsigned int IB>
+		static FORCEINLINE uint64_t insertAnchorBit(uint64_t idx, unsigned int pixel)
+		{
+			const uint64_t low_mask = (1ULL << (pixel * IB + IB - 1)) - 1;
+			return (idx & low_mask) | ((idx & ~low_mask) << 1);
+		}
+
+		/**
+		 * Read an endpoint from a BC7 block.
+		 * All bit positions are constant, so the fields of all
+		 * endpoints can be extracted independently.
+		 * @tparam M BC7_Mode
+		 * @tparam i Endpoint number. (ignored if >= M::endpoints)
+		 * @param ep	[out] ARGB32 endpoints.
+		 * @param lsb	[in] LSB QWORD
+		 * @param msb	[in] MSB QWORD
+		 */
+		template<class M, unsigned int i>
+		static FORCEINLINE void readEndpoint(uint32_t ep[M::endpoints], uint64_t lsb, uint64_t msb)
+		{
+			if (i >= M::endpoints)
+				return;
+
+			// NOTE: n is clamped to keep the bit positions valid
+			// for endpoints that aren't present in this mode.
+			enum {
+				n = (i < M::endpoints ? i : 0),
+				cb = M::color_bits,
+				ab = (M::alpha_bits != 0 ? M::alpha_bits : 1),
+			};
+
+			// Components are stored in RRRR/GGGG/BBBB order,
+			// followed by the alpha components.
+			uint32_t v = static_cast<uint32_t>(
+				(getBits<M::color_pos + ((0 * M::endpoints) + n) * cb, cb>(lsb, msb) << 16) |
+				(getBits<M::color_pos + ((1 * M::endpoints) + n) * cb, cb>(lsb, msb) << 8) |
+				(getBits<M::color_pos + ((2 * M::endpoints) + n) * cb, cb>(lsb, msb)));
+			if (M::alpha_bits != 0) {
+				v |= static_cast<uint32_t>(getBits<M::alpha_pos + (n * ab), ab>(lsb, msb)) << 24;
+			}
+
+			// P-bits. These are the LSB of each component.
+			if (M::ep_pbits != 0) {
+				// Unique P-bit for each endpoint.
+				const uint32_t pbit_comps = (M::alpha_bits != 0 ? 0x01010101U : 0x00010101U);
+				v = (v << 1) | (static_cast<uint32_t>(getBits<M::pbit_pos + n, 1>(lsb, msb)) * pbit_comps);
+			} else if (M::subset_pbits != 0) {
+				// Shared P-bit for each subset. (Mode 1 only; no alpha.)
+				v = (v << 1) | (static_cast<uint32_t>(getBits<M::pbit_pos + (n / 2), 1>(lsb, msb)) * 0x00010101U);
+			}
+
+			// Expand the components to 8 bits.
+			const uint32_t rgb = expand<M::color_prec>(v & 0x00FFFFFF) & 0x00FFFFFF;
+			uint32_t a;
+			if (M::alpha_bits != 0) {
+				a = expand<(M::alpha_prec != 0 ? M::alpha_prec : 8)>(v >> 24) << 24;
+			} else {
+				// No alpha. Use 255.
+				a = 0xFF000000;
+			}
+			ep[n] = a | rgb;
+		}
+
+		/**
+		 * Read endpoints from a BC7 block.
+		 * @tparam M BC7_Mode
+		 * @param ep	[out] ARGB32 endpoints.
+		 * @param lsb	[in] LSB QWORD
+		 * @param msb	[in] MSB QWORD
+		 */
+		template<class M>
+		static FORCEINLINE void readEndpoints(uint32_t ep[M::endpoints], uint64_t lsb, uint64_t msb)
+		{
+			static_assert(M::endpoints <= 6, "Too many endpoints.");
+			readEndpoint<M, 0>(ep, lsb, msb);
+			readEndpoint<M, 1>(ep, lsb, msb);
+			readEndpoint<M, 2>(ep, lsb, msb);
+			readEndpoint<M, 3>(ep, lsb, msb);
+			readEndpoint<M, 4>(ep, lsb, msb);
+			readEndpoint<M, 5>(ep, lsb, msb);
+		}
+
+		/**
+		 * Decode a BC7 block with a single set of indexes. (Modes 0-3, 6, 7)
+		 * @tparam M BC7_Mode
+		 * @param dest		[out] Destination pixel for the top-left corner of the block.
+		 * @param stride_px	[in] Destination stride, in pixels.
+		 * @param lsb		[in] LSB QWORD
+		 * @param msb		[in] MSB QWORD
+		 */
+		template<class M>
+		static FORCEINLINE void decodeBlock(uint32_t *RESTRICT dest, unsigned int stride_px,
+			uint64_t lsb, uint64_t msb)
+		{
+			uint32_t ep[M::endpoints];
+			readEndpoints<M>(ep, lsb, msb);
+
+			// Index data, with anchor bits inserted.
+			uint64_t idx = getBits<M::index_pos, M::index_len>(lsb, msb);
+			uint32_t subset = 0;
+			idx = insertAnchorBit<M::index_bits>(idx, 0);
+
+			// NOTE: partition_bits is 0 for 1-subset modes, so use a
+			// dummy value to keep getBits() happy.
+			const uint8_t partition = static_cast<uint8_t>(getBits<M::partition_pos,
+				(M::partition_bits != 0 ? M::partition_bits : 1)>(lsb, msb));
+			if (M::subsets == 2) {
+				subset = ImageDecoderPrivate::BC7_Subsets2[partition];
+				idx = insertAnchorBit<M::index_bits>(idx,
+					ImageDecoderPrivate::BC7_Anchor2of2[partition]);
+			} else if (M::subsets == 3) {
+				subset = ImageDecoderPrivate::BC7_Subsets3[partition];
+				unsigned int a1 = ImageDecoderPrivate::BC7_Anchor2of3[partition];
+				unsigned int a2 = ImageDecoderPrivate::BC7_Anchor3of3[partition];
+				if (a1 > a2) {
+					std::swap(a1, a2);
+				}
+				idx = insertAnchorBit<M::index_bits>(idx, a1);
+				idx = insertAnchorBit<M::index_bits>(idx, a2);
+			}
+
+			Ops::template decodeColor<M>(dest, stride_px, ep, idx, subset);
+		}
+
+		/**
+		 * Decode a BC7 block with separate color and alpha indexes. (Modes 4, 5)
+		 * @tparam M BC7_Mode
+		 * @param dest		[out] Destination pixel for the top-left corner of the block.
+		 * @param stride_px	[in] Destination stride, in pixels.
+		 * @param lsb		[in] LSB QWORD
+		 * @param msb		[in] MSB QWORD
+		 */
+		template<class M>
+		static FORCEINLINE void decodeBlockSepAlpha(uint32_t *RESTRICT dest, unsigned int stride_px,
+			uint64_t lsb, uint64_t msb)
+		{
+			uint32_t ep[2];
+			readEndpoints<M>(ep, lsb, msb);
+
+			const unsigned int rotation = static_cast<unsigned int>(getBits<M::rotation_pos, 2>(lsb, msb));
+
+			// Both sets of indexes have a single subset.
+			const uint64_t idx1 = insertAnchorBit<M::index_bits>(
+				getBits<M::index_pos, M::index_len>(lsb, msb), 0);
+			const uint64_t idx2 = insertAnchorBit<M::index2_bits>(
+				getBits<M::index2_pos, M::index2_len>(lsb, msb), 0);
+
+			if (M::idxsel_bits != 0 && getBits<M::idxsel_pos, 1>(lsb, msb) != 0) {
+				// Index selection bit is set: (Mode 4 only)
+				// Color uses the secondary indexes; alpha uses the primary indexes.
+				Ops::template decodeSepAlpha<M::index2_bits, M::index_bits>(
+					dest, stride_px, ep, rotation, idx2, idx1);
+			} else {
+				// Color uses the primary indexes; alpha uses the secondary indexes.
+				Ops::template decodeSepAlpha<M::index_bits, M::index2_bits>(
+					dest, stride_px, ep, rotation, idx1, idx2);
+			}
+		}
+
+	public:
+		/**
+		 * Decode a row of BC7 tiles.
+		 * @param dest		[out] Destination pixel for the top-left corner of the row.
+		 * @param stride_px	[in] Destination stride, in pixels.
+		 * @param src		[in] BC7 blocks.
+		 * @param tilesX	[in] Number of tiles.
+		 * @param hasAlpha	[in/out] Set to true if any block has alpha bits.
+		 * @return True on success; false if a block has an invalid mode.
+		 */
+		static bool decodeTileRow(uint32_t *RESTRICT dest, unsigned int stride_px,
+			const uint8_t *RESTRICT src, unsigned int tilesX, bool &hasAlpha)
+		{
+			const uint64_t *bc7_src = reinterpret_cast<const uint64_t*>(src);
+			for (; tilesX > 0; tilesX--, bc7_src += 2, dest += 4) {
+				const uint64_t lsb = le64_to_cpu(bc7_src[0]);
+				const uint64_t msb = le64_to_cpu(bc7_src[1]);
+
+				// The mode number is the lowest set bit.
+				const unsigned int mode_bits = static_cast<unsigned int>(lsb & 0xFF);
+				if (mode_bits & 0x0F) {
+					// Modes 0-3: Color only.
+					if (mode_bits & 0x01) {
+						decodeBlock<BC7_Mode<0> >(dest, stride_px, lsb, msb);
+					} else if (mode_bits & 0x02) {
+						decodeBlock<BC7_Mode<1> >(dest, stride_px, lsb, msb);
+					} else if (mode_bits & 0x04) {
+						decodeBlock<BC7_Mode<2> >(dest, stride_px, lsb, msb);
+					} else {
+						decodeBlock<BC7_Mode<3> >(dest, stride_px, lsb, msb);
+					}
+					continue;
+				}
+
+				// Modes 4-7: Color and alpha.
+				// TODO: Might not actually be alpha if rotation is enabled...
+				if (mode_bits & 0x10) {
+					decodeBlockSepAlpha<BC7_Mode<4> >(dest, stride_px, lsb, msb);
+				} else if (mode_bits & 0x20) {
+					decodeBlockSepAlpha<BC7_Mode<5> >(dest, stride_px, lsb, msb);
+				} else if (mode_bits & 0x40) {
+					decodeBlock<BC7_Mode<6> >(dest, stride_px, lsb, msb);
+				} else if (mode_bits & 0x80) {
+					decodeBlock<BC7_Mode<7> >(dest, stride_px, lsb, msb);
+				} else {
+					// Invalid mode.
+					return false;
+				}
+				hasAlpha = true;
+			}
+			return true;
+		}
+
+		/**
+		 * Convert a BC7 image to rp_image.
+		 * @param width Image width.
+		 * @param height Image height.
+		 * @param img_buf BC7 image buffer.
+		 * @param img_siz Size of image data. [must be >= (w*h)]
+		 * @return rp_image, or nullptr on error.
+		 */
+		static rp_image *fromBC7(int width, int height,
+			const uint8_t *RESTRICT img_buf, int img_siz)
+		{
+			// Verify parameters.
+			assert(img_buf != nullptr);
+			assert(width > 0);
+			assert(height > 0);
+			assert(img_siz >= (width * height));
+			if (!img_buf || width <= 0 || height <= 0 ||
+			    img_siz < (width * height))
+			{
+				return nullptr;
+			}
+
+			// BC7 uses 4x4 tiles.
+			assert(width % 4 == 0);
+			assert(height % 4 == 0);
+			if (width % 4 != 0 || height % 4 != 0)
+				return nullptr;
+
+			// Calculate the total number of tiles.
+			const unsigned int tilesX = static_cast<unsigned int>(width / 4);
+			const unsigned int tilesY = static_cast<unsigned int>(height / 4);
+
+			// Create an rp_image.
+			rp_image *const img = new rp_image(width, height, rp_image::FORMAT_ARGB32);
+			if (!img->isValid()) {
+				// Could not allocate the image.
+				delete img;
+				return nullptr;
+			}
+
+			// Decode one row of tiles at a time, directly into the image.
+			const unsigned int stride_px = img->stride() / sizeof(uint32_t);
+			uint32_t *dest = static_cast<uint32_t*>(img->bits());
+			bool hasAlpha = false;
+			for (unsigned int y = tilesY; y > 0; y--) {
+				if (!decodeTileRow(dest, stride_px, img_buf, tilesX, hasAlpha)) {
+					// Invalid mode.
+					assert(!"BC7 block has an invalid mode.");
+					delete img;
+					return nullptr;
+				}
+				img_buf += tilesX * 16;
+				dest += stride_px * 4;
+			}
+
+			// Set the sBIT metadata.
+			// The alpha value is set depending on whether or not
+			// a block with alpha bits set is encountered.
+			// TODO: Check rotation?
+			static const rp_image::sBIT_t sBIT_opaque = {8,8,8,0,0};
+			static const rp_image::sBIT_t sBIT_alpha  = {8,8,8,0,8};
+			img->set_sBIT(hasAlpha ? &sBIT_alpha : &sBIT_opaque);
+
+			// Image has been converted.
+			return img;
+		}
+};
+
+}
+
+#endif /* __ROMPROPERTIES_LIBRPBASE_IMG_IMAGEDECODER_BC7_P_HPP__ */
@@ -0,0 +1,67 @@
+/***************************************************************************
+ * ROM Properties Page shell extension. (librpbase)                        *
+ * ImageDecoder_BC7_sse2.cpp: Image decoding functions. (BC7)              *
+ * SSE2-optimized version.                                                 *
+ *                                                                         *
+ * Copyright (c) 2016-2019 by David Korth.                                 *
+ *                                                                         *
+ * This program is free software; you can redistribute it and/or modify it *
+ * under the terms of the GNU General Public License as published by the   *
+ * Free Software Foundation; either version 2 of the License, or (at your  *
+ * option) any later version.                                              *
+ *                                                                         *
+ * This program is distributed in the hope that it will be useful, but     *
+ * WITHOUT ANY WARRANTY; without even the implied warranty of              *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the           *
+ * GNU General Public License for more details.                            *
+ *                                                                         *
+ * You should have received a copy of the GNU General Public License       *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.   *
+ ***************************************************************************/
+
+#include "config.librpbase.h"
+
+#include "ImageDecoder.hpp"
+#include "ImageDecoder_BC7_p.hpp"
+#include "ImageDecoder_BC7_sse2.hpp"
+
+namespace LibRpBase {
+
+/**
+ * SSE2 palette interpolation functions for T_BC7_Ops_lookup.
+ */
+struct BC7_Interp_sse2 {
+	/**
+	 * Interpolate a BC7 palette.
+	 * @tparam IB Index precision, in number of bits.
+	 * @param pal	[out] Palette. (1 << IB entries)
+	 * @param c0	[in] ARGB32 endpoint 0.
+	 * @param c1	[in] ARGB32 endpoint 1.
+	 */
+	template<unsigned int IB>
+	static FORCEINLINE void interpolate(uint32_t *RESTRICT pal, uint32_t c0, uint32_t c1)
+	{
+		__m128i pal_v[(1U << IB) / 4];
+		BC7_interpolate_sse2<IB>(pal_v, c0, c1);
+		for (unsigned int i = 0; i < ARRAY_SIZE(pal_v); i++) {
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(&pal[i * 4]), pal_v[i]);
+		}
+	}
+};
+
+/**
+ * Convert a BC7 image to rp_image.
+ * SSE2-optimized version.
+ * @param width Image width.
+ * @param height Image height.
+ * @param img_buf BC7 image buffer.
+ * @param img_siz Size of image data. [must be >= (w*h)]
+ * @return rp_image, or nullptr on error.
+ */
+rp_image *ImageDecoder::fromBC7_sse2(int width, int height,
+	const uint8_t *RESTRICT img_buf, int img_siz)
+{
+	return T_BC7Decoder<T_BC7_Ops_lookup<BC7_Interp_sse2> >::fromBC7(width, height, img_buf, img_siz);
+}
+
+}
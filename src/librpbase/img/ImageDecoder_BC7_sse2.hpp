@@ -0,0 +1,102 @@
+/***************************************************************************
+ * ROM Properties Page shell extension. (librpbase)                        *
+ * ImageDecoder_BC7_sse2.hpp: Image decoding functions. (BC7)              *
+ * Common SSE2 functions for the SIMD-optimized BC7 decoders.              *
+ *                                                                         *
+ * Copyright (c) 2016-2019 by David Korth.                                 *
+ *                                                                         *
+ * This program is free software; you can redistribute it and/or modify it *
+ * under the terms of the GNU General Public License as published by the   *
+ * Free Software Foundation; either version 2 of the License, or (at your  *
+ * option) any later version.                                              *
+ *                                                                         *
+ * This program is distributed in the hope that it will be useful, but     *
+ * WITHOUT ANY WARRANTY; without even the implied warranty of              *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the           *
+ * GNU General Public License for more details.                            *
+ *                                                                         *
+ * You should have received a copy of the GNU General Public License       *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.   *
+ ***************************************************************************/
+
+#ifndef __ROMPROPERTIES_LIBRPBASE_IMG_IMAGEDECODER_BC7_SSE2_HPP__
+#define __ROMPROPERTIES_LIBRPBASE_IMG_IMAGEDECODER_BC7_SSE2_HPP__
+
+// NOTE: This header must only be included by source files
+// that are compiled with SSE2 (or later) enabled.
+// All functions are static in order to prevent the linker
+// from merging copies compiled for different instruction sets.
+
+#include "common.h"
+
+// SSE2 headers.
+#include <emmintrin.h>
+
+namespace LibRpBase {
+
+// Interpolation values.
+// Each weight is repeated for all four components,
+// so each vector has the weights for two palette entries.
+static const ALIGNED_VAR(16, uint16_t BC7_aWeight2_sse2[16]) = {
+	 0,  0,  0,  0, 21, 21, 21, 21,
+	43, 43, 43, 43, 64, 64, 64, 64,
+};
+
+static const ALIGNED_VAR(16, uint16_t BC7_aWeight3_sse2[32]) = {
+	 0,  0,  0,  0,  9,  9,  9,  9,
+	18, 18, 18, 18, 27, 27, 27, 27,
+	37, 37, 37, 37, 46, 46, 46, 46,
+	55, 55, 55, 55, 64, 64, 64, 64,
+};
+
+static const ALIGNED_VAR(16, uint16_t BC7_aWeight4_sse2[64]) = {
+	 0,  0,  0,  0,  4,  4,  4,  4,
+	 9,  9,  9,  9, 13, 13, 13, 13,
+	17, 17, 17, 17, 21, 21, 21, 21,
+	26, 26, 26, 26, 30, 30, 30, 30,
+	34, 34, 34, 34, 38, 38, 38, 38,
+	43, 43, 43, 43, 47, 47, 47, 47,
+	51, 51, 51, 51, 55, 55, 55, 55,
+	60, 60, 60, 60, 64, 64, 64, 64,
+};
+
+/**
+ * Interpolate a BC7 palette.
+ * Four palette entries are calculated per vector.
+ *
+ * ((64 - w) * e0 + w * e1 + 32) >> 6 is calculated as
+ * e0 + ((w * (e1 - e0) + 32) >> 6), which only needs
+ * one multiplication and has the same result, since
+ * the arithmetic shift rounds towards negative infinity.
+ *
+ * @tparam IB Index precision, in number of bits.
+ * @param pal	[out] Palette. ((1 << IB) / 4 vectors of ARGB32)
+ * @param c0	[in] ARGB32 endpoint 0.
+ * @param c1	[in] ARGB32 endpoint 1.
+ */
+template<unsigned int IB>
+static FORCEINLINE void BC7_interpolate_sse2(__m128i *pal, uint32_t c0, uint32_t c1)
+{
+	static_assert(IB >= 2 && IB <= 4, "Invalid index precision.");
+	const __m128i *pw = reinterpret_cast<const __m128i*>(
+		IB == 2 ? BC7_aWeight2_sse2 : (IB == 3 ? BC7_aWeight3_sse2 : BC7_aWeight4_sse2));
+
+	// Endpoints, as 16-bit components. (two copies each)
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i e0 = _mm_unpacklo_epi8(_mm_set1_epi32(static_cast<int>(c0)), zero);
+	const __m128i e1 = _mm_unpacklo_epi8(_mm_set1_epi32(static_cast<int>(c1)), zero);
+	const __m128i d = _mm_sub_epi16(e1, e0);
+	const __m128i k32 = _mm_set1_epi16(32);
+
+	for (unsigned int i = 0; i < (1U << IB) / 4; i++, pw += 2) {
+		__m128i lo = _mm_add_epi16(_mm_mullo_epi16(d, _mm_load_si128(&pw[0])), k32);
+		__m128i hi = _mm_add_epi16(_mm_mullo_epi16(d, _mm_load_si128(&pw[1])), k32);
+		lo = _mm_add_epi16(e0, _mm_srai_epi16(lo, 6));
+		hi = _mm_add_epi16(e0, _mm_srai_epi16(hi, 6));
+		pal[i] = _mm_packus_epi16(lo, hi);
+	}
+}
+
+}
+
+#endif /* __ROMPROPERTIES_LIBRPBASE_IMG_IMAGEDECODER_BC7_SSE2_HPP__ */
@@ -0,0 +1,387 @@
+/***************************************************************************
+ * ROM Properties Page shell extension. (librpbase)                        *
+ * ImageDecoder_BC7_ssse3.cpp: Image decoding functions. (BC7)             *
+ * SSSE3-optimized version.                                                *
+ *                                                                         *
+ * Copyright (c) 2016-2019 by David Korth.                                 *
+ *                                                                         *
+ * This program is free software; you can redistribute it and/or modify it *
+ * under the terms of the GNU General Public License as published by the   *
+ * Free Software Foundation; either version 2 of the License, or (at your  *
+ * option) any later version.                                              *
+ *                                                                         *
+ * This program is distributed in the hope that it will be useful, but     *
+ * WITHOUT ANY WARRANTY; without even the implied warranty of              *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the           *
+ * GNU General Public License for more details.                            *
+ *                                                                         *
+ * You should have received a copy of the GNU General Public License       *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.   *
+ ***************************************************************************/
+
+#include "config.librpbase.h"
+
+#include "ImageDecoder.hpp"
+#include "ImageDecoder_BC7_p.hpp"
+#include "ImageDecoder_BC7_sse2.hpp"
+
+// SSSE3 headers.
+#include <emmintrin.h>
+#include <tmmintrin.h>
+
+namespace LibRpBase {
+
+/**
+ * SSSE3 palette interpolation functions for T_BC7_Ops_lookup.
+ * Only used for mode 0, which has 24 palette entries.
+ */
+struct BC7_Interp_ssse3 {
+	/**
+	 * Interpolate a BC7 palette.
+	 * @tparam IB Index precision, in number of bits.
+	 * @param pal	[out] Palette. (1 << IB entries)
+	 * @param c0	[in] ARGB32 endpoint 0.
+	 * @param c1	[in] ARGB32 endpoint 1.
+	 */
+	template<unsigned int IB>
+	static FORCEINLINE void interpolate(uint32_t *RESTRICT pal, uint32_t c0, uint32_t c1)
+	{
+		__m128i pal_v[(1U << IB) / 4];
+		BC7_interpolate_sse2<IB>(pal_v, c0, c1);
+		for (unsigned int i = 0; i < ARRAY_SIZE(pal_v); i++) {
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(&pal[i * 4]), pal_v[i]);
+		}
+	}
+};
+
+/**
+ * Palette interpolation tables for BC7_Ops_ssse3::interpolatePlane().
+ * Each table has two vectors: palette entries 0-7 and 8-15.
+ */
+struct BC7_PlaneTables_ssse3 {
+	// Endpoint byte pair for each palette entry.
+	// Subsets alternate between the low and high QWORDs
+	// of the source vector; see interpolatePlane().
+	uint8_t sel[2][16];
+	// Weight pair for each palette entry: {64 - w, w}
+	uint8_t weights[2][16];
+};
+
+static const ALIGNED_VAR(16, BC7_PlaneTables_ssse3 BC7_planeTables_ssse3[3]) = {
+	// 2-bit indexes
+	{{{0,1, 0,1, 0,1, 0,1, 8,9, 8,9, 8,9, 8,9},
+	  {0,1, 0,1, 0,1, 0,1, 8,9, 8,9, 8,9, 8,9}},
+	 {{64,0, 43,21, 21,43, 0,64, 64,0, 43,21, 21,43, 0,64},
+	  {64,0, 43,21, 21,43, 0,64, 64,0, 43,21, 21,43, 0,64}}},
+
+	// 3-bit indexes
+	{{{0,1, 0,1, 0,1, 0,1, 0,1, 0,1, 0,1, 0,1},
+	  {8,9, 8,9, 8,9, 8,9, 8,9, 8,9, 8,9, 8,9}},
+	 {{64,0, 55,9, 46,18, 37,27, 27,37, 18,46, 9,55, 0,64},
+	  {64,0, 55,9, 46,18, 37,27, 27,37, 18,46, 9,55, 0,64}}},
+
+	// 4-bit indexes
+	{{{0,1, 0,1, 0,1, 0,1, 0,1, 0,1, 0,1, 0,1},
+	  {0,1, 0,1, 0,1, 0,1, 0,1, 0,1, 0,1, 0,1}},
+	 {{64,0, 60,4, 55,9, 51,13, 47,17, 43,21, 38,26, 34,30},
+	  {30,34, 26,38, 21,43, 17,47, 13,51, 9,55, 4,60, 0,64}}},
+};
+
+/**
+ * SSSE3 palette and pixel lookup functions for T_BC7Decoder.
+ *
+ * Palettes with up to 16 entries are calculated as one vector
+ * per component, so all 16 pixels of a block can be looked up
+ * at once using PSHUFB.
+ */
+struct BC7_Ops_ssse3 {
+	/**
+	 * Expand packed 2-bit values to one value per byte.
+	 * @tparam shamt Left shift for each value.
+	 * @param v Packed 2-bit values.
+	 * @return (value << shamt) for each pixel, one per byte.
+	 */
+	template<unsigned int shamt>
+	static FORCEINLINE __m128i expand2(uint32_t v)
+	{
+		const __m128i mask4 = _mm_set1_epi8(0x0F);
+
+		// Copy each row of values to the bytes for its four pixels,
+		// then mask each pixel's value in place.
+		__m128i px = _mm_shuffle_epi8(_mm_cvtsi32_si128(static_cast<int>(v)),
+			_mm_setr_epi8(0,0,0,0, 1,1,1,1, 2,2,2,2, 3,3,3,3));
+		px = _mm_and_si128(px, _mm_set1_epi32(static_cast<int>(0xC0300C03)));
+
+		// Pixels 2 and 3 are in the high nybble. Move them to the low nybble.
+		// Pixels 0 and 2 now have values 0-3; pixels 1 and 3 have 0,4,8,12.
+		px = _mm_or_si128(_mm_and_si128(px, mask4), _mm_and_si128(_mm_srli_epi16(px, 4), mask4));
+		return _mm_shuffle_epi8(_mm_setr_epi8(
+			0, 1 << shamt, 2 << shamt, 3 << shamt, 1 << shamt, 0, 0, 0,
+			2 << shamt, 0, 0, 0, 3 << shamt, 0, 0, 0), px);
+	}
+
+	/**
+	 * Expand packed 3-bit values to one value per byte.
+	 * @param v Packed 3-bit values.
+	 * @return Value for each pixel, one per byte.
+	 */
+	static FORCEINLINE __m128i expand3(uint64_t v)
+	{
+		const __m128i v8 = _mm_set_epi32(0, 0,
+			static_cast<int>(v >> 32), static_cast<int>(v & 0xFFFFFFFFU));
+
+		// Copy the two bytes containing each pixel's value to a 16-bit lane.
+		const __m128i w_lo = _mm_shuffle_epi8(v8,
+			_mm_setr_epi8(0,1, 0,1, 0,1, 1,2, 1,2, 1,2, 2,3, 2,3));
+		const __m128i w_hi = _mm_shuffle_epi8(v8,
+			_mm_setr_epi8(3,4, 3,4, 3,4, 4,5, 4,5, 4,5, 5,6, 5,6));
+
+		// Shift each value to bits 7-9, then down to bits 0-2.
+		// SSSE3 doesn't have variable shifts, so the left shift
+		// is done using multiplication.
+		const __m128i mul = _mm_setr_epi16(1<<7, 1<<4, 1<<1, 1<<6, 1<<3, 1<<0, 1<<5, 1<<2);
+		const __m128i mask3 = _mm_set1_epi16(7);
+		const __m128i c_lo = _mm_and_si128(_mm_srli_epi16(_mm_mullo_epi16(w_lo, mul), 7), mask3);
+		const __m128i c_hi = _mm_and_si128(_mm_srli_epi16(_mm_mullo_epi16(w_hi, mul), 7), mask3);
+		return _mm_packus_epi16(c_lo, c_hi);
+	}
+
+	/**
+	 * Expand packed 4-bit values to one value per byte.
+	 * @param v Packed 4-bit values.
+	 * @return Value for each pixel, one per byte.
+	 */
+	static FORCEINLINE __m128i expand4(uint64_t v)
+	{
+		const __m128i mask4 = _mm_set1_epi8(0x0F);
+		const __m128i nyb = _mm_set_epi32(0, 0,
+			static_cast<int>(v >> 32), static_cast<int>(v & 0xFFFFFFFFU));
+		return _mm_unpacklo_epi8(_mm_and_si128(nyb, mask4),
+			_mm_and_si128(_mm_srli_epi16(nyb, 4), mask4));
+	}
+
+	/**
+	 * Expand packed indexes to one index per byte.
+	 * @tparam IB Index bits. (2-4)
+	 * @param idx Packed indexes. (16 * IB bits)
+	 * @return Index for each pixel, one per byte.
+	 */
+	template<unsigned int IB>
+	static FORCEINLINE __m128i expandIndexes(uint64_t idx)
+	{
+		static_assert(IB >= 2 && IB <= 4, "Invalid index precision.");
+		if (IB == 2) {
+			return expand2<0>(static_cast<uint32_t>(idx));
+		} else if (IB == 3) {
+			return expand3(idx);
+		} else {
+			return expand4(idx);
+		}
+	}
+
+	/**
+	 * Interleave the components of a subset's endpoints.
+	 * @param c0 ARGB32 endpoint 0.
+	 * @param c1 ARGB32 endpoint 1.
+	 * @return Low QWORD: {B0,B1,G0,G1,R0,R1,A0,A1}
+	 */
+	static FORCEINLINE __m128i endpointPairs(uint32_t c0, uint32_t c1)
+	{
+		return _mm_unpacklo_epi8(_mm_cvtsi32_si128(static_cast<int>(c0)),
+			_mm_cvtsi32_si128(static_cast<int>(c1)));
+	}
+
+	/**
+	 * Interpolate one component of a BC7 palette.
+	 *
+	 * Palette entry i is in subset (i >> IB), which must be in
+	 * the low QWORD of the source vector for even subsets and
+	 * in the high QWORD for odd subsets:
+	 * - src_lo: Entries 0-7.
+	 * - src_hi: Entries 8-15. (only used if there are more than 8 entries)
+	 *
+	 * @tparam IB Index precision, in number of bits.
+	 * @tparam NS Number of subsets.
+	 * @tparam C Component. (0 == B, 1 == G, 2 == R, 3 == A)
+	 * @param src_lo Endpoint pairs for entries 0-7, from endpointPairs().
+	 * @param src_hi Endpoint pairs for entries 8-15, from endpointPairs().
+	 * @return Component for each palette entry, one per byte.
+	 */
+	template<unsigned int IB, unsigned int NS, unsigned int C>
+	static FORCEINLINE __m128i interpolatePlane(__m128i src_lo, __m128i src_hi)
+	{
+		static_assert(IB >= 2 && IB <= 4, "Invalid index precision.");
+		static_assert((NS << IB) <= 16, "Too many palette entries.");
+		const BC7_PlaneTables_ssse3 *const tbl = &BC7_planeTables_ssse3[IB - 2];
+		const __m128i comp = _mm_set1_epi8(C * 2);
+		const __m128i k32 = _mm_set1_epi16(32);
+
+		// ((64 - w) * e0 + w * e1 + 32) >> 6
+		// PMADDUBSW calculates both products and adds them.
+		__m128i lo = _mm_shuffle_epi8(src_lo, _mm_add_epi8(comp,
+			_mm_load_si128(reinterpret_cast<const __m128i*>(tbl->sel[0]))));
+		lo = _mm_maddubs_epi16(lo, _mm_load_si128(reinterpret_cast<const __m128i*>(tbl->weights[0])));
+		lo = _mm_srli_epi16(_mm_add_epi16(lo, k32), 6);
+		if ((NS << IB) <= 8) {
+			return _mm_packus_epi16(lo, lo);
+		}
+
+		__m128i hi = _mm_shuffle_epi8(src_hi, _mm_add_epi8(comp,
+			_mm_load_si128(reinterpret_cast<const __m128i*>(tbl->sel[1]))));
+		hi = _mm_maddubs_epi16(hi, _mm_load_si128(reinterpret_cast<const __m128i*>(tbl->weights[1])));
+		hi = _mm_srli_epi16(_mm_add_epi16(hi, k32), 6);
+		return _mm_packus_epi16(lo, hi);
+	}
+
+	/**
+	 * Write the pixels for a BC7 block.
+	 * @param dest		[out] Destination pixel for the top-left corner of the block.
+	 * @param stride_px	[in] Destination stride, in pixels.
+	 * @param b		[in] Blue components.
+	 * @param g		[in] Green components.
+	 * @param r		[in] Red components.
+	 * @param a		[in] Alpha components.
+	 */
+	static FORCEINLINE void writeRows(uint32_t *RESTRICT dest, unsigned int stride_px,
+		__m128i b, __m128i g, __m128i r, __m128i a)
+	{
+		const __m128i bg_lo = _mm_unpacklo_epi8(b, g);
+		const __m128i bg_hi = _mm_unpackhi_epi8(b, g);
+		const __m128i ra_lo = _mm_unpacklo_epi8(r, a);
+		const __m128i ra_hi = _mm_unpackhi_epi8(r, a);
+
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(dest), _mm_unpacklo_epi16(bg_lo, ra_lo));
+		dest += stride_px;
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(dest), _mm_unpackhi_epi16(bg_lo, ra_lo));
+		dest += stride_px;
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(dest), _mm_unpacklo_epi16(bg_hi, ra_hi));
+		dest += stride_px;
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(dest), _mm_unpackhi_epi16(bg_hi, ra_hi));
+	}
+
+	/**
+	 * Write the pixels for a BC7 block with a single set of indexes. (Modes 0-3, 6, 7)
+	 * @tparam M BC7_Mode
+	 * @param dest		[out] Destination pixel for the top-left corner of the block.
+	 * @param stride_px	[in] Destination stride, in pixels.
+	 * @param ep		[in] ARGB32 endpoints.
+	 * @param idx		[in] Index data, with anchor bits inserted.
+	 * @param subset	[in] Partition definition. (2 bits per pixel)
+	 */
+	template<class M>
+	static FORCEINLINE void decodeColor(uint32_t *RESTRICT dest, unsigned int stride_px,
+		const uint32_t ep[M::endpoints], uint64_t idx, uint32_t subset)
+	{
+		if ((M::subsets << M::index_bits) > 16) {
+			// Too many palette entries for PSHUFB. (Mode 0)
+			T_BC7_Ops_lookup<BC7_Interp_ssse3>::template decodeColor<M>(
+				dest, stride_px, ep, idx, subset);
+			return;
+		}
+
+		// NOTE: The endpoint indexes are clamped for modes
+		// that don't have them. They're never used.
+		enum {
+			IB = M::index_bits,
+			NS = ((M::subsets << M::index_bits) > 16 ? 1 : M::subsets),
+			ep2 = (M::endpoints > 2 ? 2 : 0),
+			ep3 = (M::endpoints > 3 ? 3 : 0),
+			ep4 = (M::endpoints > 4 ? 4 : 0),
+			ep5 = (M::endpoints > 5 ? 5 : 0),
+		};
+
+		// Endpoint pairs. (See interpolatePlane().)
+		__m128i src_lo = endpointPairs(ep[0], ep[1]);
+		__m128i src_hi = src_lo;
+		if (NS >= 2) {
+			src_lo = _mm_unpacklo_epi64(src_lo, endpointPairs(ep[ep2], ep[ep3]));
+			src_hi = src_lo;
+		}
+		if (NS >= 3) {
+			src_hi = endpointPairs(ep[ep4], ep[ep5]);
+		}
+
+		// Palette index for each pixel.
+		// The subset index is the high bit(s) of the palette index.
+		__m128i px_idx = expandIndexes<IB>(idx);
+		if (NS > 1) {
+			px_idx = _mm_or_si128(px_idx, expand2<IB>(subset));
+		}
+
+		const __m128i b = _mm_shuffle_epi8(interpolatePlane<IB, NS, 0>(src_lo, src_hi), px_idx);
+		const __m128i g = _mm_shuffle_epi8(interpolatePlane<IB, NS, 1>(src_lo, src_hi), px_idx);
+		const __m128i r = _mm_shuffle_epi8(interpolatePlane<IB, NS, 2>(src_lo, src_hi), px_idx);
+		__m128i a;
+		if (M::alpha_bits != 0) {
+			a = _mm_shuffle_epi8(interpolatePlane<IB, NS, 3>(src_lo, src_hi), px_idx);
+		} else {
+			// No alpha. Use 255.
+			a = _mm_set1_epi8(static_cast<int8_t>(0xFF));
+		}
+		writeRows(dest, stride_px, b, g, r, a);
+	}
+
+	/**
+	 * Write the pixels for a BC7 block with separate color and alpha indexes. (Modes 4, 5)
+	 * @tparam CIB Color index bits.
+	 * @tparam AIB Alpha index bits.
+	 * @param dest		[out] Destination pixel for the top-left corner of the block.
+	 * @param stride_px	[in] Destination stride, in pixels.
+	 * @param ep		[in] ARGB32 endpoints.
+	 * @param rotation	[in] Rotation mode.
+	 * @param cidx		[in] Color index data, with anchor bits inserted.
+	 * @param aidx		[in] Alpha index data, with anchor bits inserted.
+	 */
+	template<unsigned int CIB, unsigned int AIB>
+	static FORCEINLINE void decodeSepAlpha(uint32_t *RESTRICT dest, unsigned int stride_px,
+		const uint32_t ep[2], unsigned int rotation, uint64_t cidx, uint64_t aidx)
+	{
+		const __m128i src = endpointPairs(ep[0], ep[1]);
+		const __m128i ci = expandIndexes<CIB>(cidx);
+		const __m128i ai = expandIndexes<AIB>(aidx);
+
+		__m128i b = _mm_shuffle_epi8(interpolatePlane<CIB, 1, 0>(src, src), ci);
+		__m128i g = _mm_shuffle_epi8(interpolatePlane<CIB, 1, 1>(src, src), ci);
+		__m128i r = _mm_shuffle_epi8(interpolatePlane<CIB, 1, 2>(src, src), ci);
+		__m128i a = _mm_shuffle_epi8(interpolatePlane<AIB, 1, 3>(src, src), ai);
+
+		// Component rotation.
+		// - 00: ARGB - no swapping
+		// - 01: RAGB - swap A and R
+		// - 10: GRAB - swap A and G
+		// - 11: BRGA - swap A and B
+		__m128i tmp;
+		switch (rotation) {
+			default:
+				break;
+			case 1:
+				tmp = a; a = r; r = tmp;
+				break;
+			case 2:
+				tmp = a; a = g; g = tmp;
+				break;
+			case 3:
+				tmp = a; a = b; b = tmp;
+				break;
+		}
+
+		writeRows(dest, stride_px, b, g, r, a);
+	}
+};
+
+/**
+ * Convert a BC7 image to rp_image.
+ * SSSE3-optimized version.
+ * @param width Image width.
+ * @param height Image height.
+ * @param img_buf BC7 image buffer.
+ * @param img_siz Size of image data. [must be >= (w*h)]
+ * @return rp_image, or nullptr on error.
+ */
+rp_image *ImageDecoder::fromBC7_ssse3(int width, int height,
+	const uint8_t *RESTRICT img_buf, int img_siz)
+{
+	return T_BC7Decoder<BC7_Ops_ssse3>::fromBC7(width, height, img_buf, img_siz);
+}
+
+}
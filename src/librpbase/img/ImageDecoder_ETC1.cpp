@@ -21,114 +21,10 @@
 #include "config.librpbase.h"
 
 #include "ImageDecoder.hpp"
-#include "ImageDecoder_p.hpp"
-
-// References:
-// - https://www.khronos.org/registry/OpenGL/extensions/OES/OES_compressed_ETC1_RGB8_texture.txt
-// - https://www.khronos.org/registry/DataFormat/specs/1.1/dataformat.1.1.html#ETC1
-// - https://www.khronos.org/registry/DataFormat/specs/1.1/dataformat.1.1.html#ETC2
+#include "ImageDecoder_ETC1_p.hpp"
 
 namespace LibRpBase {
 
-#pragma pack(1)
-
-// ETC1 block format.
-// NOTE: Layout maps to on-disk format, which is big-endian.
-union PACKED etc1_block {
-	struct {
-		// Base colors
-		// Byte layout:
-		// - diffbit == 0: 4 MSB == base 1, 4 LSB == base 2
-		// - diffbit == 1: 5 MSB == base, 3 LSB == differential
-		union {
-			// Indiv/Diff
-			struct {
-				uint8_t R;
-				uint8_t G;
-				uint8_t B;
-			} id;
-
-			// ETC2 'T' mode
-			struct {
-				uint8_t R1;
-				uint8_t G1B1;
-				uint8_t R2G2;
-				// B2 is in `control`.
-			} t;
-
-			// ETC2 'H' mode
-			struct {
-				uint8_t R1G1a;
-				uint8_t G1bB1aB1b;
-				uint8_t B1bR2G2;
-				// Part of G2 is in `control`.
-				// B2 is in `control`.
-			} h;
-		};
-
-		// Control byte: [ETC1]
-		// - 3 MSB:  table code word 1
-		// - 3 next: table code word 2
-		// - 1 bit:  diff bit
-		// - 1 LSB:  flip bit
-		uint8_t control;
-
-		// Pixel index bits. (big-endian)
-		uint16_t msb;
-		uint16_t lsb;
-	};
-
-	struct {
-		// Planar mode has 3 colors in RGB676 format.
-		// Colors are labelled 'O', 'H', and 'V'.
-		uint8_t RO_GO1;		// 6-1: RO;     0: GO1
-		uint8_t GO2_BO1;	// 6-1: GO2;    0: BO1
-		uint8_t BO2_BO3;	// 4-3: BO2;  1-0: BO3a
-		uint8_t BO3_RH;		//   7: BO3b; 6-2: RH1; 0: RH2
-		uint8_t GH_BH;		// 7-1: GH;     0: BH
-		uint8_t BH_RV;		// 7-3: BH;   2-0: RV
-		uint8_t RV_GV;		// 7-5: RV;   4-0: GV
-		uint8_t GV_BV;		// 7-6: GV;   5-0: BV
-	} planar;
-};
-ASSERT_STRUCT(etc1_block, 8);
-
-// ETC2 alpha block format.
-// NOTE: Layout maps to on-disk format, which is big-endian.
-union etc2_alpha {
-	struct {
-		uint8_t base_codeword;	// Base codeword.
-		uint8_t mult_tbl_idx;	// Multiplier (high 4); table index (low 4)
-		uint8_t values[6];	// Alpha values. (48-bit unsigned; 3-bit per pixel)
-	};
-	uint64_t u64;				// Access the 48-bit alpha value directly. (Requires shifting.)
-};
-ASSERT_STRUCT(etc2_alpha, 8);
-
-// ETC2 RGBA block format.
-// NOTE: Layout maps to on-disk format, which is big-endian.
-struct etc2_rgba_block {
-	etc2_alpha alpha;
-	etc1_block etc1;
-};
-ASSERT_STRUCT(etc2_rgba_block, 16);
-
-#pragma pack()
-
-/**
- * Extract the 48-bit code value from etc2_alpha.
- * @param data etc2_alpha.
- * @return 48-bit code value.
- */
-static FORCEINLINE uint64_t extract48(const etc2_alpha *RESTRICT data)
-{
-	// values[6] starts at 0x02 within etc2_alpha.
-	// Hence, we need to mask it after byteswapping.
-	// TODO: constexpr?
-	// TODO: Verify on big-endian.
-	return be64_to_cpu(data->u64) & 0x0000FFFFFFFFFFFFULL;
-}
-
 /**
  * Pixel index values:
  * msb lsb
@@ -153,7 +49,7 @@ static FORCEINLINE uint64_t extract48(const etc2_alpha *RESTRICT data)
  * index values in ascending two-bit value order as
  * listed above instead of mapping to ETC1 table 3.17.2.
  */
-static const int16_t etc1_intensity[8][4] = {
+const int16_t ImageDecoderPrivate::ETC1_intensity[8][4] = {
 	{ 2,   8,  -2,   -8},
 	{ 5,  17,  -5,  -17},
 	{ 9,  29,  -9,  -29},
@@ -173,7 +69,7 @@ static const int16_t etc1_intensity[8][4] = {
  * index values in ascending two-bit value order as
  * listed above instead of mapping to ETC1 table 3.17.2.
  */
-static const int16_t etc2_intensity_a1[8][4] = {
+const int16_t ImageDecoderPrivate::ETC2_intensity_a1[8][4] = {
 	{0,   8, 0,   -8},
 	{0,  17, 0,  -17},
 	{0,  29, 0,  -29},
@@ -205,26 +101,18 @@ static const uint16_t etc1_subblock_mapping[2] = {
 };
 
 // 3-bit 2's complement lookup table.
-static const int8_t etc1_3bit_diff_tbl[8] = {
+const int8_t ImageDecoderPrivate::ETC1_3bit_diff_tbl[8] = {
 	0, 1, 2, 3, -4, -3, -2, -1
 };
 
-// ETC2 block mode.
-enum etc2_block_mode {
-	ETC2_BLOCK_MODE_UNKNOWN = 0,
-	ETC2_BLOCK_MODE_ETC1,		// ETC1-compatible mode (indiv, diff)
-	ETC2_BLOCK_MODE_TH,		// ETC2 'T' or 'H' mode
-	ETC2_BLOCK_MODE_PLANAR,		// ETC2 'Planar' mode
-};
-
 // ETC2 distance table for 'T' and 'H' modes.
-static const uint8_t etc2_dist_tbl[8] = {
+const uint8_t ImageDecoderPrivate::ETC2_dist_tbl[8] = {
 	 3,  6, 11, 16,
 	23, 32, 41, 64,
 };
 
 // ETC2 alpha modifiers table.
-static const int8_t etc2_alpha_tbl[16][8] = {
+const int8_t ImageDecoderPrivate::ETC2_alpha_tbl[16][8] = {
 	{-3, -6,  -9, -15, 2, 5, 8, 14},
 	{-3, -7, -10, -13, 2, 6, 9, 12},
 	{-2, -5,  -8, -13, 1, 4, 7, 12},
@@ -243,91 +131,6 @@ static const int8_t etc2_alpha_tbl[16][8] = {
 	{-3, -5,  -7,  -9, 2, 4, 6,  8},
 };
 
-/**
- * Extend a 4-bit color component to 8-bit color.
- * @param value 4-bit color component.
- * @return 8-bit color value.
- */
-static inline uint8_t extend_4to8bits(uint8_t value)
-{
-	return (value << 4) | value;
-}
-
-/**
- * Extend a 5-bit color component to 8-bit color.
- * @param value 5-bit color component.
- * @return 8-bit color value.
- */
-static inline uint8_t extend_5to8bits(uint8_t value)
-{
-	return (value << 3) | (value >> 2);
-}
-
-/**
- * Extend a 6-bit color component to 8-bit color.
- * @param value 6-bit color component.
- * @return 8-bit color value.
- */
-static inline uint8_t extend_6to8bits(uint8_t value)
-{
-	return (value << 2) | (value >> 4);
-}
-
-/**
- * Extend a 7-bit color component to 8-bit color.
- * @param value 7-bit color component.
- * @return 7-bit color value.
- */
-static inline uint8_t extend_7to8bits(uint8_t value)
-{
-	return (value << 1) | (value >> 6);
-}
-
-// Temporary RGB structure that allows us to clamp it later.
-// TODO: Use SSE2?
-struct ColorRGB {
-	int R;
-	int G;
-	int B;
-};
-
-/**
- * Clamp a ColorRGB struct and convert it to xRGB32.
- * @param color ColorRGB struct.
- * @return xRGB32 value. (Alpha channel set to 0xFF)
- */
-static inline uint32_t clamp_ColorRGB(const ColorRGB &color)
-{
-	uint32_t xrgb32 = 0;
-	if (color.B > 255) {
-		xrgb32 = 255;
-	} else if (color.B > 0) {
-		xrgb32 = color.B;
-	}
-	if (color.G > 255) {
-		xrgb32 |= (255 << 8);
-	} else if (color.G > 0) {
-		xrgb32 |= (color.G << 8);
-	}
-	if (color.R > 255) {
-		xrgb32 |= (255 << 16);
-	} else if (color.R > 0) {
-		xrgb32 |= (color.R << 16);
-	}
-	return xrgb32 | 0xFF000000;
-}
-
-// ETC decoding mode.
-enum ETC_Decoding_Mode {
-	// Bit 0: ETC1 vs. ETC2
-	ETC_DM_ETC1 = (0 << 0),	// ETC1
-	ETC_DM_ETC2 = (1 << 0),	// ETC2
-	ETC_DM_MASK12 = (1 << 0),
-
-	// Bit 1: ETC2 punchthrough alpha
-	ETC2_DM_A1 = (1 << 1),
-};
-
 /**
  * Decode an ETC1/ETC2 RGB block.
  * @param mode          [in] Mode flags.
@@ -337,9 +140,6 @@ enum ETC_Decoding_Mode {
 template</* ETC_Decoding_Mode */ unsigned int mode>
 static void decodeBlock_ETC_RGB(uint32_t tileBuf[4*4], const etc1_block *etc1_src)
 {
-	// Prevent invalid combinations from being used.
-	static_assert(mode != (ETC_DM_ETC1 | ETC2_DM_A1), "Cannot use ETC1 with punchthrough alpha.");
-
 	// Base colors.
 	// For ETC1 mode, these are used as base colors for the two subblocks.
 	// For 'T' and 'H' mode, these are used to calculate the paint colors.
@@ -352,152 +152,8 @@ static void decodeBlock_ETC_RGB(uint32_t tileBuf[4*4], const etc1_block *etc1_sr
 	uint32_t paint_color[4];
 
 	// ETC2 block mode.
-	etc2_block_mode block_mode = ETC2_BLOCK_MODE_UNKNOWN;
-
-	// TODO: Optimize the extend function by assuming the value is MSB-aligned.
-
-	// control, bit 1: diffbit
-	// NOTE: If using punchthrough alpha, this is repurposed as the opaque bit.
-	// Hence, individual mode is unavailable.
-	if (!(mode & ETC2_DM_A1) && !(etc1_src->control & 0x02)) {
-		// Individual mode.
-		block_mode = ETC2_BLOCK_MODE_ETC1;
-		base_color[0].R = extend_4to8bits(etc1_src->id.R >> 4);
-		base_color[0].G = extend_4to8bits(etc1_src->id.G >> 4);
-		base_color[0].B = extend_4to8bits(etc1_src->id.B >> 4);
-		base_color[1].R = extend_4to8bits(etc1_src->id.R & 0x0F);
-		base_color[1].G = extend_4to8bits(etc1_src->id.G & 0x0F);
-		base_color[1].B = extend_4to8bits(etc1_src->id.B & 0x0F);
-	} else {
-		// Other mode.
-
-		// Differential colors are 3-bit two's complement.
-		const int8_t dR2 = etc1_3bit_diff_tbl[etc1_src->id.R & 0x07];
-		const int8_t dG2 = etc1_3bit_diff_tbl[etc1_src->id.G & 0x07];
-		const int8_t dB2 = etc1_3bit_diff_tbl[etc1_src->id.B & 0x07];
-
-		// Sums of R+dR2, G+dG2, and B+dB2 are used to determine the mode.
-		// If all of the sums are within [0,31], ETC1 differential mode is used.
-		// Otherwise, a new ETC2 mode is used, which may discard some of the above values.
-		const int sR = (etc1_src->id.R >> 3) + dR2;
-		const int sG = (etc1_src->id.G >> 3) + dG2;
-		const int sB = (etc1_src->id.B >> 3) + dB2;
-
-		if ((mode & ETC_DM_MASK12) == ETC_DM_ETC2) {
-			// ETC2 block modes are available.
-			if ((sR & ~0x1F) != 0) {
-				// 'T' mode.
-				// Base colors are arranged differently compared to ETC1,
-				// and R1 is calculated differently.
-				// Note that G and B are arranged slightly differently.
-				block_mode = ETC2_BLOCK_MODE_TH;
-				base_color[0].R = extend_4to8bits(((etc1_src->t.R1 & 0x18) >> 1) |
-								   (etc1_src->t.R1 & 0x03));
-				base_color[0].G = extend_4to8bits(etc1_src->t.G1B1 >> 4);
-				base_color[0].B = extend_4to8bits(etc1_src->t.G1B1 & 0x0F);
-				base_color[1].R = extend_4to8bits(etc1_src->t.R2G2 >> 4);
-				base_color[1].G = extend_4to8bits(etc1_src->t.R2G2 & 0x0F);
-				base_color[1].B = extend_4to8bits(etc1_src->control >> 4);
-
-				// Determine the paint colors.
-				paint_color[0] = clamp_ColorRGB(base_color[0]);
-				paint_color[2] = clamp_ColorRGB(base_color[1]);
-
-				// Paint colors 1 and 3 are adjusted using the distance table.
-				const uint8_t d = etc2_dist_tbl[((etc1_src->control & 0x0C) >> 1) |
-								 (etc1_src->control & 0x01)];
-				ColorRGB tmp;
-				tmp.R = base_color[1].R + d;
-				tmp.G = base_color[1].G + d;
-				tmp.B = base_color[1].B + d;
-				paint_color[1] = clamp_ColorRGB(tmp);
-				tmp.R = base_color[1].R - d;
-				tmp.G = base_color[1].G - d;
-				tmp.B = base_color[1].B - d;
-				paint_color[3] = clamp_ColorRGB(tmp);
-			} else if ((sG & ~0x1F) != 0) {
-				// 'H' mode.
-				// Base colors are arranged differently compared to ETC1,
-				// and G1 and B1 are calculated differently.
-				block_mode = ETC2_BLOCK_MODE_TH;
-				base_color[0].R = extend_4to8bits(etc1_src->h.R1G1a >> 3);
-				base_color[0].G = extend_4to8bits(((etc1_src->h.R1G1a & 0x07) << 1) |
-								  ((etc1_src->h.G1bB1aB1b >> 4) & 0x01));
-				base_color[0].B = extend_4to8bits( (etc1_src->h.G1bB1aB1b & 0x08) |
-								  ((etc1_src->h.G1bB1aB1b & 0x03) << 1) |
-								   (etc1_src->h.B1bR2G2 >> 7));
-				base_color[1].R = extend_4to8bits(etc1_src->h.B1bR2G2 >> 3);
-				base_color[1].G = extend_4to8bits(((etc1_src->h.B1bR2G2 & 0x07) << 1) |
-								  (etc1_src->control >> 7));
-				base_color[1].B = extend_4to8bits((etc1_src->control >> 3) & 0x0F);
-
-				// Determine the paint colors.
-				// All paint colors in 'H' mode are adjusted using the distance table.
-				uint8_t d_idx = (etc1_src->control & 0x04) | ((etc1_src->control & 0x01) << 1);
-				// d_idx LSB is determined by comparing the base colors in xRGB32 format.
-				d_idx |= (clamp_ColorRGB(base_color[0]) >= clamp_ColorRGB(base_color[1]));
-
-				const uint8_t d = etc2_dist_tbl[d_idx];
-				ColorRGB tmp;
-				tmp.R = base_color[0].R + d;
-				tmp.G = base_color[0].G + d;
-				tmp.B = base_color[0].B + d;
-				paint_color[0] = clamp_ColorRGB(tmp);
-				tmp.R = base_color[0].R - d;
-				tmp.G = base_color[0].G - d;
-				tmp.B = base_color[0].B - d;
-				paint_color[1] = clamp_ColorRGB(tmp);
-				tmp.R = base_color[1].R + d;
-				tmp.G = base_color[1].G + d;
-				tmp.B = base_color[1].B + d;
-				paint_color[2] = clamp_ColorRGB(tmp);
-				tmp.R = base_color[1].R - d;
-				tmp.G = base_color[1].G - d;
-				tmp.B = base_color[1].B - d;
-				paint_color[3] = clamp_ColorRGB(tmp);
-			} else if ((sB & ~0x1F) != 0) {
-				// 'Planar' mode.
-				// TODO: Needs testing - I don't have a sample file with 'Planar' encoding.
-				block_mode = ETC2_BLOCK_MODE_PLANAR;
-
-				// 'O' color.
-				base_color[0].R = extend_6to8bits((etc1_src->planar.RO_GO1 >> 1) & 0x3F);
-				base_color[0].G = extend_7to8bits(((etc1_src->planar.RO_GO1 << 6) & 0x40) |
-								  ((etc1_src->planar.GO2_BO1 >> 1) & 0x3F));
-				base_color[0].B = extend_6to8bits(((etc1_src->planar.GO2_BO1 << 5) & 0x20) |
-								   (etc1_src->planar.BO2_BO3 & 0x18) |
-								  ((etc1_src->planar.BO2_BO3 << 1) & 0x06) |
-								   (etc1_src->planar.BO3_RH >> 7));
-
-				// 'H' color.
-				base_color[1].R = extend_6to8bits(((etc1_src->planar.BO3_RH >> 1) & 0x3C) |
-								   (etc1_src->planar.BO3_RH & 0x01));
-				base_color[1].G = extend_7to8bits(etc1_src->planar.GH_BH >> 1);
-				base_color[1].B = extend_6to8bits(((etc1_src->planar.GH_BH << 5) & 0x20) |
-								   (etc1_src->planar.BH_RV >> 3));
-
-				// 'V' color.
-				base_color[2].R = extend_6to8bits(((etc1_src->planar.BH_RV << 3) & 0x38) |
-								   (etc1_src->planar.RV_GV >> 5));
-				base_color[2].G = extend_7to8bits(((etc1_src->planar.RV_GV << 2) & 0x7C) |
-								   (etc1_src->planar.GV_BV >> 6));
-				base_color[2].B = extend_6to8bits(etc1_src->planar.GV_BV & 0x3F);
-			}
-		}
-
-		if ((mode & ETC_DM_MASK12) == ETC_DM_ETC1 ||
-		    block_mode == ETC2_BLOCK_MODE_UNKNOWN)
-		{
-			// ETC1 differential mode.
-			block_mode = ETC2_BLOCK_MODE_ETC1;
-			base_color[0].R = extend_5to8bits(etc1_src->id.R >> 3);
-			base_color[0].G = extend_5to8bits(etc1_src->id.G >> 3);
-			base_color[0].B = extend_5to8bits(etc1_src->id.B >> 3);
-			base_color[1].R = extend_5to8bits(sR);
-			base_color[1].G = extend_5to8bits(sG);
-			base_color[1].B = extend_5to8bits(sB);
-		}
-	}
+	const etc2_block_mode block_mode =
+		decodeBlockColors_ETC<mode>(etc1_src, base_color, paint_color);
 
 	// Tile arrangement:
 	// flip == 0        flip == 1
@@ -525,12 +181,12 @@ static void decodeBlock_ETC_RGB(uint32_t tileBuf[4*4], const etc1_block *etc1_sr
 			const int16_t *tbl[2];
 			if ((mode & ETC2_DM_A1) && !(etc1_src->control & 0x02)) {
 				// ETC2, punchthrough alpha: Opaque bit is unset.
-				tbl[0] = etc2_intensity_a1[ etc1_src->control >> 5];
-				tbl[1] = etc2_intensity_a1[(etc1_src->control >> 2) & 0x07];
+				tbl[0] = ImageDecoderPrivate::ETC2_intensity_a1[ etc1_src->control >> 5];
+				tbl[1] = ImageDecoderPrivate::ETC2_intensity_a1[(etc1_src->control >> 2) & 0x07];
 			} else {
 				// All other versions.
-				tbl[0] = etc1_intensity[ etc1_src->control >> 5];
-				tbl[1] = etc1_intensity[(etc1_src->control >> 2) & 0x07];
+				tbl[0] = ImageDecoderPrivate::ETC1_intensity[ etc1_src->control >> 5];
+				tbl[1] = ImageDecoderPrivate::ETC1_intensity[(etc1_src->control >> 2) & 0x07];
 			}
 
 			// control, bit 0: flip
@@ -615,13 +271,14 @@ static void decodeBlock_ETC_RGB(uint32_t tileBuf[4*4], const etc1_block *etc1_sr
 
 /**
  * Convert an ETC1 image to rp_image.
+ * Standard version using regular C++ code.
  * @param width Image width.
  * @param height Image height.
  * @param img_buf ETC1 image buffer.
  * @param img_siz Size of image data. [must be >= (w*h)/2]
  * @return rp_image, or nullptr on error.
  */
-rp_image *ImageDecoder::fromETC1(int width, int height,
+rp_image *ImageDecoder::fromETC1_cpp(int width, int height,
 	const uint8_t *RESTRICT img_buf, int img_siz)
 {
 	// Verify parameters.
@@ -677,13 +334,14 @@ rp_image *ImageDecoder::fromETC1(int width, int height,
 
 /**
  * Convert an ETC2 RGB image to rp_image.
+ * Standard version using regular C++ code.
  * @param width Image width.
  * @param height Image height.
  * @param img_buf ETC2 RGB image buffer.
  * @param img_siz Size of image data. [must be >= (w*h)/2]
  * @return rp_image, or nullptr on error.
  */
-rp_image *ImageDecoder::fromETC2_RGB(int width, int height,
+rp_image *ImageDecoder::fromETC2_RGB_cpp(int width, int height,
 	const uint8_t *RESTRICT img_buf, int img_siz)
 {
 	// Verify parameters.
@@ -754,7 +412,7 @@ static void decodeBlock_ETC2_alpha(uint32_t tileBuf[4*4], const etc2_alpha *alph
 	const uint8_t mult = (alpha->mult_tbl_idx >> 4);
 
 	// Table pointer.
-	const int8_t *const tbl = etc2_alpha_tbl[alpha->mult_tbl_idx & 0x0F];
+	const int8_t *const tbl = ImageDecoderPrivate::ETC2_alpha_tbl[alpha->mult_tbl_idx & 0x0F];
 
 	// TODO: Zero out the alpha channel in the entire tile using SIMD.
 
@@ -777,13 +435,14 @@ static void decodeBlock_ETC2_alpha(uint32_t tileBuf[4*4], const etc2_alpha *alph
 
 /**
  * Convert an ETC2 RGBA image to rp_image.
+ * Standard version using regular C++ code.
  * @param width Image width.
  * @param height Image height.
  * @param img_buf ETC2 RGBA image buffer.
  * @param img_siz Size of image data. [must be >= (w*h)]
  * @return rp_image, or nullptr on error.
  */
-rp_image *ImageDecoder::fromETC2_RGBA(int width, int height,
+rp_image *ImageDecoder::fromETC2_RGBA_cpp(int width, int height,
 	const uint8_t *RESTRICT img_buf, int img_siz)
 {
 	// Verify parameters.
@@ -843,13 +502,14 @@ rp_image *ImageDecoder::fromETC2_RGBA(int width, int height,
 
 /**
  * Convert an ETC2 RGB+A1 (punchthrough alpha) image to rp_image.
+ * Standard version using regular C++ code.
  * @param width Image width.
  * @param height Image height.
  * @param img_buf ETC2 RGB+A1 image buffer.
  * @param img_siz Size of image data. [must be >= (w*h)/2]
  * @return rp_image, or nullptr on error.
  */
-rp_image *ImageDecoder::fromETC2_RGB_A1(int width, int height,
+rp_image *ImageDecoder::fromETC2_RGB_A1_cpp(int width, int height,
 	const uint8_t *RESTRICT img_buf, int img_siz)
 {
 	// Verify parameters.
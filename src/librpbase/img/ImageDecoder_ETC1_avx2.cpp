@@ -0,0 +1,258 @@
+/***************************************************************************
+ * ROM Properties Page shell extension. (librpbase)                        *
+ * ImageDecoder_ETC1_avx2.cpp: Image decoding functions. (ETC1)            *
+ * AVX2-optimized version.                                                 *
+ *                                                                         *
+ * Copyright (c) 2016-2019 by David Korth.                                 *
+ *                                                                         *
+ * This program is free software; you can redistribute it and/or modify it *
+ * under the terms of the GNU General Public License as published by the   *
+ * Free Software Foundation; either version 2 of the License, or (at your  *
+ * option) any later version.                                              *
+ *                                                                         *
+ * This program is distributed in the hope that it will be useful, but     *
+ * WITHOUT ANY WARRANTY; without even the implied warranty of              *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the           *
+ * GNU General Public License for more details.                            *
+ *                                                                         *
+ * You should have received a copy of the GNU General Public License       *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.   *
+ ***************************************************************************/
+
+#include "config.librpbase.h"
+
+#include "ImageDecoder.hpp"
+#include "ImageDecoder_ETC1_sse41.hpp"
+
+// AVX2 headers.
+#include <immintrin.h>
+
+// Each 256-bit vector contains two horizontally-adjacent blocks:
+// the left block in the low 128 bits, and the right block in the
+// high 128 bits. The AVX2 byte shuffles and blends operate within
+// 128-bit lanes, so one row of a vector is one row of both blocks.
+
+namespace LibRpBase {
+
+/**
+ * Combine two 128-bit vectors into a 256-bit vector.
+ * @param lo Low 128 bits.
+ * @param hi High 128 bits.
+ * @return 256-bit vector.
+ */
+static FORCEINLINE __m256i combine_avx2(__m128i lo, __m128i hi)
+{
+	return _mm256_inserti128_si256(_mm256_castsi128_si256(lo), hi, 1);
+}
+
+/**
+ * Look up the pixels of two ETC blocks.
+ * @param rows		[out] Four rows of ARGB32 pixels.
+ * @param pal		[in] Palettes: entries 0-3 and 4-7 for each block. (ARGB32)
+ * @param offsets	[in] Palette byte offsets for each block, in row-major order.
+ */
+static FORCEINLINE void lookupRows_avx2(__m256i rows[4], const __m256i pal[2], __m256i offsets)
+{
+	const __m256i byte_offsets = _mm256_set1_epi32(0x03020100);
+	const __m256i row_inc = _mm256_set1_epi8(4);
+	__m256i row_sel = _mm256_broadcastsi128_si256(
+		_mm_setr_epi8(0,0,0,0, 1,1,1,1, 2,2,2,2, 3,3,3,3));
+	for (unsigned int y = 0; y < 4; y++) {
+		// VPSHUFB only uses the low 4 bits of the offset.
+		// Bit 4 selects the palette; shift it to bit 7 for VPBLENDVB.
+		const __m256i o = _mm256_add_epi8(_mm256_shuffle_epi8(offsets, row_sel), byte_offsets);
+		rows[y] = _mm256_blendv_epi8(_mm256_shuffle_epi8(pal[0], o),
+			_mm256_shuffle_epi8(pal[1], o), _mm256_slli_epi16(o, 3));
+		row_sel = _mm256_add_epi8(row_sel, row_inc);
+	}
+}
+
+/**
+ * Decode an ETC block to four row vectors.
+ * @tparam fmt ETC format.
+ * @param rows	[out] Four rows of ARGB32 pixels.
+ * @param blk	[in] Source block.
+ */
+template<ETC_SIMD_Format fmt>
+static FORCEINLINE void decodeBlock_rows(__m128i rows[4], const uint8_t *blk)
+{
+	const unsigned int colorOffset = (ETC_SIMD_Params<fmt>::blockSize == 16 ? 8 : 0);
+	__m128i pal[2], offsets;
+	if (ETC_SIMD_decodeBlock_RGB<fmt>(pal, offsets, rows,
+		reinterpret_cast<const etc1_block*>(blk + colorOffset)))
+	{
+		ETC_SIMD_lookupRows(rows, pal, offsets);
+	}
+	if (fmt == ETC_SIMD_ETC2_RGBA) {
+		ETC_SIMD_applyAlpha(rows, ETC_SIMD_decodeBlock_alpha(
+			reinterpret_cast<const etc2_alpha*>(blk)));
+	}
+}
+
+/**
+ * Convert an ETC image to rp_image.
+ * AVX2-optimized version.
+ *
+ * Blocks are decoded two at a time. If neither block uses
+ * 'Planar' mode, the pixels of both blocks are looked up
+ * with 256-bit vectors.
+ *
+ * @tparam fmt ETC format.
+ * @param width Image width.
+ * @param height Image height.
+ * @param img_buf Image buffer.
+ * @param img_siz Size of image data.
+ * @return rp_image, or nullptr on error.
+ */
+template<ETC_SIMD_Format fmt>
+static rp_image *T_fromETC_avx2(int width, int height,
+	const uint8_t *RESTRICT img_buf, int img_siz)
+{
+	rp_image *const img = ETC_SIMD_createImage<fmt>(width, height, img_buf, img_siz);
+	if (!img) {
+		return nullptr;
+	}
+
+	const unsigned int blockSize = ETC_SIMD_Params<fmt>::blockSize;
+	// ETC2 RGBA has the RGB block after the alpha block.
+	const unsigned int colorOffset = (blockSize == 16 ? 8 : 0);
+
+	const unsigned int tilesX = static_cast<unsigned int>(width / 4);
+	const unsigned int tilesY = static_cast<unsigned int>(height / 4);
+	const int stride_px = img->stride() / sizeof(uint32_t);
+	uint32_t *dest_row = static_cast<uint32_t*>(img->bits());
+
+	for (unsigned int y = 0; y < tilesY; y++, dest_row += (stride_px * 4)) {
+		uint32_t *dest = dest_row;
+		unsigned int x = 0;
+		for (; x + 2 <= tilesX; x += 2, dest += 8, img_buf += blockSize * 2) {
+			__m128i pal_lo[2], pal_hi[2], offsets_lo, offsets_hi;
+			__m128i rows_lo[4], rows_hi[4];
+			const bool lut_lo = ETC_SIMD_decodeBlock_RGB<fmt>(pal_lo, offsets_lo, rows_lo,
+				reinterpret_cast<const etc1_block*>(img_buf + colorOffset));
+			const bool lut_hi = ETC_SIMD_decodeBlock_RGB<fmt>(pal_hi, offsets_hi, rows_hi,
+				reinterpret_cast<const etc1_block*>(img_buf + blockSize + colorOffset));
+
+			__m256i rows[4];
+			if (likely(lut_lo && lut_hi)) {
+				const __m256i pal[2] = {
+					combine_avx2(pal_lo[0], pal_hi[0]),
+					combine_avx2(pal_lo[1], pal_hi[1]),
+				};
+				lookupRows_avx2(rows, pal, combine_avx2(offsets_lo, offsets_hi));
+			} else {
+				// At least one block uses 'Planar' mode.
+				if (lut_lo) {
+					ETC_SIMD_lookupRows(rows_lo, pal_lo, offsets_lo);
+				}
+				if (lut_hi) {
+					ETC_SIMD_lookupRows(rows_hi, pal_hi, offsets_hi);
+				}
+				rows[0] = combine_avx2(rows_lo[0], rows_hi[0]);
+				rows[1] = combine_avx2(rows_lo[1], rows_hi[1]);
+				rows[2] = combine_avx2(rows_lo[2], rows_hi[2]);
+				rows[3] = combine_avx2(rows_lo[3], rows_hi[3]);
+			}
+
+			if (fmt == ETC_SIMD_ETC2_RGBA) {
+				// Replace the alpha channels.
+				const __m256i a8 = combine_avx2(
+					ETC_SIMD_decodeBlock_alpha(reinterpret_cast<const etc2_alpha*>(img_buf)),
+					ETC_SIMD_decodeBlock_alpha(reinterpret_cast<const etc2_alpha*>(img_buf + blockSize)));
+				const __m256i zero = _mm256_setzero_si256();
+				const __m256i rgb_mask = _mm256_set1_epi32(0x00FFFFFF);
+				const __m256i a_lo = _mm256_unpacklo_epi8(zero, a8);
+				const __m256i a_hi = _mm256_unpackhi_epi8(zero, a8);
+				rows[0] = _mm256_or_si256(_mm256_and_si256(rows[0], rgb_mask), _mm256_unpacklo_epi16(zero, a_lo));
+				rows[1] = _mm256_or_si256(_mm256_and_si256(rows[1], rgb_mask), _mm256_unpackhi_epi16(zero, a_lo));
+				rows[2] = _mm256_or_si256(_mm256_and_si256(rows[2], rgb_mask), _mm256_unpacklo_epi16(zero, a_hi));
+				rows[3] = _mm256_or_si256(_mm256_and_si256(rows[3], rgb_mask), _mm256_unpackhi_epi16(zero, a_hi));
+			}
+
+			// Write the rows directly to the image.
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(dest), rows[0]);
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(dest + stride_px), rows[1]);
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(dest + stride_px*2), rows[2]);
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(dest + stride_px*3), rows[3]);
+		}
+
+		if (x < tilesX) {
+			// One block is left.
+			__m128i rows[4];
+			decodeBlock_rows<fmt>(rows, img_buf);
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(dest), rows[0]);
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(dest + stride_px), rows[1]);
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(dest + stride_px*2), rows[2]);
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(dest + stride_px*3), rows[3]);
+			img_buf += blockSize;
+		}
+	}
+
+	// Set the sBIT metadata.
+	ETC_SIMD_set_sBIT<fmt>(img);
+
+	// Image has been converted.
+	return img;
+}
+
+/**
+ * Convert an ETC1 image to rp_image.
+ * AVX2-optimized version.
+ * @param width Image width.
+ * @param height Image height.
+ * @param img_buf ETC1 image buffer.
+ * @param img_siz Size of image data. [must be >= (w*h)/2]
+ * @return rp_image, or nullptr on error.
+ */
+rp_image *ImageDecoder::fromETC1_avx2(int width, int height,
+	const uint8_t *RESTRICT img_buf, int img_siz)
+{
+	return T_fromETC_avx2<ETC_SIMD_ETC1>(width, height, img_buf, img_siz);
+}
+
+/**
+ * Convert an ETC2 RGB image to rp_image.
+ * AVX2-optimized version.
+ * @param width Image width.
+ * @param height Image height.
+ * @param img_buf ETC2 RGB image buffer.
+ * @param img_siz Size of image data. [must be >= (w*h)/2]
+ * @return rp_image, or nullptr on error.
+ */
+rp_image *ImageDecoder::fromETC2_RGB_avx2(int width, int height,
+	const uint8_t *RESTRICT img_buf, int img_siz)
+{
+	return T_fromETC_avx2<ETC_SIMD_ETC2_RGB>(width, height, img_buf, img_siz);
+}
+
+/**
+ * Convert an ETC2 RGBA image to rp_image.
+ * AVX2-optimized version.
+ * @param width Image width.
+ * @param height Image height.
+ * @param img_buf ETC2 RGBA image buffer.
+ * @param img_siz Size of image data. [must be >= (w*h)]
+ * @return rp_image, or nullptr on error.
+ */
+rp_image *ImageDecoder::fromETC2_RGBA_avx2(int width, int height,
+	const uint8_t *RESTRICT img_buf, int img_siz)
+{
+	return T_fromETC_avx2<ETC_SIMD_ETC2_RGBA>(width, height, img_buf, img_siz);
+}
+
+/**
+ * Convert an ETC2 RGB+A1 (punchthrough alpha) image to rp_image.
+ * AVX2-optimized version.
+ * @param width Image width.
+ * @param height Image height.
+ * @param img_buf ETC2 RGB+A1 image buffer.
+ * @param img_siz Size of image data. [must be >= (w*h)/2]
+ * @return rp_image, or nullptr on error.
+ */
+rp_image *ImageDecoder::fromETC2_RGB_A1_avx2(int width, int height,
+	const uint8_t *RESTRICT img_buf, int img_siz)
+{
+	return T_fromETC_avx2<ETC_SIMD_ETC2_RGB_A1>(width, height, img_buf, img_siz);
+}
+
+}
@@ -0,0 +1,394 @@
+/***************************************************************************
+ * ROM Properties Page shell extension. (librpbase)                        *
+ * ImageDecoder_ETC1_p.hpp: Image decoding functions. (ETC1)               *
+ * Block structures and common block decoding functions.                  *
+ *                                                                         *
+ * Copyright (c) 2016-2019 by David Korth.                                 *
+ *                                                                         *
+ * This program is free software; you can redistribute it and/or modify it *
+ * under the terms of the GNU General Public License as published by the   *
+ * Free Software Foundation; either version 2 of the License, or (at your  *
+ * option) any later version.                                              *
+ *                                                                         *
+ * This program is distributed in the hope that it will be useful, but     *
+ * WITHOUT ANY WARRANTY; without even the implied warranty of              *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the           *
+ * GNU General Public License for more details.                            *
+ *                                                                         *
+ * You should have received a copy of the GNU General Public License       *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.   *
+ ***************************************************************************/
+
+#ifndef __ROMPROPERTIES_LIBRPBASE_IMG_IMAGEDECODER_ETC1_P_HPP__
+#define __ROMPROPERTIES_LIBRPBASE_IMG_IMAGEDECODER_ETC1_P_HPP__
+
+#include "ImageDecoder_p.hpp"
+
+// References:
+// - https://www.khronos.org/registry/OpenGL/extensions/OES/OES_compressed_ETC1_RGB8_texture.txt
+// - https://www.khronos.org/registry/DataFormat/specs/1.1/dataformat.1.1.html#ETC1
+// - https://www.khronos.org/registry/DataFormat/specs/1.1/dataformat.1.1.html#ETC2
+
+// NOTE: This file is included by multiple source files that are
+// compiled with different CPU flags. All functions are static
+// so the linker doesn't merge functions built for different
+// instruction sets.
+
+namespace LibRpBase {
+
+#pragma pack(1)
+
+// ETC1 block format.
+// NOTE: Layout maps to on-disk format, which is big-endian.
+union PACKED etc1_block {
+	struct {
+		// Base colors
+		// Byte layout:
+		// - diffbit == 0: 4 MSB == base 1, 4 LSB == base 2
+		// - diffbit == 1: 5 MSB == base, 3 LSB == differential
+		union {
+			// Indiv/Diff
+			struct {
+				uint8_t R;
+				uint8_t G;
+				uint8_t B;
+			} id;
+
+			// ETC2 'T' mode
+			struct {
+				uint8_t R1;
+				uint8_t G1B1;
+				uint8_t R2G2;
+				// B2 is in `control`.
+			} t;
+
+			// ETC2 'H' mode
+			struct {
+				uint8_t R1G1a;
+				uint8_t G1bB1aB1b;
+				uint8_t B1bR2G2;
+				// Part of G2 is in `control`.
+				// B2 is in `control`.
+			} h;
+		};
+
+		// Control byte: [ETC1]
+		// - 3 MSB:  table code word 1
+		// - 3 next: table code word 2
+		// - 1 bit:  diff bit
+		// - 1 LSB:  flip bit
+		uint8_t control;
+
+		// Pixel index bits. (big-endian)
+		uint16_t msb;
+		uint16_t lsb;
+	};
+
+	struct {
+		// Planar mode has 3 colors in RGB676 format.
+		// Colors are labelled 'O', 'H', and 'V'.
+		uint8_t RO_GO1;		// 6-1: RO;     0: GO1
+		uint8_t GO2_BO1;	// 6-1: GO2;    0: BO1
+		uint8_t BO2_BO3;	// 4-3: BO2;  1-0: BO3a
+		uint8_t BO3_RH;		//   7: BO3b; 6-2: RH1; 0: RH2
+		uint8_t GH_BH;		// 7-1: GH;     0: BH
+		uint8_t BH_RV;		// 7-3: BH;   2-0: RV
+		uint8_t RV_GV;		// 7-5: RV;   4-0: GV
+		uint8_t GV_BV;		// 7-6: GV;   5-0: BV
+	} planar;
+};
+ASSERT_STRUCT(etc1_block, 8);
+
+// ETC2 alpha block format.
+// NOTE: Layout maps to on-disk format, which is big-endian.
+union etc2_alpha {
+	struct {
+		uint8_t base_codeword;	// Base codeword.
+		uint8_t mult_tbl_idx;	// Multiplier (high 4); table index (low 4)
+		uint8_t values[6];	// Alpha values. (48-bit unsigned; 3-bit per pixel)
+	};
+	uint64_t u64;				// Access the 48-bit alpha value directly. (Requires shifting.)
+};
+ASSERT_STRUCT(etc2_alpha, 8);
+
+// ETC2 RGBA block format.
+// NOTE: Layout maps to on-disk format, which is big-endian.
+struct etc2_rgba_block {
+	etc2_alpha alpha;
+	etc1_block etc1;
+};
+ASSERT_STRUCT(etc2_rgba_block, 16);
+
+#pragma pack()
+
+/**
+ * Extract the 48-bit code value from etc2_alpha.
+ * @param data etc2_alpha.
+ * @return 48-bit code value.
+ */
+static FORCEINLINE uint64_t extract48(const etc2_alpha *RESTRICT data)
+{
+	// values[6] starts at 0x02 within etc2_alpha.
+	// Hence, we need to mask it after byteswapping.
+	// TODO: constexpr?
+	// TODO: Verify on big-endian.
+	return be64_to_cpu(data->u64) & 0x0000FFFFFFFFFFFFULL;
+}
+
+// ETC2 block mode.
+enum etc2_block_mode {
+	ETC2_BLOCK_MODE_UNKNOWN = 0,
+	ETC2_BLOCK_MODE_ETC1,		// ETC1-compatible mode (indiv, diff)
+	ETC2_BLOCK_MODE_TH,		// ETC2 'T' or 'H' mode
+	ETC2_BLOCK_MODE_PLANAR,		// ETC2 'Planar' mode
+};
+
+/**
+ * Extend a 4-bit color component to 8-bit color.
+ * @param value 4-bit color component.
+ * @return 8-bit color value.
+ */
+static inline uint8_t extend_4to8bits(uint8_t value)
+{
+	return (value << 4) | value;
+}
+
+/**
+ * Extend a 5-bit color component to 8-bit color.
+ * @param value 5-bit color component.
+ * @return 8-bit color value.
+ */
+static inline uint8_t extend_5to8bits(uint8_t value)
+{
+	return (value << 3) | (value >> 2);
+}
+
+/**
+ * Extend a 6-bit color component to 8-bit color.
+ * @param value 6-bit color component.
+ * @return 8-bit color value.
+ */
+static inline uint8_t extend_6to8bits(uint8_t value)
+{
+	return (value << 2) | (value >> 4);
+}
+
+/**
+ * Extend a 7-bit color component to 8-bit color.
+ * @param value 7-bit color component.
+ * @return 7-bit color value.
+ */
+static inline uint8_t extend_7to8bits(uint8_t value)
+{
+	return (value << 1) | (value >> 6);
+}
+
+// Temporary RGB structure that allows us to clamp it later.
+struct ColorRGB {
+	int R;
+	int G;
+	int B;
+};
+
+/**
+ * Clamp a ColorRGB struct and convert it to xRGB32.
+ * @param color ColorRGB struct.
+ * @return xRGB32 value. (Alpha channel set to 0xFF)
+ */
+static inline uint32_t clamp_ColorRGB(const ColorRGB &color)
+{
+	uint32_t xrgb32 = 0;
+	if (color.B > 255) {
+		xrgb32 = 255;
+	} else if (color.B > 0) {
+		xrgb32 = color.B;
+	}
+	if (color.G > 255) {
+		xrgb32 |= (255 << 8);
+	} else if (color.G > 0) {
+		xrgb32 |= (color.G << 8);
+	}
+	if (color.R > 255) {
+		xrgb32 |= (255 << 16);
+	} else if (color.R > 0) {
+		xrgb32 |= (color.R << 16);
+	}
+	return xrgb32 | 0xFF000000;
+}
+
+// ETC decoding mode.
+enum ETC_Decoding_Mode {
+	// Bit 0: ETC1 vs. ETC2
+	ETC_DM_ETC1 = (0 << 0),	// ETC1
+	ETC_DM_ETC2 = (1 << 0),	// ETC2
+	ETC_DM_MASK12 = (1 << 0),
+
+	// Bit 1: ETC2 punchthrough alpha
+	ETC2_DM_A1 = (1 << 1),
+};
+
+/**
+ * Decode the base colors of an ETC1/ETC2 RGB block.
+ *
+ * The pixel indexes are not decoded here. This is shared by
+ * the standard and SIMD-optimized decoders, which differ only
+ * in how the colors are applied to the pixels.
+ *
+ * @param mode			[in] Mode flags.
+ * @param etc1_src		[in] Source RGB block.
+ * @param base_color		[out] ETC1, 'Planar': Base colors.
+ * @param paint_color		[out] 'T', 'H': Paint colors. (xRGB32)
+ * @return Block mode.
+ */
+template</* ETC_Decoding_Mode */ unsigned int mode>
+static FORCEINLINE etc2_block_mode decodeBlockColors_ETC(const etc1_block *etc1_src,
+	ColorRGB base_color[3], uint32_t paint_color[4])
+{
+	// Prevent invalid combinations from being used.
+	static_assert(mode != (ETC_DM_ETC1 | ETC2_DM_A1), "Cannot use ETC1 with punchthrough alpha.");
+
+	// TODO: Optimize the extend function by assuming the value is MSB-aligned.
+
+	// control, bit 1: diffbit
+	// NOTE: If using punchthrough alpha, this is repurposed as the opaque bit.
+	// Hence, individual mode is unavailable.
+	if (!(mode & ETC2_DM_A1) && !(etc1_src->control & 0x02)) {
+		// Individual mode.
+		base_color[0].R = extend_4to8bits(etc1_src->id.R >> 4);
+		base_color[0].G = extend_4to8bits(etc1_src->id.G >> 4);
+		base_color[0].B = extend_4to8bits(etc1_src->id.B >> 4);
+		base_color[1].R = extend_4to8bits(etc1_src->id.R & 0x0F);
+		base_color[1].G = extend_4to8bits(etc1_src->id.G & 0x0F);
+		base_color[1].B = extend_4to8bits(etc1_src->id.B & 0x0F);
+		return ETC2_BLOCK_MODE_ETC1;
+	}
+
+	// Other mode.
+
+	// Differential colors are 3-bit two's complement.
+	const int8_t dR2 = ImageDecoderPrivate::ETC1_3bit_diff_tbl[etc1_src->id.R & 0x07];
+	const int8_t dG2 = ImageDecoderPrivate::ETC1_3bit_diff_tbl[etc1_src->id.G & 0x07];
+	const int8_t dB2 = ImageDecoderPrivate::ETC1_3bit_diff_tbl[etc1_src->id.B & 0x07];
+
+	// Sums of R+dR2, G+dG2, and B+dB2 are used to determine the mode.
+	// If all of the sums are within [0,31], ETC1 differential mode is used.
+	// Otherwise, a new ETC2 mode is used, which may discard some of the above values.
+	const int sR = (etc1_src->id.R >> 3) + dR2;
+	const int sG = (etc1_src->id.G >> 3) + dG2;
+	const int sB = (etc1_src->id.B >> 3) + dB2;
+
+	if ((mode & ETC_DM_MASK12) == ETC_DM_ETC2) {
+		// ETC2 block modes are available.
+		if ((sR & ~0x1F) != 0) {
+			// 'T' mode.
+			// Base colors are arranged differently compared to ETC1,
+			// and R1 is calculated differently.
+			// Note that G and B are arranged slightly differently.
+			base_color[0].R = extend_4to8bits(((etc1_src->t.R1 & 0x18) >> 1) |
+							   (etc1_src->t.R1 & 0x03));
+			base_color[0].G = extend_4to8bits(etc1_src->t.G1B1 >> 4);
+			base_color[0].B = extend_4to8bits(etc1_src->t.G1B1 & 0x0F);
+			base_color[1].R = extend_4to8bits(etc1_src->t.R2G2 >> 4);
+			base_color[1].G = extend_4to8bits(etc1_src->t.R2G2 & 0x0F);
+			base_color[1].B = extend_4to8bits(etc1_src->control >> 4);
+
+			// Determine the paint colors.
+			paint_color[0] = clamp_ColorRGB(base_color[0]);
+			paint_color[2] = clamp_ColorRGB(base_color[1]);
+
+			// Paint colors 1 and 3 are adjusted using the distance table.
+			const uint8_t d = ImageDecoderPrivate::ETC2_dist_tbl[
+				((etc1_src->control & 0x0C) >> 1) | (etc1_src->control & 0x01)];
+			ColorRGB tmp;
+			tmp.R = base_color[1].R + d;
+			tmp.G = base_color[1].G + d;
+			tmp.B = base_color[1].B + d;
+			paint_color[1] = clamp_ColorRGB(tmp);
+			tmp.R = base_color[1].R - d;
+			tmp.G = base_color[1].G - d;
+			tmp.B = base_color[1].B - d;
+			paint_color[3] = clamp_ColorRGB(tmp);
+			return ETC2_BLOCK_MODE_TH;
+		} else if ((sG & ~0x1F) != 0) {
+			// 'H' mode.
+			// Base colors are arranged differently compared to ETC1,
+			// and G1 and B1 are calculated differently.
+			base_color[0].R = extend_4to8bits(etc1_src->h.R1G1a >> 3);
+			base_color[0].G = extend_4to8bits(((etc1_src->h.R1G1a & 0x07) << 1) |
+							  ((etc1_src->h.G1bB1aB1b >> 4) & 0x01));
+			base_color[0].B = extend_4to8bits( (etc1_src->h.G1bB1aB1b & 0x08) |
+							  ((etc1_src->h.G1bB1aB1b & 0x03) << 1) |
+							   (etc1_src->h.B1bR2G2 >> 7));
+			base_color[1].R = extend_4to8bits(etc1_src->h.B1bR2G2 >> 3);
+			base_color[1].G = extend_4to8bits(((etc1_src->h.B1bR2G2 & 0x07) << 1) |
+							  (etc1_src->control >> 7));
+			base_color[1].B = extend_4to8bits((etc1_src->control >> 3) & 0x0F);
+
+			// Determine the paint colors.
+			// All paint colors in 'H' mode are adjusted using the distance table.
+			uint8_t d_idx = (etc1_src->control & 0x04) | ((etc1_src->control & 0x01) << 1);
+			// d_idx LSB is determined by comparing the base colors in xRGB32 format.
+			d_idx |= (clamp_ColorRGB(base_color[0]) >= clamp_ColorRGB(base_color[1]));
+
+			const uint8_t d = ImageDecoderPrivate::ETC2_dist_tbl[d_idx];
+			ColorRGB tmp;
+			tmp.R = base_color[0].R + d;
+			tmp.G = base_color[0].G + d;
+			tmp.B = base_color[0].B + d;
+			paint_color[0] = clamp_ColorRGB(tmp);
+			tmp.R = base_color[0].R - d;
+			tmp.G = base_color[0].G - d;
+			tmp.B = base_color[0].B - d;
+			paint_color[1] = clamp_ColorRGB(tmp);
+			tmp.R = base_color[1].R + d;
+			tmp.G = base_color[1].G + d;
+			tmp.B = base_color[1].B + d;
+			paint_color[2] = clamp_ColorRGB(tmp);
+			tmp.R = base_color[1].R - d;
+			tmp.G = base_color[1].G - d;
+			tmp.B = base_color[1].B - d;
+			paint_color[3] = clamp_ColorRGB(tmp);
+			return ETC2_BLOCK_MODE_TH;
+		} else if ((sB & ~0x1F) != 0) {
+			// 'Planar' mode.
+			// TODO: Needs testing - I don't have a sample file with 'Planar' encoding.
+
+			// 'O' color.
+			base_color[0].R = extend_6to8bits((etc1_src->planar.RO_GO1 >> 1) & 0x3F);
+			base_color[0].G = extend_7to8bits(((etc1_src->planar.RO_GO1 << 6) & 0x40) |
+							  ((etc1_src->planar.GO2_BO1 >> 1) & 0x3F));
+			base_color[0].B = extend_6to8bits(((etc1_src->planar.GO2_BO1 << 5) & 0x20) |
+							   (etc1_src->planar.BO2_BO3 & 0x18) |
+							  ((etc1_src->planar.BO2_BO3 << 1) & 0x06) |
+							   (etc1_src->planar.BO3_RH >> 7));
+
+			// 'H' color.
+			base_color[1].R = extend_6to8bits(((etc1_src->planar.BO3_RH >> 1) & 0x3C) |
+							   (etc1_src->planar.BO3_RH & 0x01));
+			base_color[1].G = extend_7to8bits(etc1_src->planar.GH_BH >> 1);
+			base_color[1].B = extend_6to8bits(((etc1_src->planar.GH_BH << 5) & 0x20) |
+							   (etc1_src->planar.BH_RV >> 3));
+
+			// 'V' color.
+			base_color[2].R = extend_6to8bits(((etc1_src->planar.BH_RV << 3) & 0x38) |
+							   (etc1_src->planar.RV_GV >> 5));
+			base_color[2].G = extend_7to8bits(((etc1_src->planar.RV_GV << 2) & 0x7C) |
+							   (etc1_src->planar.GV_BV >> 6));
+			base_color[2].B = extend_6to8bits(etc1_src->planar.GV_BV & 0x3F);
+			return ETC2_BLOCK_MODE_PLANAR;
+		}
+	}
+
+	// ETC1 differential mode.
+	base_color[0].R = extend_5to8bits(etc1_src->id.R >> 3);
+	base_color[0].G = extend_5to8bits(etc1_src->id.G >> 3);
+	base_color[0].B = extend_5to8bits(etc1_src->id.B >> 3);
+	base_color[1].R = extend_5to8bits(sR);
+	base_color[1].G = extend_5to8bits(sG);
+	base_color[1].B = extend_5to8bits(sB);
+	return ETC2_BLOCK_MODE_ETC1;
+}
+
+}
+
+#endif /* __ROMPROPERTIES_LIBRPBASE_IMG_IMAGEDECODER_ETC1_P_HPP__ */
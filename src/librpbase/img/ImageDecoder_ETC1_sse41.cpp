@@ -0,0 +1,150 @@
+/***************************************************************************
+ * ROM Properties Page shell extension. (librpbase)                        *
+ * ImageDecoder_ETC1_sse41.cpp: Image decoding functions. (ETC1)           *
+ * SSE4.1-optimized version.                                               *
+ *                                                                         *
+ * Copyright (c) 2016-2019 by David Korth.                                 *
+ *                                                                         *
+ * This program is free software; you can redistribute it and/or modify it *
+ * under the terms of the GNU General Public License as published by the   *
+ * Free Software Foundation; either version 2 of the License, or (at your  *
+ * option) any later version.                                              *
+ *                                                                         *
+ * This program is distributed in the hope that it will be useful, but     *
+ * WITHOUT ANY WARRANTY; without even the implied warranty of              *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the           *
+ * GNU General Public License for more details.                            *
+ *                                                                         *
+ * You should have received a copy of the GNU General Public License       *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.   *
+ ***************************************************************************/
+
+#include "config.librpbase.h"
+
+#include "ImageDecoder.hpp"
+#include "ImageDecoder_ETC1_sse41.hpp"
+
+namespace LibRpBase {
+
+/**
+ * Convert an ETC image to rp_image.
+ * SSE4.1-optimized version.
+ *
+ * Each block is decoded into four row vectors,
+ * which are written directly to the image.
+ *
+ * @tparam fmt ETC format.
+ * @param width Image width.
+ * @param height Image height.
+ * @param img_buf Image buffer.
+ * @param img_siz Size of image data.
+ * @return rp_image, or nullptr on error.
+ */
+template<ETC_SIMD_Format fmt>
+static rp_image *T_fromETC_sse41(int width, int height,
+	const uint8_t *RESTRICT img_buf, int img_siz)
+{
+	rp_image *const img = ETC_SIMD_createImage<fmt>(width, height, img_buf, img_siz);
+	if (!img) {
+		return nullptr;
+	}
+
+	const unsigned int blockSize = ETC_SIMD_Params<fmt>::blockSize;
+	// ETC2 RGBA has the RGB block after the alpha block.
+	const unsigned int colorOffset = (blockSize == 16 ? 8 : 0);
+
+	const unsigned int tilesX = static_cast<unsigned int>(width / 4);
+	const unsigned int tilesY = static_cast<unsigned int>(height / 4);
+	const int stride_px = img->stride() / sizeof(uint32_t);
+	uint32_t *dest_row = static_cast<uint32_t*>(img->bits());
+
+	for (unsigned int y = 0; y < tilesY; y++, dest_row += (stride_px * 4)) {
+		uint32_t *dest = dest_row;
+		for (unsigned int x = 0; x < tilesX; x++, dest += 4, img_buf += blockSize) {
+			__m128i pal[2], offsets, rows[4];
+			if (ETC_SIMD_decodeBlock_RGB<fmt>(pal, offsets, rows,
+				reinterpret_cast<const etc1_block*>(img_buf + colorOffset)))
+			{
+				ETC_SIMD_lookupRows(rows, pal, offsets);
+			}
+			if (fmt == ETC_SIMD_ETC2_RGBA) {
+				ETC_SIMD_applyAlpha(rows, ETC_SIMD_decodeBlock_alpha(
+					reinterpret_cast<const etc2_alpha*>(img_buf)));
+			}
+
+			// Write the rows directly to the image.
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(dest), rows[0]);
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(dest + stride_px), rows[1]);
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(dest + stride_px*2), rows[2]);
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(dest + stride_px*3), rows[3]);
+		}
+	}
+
+	// Set the sBIT metadata.
+	ETC_SIMD_set_sBIT<fmt>(img);
+
+	// Image has been converted.
+	return img;
+}
+
+/**
+ * Convert an ETC1 image to rp_image.
+ * SSE4.1-optimized version.
+ * @param width Image width.
+ * @param height Image height.
+ * @param img_buf ETC1 image buffer.
+ * @param img_siz Size of image data. [must be >= (w*h)/2]
+ * @return rp_image, or nullptr on error.
+ */
+rp_image *ImageDecoder::fromETC1_sse41(int width, int height,
+	const uint8_t *RESTRICT img_buf, int img_siz)
+{
+	return T_fromETC_sse41<ETC_SIMD_ETC1>(width, height, img_buf, img_siz);
+}
+
+/**
+ * Convert an ETC2 RGB image to rp_image.
+ * SSE4.1-optimized version.
+ * @param width Image width.
+ * @param height Image height.
+ * @param img_buf ETC2 RGB image buffer.
+ * @param img_siz Size of image data. [must be >= (w*h)/2]
+ * @return rp_image, or nullptr on error.
+ */
+rp_image *ImageDecoder::fromETC2_RGB_sse41(int width, int height,
+	const uint8_t *RESTRICT img_buf, int img_siz)
+{
+	return T_fromETC_sse41<ETC_SIMD_ETC2_RGB>(width, height, img_buf, img_siz);
+}
+
+/**
+ * Convert an ETC2 RGBA image to rp_image.
+ * SSE4.1-optimized version.
+ * @param width Image width.
+ * @param height Image height.
+ * @param img_buf ETC2 RGBA image buffer.
+ * @param img_siz Size of image data. [must be >= (w*h)]
+ * @return rp_image, or nullptr on error.
+ */
+rp_image *ImageDecoder::fromETC2_RGBA_sse41(int width, int height,
+	const uint8_t *RESTRICT img_buf, int img_siz)
+{
+	return T_fromETC_sse41<ETC_SIMD_ETC2_RGBA>(width, height, img_buf, img_siz);
+}
+
+/**
+ * Convert an ETC2 RGB+A1 (punchthrough alpha) image to rp_image.
+ * SSE4.1-optimized version.
+ * @param width Image width.
+ * @param height Image height.
+ * @param img_buf ETC2 RGB+A1 image buffer.
+ * @param img_siz Size of image data. [must be >= (w*h)/2]
+ * @return rp_image, or nullptr on error.
+ */
+rp_image *ImageDecoder::fromETC2_RGB_A1_sse41(int width, int height,
+	const uint8_t *RESTRICT img_buf, int img_siz)
+{
+	return T_fromETC_sse41<ETC_SIMD_ETC2_RGB_A1>(width, height, img_buf, img_siz);
+}
+
+}
@@ -0,0 +1,378 @@
+/***************************************************************************
+ * ROM Properties Page shell extension. (librpbase)                        *
+ * ImageDecoder_ETC1_sse41.hpp: Image decoding functions. (ETC1)           *
+ * Common SSE4.1 functions for the SIMD-optimized ETC decoders.            *
+ *                                                                         *
+ * Copyright (c) 2016-2019 by David Korth.                                 *
+ *                                                                         *
+ * This program is free software; you can redistribute it and/or modify it *
+ * under the terms of the GNU General Public License as published by the   *
+ * Free Software Foundation; either version 2 of the License, or (at your  *
+ * option) any later version.                                              *
+ *                                                                         *
+ * This program is distributed in the hope that it will be useful, but     *
+ * WITHOUT ANY WARRANTY; without even the implied warranty of              *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the           *
+ * GNU General Public License for more details.                            *
+ *                                                                         *
+ * You should have received a copy of the GNU General Public License       *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.   *
+ ***************************************************************************/
+
+#ifndef __ROMPROPERTIES_LIBRPBASE_IMG_IMAGEDECODER_ETC1_SSE41_HPP__
+#define __ROMPROPERTIES_LIBRPBASE_IMG_IMAGEDECODER_ETC1_SSE41_HPP__
+
+// NOTE: This header must only be included by source files
+// that are compiled with SSE4.1 (or later) enabled.
+// All functions are static in order to prevent the linker
+// from merging copies compiled for different instruction sets.
+
+#include "ImageDecoder_ETC1_p.hpp"
+#include "img/rp_image.hpp"
+
+// C includes. (C++ namespace)
+#include <cassert>
+
+// SSE4.1 headers.
+#include <smmintrin.h>
+
+// The block colors are decoded using the standard C++ code.
+// Everything after that is done with vectors:
+// - ETC1, 'T', 'H': Up to eight palette entries are calculated
+//   using saturated arithmetic, and the pixels are looked up
+//   using PSHUFB, with PBLENDVB selecting the subblock.
+// - 'Planar': All 16 pixels are interpolated using 16-bit math.
+// - ETC2 alpha: The 3-bit codes are extracted using PMULLW as a
+//   per-lane shift, then looked up using PSHUFB.
+
+namespace LibRpBase {
+
+// ETC formats handled by the SIMD-optimized decoders.
+enum ETC_SIMD_Format {
+	ETC_SIMD_ETC1,		// ETC1
+	ETC_SIMD_ETC2_RGB,	// ETC2 RGB
+	ETC_SIMD_ETC2_RGBA,	// ETC2 RGBA (EAC alpha block)
+	ETC_SIMD_ETC2_RGB_A1,	// ETC2 RGB with punchthrough alpha
+};
+
+/**
+ * ETC format properties.
+ * @tparam fmt ETC format.
+ */
+template<ETC_SIMD_Format fmt>
+struct ETC_SIMD_Params {
+	enum {
+		// Decoding mode for decodeBlockColors_ETC().
+		mode = (fmt == ETC_SIMD_ETC1 ? ETC_DM_ETC1 :
+			(fmt == ETC_SIMD_ETC2_RGB_A1 ? (ETC_DM_ETC2 | ETC2_DM_A1) : ETC_DM_ETC2)),
+
+		// Block size, in bytes.
+		blockSize = (fmt == ETC_SIMD_ETC2_RGBA ? 16 : 8),
+	};
+};
+
+/**
+ * Validate parameters and create an rp_image for an ETC image.
+ * @tparam fmt ETC format.
+ * @param width Image width.
+ * @param height Image height.
+ * @param img_buf Image buffer.
+ * @param img_siz Size of image data.
+ * @return rp_image, or nullptr on error.
+ */
+template<ETC_SIMD_Format fmt>
+static inline rp_image *ETC_SIMD_createImage(int width, int height,
+	const uint8_t *RESTRICT img_buf, int img_siz)
+{
+	// Verify parameters.
+	// 8-byte blocks use 4 bits per pixel; 16-byte blocks use 8 bits per pixel.
+	const int min_siz = (ETC_SIMD_Params<fmt>::blockSize == 8)
+		? ((width * height) / 2)
+		: (width * height);
+	assert(img_buf != nullptr);
+	assert(width > 0);
+	assert(height > 0);
+	assert(img_siz >= min_siz);
+	if (!img_buf || width <= 0 || height <= 0 || img_siz < min_siz) {
+		return nullptr;
+	}
+
+	// ETC uses 4x4 tiles.
+	assert(width % 4 == 0);
+	assert(height % 4 == 0);
+	if (width % 4 != 0 || height % 4 != 0)
+		return nullptr;
+
+	// Create an rp_image.
+	rp_image *img = new rp_image(width, height, rp_image::FORMAT_ARGB32);
+	if (!img->isValid()) {
+		// Could not allocate the image.
+		delete img;
+		return nullptr;
+	}
+	return img;
+}
+
+/**
+ * Set the sBIT metadata for an ETC image.
+ * @tparam fmt ETC format.
+ * @param img rp_image.
+ */
+template<ETC_SIMD_Format fmt>
+static inline void ETC_SIMD_set_sBIT(rp_image *img)
+{
+	static const rp_image::sBIT_t sBIT_RGB    = {8,8,8,0,0};
+	static const rp_image::sBIT_t sBIT_RGBA   = {8,8,8,0,8};
+	static const rp_image::sBIT_t sBIT_RGB_A1 = {8,8,8,0,1};
+
+	switch (fmt) {
+		case ETC_SIMD_ETC1:
+		case ETC_SIMD_ETC2_RGB:
+			img->set_sBIT(&sBIT_RGB);
+			break;
+		case ETC_SIMD_ETC2_RGBA:
+			img->set_sBIT(&sBIT_RGBA);
+			break;
+		case ETC_SIMD_ETC2_RGB_A1:
+			img->set_sBIT(&sBIT_RGB_A1);
+			break;
+	}
+}
+
+/**
+ * Load a base color as 16-bit components.
+ * Components are in BGRA order, with alpha set to 0.
+ * @param color Base color. (components must be within [0,255])
+ * @return Two copies of the color.
+ */
+static FORCEINLINE __m128i ETC_SIMD_loadColor16(const ColorRGB &color)
+{
+	const __m128i c = _mm_unpacklo_epi8(_mm_cvtsi32_si128(
+		color.B | (color.G << 8) | (color.R << 16)), _mm_setzero_si128());
+	return _mm_unpacklo_epi64(c, c);
+}
+
+/**
+ * Get the palette byte offsets of an ETC block's pixels.
+ * @param blk ETC block. (low 64 bits)
+ * @return Byte offsets (index * 4) for all 16 pixels, in row-major order.
+ */
+static FORCEINLINE __m128i ETC_SIMD_pixelOffsets(__m128i blk)
+{
+	// Pixels are stored by column, then by row, so pixel (x,y)
+	// is bit (x*4)+y of the big-endian LSB and MSB words.
+	// Copy the byte containing each pixel's bit to the pixel's
+	// lane, then check the bit.
+	const __m128i lsb = _mm_shuffle_epi8(blk,
+		_mm_setr_epi8(7,7,6,6, 7,7,6,6, 7,7,6,6, 7,7,6,6));
+	const __m128i msb = _mm_shuffle_epi8(blk,
+		_mm_setr_epi8(5,5,4,4, 5,5,4,4, 5,5,4,4, 5,5,4,4));
+	const __m128i bit = _mm_setr_epi8(
+		0x01,0x10,0x01,0x10, 0x02,0x20,0x02,0x20,
+		0x04,0x40,0x04,0x40, 0x08,static_cast<int8_t>(0x80),0x08,static_cast<int8_t>(0x80));
+	const __m128i l = _mm_cmpeq_epi8(_mm_and_si128(lsb, bit), bit);
+	const __m128i m = _mm_cmpeq_epi8(_mm_and_si128(msb, bit), bit);
+	return _mm_or_si128(_mm_and_si128(l, _mm_set1_epi8(4)), _mm_and_si128(m, _mm_set1_epi8(8)));
+}
+
+/**
+ * Calculate the palettes for an ETC1-mode block.
+ * @param pal		[out] Palettes: pal[0] for subblock 0; pal[1] for subblock 1. (ARGB32)
+ * @param base_color	[in] Base colors.
+ * @param tbl0		[in] Intensity modifiers for subblock 0.
+ * @param tbl1		[in] Intensity modifiers for subblock 1.
+ */
+static FORCEINLINE void ETC_SIMD_palette_ETC1(__m128i pal[2], const ColorRGB base_color[2],
+	const int16_t *tbl0, const int16_t *tbl1)
+{
+	// Copy each modifier to the B, G, and R components.
+	const __m128i sel01 = _mm_setr_epi8(0,1, 0,1, 0,1, -1,-1, 2,3, 2,3, 2,3, -1,-1);
+	const __m128i sel23 = _mm_setr_epi8(4,5, 4,5, 4,5, -1,-1, 6,7, 6,7, 6,7, -1,-1);
+	const __m128i alpha = _mm_set1_epi32(static_cast<int>(0xFF000000));
+
+	const __m128i t0 = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(tbl0));
+	const __m128i t1 = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(tbl1));
+	const __m128i b0 = ETC_SIMD_loadColor16(base_color[0]);
+	const __m128i b1 = ETC_SIMD_loadColor16(base_color[1]);
+
+	// Saturated packing clamps the components to [0,255].
+	pal[0] = _mm_or_si128(_mm_packus_epi16(
+		_mm_add_epi16(b0, _mm_shuffle_epi8(t0, sel01)),
+		_mm_add_epi16(b0, _mm_shuffle_epi8(t0, sel23))), alpha);
+	pal[1] = _mm_or_si128(_mm_packus_epi16(
+		_mm_add_epi16(b1, _mm_shuffle_epi8(t1, sel01)),
+		_mm_add_epi16(b1, _mm_shuffle_epi8(t1, sel23))), alpha);
+}
+
+/**
+ * Decode an ETC2 'Planar' mode block.
+ * @param rows		[out] Four rows of ARGB32 pixels.
+ * @param base_color	[in] Colors 'O', 'H', and 'V'.
+ */
+static FORCEINLINE void ETC_SIMD_planar(__m128i rows[4], const ColorRGB base_color[3])
+{
+	// Each pixel is (x*(H-O) + y*(V-O) + 4*O + 2) >> 2.
+	// The low half of each vector has x=0,1; the high half has x=2,3.
+	const __m128i o = ETC_SIMD_loadColor16(base_color[0]);
+	const __m128i dH = _mm_sub_epi16(ETC_SIMD_loadColor16(base_color[1]), o);
+	const __m128i dV = _mm_sub_epi16(ETC_SIMD_loadColor16(base_color[2]), o);
+	const __m128i alpha = _mm_set1_epi32(static_cast<int>(0xFF000000));
+
+	__m128i lo = _mm_add_epi16(_mm_add_epi16(_mm_slli_epi16(o, 2), _mm_set1_epi16(2)),
+		_mm_unpacklo_epi64(_mm_setzero_si128(), dH));
+	__m128i hi = _mm_add_epi16(lo, _mm_add_epi16(dH, dH));
+	for (unsigned int y = 0; y < 4; y++) {
+		// Saturated packing clamps the components to [0,255].
+		rows[y] = _mm_or_si128(_mm_packus_epi16(
+			_mm_srai_epi16(lo, 2), _mm_srai_epi16(hi, 2)), alpha);
+		lo = _mm_add_epi16(lo, dV);
+		hi = _mm_add_epi16(hi, dV);
+	}
+}
+
+/**
+ * Decode an ETC1/ETC2 RGB block.
+ *
+ * ETC1, 'T', and 'H' blocks are returned as palettes and
+ * byte offsets, which are looked up by ETC_SIMD_lookupRows().
+ * This allows the AVX2 decoder to look up two blocks at once.
+ *
+ * @tparam fmt ETC format.
+ * @param pal		[out] Palettes: entries 0-3 and 4-7. (ARGB32)
+ * @param offsets	[out] Palette byte offsets, in row-major order.
+ * @param rows		[out] 'Planar': Four rows of ARGB32 pixels.
+ * @param etc1_src	[in] Source RGB block.
+ * @return True if pal and offsets were set; false if rows was set.
+ */
+template<ETC_SIMD_Format fmt>
+static FORCEINLINE bool ETC_SIMD_decodeBlock_RGB(__m128i pal[2], __m128i &offsets,
+	__m128i rows[4], const etc1_block *etc1_src)
+{
+	ColorRGB base_color[3];
+	uint32_t paint_color[4];
+	const etc2_block_mode block_mode = decodeBlockColors_ETC<ETC_SIMD_Params<fmt>::mode>(
+		etc1_src, base_color, paint_color);
+
+	// ETC2, punchthrough alpha: Opaque bit is unset.
+	const bool a1_transparent = (fmt == ETC_SIMD_ETC2_RGB_A1 && !(etc1_src->control & 0x02));
+
+	const __m128i blk = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(etc1_src));
+	if (block_mode == ETC2_BLOCK_MODE_PLANAR) {
+		// ETC2 'Planar' mode.
+		// NOTE: Punchthrough alpha is not used in this mode.
+		ETC_SIMD_planar(rows, base_color);
+		return false;
+	} else if (block_mode == ETC2_BLOCK_MODE_TH) {
+		// ETC2 'T' or 'H' mode.
+		// Pixel index indicates the paint color to use.
+		pal[0] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(paint_color));
+		pal[1] = pal[0];
+		offsets = ETC_SIMD_pixelOffsets(blk);
+	} else {
+		// ETC1 block mode.
+		const int16_t (*const intensity)[4] = (a1_transparent
+			? ImageDecoderPrivate::ETC2_intensity_a1
+			: ImageDecoderPrivate::ETC1_intensity);
+		ETC_SIMD_palette_ETC1(pal, base_color,
+			intensity[ etc1_src->control >> 5],
+			intensity[(etc1_src->control >> 2) & 0x07]);
+
+		// control, bit 0: flip
+		// Subblock 1 uses the second palette. (offset 16)
+		// - flip == 0: 2x4 subblocks (right half)
+		// - flip == 1: 4x2 subblocks (bottom half)
+		const __m128i subblock = (etc1_src->control & 0x01)
+			? _mm_setr_epi8(0,0,0,0, 0,0,0,0, 16,16,16,16, 16,16,16,16)
+			: _mm_setr_epi8(0,0,16,16, 0,0,16,16, 0,0,16,16, 0,0,16,16);
+		offsets = _mm_or_si128(ETC_SIMD_pixelOffsets(blk), subblock);
+	}
+
+	if (a1_transparent) {
+		// Pixel index 2 is completely transparent.
+		const __m128i mask = _mm_setr_epi32(-1, -1, 0, -1);
+		pal[0] = _mm_and_si128(pal[0], mask);
+		pal[1] = _mm_and_si128(pal[1], mask);
+	}
+	return true;
+}
+
+/**
+ * Look up the pixels of an ETC block.
+ * @param rows		[out] Four rows of ARGB32 pixels.
+ * @param pal		[in] Palettes: entries 0-3 and 4-7. (ARGB32)
+ * @param offsets	[in] Palette byte offsets, in row-major order.
+ */
+static FORCEINLINE void ETC_SIMD_lookupRows(__m128i rows[4], const __m128i pal[2], __m128i offsets)
+{
+	const __m128i byte_offsets = _mm_set1_epi32(0x03020100);
+	const __m128i row_inc = _mm_set1_epi8(4);
+	__m128i row_sel = _mm_setr_epi8(0,0,0,0, 1,1,1,1, 2,2,2,2, 3,3,3,3);
+	for (unsigned int y = 0; y < 4; y++) {
+		// PSHUFB only uses the low 4 bits of the offset.
+		// Bit 4 selects the palette; shift it to bit 7 for PBLENDVB.
+		const __m128i o = _mm_add_epi8(_mm_shuffle_epi8(offsets, row_sel), byte_offsets);
+		rows[y] = _mm_blendv_epi8(_mm_shuffle_epi8(pal[0], o),
+			_mm_shuffle_epi8(pal[1], o), _mm_slli_epi16(o, 3));
+		row_sel = _mm_add_epi8(row_sel, row_inc);
+	}
+}
+
+/**
+ * Decode an ETC2 alpha block.
+ * @param alpha Source alpha block.
+ * @return 16 alpha values, in row-major order.
+ */
+static FORCEINLINE __m128i ETC_SIMD_decodeBlock_alpha(const etc2_alpha *alpha)
+{
+	// Get the base codeword and multiplier.
+	// NOTE: mult == 0 is not allowed to be used by the encoder,
+	// but the specification requires decoders to handle it.
+	const int base = alpha->base_codeword;
+	const int mult = (alpha->mult_tbl_idx >> 4);
+
+	// Calculate the palette.
+	// Saturated packing clamps the values to [0,255].
+	const __m128i tbl = _mm_cvtepi8_epi16(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(
+		ImageDecoderPrivate::ETC2_alpha_tbl[alpha->mult_tbl_idx & 0x0F])));
+	__m128i pal = _mm_add_epi16(_mm_mullo_epi16(tbl, _mm_set1_epi16(mult)), _mm_set1_epi16(base));
+	pal = _mm_packus_epi16(pal, pal);
+
+	// Pixel (x,y) uses bits 3i to 3i+2 of the big-endian 48-bit code value,
+	// where i = (x*4)+y. Copy the two bytes containing each pixel's code
+	// to a 16-bit lane, then shift the code to bits 7-9 by multiplying.
+	const __m128i blk = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(alpha));
+	const __m128i w_lo = _mm_shuffle_epi8(blk,
+		_mm_setr_epi8(7,6, 6,5, 4,3, 3,2, 7,6, 6,5, 4,3, 3,2));
+	const __m128i w_hi = _mm_shuffle_epi8(blk,
+		_mm_setr_epi8(7,6, 5,4, 4,3, 2,1, 6,5, 5,4, 3,2, 2,1));
+	const __m128i mask3 = _mm_set1_epi16(7);
+	const __m128i c_lo = _mm_and_si128(_mm_srli_epi16(_mm_mullo_epi16(w_lo,
+		_mm_setr_epi16(128, 8, 128, 8, 16, 1, 16, 1)), 7), mask3);
+	const __m128i c_hi = _mm_and_si128(_mm_srli_epi16(_mm_mullo_epi16(w_hi,
+		_mm_setr_epi16(2, 32, 2, 32, 64, 4, 64, 4)), 7), mask3);
+	const __m128i codes = _mm_packus_epi16(c_lo, c_hi);
+
+	// Look up the palette entries.
+	return _mm_shuffle_epi8(pal, codes);
+}
+
+/**
+ * Replace the alpha channels of four rows of ARGB32 pixels.
+ * @param rows	[in/out] Four rows of ARGB32 pixels.
+ * @param a8	[in] 16 alpha values.
+ */
+static FORCEINLINE void ETC_SIMD_applyAlpha(__m128i rows[4], __m128i a8)
+{
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i rgb_mask = _mm_set1_epi32(0x00FFFFFF);
+	const __m128i a_lo = _mm_unpacklo_epi8(zero, a8);
+	const __m128i a_hi = _mm_unpackhi_epi8(zero, a8);
+	rows[0] = _mm_or_si128(_mm_and_si128(rows[0], rgb_mask), _mm_unpacklo_epi16(zero, a_lo));
+	rows[1] = _mm_or_si128(_mm_and_si128(rows[1], rgb_mask), _mm_unpackhi_epi16(zero, a_lo));
+	rows[2] = _mm_or_si128(_mm_and_si128(rows[2], rgb_mask), _mm_unpacklo_epi16(zero, a_hi));
+	rows[3] = _mm_or_si128(_mm_and_si128(rows[3], rgb_mask), _mm_unpackhi_epi16(zero, a_hi));
+}
+
+}
+
+#endif /* __ROMPROPERTIES_LIBRPBASE_IMG_IMAGEDECODER_ETC1_SSE41_HPP__ */
@@ -0,0 +1,391 @@
+/***************************************************************************
+ * ROM Properties Page shell extension. (librpbase)                        *
+ * ImageDecoder_ROI.cpp: Image decoding functions.                         *
+ * (Region-of-interest and reduced-resolution decoding)                    *
+ *                                                                         *
+ * Copyright (c) 2016-2019 by David Korth.                                 *
+ *                                                                         *
+ * This program is free software; you can redistribute it and/or modify it *
+ * under the terms of the GNU General Public License as published by the   *
+ * Free Software Foundation; either version 2 of the License, or (at your  *
+ * option) any later version.                                              *
+ *                                                                         *
+ * This program is distributed in the hope that it will be useful, but     *
+ * WITHOUT ANY WARRANTY; without even the implied warranty of              *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the           *
+ * GNU General Public License for more details.                            *
+ *                                                                         *
+ * You should have received a copy of the GNU General Public License       *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.   *
+ ***************************************************************************/
+
+#include "ImageDecoder.hpp"
+#include "ImageDecoder_p.hpp"
+#include "aligned_malloc.h"
+
+// C++ includes.
+#include <algorithm>
+#include <memory>
+#include <vector>
+using std::unique_ptr;
+using std::vector;
+
+namespace LibRpBase {
+
+/**
+ * Get the size of one 4x4 block for a block-compressed format.
+ * @param fmt Block format.
+ * @return Block size, in bytes. (8 or 16; 0 if invalid)
+ */
+unsigned int ImageDecoder::blockFormatSize(BlockFormat fmt)
+{
+	static const uint8_t blockSizes[BLOCK_MAX] = {
+		8,	// BLOCK_DXT1
+		8,	// BLOCK_DXT1_A1
+		16,	// BLOCK_DXT2
+		16,	// BLOCK_DXT3
+		16,	// BLOCK_DXT4
+		16,	// BLOCK_DXT5
+		8,	// BLOCK_BC4
+		16,	// BLOCK_BC5
+		16,	// BLOCK_BC7
+		8,	// BLOCK_ETC1
+		8,	// BLOCK_ETC2_RGB
+		16,	// BLOCK_ETC2_RGBA
+		8,	// BLOCK_ETC2_RGB_A1
+	};
+	static_assert(ARRAY_SIZE(blockSizes) == BLOCK_MAX, "blockSizes[] is the wrong size.");
+
+	assert(fmt >= 0 && fmt < BLOCK_MAX);
+	if (fmt < 0 || fmt >= BLOCK_MAX)
+		return 0;
+	return blockSizes[fmt];
+}
+
+/**
+ * Convert a block-compressed image to rp_image.
+ * This calls the decoder function for the specified format.
+ * @param fmt		[in] Block format.
+ * @param width		[in] Image width.
+ * @param height	[in] Image height.
+ * @param img_buf	[in] Image buffer.
+ * @param img_siz	[in] Size of image data.
+ * @return rp_image, or nullptr on error.
+ */
+rp_image *ImageDecoder::fromBlocks(BlockFormat fmt, int width, int height,
+	const uint8_t *RESTRICT img_buf, int img_siz)
+{
+	// NOTE: The decoders are called directly instead of
+	// through a function pointer table. Taking the address
+	// of an IFUNC-dispatched function requires the resolver
+	// to run during relocation, before CPU detection is usable.
+	switch (fmt) {
+		case BLOCK_DXT1:
+			return fromDXT1(width, height, img_buf, img_siz);
+		case BLOCK_DXT1_A1:
+			return fromDXT1_A1(width, height, img_buf, img_siz);
+		case BLOCK_DXT2:
+			return fromDXT2(width, height, img_buf, img_siz);
+		case BLOCK_DXT3:
+			return fromDXT3(width, height, img_buf, img_siz);
+		case BLOCK_DXT4:
+			return fromDXT4(width, height, img_buf, img_siz);
+		case BLOCK_DXT5:
+			return fromDXT5(width, height, img_buf, img_siz);
+		case BLOCK_BC4:
+			return fromBC4(width, height, img_buf, img_siz);
+		case BLOCK_BC5:
+			return fromBC5(width, height, img_buf, img_siz);
+		case BLOCK_BC7:
+			return fromBC7(width, height, img_buf, img_siz);
+		case BLOCK_ETC1:
+			return fromETC1(width, height, img_buf, img_siz);
+		case BLOCK_ETC2_RGB:
+			return fromETC2_RGB(width, height, img_buf, img_siz);
+		case BLOCK_ETC2_RGBA:
+			return fromETC2_RGBA(width, height, img_buf, img_siz);
+		case BLOCK_ETC2_RGB_A1:
+			return fromETC2_RGB_A1(width, height, img_buf, img_siz);
+		default:
+			assert(!"Invalid block format.");
+			break;
+	}
+	return nullptr;
+}
+
+/**
+ * Verify the parameters for a block-compressed image.
+ * @param blockSize	[in] Size of one 4x4 block, in bytes. (8 or 16)
+ * @param width		[in] Image width.
+ * @param height	[in] Image height.
+ * @param img_buf	[in] Image buffer.
+ * @param img_siz	[in] Size of image data.
+ * @return True if valid; false if not.
+ */
+static inline bool verifyBlockParams(unsigned int blockSize,
+	int width, int height, const uint8_t *img_buf, int img_siz)
+{
+	assert(blockSize == 8 || blockSize == 16);
+	assert(img_buf != nullptr);
+	assert(width > 0);
+	assert(height > 0);
+	if ((blockSize != 8 && blockSize != 16) ||
+	    !img_buf || width <= 0 || height <= 0)
+	{
+		return false;
+	}
+
+	// Block-compressed images use 4x4 tiles.
+	assert(width % 4 == 0);
+	assert(height % 4 == 0);
+	if (width % 4 != 0 || height % 4 != 0)
+		return false;
+
+	const unsigned int expected_size = (width / 4) * (height / 4) * blockSize;
+	assert(img_siz >= 0 && static_cast<unsigned int>(img_siz) >= expected_size);
+	return (img_siz >= 0 && static_cast<unsigned int>(img_siz) >= expected_size);
+}
+
+/**
+ * Convert a rectangular region of a block-compressed image to rp_image.
+ * Only the blocks that intersect the region are decoded.
+ * The region is expanded to 4x4 block boundaries.
+ * @param fmt		[in] Block format.
+ * @param width		[in] Image width.
+ * @param height	[in] Image height.
+ * @param img_buf	[in] Image buffer.
+ * @param img_siz	[in] Size of image data.
+ * @param x		[in] Region X position.
+ * @param y		[in] Region Y position.
+ * @param w		[in] Region width.
+ * @param h		[in] Region height.
+ * @return rp_image, or nullptr on error.
+ */
+rp_image *ImageDecoder::fromBlocksRect(BlockFormat fmt,
+	int width, int height,
+	const uint8_t *RESTRICT img_buf, int img_siz,
+	int x, int y, int w, int h)
+{
+	// Verify parameters.
+	const unsigned int blockSize = blockFormatSize(fmt);
+	if (!verifyBlockParams(blockSize, width, height, img_buf, img_siz))
+		return nullptr;
+
+	// Clip the region to the image and expand it to block boundaries.
+	const int x0 = std::max(x, 0) & ~3;
+	const int y0 = std::max(y, 0) & ~3;
+	const int x1 = (std::min(x + w, width) + 3) & ~3;
+	const int y1 = (std::min(y + h, height) + 3) & ~3;
+	assert(x1 > x0);
+	assert(y1 > y0);
+	if (x1 <= x0 || y1 <= y0) {
+		// Region is empty or outside of the image.
+		return nullptr;
+	}
+
+	const unsigned int rowBytes = (width / 4) * blockSize;
+	const unsigned int rectRowBytes = ((x1 - x0) / 4) * blockSize;
+	const unsigned int rectRows = (y1 - y0) / 4;
+	const uint8_t *src = img_buf + ((y0 / 4) * rowBytes) + ((x0 / 4) * blockSize);
+
+	if (x0 == 0 && x1 == width) {
+		// Full-width region. The blocks are contiguous,
+		// so they can be decoded in place.
+		return fromBlocks(fmt, width, y1 - y0, src, static_cast<int>(rectRows * rowBytes));
+	}
+
+	// Copy the blocks in the region to a temporary buffer.
+	const unsigned int rect_siz = rectRows * rectRowBytes;
+	auto buf = aligned_uptr<uint8_t>(16, rect_siz);
+	uint8_t *dest = buf.get();
+	for (unsigned int row = rectRows; row > 0; row--) {
+		memcpy(dest, src, rectRowBytes);
+		dest += rectRowBytes;
+		src += rowBytes;
+	}
+
+	return fromBlocks(fmt, x1 - x0, y1 - y0, buf.get(), static_cast<int>(rect_siz));
+}
+
+/**
+ * Convert a block-compressed image to rp_image at a reduced resolution.
+ *
+ * The image is decoded one row of blocks at a time, and each row
+ * is box-filtered into the destination image. The full-size image
+ * is never allocated, so this uses much less memory than decoding
+ * the full image and rescaling it.
+ *
+ * Color channels are weighted by alpha in order to prevent
+ * transparent pixels from bleeding into the reduced image.
+ *
+ * @param fmt		[in] Block format.
+ * @param width		[in] Image width.
+ * @param height	[in] Image height.
+ * @param img_buf	[in] Image buffer.
+ * @param img_siz	[in] Size of image data.
+ * @param level		[in] Reduction level. (Image is reduced by 2^level.)
+ * @return rp_image, or nullptr on error.
+ */
+rp_image *ImageDecoder::fromBlocksReduced(BlockFormat fmt,
+	int width, int height,
+	const uint8_t *RESTRICT img_buf, int img_siz,
+	int level)
+{
+	if (level <= 0) {
+		// No reduction.
+		return fromBlocks(fmt, width, height, img_buf, img_siz);
+	}
+
+	assert(level < 16);
+	if (level >= 16) {
+		// Reduction level is too large.
+		return nullptr;
+	}
+	return fromBlocksReduced(fmt, width, height, img_buf, img_siz,
+		width >> level, height >> level);
+}
+
+/**
+ * Convert a block-compressed image to rp_image at a reduced resolution.
+ *
+ * Same as above, but the output size can be any size up to
+ * the image size. If the image size isn't a multiple of the
+ * output size, the boxes differ in size by at most one pixel.
+ *
+ * @param fmt		[in] Block format.
+ * @param width		[in] Image width.
+ * @param height	[in] Image height.
+ * @param img_buf	[in] Image buffer.
+ * @param img_siz	[in] Size of image data.
+ * @param out_w		[in] Output width.
+ * @param out_h		[in] Output height.
+ * @return rp_image, or nullptr on error.
+ */
+rp_image *ImageDecoder::fromBlocksReduced(BlockFormat fmt,
+	int width, int height,
+	const uint8_t *RESTRICT img_buf, int img_siz,
+	int out_w, int out_h)
+{
+	if (out_w == width && out_h == height) {
+		// No reduction.
+		return fromBlocks(fmt, width, height, img_buf, img_siz);
+	}
+
+	// Verify parameters.
+	const unsigned int blockSize = blockFormatSize(fmt);
+	if (!verifyBlockParams(blockSize, width, height, img_buf, img_siz))
+		return nullptr;
+
+	assert(out_w > 0 && out_w <= width);
+	assert(out_h > 0 && out_h <= height);
+	if (out_w <= 0 || out_w > width || out_h <= 0 || out_h > height) {
+		// Invalid output size.
+		return nullptr;
+	}
+
+	rp_image *img = new rp_image(out_w, out_h, rp_image::FORMAT_ARGB32);
+	if (!img->isValid()) {
+		// Could not allocate the image.
+		delete img;
+		return nullptr;
+	}
+
+	// Destination column for each source column, and the
+	// width of each destination column's box.
+	// Box n covers source pixels [n*width/out_w, (n+1)*width/out_w).
+	vector<int> x_dest(width);
+	vector<unsigned int> box_w(out_w);
+	for (int dx = 0; dx < out_w; dx++) {
+		const int x0 = static_cast<int>(static_cast<int64_t>(dx) * width / out_w);
+		const int x1 = static_cast<int>(static_cast<int64_t>(dx + 1) * width / out_w);
+		box_w[dx] = x1 - x0;
+		for (int x = x0; x < x1; x++) {
+			x_dest[x] = dx;
+		}
+	}
+
+	// Decode up to four rows of blocks at a time.
+	// NOTE: The image height is a multiple of 4,
+	// so each strip is a whole number of blocks.
+	static const int STRIP_ROWS = 16;
+	const unsigned int rowBytes = (width / 4) * blockSize;
+
+	// Accumulators: Alpha, plus alpha-weighted R, G, and B.
+	vector<uint64_t> acc(out_w * 4);
+	bool has_sBIT = false;
+	rp_image::sBIT_t sBIT;
+
+	// Current destination row and the source row where its box ends.
+	int dy = 0;
+	int y0 = 0;
+	int y1 = static_cast<int>(static_cast<int64_t>(height) / out_h);
+
+	for (int sy = 0; sy < height; sy += STRIP_ROWS) {
+		const int rows = std::min(STRIP_ROWS, height - sy);
+		unique_ptr<rp_image> strip(fromBlocks(fmt, width, rows,
+			img_buf + ((sy / 4) * rowBytes), static_cast<int>((rows / 4) * rowBytes)));
+		if (!strip) {
+			// Decode error.
+			delete img;
+			return nullptr;
+		}
+		assert(strip->format() == rp_image::FORMAT_ARGB32);
+		if (!has_sBIT) {
+			has_sBIT = (strip->get_sBIT(&sBIT) == 0);
+		}
+
+		for (int y = 0; y < rows; y++) {
+			const uint32_t *src = static_cast<const uint32_t*>(strip->scanLine(y));
+			for (int x = 0; x < width; x++) {
+				const uint32_t px = src[x];
+				const uint32_t a = (px >> 24);
+				uint64_t *const p = &acc[x_dest[x] * 4];
+				p[0] += a;
+				p[1] += ((px >> 16) & 0xFF) * a;
+				p[2] += ((px >>  8) & 0xFF) * a;
+				p[3] += ( px        & 0xFF) * a;
+			}
+
+			if (sy + y + 1 < y1) {
+				// Box isn't complete yet.
+				continue;
+			}
+
+			// Write the destination row.
+			const unsigned int box_h = y1 - y0;
+			uint32_t *dest = static_cast<uint32_t*>(img->scanLine(dy));
+			for (int x = 0; x < out_w; x++) {
+				uint64_t *const p = &acc[x * 4];
+				const uint64_t a_sum = p[0];
+				if (a_sum == 0) {
+					// Fully transparent.
+					dest[x] = 0;
+				} else {
+					const uint64_t box_area = static_cast<uint64_t>(box_w[x]) * box_h;
+					const uint64_t a_half = a_sum / 2;
+					dest[x] = (static_cast<uint32_t>((a_sum + (box_area / 2)) / box_area) << 24) |
+						  (static_cast<uint32_t>((p[1] + a_half) / a_sum) << 16) |
+						  (static_cast<uint32_t>((p[2] + a_half) / a_sum) <<  8) |
+						   static_cast<uint32_t>((p[3] + a_half) / a_sum);
+				}
+				p[0] = 0; p[1] = 0; p[2] = 0; p[3] = 0;
+			}
+
+			// Next destination row.
+			dy++;
+			y0 = y1;
+			y1 = static_cast<int>(static_cast<int64_t>(dy + 1) * height / out_h);
+		}
+	}
+	assert(dy == out_h);
+
+	if (has_sBIT) {
+		// Copy the sBIT metadata from the decoder.
+		img->set_sBIT(&sBIT);
+	}
+
+	// Image has been converted.
+	return img;
+}
+
+}
@@ -514,6 +514,7 @@ static rp_image *T_fromDXT1(int width, int height,
 
 /**
  * Convert a DXT1 image to rp_image.
+ * Standard version using regular C++ code.
  * S3TC palette index 3 will be interpreted as black.
  *
  * @param width Image width.
@@ -522,7 +523,7 @@ static rp_image *T_fromDXT1(int width, int height,
  * @param img_siz Size of image data. [must be >= (w*h)/2]
  * @return rp_image, or nullptr on error.
  */
-rp_image *ImageDecoder::fromDXT1(int width, int height,
+rp_image *ImageDecoder::fromDXT1_cpp(int width, int height,
 	const uint8_t *RESTRICT img_buf, int img_siz)
 {
 	return T_fromDXT1<0>(width, height, img_buf, img_siz);
@@ -530,6 +531,7 @@ rp_image *ImageDecoder::fromDXT1(int width, int height,
 
 /**
  * Convert a DXT1 image to rp_image.
+ * Standard version using regular C++ code.
  * S3TC palette index 3 will be interpreted as fully transparent.
  *
  * @param width Image width.
@@ -538,7 +540,7 @@ rp_image *ImageDecoder::fromDXT1(int width, int height,
  * @param img_siz Size of image data. [must be >= (w*h)/2]
  * @return rp_image, or nullptr on error.
  */
-rp_image *ImageDecoder::fromDXT1_A1(int width, int height,
+rp_image *ImageDecoder::fromDXT1_A1_cpp(int width, int height,
 	const uint8_t *RESTRICT img_buf, int img_siz)
 {
 	return T_fromDXT1<DXTn_PALETTE_COLOR3_ALPHA>(width, height, img_buf, img_siz);
@@ -575,13 +577,14 @@ rp_image *ImageDecoder::fromDXT2(int width, int height,
 
 /**
  * Convert a DXT3 image to rp_image.
+ * Standard version using regular C++ code.
  * @param width Image width.
  * @param height Image height.
  * @param img_buf DXT5 image buffer.
  * @param img_siz Size of image data. [must be >= (w*h)]
  * @return rp_image, or nullptr on error.
  */
-rp_image *ImageDecoder::fromDXT3(int width, int height,
+rp_image *ImageDecoder::fromDXT3_cpp(int width, int height,
 	const uint8_t *RESTRICT img_buf, int img_siz)
 {
 	// Verify parameters.
@@ -721,13 +724,14 @@ rp_image *ImageDecoder::fromDXT4(int width, int height,
 
 /**
  * Convert a DXT5 image to rp_image.
+ * Standard version using regular C++ code.
  * @param width Image width.
  * @param height Image height.
  * @param img_buf DXT5 image buffer.
  * @param img_siz Size of image data. [must be >= (w*h)]
  * @return rp_image, or nullptr on error.
  */
-rp_image *ImageDecoder::fromDXT5(int width, int height,
+rp_image *ImageDecoder::fromDXT5_cpp(int width, int height,
 	const uint8_t *RESTRICT img_buf, int img_siz)
 {
 	// Verify parameters.
@@ -837,13 +841,14 @@ rp_image *ImageDecoder::fromDXT5(int width, int height,
 
 /**
  * Convert a BC4 (ATI1) image to rp_image.
+ * Standard version using regular C++ code.
  * @param width Image width.
  * @param height Image height.
  * @param img_buf BC4 image buffer.
  * @param img_siz Size of image data. [must be >= (w*h)/2]
  * @return rp_image, or nullptr on error.
  */
-rp_image *ImageDecoder::fromBC4(int width, int height,
+rp_image *ImageDecoder::fromBC4_cpp(int width, int height,
 	const uint8_t *RESTRICT img_buf, int img_siz)
 {
 	// Verify parameters.
@@ -947,13 +952,14 @@ rp_image *ImageDecoder::fromBC4(int width, int height,
 
 /**
  * Convert a BC5 (ATI2) image to rp_image.
+ * Standard version using regular C++ code.
  * @param width Image width.
  * @param height Image height.
  * @param img_buf BC5 image buffer.
  * @param img_siz Size of image data. [must be >= (w*h)]
  * @return rp_image, or nullptr on error.
  */
-rp_image *ImageDecoder::fromBC5(int width, int height,
+rp_image *ImageDecoder::fromBC5_cpp(int width, int height,
 	const uint8_t *RESTRICT img_buf, int img_siz)
 {
 	// Verify parameters.
@@ -0,0 +1,410 @@
+/***************************************************************************
+ * ROM Properties Page shell extension. (librpbase)                        *
+ * ImageDecoder_S3TC.cpp: Image decoding functions. (S3TC)                 *
+ * AVX2-optimized version.                                                 *
+ *                                                                         *
+ * Copyright (c) 2016-2018 by David Korth.                                 *
+ *                                                                         *
+ * This program is free software; you can redistribute it and/or modify it *
+ * under the terms of the GNU General Public License as published by the   *
+ * Free Software Foundation; either version 2 of the License, or (at your  *
+ * option) any later version.                                              *
+ *                                                                         *
+ * This program is distributed in the hope that it will be useful, but     *
+ * WITHOUT ANY WARRANTY; without even the implied warranty of              *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the           *
+ * GNU General Public License for more details.                            *
+ *                                                                         *
+ * You should have received a copy of the GNU General Public License       *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.   *
+ ***************************************************************************/
+
+#include "ImageDecoder.hpp"
+#include "ImageDecoder_p.hpp"
+#include "ImageDecoder_S3TC_sse2.hpp"
+
+// AVX2 headers.
+#include <immintrin.h>
+
+// Only S3TC decoding is optimized. S2TC decoding is
+// handled by the standard C++ version.
+
+// Each 256-bit vector contains two horizontally-adjacent blocks:
+// the left block in the low 128 bits, and the right block in the
+// high 128 bits. The AVX2 byte shuffles and unpacks operate within
+// 128-bit lanes, so one row of a vector is one row of both blocks.
+
+namespace LibRpBase {
+
+/**
+ * Combine two 128-bit vectors into a 256-bit vector.
+ * @param lo Low 128 bits.
+ * @param hi High 128 bits.
+ * @return 256-bit vector.
+ */
+static FORCEINLINE __m256i combine_avx2(__m128i lo, __m128i hi)
+{
+	return _mm256_inserti128_si256(_mm256_castsi128_si256(lo), hi, 1);
+}
+
+/**
+ * Broadcast a 128-bit constant to both lanes of a 256-bit vector.
+ * @param x 128-bit constant.
+ * @return 256-bit vector.
+ */
+static FORCEINLINE __m256i bcast_avx2(__m128i x)
+{
+	return _mm256_broadcastsi128_si256(x);
+}
+
+/**
+ * Look up the DXTn color indexes for two blocks.
+ * @param rows		[out] Four rows of ARGB32 pixels.
+ * @param pal		[in] Block palettes: {c0,c1,c2,c3} in each lane.
+ * @param idx_lo	[in] 2-bit color indexes for the left block.
+ * @param idx_hi	[in] 2-bit color indexes for the right block.
+ */
+static FORCEINLINE void lookup_DXTn_rows_avx2(__m256i rows[4], __m256i pal,
+	uint32_t idx_lo, uint32_t idx_hi)
+{
+	const __m256i mask4 = _mm256_set1_epi8(0x0F);
+
+	// Copy each row of indexes to the bytes for its four pixels,
+	// then mask each pixel's index in place.
+	__m256i idx = _mm256_shuffle_epi8(
+		combine_avx2(_mm_cvtsi32_si128(static_cast<int>(idx_lo)),
+			     _mm_cvtsi32_si128(static_cast<int>(idx_hi))),
+		bcast_avx2(_mm_setr_epi8(0,0,0,0, 1,1,1,1, 2,2,2,2, 3,3,3,3)));
+	idx = _mm256_and_si256(idx, _mm256_set1_epi32(static_cast<int>(0xC0300C03)));
+
+	// Pixels 2 and 3 are in the high nybble. Move them to the low nybble.
+	// Pixels 0 and 2 now have values 0-3; pixels 1 and 3 have 0,4,8,12.
+	idx = _mm256_or_si256(_mm256_and_si256(idx, mask4),
+		_mm256_and_si256(_mm256_srli_epi16(idx, 4), mask4));
+
+	// Convert the values to palette byte offsets. (index * 4)
+	idx = _mm256_shuffle_epi8(
+		bcast_avx2(_mm_setr_epi8(0,4,8,12, 4,0,0,0, 8,0,0,0, 12,0,0,0)), idx);
+
+	// Look up the palette entries for each row.
+	const __m256i byte_offsets = _mm256_set1_epi32(0x03020100);
+	__m256i row_sel = bcast_avx2(_mm_setr_epi8(0,0,0,0, 1,1,1,1, 2,2,2,2, 3,3,3,3));
+	const __m256i row_inc = _mm256_set1_epi8(4);
+	for (unsigned int r = 0; r < 4; r++) {
+		rows[r] = _mm256_shuffle_epi8(pal, _mm256_add_epi8(byte_offsets,
+			_mm256_shuffle_epi8(idx, row_sel)));
+		row_sel = _mm256_add_epi8(row_sel, row_inc);
+	}
+}
+
+/**
+ * Expand DXT5-style 3-bit codes using interpolated palettes for two blocks.
+ * @param blk_lo DXT5 alpha block for the left block. (or BC4/BC5 color block)
+ * @param blk_hi DXT5 alpha block for the right block. (or BC4/BC5 color block)
+ * @return 16 values per lane, one byte per pixel.
+ */
+static FORCEINLINE __m256i expand_DXT5_alpha_avx2(const uint8_t *blk_lo, const uint8_t *blk_hi)
+{
+	const __m256i pal16 = combine_avx2(
+		decode_DXT5_alpha_palette_S3TC_sse2(S3TC_SIMD_read32(blk_lo)),
+		decode_DXT5_alpha_palette_S3TC_sse2(S3TC_SIMD_read32(blk_hi)));
+	const __m256i pal8 = _mm256_packus_epi16(pal16, pal16);
+
+	// Copy the two bytes containing each pixel's code to a 16-bit lane.
+	// The 48-bit code value starts at byte 2.
+	const __m256i blk8 = combine_avx2(
+		_mm_loadl_epi64(reinterpret_cast<const __m128i*>(blk_lo)),
+		_mm_loadl_epi64(reinterpret_cast<const __m128i*>(blk_hi)));
+	const __m256i w_lo = _mm256_shuffle_epi8(blk8,
+		bcast_avx2(_mm_setr_epi8(2,3, 2,3, 2,3, 3,4, 3,4, 3,4, 4,5, 4,5)));
+	const __m256i w_hi = _mm256_shuffle_epi8(blk8,
+		bcast_avx2(_mm_setr_epi8(5,6, 5,6, 5,6, 6,7, 6,7, 6,7, 7,-1, 7,-1)));
+
+	// Shift each code to bits 0-2.
+	const __m256i shift = bcast_avx2(_mm_setr_epi16(0, 3, 6, 1, 4, 7, 2, 5));
+	const __m256i mask3 = _mm256_set1_epi16(7);
+	const __m256i shift_lo = _mm256_unpacklo_epi16(shift, _mm256_setzero_si256());
+	const __m256i shift_hi = _mm256_unpackhi_epi16(shift, _mm256_setzero_si256());
+	const __m256i zero = _mm256_setzero_si256();
+	// AVX2 only has variable shifts for 32-bit and 64-bit lanes,
+	// so the 16-bit windows are zero-extended to 32 bits first.
+#define SHIFT_CODES(w) _mm256_and_si256(_mm256_packus_epi32( \
+		_mm256_srlv_epi32(_mm256_unpacklo_epi16(w, zero), shift_lo), \
+		_mm256_srlv_epi32(_mm256_unpackhi_epi16(w, zero), shift_hi)), mask3)
+	const __m256i c_lo = SHIFT_CODES(w_lo);
+	const __m256i c_hi = SHIFT_CODES(w_hi);
+#undef SHIFT_CODES
+
+	// Look up the palette entries.
+	return _mm256_shuffle_epi8(pal8, _mm256_packus_epi16(c_lo, c_hi));
+}
+
+/**
+ * Convert 16 alpha values per lane to four rows of ARGB32 alpha channels.
+ * @param rows	[in/out] Four rows of ARGB32 pixels. (alpha channel must be 0)
+ * @param a8	[in] 16 alpha values per lane.
+ */
+static FORCEINLINE void apply_alpha_rows_avx2(__m256i rows[4], __m256i a8)
+{
+	const __m256i zero = _mm256_setzero_si256();
+	const __m256i a_lo = _mm256_unpacklo_epi8(zero, a8);
+	const __m256i a_hi = _mm256_unpackhi_epi8(zero, a8);
+	rows[0] = _mm256_or_si256(rows[0], _mm256_unpacklo_epi16(zero, a_lo));
+	rows[1] = _mm256_or_si256(rows[1], _mm256_unpackhi_epi16(zero, a_lo));
+	rows[2] = _mm256_or_si256(rows[2], _mm256_unpacklo_epi16(zero, a_hi));
+	rows[3] = _mm256_or_si256(rows[3], _mm256_unpackhi_epi16(zero, a_hi));
+}
+
+/**
+ * Convert 16 red and green values per lane to four rows of ARGB32 pixels.
+ * Alpha is set to 0xFF; blue is set to 0.
+ * @param rows	[out] Four rows of ARGB32 pixels.
+ * @param r8	[in] 16 red values per lane.
+ * @param g8	[in] 16 green values per lane.
+ */
+static FORCEINLINE void make_RG_rows_avx2(__m256i rows[4], __m256i r8, __m256i g8)
+{
+	// Low 16 bits: {B,G}; high 16 bits: {R,A}
+	const __m256i alpha = _mm256_set1_epi8(static_cast<int8_t>(0xFF));
+	const __m256i zero = _mm256_setzero_si256();
+	const __m256i bg_lo = _mm256_unpacklo_epi8(zero, g8);
+	const __m256i bg_hi = _mm256_unpackhi_epi8(zero, g8);
+	const __m256i ra_lo = _mm256_unpacklo_epi8(r8, alpha);
+	const __m256i ra_hi = _mm256_unpackhi_epi8(r8, alpha);
+	rows[0] = _mm256_unpacklo_epi16(bg_lo, ra_lo);
+	rows[1] = _mm256_unpackhi_epi16(bg_lo, ra_lo);
+	rows[2] = _mm256_unpacklo_epi16(bg_hi, ra_hi);
+	rows[3] = _mm256_unpackhi_epi16(bg_hi, ra_hi);
+}
+
+/**
+ * Convert an S3TC image to rp_image.
+ * AVX2-optimized version.
+ *
+ * Color palettes are calculated for four blocks at a time,
+ * and pixels are decoded for two blocks at a time.
+ * Each pair of blocks is written directly to the destination rows.
+ *
+ * @tparam fmt S3TC format.
+ * @param width Image width.
+ * @param height Image height.
+ * @param img_buf Image buffer.
+ * @param img_siz Size of image data.
+ * @return rp_image, or nullptr on error.
+ */
+template<S3TC_SIMD_Format fmt>
+static rp_image *T_fromS3TC_avx2(int width, int height,
+	const uint8_t *RESTRICT img_buf, int img_siz)
+{
+	rp_image *const img = S3TC_SIMD_createImage<fmt>(width, height, img_buf, img_siz);
+	if (!img) {
+		return nullptr;
+	}
+
+	const unsigned int blockSize = S3TC_SIMD_blockSize<fmt>();
+	const bool hasColor = (fmt != S3TC_SIMD_BC4 && fmt != S3TC_SIMD_BC5);
+	// DXT3 and DXT5 have the color block after the alpha block.
+	const unsigned int colorOffset = (blockSize == 16 ? 8 : 0);
+	const __m256i rgb_mask = _mm256_set1_epi32(0x00FFFFFF);
+
+	const unsigned int tilesX = static_cast<unsigned int>(width / 4);
+	const unsigned int tilesY = static_cast<unsigned int>(height / 4);
+	const int stride_px = img->stride() / sizeof(uint32_t);
+	uint32_t *dest_row = static_cast<uint32_t*>(img->bits());
+
+	for (unsigned int y = 0; y < tilesY; y++, dest_row += (stride_px * 4)) {
+		uint32_t *dest = dest_row;
+		for (unsigned int x = 0; x < tilesX; x += 4) {
+			// Decode up to four blocks.
+			// If fewer than four blocks are left, the last block
+			// is repeated for the palette calculation.
+			const unsigned int nb = (tilesX - x >= 4 ? 4 : tilesX - x);
+			__m128i pal[4];
+			if (hasColor) {
+				const uint8_t *const c = img_buf + colorOffset;
+				const __m128i c01 = _mm_setr_epi32(
+					S3TC_SIMD_read32(c),
+					S3TC_SIMD_read32(c + blockSize * (nb > 1 ? 1 : 0)),
+					S3TC_SIMD_read32(c + blockSize * (nb > 2 ? 2 : nb-1)),
+					S3TC_SIMD_read32(c + blockSize * (nb > 3 ? 3 : nb-1)));
+				decode_DXTn_palettes_S3TC_sse2<fmt == S3TC_SIMD_DXT1_A1>(pal, c01);
+			}
+
+			for (unsigned int k = 0; k < nb; k += 2, dest += 8) {
+				// If there's only one block left, decode it twice.
+				const bool pair = (k + 1 < nb);
+				const uint8_t *const blk_lo = img_buf;
+				const uint8_t *const blk_hi = (pair ? img_buf + blockSize : img_buf);
+				__m256i pal2;
+				if (hasColor) {
+					pal2 = combine_avx2(pal[k], pal[pair ? k+1 : k]);
+				}
+
+				__m256i rows[4];
+				switch (fmt) {
+					case S3TC_SIMD_DXT1:
+					case S3TC_SIMD_DXT1_A1:
+						lookup_DXTn_rows_avx2(rows, pal2,
+							S3TC_SIMD_read32(&blk_lo[4]), S3TC_SIMD_read32(&blk_hi[4]));
+						break;
+					case S3TC_SIMD_DXT3:
+						lookup_DXTn_rows_avx2(rows, _mm256_and_si256(pal2, rgb_mask),
+							S3TC_SIMD_read32(&blk_lo[12]), S3TC_SIMD_read32(&blk_hi[12]));
+						apply_alpha_rows_avx2(rows, combine_avx2(
+							expand_DXT3_alpha_S3TC_sse2(blk_lo),
+							expand_DXT3_alpha_S3TC_sse2(blk_hi)));
+						break;
+					case S3TC_SIMD_DXT5:
+						lookup_DXTn_rows_avx2(rows, _mm256_and_si256(pal2, rgb_mask),
+							S3TC_SIMD_read32(&blk_lo[12]), S3TC_SIMD_read32(&blk_hi[12]));
+						apply_alpha_rows_avx2(rows, expand_DXT5_alpha_avx2(blk_lo, blk_hi));
+						break;
+					case S3TC_SIMD_BC4:
+						// NOTE: Using red instead of grayscale here.
+						make_RG_rows_avx2(rows, expand_DXT5_alpha_avx2(blk_lo, blk_hi),
+							_mm256_setzero_si256());
+						break;
+					case S3TC_SIMD_BC5:
+						make_RG_rows_avx2(rows, expand_DXT5_alpha_avx2(blk_lo, blk_hi),
+							expand_DXT5_alpha_avx2(&blk_lo[8], &blk_hi[8]));
+						break;
+				}
+
+				// Write the rows directly to the image.
+				if (pair) {
+					_mm256_storeu_si256(reinterpret_cast<__m256i*>(dest), rows[0]);
+					_mm256_storeu_si256(reinterpret_cast<__m256i*>(dest + stride_px), rows[1]);
+					_mm256_storeu_si256(reinterpret_cast<__m256i*>(dest + stride_px*2), rows[2]);
+					_mm256_storeu_si256(reinterpret_cast<__m256i*>(dest + stride_px*3), rows[3]);
+					img_buf += blockSize * 2;
+				} else {
+					_mm_storeu_si128(reinterpret_cast<__m128i*>(dest), _mm256_castsi256_si128(rows[0]));
+					_mm_storeu_si128(reinterpret_cast<__m128i*>(dest + stride_px), _mm256_castsi256_si128(rows[1]));
+					_mm_storeu_si128(reinterpret_cast<__m128i*>(dest + stride_px*2), _mm256_castsi256_si128(rows[2]));
+					_mm_storeu_si128(reinterpret_cast<__m128i*>(dest + stride_px*3), _mm256_castsi256_si128(rows[3]));
+					img_buf += blockSize;
+				}
+			}
+		}
+	}
+
+	// Set the sBIT metadata.
+	S3TC_SIMD_set_sBIT<fmt>(img);
+
+	// Image has been converted.
+	return img;
+}
+
+/**
+ * Convert a DXT1 image to rp_image.
+ * AVX2-optimized version.
+ * S3TC palette index 3 will be interpreted as black.
+ *
+ * @param width Image width.
+ * @param height Image height.
+ * @param img_buf DXT1 image buffer.
+ * @param img_siz Size of image data. [must be >= (w*h)/2]
+ * @return rp_image, or nullptr on error.
+ */
+rp_image *ImageDecoder::fromDXT1_avx2(int width, int height,
+	const uint8_t *RESTRICT img_buf, int img_siz)
+{
+	if (unlikely(!EnableS3TC)) {
+		return fromDXT1_cpp(width, height, img_buf, img_siz);
+	}
+	return T_fromS3TC_avx2<S3TC_SIMD_DXT1>(width, height, img_buf, img_siz);
+}
+
+/**
+ * Convert a DXT1 image to rp_image.
+ * AVX2-optimized version.
+ * S3TC palette index 3 will be interpreted as fully transparent.
+ *
+ * @param width Image width.
+ * @param height Image height.
+ * @param img_buf DXT1 image buffer.
+ * @param img_siz Size of image data. [must be >= (w*h)/2]
+ * @return rp_image, or nullptr on error.
+ */
+rp_image *ImageDecoder::fromDXT1_A1_avx2(int width, int height,
+	const uint8_t *RESTRICT img_buf, int img_siz)
+{
+	if (unlikely(!EnableS3TC)) {
+		return fromDXT1_A1_cpp(width, height, img_buf, img_siz);
+	}
+	return T_fromS3TC_avx2<S3TC_SIMD_DXT1_A1>(width, height, img_buf, img_siz);
+}
+
+/**
+ * Convert a DXT3 image to rp_image.
+ * AVX2-optimized version.
+ * @param width Image width.
+ * @param height Image height.
+ * @param img_buf DXT3 image buffer.
+ * @param img_siz Size of image data. [must be >= (w*h)]
+ * @return rp_image, or nullptr on error.
+ */
+rp_image *ImageDecoder::fromDXT3_avx2(int width, int height,
+	const uint8_t *RESTRICT img_buf, int img_siz)
+{
+	if (unlikely(!EnableS3TC)) {
+		return fromDXT3_cpp(width, height, img_buf, img_siz);
+	}
+	return T_fromS3TC_avx2<S3TC_SIMD_DXT3>(width, height, img_buf, img_siz);
+}
+
+/**
+ * Convert a DXT5 image to rp_image.
+ * AVX2-optimized version.
+ * @param width Image width.
+ * @param height Image height.
+ * @param img_buf DXT5 image buffer.
+ * @param img_siz Size of image data. [must be >= (w*h)]
+ * @return rp_image, or nullptr on error.
+ */
+rp_image *ImageDecoder::fromDXT5_avx2(int width, int height,
+	const uint8_t *RESTRICT img_buf, int img_siz)
+{
+	if (unlikely(!EnableS3TC)) {
+		return fromDXT5_cpp(width, height, img_buf, img_siz);
+	}
+	return T_fromS3TC_avx2<S3TC_SIMD_DXT5>(width, height, img_buf, img_siz);
+}
+
+/**
+ * Convert a BC4 (ATI1) image to rp_image.
+ * AVX2-optimized version.
+ * @param width Image width.
+ * @param height Image height.
+ * @param img_buf BC4 image buffer.
+ * @param img_siz Size of image data. [must be >= (w*h)/2]
+ * @return rp_image, or nullptr on error.
+ */
+rp_image *ImageDecoder::fromBC4_avx2(int width, int height,
+	const uint8_t *RESTRICT img_buf, int img_siz)
+{
+	if (unlikely(!EnableS3TC)) {
+		return fromBC4_cpp(width, height, img_buf, img_siz);
+	}
+	return T_fromS3TC_avx2<S3TC_SIMD_BC4>(width, height, img_buf, img_siz);
+}
+
+/**
+ * Convert a BC5 (ATI2) image to rp_image.
+ * AVX2-optimized version.
+ * @param width Image width.
+ * @param height Image height.
+ * @param img_buf BC5 image buffer.
+ * @param img_siz Size of image data. [must be >= (w*h)]
+ * @return rp_image, or nullptr on error.
+ */
+rp_image *ImageDecoder::fromBC5_avx2(int width, int height,
+	const uint8_t *RESTRICT img_buf, int img_siz)
+{
+	if (unlikely(!EnableS3TC)) {
+		return fromBC5_cpp(width, height, img_buf, img_siz);
+	}
+	return T_fromS3TC_avx2<S3TC_SIMD_BC5>(width, height, img_buf, img_siz);
+}
+
+}
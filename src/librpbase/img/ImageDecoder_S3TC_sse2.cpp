@@ -0,0 +1,209 @@
+/***************************************************************************
+ * ROM Properties Page shell extension. (librpbase)                        *
+ * ImageDecoder_S3TC.cpp: Image decoding functions. (S3TC)                 *
+ * SSE2-optimized version.                                                 *
+ *                                                                         *
+ * Copyright (c) 2016-2018 by David Korth.                                 *
+ *                                                                         *
+ * This program is free software; you can redistribute it and/or modify it *
+ * under the terms of the GNU General Public License as published by the   *
+ * Free Software Foundation; either version 2 of the License, or (at your  *
+ * option) any later version.                                              *
+ *                                                                         *
+ * This program is distributed in the hope that it will be useful, but     *
+ * WITHOUT ANY WARRANTY; without even the implied warranty of              *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the           *
+ * GNU General Public License for more details.                            *
+ *                                                                         *
+ * You should have received a copy of the GNU General Public License       *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.   *
+ ***************************************************************************/
+
+#include "ImageDecoder.hpp"
+#include "ImageDecoder_p.hpp"
+#include "ImageDecoder_S3TC_sse2.hpp"
+
+// SSE2 headers.
+#include <emmintrin.h>
+
+// Only S3TC decoding is optimized. S2TC decoding is
+// handled by the standard C++ version.
+
+namespace LibRpBase {
+
+/**
+ * SSE2-specific functions for T_fromS3TC_simd128().
+ */
+struct S3TC_Ops_sse2 {
+	/**
+	 * Look up the DXTn color indexes for a single block.
+	 * @param rows		[out] Four rows of ARGB32 pixels.
+	 * @param pal		[in] Block palette: {c0,c1,c2,c3}
+	 * @param indexes	[in] 2-bit color indexes.
+	 */
+	static FORCEINLINE void lookup_DXTn_rows(__m128i rows[4], __m128i pal, uint32_t indexes)
+	{
+		// Each pixel is selected by comparing its masked index
+		// against the three possible non-zero values.
+		// Palette entries are XOR'd against color 0 so the
+		// three matches can be combined without blending.
+		const __m128i k1 = _mm_setr_epi32(1<<0, 1<<2, 1<<4, 1<<6);
+		const __m128i k2 = _mm_setr_epi32(2<<0, 2<<2, 2<<4, 2<<6);
+		const __m128i k3 = _mm_setr_epi32(3<<0, 3<<2, 3<<4, 3<<6);
+
+		const __m128i p0 = _mm_shuffle_epi32(pal, _MM_SHUFFLE(0,0,0,0));
+		const __m128i d1 = _mm_xor_si128(p0, _mm_shuffle_epi32(pal, _MM_SHUFFLE(1,1,1,1)));
+		const __m128i d2 = _mm_xor_si128(p0, _mm_shuffle_epi32(pal, _MM_SHUFFLE(2,2,2,2)));
+		const __m128i d3 = _mm_xor_si128(p0, _mm_shuffle_epi32(pal, _MM_SHUFFLE(3,3,3,3)));
+
+		for (unsigned int r = 0; r < 4; r++, indexes >>= 8) {
+			const __m128i v = _mm_and_si128(_mm_set1_epi32(indexes), k3);
+			__m128i px = _mm_xor_si128(p0, _mm_and_si128(_mm_cmpeq_epi32(v, k1), d1));
+			px = _mm_xor_si128(px, _mm_and_si128(_mm_cmpeq_epi32(v, k2), d2));
+			px = _mm_xor_si128(px, _mm_and_si128(_mm_cmpeq_epi32(v, k3), d3));
+			rows[r] = px;
+		}
+	}
+
+	/**
+	 * Expand DXT5-style 3-bit codes using an interpolated palette.
+	 * @param blk DXT5 alpha block. (or BC4/BC5 color block)
+	 * @return 16 values, one byte per pixel.
+	 */
+	static FORCEINLINE __m128i expand_DXT5_alpha(const uint8_t *blk)
+	{
+		// Calculate the palette using SSE2.
+		ALIGNED_VAR(16, uint8_t pal[16]);
+		const __m128i pal16 = decode_DXT5_alpha_palette_S3TC_sse2(S3TC_SIMD_read32(blk));
+		_mm_store_si128(reinterpret_cast<__m128i*>(pal), _mm_packus_epi16(pal16, pal16));
+
+		// SSE2 doesn't have a byte shuffle, so look up
+		// the codes using the stored palette.
+		// Each half of the 48-bit code value has 8 pixels.
+		ALIGNED_VAR(16, uint8_t px[16]);
+		uint32_t code = S3TC_SIMD_read32(&blk[2]) & 0xFFFFFF;
+		for (unsigned int i = 0; i < 8; i++, code >>= 3) {
+			px[i] = pal[code & 7];
+		}
+		code = S3TC_SIMD_read32(&blk[4]) >> 8;
+		for (unsigned int i = 8; i < 16; i++, code >>= 3) {
+			px[i] = pal[code & 7];
+		}
+		return _mm_load_si128(reinterpret_cast<const __m128i*>(px));
+	}
+
+};
+
+/**
+ * Convert a DXT1 image to rp_image.
+ * SSE2-optimized version.
+ * S3TC palette index 3 will be interpreted as black.
+ *
+ * @param width Image width.
+ * @param height Image height.
+ * @param img_buf DXT1 image buffer.
+ * @param img_siz Size of image data. [must be >= (w*h)/2]
+ * @return rp_image, or nullptr on error.
+ */
+rp_image *ImageDecoder::fromDXT1_sse2(int width, int height,
+	const uint8_t *RESTRICT img_buf, int img_siz)
+{
+	if (unlikely(!EnableS3TC)) {
+		return fromDXT1_cpp(width, height, img_buf, img_siz);
+	}
+	return T_fromS3TC_simd128<S3TC_SIMD_DXT1, S3TC_Ops_sse2>(width, height, img_buf, img_siz);
+}
+
+/**
+ * Convert a DXT1 image to rp_image.
+ * SSE2-optimized version.
+ * S3TC palette index 3 will be interpreted as fully transparent.
+ *
+ * @param width Image width.
+ * @param height Image height.
+ * @param img_buf DXT1 image buffer.
+ * @param img_siz Size of image data. [must be >= (w*h)/2]
+ * @return rp_image, or nullptr on error.
+ */
+rp_image *ImageDecoder::fromDXT1_A1_sse2(int width, int height,
+	const uint8_t *RESTRICT img_buf, int img_siz)
+{
+	if (unlikely(!EnableS3TC)) {
+		return fromDXT1_A1_cpp(width, height, img_buf, img_siz);
+	}
+	return T_fromS3TC_simd128<S3TC_SIMD_DXT1_A1, S3TC_Ops_sse2>(width, height, img_buf, img_siz);
+}
+
+/**
+ * Convert a DXT3 image to rp_image.
+ * SSE2-optimized version.
+ * @param width Image width.
+ * @param height Image height.
+ * @param img_buf DXT3 image buffer.
+ * @param img_siz Size of image data. [must be >= (w*h)]
+ * @return rp_image, or nullptr on error.
+ */
+rp_image *ImageDecoder::fromDXT3_sse2(int width, int height,
+	const uint8_t *RESTRICT img_buf, int img_siz)
+{
+	if (unlikely(!EnableS3TC)) {
+		return fromDXT3_cpp(width, height, img_buf, img_siz);
+	}
+	return T_fromS3TC_simd128<S3TC_SIMD_DXT3, S3TC_Ops_sse2>(width, height, img_buf, img_siz);
+}
+
+/**
+ * Convert a DXT5 image to rp_image.
+ * SSE2-optimized version.
+ * @param width Image width.
+ * @param height Image height.
+ * @param img_buf DXT5 image buffer.
+ * @param img_siz Size of image data. [must be >= (w*h)]
+ * @return rp_image, or nullptr on error.
+ */
+rp_image *ImageDecoder::fromDXT5_sse2(int width, int height,
+	const uint8_t *RESTRICT img_buf, int img_siz)
+{
+	if (unlikely(!EnableS3TC)) {
+		return fromDXT5_cpp(width, height, img_buf, img_siz);
+	}
+	return T_fromS3TC_simd128<S3TC_SIMD_DXT5, S3TC_Ops_sse2>(width, height, img_buf, img_siz);
+}
+
+/**
+ * Convert a BC4 (ATI1) image to rp_image.
+ * SSE2-optimized version.
+ * @param width Image width.
+ * @param height Image height.
+ * @param img_buf BC4 image buffer.
+ * @param img_siz Size of image data. [must be >= (w*h)/2]
+ * @return rp_image, or nullptr on error.
+ */
+rp_image *ImageDecoder::fromBC4_sse2(int width, int height,
+	const uint8_t *RESTRICT img_buf, int img_siz)
+{
+	if (unlikely(!EnableS3TC)) {
+		return fromBC4_cpp(width, height, img_buf, img_siz);
+	}
+	return T_fromS3TC_simd128<S3TC_SIMD_BC4, S3TC_Ops_sse2>(width, height, img_buf, img_siz);
+}
+
+/**
+ * Convert a BC5 (ATI2) image to rp_image.
+ * SSE2-optimized version.
+ * @param width Image width.
+ * @param height Image height.
+ * @param img_buf BC5 image buffer.
+ * @param img_siz Size of image data. [must be >= (w*h)]
+ * @return rp_image, or nullptr on error.
+ */
+rp_image *ImageDecoder::fromBC5_sse2(int width, int height,
+	const uint8_t *RESTRICT img_buf, int img_siz)
+{
+	if (unlikely(!EnableS3TC)) {
+		return fromBC5_cpp(width, height, img_buf, img_siz);
+	}
+	return T_fromS3TC_simd128<S3TC_SIMD_BC5, S3TC_Ops_sse2>(width, height, img_buf, img_siz);
+}
+
+}
@@ -0,0 +1,460 @@
+/***************************************************************************
+ * ROM Properties Page shell extension. (librpbase)                        *
+ * ImageDecoder_S3TC_sse2.hpp: Image decoding functions. (S3TC)            *
+ * Common SSE2 functions for the SIMD-optimized S3TC decoders.             *
+ *                                                                         *
+ * Copyright (c) 2016-2018 by David Korth.                                 *
+ *                                                                         *
+ * This program is free software; you can redistribute it and/or modify it *
+ * under the terms of the GNU General Public License as published by the   *
+ * Free Software Foundation; either version 2 of the License, or (at your  *
+ * option) any later version.                                              *
+ *                                                                         *
+ * This program is distributed in the hope that it will be useful, but     *
+ * WITHOUT ANY WARRANTY; without even the implied warranty of              *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the           *
+ * GNU General Public License for more details.                            *
+ *                                                                         *
+ * You should have received a copy of the GNU General Public License       *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.   *
+ ***************************************************************************/
+
+#ifndef __ROMPROPERTIES_LIBRPBASE_IMG_IMAGEDECODER_S3TC_SSE2_HPP__
+#define __ROMPROPERTIES_LIBRPBASE_IMG_IMAGEDECODER_S3TC_SSE2_HPP__
+
+// NOTE: This header must only be included by source files
+// that are compiled with SSE2 (or later) enabled.
+// All functions are static in order to prevent the linker
+// from merging copies compiled for different instruction sets.
+
+#include "common.h"
+#include "img/rp_image.hpp"
+
+// C includes. (C++ namespace)
+#include <cassert>
+#include <cstring>
+
+// SSE2 headers.
+#include <emmintrin.h>
+
+namespace LibRpBase {
+
+// S3TC formats handled by the SIMD-optimized decoders.
+enum S3TC_SIMD_Format {
+	S3TC_SIMD_DXT1,		// DXT1; color 3 is black
+	S3TC_SIMD_DXT1_A1,	// DXT1; color 3 is transparent
+	S3TC_SIMD_DXT3,		// DXT3; 4-bit alpha
+	S3TC_SIMD_DXT5,		// DXT5; interpolated alpha
+	S3TC_SIMD_BC4,		// BC4; interpolated red
+	S3TC_SIMD_BC5,		// BC5; interpolated red and green
+};
+
+/**
+ * Get the block size for an S3TC format.
+ * @tparam fmt S3TC format.
+ * @return Block size, in bytes.
+ */
+template<S3TC_SIMD_Format fmt>
+static FORCEINLINE unsigned int S3TC_SIMD_blockSize(void)
+{
+	return (fmt == S3TC_SIMD_DXT1 || fmt == S3TC_SIMD_DXT1_A1 || fmt == S3TC_SIMD_BC4) ? 8 : 16;
+}
+
+/**
+ * Validate parameters and create an rp_image for an S3TC image.
+ * @tparam fmt S3TC format.
+ * @param width Image width.
+ * @param height Image height.
+ * @param img_buf Image buffer.
+ * @param img_siz Size of image data.
+ * @return rp_image, or nullptr on error.
+ */
+template<S3TC_SIMD_Format fmt>
+static inline rp_image *S3TC_SIMD_createImage(int width, int height,
+	const uint8_t *RESTRICT img_buf, int img_siz)
+{
+	// Verify parameters.
+	// 8-byte blocks use 4 bits per pixel; 16-byte blocks use 8 bits per pixel.
+	const int min_siz = (S3TC_SIMD_blockSize<fmt>() == 8)
+		? ((width * height) / 2)
+		: (width * height);
+	assert(img_buf != nullptr);
+	assert(width > 0);
+	assert(height > 0);
+	assert(img_siz >= min_siz);
+	if (!img_buf || width <= 0 || height <= 0 || img_siz < min_siz) {
+		return nullptr;
+	}
+
+	// S3TC uses 4x4 tiles.
+	assert(width % 4 == 0);
+	assert(height % 4 == 0);
+	if (width % 4 != 0 || height % 4 != 0)
+		return nullptr;
+
+	// Create an rp_image.
+	rp_image *img = new rp_image(width, height, rp_image::FORMAT_ARGB32);
+	if (!img->isValid()) {
+		// Could not allocate the image.
+		delete img;
+		return nullptr;
+	}
+	return img;
+}
+
+/**
+ * Set the sBIT metadata for an S3TC image.
+ * @tparam fmt S3TC format.
+ * @param img rp_image.
+ */
+template<S3TC_SIMD_Format fmt>
+static inline void S3TC_SIMD_set_sBIT(rp_image *img)
+{
+	// NOTE: We have to set '1' for empty color channels,
+	// since libpng complains if it's set to '0'.
+	static const rp_image::sBIT_t sBIT_DXT1 = {8,8,8,0,1};
+	static const rp_image::sBIT_t sBIT_DXT3 = {8,8,8,0,4};
+	static const rp_image::sBIT_t sBIT_DXT5 = {8,8,8,0,8};
+	static const rp_image::sBIT_t sBIT_BC4  = {8,1,1,0,0};
+	static const rp_image::sBIT_t sBIT_BC5  = {8,8,1,0,0};
+
+	switch (fmt) {
+		case S3TC_SIMD_DXT1:
+		case S3TC_SIMD_DXT1_A1:
+			img->set_sBIT(&sBIT_DXT1);
+			break;
+		case S3TC_SIMD_DXT3:
+			img->set_sBIT(&sBIT_DXT3);
+			break;
+		case S3TC_SIMD_DXT5:
+			img->set_sBIT(&sBIT_DXT5);
+			break;
+		case S3TC_SIMD_BC4:
+			img->set_sBIT(&sBIT_BC4);
+			break;
+		case S3TC_SIMD_BC5:
+			img->set_sBIT(&sBIT_BC5);
+			break;
+	}
+}
+
+/**
+ * Read an unaligned 32-bit little-endian value.
+ * SIMD decoders are only built for x86, so no byteswapping is needed.
+ * @param p Pointer.
+ * @return 32-bit value.
+ */
+static FORCEINLINE uint32_t S3TC_SIMD_read32(const uint8_t *p)
+{
+	uint32_t val;
+	memcpy(&val, p, sizeof(val));
+	return val;
+}
+
+/**
+ * Decode the DXTn color palettes for four blocks. (S3TC version)
+ *
+ * This is equivalent to decode_DXTn_tile_color_palette_S3TC<>()
+ * with DXTn_PALETTE_COLOR0_LE_COLOR1 disabled.
+ *
+ * @tparam color3_alpha If true, color 3 is transparent in 3-color mode.
+ * @param pal	[out] Palettes: {c0,c1,c2,c3} for each block, in ARGB32 format.
+ * @param c01	[in] Colors 0 and 1 of each block, in RGB565 format.
+ *		     Each 32-bit lane contains the first 32 bits of a DXT1 block.
+ */
+template<bool color3_alpha>
+static FORCEINLINE void decode_DXTn_palettes_S3TC_sse2(__m128i pal[4], __m128i c01)
+{
+	// NOTE: Each 16-bit lane contains one color.
+	// Even lanes are color0; odd lanes are color1.
+	const __m128i mask5 = _mm_set1_epi16(0x1F);
+	const __m128i mask6 = _mm_set1_epi16(0x3F);
+	const __m128i maskFF = _mm_set1_epi16(0xFF);
+	const __m128i even_mask = _mm_setr_epi16(-1,0,-1,0,-1,0,-1,0);
+
+	// Swap color0 and color1 within each block.
+	const __m128i c10 = _mm_shufflehi_epi16(
+		_mm_shufflelo_epi16(c01, _MM_SHUFFLE(2,3,0,1)), _MM_SHUFFLE(2,3,0,1));
+
+	// Four-color mode is used if color0 > color1. (unsigned comparison)
+	// The even lane has the result; copy it to the odd lane.
+	const __m128i sign = _mm_set1_epi16(static_cast<int16_t>(0x8000));
+	__m128i mode4 = _mm_cmpgt_epi16(_mm_xor_si128(c01, sign), _mm_xor_si128(c10, sign));
+	mode4 = _mm_shufflehi_epi16(
+		_mm_shufflelo_epi16(mode4, _MM_SHUFFLE(2,2,0,0)), _MM_SHUFFLE(2,2,0,0));
+
+	// Expand RGB565 to 8 bits per channel.
+	__m128i r01 = _mm_srli_epi16(c01, 11);
+	__m128i g01 = _mm_and_si128(_mm_srli_epi16(c01, 5), mask6);
+	__m128i b01 = _mm_and_si128(c01, mask5);
+	r01 = _mm_or_si128(_mm_slli_epi16(r01, 3), _mm_srli_epi16(r01, 2));
+	g01 = _mm_or_si128(_mm_slli_epi16(g01, 2), _mm_srli_epi16(g01, 4));
+	b01 = _mm_or_si128(_mm_slli_epi16(b01, 3), _mm_srli_epi16(b01, 2));
+
+	// Calculate colors 2 and 3.
+	// Four-color mode:
+	// - Even lane: (2*c0 + c1) / 3 == color2
+	// - Odd lane:  (2*c1 + c0) / 3 == color3
+	// Three-color mode:
+	// - Even lane: (c0 + c1) / 2 == color2
+	// - Odd lane:  black or transparent
+	// NOTE: Division by 3 is done using a reciprocal multiplication,
+	// which is exact for all values up to 3*255.
+	const __m128i recip3 = _mm_set1_epi16(0x5556);
+#define CALC_C23(x01) do { \
+	const __m128i x10 = _mm_shufflehi_epi16( \
+		_mm_shufflelo_epi16(x01, _MM_SHUFFLE(2,3,0,1)), _MM_SHUFFLE(2,3,0,1)); \
+	const __m128i t3 = _mm_mulhi_epu16(_mm_add_epi16(_mm_add_epi16(x01, x01), x10), recip3); \
+	const __m128i t2 = _mm_and_si128(_mm_srli_epi16(_mm_add_epi16(x01, x10), 1), even_mask); \
+	x23 = _mm_or_si128(_mm_and_si128(mode4, t3), _mm_andnot_si128(mode4, t2)); \
+} while (0)
+	__m128i x23;
+	CALC_C23(r01);
+	const __m128i r23 = x23;
+	CALC_C23(g01);
+	const __m128i g23 = x23;
+	CALC_C23(b01);
+	const __m128i b23 = x23;
+#undef CALC_C23
+
+	// Alpha channel for colors 2 and 3.
+	__m128i a23;
+	if (color3_alpha) {
+		// Color 3 is transparent in three-color mode.
+		a23 = _mm_and_si128(_mm_or_si128(mode4, even_mask), maskFF);
+	} else {
+		// All colors are opaque.
+		a23 = maskFF;
+	}
+
+	// Combine the channels into ARGB32.
+	// Each 16-bit lane is {B,G} or {R,A}.
+	const __m128i bg01 = _mm_or_si128(b01, _mm_slli_epi16(g01, 8));
+	const __m128i ra01 = _mm_or_si128(r01, _mm_slli_epi16(maskFF, 8));
+	const __m128i bg23 = _mm_or_si128(b23, _mm_slli_epi16(g23, 8));
+	const __m128i ra23 = _mm_or_si128(r23, _mm_slli_epi16(a23, 8));
+
+	// Blocks 0 and 1: [0.c0, 0.c1, 1.c0, 1.c1], [0.c2, 0.c3, 1.c2, 1.c3]
+	// Blocks 2 and 3: [2.c0, 2.c1, 3.c0, 3.c1], [2.c2, 2.c3, 3.c2, 3.c3]
+	const __m128i p01_lo = _mm_unpacklo_epi16(bg01, ra01);
+	const __m128i p01_hi = _mm_unpackhi_epi16(bg01, ra01);
+	const __m128i p23_lo = _mm_unpacklo_epi16(bg23, ra23);
+	const __m128i p23_hi = _mm_unpackhi_epi16(bg23, ra23);
+
+	pal[0] = _mm_unpacklo_epi64(p01_lo, p23_lo);
+	pal[1] = _mm_unpackhi_epi64(p01_lo, p23_lo);
+	pal[2] = _mm_unpacklo_epi64(p01_hi, p23_hi);
+	pal[3] = _mm_unpackhi_epi64(p01_hi, p23_hi);
+}
+
+/**
+ * DXT5-style interpolation weights.
+ * [0] == alpha0 <= alpha1; [1] == alpha0 > alpha1
+ * Each row has 8 16-bit values:
+ * - w0: Weight for alpha0.
+ * - w1: Weight for alpha1.
+ * - recip: Reciprocal of the divisor. (0x10000 / 5 or 0x10000 / 7, rounded up)
+ * - fixup: OR'd with the result. (alpha0 <= alpha1: index 7 is 255)
+ *
+ * NOTE: Division using mulhi_epu16() is exact for all values
+ * that can be generated using these weights.
+ */
+struct S3TC_SIMD_AlphaWeights {
+	uint16_t w0[8];
+	uint16_t w1[8];
+	uint16_t recip[8];
+	uint16_t fixup[8];
+};
+static const ALIGNED_VAR(16, S3TC_SIMD_AlphaWeights S3TC_SIMD_alpha_weights[2]) = {
+	// alpha0 <= alpha1: 6 values, 0, and 255.
+	{{5,0,4,3,2,1,0,0},
+	 {0,5,1,2,3,4,0,0},
+	 {0x3334,0x3334,0x3334,0x3334,0x3334,0x3334,0x3334,0x3334},
+	 {0,0,0,0,0,0,0,255}},
+
+	// alpha0 > alpha1: 8 values.
+	{{7,0,6,5,4,3,2,1},
+	 {0,7,1,2,3,4,5,6},
+	 {0x2493,0x2493,0x2493,0x2493,0x2493,0x2493,0x2493,0x2493},
+	 {0,0,0,0,0,0,0,0}},
+};
+
+/**
+ * Decode a DXT5 alpha palette. (S3TC version)
+ * This is equivalent to decode_DXT5_alpha_S3TC() for all 8 codes.
+ * @param a01 First two bytes of the alpha block. (alpha0, alpha1)
+ * @return Palette, as 8 16-bit values.
+ */
+static FORCEINLINE __m128i decode_DXT5_alpha_palette_S3TC_sse2(unsigned int a01)
+{
+	const unsigned int a0 = a01 & 0xFF;
+	const unsigned int a1 = (a01 >> 8) & 0xFF;
+	const __m128i *const w = reinterpret_cast<const __m128i*>(&S3TC_SIMD_alpha_weights[a0 > a1]);
+
+	__m128i pal = _mm_add_epi16(
+		_mm_mullo_epi16(_mm_load_si128(&w[0]), _mm_set1_epi16(static_cast<int16_t>(a0))),
+		_mm_mullo_epi16(_mm_load_si128(&w[1]), _mm_set1_epi16(static_cast<int16_t>(a1))));
+	pal = _mm_mulhi_epu16(pal, _mm_load_si128(&w[2]));
+	return _mm_or_si128(pal, _mm_load_si128(&w[3]));
+}
+
+/**
+ * Expand DXT3 4-bit alpha values to 8-bit.
+ * @param blk DXT3 block.
+ * @return 16 alpha values, one byte per pixel.
+ */
+static FORCEINLINE __m128i expand_DXT3_alpha_S3TC_sse2(const uint8_t *blk)
+{
+	const __m128i mask4 = _mm_set1_epi8(0x0F);
+	const __m128i a4 = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(blk));
+
+	// Low nybble is the even pixel; high nybble is the odd pixel.
+	const __m128i lo = _mm_and_si128(a4, mask4);
+	const __m128i hi = _mm_and_si128(_mm_srli_epi16(a4, 4), mask4);
+	const __m128i n = _mm_unpacklo_epi8(lo, hi);
+
+	// TODO: Verify alpha value handling for DXT3.
+	return _mm_or_si128(n, _mm_slli_epi16(n, 4));
+}
+
+/**
+ * Convert 16 alpha values to four rows of ARGB32 alpha channels.
+ * @param rows	[in/out] Four rows of ARGB32 pixels. (alpha channel must be 0)
+ * @param a8	[in] 16 alpha values.
+ */
+static FORCEINLINE void apply_alpha_rows_sse2(__m128i rows[4], __m128i a8)
+{
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i a_lo = _mm_unpacklo_epi8(zero, a8);
+	const __m128i a_hi = _mm_unpackhi_epi8(zero, a8);
+	rows[0] = _mm_or_si128(rows[0], _mm_unpacklo_epi16(zero, a_lo));
+	rows[1] = _mm_or_si128(rows[1], _mm_unpackhi_epi16(zero, a_lo));
+	rows[2] = _mm_or_si128(rows[2], _mm_unpacklo_epi16(zero, a_hi));
+	rows[3] = _mm_or_si128(rows[3], _mm_unpackhi_epi16(zero, a_hi));
+}
+
+/**
+ * Convert 16 red and green values to four rows of ARGB32 pixels.
+ * Alpha is set to 0xFF; blue is set to 0.
+ * @param rows	[out] Four rows of ARGB32 pixels.
+ * @param r8	[in] 16 red values.
+ * @param g8	[in] 16 green values.
+ */
+static FORCEINLINE void make_RG_rows_sse2(__m128i rows[4], __m128i r8, __m128i g8)
+{
+	// Low 16 bits: {B,G}; high 16 bits: {R,A}
+	const __m128i alpha = _mm_set1_epi8(static_cast<int8_t>(0xFF));
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i bg_lo = _mm_unpacklo_epi8(zero, g8);
+	const __m128i bg_hi = _mm_unpackhi_epi8(zero, g8);
+	const __m128i ra_lo = _mm_unpacklo_epi8(r8, alpha);
+	const __m128i ra_hi = _mm_unpackhi_epi8(r8, alpha);
+	rows[0] = _mm_unpacklo_epi16(bg_lo, ra_lo);
+	rows[1] = _mm_unpackhi_epi16(bg_lo, ra_lo);
+	rows[2] = _mm_unpacklo_epi16(bg_hi, ra_hi);
+	rows[3] = _mm_unpackhi_epi16(bg_hi, ra_hi);
+}
+
+/**
+ * Convert an S3TC image to rp_image using 128-bit vectors.
+ *
+ * Color palettes are calculated for four blocks at a time,
+ * and each block is written directly to the destination rows.
+ *
+ * Instruction set-specific functions are provided by Ops:
+ * - static void lookup_DXTn_rows(__m128i rows[4], __m128i pal, uint32_t indexes);
+ * - static __m128i expand_DXT5_alpha(const uint8_t *blk);
+ *
+ * @tparam fmt S3TC format.
+ * @tparam Ops Instruction set-specific functions.
+ * @param width Image width.
+ * @param height Image height.
+ * @param img_buf Image buffer.
+ * @param img_siz Size of image data.
+ * @return rp_image, or nullptr on error.
+ */
+template<S3TC_SIMD_Format fmt, class Ops>
+static rp_image *T_fromS3TC_simd128(int width, int height,
+	const uint8_t *RESTRICT img_buf, int img_siz)
+{
+	rp_image *const img = S3TC_SIMD_createImage<fmt>(width, height, img_buf, img_siz);
+	if (!img) {
+		return nullptr;
+	}
+
+	const unsigned int blockSize = S3TC_SIMD_blockSize<fmt>();
+	const bool hasColor = (fmt != S3TC_SIMD_BC4 && fmt != S3TC_SIMD_BC5);
+	// DXT3 and DXT5 have the color block after the alpha block.
+	const unsigned int colorOffset = (blockSize == 16 ? 8 : 0);
+	const __m128i rgb_mask = _mm_set1_epi32(0x00FFFFFF);
+
+	const unsigned int tilesX = static_cast<unsigned int>(width / 4);
+	const unsigned int tilesY = static_cast<unsigned int>(height / 4);
+	const int stride_px = img->stride() / sizeof(uint32_t);
+	uint32_t *dest_row = static_cast<uint32_t*>(img->bits());
+
+	for (unsigned int y = 0; y < tilesY; y++, dest_row += (stride_px * 4)) {
+		uint32_t *dest = dest_row;
+		for (unsigned int x = 0; x < tilesX; x += 4) {
+			// Decode up to four blocks.
+			// If fewer than four blocks are left, the last block
+			// is repeated for the palette calculation.
+			const unsigned int nb = (tilesX - x >= 4 ? 4 : tilesX - x);
+			__m128i pal[4];
+			if (hasColor) {
+				const uint8_t *const c = img_buf + colorOffset;
+				const __m128i c01 = _mm_setr_epi32(
+					S3TC_SIMD_read32(c),
+					S3TC_SIMD_read32(c + blockSize * (nb > 1 ? 1 : 0)),
+					S3TC_SIMD_read32(c + blockSize * (nb > 2 ? 2 : nb-1)),
+					S3TC_SIMD_read32(c + blockSize * (nb > 3 ? 3 : nb-1)));
+				decode_DXTn_palettes_S3TC_sse2<fmt == S3TC_SIMD_DXT1_A1>(pal, c01);
+			}
+
+			for (unsigned int k = 0; k < nb; k++, img_buf += blockSize, dest += 4) {
+				__m128i rows[4];
+				switch (fmt) {
+					case S3TC_SIMD_DXT1:
+					case S3TC_SIMD_DXT1_A1:
+						Ops::lookup_DXTn_rows(rows, pal[k], S3TC_SIMD_read32(&img_buf[4]));
+						break;
+					case S3TC_SIMD_DXT3:
+						Ops::lookup_DXTn_rows(rows, _mm_and_si128(pal[k], rgb_mask),
+							S3TC_SIMD_read32(&img_buf[12]));
+						apply_alpha_rows_sse2(rows, expand_DXT3_alpha_S3TC_sse2(img_buf));
+						break;
+					case S3TC_SIMD_DXT5:
+						Ops::lookup_DXTn_rows(rows, _mm_and_si128(pal[k], rgb_mask),
+							S3TC_SIMD_read32(&img_buf[12]));
+						apply_alpha_rows_sse2(rows, Ops::expand_DXT5_alpha(img_buf));
+						break;
+					case S3TC_SIMD_BC4:
+						// NOTE: Using red instead of grayscale here.
+						make_RG_rows_sse2(rows, Ops::expand_DXT5_alpha(img_buf),
+							_mm_setzero_si128());
+						break;
+					case S3TC_SIMD_BC5:
+						make_RG_rows_sse2(rows, Ops::expand_DXT5_alpha(img_buf),
+							Ops::expand_DXT5_alpha(&img_buf[8]));
+						break;
+				}
+
+				// Write the rows directly to the image.
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(dest), rows[0]);
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(dest + stride_px), rows[1]);
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(dest + stride_px*2), rows[2]);
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(dest + stride_px*3), rows[3]);
+			}
+		}
+	}
+
+	// Set the sBIT metadata.
+	S3TC_SIMD_set_sBIT<fmt>(img);
+
+	// Image has been converted.
+	return img;
+}
+
+}
+
+#endif /* __ROMPROPERTIES_LIBRPBASE_IMG_IMAGEDECODER_S3TC_SSE2_HPP__ */
@@ -0,0 +1,218 @@
+/***************************************************************************
+ * ROM Properties Page shell extension. (librpbase)                        *
+ * ImageDecoder_S3TC.cpp: Image decoding functions. (S3TC)                 *
+ * SSSE3-optimized version.                                                *
+ *                                                                         *
+ * Copyright (c) 2016-2018 by David Korth.                                 *
+ *                                                                         *
+ * This program is free software; you can redistribute it and/or modify it *
+ * under the terms of the GNU General Public License as published by the   *
+ * Free Software Foundation; either version 2 of the License, or (at your  *
+ * option) any later version.                                              *
+ *                                                                         *
+ * This program is distributed in the hope that it will be useful, but     *
+ * WITHOUT ANY WARRANTY; without even the implied warranty of              *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the           *
+ * GNU General Public License for more details.                            *
+ *                                                                         *
+ * You should have received a copy of the GNU General Public License       *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.   *
+ ***************************************************************************/
+
+#include "ImageDecoder.hpp"
+#include "ImageDecoder_p.hpp"
+#include "ImageDecoder_S3TC_sse2.hpp"
+
+// SSSE3 headers.
+#include <emmintrin.h>
+#include <tmmintrin.h>
+
+// Only S3TC decoding is optimized. S2TC decoding is
+// handled by the standard C++ version.
+
+namespace LibRpBase {
+
+/**
+ * SSSE3-specific functions for T_fromS3TC_simd128().
+ */
+struct S3TC_Ops_ssse3 {
+	/**
+	 * Look up the DXTn color indexes for a single block.
+	 * @param rows		[out] Four rows of ARGB32 pixels.
+	 * @param pal		[in] Block palette: {c0,c1,c2,c3}
+	 * @param indexes	[in] 2-bit color indexes.
+	 */
+	static FORCEINLINE void lookup_DXTn_rows(__m128i rows[4], __m128i pal, uint32_t indexes)
+	{
+		const __m128i mask4 = _mm_set1_epi8(0x0F);
+
+		// Copy each row of indexes to the bytes for its four pixels,
+		// then mask each pixel's index in place.
+		__m128i idx = _mm_shuffle_epi8(_mm_cvtsi32_si128(static_cast<int>(indexes)),
+			_mm_setr_epi8(0,0,0,0, 1,1,1,1, 2,2,2,2, 3,3,3,3));
+		idx = _mm_and_si128(idx, _mm_set1_epi32(static_cast<int>(0xC0300C03)));
+
+		// Pixels 2 and 3 are in the high nybble. Move them to the low nybble.
+		// Pixels 0 and 2 now have values 0-3; pixels 1 and 3 have 0,4,8,12.
+		idx = _mm_or_si128(_mm_and_si128(idx, mask4),
+			_mm_and_si128(_mm_srli_epi16(idx, 4), mask4));
+
+		// Convert the values to palette byte offsets. (index * 4)
+		idx = _mm_shuffle_epi8(_mm_setr_epi8(0,4,8,12, 4,0,0,0, 8,0,0,0, 12,0,0,0), idx);
+
+		// Look up the palette entries for each row.
+		const __m128i byte_offsets = _mm_set1_epi32(0x03020100);
+		rows[0] = _mm_shuffle_epi8(pal, _mm_add_epi8(byte_offsets,
+			_mm_shuffle_epi8(idx, _mm_setr_epi8(0,0,0,0, 1,1,1,1, 2,2,2,2, 3,3,3,3))));
+		rows[1] = _mm_shuffle_epi8(pal, _mm_add_epi8(byte_offsets,
+			_mm_shuffle_epi8(idx, _mm_setr_epi8(4,4,4,4, 5,5,5,5, 6,6,6,6, 7,7,7,7))));
+		rows[2] = _mm_shuffle_epi8(pal, _mm_add_epi8(byte_offsets,
+			_mm_shuffle_epi8(idx, _mm_setr_epi8(8,8,8,8, 9,9,9,9, 10,10,10,10, 11,11,11,11))));
+		rows[3] = _mm_shuffle_epi8(pal, _mm_add_epi8(byte_offsets,
+			_mm_shuffle_epi8(idx, _mm_setr_epi8(12,12,12,12, 13,13,13,13, 14,14,14,14, 15,15,15,15))));
+	}
+
+	/**
+	 * Expand DXT5-style 3-bit codes using an interpolated palette.
+	 * @param blk DXT5 alpha block. (or BC4/BC5 color block)
+	 * @return 16 values, one byte per pixel.
+	 */
+	static FORCEINLINE __m128i expand_DXT5_alpha(const uint8_t *blk)
+	{
+		const __m128i pal16 = decode_DXT5_alpha_palette_S3TC_sse2(S3TC_SIMD_read32(blk));
+		const __m128i pal8 = _mm_packus_epi16(pal16, pal16);
+
+		// Copy the two bytes containing each pixel's code to a 16-bit lane.
+		// The 48-bit code value starts at byte 2.
+		const __m128i blk8 = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(blk));
+		const __m128i w_lo = _mm_shuffle_epi8(blk8,
+			_mm_setr_epi8(2,3, 2,3, 2,3, 3,4, 3,4, 3,4, 4,5, 4,5));
+		const __m128i w_hi = _mm_shuffle_epi8(blk8,
+			_mm_setr_epi8(5,6, 5,6, 5,6, 6,7, 6,7, 6,7, 7,-1, 7,-1));
+
+		// Shift each code to bits 7-9, then down to bits 0-2.
+		// SSSE3 doesn't have variable shifts, so the left shift
+		// is done using multiplication.
+		const __m128i mul = _mm_setr_epi16(1<<7, 1<<4, 1<<1, 1<<6, 1<<3, 1<<0, 1<<5, 1<<2);
+		const __m128i mask3 = _mm_set1_epi16(7);
+		const __m128i c_lo = _mm_and_si128(_mm_srli_epi16(_mm_mullo_epi16(w_lo, mul), 7), mask3);
+		const __m128i c_hi = _mm_and_si128(_mm_srli_epi16(_mm_mullo_epi16(w_hi, mul), 7), mask3);
+
+		// Look up the palette entries.
+		return _mm_shuffle_epi8(pal8, _mm_packus_epi16(c_lo, c_hi));
+	}
+};
+
+/**
+ * Convert a DXT1 image to rp_image.
+ * SSSE3-optimized version.
+ * S3TC palette index 3 will be interpreted as black.
+ *
+ * @param width Image width.
+ * @param height Image height.
+ * @param img_buf DXT1 image buffer.
+ * @param img_siz Size of image data. [must be >= (w*h)/2]
+ * @return rp_image, or nullptr on error.
+ */
+rp_image *ImageDecoder::fromDXT1_ssse3(int width, int height,
+	const uint8_t *RESTRICT img_buf, int img_siz)
+{
+	if (unlikely(!EnableS3TC)) {
+		return fromDXT1_cpp(width, height, img_buf, img_siz);
+	}
+	return T_fromS3TC_simd128<S3TC_SIMD_DXT1, S3TC_Ops_ssse3>(width, height, img_buf, img_siz);
+}
+
+/**
+ * Convert a DXT1 image to rp_image.
+ * SSSE3-optimized version.
+ * S3TC palette index 3 will be interpreted as fully transparent.
+ *
+ * @param width Image width.
+ * @param height Image height.
+ * @param img_buf DXT1 image buffer.
+ * @param img_siz Size of image data. [must be >= (w*h)/2]
+ * @return rp_image, or nullptr on error.
+ */
+rp_image *ImageDecoder::fromDXT1_A1_ssse3(int width, int height,
+	const uint8_t *RESTRICT img_buf, int img_siz)
+{
+	if (unlikely(!EnableS3TC)) {
+		return fromDXT1_A1_cpp(width, height, img_buf, img_siz);
+	}
+	return T_fromS3TC_simd128<S3TC_SIMD_DXT1_A1, S3TC_Ops_ssse3>(width, height, img_buf, img_siz);
+}
+
+/**
+ * Convert a DXT3 image to rp_image.
+ * SSSE3-optimized version.
+ * @param width Image width.
+ * @param height Image height.
+ * @param img_buf DXT3 image buffer.
+ * @param img_siz Size of image data. [must be >= (w*h)]
+ * @return rp_image, or nullptr on error.
+ */
+rp_image *ImageDecoder::fromDXT3_ssse3(int width, int height,
+	const uint8_t *RESTRICT img_buf, int img_siz)
+{
+	if (unlikely(!EnableS3TC)) {
+		return fromDXT3_cpp(width, height, img_buf, img_siz);
+	}
+	return T_fromS3TC_simd128<S3TC_SIMD_DXT3, S3TC_Ops_ssse3>(width, height, img_buf, img_siz);
+}
+
+/**
+ * Convert a DXT5 image to rp_image.
+ * SSSE3-optimized version.
+ * @param width Image width.
+ * @param height Image height.
+ * @param img_buf DXT5 image buffer.
+ * @param img_siz Size of image data. [must be >= (w*h)]
+ * @return rp_image, or nullptr on error.
+ */
+rp_image *ImageDecoder::fromDXT5_ssse3(int width, int height,
+	const uint8_t *RESTRICT img_buf, int img_siz)
+{
+	if (unlikely(!EnableS3TC)) {
+		return fromDXT5_cpp(width, height, img_buf, img_siz);
+	}
+	return T_fromS3TC_simd128<S3TC_SIMD_DXT5, S3TC_Ops_ssse3>(width, height, img_buf, img_siz);
+}
+
+/**
+ * Convert a BC4 (ATI1) image to rp_image.
+ * SSSE3-optimized version.
+ * @param width Image width.
+ * @param height Image height.
+ * @param img_buf BC4 image buffer.
+ * @param img_siz Size of image data. [must be >= (w*h)/2]
+ * @return rp_image, or nullptr on error.
+ */
+rp_image *ImageDecoder::fromBC4_ssse3(int width, int height,
+	const uint8_t *RESTRICT img_buf, int img_siz)
+{
+	if (unlikely(!EnableS3TC)) {
+		return fromBC4_cpp(width, height, img_buf, img_siz);
+	}
+	return T_fromS3TC_simd128<S3TC_SIMD_BC4, S3TC_Ops_ssse3>(width, height, img_buf, img_siz);
+}
+
+/**
+ * Convert a BC5 (ATI2) image to rp_image.
+ * SSSE3-optimized version.
+ * @param width Image width.
+ * @param height Image height.
+ * @param img_buf BC5 image buffer.
+ * @param img_siz Size of image data. [must be >= (w*h)]
+ * @return rp_image, or nullptr on error.
+ */
+rp_image *ImageDecoder::fromBC5_ssse3(int width, int height,
+	const uint8_t *RESTRICT img_buf, int img_siz)
+{
+	if (unlikely(!EnableS3TC)) {
+		return fromBC5_cpp(width, height, img_buf, img_siz);
+	}
+	return T_fromS3TC_simd128<S3TC_SIMD_BC5, S3TC_Ops_ssse3>(width, height, img_buf, img_siz);
+}
+
+}
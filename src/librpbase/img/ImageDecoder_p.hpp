@@ -86,6 +86,40 @@ class ImageDecoderPrivate
 		// NOTE: Implementation is in ImageDecoder_Linear.cpp.
 		static const uint8_t c3_lookup[8];
 
+		/** BC7 tables. **/
+
+		// Partition definitions for modes with 2 and 3 subsets.
+		// NOTE: Implementation is in ImageDecoder_BC7.cpp.
+		static const uint32_t BC7_Subsets2[64];
+		static const uint32_t BC7_Subsets3[64];
+
+		// Anchor indexes for the second subset in 2-subset modes,
+		// and the second and third subsets in 3-subset modes.
+		// NOTE: Implementation is in ImageDecoder_BC7.cpp.
+		static const uint8_t BC7_Anchor2of2[64];
+		static const uint8_t BC7_Anchor2of3[64];
+		static const uint8_t BC7_Anchor3of3[64];
+
+		/** ETC1/ETC2 tables. **/
+
+		// Intensity modifier sets for ETC1 and ETC2 punchthrough alpha.
+		// Index 0 is the table codeword; index 1 is the pixel index value.
+		// NOTE: Implementation is in ImageDecoder_ETC1.cpp.
+		static const int16_t ETC1_intensity[8][4];
+		static const int16_t ETC2_intensity_a1[8][4];
+
+		// 3-bit 2's complement lookup table.
+		// NOTE: Implementation is in ImageDecoder_ETC1.cpp.
+		static const int8_t ETC1_3bit_diff_tbl[8];
+
+		// ETC2 distance table for 'T' and 'H' modes.
+		// NOTE: Implementation is in ImageDecoder_ETC1.cpp.
+		static const uint8_t ETC2_dist_tbl[8];
+
+		// ETC2 alpha modifiers table.
+		// NOTE: Implementation is in ImageDecoder_ETC1.cpp.
+		static const int8_t ETC2_alpha_tbl[16][8];
+
 		// 16-bit RGB
 
 		/**
@@ -0,0 +1,467 @@
+/***************************************************************************
+ * ROM Properties Page shell extension. (librpbase)                        *
+ * ImagePipeline.cpp: Single-pass image conversion pipeline.               *
+ *                                                                         *
+ * Copyright (c) 2016-2019 by David Korth.                                 *
+ *                                                                         *
+ * This program is free software; you can redistribute it and/or modify it *
+ * under the terms of the GNU General Public License as published by the   *
+ * Free Software Foundation; either version 2 of the License, or (at your  *
+ * option) any later version.                                              *
+ *                                                                         *
+ * This program is distributed in the hope that it will be useful, but     *
+ * WITHOUT ANY WARRANTY; without even the implied warranty of              *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the           *
+ * GNU General Public License for more details.                            *
+ *                                                                         *
+ * You should have received a copy of the GNU General Public License       *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.   *
+ ***************************************************************************/
+
+#include "ImagePipeline.hpp"
+#include "rp_image.hpp"
+
+// C includes. (C++ namespace)
+#include <cassert>
+#include <cerrno>
+#include <cstring>
+
+// C++ includes.
+#include <algorithm>
+
+namespace LibRpBase {
+
+/**
+ * Un-premultiply an ARGB32 pixel.
+ * Same as the standard version in un-premultiply.cpp.
+ * @param px	[in] ARGB32 pixel to un-premultiply.
+ * @return Un-premultiplied pixel.
+ */
+static FORCEINLINE uint32_t un_premultiply_pixel(uint32_t px)
+{
+	argb32_t rpx;
+	rpx.u32 = px;
+	if (likely(rpx.a == 255 || rpx.a == 0))
+		return px;
+
+	// Based on Qt 5.9.1's qUnpremultiply().
+	const unsigned int invAlpha = rp_image::qt_inv_premul_factor[rpx.a];
+	rpx.r = (rpx.r * invAlpha + 0x8000) >> 16;
+	rpx.g = (rpx.g * invAlpha + 0x8000) >> 16;
+	rpx.b = (rpx.b * invAlpha + 0x8000) >> 16;
+	return rpx.u32;
+}
+
+/**
+ * Apply an alpha operation to an array of ARGB32 pixels.
+ * @param op	[in] Alpha operation.
+ * @param px	[in,out] Pixels.
+ * @param count	[in] Number of pixels.
+ */
+static void applyAlphaOp(ImagePipeline::AlphaOp op, uint32_t *px, int count)
+{
+	switch (op) {
+		case ImagePipeline::ALPHA_UN_PREMULTIPLY:
+			for (; count > 0; count--, px++) {
+				*px = un_premultiply_pixel(*px);
+			}
+			break;
+		case ImagePipeline::ALPHA_PREMULTIPLY:
+			for (; count > 0; count--, px++) {
+				*px = rp_image::premultiply_pixel(*px);
+			}
+			break;
+		case ImagePipeline::ALPHA_NONE:
+		default:
+			break;
+	}
+}
+
+/**
+ * Create an image pipeline.
+ * @param src Source image. (CI8 or ARGB32; must remain valid)
+ */
+ImagePipeline::ImagePipeline(const rp_image *src)
+	: m_src(src)
+	, m_src_width(0)
+	, m_src_height(0)
+	, m_valid(false)
+	, m_alphaOp(ALPHA_NONE)
+	, m_filter(SCALE_NEAREST)
+	, m_vflip(false)
+	, m_square(false)
+	, m_scale_width(0)
+	, m_scale_height(0)
+	, m_width(0)
+	, m_height(0)
+	, m_content_x(0)
+	, m_content_y(0)
+{
+	memset(m_palette, 0, sizeof(m_palette));
+
+	assert(src != nullptr);
+	assert(src && src->isValid());
+	if (!src || !src->isValid())
+		return;
+
+	const rp_image::Format format = src->format();
+	assert(format == rp_image::FORMAT_CI8 || format == rp_image::FORMAT_ARGB32);
+	if (format != rp_image::FORMAT_CI8 && format != rp_image::FORMAT_ARGB32)
+		return;
+
+	m_src_width = src->width();
+	m_src_height = src->height();
+	m_scale_width = m_src_width;
+	m_scale_height = m_src_height;
+	m_valid = (m_src_width > 0 && m_src_height > 0);
+
+	if (format == rp_image::FORMAT_CI8) {
+		// Copy the palette.
+		// Entries past the end of the source palette are transparent.
+		const uint32_t *const palette = src->palette();
+		const int palette_len = std::min(src->palette_len(), 256);
+		if (palette && palette_len > 0) {
+			memcpy(m_palette, palette, palette_len * sizeof(uint32_t));
+		}
+	}
+
+	// Temporary buffer for converted source rows.
+	m_row.resize(m_src_width);
+	updateGeometry();
+}
+
+/**
+ * Set the alpha operation.
+ * @param op Alpha operation.
+ * @return This pipeline.
+ */
+ImagePipeline &ImagePipeline::setAlphaOp(AlphaOp op)
+{
+	if (op == m_alphaOp)
+		return *this;
+
+	if (m_valid && m_src->format() == rp_image::FORMAT_CI8) {
+		// Apply the alpha operation to the palette instead of each pixel.
+		const uint32_t *const palette = m_src->palette();
+		const int palette_len = std::min(m_src->palette_len(), 256);
+		if (palette && palette_len > 0) {
+			memcpy(m_palette, palette, palette_len * sizeof(uint32_t));
+			applyAlphaOp(op, m_palette, palette_len);
+		}
+	}
+
+	m_alphaOp = op;
+	return *this;
+}
+
+/**
+ * Vertically flip the image.
+ * @param vflip If true, flip the image.
+ * @return This pipeline.
+ */
+ImagePipeline &ImagePipeline::setVFlip(bool vflip)
+{
+	m_vflip = vflip;
+	return *this;
+}
+
+/**
+ * Scale the image.
+ * @param width Scaled width.
+ * @param height Scaled height.
+ * @param filter Scaling filter.
+ * @return This pipeline.
+ */
+ImagePipeline &ImagePipeline::setScale(int width, int height, ScaleFilter filter)
+{
+	assert(width > 0);
+	assert(height > 0);
+	if (width <= 0 || height <= 0) {
+		// Invalid size.
+		m_valid = false;
+		return *this;
+	}
+
+	m_scale_width = width;
+	m_scale_height = height;
+	m_filter = filter;
+	updateGeometry();
+	return *this;
+}
+
+/**
+ * Pad the image to a square.
+ * Transparent rows or columns will be added to
+ * center the image, as in rp_image::squared().
+ * @param square If true, pad the image to a square.
+ * @return This pipeline.
+ */
+ImagePipeline &ImagePipeline::setSquare(bool square)
+{
+	m_square = square;
+	updateGeometry();
+	return *this;
+}
+
+/**
+ * Is the pipeline valid?
+ * The source image must be valid and either CI8 or ARGB32.
+ * @return True if valid; false if not.
+ */
+bool ImagePipeline::isValid(void) const
+{
+	return m_valid;
+}
+
+/**
+ * Get the output image width.
+ * @return Output image width.
+ */
+int ImagePipeline::width(void) const
+{
+	return m_width;
+}
+
+/**
+ * Get the output image height.
+ * @return Output image height.
+ */
+int ImagePipeline::height(void) const
+{
+	return m_height;
+}
+
+/**
+ * Initialize the output geometry.
+ * This is called after changing the scale or square settings.
+ */
+void ImagePipeline::updateGeometry(void)
+{
+	m_width = m_scale_width;
+	m_height = m_scale_height;
+	m_content_x = 0;
+	m_content_y = 0;
+
+	if (m_square) {
+		// Center the image, as in rp_image::squared().
+		if (m_width > m_height) {
+			m_content_y = (m_width - m_height) / 2;
+			m_height = m_width;
+		} else if (m_width < m_height) {
+			m_content_x = (m_height - m_width) / 2;
+			m_width = m_height;
+		}
+	}
+
+	if (m_filter == SCALE_BOX) {
+		// Alpha, plus alpha-weighted R, G, and B.
+		m_acc.resize(m_scale_width * 4);
+	}
+}
+
+/**
+ * Get a source row, converted to ARGB32 with alpha processing.
+ * @param sy Source row, before flipping.
+ * @return Pointer to the row.
+ */
+const uint32_t *ImagePipeline::sourceRow(int sy)
+{
+	if (m_vflip) {
+		sy = m_src_height - 1 - sy;
+	}
+
+	if (m_src->format() == rp_image::FORMAT_CI8) {
+		// Convert from CI8 to ARGB32.
+		// The alpha operation was applied to the palette.
+		const uint8_t *src = static_cast<const uint8_t*>(m_src->scanLine(sy));
+		uint32_t *dest = m_row.data();
+		for (int x = m_src_width; x > 0; x--) {
+			*dest++ = m_palette[*src++];
+		}
+		return m_row.data();
+	}
+
+	const uint32_t *const src = static_cast<const uint32_t*>(m_src->scanLine(sy));
+	if (m_alphaOp == ALPHA_NONE) {
+		// No conversion is needed.
+		return src;
+	}
+
+	memcpy(m_row.data(), src, m_src_width * sizeof(uint32_t));
+	applyAlphaOp(m_alphaOp, m_row.data(), m_src_width);
+	return m_row.data();
+}
+
+/**
+ * Scale one row of the content area using box filtering.
+ * @param y	[in] Content row.
+ * @param dest	[out] Output buffer for the content area.
+ */
+void ImagePipeline::boxRow(int y, uint32_t *dest)
+{
+	const int sw = m_src_width;
+	const int sh = m_src_height;
+	const int cw = m_scale_width;
+	const int ch = m_scale_height;
+
+	// Source rows for this output row.
+	// If upscaling, each box contains at least one pixel.
+	const int sy0 = static_cast<int>((static_cast<int64_t>(y) * sh) / ch);
+	const int sy1 = std::max(sy0 + 1,
+		static_cast<int>((static_cast<int64_t>(y + 1) * sh) / ch));
+
+	std::fill(m_acc.begin(), m_acc.end(), 0);
+	for (int sy = sy0; sy < sy1; sy++) {
+		const uint32_t *const src = sourceRow(sy);
+		uint64_t *p = m_acc.data();
+		int sx0 = 0;
+		for (int x = 0; x < cw; x++, p += 4) {
+			const int sx1 = std::max(sx0 + 1,
+				static_cast<int>((static_cast<int64_t>(x + 1) * sw) / cw));
+			for (int sx = sx0; sx < sx1; sx++) {
+				// Color channels are weighted by alpha in order to
+				// prevent transparent pixels from bleeding.
+				const uint32_t px = src[sx];
+				const uint32_t a = (px >> 24);
+				p[0] += a;
+				p[1] += ((px >> 16) & 0xFF) * a;
+				p[2] += ((px >>  8) & 0xFF) * a;
+				p[3] += ( px        & 0xFF) * a;
+			}
+			sx0 = static_cast<int>((static_cast<int64_t>(x + 1) * sw) / cw);
+		}
+	}
+
+	const uint64_t *p = m_acc.data();
+	int sx0 = 0;
+	for (int x = 0; x < cw; x++, p += 4) {
+		const int sx1 = std::max(sx0 + 1,
+			static_cast<int>((static_cast<int64_t>(x + 1) * sw) / cw));
+		const uint64_t box_area = static_cast<uint64_t>(sx1 - sx0) * (sy1 - sy0);
+		const uint64_t a_sum = p[0];
+		if (a_sum == 0) {
+			// Fully transparent.
+			dest[x] = 0;
+		} else {
+			const uint64_t a_half = a_sum / 2;
+			dest[x] = (static_cast<uint32_t>((a_sum + (box_area / 2)) / box_area) << 24) |
+				  (static_cast<uint32_t>((p[1] + a_half) / a_sum) << 16) |
+				  (static_cast<uint32_t>((p[2] + a_half) / a_sum) <<  8) |
+				   static_cast<uint32_t>((p[3] + a_half) / a_sum);
+		}
+		sx0 = static_cast<int>((static_cast<int64_t>(x + 1) * sw) / cw);
+	}
+}
+
+/**
+ * Generate one row of the output image.
+ * @param y	[in] Output row.
+ * @param dest	[out] Output row buffer. (ARGB32; must have width() pixels)
+ * @return 0 on success; negative POSIX error code on error.
+ */
+int ImagePipeline::processRow(int y, uint32_t *dest)
+{
+	assert(m_valid);
+	assert(dest != nullptr);
+	assert(y >= 0 && y < m_height);
+	if (!m_valid || !dest || y < 0 || y >= m_height)
+		return -EINVAL;
+
+	const int cw = m_scale_width;
+	const int ch = m_scale_height;
+	const int cy = y - m_content_y;
+	if (cy < 0 || cy >= ch) {
+		// Square padding row.
+		memset(dest, 0, m_width * sizeof(uint32_t));
+		return 0;
+	}
+
+	// Square padding columns.
+	if (cw < m_width) {
+		memset(dest, 0, m_content_x * sizeof(uint32_t));
+		memset(&dest[m_content_x + cw], 0, (m_width - m_content_x - cw) * sizeof(uint32_t));
+		dest += m_content_x;
+	}
+
+	const int sw = m_src_width;
+	const int sh = m_src_height;
+	if (m_filter == SCALE_BOX && (cw != sw || ch != sh)) {
+		// Box filter.
+		boxRow(cy, dest);
+		return 0;
+	}
+
+	// Nearest-neighbor.
+	const int sy = static_cast<int>((static_cast<int64_t>(cy) * sh) / ch);
+	const uint32_t *const src = sourceRow(sy);
+	if (cw == sw) {
+		// Same width.
+		memcpy(dest, src, cw * sizeof(uint32_t));
+	} else {
+		for (int x = 0; x < cw; x++) {
+			dest[x] = src[(static_cast<int64_t>(x) * sw) / cw];
+		}
+	}
+	return 0;
+}
+
+/**
+ * Generate the output image into a caller-provided buffer.
+ * @param dest		[out] Output buffer. (ARGB32)
+ * @param dest_stride	[in] Output stride, in bytes.
+ * @return 0 on success; negative POSIX error code on error.
+ */
+int ImagePipeline::process(void *dest, int dest_stride)
+{
+	assert(dest != nullptr);
+	assert(dest_stride >= m_width * static_cast<int>(sizeof(uint32_t)));
+	if (!m_valid || !dest || dest_stride < m_width * static_cast<int>(sizeof(uint32_t)))
+		return -EINVAL;
+
+	// NOTE: Using uint8_t* because stride is measured in bytes.
+	uint8_t *row = static_cast<uint8_t*>(dest);
+	for (int y = 0; y < m_height; y++, row += dest_stride) {
+		int ret = processRow(y, reinterpret_cast<uint32_t*>(row));
+		if (ret != 0)
+			return ret;
+	}
+	return 0;
+}
+
+/**
+ * Generate the output image as a new rp_image.
+ * sBIT metadata is copied from the source image.
+ * @return New ARGB32 rp_image, or nullptr on error.
+ */
+rp_image *ImagePipeline::toImage(void)
+{
+	if (!m_valid)
+		return nullptr;
+
+	rp_image *img = new rp_image(m_width, m_height, rp_image::FORMAT_ARGB32);
+	if (!img->isValid()) {
+		// Could not allocate the image.
+		delete img;
+		return nullptr;
+	}
+
+	if (process(img->bits(), img->stride()) != 0) {
+		// Error processing the image.
+		delete img;
+		return nullptr;
+	}
+
+	// Copy sBIT if it's set.
+	rp_image::sBIT_t sBIT;
+	if (m_src->get_sBIT(&sBIT) == 0) {
+		if (sBIT.alpha == 0 && (m_width != m_scale_width || m_height != m_scale_height)) {
+			// Square padding is transparent.
+			sBIT.alpha = 1;
+		}
+		img->set_sBIT(&sBIT);
+	}
+
+	return img;
+}
+
+}
@@ -0,0 +1,204 @@
+/***************************************************************************
+ * ROM Properties Page shell extension. (librpbase)                        *
+ * ImagePipeline.hpp: Single-pass image conversion pipeline.               *
+ *                                                                         *
+ * Copyright (c) 2016-2019 by David Korth.                                 *
+ *                                                                         *
+ * This program is free software; you can redistribute it and/or modify it *
+ * under the terms of the GNU General Public License as published by the   *
+ * Free Software Foundation; either version 2 of the License, or (at your  *
+ * option) any later version.                                              *
+ *                                                                         *
+ * This program is distributed in the hope that it will be useful, but     *
+ * WITHOUT ANY WARRANTY; without even the implied warranty of              *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the           *
+ * GNU General Public License for more details.                            *
+ *                                                                         *
+ * You should have received a copy of the GNU General Public License       *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.   *
+ ***************************************************************************/
+
+#ifndef __ROMPROPERTIES_LIBRPBASE_IMG_IMAGEPIPELINE_HPP__
+#define __ROMPROPERTIES_LIBRPBASE_IMG_IMAGEPIPELINE_HPP__
+
+#include "common.h"
+
+// C includes.
+#include <stdint.h>
+
+// C++ includes.
+#include <vector>
+
+namespace LibRpBase {
+
+class rp_image;
+
+/**
+ * Single-pass image conversion pipeline.
+ *
+ * The output image is generated one row at a time. Each output
+ * row is processed by these stages, in order:
+ * - Format conversion. (CI8 -> ARGB32)
+ * - Premultiplied alpha handling.
+ * - Vertical flip.
+ * - Scaling. (nearest-neighbor or box filter)
+ * - Padding to a square image.
+ *
+ * This replaces chains like dup_ARGB32(), un_premultiply(),
+ * vflip(), and squared(), each of which allocates a new
+ * full-size image. Only the output is full-size; temporary
+ * data is limited to one source row plus one output row.
+ *
+ * Output is always ARGB32.
+ */
+class ImagePipeline
+{
+	public:
+		/**
+		 * Create an image pipeline.
+		 * @param src Source image. (CI8 or ARGB32; must remain valid)
+		 */
+		explicit ImagePipeline(const rp_image *src);
+
+	private:
+		RP_DISABLE_COPY(ImagePipeline)
+
+	public:
+		enum AlphaOp {
+			ALPHA_NONE,		// No alpha processing.
+			ALPHA_UN_PREMULTIPLY,	// Source is premultiplied; convert to straight alpha.
+			ALPHA_PREMULTIPLY,	// Source is straight alpha; convert to premultiplied.
+		};
+
+		enum ScaleFilter {
+			SCALE_NEAREST,	// Nearest-neighbor.
+			SCALE_BOX,	// Box filter. (Use for downscaling.)
+		};
+
+		/**
+		 * Set the alpha operation.
+		 * @param op Alpha operation.
+		 * @return This pipeline.
+		 */
+		ImagePipeline &setAlphaOp(AlphaOp op);
+
+		/**
+		 * Vertically flip the image.
+		 * @param vflip If true, flip the image.
+		 * @return This pipeline.
+		 */
+		ImagePipeline &setVFlip(bool vflip);
+
+		/**
+		 * Scale the image.
+		 * @param width Scaled width.
+		 * @param height Scaled height.
+		 * @param filter Scaling filter.
+		 * @return This pipeline.
+		 */
+		ImagePipeline &setScale(int width, int height, ScaleFilter filter = SCALE_NEAREST);
+
+		/**
+		 * Pad the image to a square.
+		 * Transparent rows or columns will be added to
+		 * center the image, as in rp_image::squared().
+		 * @param square If true, pad the image to a square.
+		 * @return This pipeline.
+		 */
+		ImagePipeline &setSquare(bool square);
+
+	public:
+		/**
+		 * Is the pipeline valid?
+		 * The source image must be valid and either CI8 or ARGB32.
+		 * @return True if valid; false if not.
+		 */
+		bool isValid(void) const;
+
+		/**
+		 * Get the output image width.
+		 * @return Output image width.
+		 */
+		int width(void) const;
+
+		/**
+		 * Get the output image height.
+		 * @return Output image height.
+		 */
+		int height(void) const;
+
+		/**
+		 * Generate one row of the output image.
+		 * @param y	[in] Output row.
+		 * @param dest	[out] Output row buffer. (ARGB32; must have width() pixels)
+		 * @return 0 on success; negative POSIX error code on error.
+		 */
+		int processRow(int y, uint32_t *dest);
+
+		/**
+		 * Generate the output image into a caller-provided buffer.
+		 * @param dest		[out] Output buffer. (ARGB32)
+		 * @param dest_stride	[in] Output stride, in bytes.
+		 * @return 0 on success; negative POSIX error code on error.
+		 */
+		int process(void *dest, int dest_stride);
+
+		/**
+		 * Generate the output image as a new rp_image.
+		 * sBIT metadata is copied from the source image.
+		 * @return New ARGB32 rp_image, or nullptr on error.
+		 */
+		rp_image *toImage(void);
+
+	private:
+		/**
+		 * Initialize the output geometry.
+		 * This is called after changing the scale or square settings.
+		 */
+		void updateGeometry(void);
+
+		/**
+		 * Get a source row, converted to ARGB32 with alpha processing.
+		 * @param sy Source row, before flipping.
+		 * @return Pointer to the row.
+		 */
+		const uint32_t *sourceRow(int sy);
+
+		/**
+		 * Scale one row of the content area using box filtering.
+		 * @param y	[in] Content row.
+		 * @param dest	[out] Output buffer for the content area.
+		 */
+		void boxRow(int y, uint32_t *dest);
+
+	private:
+		const rp_image *m_src;
+		int m_src_width;
+		int m_src_height;
+		bool m_valid;
+
+		// Stage settings.
+		AlphaOp m_alphaOp;
+		ScaleFilter m_filter;
+		bool m_vflip;
+		bool m_square;
+		int m_scale_width;	// Scaled content width.
+		int m_scale_height;	// Scaled content height.
+
+		// Output geometry.
+		int m_width;		// Output width.
+		int m_height;		// Output height.
+		int m_content_x;	// Content X offset. (square padding)
+		int m_content_y;	// Content Y offset. (square padding)
+
+		// ARGB32 palette for CI8 images.
+		uint32_t m_palette[256];
+
+		// Temporary row buffers.
+		std::vector<uint32_t> m_row;	// One source row.
+		std::vector<uint64_t> m_acc;	// Box filter accumulators.
+};
+
+}
+
+#endif /* __ROMPROPERTIES_LIBRPBASE_IMG_IMAGEPIPELINE_HPP__ */
@@ -26,6 +26,8 @@
 #include "TextFuncs.hpp"
 #include "file/RpFile.hpp"
 
+#include "ImagePipeline.hpp"
+
 // APNG
 #include "img/IconAnimData.hpp"
 #include "APNG_dlopen.h"
@@ -276,6 +278,19 @@ class RpPngWriterPrivate
 		 */
 		int write_IDAT(const png_byte *const *row_pointers, bool is_abgr = false);
 
+		/**
+		 * Write raw image data to the PNG image from an ImagePipeline.
+		 *
+		 * This must be called after any other modifier functions.
+		 *
+		 * NOTE: This will automatically close the file.
+		 * TODO: Keep it open so we can write text after IDAT?
+		 *
+		 * @param pipeline ImagePipeline. (Output size must match cache.width and cache.height.)
+		 * @return 0 on success; negative POSIX error code on error.
+		 */
+		int write_IDAT(ImagePipeline *pipeline);
+
 		/**
 		 * Write the rp_image data to the PNG image.
 		 *
@@ -759,6 +774,100 @@ int RpPngWriterPrivate::write_IDAT(const png_byte *const *row_pointers, bool is_
 	return 0;
 }
 
+/**
+ * Write raw image data to the PNG image from an ImagePipeline.
+ *
+ * This must be called after any other modifier functions.
+ *
+ * NOTE: This will automatically close the file.
+ * TODO: Keep it open so we can write text after IDAT?
+ *
+ * @param pipeline ImagePipeline. (Output size must match cache.width and cache.height.)
+ * @return 0 on success; negative POSIX error code on error.
+ */
+int RpPngWriterPrivate::write_IDAT(ImagePipeline *pipeline)
+{
+	assert(file != nullptr);
+	assert(imageTag == IMGT_RAW);
+	assert(IHDR_written);
+	if (unlikely(!file || imageTag != IMGT_RAW)) {
+		// Invalid state.
+		lastError = EIO;
+		return -lastError;
+	}
+	if (unlikely(!IHDR_written)) {
+		// IHDR has not been written yet.
+		// TODO: Better error code?
+		lastError = EIO;
+		return -lastError;
+	}
+
+	// Only ARGB32 is supported, and the size must match.
+	assert(cache.format == rp_image::FORMAT_ARGB32);
+	assert(pipeline->width() == cache.width);
+	assert(pipeline->height() == cache.height);
+	if (unlikely(cache.format != rp_image::FORMAT_ARGB32 ||
+	    pipeline->width() != cache.width ||
+	    pipeline->height() != cache.height))
+	{
+		lastError = EINVAL;
+		return -lastError;
+	}
+
+	// Row buffer. (NOTE: Allocated after setjmp().)
+	// This must be volatile, since it's modified after
+	// setjmp() and used if longjmp() is called.
+	png_byte *volatile row = nullptr;
+
+#ifdef PNG_SETJMP_SUPPORTED
+	// WARNING: Do NOT initialize any C++ objects past this point!
+	if (setjmp(png_jmpbuf(png_ptr))) {
+		// PNG write failed.
+		png_free(png_ptr, row);
+		return -EIO;
+	}
+#endif /* PNG_SETJMP_SUPPORTED */
+
+	// TODO: Byteswap image data on big-endian systems?
+	//png_set_swap(png_ptr);
+	// TODO: What format on big-endian?
+	png_set_bgr(png_ptr);
+
+	if (cache.skip_alpha) {
+		// Need to skip the alpha bytes.
+		// Assuming 'after' on LE, 'before' on BE.
+#if SYS_BYTEORDER == SYS_LIL_ENDIAN
+		static const int flags = PNG_FILLER_AFTER;
+#else /* SYS_BYTEORDER == SYS_BIG_ENDIAN */
+		static const int flags = PNG_FILLER_BEFORE;
+#endif
+		png_set_filler(png_ptr, 0xFF, flags);
+	}
+
+	// Allocate the row buffer.
+	row = static_cast<png_byte*>(png_malloc(png_ptr, cache.width * sizeof(uint32_t)));
+	if (!row) {
+		lastError = ENOMEM;
+		return -lastError;
+	}
+
+	// Write the image data, one row at a time.
+	int ret = 0;
+	for (int y = 0; y < cache.height; y++) {
+		ret = pipeline->processRow(y, reinterpret_cast<uint32_t*>(row));
+		if (ret != 0)
+			break;
+		png_write_row(png_ptr, row);
+	}
+
+	// Free the row buffer.
+	png_free(png_ptr, row);
+	if (ret != 0) {
+		lastError = -ret;
+	}
+	return ret;
+}
+
 /**
  * Write the rp_image data to the PNG image.
  *
@@ -787,24 +896,38 @@ int RpPngWriterPrivate::write_IDAT(void)
 		return -lastError;
 	}
 
-	// Allocate the row pointers.
-	const png_byte **row_pointers = static_cast<const png_byte**>(
-		png_malloc(png_ptr, sizeof(const png_byte*) * cache.height));
-	if (!row_pointers) {
-		lastError = ENOMEM;
-		return -lastError;
+#ifdef PNG_SETJMP_SUPPORTED
+	// WARNING: Do NOT initialize any C++ objects past this point!
+	if (setjmp(png_jmpbuf(png_ptr))) {
+		// PNG write failed.
+		return -EIO;
 	}
+#endif /* PNG_SETJMP_SUPPORTED */
+
+	// TODO: Byteswap image data on big-endian systems?
+	//png_set_swap(png_ptr);
+	// TODO: What format on big-endian?
+	png_set_bgr(png_ptr);
 
-	// Initialize the row pointers array.
-	for (int y = cache.height-1; y >= 0; y--) {
-		row_pointers[y] = static_cast<const png_byte*>(img->scanLine(y));
+	if (cache.skip_alpha && cache.format == rp_image::FORMAT_ARGB32) {
+		// Need to skip the alpha bytes.
+		// Assuming 'after' on LE, 'before' on BE.
+#if SYS_BYTEORDER == SYS_LIL_ENDIAN
+		static const int flags = PNG_FILLER_AFTER;
+#else /* SYS_BYTEORDER == SYS_BIG_ENDIAN */
+		static const int flags = PNG_FILLER_BEFORE;
+#endif
+		png_set_filler(png_ptr, 0xFF, flags);
 	}
 
-	// Write the image data.
-	int ret = write_IDAT(row_pointers);
-	// Free the row pointers.
-	png_free(png_ptr, row_pointers);
-	return ret;
+	// Write the image data, one row at a time.
+	// The rows are already in memory, so a row
+	// pointer array isn't needed.
+	for (int y = 0; y < cache.height; y++) {
+		png_write_row(png_ptr, const_cast<png_bytep>(
+			static_cast<const png_byte*>(img->scanLine(y))));
+	}
+	return 0;
 }
 
 /**
@@ -1416,6 +1539,41 @@ int RpPngWriter::write_IDAT(const uint8_t *const *row_pointers, bool is_abgr)
 	return d->write_IDAT(row_pointers, is_abgr);
 }
 
+/**
+ * Write raw image data to the PNG image from an ImagePipeline.
+ *
+ * Rows are generated and compressed one at a time,
+ * so the output image is never stored in memory.
+ *
+ * This must be called after any other modifier functions.
+ *
+ * If constructed using a filename instead of IRpFile,
+ * this will automatically close the file.
+ *
+ * NOTE: This version is *only* for raw ARGB32 images!
+ * The pipeline's output size must match the PNG image size.
+ *
+ * @param pipeline ImagePipeline.
+ * @return 0 on success; negative POSIX error code on error.
+ */
+int RpPngWriter::write_IDAT(ImagePipeline *pipeline)
+{
+	assert(pipeline != nullptr);
+	assert(pipeline && pipeline->isValid());
+	if (unlikely(!pipeline || !pipeline->isValid())) {
+		return -EINVAL;
+	}
+
+	RP_D(RpPngWriter);
+	assert(d->imageTag == RpPngWriterPrivate::IMGT_RAW);
+	if (unlikely(d->imageTag != RpPngWriterPrivate::IMGT_RAW)) {
+		// Can't be used for this type.
+		return -EINVAL;
+	}
+
+	return d->write_IDAT(pipeline);
+}
+
 /**
  * Write the rp_image data to the PNG image.
  *
@@ -32,6 +32,7 @@ namespace LibRpBase {
 
 class IRpFile;
 struct IconAnimData;
+class ImagePipeline;
 
 class RpPngWriterPrivate;
 class RpPngWriter
@@ -245,6 +246,25 @@ class RpPngWriter
 		 */
 		int write_IDAT(const uint8_t *const *row_pointers, bool is_abgr = false);
 
+		/**
+		 * Write raw image data to the PNG image from an ImagePipeline.
+		 *
+		 * Rows are generated and compressed one at a time,
+		 * so the output image is never stored in memory.
+		 *
+		 * This must be called after any other modifier functions.
+		 *
+		 * If constructed using a filename instead of IRpFile,
+		 * this will automatically close the file.
+		 *
+		 * NOTE: This version is *only* for raw ARGB32 images!
+		 * The pipeline's output size must match the PNG image size.
+		 *
+		 * @param pipeline ImagePipeline.
+		 * @return 0 on success; negative POSIX error code on error.
+		 */
+		int write_IDAT(ImagePipeline *pipeline);
+
 		/**
 		 * Write the rp_image data to the PNG image.
 		 *
@@ -23,12 +23,27 @@
 
 // AesCipher
 #include "../crypto/AesCipherFactory.hpp"
+#include "../crypto/AesParallel.hpp"
 #include "../crypto/IAesCipher.hpp"
+#include "librpbase/config.librpbase.h"
+#include "librpbase/cpu_dispatch.h"
+#if defined(RP_CPU_I386) || defined(RP_CPU_AMD64)
+# include "../crypto/AesNI.hpp"
+# if defined(_WIN32)
+#  include "../crypto/AesCAPI.hpp"
+#  define HAVE_AESNI_REFERENCE 1
+# elif defined(HAVE_NETTLE)
+#  include "../crypto/AesNettle.hpp"
+#  define HAVE_AESNI_REFERENCE 1
+# endif
+#endif /* RP_CPU_I386 || RP_CPU_AMD64 */
 
 // C includes. (C++ namespace)
 #include <cstdio>
+#include <cstring>
 
 // C++ includes.
+#include <chrono>
 #include <iostream>
 #include <sstream>
 #include <string>
@@ -491,6 +506,303 @@ INSTANTIATE_TEST_CASE_P(AesDecryptTest, AesCipherTest,
 		)
 
 	, AesCipherTest::test_case_suffix_generator);
+
+/**
+ * AesParallel tests.
+ * AesParallel is compared against a single AesCipher.
+ */
+class AesParallelTest : public ::testing::TestWithParam<IAesCipher::ChainingMode>
+{
+	public:
+		// Buffer size for tests.
+		// NOTE: Not a multiple of the chunk size.
+		static const size_t TEST_SIZE = (4*1024*1024) + (3*16);
+
+		// Number of iterations for benchmarks.
+		static const unsigned int BENCHMARK_ITERATIONS = 16;
+};
+
+/**
+ * Compare AesParallel against a single AesCipher.
+ */
+TEST_P(AesParallelTest, compareTest)
+{
+	const IAesCipher::ChainingMode mode = GetParam();
+	// Counter that overflows the low bytes during the test.
+	static const uint8_t ctr[16] = {
+		0x00,0x01,0x02,0x03,0x04,0x05,0x06,0x07,
+		0x08,0x09,0x0A,0x0B,0x0C,0xFF,0xFF,0xF0
+	};
+
+	// Pseudo-random data.
+	const size_t size = TEST_SIZE;
+	vector<uint8_t> data(size);
+	uint32_t seed = 0x87654321;
+	for (size_t i = 0; i < size; i++) {
+		seed = seed * 1103515245 + 12345;
+		data[i] = static_cast<uint8_t>(seed >> 16);
+	}
+
+	// Decrypt the data using a single cipher.
+	IAesCipher *const cipher = AesCipherFactory::create();
+	ASSERT_TRUE(cipher != nullptr);
+	ASSERT_EQ(0, cipher->setKey(AesCipherTest::aes_key, 16));
+	ASSERT_EQ(0, cipher->setChainingMode(mode));
+	if (mode != IAesCipher::CM_ECB) {
+		ASSERT_EQ(0, cipher->setIV(ctr, sizeof(ctr)));
+	}
+	vector<uint8_t> expected(data);
+	ASSERT_EQ(size, cipher->decrypt(expected.data(), size));
+	delete cipher;
+
+	// Decrypt the data using AesParallel.
+	vector<uint8_t> actual(data);
+	ASSERT_EQ(size, AesParallel::decrypt(mode,
+		AesCipherTest::aes_key, 16, ctr, actual.data(), size));
+	EXPECT_EQ(0, memcmp(expected.data(), actual.data(), size));
+
+	// Stop the worker threads.
+	// The next decrypt() call restarts them.
+	ASSERT_EQ(0, AesParallel::shutdown());
+	actual = data;
+	ASSERT_EQ(size, AesParallel::decrypt(mode,
+		AesCipherTest::aes_key, 16, ctr, actual.data(), size));
+	EXPECT_EQ(0, memcmp(expected.data(), actual.data(), size));
+}
+
+/**
+ * Benchmark AesParallel.
+ */
+TEST_P(AesParallelTest, decrypt_benchmark)
+{
+	const IAesCipher::ChainingMode mode = GetParam();
+	const size_t size = TEST_SIZE;
+	vector<uint8_t> buf(size);
+
+	const auto start = std::chrono::steady_clock::now();
+	for (unsigned int i = BENCHMARK_ITERATIONS; i > 0; i--) {
+		ASSERT_EQ(size, AesParallel::decrypt(mode,
+			AesCipherTest::aes_key, 16, AesCipherTest::aes_iv, buf.data(), size));
+	}
+	const auto end = std::chrono::steady_clock::now();
+
+	const double secs = std::chrono::duration<double>(end - start).count();
+	const double mb = (static_cast<double>(size) * BENCHMARK_ITERATIONS) / 1048576.0;
+	printf("AesParallel: %.1f MB in %.3f s: %.1f MB/s\n", mb, secs, mb / secs);
+}
+
+INSTANTIATE_TEST_CASE_P(AesParallelTest, AesParallelTest,
+	::testing::Values(IAesCipher::CM_ECB, IAesCipher::CM_CBC, IAesCipher::CM_CTR));
+
+#ifdef HAVE_AESNI_REFERENCE
+/**
+ * AesNI tests.
+ * AesNI is compared against the OS cipher implementation
+ * using large buffers, which exercises the multi-block
+ * code paths that the test vectors above don't reach.
+ */
+class AesNITest : public ::testing::Test
+{
+	protected:
+		AesNITest() { }
+
+		void SetUp(void) final
+		{
+			if (!AesNI::isUsable()) {
+				// TODO: GTEST_SKIP() once gtest is updated.
+				printf("AES-NI is not supported by this CPU; skipping.\n");
+			}
+		}
+
+	public:
+		// Number of blocks for comparison tests.
+		// NOTE: Not a multiple of 8 or 16, so the
+		// single-block tail code is also tested.
+		static const unsigned int COMPARE_BLOCKS = 1027;
+
+		// Buffer size for benchmarks.
+		static const size_t BENCHMARK_SIZE = 16*1024*1024;
+		// Number of iterations for benchmarks.
+		static const unsigned int BENCHMARK_ITERATIONS = 8;
+
+		/**
+		 * Create the reference cipher.
+		 * @return Reference cipher.
+		 */
+		static IAesCipher *createReference(void)
+		{
+#ifdef _WIN32
+			return new AesCAPI();
+#else /* !_WIN32 */
+			return new AesNettle();
+#endif /* _WIN32 */
+		}
+
+		/**
+		 * Compare AesNI against the reference cipher.
+		 * @param mode		[in] Chaining mode.
+		 * @param key_len	[in] Key length.
+		 * @param iv		[in] IV/counter. (ignored for ECB)
+		 */
+		static void compare(IAesCipher::ChainingMode mode, unsigned int key_len, const uint8_t *iv);
+
+		/**
+		 * Run a benchmark.
+		 * @param cipher	[in] Cipher.
+		 * @param mode		[in] Chaining mode.
+		 */
+		static void benchmark(IAesCipher *cipher, IAesCipher::ChainingMode mode);
+};
+
+/**
+ * Compare AesNI against the reference cipher.
+ * @param mode		[in] Chaining mode.
+ * @param key_len	[in] Key length.
+ * @param iv		[in] IV/counter. (ignored for ECB)
+ */
+void AesNITest::compare(IAesCipher::ChainingMode mode, unsigned int key_len, const uint8_t *iv)
+{
+	if (!AesNI::isUsable())
+		return;
+
+	// Pseudo-random data.
+	const size_t size = COMPARE_BLOCKS * 16;
+	vector<uint8_t> data(size);
+	uint32_t seed = 0x12345678;
+	for (size_t i = 0; i < size; i++) {
+		seed = seed * 1103515245 + 12345;
+		data[i] = static_cast<uint8_t>(seed >> 16);
+	}
+
+	// Decrypt the data using the reference cipher.
+	IAesCipher *const ref = createReference();
+	ASSERT_TRUE(ref->isInit());
+	ASSERT_EQ(0, ref->setKey(AesCipherTest::aes_key, key_len));
+	ASSERT_EQ(0, ref->setChainingMode(mode));
+	if (mode != IAesCipher::CM_ECB) {
+		ASSERT_EQ(0, ref->setIV(iv, 16));
+	}
+	vector<uint8_t> expected(data);
+	ASSERT_EQ(size, ref->decrypt(expected.data(), size));
+	delete ref;
+
+	// Decrypt the data using AesNI in a single call.
+	AesNI aesni;
+	ASSERT_EQ(0, aesni.setKey(AesCipherTest::aes_key, key_len));
+	ASSERT_EQ(0, aesni.setChainingMode(mode));
+	if (mode != IAesCipher::CM_ECB) {
+		ASSERT_EQ(0, aesni.setIV(iv, 16));
+	}
+	vector<uint8_t> actual(data);
+	ASSERT_EQ(size, aesni.decrypt(actual.data(), size));
+	EXPECT_EQ(0, memcmp(expected.data(), actual.data(), size));
+
+	// Decrypt the data using AesNI in multiple calls.
+	// This verifies that the IV/counter is updated correctly.
+	static const unsigned int chunks[] = {1, 7, 8, 9, 15, 16, 17, 33, 100};
+	if (mode != IAesCipher::CM_ECB) {
+		ASSERT_EQ(0, aesni.setIV(iv, 16));
+	}
+	actual = data;
+	size_t pos = 0;
+	for (unsigned int i = 0; pos < size; i++) {
+		size_t len = chunks[i % ARRAY_SIZE(chunks)] * 16;
+		if (len > size - pos) {
+			len = size - pos;
+		}
+		ASSERT_EQ(len, aesni.decrypt(&actual[pos], len));
+		pos += len;
+	}
+	EXPECT_EQ(0, memcmp(expected.data(), actual.data(), size));
+}
+
+/**
+ * Run a benchmark.
+ * @param cipher	[in] Cipher.
+ * @param mode		[in] Chaining mode.
+ */
+void AesNITest::benchmark(IAesCipher *cipher, IAesCipher::ChainingMode mode)
+{
+	ASSERT_TRUE(cipher->isInit());
+	ASSERT_EQ(0, cipher->setKey(AesCipherTest::aes_key, 16));
+	ASSERT_EQ(0, cipher->setChainingMode(mode));
+	ASSERT_EQ(0, cipher->setIV(AesCipherTest::aes_iv, 16));
+
+	const size_t size = BENCHMARK_SIZE;
+	vector<uint8_t> buf(size);
+	const auto start = std::chrono::steady_clock::now();
+	for (unsigned int i = BENCHMARK_ITERATIONS; i > 0; i--) {
+		ASSERT_EQ(size, cipher->decrypt(buf.data(), size));
+	}
+	const auto end = std::chrono::steady_clock::now();
+
+	const double secs = std::chrono::duration<double>(end - start).count();
+	const double mb = (static_cast<double>(size) * BENCHMARK_ITERATIONS) / 1048576.0;
+	printf("%s: %.1f MB in %.3f s: %.1f MB/s\n", cipher->name(), mb, secs, mb / secs);
+}
+
+// Counter that overflows the low 64 bits during the test.
+static const uint8_t aesni_ctr_carry[16] = {
+	0x00,0x01,0x02,0x03,0x04,0x05,0x06,0x07,
+	0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFF,0xFE
+};
+
+TEST_F(AesNITest, ecbCompareTest)
+{
+	compare(IAesCipher::CM_ECB, 16, nullptr);
+	compare(IAesCipher::CM_ECB, 24, nullptr);
+	compare(IAesCipher::CM_ECB, 32, nullptr);
+}
+
+TEST_F(AesNITest, cbcCompareTest)
+{
+	compare(IAesCipher::CM_CBC, 16, AesCipherTest::aes_iv);
+	compare(IAesCipher::CM_CBC, 24, AesCipherTest::aes_iv);
+	compare(IAesCipher::CM_CBC, 32, AesCipherTest::aes_iv);
+}
+
+TEST_F(AesNITest, ctrCompareTest)
+{
+	compare(IAesCipher::CM_CTR, 16, AesCipherTest::aes_iv);
+	compare(IAesCipher::CM_CTR, 24, AesCipherTest::aes_iv);
+	compare(IAesCipher::CM_CTR, 32, AesCipherTest::aes_iv);
+}
+
+TEST_F(AesNITest, ctrCarryCompareTest)
+{
+	compare(IAesCipher::CM_CTR, 16, aesni_ctr_carry);
+}
+
+TEST_F(AesNITest, cbc_aesni_benchmark)
+{
+	if (!AesNI::isUsable())
+		return;
+	AesNI aesni;
+	benchmark(&aesni, IAesCipher::CM_CBC);
+}
+
+TEST_F(AesNITest, ctr_aesni_benchmark)
+{
+	if (!AesNI::isUsable())
+		return;
+	AesNI aesni;
+	benchmark(&aesni, IAesCipher::CM_CTR);
+}
+
+TEST_F(AesNITest, cbc_reference_benchmark)
+{
+	IAesCipher *const cipher = createReference();
+	benchmark(cipher, IAesCipher::CM_CBC);
+	delete cipher;
+}
+
+TEST_F(AesNITest, ctr_reference_benchmark)
+{
+	IAesCipher *const cipher = createReference();
+	benchmark(cipher, IAesCipher::CM_CTR);
+	delete cipher;
+}
+#endif /* HAVE_AESNI_REFERENCE */
 } }
 
 /**
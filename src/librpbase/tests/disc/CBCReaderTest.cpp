@@ -0,0 +1,273 @@
+/***************************************************************************
+ * ROM Properties Page shell extension. (librpbase/tests)                  *
+ * CBCReaderTest.cpp: CBCReader class test.                                *
+ *                                                                         *
+ * Copyright (c) 2016-2018 by David Korth.                                 *
+ *                                                                         *
+ * This program is free software; you can redistribute it and/or modify it *
+ * under the terms of the GNU General Public License as published by the   *
+ * Free Software Foundation; either version 2 of the License, or (at your  *
+ * option) any later version.                                              *
+ *                                                                         *
+ * This program is distributed in the hope that it will be useful, but     *
+ * WITHOUT ANY WARRANTY; without even the implied warranty of              *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the           *
+ * GNU General Public License for more details.                            *
+ *                                                                         *
+ * You should have received a copy of the GNU General Public License       *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.   *
+ ***************************************************************************/
+
+
+// Google Test
+#include "gtest/gtest.h"
+
+// librpbase
+#include "librpbase/crypto/AesCipherFactory.hpp"
+#include "librpbase/crypto/IAesCipher.hpp"
+#include "librpbase/disc/CBCReader.hpp"
+#include "librpbase/file/RpMemFile.hpp"
+
+// C includes. (C++ namespace)
+#include <cstdio>
+#include <cstring>
+
+// C++ includes.
+#include <string>
+#include <vector>
+using std::string;
+using std::vector;
+
+namespace LibRpBase { namespace Tests {
+
+/**
+ * IRpFile wrapper that counts reads.
+ */
+class CountingFile : public IRpFile
+{
+	public:
+		CountingFile(const void *buf, size_t size)
+			: m_file(buf, size)
+			, readCount(0)
+		{ }
+
+	private:
+		typedef IRpFile super;
+		RP_DISABLE_COPY(CountingFile)
+
+	public:
+		bool isOpen(void) const final { return m_file.isOpen(); }
+		IRpFile *dup(void) final { return nullptr; }
+		void close(void) final { m_file.close(); }
+		size_t read(void *ptr, size_t size) final
+		{
+			readCount++;
+			return m_file.read(ptr, size);
+		}
+		size_t write(const void *ptr, size_t size) final { return m_file.write(ptr, size); }
+		int seek(int64_t pos) final { return m_file.seek(pos); }
+		int64_t tell(void) final { return m_file.tell(); }
+		int truncate(int64_t size = 0) final { return m_file.truncate(size); }
+		size_t pread(int64_t pos, void *ptr, size_t size) final
+		{
+			readCount++;
+			return m_file.pread(pos, ptr, size);
+		}
+		int64_t size(void) final { return m_file.size(); }
+		string filename(void) const final { return m_file.filename(); }
+
+	private:
+		RpMemFile m_file;
+
+	public:
+		unsigned int readCount;	// Number of read() and pread() calls.
+};
+
+struct CBCReaderTest_mode
+{
+	bool cbc;		// True for CBC; false for ECB.
+	unsigned int offset;	// Encrypted data offset within the file.
+
+	CBCReaderTest_mode(bool cbc, unsigned int offset)
+		: cbc(cbc), offset(offset)
+	{ }
+};
+
+/**
+ * Formatting function for CBCReaderTest_mode.
+ */
+inline ::std::ostream& operator<<(::std::ostream& os, const CBCReaderTest_mode& mode)
+{
+	return os << (mode.cbc ? "CBC" : "ECB") << "_offset" << mode.offset;
+};
+
+class CBCReaderTest : public ::testing::TestWithParam<CBCReaderTest_mode>
+{
+	protected:
+		// Encrypted data size.
+		// NOTE: Not a multiple of the window size.
+		static const unsigned int DATA_SIZE = (256*1024) + (5*16);
+
+		void SetUp(void) final;
+
+	public:
+		static const uint8_t key[16];
+		static const uint8_t iv[16];
+
+		vector<uint8_t> fileData;	// File data, including cipher text.
+		vector<uint8_t> plainData;	// Expected plain text.
+};
+
+const unsigned int CBCReaderTest::DATA_SIZE;
+
+const uint8_t CBCReaderTest::key[16] = {
+	0x00,0x11,0x22,0x33,0x44,0x55,0x66,0x77,
+	0x88,0x99,0xAA,0xBB,0xCC,0xDD,0xEE,0xFF
+};
+
+const uint8_t CBCReaderTest::iv[16] = {
+	0xF0,0xE1,0xD2,0xC3,0xB4,0xA5,0x96,0x87,
+	0x78,0x69,0x5A,0x4B,0x3C,0x2D,0x1E,0x0F
+};
+
+/**
+ * SetUp() function.
+ * Run before each test.
+ */
+void CBCReaderTest::SetUp(void)
+{
+	const CBCReaderTest_mode &mode = GetParam();
+
+	// Pseudo-random cipher text.
+	// The expected plain text is obtained by decrypting
+	// all of it at once with a regular cipher.
+	fileData.resize(mode.offset + DATA_SIZE + 16);
+	uint32_t seed = 0x13579BDF;
+	for (size_t i = 0; i < fileData.size(); i++) {
+		seed = seed * 1103515245 + 12345;
+		fileData[i] = static_cast<uint8_t>(seed >> 16);
+	}
+
+	IAesCipher *const cipher = AesCipherFactory::create();
+	ASSERT_TRUE(cipher != nullptr);
+	ASSERT_EQ(0, cipher->setChainingMode(mode.cbc ? IAesCipher::CM_CBC : IAesCipher::CM_ECB));
+	ASSERT_EQ(0, cipher->setKey(key, sizeof(key)));
+	if (mode.cbc) {
+		ASSERT_EQ(0, cipher->setIV(iv, sizeof(iv)));
+	}
+	plainData.assign(fileData.begin() + mode.offset,
+		fileData.begin() + mode.offset + DATA_SIZE);
+	ASSERT_EQ(DATA_SIZE, cipher->decrypt(plainData.data(), DATA_SIZE));
+	delete cipher;
+}
+
+/**
+ * Read the entire data area at once.
+ */
+TEST_P(CBCReaderTest, fullReadTest)
+{
+	const CBCReaderTest_mode &mode = GetParam();
+	CountingFile file(fileData.data(), fileData.size());
+	CBCReader reader(&file, mode.offset, DATA_SIZE, key, mode.cbc ? iv : nullptr);
+	ASSERT_TRUE(reader.isOpen());
+
+	vector<uint8_t> buf(DATA_SIZE);
+	ASSERT_EQ(DATA_SIZE, reader.read(buf.data(), DATA_SIZE));
+	EXPECT_EQ(0, memcmp(plainData.data(), buf.data(), DATA_SIZE));
+}
+
+/**
+ * Small sequential reads with arbitrary lengths.
+ * Sequential reads must not re-read the IV from the file.
+ */
+TEST_P(CBCReaderTest, sequentialReadTest)
+{
+	const CBCReaderTest_mode &mode = GetParam();
+	CountingFile file(fileData.data(), fileData.size());
+	CBCReader reader(&file, mode.offset, DATA_SIZE, key, mode.cbc ? iv : nullptr);
+	ASSERT_TRUE(reader.isOpen());
+
+	vector<uint8_t> buf(DATA_SIZE);
+	size_t pos = 0;
+	for (unsigned int i = 0; pos < DATA_SIZE; i++) {
+		size_t len = 1 + ((i * 37) % 300);
+		if (len > DATA_SIZE - pos) {
+			len = DATA_SIZE - pos;
+		}
+		ASSERT_EQ(len, reader.read(&buf[pos], len)) << "pos == " << pos;
+		pos += len;
+	}
+	EXPECT_EQ(0, memcmp(plainData.data(), buf.data(), DATA_SIZE));
+
+	// One file read per 32 KB window.
+	EXPECT_LE(file.readCount, (DATA_SIZE + 32767U) / 32768U);
+}
+
+/**
+ * Random-access reads at arbitrary offsets and lengths.
+ */
+TEST_P(CBCReaderTest, randomReadTest)
+{
+	const CBCReaderTest_mode &mode = GetParam();
+	CountingFile file(fileData.data(), fileData.size());
+	CBCReader reader(&file, mode.offset, DATA_SIZE, key, mode.cbc ? iv : nullptr);
+	ASSERT_TRUE(reader.isOpen());
+
+	vector<uint8_t> buf(DATA_SIZE);
+	uint32_t seed = 0x2468ACE0;
+	for (unsigned int i = 0; i < 500; i++) {
+		seed = seed * 1103515245 + 12345;
+		const size_t pos = (seed >> 4) % DATA_SIZE;
+		seed = seed * 1103515245 + 12345;
+		// Mostly small reads, with some large reads.
+		size_t len = (i % 16 == 0)
+			? ((seed >> 4) % (DATA_SIZE / 2))
+			: ((seed >> 4) % 1024);
+		len++;
+		if (len > DATA_SIZE - pos) {
+			len = DATA_SIZE - pos;
+		}
+
+		ASSERT_EQ(len, reader.pread(pos, buf.data(), len)) << "pos == " << pos << ", len == " << len;
+		ASSERT_EQ(0, memcmp(&plainData[pos], buf.data(), len)) << "pos == " << pos << ", len == " << len;
+	}
+}
+
+/**
+ * Reads past the end of the data area are truncated.
+ */
+TEST_P(CBCReaderTest, endOfDataTest)
+{
+	const CBCReaderTest_mode &mode = GetParam();
+	CountingFile file(fileData.data(), fileData.size());
+	CBCReader reader(&file, mode.offset, DATA_SIZE, key, mode.cbc ? iv : nullptr);
+	ASSERT_TRUE(reader.isOpen());
+
+	uint8_t buf[64];
+	ASSERT_EQ(7U, reader.pread(DATA_SIZE - 7, buf, sizeof(buf)));
+	EXPECT_EQ(0, memcmp(&plainData[DATA_SIZE - 7], buf, 7));
+	EXPECT_EQ(0U, reader.pread(DATA_SIZE, buf, sizeof(buf)));
+}
+
+INSTANTIATE_TEST_CASE_P(CBCReaderTest, CBCReaderTest,
+	::testing::Values(
+		CBCReaderTest_mode(true, 0),
+		CBCReaderTest_mode(true, 0x40),
+		CBCReaderTest_mode(false, 0),
+		CBCReaderTest_mode(false, 0x40)
+		));
+
+} }
+
+/**
+ * Test suite main function.
+ */
+extern "C" int gtest_main(int argc, char *argv[])
+{
+	fprintf(stderr, "LibRpBase test suite: CBCReader tests.\n\n");
+	fflush(nullptr);
+
+	// coverity[fun_call_w_exception]: uncaught exceptions cause nonzero exit anyway, so don't warn.
+	::testing::InitGoogleTest(&argc, argv);
+	return RUN_ALL_TESTS();
+}
@@ -0,0 +1,317 @@
+/***************************************************************************
+ * ROM Properties Page shell extension. (librpbase/tests)                  *
+ * SparseDiscReaderTest.cpp: SparseDiscReader test.                        *
+ *                                                                         *
+ * Copyright (c) 2016-2018 by David Korth.                                 *
+ *                                                                         *
+ * This program is free software; you can redistribute it and/or modify it *
+ * under the terms of the GNU General Public License as published by the   *
+ * Free Software Foundation; either version 2 of the License, or (at your  *
+ * option) any later version.                                              *
+ *                                                                         *
+ * This program is distributed in the hope that it will be useful, but     *
+ * WITHOUT ANY WARRANTY; without even the implied warranty of              *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the           *
+ * GNU General Public License for more details.                            *
+ *                                                                         *
+ * You should have received a copy of the GNU General Public License       *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.   *
+ ***************************************************************************/
+
+// Google Test
+#include "gtest/gtest.h"
+
+// librpbase
+#include "librpbase/disc/SparseDiscReader.hpp"
+#include "librpbase/disc/SparseDiscReader_p.hpp"
+#include "librpbase/file/RpMemFile.hpp"
+
+// C includes. (C++ namespace)
+#include <cstdio>
+#include <cstring>
+
+// C++ includes.
+#include <vector>
+using std::vector;
+
+namespace LibRpBase { namespace Tests {
+
+/**
+ * Test disc reader.
+ * Logical blocks are mapped to physical blocks using a table.
+ */
+class TestSparseDiscReaderPrivate;
+class TestSparseDiscReader : public SparseDiscReader
+{
+	public:
+		TestSparseDiscReader(IRpFile *file, const vector<int64_t> &blockMap, unsigned int block_size);
+
+	private:
+		typedef SparseDiscReader super;
+		RP_DISABLE_COPY(TestSparseDiscReader)
+
+	public:
+		int isDiscSupported(const uint8_t *pHeader, size_t szHeader) const final
+		{
+			RP_UNUSED(pHeader);
+			RP_UNUSED(szHeader);
+			return 0;
+		}
+
+	protected:
+		int64_t getPhysBlockAddr(uint32_t blockIdx) const final;
+
+	public:
+		vector<int64_t> blockMap;
+		mutable unsigned int physBlockAddrCount;	// Number of getPhysBlockAddr() calls.
+};
+
+class TestSparseDiscReaderPrivate : public SparseDiscReaderPrivate
+{
+	public:
+		TestSparseDiscReaderPrivate(TestSparseDiscReader *q, IRpFile *file)
+			: SparseDiscReaderPrivate(q, file)
+		{ }
+};
+
+TestSparseDiscReader::TestSparseDiscReader(IRpFile *file, const vector<int64_t> &blockMap, unsigned int block_size)
+	: super(new TestSparseDiscReaderPrivate(this, file))
+	, blockMap(blockMap)
+	, physBlockAddrCount(0)
+{
+	RP_D(SparseDiscReader);
+	d->block_size = block_size;
+	d->disc_size = static_cast<int64_t>(blockMap.size()) * block_size;
+	d->pos = 0;
+}
+
+int64_t TestSparseDiscReader::getPhysBlockAddr(uint32_t blockIdx) const
+{
+	physBlockAddrCount++;
+	if (blockIdx >= blockMap.size())
+		return -1;
+	return blockMap[blockIdx];
+}
+
+class SparseDiscReaderTest : public ::testing::Test
+{
+	protected:
+		static const unsigned int BLOCK_SIZE = 16;
+		static const unsigned int BLOCK_COUNT = 24;
+
+		void SetUp(void) final;
+
+	public:
+		vector<uint8_t> physData;	// Physical disc image.
+		vector<uint8_t> logicalData;	// Expected logical data.
+		vector<int64_t> blockMap;	// Logical to physical block map.
+};
+
+/**
+ * SetUp() function.
+ * Run before each test.
+ */
+void SparseDiscReaderTest::SetUp(void)
+{
+	// Physical block order. (-1 == empty block)
+	// Includes contiguous runs, empty runs, and
+	// out-of-order blocks.
+	static const int8_t physBlocks[BLOCK_COUNT] = {
+		 0,  1,  2,  3, -1, -1,  4,  5,
+		 7,  6, -1,  8,  9, 10, 12, 11,
+		-1, -1, -1, 13, 14, 15, 16, -1,
+	};
+
+	// Physical image: Header block, followed by data blocks.
+	// The header is filled with 0xFF so that incorrect
+	// reads from address 0 will be detected.
+	physData.assign(BLOCK_SIZE * 18, 0xFF);
+	logicalData.assign(BLOCK_SIZE * BLOCK_COUNT, 0);
+	blockMap.resize(BLOCK_COUNT);
+	for (unsigned int i = 0; i < BLOCK_COUNT; i++) {
+		if (physBlocks[i] < 0) {
+			blockMap[i] = 0;
+			continue;
+		}
+
+		const unsigned int physAddr = (physBlocks[i] + 1) * BLOCK_SIZE;
+		blockMap[i] = physAddr;
+		for (unsigned int j = 0; j < BLOCK_SIZE; j++) {
+			const uint8_t val = static_cast<uint8_t>(i * 7 + j + 1);
+			physData[physAddr + j] = val;
+			logicalData[i * BLOCK_SIZE + j] = val;
+		}
+	}
+}
+
+/**
+ * Read every possible range with pread().
+ * @param reader Disc reader.
+ * @param logicalData Expected logical data.
+ */
+static void checkAllRanges(TestSparseDiscReader &reader, const vector<uint8_t> &logicalData)
+{
+	const size_t disc_size = logicalData.size();
+	vector<uint8_t> buf(disc_size + 1);
+	for (size_t pos = 0; pos < disc_size; pos++) {
+		for (size_t size = 1; pos + size <= disc_size; size++) {
+			memset(buf.data(), 0xCC, buf.size());
+			ASSERT_EQ(size, reader.pread(pos, buf.data(), size)) << "pos == " << pos << ", size == " << size;
+			ASSERT_EQ(0, memcmp(&logicalData[pos], buf.data(), size)) << "pos == " << pos << ", size == " << size;
+			ASSERT_EQ(0xCC, buf[size]) << "pos == " << pos << ", size == " << size;
+		}
+	}
+}
+
+/**
+ * Read every possible range with pread(), without the block cache.
+ */
+TEST_F(SparseDiscReaderTest, pread_allRanges_test)
+{
+	RpMemFile *const memFile = new RpMemFile(physData.data(), physData.size());
+	TestSparseDiscReader reader(memFile, blockMap, BLOCK_SIZE);
+	delete memFile;
+	ASSERT_TRUE(reader.isOpen());
+
+	reader.setCacheSize(0);
+	checkAllRanges(reader, logicalData);
+}
+
+/**
+ * Read every possible range with pread(), using the block cache.
+ * The cache is smaller than the disc, so lines will be evicted.
+ */
+TEST_F(SparseDiscReaderTest, pread_allRanges_cached_test)
+{
+	RpMemFile *const memFile = new RpMemFile(physData.data(), physData.size());
+	TestSparseDiscReader reader(memFile, blockMap, BLOCK_SIZE);
+	delete memFile;
+	ASSERT_TRUE(reader.isOpen());
+
+	reader.setCacheSize(BLOCK_SIZE * 5);
+	checkAllRanges(reader, logicalData);
+
+	SparseDiscReader::CacheStats stats;
+	reader.getCacheStats(&stats);
+	EXPECT_GT(stats.hits, 0U);
+	EXPECT_GT(stats.misses, 0U);
+	EXPECT_LE(stats.size, static_cast<size_t>(BLOCK_SIZE * 5));
+}
+
+/**
+ * Repeated small reads are satisfied by the block cache.
+ */
+TEST_F(SparseDiscReaderTest, cache_repeatedReads_test)
+{
+	RpMemFile *const memFile = new RpMemFile(physData.data(), physData.size());
+	TestSparseDiscReader reader(memFile, blockMap, BLOCK_SIZE);
+	delete memFile;
+	ASSERT_TRUE(reader.isOpen());
+
+	uint8_t buf[BLOCK_SIZE * 2];
+	for (unsigned int i = 0; i < 5; i++) {
+		ASSERT_EQ(8U, reader.pread(4, buf, 8));
+		EXPECT_EQ(0, memcmp(&logicalData[4], buf, 8));
+	}
+	EXPECT_EQ(1U, reader.physBlockAddrCount);
+
+	// Crossing into the next block only reads the new block.
+	ASSERT_EQ(sizeof(buf), reader.pread(8, buf, sizeof(buf)));
+	EXPECT_EQ(0, memcmp(&logicalData[8], buf, sizeof(buf)));
+	EXPECT_EQ(3U, reader.physBlockAddrCount);
+
+	SparseDiscReader::CacheStats stats;
+	reader.getCacheStats(&stats);
+	EXPECT_EQ(5U, stats.hits);
+	EXPECT_EQ(3U, stats.misses);
+	EXPECT_EQ(static_cast<size_t>(BLOCK_SIZE * 3), stats.size);
+
+	// Disabling the cache releases its memory.
+	const size_t globalSize = SparseDiscReader::globalCacheSize();
+	reader.setCacheSize(0);
+	reader.getCacheStats(&stats);
+	EXPECT_EQ(0U, stats.size);
+	EXPECT_EQ(globalSize - BLOCK_SIZE * 3, SparseDiscReader::globalCacheSize());
+}
+
+/**
+ * The process-wide cache limit is shared by all readers.
+ */
+TEST_F(SparseDiscReaderTest, cache_globalLimit_test)
+{
+	RpMemFile *const memFile = new RpMemFile(physData.data(), physData.size());
+	TestSparseDiscReader reader1(memFile, blockMap, BLOCK_SIZE);
+	TestSparseDiscReader reader2(memFile, blockMap, BLOCK_SIZE);
+	delete memFile;
+	ASSERT_TRUE(reader1.isOpen());
+	ASSERT_TRUE(reader2.isOpen());
+
+	ASSERT_EQ(0U, SparseDiscReader::globalCacheSize());
+	SparseDiscReader::setGlobalCacheSize(BLOCK_SIZE * 4);
+
+	// reader1 uses the entire budget.
+	uint8_t buf[BLOCK_SIZE * 8];
+	ASSERT_EQ(sizeof(buf), reader1.pread(0, buf, sizeof(buf)));
+	SparseDiscReader::CacheStats stats;
+	reader1.getCacheStats(&stats);
+	EXPECT_EQ(static_cast<size_t>(BLOCK_SIZE * 4), stats.size);
+
+	// reader2 can't add anything, but still reads correctly.
+	ASSERT_EQ(sizeof(buf), reader2.pread(0, buf, sizeof(buf)));
+	EXPECT_EQ(0, memcmp(logicalData.data(), buf, sizeof(buf)));
+	reader2.getCacheStats(&stats);
+	EXPECT_EQ(0U, stats.size);
+	EXPECT_EQ(static_cast<size_t>(BLOCK_SIZE * 4), SparseDiscReader::globalCacheSize());
+
+	SparseDiscReader::setGlobalCacheSize(0);
+}
+
+/**
+ * Short reads at the end of the disc.
+ */
+TEST_F(SparseDiscReaderTest, read_shortRead_test)
+{
+	RpMemFile *const memFile = new RpMemFile(physData.data(), physData.size());
+	TestSparseDiscReader reader(memFile, blockMap, BLOCK_SIZE);
+	delete memFile;
+	ASSERT_TRUE(reader.isOpen());
+
+	vector<uint8_t> buf(logicalData.size() * 2);
+	ASSERT_EQ(0, reader.seek(BLOCK_SIZE + 3));
+	const size_t expected = logicalData.size() - (BLOCK_SIZE + 3);
+	EXPECT_EQ(expected, reader.read(buf.data(), buf.size()));
+	EXPECT_EQ(0, memcmp(&logicalData[BLOCK_SIZE + 3], buf.data(), expected));
+	EXPECT_EQ(static_cast<int64_t>(logicalData.size()), reader.tell());
+	EXPECT_EQ(0U, reader.read(buf.data(), buf.size()));
+}
+
+/**
+ * A truncated physical image results in a short read.
+ */
+TEST_F(SparseDiscReaderTest, pread_truncated_test)
+{
+	// Remove the last physical block. (logical block 22)
+	RpMemFile *const memFile = new RpMemFile(physData.data(), physData.size() - BLOCK_SIZE);
+	TestSparseDiscReader reader(memFile, blockMap, BLOCK_SIZE);
+	delete memFile;
+	ASSERT_TRUE(reader.isOpen());
+
+	vector<uint8_t> buf(logicalData.size());
+	EXPECT_EQ(22U * BLOCK_SIZE, reader.pread(0, buf.data(), buf.size()));
+	EXPECT_EQ(0, memcmp(logicalData.data(), buf.data(), 22U * BLOCK_SIZE));
+}
+
+} }
+
+/**
+ * Test suite main function.
+ */
+extern "C" int gtest_main(int argc, char *argv[])
+{
+	fprintf(stderr, "LibRpBase test suite: SparseDiscReader tests.\n\n");
+	fflush(nullptr);
+
+	// coverity[fun_call_w_exception]: uncaught exceptions cause nonzero exit anyway, so don't warn.
+	::testing::InitGoogleTest(&argc, argv);
+	return RUN_ALL_TESTS();
+}
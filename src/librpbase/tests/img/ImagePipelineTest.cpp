@@ -0,0 +1,406 @@
+/***************************************************************************
+ * ROM Properties Page shell extension. (librpbase/tests)                  *
+ * ImagePipelineTest.cpp: ImagePipeline test.                              *
+ *                                                                         *
+ * Copyright (c) 2016-2019 by David Korth.                                 *
+ *                                                                         *
+ * This program is free software; you can redistribute it and/or modify it *
+ * under the terms of the GNU General Public License as published by the   *
+ * Free Software Foundation; either version 2 of the License, or (at your  *
+ * option) any later version.                                              *
+ *                                                                         *
+ * This program is distributed in the hope that it will be useful, but     *
+ * WITHOUT ANY WARRANTY; without even the implied warranty of              *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the           *
+ * GNU General Public License for more details.                            *
+ *                                                                         *
+ * You should have received a copy of the GNU General Public License       *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.   *
+ ***************************************************************************/
+
+// Google Test
+#include "gtest/gtest.h"
+
+// librpbase
+#include "librpbase/common.h"
+#include "librpbase/file/RpFile.hpp"
+#include "librpbase/file/FileSystem.hpp"
+#include "librpbase/img/rp_image.hpp"
+#include "librpbase/img/ImagePipeline.hpp"
+#include "librpbase/img/RpPng.hpp"
+#include "librpbase/img/RpPngWriter.hpp"
+
+// C includes.
+#include <stdint.h>
+#include <stdlib.h>
+
+// C includes. (C++ namespace)
+#include <cstring>
+
+// C++ includes.
+#include <memory>
+using std::unique_ptr;
+
+namespace LibRpBase { namespace Tests {
+
+class ImagePipelineTest : public ::testing::Test
+{
+	protected:
+		ImagePipelineTest() { }
+
+	public:
+		// Test image size. (Non-square)
+		static const int TEST_WIDTH = 24;
+		static const int TEST_HEIGHT = 16;
+
+		// Number of iterations for benchmarks.
+		static const unsigned int BENCHMARK_ITERATIONS = 1000;
+
+		/**
+		 * Create an ARGB32 test image with random pixels.
+		 * @param width Width.
+		 * @param height Height.
+		 * @param opaque If true, all pixels are opaque.
+		 * @return rp_image.
+		 */
+		static rp_image *createARGB32(int width, int height, bool opaque);
+
+		/**
+		 * Create a CI8 test image with a random palette and pixels.
+		 * @param width Width.
+		 * @param height Height.
+		 * @return rp_image.
+		 */
+		static rp_image *createCI8(int width, int height);
+
+		/**
+		 * Compare two ARGB32 images.
+		 * @param expected Expected image.
+		 * @param actual Actual image.
+		 */
+		static void compareImages(const rp_image *expected, const rp_image *actual);
+};
+
+/**
+ * Create an ARGB32 test image with random pixels.
+ * @param width Width.
+ * @param height Height.
+ * @param opaque If true, all pixels are opaque.
+ * @return rp_image.
+ */
+rp_image *ImagePipelineTest::createARGB32(int width, int height, bool opaque)
+{
+	rp_image *const img = new rp_image(width, height, rp_image::FORMAT_ARGB32);
+	for (int y = 0; y < height; y++) {
+		uint32_t *const row = static_cast<uint32_t*>(img->scanLine(y));
+		for (int x = 0; x < width; x++) {
+			uint32_t px = (static_cast<uint32_t>(rand() & 0xFFFF) << 16) |
+				static_cast<uint32_t>(rand() & 0xFFFF);
+			if (opaque) {
+				px |= 0xFF000000;
+			}
+			row[x] = px;
+		}
+	}
+	return img;
+}
+
+/**
+ * Create a CI8 test image with a random palette and pixels.
+ * @param width Width.
+ * @param height Height.
+ * @return rp_image.
+ */
+rp_image *ImagePipelineTest::createCI8(int width, int height)
+{
+	rp_image *const img = new rp_image(width, height, rp_image::FORMAT_CI8);
+	uint32_t *const palette = img->palette();
+	for (int i = 0; i < img->palette_len(); i++) {
+		palette[i] = (static_cast<uint32_t>(rand() & 0xFFFF) << 16) |
+			static_cast<uint32_t>(rand() & 0xFFFF);
+	}
+	for (int y = 0; y < height; y++) {
+		uint8_t *const row = static_cast<uint8_t*>(img->scanLine(y));
+		for (int x = 0; x < width; x++) {
+			row[x] = static_cast<uint8_t>(rand() & 0xFF);
+		}
+	}
+	return img;
+}
+
+/**
+ * Compare two ARGB32 images.
+ * @param expected Expected image.
+ * @param actual Actual image.
+ */
+void ImagePipelineTest::compareImages(const rp_image *expected, const rp_image *actual)
+{
+	ASSERT_TRUE(expected != nullptr);
+	ASSERT_TRUE(actual != nullptr);
+	ASSERT_EQ(rp_image::FORMAT_ARGB32, expected->format());
+	ASSERT_EQ(rp_image::FORMAT_ARGB32, actual->format());
+	ASSERT_EQ(expected->width(), actual->width());
+	ASSERT_EQ(expected->height(), actual->height());
+
+	const size_t row_bytes = expected->width() * sizeof(uint32_t);
+	for (int y = 0; y < expected->height(); y++) {
+		ASSERT_EQ(0, memcmp(expected->scanLine(y), actual->scanLine(y), row_bytes)) <<
+			"Row " << y << " does not match.";
+	}
+}
+
+/**
+ * Pipeline with no stages should copy the image.
+ */
+TEST_F(ImagePipelineTest, copyTest)
+{
+	unique_ptr<rp_image> src(createARGB32(TEST_WIDTH, TEST_HEIGHT, false));
+	ImagePipeline pipeline(src.get());
+	ASSERT_TRUE(pipeline.isValid());
+	EXPECT_EQ((int)TEST_WIDTH, pipeline.width());
+	EXPECT_EQ((int)TEST_HEIGHT, pipeline.height());
+
+	unique_ptr<rp_image> out(pipeline.toImage());
+	ASSERT_NO_FATAL_FAILURE(compareImages(src.get(), out.get()));
+}
+
+/**
+ * CI8 to ARGB32 conversion should match rp_image::dup_ARGB32().
+ */
+TEST_F(ImagePipelineTest, ci8Test)
+{
+	unique_ptr<rp_image> src(createCI8(TEST_WIDTH, TEST_HEIGHT));
+	unique_ptr<rp_image> expected(src->dup_ARGB32());
+	unique_ptr<rp_image> out(ImagePipeline(src.get()).toImage());
+	ASSERT_NO_FATAL_FAILURE(compareImages(expected.get(), out.get()));
+}
+
+/**
+ * Un-premultiply should match rp_image::un_premultiply().
+ */
+TEST_F(ImagePipelineTest, unPremultiplyTest)
+{
+	unique_ptr<rp_image> src(createARGB32(TEST_WIDTH, TEST_HEIGHT, false));
+	ASSERT_EQ(0, src->premultiply());
+	unique_ptr<rp_image> expected(src->dup());
+	ASSERT_EQ(0, expected->un_premultiply());
+
+	ImagePipeline pipeline(src.get());
+	pipeline.setAlphaOp(ImagePipeline::ALPHA_UN_PREMULTIPLY);
+	unique_ptr<rp_image> out(pipeline.toImage());
+	ASSERT_NO_FATAL_FAILURE(compareImages(expected.get(), out.get()));
+}
+
+/**
+ * Premultiply should match rp_image::premultiply(), including CI8.
+ */
+TEST_F(ImagePipelineTest, premultiplyTest)
+{
+	unique_ptr<rp_image> src(createCI8(TEST_WIDTH, TEST_HEIGHT));
+	unique_ptr<rp_image> expected(src->dup_ARGB32());
+	ASSERT_EQ(0, expected->premultiply());
+
+	ImagePipeline pipeline(src.get());
+	pipeline.setAlphaOp(ImagePipeline::ALPHA_PREMULTIPLY);
+	unique_ptr<rp_image> out(pipeline.toImage());
+	ASSERT_NO_FATAL_FAILURE(compareImages(expected.get(), out.get()));
+}
+
+/**
+ * Vertical flip should match rp_image::vflip().
+ */
+TEST_F(ImagePipelineTest, vflipTest)
+{
+	unique_ptr<rp_image> src(createARGB32(TEST_WIDTH, TEST_HEIGHT, false));
+	unique_ptr<rp_image> expected(src->vflip());
+
+	ImagePipeline pipeline(src.get());
+	pipeline.setVFlip(true);
+	unique_ptr<rp_image> out(pipeline.toImage());
+	ASSERT_NO_FATAL_FAILURE(compareImages(expected.get(), out.get()));
+}
+
+/**
+ * Square padding should match rp_image::squared().
+ */
+TEST_F(ImagePipelineTest, squareTest)
+{
+	// Wide image.
+	unique_ptr<rp_image> src(createARGB32(TEST_WIDTH, TEST_HEIGHT, false));
+	unique_ptr<rp_image> expected(src->squared());
+	ImagePipeline pipeline(src.get());
+	pipeline.setSquare(true);
+	unique_ptr<rp_image> out(pipeline.toImage());
+	ASSERT_NO_FATAL_FAILURE(compareImages(expected.get(), out.get()));
+
+	// Tall image. (Odd difference)
+	src.reset(createARGB32(TEST_HEIGHT - 3, TEST_WIDTH, false));
+	expected.reset(src->squared());
+	ImagePipeline pipeline2(src.get());
+	pipeline2.setSquare(true);
+	out.reset(pipeline2.toImage());
+	ASSERT_NO_FATAL_FAILURE(compareImages(expected.get(), out.get()));
+}
+
+/**
+ * Nearest-neighbor integer upscaling should replicate pixels.
+ */
+TEST_F(ImagePipelineTest, nearestTest)
+{
+	unique_ptr<rp_image> src(createCI8(TEST_WIDTH, TEST_HEIGHT));
+	unique_ptr<rp_image> src32(src->dup_ARGB32());
+
+	ImagePipeline pipeline(src.get());
+	pipeline.setScale(TEST_WIDTH * 3, TEST_HEIGHT * 3);
+	unique_ptr<rp_image> out(pipeline.toImage());
+	ASSERT_TRUE(out != nullptr);
+	ASSERT_EQ(TEST_WIDTH * 3, out->width());
+	ASSERT_EQ(TEST_HEIGHT * 3, out->height());
+
+	for (int y = 0; y < out->height(); y++) {
+		const uint32_t *const row = static_cast<const uint32_t*>(out->scanLine(y));
+		const uint32_t *const src_row = static_cast<const uint32_t*>(src32->scanLine(y / 3));
+		for (int x = 0; x < out->width(); x++) {
+			ASSERT_EQ(src_row[x / 3], row[x]) << "(" << x << "," << y << ")";
+		}
+	}
+}
+
+/**
+ * Box filter downscaling of an opaque image should average the pixels.
+ */
+TEST_F(ImagePipelineTest, boxTest)
+{
+	unique_ptr<rp_image> src(createARGB32(TEST_WIDTH, TEST_HEIGHT, true));
+	ImagePipeline pipeline(src.get());
+	pipeline.setScale(TEST_WIDTH / 2, TEST_HEIGHT / 2, ImagePipeline::SCALE_BOX);
+	unique_ptr<rp_image> out(pipeline.toImage());
+	ASSERT_TRUE(out != nullptr);
+	ASSERT_EQ(TEST_WIDTH / 2, out->width());
+	ASSERT_EQ(TEST_HEIGHT / 2, out->height());
+
+	for (int y = 0; y < out->height(); y++) {
+		const uint32_t *const row = static_cast<const uint32_t*>(out->scanLine(y));
+		const uint32_t *const src0 = static_cast<const uint32_t*>(src->scanLine(y * 2));
+		const uint32_t *const src1 = static_cast<const uint32_t*>(src->scanLine(y * 2 + 1));
+		for (int x = 0; x < out->width(); x++) {
+			const uint32_t px[4] = {src0[x*2], src0[x*2+1], src1[x*2], src1[x*2+1]};
+			uint32_t expected = 0xFF000000;
+			for (int shift = 0; shift < 24; shift += 8) {
+				unsigned int sum = 0;
+				for (int i = 0; i < 4; i++) {
+					sum += (px[i] >> shift) & 0xFF;
+				}
+				expected |= ((sum + 2) / 4) << shift;
+			}
+			ASSERT_EQ(expected, row[x]) << "(" << x << "," << y << ")";
+		}
+	}
+}
+
+/**
+ * All stages combined should match the separate operations.
+ */
+TEST_F(ImagePipelineTest, combinedTest)
+{
+	unique_ptr<rp_image> src(createCI8(TEST_WIDTH, TEST_HEIGHT));
+
+	// Separate operations.
+	unique_ptr<rp_image> tmp(src->dup_ARGB32());
+	tmp.reset(tmp->vflip());
+	ImagePipeline scaler(tmp.get());
+	scaler.setScale(TEST_WIDTH * 2, TEST_HEIGHT * 2);
+	tmp.reset(scaler.toImage());
+	ASSERT_TRUE(tmp != nullptr);
+	unique_ptr<rp_image> expected(tmp->squared());
+
+	// Single pass.
+	ImagePipeline pipeline(src.get());
+	pipeline.setVFlip(true)
+		.setScale(TEST_WIDTH * 2, TEST_HEIGHT * 2)
+		.setSquare(true);
+	unique_ptr<rp_image> out(pipeline.toImage());
+	ASSERT_NO_FATAL_FAILURE(compareImages(expected.get(), out.get()));
+
+	// Caller-provided buffer with a larger stride.
+	const int stride = (pipeline.width() + 3) * sizeof(uint32_t);
+	unique_ptr<uint32_t[]> buf(new uint32_t[(stride / sizeof(uint32_t)) * pipeline.height()]);
+	ASSERT_EQ(0, pipeline.process(buf.get(), stride));
+	for (int y = 0; y < pipeline.height(); y++) {
+		ASSERT_EQ(0, memcmp(&buf[y * (stride / sizeof(uint32_t))], out->scanLine(y),
+			pipeline.width() * sizeof(uint32_t))) << "Row " << y << " does not match.";
+	}
+}
+
+/**
+ * RpPngWriter should write pipeline output row by row.
+ */
+TEST_F(ImagePipelineTest, pngWriterTest)
+{
+	static const char filename[] = "ImagePipelineTest.png";
+
+	unique_ptr<rp_image> src(createCI8(TEST_WIDTH, TEST_HEIGHT));
+	ImagePipeline pipeline(src.get());
+	pipeline.setScale(TEST_WIDTH * 2, TEST_HEIGHT * 2).setSquare(true);
+	unique_ptr<rp_image> expected(pipeline.toImage());
+	ASSERT_TRUE(expected != nullptr);
+
+	{
+		unique_ptr<RpPngWriter> pngWriter(new RpPngWriter(filename,
+			pipeline.width(), pipeline.height(), rp_image::FORMAT_ARGB32));
+		ASSERT_TRUE(pngWriter->isOpen());
+		ASSERT_EQ(0, pngWriter->write_IHDR(nullptr));
+		ASSERT_EQ(0, pngWriter->write_IDAT(&pipeline));
+	}
+
+	unique_ptr<IRpFile> file(new RpFile(filename, RpFile::FM_OPEN_READ));
+	ASSERT_TRUE(file->isOpen());
+	unique_ptr<rp_image> out(RpPng::load(file.get()));
+	file.reset();
+	FileSystem::delete_file(filename);
+	ASSERT_NO_FATAL_FAILURE(compareImages(expected.get(), out.get()));
+}
+
+/**
+ * Benchmark converting, flipping, and scaling with separate operations.
+ */
+TEST_F(ImagePipelineTest, separate_ops_benchmark)
+{
+	unique_ptr<rp_image> src(createCI8(256, 128));
+	for (unsigned int i = BENCHMARK_ITERATIONS; i > 0; i--) {
+		unique_ptr<rp_image> tmp(src->dup_ARGB32());
+		tmp.reset(tmp->vflip());
+		tmp.reset(tmp->squared());
+	}
+}
+
+/**
+ * Benchmark converting, flipping, and scaling with ImagePipeline.
+ */
+TEST_F(ImagePipelineTest, pipeline_benchmark)
+{
+	unique_ptr<rp_image> src(createCI8(256, 128));
+	for (unsigned int i = BENCHMARK_ITERATIONS; i > 0; i--) {
+		ImagePipeline pipeline(src.get());
+		pipeline.setVFlip(true).setSquare(true);
+		unique_ptr<rp_image> tmp(pipeline.toImage());
+	}
+}
+
+} }
+
+/**
+ * Test suite main function.
+ * Called by gtest_init.c.
+ */
+extern "C" int gtest_main(int argc, char *argv[])
+{
+	fprintf(stderr, "LibRpBase test suite: ImagePipeline tests.\n\n");
+	fprintf(stderr, "Benchmark iterations: %u\n",
+		LibRpBase::Tests::ImagePipelineTest::BENCHMARK_ITERATIONS);
+	fflush(nullptr);
+
+	// coverity[fun_call_w_exception]: uncaught exceptions cause nonzero exit anyway, so don't warn.
+	::testing::InitGoogleTest(&argc, argv);
+	return RUN_ALL_TESTS();
+}
@@ -21,7 +21,7 @@
 #ifndef __ROMPROPERTIES_LIBRPBASE_MUTEX_HPP__
 #define __ROMPROPERTIES_LIBRPBASE_MUTEX_HPP__
 
-#include "common.h"
+#include "librpbase/common.h"
 
 // NOTE: The .cpp files are #included here in order to inline the functions.
 // Do NOT compile them separately!
@@ -0,0 +1,37 @@
+/***************************************************************************
+ * ROM Properties Page shell extension. (librpbase)                        *
+ * Thread.hpp: System-specific thread implementation.                      *
+ *                                                                         *
+ * Copyright (c) 2016-2018 by David Korth.                                 *
+ *                                                                         *
+ * This program is free software; you can redistribute it and/or modify it *
+ * under the terms of the GNU General Public License as published by the   *
+ * Free Software Foundation; either version 2 of the License, or (at your  *
+ * option) any later version.                                              *
+ *                                                                         *
+ * This program is distributed in the hope that it will be useful, but     *
+ * WITHOUT ANY WARRANTY; without even the implied warranty of              *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the           *
+ * GNU General Public License for more details.                            *
+ *                                                                         *
+ * You should have received a copy of the GNU General Public License       *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.   *
+ ***************************************************************************/
+
+#ifndef __ROMPROPERTIES_LIBRPBASE_THREAD_HPP__
+#define __ROMPROPERTIES_LIBRPBASE_THREAD_HPP__
+
+#include "librpbase/common.h"
+
+// NOTE: The .cpp files are #included here in order to inline the functions.
+// Do NOT compile them separately!
+
+// Each .cpp file defines the Thread class itself, with required fields.
+
+#ifdef _WIN32
+# include "ThreadWin32.cpp"
+#else /* !_WIN32 */
+# include "ThreadPosix.cpp"
+#endif
+
+#endif /* __ROMPROPERTIES_LIBRPBASE_THREAD_HPP__ */
@@ -0,0 +1,169 @@
+/***************************************************************************
+ * ROM Properties Page shell extension. (librpbase)                        *
+ * ThreadPosix.cpp: POSIX thread implementation.                           *
+ *                                                                         *
+ * Copyright (c) 2016-2018 by David Korth.                                 *
+ *                                                                         *
+ * This program is free software; you can redistribute it and/or modify it *
+ * under the terms of the GNU General Public License as published by the   *
+ * Free Software Foundation; either version 2 of the License, or (at your  *
+ * option) any later version.                                              *
+ *                                                                         *
+ * This program is distributed in the hope that it will be useful, but     *
+ * WITHOUT ANY WARRANTY; without even the implied warranty of              *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the           *
+ * GNU General Public License for more details.                            *
+ *                                                                         *
+ * You should have received a copy of the GNU General Public License       *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.   *
+ ***************************************************************************/
+
+#include "Thread.hpp"
+#include <pthread.h>
+#include <unistd.h>
+
+// C includes. (C++ namespace)
+#include <cassert>
+#include <cerrno>
+
+namespace LibRpBase {
+
+class Thread
+{
+	public:
+		/**
+		 * Thread function.
+		 * @param param User-specified parameter.
+		 */
+		typedef void (*ThreadFunc)(void *param);
+
+		/**
+		 * Create a thread object.
+		 * The thread isn't started until start() is called.
+		 */
+		inline explicit Thread();
+
+		/**
+		 * Delete the thread object.
+		 * WARNING: If the thread was started, it MUST be joined!
+		 */
+		inline ~Thread();
+
+	private:
+		RP_DISABLE_COPY(Thread)
+
+	public:
+		/**
+		 * Start the thread.
+		 * @param func Thread function.
+		 * @param param User-specified parameter.
+		 * @return 0 on success; negative POSIX error code on error.
+		 */
+		inline int start(ThreadFunc func, void *param);
+
+		/**
+		 * Wait for the thread to exit.
+		 * @return 0 on success; negative POSIX error code on error.
+		 */
+		inline int join(void);
+
+		/**
+		 * Get the number of online CPUs.
+		 * @return Number of online CPUs. (Always at least 1.)
+		 */
+		static inline unsigned int cpuCount(void);
+
+	private:
+		/**
+		 * pthread start routine.
+		 * @param self Thread object.
+		 * @return nullptr
+		 */
+		static void *threadProc(void *self);
+
+	private:
+		pthread_t m_thread;
+		ThreadFunc m_func;
+		void *m_param;
+		bool m_isStarted;
+};
+
+/**
+ * Create a thread object.
+ * The thread isn't started until start() is called.
+ */
+inline Thread::Thread()
+	: m_func(nullptr)
+	, m_param(nullptr)
+	, m_isStarted(false)
+{ }
+
+/**
+ * Delete the thread object.
+ * WARNING: If the thread was started, it MUST be joined!
+ */
+inline Thread::~Thread()
+{
+	assert(!m_isStarted);
+}
+
+/**
+ * Start the thread.
+ * @param func Thread function.
+ * @param param User-specified parameter.
+ * @return 0 on success; negative POSIX error code on error.
+ */
+inline int Thread::start(ThreadFunc func, void *param)
+{
+	assert(!m_isStarted);
+	if (m_isStarted)
+		return -EBUSY;
+
+	m_func = func;
+	m_param = param;
+	int ret = pthread_create(&m_thread, nullptr, threadProc, this);
+	if (ret != 0)
+		return -ret;
+	m_isStarted = true;
+	return 0;
+}
+
+/**
+ * Wait for the thread to exit.
+ * @return 0 on success; negative POSIX error code on error.
+ */
+inline int Thread::join(void)
+{
+	if (!m_isStarted)
+		return -ESRCH;
+
+	int ret = pthread_join(m_thread, nullptr);
+	if (ret != 0)
+		return -ret;
+	m_isStarted = false;
+	return 0;
+}
+
+/**
+ * Get the number of online CPUs.
+ * @return Number of online CPUs. (Always at least 1.)
+ */
+inline unsigned int Thread::cpuCount(void)
+{
+	long count = sysconf(_SC_NPROCESSORS_ONLN);
+	return (count > 0 ? static_cast<unsigned int>(count) : 1);
+}
+
+/**
+ * pthread start routine.
+ * @param self Thread object.
+ * @return nullptr
+ */
+inline void *Thread::threadProc(void *self)
+{
+	Thread *const thread = static_cast<Thread*>(self);
+	thread->m_func(thread->m_param);
+	return nullptr;
+}
+
+}
@@ -0,0 +1,180 @@
+/***************************************************************************
+ * ROM Properties Page shell extension. (librpbase)                        *
+ * ThreadWin32.cpp: Win32 thread implementation.                           *
+ *                                                                         *
+ * Copyright (c) 2016-2018 by David Korth.                                 *
+ *                                                                         *
+ * This program is free software; you can redistribute it and/or modify it *
+ * under the terms of the GNU General Public License as published by the   *
+ * Free Software Foundation; either version 2 of the License, or (at your  *
+ * option) any later version.                                              *
+ *                                                                         *
+ * This program is distributed in the hope that it will be useful, but     *
+ * WITHOUT ANY WARRANTY; without even the implied warranty of              *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the           *
+ * GNU General Public License for more details.                            *
+ *                                                                         *
+ * You should have received a copy of the GNU General Public License       *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.   *
+ ***************************************************************************/
+
+#include "Thread.hpp"
+#include "libwin32common/RpWin32_sdk.h"
+#include <process.h>
+
+// C includes. (C++ namespace)
+#include <cassert>
+#include <cerrno>
+
+namespace LibRpBase {
+
+class Thread
+{
+	public:
+		/**
+		 * Thread function.
+		 * @param param User-specified parameter.
+		 */
+		typedef void (*ThreadFunc)(void *param);
+
+		/**
+		 * Create a thread object.
+		 * The thread isn't started until start() is called.
+		 */
+		inline explicit Thread();
+
+		/**
+		 * Delete the thread object.
+		 * WARNING: If the thread was started, it MUST be joined!
+		 */
+		inline ~Thread();
+
+	private:
+		RP_DISABLE_COPY(Thread)
+
+	public:
+		/**
+		 * Start the thread.
+		 * @param func Thread function.
+		 * @param param User-specified parameter.
+		 * @return 0 on success; negative POSIX error code on error.
+		 */
+		inline int start(ThreadFunc func, void *param);
+
+		/**
+		 * Wait for the thread to exit.
+		 * NOTE: Do NOT call this while the loader lock is held,
+		 * e.g. from DllMain() or from a static destructor.
+		 * @return 0 on success; negative POSIX error code on error.
+		 */
+		inline int join(void);
+
+		/**
+		 * Get the number of online CPUs.
+		 * @return Number of online CPUs. (Always at least 1.)
+		 */
+		static inline unsigned int cpuCount(void);
+
+	private:
+		/**
+		 * _beginthreadex() start routine.
+		 * @param self Thread object.
+		 * @return 0
+		 */
+		static unsigned int __stdcall threadProc(void *self);
+
+	private:
+		HANDLE m_hThread;
+		ThreadFunc m_func;
+		void *m_param;
+};
+
+/**
+ * Create a thread object.
+ * The thread isn't started until start() is called.
+ */
+inline Thread::Thread()
+	: m_hThread(nullptr)
+	, m_func(nullptr)
+	, m_param(nullptr)
+{ }
+
+/**
+ * Delete the thread object.
+ * WARNING: If the thread was started, it MUST be joined!
+ */
+inline Thread::~Thread()
+{
+	assert(m_hThread == nullptr);
+}
+
+/**
+ * Start the thread.
+ * @param func Thread function.
+ * @param param User-specified parameter.
+ * @return 0 on success; negative POSIX error code on error.
+ */
+inline int Thread::start(ThreadFunc func, void *param)
+{
+	assert(m_hThread == nullptr);
+	if (m_hThread != nullptr)
+		return -EBUSY;
+
+	m_func = func;
+	m_param = param;
+
+	// NOTE: _beginthreadex() is used instead of CreateThread()
+	// so the CRT is initialized for the new thread.
+	m_hThread = reinterpret_cast<HANDLE>(_beginthreadex(
+		nullptr, 0, threadProc, this, 0, nullptr));
+	if (!m_hThread) {
+		// TODO: Convert errno from _beginthreadex()?
+		return -EAGAIN;
+	}
+	return 0;
+}
+
+/**
+ * Wait for the thread to exit.
+ * NOTE: Do NOT call this while the loader lock is held,
+ * e.g. from DllMain() or from a static destructor.
+ * @return 0 on success; negative POSIX error code on error.
+ */
+inline int Thread::join(void)
+{
+	if (!m_hThread)
+		return -ESRCH;
+
+	if (WaitForSingleObject(m_hThread, INFINITE) != WAIT_OBJECT_0) {
+		// TODO: Convert GetLastError()?
+		return -EIO;
+	}
+	CloseHandle(m_hThread);
+	m_hThread = nullptr;
+	return 0;
+}
+
+/**
+ * Get the number of online CPUs.
+ * @return Number of online CPUs. (Always at least 1.)
+ */
+inline unsigned int Thread::cpuCount(void)
+{
+	SYSTEM_INFO si;
+	GetSystemInfo(&si);
+	return (si.dwNumberOfProcessors > 0 ? si.dwNumberOfProcessors : 1);
+}
+
+/**
+ * _beginthreadex() start routine.
+ * @param self Thread object.
+ * @return 0
+ */
+inline unsigned int __stdcall Thread::threadProc(void *self)
+{
+	Thread *const thread = static_cast<Thread*>(self);
+	thread->m_func(thread->m_param);
+	return 0;
+}
+
+}
@@ -0,0 +1,439 @@
+/***************************************************************************
+ * ROM Properties Page shell extension. (rpcli)                            *
+ * batch.cpp: Batch processing using a pool of worker threads.             *
+ *                                                                         *
+ * Copyright (c) 2016-2018 by David Korth.                                 *
+ *                                                                         *
+ * This program is free software; you can redistribute it and/or modify it *
+ * under the terms of the GNU General Public License as published by the   *
+ * Free Software Foundation; either version 2 of the License, or (at your  *
+ * option) any later version.                                              *
+ *                                                                         *
+ * This program is distributed in the hope that it will be useful, but     *
+ * WITHOUT ANY WARRANTY; without even the implied warranty of              *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the           *
+ * GNU General Public License for more details.                            *
+ *                                                                         *
+ * You should have received a copy of the GNU General Public License along *
+ * with this program; if not, write to the Free Software Foundation, Inc., *
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.           *
+ ***************************************************************************/
+
+#include "stdafx.h"
+#include "config.rpcli.h"
+
+#include "batch.hpp"
+#include "recordwriter.hpp"
+
+// librpbase
+#include "librpbase/RomData.hpp"
+#include "librpbase/TextFuncs.hpp"
+#include "librpbase/file/FileSystem.hpp"
+#include "librpbase/file/IRpFile.hpp"
+#include "librpbase/threads/Atomics.h"
+#include "librpbase/threads/Mutex.hpp"
+#include "libi18n/i18n.h"
+using namespace LibRpBase;
+
+// libromdata
+#include "libromdata/RomDataFactory.hpp"
+using namespace LibRomData;
+
+#ifdef _WIN32
+# include "libwin32common/RpWin32_sdk.h"
+# include "librpbase/TextFuncs_wchar.hpp"
+# include <fcntl.h>
+# include <io.h>
+#else /* !_WIN32 */
+# include <dirent.h>
+# include <sys/stat.h>
+#endif /* _WIN32 */
+
+// C includes. (C++ namespace)
+#include <cassert>
+#include <cstdio>
+#include <cstring>
+
+// C++ includes.
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+using std::cerr;
+using std::cin;
+using std::deque;
+using std::endl;
+using std::map;
+using std::string;
+using std::vector;
+
+// Maximum number of files per worker thread that can be
+// queued or waiting for output before the walker blocks.
+#define BATCH_WINDOW_PER_THREAD 16
+
+/**
+ * Queued file.
+ */
+struct BatchItem {
+	size_t idx;		// File index.
+	string filename;	// Filename. (If empty, the worker exits.)
+};
+
+/**
+ * Batch processing state.
+ * Shared between the walker and all worker threads.
+ *
+ * The walker queues files as it finds them, and the workers
+ * take them from the queue. The window limits the number of
+ * files that have been queued but not yet output, so neither
+ * the queue nor the pending ordered results grow without bound.
+ *
+ * NOTE: std::condition_variable is used instead of Semaphore,
+ * since Win32 semaphores can't be released past their
+ * initial count.
+ */
+struct BatchState {
+	const BatchParams *params;	// Batch parameters.
+	size_t count;			// Number of files queued so far. (walker only)
+	volatile int errors;		// Number of files that couldn't be opened.
+
+	// File queue. (protected by queue_mutex)
+	std::mutex queue_mutex;
+	std::condition_variable queue_cond;	// Signaled when an item is queued.
+	std::condition_variable window_cond;	// Signaled when a file is output.
+	deque<BatchItem> queue;
+	unsigned int window;	// Number of files that can still be queued.
+
+	// Output state. (protected by out_mutex)
+	Mutex out_mutex;
+	map<size_t, string> results;	// Pending results. (ordered mode only)
+	size_t next_output;		// Index of the next result to output. (ordered mode only)
+
+	explicit BatchState(const BatchParams *params, unsigned int threads)
+		: params(params)
+		, count(0)
+		, errors(0)
+		, window(threads * BATCH_WINDOW_PER_THREAD)
+		, next_output(0)
+	{ }
+
+	private:
+		RP_DISABLE_COPY(BatchState)
+};
+
+/**
+ * Add an item to the queue.
+ * @param state Batch state.
+ * @param item Item.
+ */
+static void PushItem(BatchState *state, const BatchItem &item)
+{
+	{
+		std::lock_guard<std::mutex> lock(state->queue_mutex);
+		state->queue.push_back(item);
+	}
+	state->queue_cond.notify_one();
+}
+
+/**
+ * Take an item from the queue.
+ * Blocks until an item is available.
+ * @param state Batch state.
+ * @param item [out] Item.
+ */
+static void PopItem(BatchState *state, BatchItem &item)
+{
+	std::unique_lock<std::mutex> lock(state->queue_mutex);
+	while (state->queue.empty()) {
+		state->queue_cond.wait(lock);
+	}
+	std::swap(item, state->queue.front());
+	state->queue.pop_front();
+}
+
+/**
+ * Release a window slot after a file's result was output.
+ * @param state Batch state.
+ */
+static void ReleaseWindow(BatchState *state)
+{
+	{
+		std::lock_guard<std::mutex> lock(state->queue_mutex);
+		state->window++;
+	}
+	state->window_cond.notify_one();
+}
+
+/**
+ * Queue a file for processing.
+ * Blocks if too many files are waiting to be processed or output.
+ * @param state Batch state.
+ * @param filename Filename.
+ */
+static void QueueFile(BatchState *state, const string &filename)
+{
+	if (filename.empty()) {
+		// Empty filenames are used to stop the workers.
+		return;
+	}
+
+	{
+		std::unique_lock<std::mutex> lock(state->queue_mutex);
+		while (state->window == 0) {
+			state->window_cond.wait(lock);
+		}
+		state->window--;
+	}
+
+	BatchItem item;
+	item.idx = state->count++;
+	item.filename = filename;
+	PushItem(state, item);
+}
+
+/**
+ * Is a path a directory?
+ * @param path Path.
+ * @return True if it's a directory; false if not.
+ */
+static bool IsDirectory(const string &path)
+{
+#ifdef _WIN32
+	const DWORD attrs = GetFileAttributes(U82T_s(path));
+	return (attrs != INVALID_FILE_ATTRIBUTES && (attrs & FILE_ATTRIBUTE_DIRECTORY));
+#else /* !_WIN32 */
+	struct stat sb;
+	return (stat(path.c_str(), &sb) == 0 && S_ISDIR(sb.st_mode));
+#endif /* _WIN32 */
+}
+
+/**
+ * Recursively queue all files in a directory.
+ * Entries are sorted by name for consistent output.
+ * Symbolic links to directories are not followed.
+ * @param state	[in] Batch state.
+ * @param path	[in] Directory path.
+ */
+static void AddDirectory(BatchState *state, const string &path)
+{
+	string prefix = path;
+	if (!prefix.empty() && prefix[prefix.size()-1] != DIR_SEP_CHR) {
+		prefix += DIR_SEP_CHR;
+	}
+
+	vector<string> names;
+	vector<string> subdirs;
+#ifdef _WIN32
+	WIN32_FIND_DATA findData;
+	HANDLE hFind = FindFirstFile(U82T_s(prefix + '*'), &findData);
+	if (hFind == INVALID_HANDLE_VALUE) {
+		return;
+	}
+	do {
+		const string name = T2U8(findData.cFileName);
+		if (name == "." || name == "..")
+			continue;
+		if (findData.dwFileAttributes & FILE_ATTRIBUTE_REPARSE_POINT)
+			continue;
+		if (findData.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) {
+			subdirs.push_back(name);
+		} else {
+			names.push_back(name);
+		}
+	} while (FindNextFile(hFind, &findData));
+	FindClose(hFind);
+#else /* !_WIN32 */
+	DIR *const dir = opendir(path.c_str());
+	if (!dir) {
+		return;
+	}
+	struct dirent *dirent;
+	while ((dirent = readdir(dir)) != nullptr) {
+		const char *const name = dirent->d_name;
+		if (!strcmp(name, ".") || !strcmp(name, ".."))
+			continue;
+
+		// NOTE: lstat() is used so symlinked directories
+		// aren't followed, which prevents infinite loops.
+		struct stat sb;
+		if (lstat((prefix + name).c_str(), &sb) != 0)
+			continue;
+		if (S_ISDIR(sb.st_mode)) {
+			subdirs.push_back(name);
+		} else if (S_ISREG(sb.st_mode) || S_ISLNK(sb.st_mode)) {
+			names.push_back(name);
+		}
+	}
+	closedir(dir);
+#endif /* _WIN32 */
+
+	std::sort(names.begin(), names.end());
+	std::sort(subdirs.begin(), subdirs.end());
+	for (auto iter = names.cbegin(); iter != names.cend(); ++iter) {
+		QueueFile(state, prefix + *iter);
+	}
+	for (auto iter = subdirs.cbegin(); iter != subdirs.cend(); ++iter) {
+		AddDirectory(state, prefix + *iter);
+	}
+}
+
+/**
+ * Process a single file.
+ * @param writer Record writer.
+ * @param filename Filename.
+ * @param pErrors Error counter.
+ */
+static void ProcessFile(RecordWriter &writer, const string &filename, volatile int *pErrors)
+{
+	IRpFile *const file = RomDataFactory::openFile(filename);
+	if (file->isOpen()) {
+		RomData *const romData = RomDataFactory::create(file);
+		if (romData && romData->isValid()) {
+			writer.writeRomData(filename.c_str(), romData);
+		} else {
+			writer.writeError(filename.c_str(), "rom is not supported");
+		}
+
+		if (romData) {
+			romData->unref();
+		}
+	} else {
+		writer.writeError(filename.c_str(), "couldn't open file", file->lastError());
+		ATOMIC_INC_FETCH(pErrors);
+	}
+	delete file;
+}
+
+/**
+ * Output a result.
+ * @param state Batch state.
+ * @param idx File index.
+ * @param result Result.
+ */
+static void OutputResult(BatchState *state, size_t idx, const string &result)
+{
+	MutexLocker locker(state->out_mutex);
+	if (!state->params->ordered) {
+		// Output the result immediately.
+		fwrite(result.data(), 1, result.size(), stdout);
+		ReleaseWindow(state);
+		return;
+	}
+
+	// Save the result, then output all results
+	// that are ready, in input order.
+	state->results[idx] = result;
+	auto iter = state->results.begin();
+	while (iter != state->results.end() && iter->first == state->next_output) {
+		fwrite(iter->second.data(), 1, iter->second.size(), stdout);
+		iter = state->results.erase(iter);
+		state->next_output++;
+		ReleaseWindow(state);
+	}
+}
+
+/**
+ * Worker thread.
+ * @param state Batch state.
+ */
+static void BatchWorker(BatchState *state)
+{
+	// Each worker has its own writer, which is
+	// reused for all files processed by the worker.
+	RecordWriter writer(state->params->msgpack
+		? RecordWriter::FMT_MSGPACK
+		: RecordWriter::FMT_JSON);
+	writer.setFieldFilter(state->params->fields);
+
+	for (;;) {
+		BatchItem item;
+		PopItem(state, item);
+		if (item.filename.empty()) {
+			// No more files.
+			break;
+		}
+
+		writer.clear();
+		ProcessFile(writer, item.filename, &state->errors);
+		OutputResult(state, item.idx, writer.buffer());
+	}
+}
+
+/**
+ * Process multiple files using a pool of worker threads.
+ *
+ * Each file is written to stdout as a single record: either one
+ * line of JSON (NDJSON) or one MessagePack map.
+ * Errors are reported in each file's record, and don't stop
+ * processing of the remaining files.
+ *
+ * @param inputs Input files. Directories are processed recursively,
+ *               and "-" reads filenames from stdin, one per line.
+ * @param params Batch parameters.
+ * @return 0 if all files were processed; non-zero if any file couldn't be opened.
+ */
+int DoBatch(const vector<const char*> &inputs, const BatchParams &params)
+{
+	unsigned int threads = params.threads;
+	if (threads == 0) {
+		threads = std::thread::hardware_concurrency();
+		if (threads == 0) {
+			threads = 1;
+		}
+	}
+	cerr << "-- " << rp_sprintf(C_("rpcli", "Processing files using %u threads"), threads) << endl;
+
+#ifdef _WIN32
+	if (params.msgpack) {
+		// MessagePack is binary. Don't translate newlines.
+		_setmode(_fileno(stdout), _O_BINARY);
+	}
+#endif /* _WIN32 */
+
+	// Start the workers first so they can process
+	// files while the directories are being walked.
+	BatchState state(&params, threads);
+	vector<std::thread> workers;
+	workers.reserve(threads);
+	for (unsigned int i = 0; i < threads; i++) {
+		workers.push_back(std::thread(BatchWorker, &state));
+	}
+
+	// The current thread walks the inputs.
+	for (auto iter = inputs.cbegin(); iter != inputs.cend(); ++iter) {
+		if (!strcmp(*iter, "-")) {
+			// Read filenames from stdin.
+			string line;
+			while (std::getline(cin, line)) {
+				if (!line.empty() && line[line.size()-1] == '\r') {
+					line.resize(line.size()-1);
+				}
+				if (!line.empty()) {
+					QueueFile(&state, line);
+				}
+			}
+		} else if (IsDirectory(*iter)) {
+			AddDirectory(&state, *iter);
+		} else {
+			QueueFile(&state, *iter);
+		}
+	}
+
+	// Tell the workers to exit once the queue is empty.
+	BatchItem last;
+	last.idx = 0;
+	for (unsigned int i = 0; i < threads; i++) {
+		PushItem(&state, last);
+	}
+	for (auto iter = workers.begin(); iter != workers.end(); ++iter) {
+		iter->join();
+	}
+	fflush(stdout);
+
+	return (state.errors != 0 ? 1 : 0);
+}
@@ -0,0 +1,60 @@
+/***************************************************************************
+ * ROM Properties Page shell extension. (rpcli)                            *
+ * batch.hpp: Batch processing using a pool of worker threads.             *
+ *                                                                         *
+ * Copyright (c) 2016-2018 by David Korth.                                 *
+ *                                                                         *
+ * This program is free software; you can redistribute it and/or modify it *
+ * under the terms of the GNU General Public License as published by the   *
+ * Free Software Foundation; either version 2 of the License, or (at your  *
+ * option) any later version.                                              *
+ *                                                                         *
+ * This program is distributed in the hope that it will be useful, but     *
+ * WITHOUT ANY WARRANTY; without even the implied warranty of              *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the           *
+ * GNU General Public License for more details.                            *
+ *                                                                         *
+ * You should have received a copy of the GNU General Public License along *
+ * with this program; if not, write to the Free Software Foundation, Inc., *
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.           *
+ ***************************************************************************/
+
+#ifndef __ROMPROPERTIES_RPCLI_BATCH_HPP__
+#define __ROMPROPERTIES_RPCLI_BATCH_HPP__
+
+#include <string>
+#include <vector>
+
+/**
+ * Batch processing parameters.
+ */
+struct BatchParams {
+	unsigned int threads;		// Number of worker threads. (0 == number of CPUs)
+	bool ordered;			// If true, output files in input order.
+					// If false, output each file as soon as it's processed.
+	bool msgpack;			// If true, use MessagePack instead of JSON.
+	std::vector<std::string> fields;	// Fields to output. (If empty, all fields are written.)
+
+	BatchParams()
+		: threads(0)
+		, ordered(true)
+		, msgpack(false)
+	{ }
+};
+
+/**
+ * Process multiple files using a pool of worker threads.
+ *
+ * Each file is written to stdout as a single record: either one
+ * line of JSON (NDJSON) or one MessagePack map.
+ * Errors are reported in each file's record, and don't stop
+ * processing of the remaining files.
+ *
+ * @param inputs Input files. Directories are processed recursively,
+ *               and "-" reads filenames from stdin, one per line.
+ * @param params Batch parameters.
+ * @return 0 if all files were processed; non-zero if any file couldn't be opened.
+ */
+int DoBatch(const std::vector<const char*> &inputs, const BatchParams &params);
+
+#endif /* __ROMPROPERTIES_RPCLI_BATCH_HPP__ */
@@ -46,6 +46,7 @@ using std::vector;
 // librpbase
 #include "librpbase/RomData.hpp"
 #include "librpbase/RomFields.hpp"
+#include "librpbase/RomMetaData.hpp"
 #include "librpbase/TextFuncs.hpp"
 #include "librpbase/img/rp_image.hpp"
 #include "librpbase/img/IconAnimData.hpp"
@@ -492,53 +493,48 @@ public:
 	}
 };
 
-class JSONString {
-	const char* str;
-public:
-	explicit JSONString(const char* str) :str(str) {}
-	friend ostream& operator<<(ostream& os, const JSONString& js) {
-		//assert(js.str); // not all strings can't be null, apparently
-		if (!js.str) {
-			// NULL string.
-			// Print "0" to indicate this.
-			return os << '0';
-		}
-
-		// Certain characters need to be escaped.
-		const char *str = js.str;
-		os << '"';
-		for (; *str != 0; str++) {
-			switch (*str) {
-				case '\\':
-					os << "\\\\";
-					break;
-				case '"':
-					os << "\\";
-					break;
-				case '\b':
-					os << "\\b";
-					break;
-				case '\f':
-					os << "\\f";
-					break;
-				case '\t':
-					os << "\\t";
-					break;
-				case '\n':
-					os << "\\n";
-					break;
-				case '\r':
-					os << "\\r";
-					break;
-				default:
-					os << *str;
-					break;
-			}
-		}
+ostream& operator<<(ostream& os, const JSONString& js) {
+	//assert(js.str); // not all strings can't be null, apparently
+	if (!js.str) {
+		// NULL string.
+		// Print "0" to indicate this.
+		return os << '0';
+	}
 
-		return os << '"';
+	// Certain characters need to be escaped.
+	const char *str = js.str;
+	os << '"';
+	for (; *str != 0; str++) {
+		switch (*str) {
+			case '\\':
+				os << "\\\\";
+				break;
+			case '"':
+				os << "\\\"";
+				break;
+			case '\b':
+				os << "\\b";
+				break;
+			case '\f':
+				os << "\\f";
+				break;
+			case '\t':
+				os << "\\t";
+				break;
+			case '\n':
+				os << "\\n";
+				break;
+			case '\r':
+				os << "\\r";
+				break;
+			default:
+				os << *str;
+				break;
+		}
 	}
-};
+
+	return os << '"';
+}
 
 class JSONFieldsOutput {
 	const RomFields& fields;
@@ -725,6 +721,50 @@ public:
 	}
 };
 
+class JSONMetaDataOutput {
+	const RomMetaData& metaData;
+public:
+	explicit JSONMetaDataOutput(const RomMetaData& metaData) :metaData(metaData) {}
+	friend std::ostream& operator<<(std::ostream& os, const JSONMetaDataOutput& mo) {
+		os << '[';
+		bool printed_first = false;
+		for (int i = 0; i < mo.metaData.count(); i++) {
+			auto prop = mo.metaData.prop(i);
+			assert(prop != nullptr);
+			const char *const name = (prop ? RomMetaData::getPropertyName(prop->name) : nullptr);
+			if (!name)
+				continue;
+
+			if (printed_first)
+				os << ',';
+			os << "{\"name\":" << JSONString(name) << ",\"value\":";
+			switch (prop->type) {
+			case PropertyType::Integer:
+				os << prop->data.ivalue;
+				break;
+			case PropertyType::UnsignedInteger:
+				os << prop->data.uvalue;
+				break;
+			case PropertyType::String:
+				os << JSONString(prop->data.str ? prop->data.str->c_str() : "");
+				break;
+			case PropertyType::Timestamp:
+				os << static_cast<int64_t>(prop->data.timestamp);
+				break;
+			default:
+				assert(!"Unsupported RomMetaData PropertyType.");
+				os << "null";
+				break;
+			}
+			os << '}';
+
+			printed_first = true;
+		}
+		os << ']';
+		return os;
+	}
+};
+
 
 
 ROMOutput::ROMOutput(const RomData *romdata) : romdata(romdata) { }
@@ -805,6 +845,11 @@ std::ostream& operator<<(std::ostream& os, const JSONROMOutput& fo) {
 	}
 	os << ",\"fields\":" << JSONFieldsOutput(*(romdata->fields()));
 
+	const RomMetaData *const metaData = romdata->metaData();
+	if (metaData && !metaData->empty()) {
+		os << ",\n\"metadata\":" << JSONMetaDataOutput(*metaData);
+	}
+
 	const int supported = romdata->supportedImageTypes();
 
 	// TODO: Tabs.
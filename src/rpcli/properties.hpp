@@ -27,6 +27,13 @@ namespace LibRpBase {
 	class RomData;
 }
 
+class JSONString {
+	const char* str;
+public:
+	explicit JSONString(const char* str) :str(str) {}
+	friend std::ostream& operator<<(std::ostream& os, const JSONString& js);
+};
+
 class ROMOutput {
 	const LibRpBase::RomData *romdata;
 public:
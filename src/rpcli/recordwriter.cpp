@@ -0,0 +1,692 @@
+/***************************************************************************
+ * ROM Properties Page shell extension. (rpcli)                            *
+ * recordwriter.cpp: Streaming NDJSON / MessagePack record writer.         *
+ *                                                                         *
+ * Copyright (c) 2016-2018 by David Korth.                                 *
+ *                                                                         *
+ * This program is free software; you can redistribute it and/or modify it *
+ * under the terms of the GNU General Public License as published by the   *
+ * Free Software Foundation; either version 2 of the License, or (at your  *
+ * option) any later version.                                              *
+ *                                                                         *
+ * This program is distributed in the hope that it will be useful, but     *
+ * WITHOUT ANY WARRANTY; without even the implied warranty of              *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the           *
+ * GNU General Public License for more details.                            *
+ *                                                                         *
+ * You should have received a copy of the GNU General Public License along *
+ * with this program; if not, write to the Free Software Foundation, Inc., *
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.           *
+ ***************************************************************************/
+
+#include "stdafx.h"
+#include "recordwriter.hpp"
+
+// librpbase
+#include "librpbase/RomData.hpp"
+#include "librpbase/RomFields.hpp"
+#include "librpbase/RomMetaData.hpp"
+using LibRpBase::RomData;
+using LibRpBase::RomFields;
+using LibRpBase::RomMetaData;
+namespace PropertyType = LibRpBase::PropertyType;
+
+// C includes. (C++ namespace)
+#include <cassert>
+#include <cstring>
+
+// C++ includes.
+#include <string>
+#include <vector>
+using std::string;
+using std::vector;
+
+RecordWriter::RecordWriter(Format format)
+	: m_format(format)
+	, m_afterKey(false)
+{
+	// Reserve enough space for a typical record.
+	m_buf.reserve(4096);
+	m_first.reserve(8);
+}
+
+/**
+ * Set the field filter.
+ * If set, only fields and metadata properties with
+ * the specified names are written.
+ * @param names Field names. (If empty, all fields are written.)
+ */
+void RecordWriter::setFieldFilter(const vector<string> &names)
+{
+	m_filter.clear();
+	m_filter.insert(names.cbegin(), names.cend());
+}
+
+/** Low-level encoding functions. **/
+
+/**
+ * JSON: Write a separator if this isn't the first element
+ * in the current container.
+ */
+inline void RecordWriter::separator(void)
+{
+	if (m_afterKey) {
+		// Value for a key. No separator.
+		m_afterKey = false;
+		return;
+	}
+	if (!m_first.empty()) {
+		if (m_first.back()) {
+			m_first.back() = 0;
+		} else {
+			m_buf += ',';
+		}
+	}
+}
+
+/**
+ * MessagePack: Write a container or string header.
+ * @param fixBase Base value for the "fix" format.
+ * @param fixMax Maximum count for the "fix" format.
+ * @param code16 Type code for 16-bit counts.
+ * @param code32 Type code for 32-bit counts.
+ * @param count Element count.
+ */
+void RecordWriter::msgpackHeader(uint8_t fixBase, unsigned int fixMax,
+	uint8_t code16, uint8_t code32, unsigned int count)
+{
+	if (count <= fixMax) {
+		m_buf += static_cast<char>(fixBase | count);
+	} else if (count <= 0xFFFF) {
+		const char hdr[3] = {
+			static_cast<char>(code16),
+			static_cast<char>(count >> 8),
+			static_cast<char>(count)
+		};
+		m_buf.append(hdr, sizeof(hdr));
+	} else {
+		const char hdr[5] = {
+			static_cast<char>(code32),
+			static_cast<char>(count >> 24),
+			static_cast<char>(count >> 16),
+			static_cast<char>(count >> 8),
+			static_cast<char>(count)
+		};
+		m_buf.append(hdr, sizeof(hdr));
+	}
+}
+
+void RecordWriter::beginRecord(void)
+{
+	m_first.clear();
+	m_afterKey = false;
+}
+
+void RecordWriter::endRecord(void)
+{
+	assert(m_first.empty());
+	if (m_format == FMT_JSON) {
+		m_buf += '\n';
+	}
+}
+
+/**
+ * Begin a map.
+ * @param count Number of keys. (required for MessagePack)
+ */
+void RecordWriter::beginMap(unsigned int count)
+{
+	if (m_format == FMT_JSON) {
+		separator();
+		m_buf += '{';
+		m_first.push_back(1);
+	} else {
+		msgpackHeader(0x80, 15, 0xDE, 0xDF, count);
+	}
+}
+
+void RecordWriter::endMap(void)
+{
+	if (m_format == FMT_JSON) {
+		m_buf += '}';
+		m_first.pop_back();
+	}
+}
+
+/**
+ * Begin an array.
+ * @param count Number of elements. (required for MessagePack)
+ */
+void RecordWriter::beginArray(unsigned int count)
+{
+	if (m_format == FMT_JSON) {
+		separator();
+		m_buf += '[';
+		m_first.push_back(1);
+	} else {
+		msgpackHeader(0x90, 15, 0xDC, 0xDD, count);
+	}
+}
+
+void RecordWriter::endArray(void)
+{
+	if (m_format == FMT_JSON) {
+		m_buf += ']';
+		m_first.pop_back();
+	}
+}
+
+/**
+ * Write a map key.
+ * @param str Key.
+ */
+void RecordWriter::key(const char *str)
+{
+	value(str);
+	if (m_format == FMT_JSON) {
+		m_buf += ':';
+		m_afterKey = true;
+	}
+}
+
+/**
+ * JSON: Write an escaped string.
+ * @param str String.
+ * @param len Length of str.
+ */
+void RecordWriter::writeJsonString(const char *str, size_t len)
+{
+	static const char hex[] = "0123456789abcdef";
+
+	m_buf += '"';
+	const char *run = str;
+	const char *const end = str + len;
+	for (; str != end; str++) {
+		const uint8_t chr = static_cast<uint8_t>(*str);
+		if (chr >= 0x20 && chr != '"' && chr != '\\')
+			continue;
+
+		// Flush the run of unescaped characters.
+		m_buf.append(run, str - run);
+		run = str + 1;
+
+		switch (chr) {
+			case '"':	m_buf += "\\\""; break;
+			case '\\':	m_buf += "\\\\"; break;
+			case '\b':	m_buf += "\\b"; break;
+			case '\f':	m_buf += "\\f"; break;
+			case '\n':	m_buf += "\\n"; break;
+			case '\r':	m_buf += "\\r"; break;
+			case '\t':	m_buf += "\\t"; break;
+			default: {
+				const char esc[6] = {'\\', 'u', '0', '0', hex[chr >> 4], hex[chr & 0x0F]};
+				m_buf.append(esc, sizeof(esc));
+				break;
+			}
+		}
+	}
+	m_buf.append(run, end - run);
+	m_buf += '"';
+}
+
+/**
+ * Write a string value.
+ * @param str String. (If nullptr, null is written.)
+ */
+void RecordWriter::value(const char *str)
+{
+	if (!str) {
+		valueNull();
+		return;
+	}
+	value(str, strlen(str));
+}
+
+/**
+ * Write a string value.
+ * @param str String.
+ * @param len Length of str.
+ */
+void RecordWriter::value(const char *str, size_t len)
+{
+	if (m_format == FMT_JSON) {
+		separator();
+		writeJsonString(str, len);
+		return;
+	}
+
+	// MessagePack: str8 is used for 32-255 bytes.
+	const unsigned int ulen = static_cast<unsigned int>(len);
+	if (ulen >= 32 && ulen <= 0xFF) {
+		const char hdr[2] = {static_cast<char>(0xD9), static_cast<char>(ulen)};
+		m_buf.append(hdr, sizeof(hdr));
+	} else {
+		msgpackHeader(0xA0, 31, 0xDA, 0xDB, ulen);
+	}
+	m_buf.append(str, len);
+}
+
+/**
+ * Write an integer value.
+ * @param val Integer.
+ */
+void RecordWriter::value(int64_t val)
+{
+	if (m_format == FMT_JSON) {
+		separator();
+
+		// Convert to decimal, right to left.
+		char tmp[24];
+		char *p = &tmp[sizeof(tmp)];
+		uint64_t uval = (val < 0 ? (0 - static_cast<uint64_t>(val)) : static_cast<uint64_t>(val));
+		do {
+			*--p = '0' + static_cast<char>(uval % 10);
+			uval /= 10;
+		} while (uval != 0);
+		if (val < 0) {
+			*--p = '-';
+		}
+		m_buf.append(p, &tmp[sizeof(tmp)] - p);
+		return;
+	}
+
+	// MessagePack: Use the smallest encoding.
+	char buf[9];
+	unsigned int bytes;
+	if (val >= 0) {
+		if (val < 0x80) {
+			m_buf += static_cast<char>(val);
+			return;
+		} else if (val <= 0xFF) {
+			buf[0] = static_cast<char>(0xCC);
+			bytes = 1;
+		} else if (val <= 0xFFFF) {
+			buf[0] = static_cast<char>(0xCD);
+			bytes = 2;
+		} else if (val <= 0xFFFFFFFFLL) {
+			buf[0] = static_cast<char>(0xCE);
+			bytes = 4;
+		} else {
+			buf[0] = static_cast<char>(0xCF);
+			bytes = 8;
+		}
+	} else {
+		if (val >= -32) {
+			m_buf += static_cast<char>(val);
+			return;
+		} else if (val >= -0x80) {
+			buf[0] = static_cast<char>(0xD0);
+			bytes = 1;
+		} else if (val >= -0x8000) {
+			buf[0] = static_cast<char>(0xD1);
+			bytes = 2;
+		} else if (val >= -0x80000000LL) {
+			buf[0] = static_cast<char>(0xD2);
+			bytes = 4;
+		} else {
+			buf[0] = static_cast<char>(0xD3);
+			bytes = 8;
+		}
+	}
+
+	// Big-endian.
+	const uint64_t uval = static_cast<uint64_t>(val);
+	for (unsigned int i = 0; i < bytes; i++) {
+		buf[1+i] = static_cast<char>(uval >> ((bytes - 1 - i) * 8));
+	}
+	m_buf.append(buf, bytes + 1);
+}
+
+/**
+ * Write a boolean value.
+ * @param val Boolean.
+ */
+void RecordWriter::value(bool val)
+{
+	if (m_format == FMT_JSON) {
+		separator();
+		m_buf += (val ? "true" : "false");
+	} else {
+		m_buf += static_cast<char>(val ? 0xC3 : 0xC2);
+	}
+}
+
+/**
+ * Write a null value.
+ */
+void RecordWriter::valueNull(void)
+{
+	if (m_format == FMT_JSON) {
+		separator();
+		m_buf += "null";
+	} else {
+		m_buf += static_cast<char>(0xC0);
+	}
+}
+
+/** Records **/
+
+/**
+ * Write the fields array.
+ * @param fields RomFields.
+ */
+void RecordWriter::writeFields(const RomFields &fields)
+{
+	// Count the fields that will be written.
+	// (MessagePack requires the count in advance.)
+	const int count = fields.count();
+	unsigned int fieldCount = 0;
+	for (int i = 0; i < count; i++) {
+		const RomFields::Field *const romField = fields.field(i);
+		if (romField && romField->isValid &&
+		    romField->type > RomFields::RFT_INVALID &&
+		    romField->type <= RomFields::RFT_DIMENSIONS &&
+		    isFieldIncluded(romField->name))
+		{
+			fieldCount++;
+		}
+	}
+
+	beginArray(fieldCount);
+	for (int i = 0; i < count; i++) {
+		const RomFields::Field *const romField = fields.field(i);
+		if (!romField || !romField->isValid ||
+		    romField->type <= RomFields::RFT_INVALID ||
+		    romField->type > RomFields::RFT_DIMENSIONS ||
+		    !isFieldIncluded(romField->name))
+		{
+			continue;
+		}
+
+		beginMap(3);
+		switch (romField->type) {
+			default:
+				assert(!"Unknown RomFieldType");
+				break;
+
+			case RomFields::RFT_STRING:
+				key("type"); value("STRING");
+				key("desc"); beginMap(2);
+					key("name"); value(romField->name);
+					key("format"); value(static_cast<int64_t>(romField->desc.flags));
+				endMap();
+				key("data");
+				if (romField->data.str) {
+					value(*romField->data.str);
+				} else {
+					valueNull();
+				}
+				break;
+
+			case RomFields::RFT_BITFIELD: {
+				const auto &bitfieldDesc = romField->desc.bitfield;
+				key("type"); value("BITFIELD");
+				key("desc"); beginMap(3);
+					key("name"); value(romField->name);
+					key("elementsPerRow"); value(static_cast<int64_t>(bitfieldDesc.elemsPerRow));
+					key("names");
+					if (bitfieldDesc.names) {
+						unsigned int bits = static_cast<unsigned int>(bitfieldDesc.names->size());
+						if (bits > 32)
+							bits = 32;
+						unsigned int nameCount = 0;
+						for (unsigned int bit = 0; bit < bits; bit++) {
+							if (!bitfieldDesc.names->at(bit).empty())
+								nameCount++;
+						}
+						beginArray(nameCount);
+						for (unsigned int bit = 0; bit < bits; bit++) {
+							const string &name = bitfieldDesc.names->at(bit);
+							if (!name.empty())
+								value(name);
+						}
+						endArray();
+					} else {
+						valueNull();
+					}
+				endMap();
+				key("data"); value(static_cast<int64_t>(romField->data.bitfield));
+				break;
+			}
+
+			case RomFields::RFT_LISTDATA: {
+				const auto &listDataDesc = romField->desc.list_data;
+				const bool hasCheckboxes = !!(listDataDesc.flags & RomFields::RFT_LISTDATA_CHECKBOXES);
+				key("type"); value("LISTDATA");
+				key("desc"); beginMap(2);
+					key("name"); value(romField->name);
+					key("names");
+					if (listDataDesc.names) {
+						const unsigned int colCount = static_cast<unsigned int>(listDataDesc.names->size());
+						beginArray(colCount + (hasCheckboxes ? 1 : 0));
+						if (hasCheckboxes) {
+							value("checked");
+						}
+						for (unsigned int j = 0; j < colCount; j++) {
+							value(listDataDesc.names->at(j));
+						}
+						endArray();
+					} else {
+						beginArray(0);
+						endArray();
+					}
+				endMap();
+
+				key("data");
+				const auto list_data = romField->data.list_data;
+				if (list_data) {
+					uint32_t checkboxes = romField->data.list_checkboxes;
+					beginArray(static_cast<unsigned int>(list_data->size()));
+					for (auto it = list_data->cbegin(); it != list_data->cend(); ++it) {
+						beginArray(static_cast<unsigned int>(it->size()) + (hasCheckboxes ? 1 : 0));
+						if (hasCheckboxes) {
+							value((checkboxes & 1) != 0);
+							checkboxes >>= 1;
+						}
+						for (auto jt = it->cbegin(); jt != it->cend(); ++jt) {
+							value(*jt);
+						}
+						endArray();
+					}
+					endArray();
+				} else {
+					valueNull();
+				}
+				break;
+			}
+
+			case RomFields::RFT_DATETIME:
+				key("type"); value("DATETIME");
+				key("desc"); beginMap(2);
+					key("name"); value(romField->name);
+					key("flags"); value(static_cast<int64_t>(romField->desc.flags));
+				endMap();
+				key("data"); value(static_cast<int64_t>(romField->data.date_time));
+				break;
+
+			case RomFields::RFT_AGE_RATINGS: {
+				key("type"); value("AGE_RATINGS");
+				key("desc"); beginMap(1);
+					key("name"); value(romField->name);
+				endMap();
+
+				key("data");
+				const RomFields::age_ratings_t *const age_ratings = romField->data.age_ratings;
+				if (!age_ratings) {
+					valueNull();
+					break;
+				}
+				const unsigned int age_ratings_max = static_cast<unsigned int>(age_ratings->size());
+				unsigned int ratingCount = 0;
+				for (unsigned int j = 0; j < age_ratings_max; j++) {
+					if (age_ratings->at(j) & RomFields::AGEBF_ACTIVE)
+						ratingCount++;
+				}
+				beginArray(ratingCount);
+				for (unsigned int j = 0; j < age_ratings_max; j++) {
+					const uint16_t rating = age_ratings->at(j);
+					if (!(rating & RomFields::AGEBF_ACTIVE))
+						continue;
+
+					beginMap(2);
+					key("name");
+					const char *const abbrev = RomFields::ageRatingAbbrev(j);
+					if (abbrev) {
+						value(abbrev);
+					} else {
+						// Invalid age rating.
+						// Use the numeric index.
+						value(static_cast<int64_t>(j));
+					}
+					key("rating"); value(RomFields::ageRatingDecode(j, rating));
+					endMap();
+				}
+				endArray();
+				break;
+			}
+
+			case RomFields::RFT_DIMENSIONS: {
+				key("type"); value("DIMENSIONS");
+				key("desc"); beginMap(1);
+					key("name"); value(romField->name);
+				endMap();
+
+				key("data");
+				const int *const dimensions = romField->data.dimensions;
+				const unsigned int dimCount = (dimensions[1] > 0 ? (dimensions[2] > 0 ? 3 : 2) : 1);
+				beginMap(dimCount);
+				key("w"); value(static_cast<int64_t>(dimensions[0]));
+				if (dimCount >= 2) {
+					key("h"); value(static_cast<int64_t>(dimensions[1]));
+				}
+				if (dimCount >= 3) {
+					key("d"); value(static_cast<int64_t>(dimensions[2]));
+				}
+				endMap();
+				break;
+			}
+		}
+		endMap();
+	}
+	endArray();
+}
+
+/**
+ * Write the metadata array.
+ * @param metaData RomMetaData.
+ */
+void RecordWriter::writeMetaData(const RomMetaData &metaData)
+{
+	// Count the properties that will be written.
+	// (MessagePack requires the count in advance.)
+	const int count = metaData.count();
+	unsigned int propCount = 0;
+	for (int i = 0; i < count; i++) {
+		const RomMetaData::MetaData *const prop = metaData.prop(i);
+		const char *const name = (prop ? RomMetaData::getPropertyName(prop->name) : nullptr);
+		if (name && isFieldIncluded(name)) {
+			propCount++;
+		}
+	}
+
+	beginArray(propCount);
+	for (int i = 0; i < count; i++) {
+		const RomMetaData::MetaData *const prop = metaData.prop(i);
+		const char *const name = (prop ? RomMetaData::getPropertyName(prop->name) : nullptr);
+		if (!name || !isFieldIncluded(name))
+			continue;
+
+		beginMap(2);
+		key("name"); value(name);
+		key("value");
+		switch (prop->type) {
+			case PropertyType::Integer:
+				value(static_cast<int64_t>(prop->data.ivalue));
+				break;
+			case PropertyType::UnsignedInteger:
+				value(static_cast<int64_t>(prop->data.uvalue));
+				break;
+			case PropertyType::String:
+				if (prop->data.str) {
+					value(*prop->data.str);
+				} else {
+					valueNull();
+				}
+				break;
+			case PropertyType::Timestamp:
+				value(static_cast<int64_t>(prop->data.timestamp));
+				break;
+			default:
+				assert(!"Unsupported RomMetaData PropertyType.");
+				valueNull();
+				break;
+		}
+		endMap();
+	}
+	endArray();
+}
+
+/**
+ * Write a record for a RomData object.
+ * @param filename Filename.
+ * @param romData RomData object.
+ */
+void RecordWriter::writeRomData(const char *filename, const RomData *romData)
+{
+	assert(romData != nullptr);
+	const RomFields *const fields = romData->fields();
+	if (!fields) {
+		writeError(filename, "rom is not supported");
+		return;
+	}
+
+	writeRecord(filename,
+		romData->systemName(RomData::SYSNAME_TYPE_LONG | RomData::SYSNAME_REGION_GENERIC),
+		romData->fileType_string(), *fields, romData->metaData());
+}
+
+/**
+ * Write a record with RomData information.
+ * @param filename Filename.
+ * @param system System name.
+ * @param filetype File type.
+ * @param fields RomFields.
+ * @param metaData RomMetaData. (optional)
+ */
+void RecordWriter::writeRecord(const char *filename, const char *system,
+	const char *filetype, const RomFields &fields,
+	const RomMetaData *metaData)
+{
+	const bool hasMetaData = (metaData && !metaData->empty());
+
+	beginRecord();
+	beginMap(hasMetaData ? 5 : 4);
+	key("file"); value(filename);
+	key("system"); value(system ? system : "unknown");
+	key("filetype"); value(filetype ? filetype : "unknown");
+	key("fields"); writeFields(fields);
+	if (hasMetaData) {
+		key("metadata"); writeMetaData(*metaData);
+	}
+	endMap();
+	endRecord();
+}
+
+/**
+ * Write an error record.
+ * @param filename Filename.
+ * @param error Error message.
+ * @param code Error code. (0 to omit)
+ */
+void RecordWriter::writeError(const char *filename, const char *error, int code)
+{
+	beginRecord();
+	beginMap(code != 0 ? 3 : 2);
+	key("file"); value(filename);
+	key("error"); value(error);
+	if (code != 0) {
+		key("code"); value(static_cast<int64_t>(code));
+	}
+	endMap();
+	endRecord();
+}
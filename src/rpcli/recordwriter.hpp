@@ -0,0 +1,174 @@
+/***************************************************************************
+ * ROM Properties Page shell extension. (rpcli)                            *
+ * recordwriter.hpp: Streaming NDJSON / MessagePack record writer.         *
+ *                                                                         *
+ * Copyright (c) 2016-2018 by David Korth.                                 *
+ *                                                                         *
+ * This program is free software; you can redistribute it and/or modify it *
+ * under the terms of the GNU General Public License as published by the   *
+ * Free Software Foundation; either version 2 of the License, or (at your  *
+ * option) any later version.                                              *
+ *                                                                         *
+ * This program is distributed in the hope that it will be useful, but     *
+ * WITHOUT ANY WARRANTY; without even the implied warranty of              *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the           *
+ * GNU General Public License for more details.                            *
+ *                                                                         *
+ * You should have received a copy of the GNU General Public License along *
+ * with this program; if not, write to the Free Software Foundation, Inc., *
+ * 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.           *
+ ***************************************************************************/
+
+#ifndef __ROMPROPERTIES_RPCLI_RECORDWRITER_HPP__
+#define __ROMPROPERTIES_RPCLI_RECORDWRITER_HPP__
+
+// C includes.
+#include <stdint.h>
+
+// C++ includes.
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+namespace LibRpBase {
+	class RomData;
+	class RomFields;
+	class RomMetaData;
+}
+
+/**
+ * Streaming record writer.
+ *
+ * Each record is a single object describing one file. Records are
+ * appended to an internal buffer, which can be reused for multiple
+ * records in order to reduce memory allocations.
+ *
+ * Formats:
+ * - FMT_JSON: One JSON object per line. (NDJSON)
+ * - FMT_MSGPACK: One MessagePack map per record, with no separators.
+ *
+ * Record schema:
+ * - file: Filename.
+ * - system, filetype, fields: RomData information.
+ * - metadata: RomData metadata properties, if any.
+ * - error, code: Error information, if the file isn't supported.
+ */
+class RecordWriter
+{
+	public:
+		enum Format {
+			FMT_JSON,
+			FMT_MSGPACK,
+		};
+
+		explicit RecordWriter(Format format = FMT_JSON);
+
+	private:
+		RecordWriter(const RecordWriter &);
+		RecordWriter &operator=(const RecordWriter &);
+
+	public:
+		/**
+		 * Get the output format.
+		 * @return Output format.
+		 */
+		inline Format format(void) const { return m_format; }
+
+		/**
+		 * Set the field filter.
+		 * If set, only fields and metadata properties with
+		 * the specified names are written.
+		 * @param names Field names. (If empty, all fields are written.)
+		 */
+		void setFieldFilter(const std::vector<std::string> &names);
+
+		/**
+		 * Get the output buffer.
+		 * @return Output buffer.
+		 */
+		inline const std::string &buffer(void) const { return m_buf; }
+
+		/**
+		 * Clear the output buffer.
+		 * The buffer's memory is retained for the next record.
+		 */
+		inline void clear(void) { m_buf.clear(); }
+
+		/**
+		 * Write a record for a RomData object.
+		 * @param filename Filename.
+		 * @param romData RomData object.
+		 */
+		void writeRomData(const char *filename, const LibRpBase::RomData *romData);
+
+		/**
+		 * Write a record with RomData information.
+		 * @param filename Filename.
+		 * @param system System name.
+		 * @param filetype File type.
+		 * @param fields RomFields.
+		 * @param metaData RomMetaData. (optional)
+		 */
+		void writeRecord(const char *filename, const char *system,
+			const char *filetype, const LibRpBase::RomFields &fields,
+			const LibRpBase::RomMetaData *metaData = nullptr);
+
+		/**
+		 * Write an error record.
+		 * @param filename Filename.
+		 * @param error Error message.
+		 * @param code Error code. (0 to omit)
+		 */
+		void writeError(const char *filename, const char *error, int code = 0);
+
+	private:
+		// Low-level encoding functions.
+		void beginRecord(void);
+		void endRecord(void);
+		void beginMap(unsigned int count);
+		void endMap(void);
+		void beginArray(unsigned int count);
+		void endArray(void);
+		void key(const char *str);
+		void value(const char *str);
+		void value(const char *str, size_t len);
+		inline void value(const std::string &str) { value(str.data(), str.size()); }
+		void value(int64_t val);
+		void value(bool val);
+		void valueNull(void);
+
+		// JSON: Separator handling.
+		void separator(void);
+		void writeJsonString(const char *str, size_t len);
+
+		// MessagePack: Headers and integers.
+		void msgpackHeader(uint8_t fixBase, unsigned int fixMax,
+			uint8_t code16, uint8_t code32, unsigned int count);
+
+		/**
+		 * Is a field included by the field filter?
+		 * @param name Field name.
+		 * @return True if included; false if not.
+		 */
+		inline bool isFieldIncluded(const std::string &name) const
+		{
+			return (m_filter.empty() || m_filter.find(name) != m_filter.end());
+		}
+
+		void writeFields(const LibRpBase::RomFields &fields);
+		void writeMetaData(const LibRpBase::RomMetaData &metaData);
+
+	private:
+		Format m_format;
+		std::string m_buf;
+
+		// Field filter.
+		std::unordered_set<std::string> m_filter;
+
+		// JSON: Is this the first element in each nested container?
+		std::vector<uint8_t> m_first;
+		// JSON: Was a key just written?
+		bool m_afterKey;
+};
+
+#endif /* __ROMPROPERTIES_RPCLI_RECORDWRITER_HPP__ */
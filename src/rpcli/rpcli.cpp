@@ -31,7 +31,7 @@ using namespace LibRpBase;
 
 // libromdata
 #include "librpbase/TextFuncs.hpp"
-#include "librpbase/file/RpFile.hpp"
+#include "librpbase/file/IRpFile.hpp"
 #include "librpbase/img/rp_image.hpp"
 #include "librpbase/img/RpPng.hpp"
 #include "librpbase/img/IconAnimData.hpp"
@@ -45,6 +45,7 @@ using namespace LibRomData;
 #endif /* _WIN32 */
 
 #include "properties.hpp"
+#include "batch.hpp"
 #ifdef ENABLE_DECRYPTION
 # include "verifykeys.hpp"
 #endif /* ENABLE_DECRYPTION */
@@ -55,6 +56,7 @@ using namespace LibRomData;
 // C includes. (C++ namespace)
 #include <cassert>
 #include <cerrno>
+#include <cstring>
 
 // C++ includes.
 #include <fstream>
@@ -157,7 +159,7 @@ static void ExtractImages(const RomData *romData, vector<ExtractParam>& extract)
 */
 static void DoFile(const char *filename, bool json, vector<ExtractParam>& extract){
 	cerr << "== " << rp_sprintf(C_("rpcli", "Reading file '%s'..."), filename) << endl;
-	IRpFile *file = new RpFile(filename, RpFile::FM_OPEN_READ_GZ);
+	IRpFile *file = RomDataFactory::openFile(filename);
 	if (file->isOpen()) {
 		RomData *romData = RomDataFactory::create(file);
 		if (romData && romData->isValid()) {
@@ -254,20 +256,32 @@ int RP_C_API main(int argc, char *argv[])
 	if(argc < 2){
 #ifdef ENABLE_DECRYPTION
 		cerr << C_("rpcli", "Usage: rpcli [-k] [-c] [-j] [[-x[b]N outfile]... [-a apngoutfile] filename]...") << endl;
+		cerr << C_("rpcli", "       rpcli -b [-tN] [-u] [-m] [-Ffield,...] filename|directory|-...") << endl;
 		cerr << "  -k:   " << C_("rpcli", "Verify encryption keys in keys.conf.") << endl;
 #else /* !ENABLE_DECRYPTION */
 		cerr << C_("rpcli", "Usage: rpcli [-j] [[-x[b]N outfile]... [-a apngoutfile] filename]...") << endl;
+		cerr << C_("rpcli", "       rpcli -b [-tN] [-u] [-m] [-Ffield,...] filename|directory|-...") << endl;
 #endif /* ENABLE_DECRYPTION */
 		cerr << "  -c:   " << C_("rpcli", "Print system region information.") << endl;
 		cerr << "  -j:   " << C_("rpcli", "Use JSON output format.") << endl;
 		cerr << "  -xN:  " << C_("rpcli", "Extract image N to outfile in PNG format.") << endl;
 		cerr << "  -a:   " << C_("rpcli", "Extract the animated icon to outfile in APNG format.") << endl;
+		cerr << "  -b:   " << C_("rpcli", "Batch mode: Output one line of JSON per file. (NDJSON)") << endl;
+		cerr << "        " << C_("rpcli", "Directories are processed recursively; '-' reads filenames from stdin.") << endl;
+		cerr << "  -tN:  " << C_("rpcli", "Batch mode: Use N worker threads. (default is the number of CPUs)") << endl;
+		cerr << "  -u:   " << C_("rpcli", "Batch mode: Output files as they're processed instead of in input order.") << endl;
+		cerr << "  -m:   " << C_("rpcli", "Batch mode: Use MessagePack output instead of JSON.") << endl;
+		cerr << "  -F:   " << C_("rpcli", "Batch mode: Only output the specified fields and metadata. (comma-separated)") << endl;
 		cerr << endl;
 		cerr << C_("rpcli", "Examples:") << endl;
 		cerr << "* rpcli s3.gen" << endl;
 		cerr << "\t " << C_("rpcli", "displays info about s3.gen") << endl;
 		cerr << "* rpcli -x0 icon.png pokeb2.nds" << endl;
 		cerr << "\t " << C_("rpcli", "extracts icon from pokeb2.nds") << endl;
+		cerr << "* find roms -name '*.nds' | rpcli -b -t8 -" << endl;
+		cerr << "\t " << C_("rpcli", "outputs info about all .nds files in roms using 8 threads") << endl;
+		cerr << "* rpcli -b -m -F\"Title,Game ID\" roms > roms.msgpack" << endl;
+		cerr << "\t " << C_("rpcli", "outputs the title and game ID of all files in roms in MessagePack format") << endl;
 	}
 	
 	assert(RomData::IMG_INT_MIN == 0);
@@ -275,12 +289,19 @@ int RP_C_API main(int argc, char *argv[])
 	bool json = false;
 	vector<ExtractParam> extract;
 
-	for (int i = 1; i < argc; i++) { // figure out the json mode in advance
+	// Batch mode parameters
+	bool batch = false;
+	BatchParams batch_params;
+	vector<const char*> batch_inputs;
+
+	for (int i = 1; i < argc; i++) { // figure out the json and batch modes in advance
 		if (argv[i][0] == '-' && argv[i][1] == 'j') {
 			json = true;
+		} else if (argv[i][0] == '-' && argv[i][1] == 'b') {
+			batch = true;
 		}
 	}
-	if (json) cout << "[\n";
+	if (json && !batch) cout << "[\n";
 	bool first = true;
 	int ret = 0;
 	for(int i=1;i<argc;i++){
@@ -322,12 +343,51 @@ int RP_C_API main(int argc, char *argv[])
 				break;
 			}
 			case 'j': // do nothing
+			case 'b':
+				break;
+			case 't': {
+				long num = atol(argv[i] + 2);
+				if (num < 0) {
+					cerr << rp_sprintf(C_("rpcli", "Warning: invalid thread count %ld"), num) << endl;
+				} else {
+					batch_params.threads = static_cast<unsigned int>(num);
+				}
+				break;
+			}
+			case 'u':
+				batch_params.ordered = false;
+				break;
+			case 'm':
+				batch_params.msgpack = true;
+				break;
+			case 'F': {
+				// Comma-separated list of field names.
+				const char *p = argv[i] + 2;
+				for (const char *comma = strchr(p, ','); comma != nullptr; comma = strchr(p, ',')) {
+					if (comma != p) {
+						batch_params.fields.push_back(string(p, comma - p));
+					}
+					p = comma + 1;
+				}
+				if (*p != '\0') {
+					batch_params.fields.push_back(p);
+				}
+				break;
+			}
+			case '\0':
+				// "-" in batch mode: Read filenames from stdin.
+				if (batch) {
+					batch_inputs.push_back(argv[i]);
+				}
 				break;
 			default:
 				cerr << rp_sprintf(C_("rpcli", "Warning: skipping unknown switch '%c'"), argv[i][1]) << endl;
 				break;
 			}
 		}
+		else if (batch) {
+			batch_inputs.push_back(argv[i]);
+		}
 		else{
 			if (first) first = false;
 			else if (json) cout << "," << endl;
@@ -335,6 +395,11 @@ int RP_C_API main(int argc, char *argv[])
 			extract.clear();
 		}
 	}
-	if (json) cout << "]\n";
+	if (batch) {
+		int batch_ret = DoBatch(batch_inputs, batch_params);
+		if (ret == 0) ret = batch_ret;
+	} else if (json) {
+		cout << "]\n";
+	}
 	return ret;
 }
@@ -0,0 +1,322 @@
+/***************************************************************************
+ * ROM Properties Page shell extension. (rpcli/tests)                      *
+ * RecordWriterTest.cpp: RecordWriter test.                                *
+ *                                                                         *
+ * Copyright (c) 2016-2018 by David Korth.                                 *
+ *                                                                         *
+ * This program is free software; you can redistribute it and/or modify it *
+ * under the terms of the GNU General Public License as published by the   *
+ * Free Software Foundation; either version 2 of the License, or (at your  *
+ * option) any later version.                                              *
+ *                                                                         *
+ * This program is distributed in the hope that it will be useful, but     *
+ * WITHOUT ANY WARRANTY; without even the implied warranty of              *
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the           *
+ * GNU General Public License for more details.                            *
+ *                                                                         *
+ * You should have received a copy of the GNU General Public License       *
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.   *
+ ***************************************************************************/
+
+// Google Test
+#include "gtest/gtest.h"
+
+// RecordWriter
+#include "recordwriter.hpp"
+
+// librpbase
+#include "librpbase/RomFields.hpp"
+using LibRpBase::RomFields;
+
+// C includes. (C++ namespace)
+#include <cstdio>
+
+// C++ includes.
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+using std::string;
+using std::unique_ptr;
+using std::vector;
+
+class RecordWriterTest : public ::testing::Test
+{
+	protected:
+		// Number of records for benchmarks.
+		static const unsigned int BENCHMARK_RECORDS = 10000;
+		// Number of iterations for benchmarks.
+		static const unsigned int BENCHMARK_ITERATIONS = 20;
+
+	public:
+		/**
+		 * Create a synthetic RomFields object.
+		 * @param idx Record index.
+		 * @return RomFields object.
+		 */
+		static RomFields *createFields(unsigned int idx);
+
+		/**
+		 * Run a benchmark.
+		 * @param format Output format.
+		 */
+		static void benchmark(RecordWriter::Format format);
+};
+
+/**
+ * Create a synthetic RomFields object.
+ * @param idx Record index.
+ * @return RomFields object.
+ */
+RomFields *RecordWriterTest::createFields(unsigned int idx)
+{
+	RomFields *const fields = new RomFields();
+
+	char buf[64];
+	snprintf(buf, sizeof(buf), "Synthetic Title #%u", idx);
+	fields->addField_string("Title", buf);
+	snprintf(buf, sizeof(buf), "RP%04X", idx & 0xFFFF);
+	fields->addField_string("Game ID", buf, RomFields::STRF_MONOSPACE);
+	fields->addField_string("Publisher", "Nintendo \"EAD\"\t\\ Kyoto");
+	fields->addField_string_numeric("Revision", idx % 4);
+
+	static const char *const bit_names[] = {"Bit 0", "Bit 1", "Bit 2", "Bit 3"};
+	fields->addField_bitfield("Flags",
+		RomFields::strArrayToVector(bit_names, 4), 2, idx & 0x0F);
+
+	auto list_data = new vector<vector<string> >(4);
+	for (unsigned int i = 0; i < 4; i++) {
+		auto &row = list_data->at(i);
+		snprintf(buf, sizeof(buf), "%u", i);
+		row.push_back(buf);
+		snprintf(buf, sizeof(buf), "0x%08X", idx * 0x1000 + i);
+		row.push_back(buf);
+	}
+	static const char *const list_names[] = {"#", "Address"};
+	fields->addField_listData("Partitions",
+		RomFields::strArrayToVector(list_names, 2), list_data,
+		0, RomFields::RFT_LISTDATA_CHECKBOXES, 0x05);
+
+	fields->addField_dateTime("Build Date", 1500000000 + idx,
+		RomFields::RFT_DATETIME_HAS_DATE | RomFields::RFT_DATETIME_HAS_TIME);
+
+	RomFields::age_ratings_t age_ratings;
+	age_ratings.fill(0);
+	age_ratings[RomFields::AGE_JAPAN] = RomFields::AGEBF_ACTIVE | 12;
+	age_ratings[RomFields::AGE_USA] = RomFields::AGEBF_ACTIVE | 13;
+	fields->addField_ageRatings("Age Rating", age_ratings);
+
+	fields->addField_dimensions("Dimensions", 256, 224);
+	return fields;
+}
+
+/**
+ * Run a benchmark.
+ * @param format Output format.
+ */
+void RecordWriterTest::benchmark(RecordWriter::Format format)
+{
+	vector<unique_ptr<RomFields> > corpus;
+	corpus.reserve(BENCHMARK_RECORDS);
+	for (unsigned int i = 0; i < BENCHMARK_RECORDS; i++) {
+		corpus.push_back(unique_ptr<RomFields>(createFields(i)));
+	}
+
+	RecordWriter writer(format);
+	uint64_t total = 0;
+	const auto start = std::chrono::steady_clock::now();
+	for (unsigned int i = BENCHMARK_ITERATIONS; i > 0; i--) {
+		for (auto iter = corpus.cbegin(); iter != corpus.cend(); ++iter) {
+			writer.clear();
+			writer.writeRecord("/path/to/file.bin", "Synthetic System", "ROM Image", **iter);
+			total += writer.buffer().size();
+		}
+	}
+	const auto end = std::chrono::steady_clock::now();
+
+	const double secs = std::chrono::duration<double>(end - start).count();
+	const unsigned int records = BENCHMARK_RECORDS * BENCHMARK_ITERATIONS;
+	printf("%u records, %.1f MB in %.3f s: %.0f records/s, %.1f MB/s\n",
+		records, total / 1048576.0, secs,
+		records / secs, (total / 1048576.0) / secs);
+}
+
+/**
+ * JSON strings are escaped, and records end with a newline.
+ */
+TEST_F(RecordWriterTest, jsonEscape_test)
+{
+	RecordWriter writer;
+	writer.writeError("a\"b\\c\n\x01/\xC3\xA9", "couldn't open file", 2);
+	EXPECT_EQ("{\"file\":\"a\\\"b\\\\c\\n\\u0001/\xC3\xA9\",\"error\":\"couldn't open file\",\"code\":2}\n",
+		writer.buffer());
+
+	// Records are appended until the buffer is cleared.
+	writer.writeError("b", "rom is not supported");
+	EXPECT_EQ("{\"file\":\"a\\\"b\\\\c\\n\\u0001/\xC3\xA9\",\"error\":\"couldn't open file\",\"code\":2}\n"
+		"{\"file\":\"b\",\"error\":\"rom is not supported\"}\n",
+		writer.buffer());
+	writer.clear();
+	EXPECT_TRUE(writer.buffer().empty());
+}
+
+/**
+ * JSON records with RomFields.
+ */
+TEST_F(RecordWriterTest, jsonFields_test)
+{
+	RomFields fields;
+	fields.addField_string("Title", "Test");
+	fields.addField_dimensions("Dimensions", 640, -5);
+	auto list_data = new vector<vector<string> >(2);
+	list_data->at(0).push_back("a");
+	list_data->at(1).push_back("b");
+	fields.addField_listData("List", nullptr, list_data,
+		0, RomFields::RFT_LISTDATA_CHECKBOXES, 0x02);
+
+	RecordWriter writer;
+	writer.writeRecord("f", "sys", "type", fields);
+	EXPECT_EQ("{\"file\":\"f\",\"system\":\"sys\",\"filetype\":\"type\",\"fields\":["
+		"{\"type\":\"STRING\",\"desc\":{\"name\":\"Title\",\"format\":0},\"data\":\"Test\"},"
+		"{\"type\":\"DIMENSIONS\",\"desc\":{\"name\":\"Dimensions\"},\"data\":{\"w\":640}},"
+		"{\"type\":\"LISTDATA\",\"desc\":{\"name\":\"List\",\"names\":[]},\"data\":[[false,\"a\"],[true,\"b\"]]}"
+		"]}\n",
+		writer.buffer());
+}
+
+/**
+ * The field filter only writes the selected fields.
+ */
+TEST_F(RecordWriterTest, fieldFilter_test)
+{
+	unique_ptr<RomFields> fields(createFields(0));
+
+	RecordWriter writer;
+	vector<string> names;
+	names.push_back("Game ID");
+	names.push_back("Build Date");
+	names.push_back("Nonexistent");
+	writer.setFieldFilter(names);
+	writer.writeRecord("f", "sys", "type", *fields);
+	EXPECT_EQ("{\"file\":\"f\",\"system\":\"sys\",\"filetype\":\"type\",\"fields\":["
+		"{\"type\":\"STRING\",\"desc\":{\"name\":\"Game ID\",\"format\":1},\"data\":\"RP0000\"},"
+		"{\"type\":\"DATETIME\",\"desc\":{\"name\":\"Build Date\",\"flags\":3},\"data\":1500000000}"
+		"]}\n",
+		writer.buffer());
+
+	// Clearing the filter writes all fields again.
+	writer.clear();
+	writer.setFieldFilter(vector<string>());
+	writer.writeRecord("f", "sys", "type", *fields);
+	EXPECT_NE(string::npos, writer.buffer().find("\"Publisher\""));
+}
+
+/**
+ * MessagePack encoding of maps, strings, and integers.
+ */
+TEST_F(RecordWriterTest, msgpack_test)
+{
+	static const struct {
+		int code;
+		const char *bytes;
+		size_t len;
+	} codes[] = {
+		{1,		"\x01", 1},
+		{127,		"\x7F", 1},
+		{200,		"\xCC\xC8", 2},
+		{70000,		"\xCE\x00\x01\x11\x70", 5},
+		{-1,		"\xFF", 1},
+		{-32,		"\xE0", 1},
+		{-100,		"\xD0\x9C", 2},
+		{-1000,		"\xD1\xFC\x18", 3},
+	};
+
+	RecordWriter writer(RecordWriter::FMT_MSGPACK);
+	for (size_t i = 0; i < sizeof(codes)/sizeof(codes[0]); i++) {
+		writer.clear();
+		writer.writeError("f", "e", codes[i].code);
+		const string expected = string("\x83\xA4" "file" "\xA1" "f" "\xA5" "error" "\xA1" "e" "\xA4" "code")
+			+ string(codes[i].bytes, codes[i].len);
+		EXPECT_EQ(expected, writer.buffer()) << "code == " << codes[i].code;
+	}
+
+	// Without an error code.
+	writer.clear();
+	writer.writeError("f", "e");
+	EXPECT_EQ(string("\x82\xA4" "file" "\xA1" "f" "\xA5" "error" "\xA1" "e"), writer.buffer());
+
+	// Long strings use str8 and str16.
+	writer.clear();
+	const string str40(40, 'x');
+	const string str300(300, 'y');
+	writer.writeError(str40.c_str(), str300.c_str());
+	EXPECT_EQ(string("\x82\xA4" "file" "\xD9\x28") + str40
+		+ string("\xA5" "error" "\xDA\x01\x2C") + str300, writer.buffer());
+}
+
+/**
+ * MessagePack records with RomFields.
+ */
+TEST_F(RecordWriterTest, msgpackFields_test)
+{
+	RomFields fields;
+	auto bit_names = new vector<string>(3);
+	bit_names->at(0) = "A";
+	bit_names->at(2) = "C";
+	fields.addField_bitfield("B", bit_names, 0, 3);
+	fields.addField_dimensions("D", 1, 2, 3);
+
+	RecordWriter writer(RecordWriter::FMT_MSGPACK);
+	writer.writeRecord("f", "s", "t", fields);
+	const string expected = string(
+		"\x84"
+		"\xA4" "file" "\xA1" "f"
+		"\xA6" "system" "\xA1" "s"
+		"\xA8" "filetype" "\xA1" "t"
+		"\xA6" "fields" "\x92"
+			"\x83"
+			"\xA4" "type" "\xA8" "BITFIELD"
+			"\xA4" "desc" "\x83"
+				"\xA4" "name" "\xA1" "B"
+				"\xAE" "elementsPerRow" "\x00"
+				"\xA5" "names" "\x92" "\xA1" "A" "\xA1" "C"
+			"\xA4" "data" "\x03"
+			"\x83"
+			"\xA4" "type" "\xAA" "DIMENSIONS"
+			"\xA4" "desc" "\x81"
+				"\xA4" "name" "\xA1" "D"
+			"\xA4" "data" "\x83"
+				"\xA1" "w" "\x01"
+				"\xA1" "h" "\x02"
+				"\xA1" "d" "\x03", 142);
+	EXPECT_EQ(expected, writer.buffer());
+}
+
+/**
+ * Benchmark the JSON writer.
+ */
+TEST_F(RecordWriterTest, json_benchmark)
+{
+	benchmark(RecordWriter::FMT_JSON);
+}
+
+/**
+ * Benchmark the MessagePack writer.
+ */
+TEST_F(RecordWriterTest, msgpack_benchmark)
+{
+	benchmark(RecordWriter::FMT_MSGPACK);
+}
+
+/**
+ * Test suite main function.
+ */
+extern "C" int gtest_main(int argc, char *argv[])
+{
+	fprintf(stderr, "rpcli test suite: RecordWriter tests.\n\n");
+	fflush(nullptr);
+
+	// coverity[fun_call_w_exception]: uncaught exceptions cause nonzero exit anyway, so don't warn.
+	::testing::InitGoogleTest(&argc, argv);
+	return RUN_ALL_TESTS();
+}
@@ -25,6 +25,7 @@
 
 #include "librpbase/img/rp_image.hpp"
 #include "librpbase/img/RpGdiplusBackend.hpp"
+#include "librpbase/img/ImagePipeline.hpp"
 using namespace LibRpBase;
 
 // C++ includes.
@@ -54,36 +55,26 @@ HBITMAP CreateThumbnail::rpImageToImgClass(const rp_image *img) const
 	// We're returning HBITMAP here, which works for IThumbnailProvider.
 	// Our IExtractIcon implementation converts it to HICON later.
 
-	// We should be using the RpGdiplusBackend.
-	const RpGdiplusBackend *backend =
-		dynamic_cast<const RpGdiplusBackend*>(img->backend());
-	assert(backend != nullptr);
-	if (!backend) {
-		// Incorrect backend set.
-		return nullptr;
-	}
+	// Convert the image using ImagePipeline.
+	// This handles CI8 conversion and squaring in a
+	// single pass, writing directly into the HBITMAP.
+	ImagePipeline pipeline(img);
+	return pipelineToImgClass(&pipeline);
+}
 
+/**
+ * Convert an ImagePipeline's output to ImgClass.
+ * The image is written directly into the HBITMAP.
+ * @param pipeline ImagePipeline.
+ * @return ImgClass, or null ImgClass on error.
+ */
+HBITMAP CreateThumbnail::pipelineToImgClass(ImagePipeline *pipeline) const
+{
 	// Windows doesn't like non-square icons.
-	// Add extra transparent columns/rows before
+	// Add extra transparent columns/rows while
 	// converting to HBITMAP.
-	unique_ptr<rp_image> tmp_img;
-	if (!img->isSquare()) {
-		// Image is non-square.
-		tmp_img.reset(img->squared());
-		assert(tmp_img.get() != nullptr);
-		if (tmp_img) {
-			const RpGdiplusBackend *const tmp_backend =
-				dynamic_cast<const RpGdiplusBackend*>(tmp_img->backend());
-			assert(tmp_backend != nullptr);
-			if (tmp_backend) {
-				backend = tmp_backend;
-			}
-		}
-	}
-
-	// Convert to HBITMAP.
-	// TODO: Const-ness stuff.
-	return const_cast<RpGdiplusBackend*>(backend)->toHBITMAP_alpha();
+	pipeline->setSquare(true);
+	return RpImageWin32::toHBITMAP_alpha(pipeline);
 }
 
 /**
@@ -256,3 +247,17 @@ HBITMAP CreateThumbnailNoAlpha::rescaleImgClass(const HBITMAP &imgClass, const I
 	const SIZE win_sz = {sz.width, sz.height};
 	return RpImageWin32::toHBITMAP(img.get(), bgColor, win_sz, true);
 }
+
+/**
+ * Convert an ImagePipeline's output to ImgClass.
+ * The image is converted to rp_image, since it has
+ * to be blended with COLOR_WINDOW.
+ * @param pipeline ImagePipeline.
+ * @return ImgClass, or null ImgClass on error.
+ */
+HBITMAP CreateThumbnailNoAlpha::pipelineToImgClass(ImagePipeline *pipeline) const
+{
+	// NOTE: CreateThumbnail's version writes an alpha-transparent
+	// HBITMAP, so use the default rp_image conversion instead.
+	return TCreateThumbnail<HBITMAP>::pipelineToImgClass(pipeline);
+}
@@ -74,6 +74,14 @@ class CreateThumbnail : public LibRomData::TCreateThumbnail<HBITMAP>
 		 */
 		HBITMAP rescaleImgClass(const HBITMAP &imgClass, const ImgSize &sz) const override;
 
+		/**
+		 * Convert an ImagePipeline's output to ImgClass.
+		 * The image is written directly into the HBITMAP.
+		 * @param pipeline ImagePipeline.
+		 * @return ImgClass, or null ImgClass on error.
+		 */
+		HBITMAP pipelineToImgClass(LibRpBase::ImagePipeline *pipeline) const override;
+
 		/**
 		 * Get the size of the specified ImgClass.
 		 * @param imgClass	[in] ImgClass object.
@@ -120,6 +128,15 @@ class CreateThumbnailNoAlpha : public CreateThumbnail
 		 * @return Rescaled ImgClass.
 		 */
 		HBITMAP rescaleImgClass(const HBITMAP &imgClass, const ImgSize &sz) const final;
+
+		/**
+		 * Convert an ImagePipeline's output to ImgClass.
+		 * The image is converted to rp_image, since it has
+		 * to be blended with COLOR_WINDOW.
+		 * @param pipeline ImagePipeline.
+		 * @return ImgClass, or null ImgClass on error.
+		 */
+		HBITMAP pipelineToImgClass(LibRpBase::ImagePipeline *pipeline) const final;
 };
 
 #endif /* __ROMPROPERTIES_WIN32_CREATETHUMBNAIL_HPP__ */
@@ -45,6 +45,13 @@
 #include "libwin32common/RegKey.hpp"
 using LibWin32Common::RegKey;
 
+// librpbase
+#include "librpbase/config.librpbase.h"
+#ifdef ENABLE_DECRYPTION
+# include "librpbase/crypto/AesParallel.hpp"
+using LibRpBase::AesParallel;
+#endif /* ENABLE_DECRYPTION */
+
 // rp_image backend registration.
 #include "librpbase/img/RpGdiplusBackend.hpp"
 #include "librpbase/img/rp_image.hpp"
@@ -141,7 +148,21 @@ BOOL WINAPI DllMain(HINSTANCE hInstance, DWORD dwReason, LPVOID /*lpReserved*/)
  */
 STDAPI DllCanUnloadNow(void)
 {
-	return (LibWin32Common::ComBase_isReferenced() ? S_FALSE : S_OK);
+	if (LibWin32Common::ComBase_isReferenced()) {
+		return S_FALSE;
+	}
+
+#ifdef ENABLE_DECRYPTION
+	// Stop the AES worker threads before the DLL is unloaded.
+	// NOTE: This can't be done in DllMain(), since joining
+	// threads while the loader lock is held will deadlock.
+	if (AesParallel::shutdown() != 0) {
+		// Decryption is still in progress.
+		return S_FALSE;
+	}
+#endif /* ENABLE_DECRYPTION */
+
+	return S_OK;
 }
 
 /**
@@ -27,7 +27,7 @@
 #include "librpbase/RomData.hpp"
 #include "librpbase/TextFuncs.hpp"
 #include "librpbase/TextFuncs_wchar.hpp"
-#include "librpbase/file/RpFile.hpp"
+#include "librpbase/file/IRpFile.hpp"
 #include "librpbase/img/rp_image.hpp"
 using namespace LibRpBase;
 
@@ -172,7 +172,7 @@ IFACEMETHODIMP RP_ExtractImage::Load(LPCOLESTR pszFileName, DWORD dwMode)
 	}
 
 	// Attempt to open the ROM file.
-	unique_ptr<IRpFile> file(new RpFile(d->filename, RpFile::FM_OPEN_READ_GZ));
+	unique_ptr<IRpFile> file(RomDataFactory::openFile(d->filename));
 	if (!file || !file->isOpen()) {
 		return E_FAIL;
 	}
@@ -258,7 +258,7 @@ RpFile_IStream::RpFile_IStream(const RpFile_IStream &other)
 
 	// Take a reference to the other IStream.
 	m_pStream->AddRef();
-	m_lastError = other.m_lastError;
+	m_lastError = other.lastError();
 
 	// Nothing else to do, since we can't actually
 	// clone the stream.
@@ -292,7 +292,7 @@ RpFile_IStream &RpFile_IStream::operator=(const RpFile_IStream &other)
 
 	// Nothing else to do, since we can't actually
 	// clone the stream.
-	m_lastError = other.m_lastError;
+	m_lastError = other.lastError();
 	return *this;
 }
 
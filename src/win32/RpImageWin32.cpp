@@ -25,7 +25,9 @@
 // librpbase
 #include "librpbase/img/rp_image.hpp"
 #include "librpbase/img/RpGdiplusBackend.hpp"
+#include "librpbase/img/ImagePipeline.hpp"
 using LibRpBase::rp_image;
+using LibRpBase::ImagePipeline;
 using LibRpBase::RpGdiplusBackend;
 
 // C includes. (C++ namespace)
@@ -321,6 +323,60 @@ HBITMAP RpImageWin32::toHBITMAP_alpha(const rp_image *image, const SIZE &size, b
 	}
 }
 
+/**
+ * Convert an ImagePipeline's output to HBITMAP.
+ * This version preserves the alpha channel.
+ * The pipeline writes directly into the DIB section.
+ * @param pipeline	[in] ImagePipeline.
+ * @return HBITMAP, or nullptr on error.
+ */
+HBITMAP RpImageWin32::toHBITMAP_alpha(ImagePipeline *pipeline)
+{
+	assert(pipeline != nullptr);
+	assert(pipeline->isValid());
+	if (!pipeline || !pipeline->isValid()) {
+		// Invalid pipeline.
+		return nullptr;
+	}
+
+	const int width = pipeline->width();
+	const int height = pipeline->height();
+
+	BITMAPINFO bmi;
+	BITMAPINFOHEADER *bmiHeader = &bmi.bmiHeader;
+
+	// Initialize the BITMAPINFOHEADER.
+	// Reference: https://msdn.microsoft.com/en-us/library/windows/desktop/dd183376%28v=vs.85%29.aspx
+	bmiHeader->biSize = sizeof(BITMAPINFOHEADER);
+	bmiHeader->biWidth = width;
+	bmiHeader->biHeight = -height;	// Top-down
+	bmiHeader->biPlanes = 1;
+	bmiHeader->biBitCount = 32;
+	bmiHeader->biCompression = BI_RGB;
+	bmiHeader->biSizeImage = 0;	// TODO?
+	bmiHeader->biXPelsPerMeter = 0;	// TODO
+	bmiHeader->biYPelsPerMeter = 0;	// TODO
+	bmiHeader->biClrUsed = 0;
+	bmiHeader->biClrImportant = 0;
+
+	// Create the bitmap.
+	void *pvBits;
+	HBITMAP hBitmap = CreateDIBSection(nullptr, &bmi, DIB_RGB_COLORS,
+		&pvBits, nullptr, 0);
+	if (!hBitmap)
+		return nullptr;
+
+	// 32bpp DIB rows are always DWORD-aligned,
+	// so the stride is width * 4.
+	if (pipeline->process(pvBits, width * 4) != 0) {
+		// Error processing the image.
+		DeleteObject(hBitmap);
+		return nullptr;
+	}
+
+	return hBitmap;
+}
+
 /**
  * Convert an rp_image to HICON.
  * @param image rp_image.
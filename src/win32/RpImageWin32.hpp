@@ -25,6 +25,7 @@
 #include "librpbase/common.h"
 namespace LibRpBase {
 	class rp_image;
+	class ImagePipeline;
 }
 
 // C includes.
@@ -85,6 +86,15 @@ class RpImageWin32
 		 */
 		static HBITMAP toHBITMAP_alpha(const LibRpBase::rp_image *image, const SIZE &size, bool nearest);
 
+		/**
+		 * Convert an ImagePipeline's output to HBITMAP.
+		 * This version preserves the alpha channel.
+		 * The pipeline writes directly into the DIB section.
+		 * @param pipeline	[in] ImagePipeline.
+		 * @return HBITMAP, or nullptr on error.
+		 */
+		static HBITMAP toHBITMAP_alpha(LibRpBase::ImagePipeline *pipeline);
+
 		/**
 		 * Convert an rp_image to HICON.
 		 * @param image rp_image.